@@ -147,6 +147,12 @@ struct module {
     0, { 0 }
   },
 
+  /* 64-bit column pointers; see taucs_index in taucs.h */
+  { "INDEX64" , exclude,  0 , { "BASE", 0 },
+    { 0 },
+    0, { 0 }
+  },
+
   { "BASE", include, generic, { 0 },
     {
       "taucs_complex", 
@@ -324,6 +330,11 @@ struct module {
     "libtaucs", { 0 }
   },
 
+  { "AMG", include, 0, { "BASE", "LLT", "ORDERING", 0 },
+    { "taucs_amg", "taucs_iter", 0 },
+    "libtaucs", { 0 }
+  },
+
   { "GREMBAN" , include, 0, { "BASE", 0 },
     { "taucs_gremban", "taucs_iter" ,0 },
     "libtaucs", { 0 }
@@ -332,6 +343,7 @@ struct module {
   { "INCOMPLETE_CHOL", include, 0 , { "BASE", 0 },
     {
       "taucs_ccs_factor_llt",
+      "taucs_sn_ic",
       "taucs_ccs_solve_llt",
       0
     },
@@ -340,7 +352,7 @@ struct module {
   },
 
   { "ITER" , include, 0, { "BASE", 0 },
-    { "taucs_iter", 0 },
+    { "taucs_iter", "taucs_gmres", 0 },
     "libtaucs", { 0 }
   },
 
@@ -407,7 +419,7 @@ struct file {
   { "taucs_config_tests",  "DIRBLD", hsource },
 
   { "taucs_sn_llt" ,       "DIRSRC", cilksource | generic | dreal | sreal | dcomplex | scomplex},
-  { "taucs_sn_ldlt" ,      "DIRSRC", csource		|	generic | dreal | sreal | dcomplex | scomplex},
+  { "taucs_sn_ldlt" ,      "DIRSRC", cilksource | generic | dreal | sreal | dcomplex | scomplex},
   { "taucs_linsolve" ,     "DIRSRC", cilksource | generic },
 
   { "taucs_logging" ,      "DIRSRC", csource | generic },
@@ -419,15 +431,18 @@ struct file {
   { "taucs_ccs_io" ,       "DIRSRC", csource | generic | dreal | sreal | dcomplex | scomplex},
   { "taucs_ccs_order" ,    "DIRSRC", csource | generic },
   { "taucs_ccs_factor_llt","DIRSRC", csource | generic | dreal | sreal | dcomplex | scomplex},
+  { "taucs_sn_ic",         "DIRSRC", csource | generic | dreal | sreal | dcomplex | scomplex},
   { "taucs_ccs_solve_llt" ,"DIRSRC", csource | generic | dreal | sreal | dcomplex | scomplex},
   { "taucs_complex" ,      "DIRSRC", csource | generic | dreal | sreal | dcomplex | scomplex},
   { "taucs_ccs_ooc_llt" ,  "DIRSRC", csource | generic | dreal | sreal | dcomplex | scomplex},
   { "taucs_ccs_ooc_ldlt",  "DIRSRC", csource | generic | dreal | sreal | dcomplex | scomplex},
   { "taucs_ccs_ooc_lu" ,   "DIRSRC", csource | generic | dreal | sreal | dcomplex | scomplex},
   { "taucs_ooc_io" ,       "DIRSRC", csource | generic },
-  { "taucs_iter" ,         "DIRSRC", csource |           dreal                              },
+  { "taucs_iter" ,         "DIRSRC", csource | generic | dreal | sreal | dcomplex | scomplex},
+  { "taucs_gmres" ,        "DIRSRC", csource | generic | dreal | sreal | dcomplex | scomplex},
   { "taucs_vaidya" ,       "DIRSRC", csource |           dreal                              },
   { "taucs_recvaidya" ,    "DIRSRC", csource |           dreal                              },
+  { "taucs_amg" ,          "DIRSRC", csource |           dreal                              },
   { "taucs_gremban" ,      "DIRSRC", csource |           dreal                              },
   { "taucs_ccs_xxt" ,      "DIRSRC", csource |           dreal                              },
 
@@ -36,26 +36,73 @@ TAUCS_CONFIG_END
 /*                                                       */
 /*********************************************************/
 
+static double
+relative_residual(taucs_ccs_matrix* A, void* x, void* b)
+{
+  void*  r;
+  double rnorm;
+
+  r = taucs_vec_create(A->n, A->flags);
+  assert(r);
+
+  taucs_ccs_times_vec(A,x,r);
+  taucs_vec_axpby(A->n,A->flags,1.0,r,-1.0,b,r);
+  rnorm = taucs_vec_norm2(A->n,A->flags,r) 
+        / taucs_vec_norm2(A->n,A->flags,b);
+
+  taucs_vec_free(A->flags,r);
+  return rnorm;
+}
+
+static int
+factor_solve(taucs_ccs_matrix* A, int* perm, char* basename,
+	     double memory, int nproc, void* x, void* b)
+{
+  taucs_io_handle* LU;
+  int rc;
+
+  LU = taucs_io_create_multifile(basename);
+  if (!LU) return TAUCS_ERROR;
+
+  if (nproc > 1)
+    rc = taucs_ooc_factor_lu_parallel(A, perm, LU, memory, nproc);
+  else
+    rc = taucs_ooc_factor_lu(A, perm, LU, memory);
+
+  if (rc == TAUCS_SUCCESS)
+    rc = taucs_ooc_solve_lu(LU, x, b);
+
+  taucs_io_delete(LU);
+  return rc;
+}
+
 int 
 main(int argc, char* argv[])
 {
   void* x;
+  void* xs;
   void* b;
   taucs_ccs_matrix* A;
-  void* LU;
   char  fname[256];
   double memory_mb = -1.0;
   int    mb = -1;
   int* perm;
   int* invperm;
+  void*  opt_arg[] = { NULL };
+  double opt_pfunc_nproc = -1;
+  double rpar, rser;
+  int    nproc;
+  int    i;
 
   taucs_logfile("stdout");
 
   if (argc < 2) {
-    fprintf(stderr,"usage: %s filename\n",argv[0]);
+    fprintf(stderr,"usage: %s filename [memory-mb] [taucs.pfunc.nproc=n]\n",argv[0]);
     fprintf(stderr,"       filename-A.bin is the matrix\n");
     fprintf(stderr,"       filename-b.bin is the rhs\n");
     fprintf(stderr,"       filename-x.bin will contain the solution\n");
+    fprintf(stderr,"       with n > 1, the factorization is also done serially\n");
+    fprintf(stderr,"       and the two residuals are compared\n");
     exit(1);
   }
 
@@ -66,31 +113,78 @@ main(int argc, char* argv[])
     sscanf(argv[2],"%d",&mb);
   }
 
+  for (i=3; i<argc; i++) {
+    if (!taucs_getopt_double(argv[i],opt_arg,"taucs.pfunc.nproc",&opt_pfunc_nproc))
+      taucs_printf("ooc_factor_solve: illegal option [[%s]]\n",argv[i]);
+  }
+  nproc = opt_pfunc_nproc > 1 ? (int) opt_pfunc_nproc : 1;
+
+#ifdef TAUCS_CONFIG_PFUNC
+  if (opt_pfunc_nproc > 0) {
+    unsigned int num_threads_per_queue[] = {(int)opt_pfunc_nproc};
+    if (pfunc_init(1, num_threads_per_queue, NULL) == PFUNC_ERROR) {
+      taucs_printf("ooc_factor_solve: failed to initialize PFUNC\n");
+      exit(1);
+    }
+  }
+#endif
+
   sprintf(fname,"%s-b.bin",argv[1]);
   b = taucs_vec_read_binary(A->m, A->flags, fname);
 
   taucs_ccs_order(A,&perm,&invperm,"colamd");
+  if (!perm) {
+    taucs_printf("ooc_factor_solve: ordering failed\n");
+    exit(1);
+  }
 
   if (mb > 0)
     memory_mb = (double) mb;
   else
     memory_mb = ((double) (-mb)) * taucs_available_memory_size()/1048576.0;
 
-  LU = taucs_io_create_multifile(argv[1]);
-  taucs_ooc_factor_lu(A, perm, LU, memory_mb*1048576.0);
+  x = taucs_vec_create(A->n, A->flags);
+  assert(x);
 
-  if (A->flags & TAUCS_DOUBLE) 
-    x = malloc((A->n) * sizeof(taucs_double));
-  else if (A->flags & TAUCS_DCOMPLEX) 
-    x = malloc((A->n) * sizeof(taucs_dcomplex));
-  else
-    assert(0);
-
-  taucs_ooc_solve_lu(LU, x, b);
+  if (factor_solve(A, perm, argv[1], memory_mb*1048576.0, nproc, x, b)
+      != TAUCS_SUCCESS) {
+    taucs_printf("ooc_factor_solve: factorization failed\n");
+    exit(1);
+  }
+  rpar = relative_residual(A,x,b);
+  taucs_printf("ooc_factor_solve: nproc=%d, relative residual %.2e\n",
+	       nproc,rpar);
+
+  if (nproc > 1) {
+    xs = taucs_vec_create(A->n, A->flags);
+    assert(xs);
+
+    sprintf(fname,"%s-serial",argv[1]);
+    if (factor_solve(A, perm, fname, memory_mb*1048576.0, 1, xs, b)
+	!= TAUCS_SUCCESS) {
+      taucs_printf("ooc_factor_solve: serial factorization failed\n");
+      exit(1);
+    }
+    rser = relative_residual(A,xs,b);
+    taucs_printf("ooc_factor_solve: nproc=1, relative residual %.2e\n",rser);
+    taucs_vec_free(A->flags,xs);
+
+    /* the threads only reorder updates; the residuals should be close */
+    if (rpar > 10.0*rser + 1e-12) {
+      taucs_printf("ooc_factor_solve: parallel residual too large\n");
+      exit(1);
+    }
+  }
 
   sprintf(fname,"%s-x.bin",argv[1]);
   taucs_vec_write_binary(A->n, A->flags, x, fname);
 
+#ifdef TAUCS_CONFIG_PFUNC
+  if (opt_pfunc_nproc > 0) pfunc_clear();
+#endif
+
+  taucs_vec_free(A->flags,x);
+  taucs_ccs_free(A);
   free(perm);
   free(invperm);
 
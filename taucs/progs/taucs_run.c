@@ -99,6 +99,8 @@ int main(int argc, char* argv[])
   char* opt_hb  = NULL;
   char* opt_bin = NULL;
   char* opt_log = "stdout";
+  double opt_log_level = -1.0; /* TAUCS_LOG_INFO unless given */
+  double opt_log_mask  = -1.0; /* TAUCS_LOG_ALL unless given  */
   double opt_3d = -1.0;
   double opt_2d = -1.0;
   char*  opt_2d_type = "dirichlet";
@@ -130,6 +132,8 @@ int main(int argc, char* argv[])
     understood |= taucs_getopt_string(argv[i],opt_arg,"taucs_run.hb", &opt_hb );
     understood |= taucs_getopt_string(argv[i],opt_arg,"taucs_run.bin", &opt_bin );
     understood |= taucs_getopt_string(argv[i],opt_arg,"taucs_run.log",&opt_log);
+    understood |= taucs_getopt_double(argv[i],opt_arg,"taucs_run.log.level",&opt_log_level);
+    understood |= taucs_getopt_double(argv[i],opt_arg,"taucs_run.log.mask",&opt_log_mask);
     understood |= taucs_getopt_double(argv[i],opt_arg,"taucs_run.mesh3d",&opt_3d);
     understood |= taucs_getopt_boolean(argv[i],opt_arg,"taucs_run.mesh3d.rand",&opt_3d_rand);
     understood |= taucs_getopt_double(argv[i],opt_arg,"taucs_run.mesh3d.small",&opt_3d_small);
@@ -151,6 +155,8 @@ int main(int argc, char* argv[])
   if (opt_scomplex) datatype = TAUCS_SCOMPLEX;
   if (opt_dcomplex) datatype = TAUCS_DCOMPLEX;
 
+  if (opt_log_level >= 0.0) taucs_log_set_level((int) opt_log_level);
+  if (opt_log_mask  >= 0.0) taucs_log_set_mask ((int) opt_log_mask);
   taucs_logfile(opt_log);
 
   if (opt_3d > 0) {
@@ -0,0 +1,194 @@
+/*********************************************************/
+/* TAUCS                                                 */
+/* Author: Sivan Toledo                                  */
+/*********************************************************/
+/*
+
+TAUCS_CONFIG_BEGIN
+TAUCS_CONFIG_DEFAULT OFF
+TAUCS_CONFIG BASE
+TAUCS_CONFIG DREAL
+TAUCS_CONFIG LLT
+TAUCS_CONFIG MALLOC_STUBS
+TAUCS_CONFIG MATRIX_GENERATORS
+TAUCS_CONFIG AD_HOC_TEST
+TAUCS_CONFIG_END
+
+*/
+
+/*
+  Factors and solves a batch of small SPD systems with
+  taucs_ccs_factor_llt_mf_batch and taucs_supernodal_solve_llt_batch,
+  and compares every solution with the one computed by
+  taucs_ccs_factor_llt_mf and taucs_supernodal_solve_llt. The
+  batch mixes shared and distinct patterns and contains one
+  indefinite matrix, which must come back without a factor.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <taucs.h>
+
+#define NMATRICES 8
+#define INDEFINITE 0
+
+/* scale*A + shift*I, same pattern as A */
+taucs_ccs_matrix* scaled_copy(taucs_ccs_matrix* A, double scale, double shift)
+{
+  taucs_ccs_matrix* S;
+  int ip,j;
+
+  S = taucs_ccs_create(A->n,A->n,A->colptr[A->n],A->flags);
+  if (!S) return NULL;
+
+  for (j=0; j<=A->n; j++) S->colptr[j] = A->colptr[j];
+  for (j=0; j<A->n; j++) {
+    for (ip=A->colptr[j]; ip<A->colptr[j+1]; ip++) {
+      S->rowind  [ip] = A->rowind[ip];
+      S->values.d[ip] = scale * A->values.d[ip];
+      if (A->rowind[ip] == j) S->values.d[ip] += shift;
+    }
+  }
+
+  return S;
+}
+
+double relative_residual(taucs_ccs_matrix* A, double* x, double* b)
+{
+  double* r;
+  double  rnorm;
+
+  r = (double*) malloc(A->n * sizeof(double));
+  if (!r) return 1.0;
+
+  taucs_ccs_times_vec(A,x,r);
+  taucs_vec_axpby(A->n,TAUCS_DOUBLE,1.0,r,-1.0,b,r);
+  rnorm = taucs_vec_norm2(A->n,TAUCS_DOUBLE,r)
+        / taucs_vec_norm2(A->n,TAUCS_DOUBLE,b);
+
+  free(r);
+  return rnorm;
+}
+
+int main()
+{
+  taucs_ccs_matrix* A[NMATRICES];
+  taucs_ccs_matrix* M2;
+  taucs_ccs_matrix* M3;
+  void*   L[NMATRICES];
+  void*   X[NMATRICES];
+  void*   B[NMATRICES];
+  void*   L1;
+  double* x1;
+  double  rbatch,rsingle;
+  int     i,k,rc;
+  int     failed = 0;
+
+  taucs_logfile("stdout");
+
+  /* runs of equal patterns share their symbolic analysis */
+  M2 = taucs_ccs_generate_mesh2d(20,"dirichlet");
+  M3 = taucs_ccs_generate_mesh3d(8,8,8);
+  if (!M2 || !M3) {
+    printf("matrix generation failed\n");
+    return 1;
+  }
+
+  /* first, so the solve has to find its datatype past a failed factor */
+  A[INDEFINITE] = scaled_copy(M3,1.0,-6.0);
+  A[1] = scaled_copy(M3,1.0,0.0);
+  A[2] = scaled_copy(M3,2.0,0.5);
+  A[3] = scaled_copy(M2,1.0,0.0);
+  A[4] = scaled_copy(M2,1.7,0.1);
+  A[5] = scaled_copy(M2,0.5,2.0);
+  A[6] = taucs_ccs_generate_mesh2d(12,"anisotropic_x");
+  A[7] = scaled_copy(M2,3.0,0.0);
+
+  for (k=0; k<NMATRICES; k++) {
+    if (!A[k]) {
+      printf("matrix generation failed\n");
+      return 1;
+    }
+    X[k] = malloc(A[k]->n * sizeof(double));
+    B[k] = malloc(A[k]->n * sizeof(double));
+    if (!X[k] || !B[k]) {
+      printf("out of memory\n");
+      return 1;
+    }
+    for (i=0; i<A[k]->n; i++) ((double*) B[k])[i] = 1.0 + (double) ((i+k)%7);
+  }
+
+  rc = taucs_ccs_factor_llt_mf_batch(NMATRICES,A,L);
+  if (rc == TAUCS_SUCCESS) {
+    printf("the batch factorization missed the indefinite matrix\n");
+    failed = 1;
+  }
+  if (L[INDEFINITE]) {
+    printf("the indefinite matrix was not marked failed\n");
+    failed = 1;
+  }
+
+  /* the solve skips the failed factor but still reports it */
+  rc = taucs_supernodal_solve_llt_batch(NMATRICES,L,X,B);
+  if (rc != TAUCS_ERROR) {
+    printf("the batch solve returned %d, expected %d\n",rc,TAUCS_ERROR);
+    failed = 1;
+  }
+
+  for (k=0; k<NMATRICES; k++) {
+    if (k == INDEFINITE) continue;
+
+    if (!L[k]) {
+      printf("matrix %d: no factor from the batch\n",k);
+      failed = 1;
+      continue;
+    }
+
+    L1 = taucs_ccs_factor_llt_mf(A[k]);
+    x1 = (double*) malloc(A[k]->n * sizeof(double));
+    if (!L1 || !x1) {
+      printf("matrix %d: single factorization failed\n",k);
+      failed = 1;
+      continue;
+    }
+    taucs_supernodal_solve_llt(L1,x1,B[k]);
+
+    rbatch  = relative_residual(A[k],(double*) X[k],(double*) B[k]);
+    rsingle = relative_residual(A[k],x1,(double*) B[k]);
+    printf("matrix %d: n=%d, batch residual %.2e, single residual %.2e\n",
+	   k,A[k]->n,rbatch,rsingle);
+
+    if (rbatch > 1e-8) {
+      printf("matrix %d: batch residual too large\n",k);
+      failed = 1;
+    }
+
+    /* the batch runs the same kernels in the same order */
+    if (memcmp(X[k],x1,A[k]->n * sizeof(double))) {
+      printf("matrix %d: batch and single solutions differ\n",k);
+      failed = 1;
+    }
+
+    taucs_supernodal_factor_free(L1);
+    free(x1);
+  }
+
+  for (k=0; k<NMATRICES; k++) {
+    if (L[k]) taucs_supernodal_factor_free(L[k]);
+    taucs_ccs_free(A[k]);
+    free(X[k]);
+    free(B[k]);
+  }
+  taucs_ccs_free(M2);
+  taucs_ccs_free(M3);
+
+  if (failed) {
+    printf("test failed\n");
+    return 1;
+  } else {
+    printf("test succeeded\n");
+    return 0;
+  }
+}
@@ -0,0 +1,140 @@
+/*********************************************************/
+/* TAUCS                                                 */
+/* Author: Sivan Toledo                                  */
+/*********************************************************/
+/*
+
+TAUCS_CONFIG_BEGIN
+TAUCS_CONFIG_DEFAULT OFF
+TAUCS_CONFIG BASE
+TAUCS_CONFIG DREAL
+TAUCS_CONFIG DCOMPLEX
+TAUCS_CONFIG ITER
+TAUCS_CONFIG MALLOC_STUBS
+TAUCS_CONFIG MATRIX_GENERATORS
+TAUCS_CONFIG AD_HOC_TEST
+TAUCS_CONFIG_END
+
+*/
+
+/*
+  CG and MINRES on a complex Hermitian positive-definite
+  matrix, and rejection of a complex symmetric one.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <taucs.h>
+
+/* the 2D Laplacian with a shifted diagonal and complex off-diagonals */
+taucs_ccs_matrix* hermitian_mesh2d(int n)
+{
+  taucs_ccs_matrix* R;
+  taucs_ccs_matrix* A;
+  int ip,j;
+  double v;
+
+  R = taucs_ccs_generate_mesh2d(n,"dirichlet");
+  if (!R) return NULL;
+
+  A = taucs_ccs_create(R->n,R->n,R->colptr[R->n],
+		       TAUCS_DCOMPLEX | TAUCS_HERMITIAN | TAUCS_LOWER);
+  if (!A) { taucs_ccs_free(R); return NULL; }
+
+  for (j=0; j<=R->n; j++) A->colptr[j] = R->colptr[j];
+  for (j=0; j<R->n; j++) {
+    for (ip=R->colptr[j]; ip<R->colptr[j+1]; ip++) {
+      A->rowind[ip] = R->rowind[ip];
+      v = R->values.d[ip];
+      if (R->rowind[ip] == j)
+	A->values.z[ip] = taucs_zcomplex_create(v + 0.5,0.0);
+      else
+	A->values.z[ip] = taucs_zcomplex_create(v,0.3*v);
+    }
+  }
+
+  taucs_ccs_free(R);
+  return A;
+}
+
+int check(taucs_ccs_matrix* A, taucs_dcomplex* x, taucs_dcomplex* b,
+	  taucs_iter_info* info, char* name)
+{
+  taucs_dcomplex* r;
+  double relres;
+
+  r = (taucs_dcomplex*) taucs_vec_create(A->n,TAUCS_DCOMPLEX);
+  if (!r) return 1;
+
+  taucs_ccs_times_vec(A,x,r);
+  taucs_vec_axpby(A->n,TAUCS_DCOMPLEX,1.0,r,-1.0,b,r);
+  relres = taucs_vec_norm2(A->n,TAUCS_DCOMPLEX,r)
+         / taucs_vec_norm2(A->n,TAUCS_DCOMPLEX,b);
+  taucs_vec_free(TAUCS_DCOMPLEX,r);
+
+  printf("%s: %d iterations, relative residual %.2e\n",
+	 name,info->iterations,relres);
+
+  return (!info->converged || relres > 1e-8);
+}
+
+int main()
+{
+  taucs_ccs_matrix* A;
+  taucs_dcomplex* x;
+  taucs_dcomplex* b;
+  taucs_iter_info info;
+  int i,rc;
+  int failed = 0;
+
+  taucs_logfile("stdout");
+
+  A = hermitian_mesh2d(30);
+  x = (taucs_dcomplex*) taucs_vec_create(A->n,TAUCS_DCOMPLEX);
+  b = (taucs_dcomplex*) taucs_vec_create(A->n,TAUCS_DCOMPLEX);
+  if (!A || !x || !b) {
+    printf("out of memory\n");
+    return 1;
+  }
+
+  for (i=0; i<A->n; i++)
+    b[i] = taucs_zcomplex_create((double) (i%7),(double) (i%3) - 1.0);
+
+  memset(&info,0,sizeof(info));
+  info.itermax     = 1000;
+  info.convergetol = 1e-10;
+
+  memset(x,0,A->n*sizeof(taucs_dcomplex));
+  rc = taucs_conjugate_gradients_info(A,NULL,NULL,x,b,&info);
+  if (rc != TAUCS_SUCCESS || check(A,x,b,&info,"cg")) failed = 1;
+
+  memset(x,0,A->n*sizeof(taucs_dcomplex));
+  rc = taucs_minres_info(A,NULL,NULL,x,b,&info);
+  if (rc != TAUCS_SUCCESS || check(A,x,b,&info,"minres")) failed = 1;
+
+  /* complex symmetric is not Hermitian; the real view does not apply */
+  A->flags = TAUCS_DCOMPLEX | TAUCS_SYMMETRIC | TAUCS_LOWER;
+
+  if (taucs_conjugate_gradients_info(A,NULL,NULL,x,b,&info) != TAUCS_ERROR_BADARGS) {
+    printf("cg accepted a complex symmetric matrix\n");
+    failed = 1;
+  }
+  if (taucs_minres_info(A,NULL,NULL,x,b,&info) != TAUCS_ERROR_BADARGS) {
+    printf("minres accepted a complex symmetric matrix\n");
+    failed = 1;
+  }
+
+  taucs_vec_free(TAUCS_DCOMPLEX,x);
+  taucs_vec_free(TAUCS_DCOMPLEX,b);
+  taucs_ccs_free(A);
+
+  if (failed) {
+    printf("test failed\n");
+    return 1;
+  } else {
+    printf("test succeeded\n");
+    return 0;
+  }
+}
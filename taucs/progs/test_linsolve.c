@@ -12,6 +12,9 @@ TAUCS_CONFIG DREAL
 TAUCS_CONFIG FACTOR
 TAUCS_CONFIG OOC_LLT
 TAUCS_CONFIG INCOMPLETE_CHOL
+TAUCS_CONFIG ITER
+TAUCS_CONFIG AMG
+TAUCS_CONFIG MULTILU
 TAUCS_CONFIG VAIDYA
 TAUCS_CONFIG METIS
 TAUCS_CONFIG GENMMD
@@ -95,12 +98,80 @@ int test_spd_factorizations(taucs_ccs_matrix* A,
   char* mfmd[] = {"taucs.factor.LLT=true", "taucs.factor.mf=true", "taucs.maxdepth=5", NULL};
   char* llmd[] = {"taucs.factor.LLT=true", "taucs.factor.ll=true", "taucs.maxdepth=5", NULL};
   char* ooc[]  = {"taucs.factor.LLT=true", "taucs.ooc=true", "taucs.ooc.basename=taucs-test", NULL};
+  char* amg[]  = {"taucs.factor.LLT=true", "taucs.approximate.amg=true", 
+		  "taucs.solve.cg=true", "taucs.solve.convergetol=1e-10", NULL};
+  char* amgo[] = {"taucs.factor.LLT=true", "taucs.approximate.amg=true", 
+		  "taucs.approximate.amg.levels=2", "taucs.approximate.amg.coarse=2000",
+		  "taucs.approximate.amg.theta=0.02", "taucs.approximate.amg.sweeps=2",
+		  "taucs.solve.cg=true", "taucs.solve.convergetol=1e-10", NULL};
+  char* icl[]  = {"taucs.factor.LLT=true", "taucs.approximate.ic=true", 
+		  "taucs.approximate.ic.levels=1",
+		  "taucs.solve.cg=true", "taucs.solve.convergetol=1e-10", NULL};
+  char* icd[]  = {"taucs.factor.LLT=true", "taucs.approximate.ic=true", 
+		  "taucs.approximate.ic.droptol=1e-3",
+		  "taucs.solve.cg=true", "taucs.solve.convergetol=1e-10", NULL};
+  char* icls[] = {"taucs.factor.LLT=true", "taucs.approximate.ic=true", 
+		  "taucs.solve.levels=true",
+		  "taucs.solve.cg=true", "taucs.solve.convergetol=1e-10", NULL};
+  char* repl[] = {"taucs.factor.LLT=true", "taucs.approximate.ic=true", 
+		  "taucs.solve.cg=true", "taucs.solve.replace=10",
+		  "taucs.solve.convergetol=1e-10", NULL};
+  char* oocz[] = {"taucs.factor.LLT=true", "taucs.ooc=true", "taucs.ooc.basename=taucs-test",
+		  "taucs.ooc.compress=true", NULL};
+  char* oocd[] = {"taucs.factor.LLT=true", "taucs.ooc=true", "taucs.ooc.basename=taucs-test",
+		  "taucs.ooc.direct=true", NULL};
+  char* oocs[] = {"taucs.factor.LLT=true", "taucs.ooc=true", 
+		  "taucs.ooc.basename=taucs-test-0,taucs-test-1,taucs-test-2", NULL};
   void* opt_arg[] = { NULL };
   
   rc = taucs_linsolve(A,NULL,1, y,b,ooc,opt_arg);
   if (rc != TAUCS_SUCCESS) return rc;
   if (rnorm(A,y,b,z)) return TAUCS_ERROR;
 
+  /* the same, with compressed factor blocks */
+  rc = taucs_linsolve(A,NULL,1, y,b,oocz,opt_arg);
+  if (rc != TAUCS_SUCCESS) return rc;
+  if (rnorm(A,y,b,z)) return TAUCS_ERROR;
+
+  /* the same, bypassing the page cache */
+  rc = taucs_linsolve(A,NULL,1, y,b,oocd,opt_arg);
+  if (rc != TAUCS_SUCCESS) return rc;
+  if (rnorm(A,y,b,z)) return TAUCS_ERROR;
+
+  /* the same, striped over three files */
+  rc = taucs_linsolve(A,NULL,1, y,b,oocs,opt_arg);
+  if (rc != TAUCS_SUCCESS) return rc;
+  if (rnorm(A,y,b,z)) return TAUCS_ERROR;
+
+  /* CG preconditioned by smoothed-aggregation AMG */
+  rc = taucs_linsolve(A,NULL,1, y,b,amg,opt_arg);
+  if (rc != TAUCS_SUCCESS) return rc;
+  if (rnorm(A,y,b,z)) return TAUCS_ERROR;
+
+  rc = taucs_linsolve(A,NULL,1, y,b,amgo,opt_arg);
+  if (rc != TAUCS_SUCCESS) return rc;
+  if (rnorm(A,y,b,z)) return TAUCS_ERROR;
+
+
+  /* CG preconditioned by supernodal IC(1) and by a drop-tolerance IC */
+  rc = taucs_linsolve(A,NULL,1, y,b,icl,opt_arg);
+  if (rc != TAUCS_SUCCESS) return rc;
+  if (rnorm(A,y,b,z)) return TAUCS_ERROR;
+
+  rc = taucs_linsolve(A,NULL,1, y,b,icd,opt_arg);
+  if (rc != TAUCS_SUCCESS) return rc;
+  if (rnorm(A,y,b,z)) return TAUCS_ERROR;
+
+  /* the same IC(0) preconditioner applied by level-scheduled solves */
+  rc = taucs_linsolve(A,NULL,1, y,b,icls,opt_arg);
+  if (rc != TAUCS_SUCCESS) return rc;
+  if (rnorm(A,y,b,z)) return TAUCS_ERROR;
+
+  /* CG replacing the recursive residual by the true one every 10 iterations */
+  rc = taucs_linsolve(A,NULL,1, y,b,repl,opt_arg);
+  if (rc != TAUCS_SUCCESS) return rc;
+  if (rnorm(A,y,b,z)) return TAUCS_ERROR;
+
   rc = taucs_linsolve(A,NULL,1, y,b,mf,opt_arg);
   if (rc != TAUCS_SUCCESS) return rc;
   if (rnorm(A,y,b,z)) return TAUCS_ERROR;
@@ -121,6 +192,153 @@ int test_spd_factorizations(taucs_ccs_matrix* A,
   return TAUCS_SUCCESS;
 }
 
+/* the LU factorization needs both triangles of A */
+taucs_ccs_matrix* symmetric_to_general(taucs_ccs_matrix* A)
+{
+  taucs_ccs_matrix* G;
+  int* len;
+  int  i,j,ip,nnz;
+
+  len = (int*) calloc(A->n,sizeof(int));
+  if (!len) return NULL;
+
+  nnz = 0;
+  for (j=0; j<A->n; j++) {
+    for (ip=A->colptr[j]; ip<A->colptr[j+1]; ip++) {
+      i = A->rowind[ip];
+      len[j]++; nnz++;
+      if (i != j) { len[i]++; nnz++; }
+    }
+  }
+
+  G = taucs_ccs_create(A->n,A->n,nnz,TAUCS_DOUBLE);
+  if (!G) { free(len); return NULL; }
+
+  G->colptr[0] = 0;
+  for (j=0; j<A->n; j++) G->colptr[j+1] = G->colptr[j] + len[j];
+  for (j=0; j<A->n; j++) len[j] = G->colptr[j];
+
+  for (j=0; j<A->n; j++) {
+    for (ip=A->colptr[j]; ip<A->colptr[j+1]; ip++) {
+      i = A->rowind[ip];
+      G->rowind  [len[j]] = i; 
+      G->values.d[len[j]] = A->values.d[ip];
+      len[j]++;
+      if (i != j) {
+	G->rowind  [len[i]] = j; 
+	G->values.d[len[i]] = A->values.d[ip];
+	len[i]++;
+      }
+    }
+  }
+
+  free(len);
+  return G;
+}
+
+int test_lu_krylov(taucs_ccs_matrix* A, 
+		   double* x, double* y, double* b, double* z)
+{
+  int rc;
+  char* gmres[] = {"taucs.factor.LU=true", "taucs.solve.gmres=true", 
+		   "taucs.solve.convergetol=1e-10", NULL};
+  char* bicg[]  = {"taucs.factor.LU=true", "taucs.solve.bicgstab=true", 
+		   "taucs.solve.convergetol=1e-10", NULL};
+  char* drop[]  = {"taucs.factor.LU=true", "taucs.solve.bicgstab=true", 
+		   "taucs.approximate.lu.droptol=0.2", "taucs.solve.maxits=1000",
+		   "taucs.solve.convergetol=1e-10", NULL};
+  char* ludir[] = {"taucs.factor.LU=true", "taucs.approximate.lu.droptol=0.2", NULL};
+  void* opt_arg[] = { NULL };
+  taucs_ccs_matrix* G;
+
+  G = symmetric_to_general(A);
+  if (!G) return TAUCS_ERROR_NOMEM;
+
+  rc = taucs_linsolve(G,NULL,1, y,b,gmres,opt_arg);
+  if (rc != TAUCS_SUCCESS) { taucs_ccs_free(G); return rc; }
+  if (rnorm(G,y,b,z)) { taucs_ccs_free(G); return TAUCS_ERROR; }
+
+  rc = taucs_linsolve(G,NULL,1, y,b,bicg,opt_arg);
+  if (rc != TAUCS_SUCCESS) { taucs_ccs_free(G); return rc; }
+  if (rnorm(G,y,b,z)) { taucs_ccs_free(G); return TAUCS_ERROR; }
+
+  /* an LU factor of a sparsified A is only a preconditioner */
+  rc = taucs_linsolve(G,NULL,1, y,b,drop,opt_arg);
+  if (rc != TAUCS_SUCCESS) { taucs_ccs_free(G); return rc; }
+  if (rnorm(G,y,b,z)) { taucs_ccs_free(G); return TAUCS_ERROR; }
+
+  /* a direct LU solve ignores the drop tolerance */
+  rc = taucs_linsolve(G,NULL,1, y,b,ludir,opt_arg);
+  if (rc != TAUCS_SUCCESS) { taucs_ccs_free(G); return rc; }
+  if (rnorm(G,y,b,z)) { taucs_ccs_free(G); return TAUCS_ERROR; }
+
+  taucs_ccs_free(G);
+
+  printf("TESING LU-PRECONDITIONED KRYLOV SOLVERS SUCCEDDED\n");
+
+  return TAUCS_SUCCESS;
+}
+
+/* A - shift*I; symmetric indefinite for a shift inside A's spectrum */
+taucs_ccs_matrix* shifted_copy(taucs_ccs_matrix* A, double shift)
+{
+  taucs_ccs_matrix* S;
+  int ip,j;
+
+  S = taucs_ccs_create(A->n,A->n,A->colptr[A->n],A->flags);
+  if (!S) return NULL;
+
+  for (j=0; j<=A->n; j++) S->colptr[j] = A->colptr[j];
+  for (j=0; j<A->n; j++) {
+    for (ip=A->colptr[j]; ip<A->colptr[j+1]; ip++) {
+      S->rowind  [ip] = A->rowind[ip];
+      S->values.d[ip] = A->values.d[ip];
+      if (A->rowind[ip] == j) S->values.d[ip] -= shift;
+    }
+  }
+
+  return S;
+}
+
+int test_indefinite_ldlt(taucs_ccs_matrix* A, 
+			 double* x, double* y, double* b, double* z)
+{
+  int rc;
+  char* ldlt[]    = {"taucs.factor.LLT=true", "taucs.factor.indefinite=true",
+		     "taucs.factor.mf=true", NULL};
+  char* tuned[]   = {"taucs.factor.LLT=true", "taucs.factor.indefinite=true",
+		     "taucs.factor.mf=true", 
+		     "taucs.factor.ldlt.alpha=0.1", "taucs.factor.ldlt.beta=1e-30", NULL};
+  char* perturb[] = {"taucs.factor.LLT=true", "taucs.factor.indefinite=true",
+		     "taucs.factor.mf=true", "taucs.factor.ldlt.perturb=1e-12", NULL};
+  void* opt_arg[] = { NULL };
+  taucs_ccs_matrix* S;
+
+  S = shifted_copy(A,5.5);
+  if (!S) return TAUCS_ERROR_NOMEM;
+  taucs_ccs_times_vec(S,x,b);
+
+  rc = taucs_linsolve(S,NULL,1, y,b,ldlt,opt_arg);
+  if (rc != TAUCS_SUCCESS) { taucs_ccs_free(S); return rc; }
+  if (rnorm(S,y,b,z)) { taucs_ccs_free(S); return TAUCS_ERROR; }
+
+  rc = taucs_linsolve(S,NULL,1, y,b,tuned,opt_arg);
+  if (rc != TAUCS_SUCCESS) { taucs_ccs_free(S); return rc; }
+  if (rnorm(S,y,b,z)) { taucs_ccs_free(S); return TAUCS_ERROR; }
+
+  rc = taucs_linsolve(S,NULL,1, y,b,perturb,opt_arg);
+  if (rc != TAUCS_SUCCESS) { taucs_ccs_free(S); return rc; }
+  if (rnorm(S,y,b,z)) { taucs_ccs_free(S); return TAUCS_ERROR; }
+
+  /* restore the right-hand side of A for the tests that follow */
+  taucs_ccs_times_vec(A,x,b);
+  taucs_ccs_free(S);
+
+  printf("TESING INDEFINITE LDL^T FACTORIZATIONS SUCCEDDED\n");
+
+  return TAUCS_SUCCESS;
+}
+
 int test_spd_factorsolve(taucs_ccs_matrix* A, 
 			 double* x, double* y, double* b, double* z)
 {
@@ -234,6 +452,16 @@ int main()
     return 1;
   }
 
+  if (test_indefinite_ldlt(A,X,Y,B,Z)) {
+    printf("INDEFINITE LDL^T FAILED\n");
+    return 1;
+  }
+
+  if (test_lu_krylov(A,X,Y,B,Z)) {
+    printf("LU-PRECONDITIONED KRYLOV FAILED\n");
+    return 1;
+  }
+
   taucs_printf("test succeeded\n");
   return 0;
 }
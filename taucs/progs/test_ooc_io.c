@@ -0,0 +1,146 @@
+/*********************************************************/
+/* TAUCS                                                 */
+/* Author: Sivan Toledo                                  */
+/*********************************************************/
+/*
+TAUCS_CONFIG_BEGIN
+TAUCS_CONFIG_DEFAULT OFF
+TAUCS_CONFIG BASE
+TAUCS_CONFIG DREAL
+TAUCS_CONFIG MALLOC_STUBS
+TAUCS_CONFIG OOC_LU
+TAUCS_CONFIG AD_HOC_TEST
+TAUCS_CONFIG_END
+*/
+
+/*
+  Writes matrices of many sizes to an out-of-core file,
+  reads them back, closes and reopens the file and reads
+  them again. The sizes straddle IO_DIRECT_ALIGN_MIN, so
+  direct I/O packs some appends and aligns others, and
+  several cross or exceed one IO_STRIPE_UNIT (1MB) on the
+  striped files.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <taucs.h>
+
+#define MULTIFILE "taucs-io-test"
+#define STRIPED   "taucs-io-test-0,taucs-io-test-1,taucs-io-test-2"
+
+/* in doubles; 8192 doubles is the direct I/O alignment threshold */
+static int sizes[] = { 50000, 50000, 50000,      /* the third crosses 1MB  */
+		       1, 17, 1000, 4000,        /* packed                 */
+		       8191, 8192, 20000,        /* packed, then aligned   */
+		       300000,                   /* more than a stripe unit */
+		       3, 8191, 131072, 5 };
+#define NBLOCKS ((int) (sizeof(sizes)/sizeof(int)))
+
+static int check_all(taucs_io_handle* f, double* data[], char* when)
+{
+  double* buf;
+  int i;
+
+  for (i=0; i<NBLOCKS; i++) {
+    buf = (double*) malloc(sizes[i]*sizeof(double));
+    if (!buf) return -1;
+    if (taucs_io_read(f,i,sizes[i],1,TAUCS_DOUBLE,buf)
+	|| memcmp(buf,data[i],sizes[i]*sizeof(double))) {
+      printf("block %d (%d doubles) differs %s\n",i,sizes[i],when);
+      free(buf);
+      return -1;
+    }
+    free(buf);
+  }
+  return 0;
+}
+
+static int round_trip(int striped, int direct, int parallel, double* data[])
+{
+  taucs_io_handle* f;
+  int i;
+  int rc = 0;
+
+  printf("%s file, direct=%d, parallel=%d\n",
+	 striped ? "striped" : "multi",direct,parallel);
+
+  f = striped ? taucs_io_create_striped(STRIPED)
+              : taucs_io_create_multifile(MULTIFILE);
+  if (!f) return -1;
+  if (direct)   taucs_io_set_direct(f,1);
+  if (parallel) taucs_io_set_parallel(f,1);
+
+  for (i=0; i<NBLOCKS; i++) {
+    if (taucs_io_append(f,i,sizes[i],1,TAUCS_DOUBLE,data[i])) {
+      printf("append of block %d failed\n",i);
+      taucs_io_delete(f);
+      return -1;
+    }
+  }
+
+  if (check_all(f,data,"before closing")) rc = -1;
+  taucs_io_close(f);
+
+  f = striped ? taucs_io_open_striped(STRIPED)
+              : taucs_io_open_multifile(MULTIFILE);
+  if (!f) return -1;
+  if (direct)   taucs_io_set_direct(f,1);
+  if (parallel) taucs_io_set_parallel(f,1);
+
+  if (check_all(f,data,"after reopening")) rc = -1;
+  taucs_io_delete(f);
+
+  return rc;
+}
+
+int main()
+{
+  double* data[NBLOCKS];
+  int i,j;
+  int striped,direct,parallel;
+  int failed = 0;
+
+  taucs_logfile("stdout");
+
+#ifdef TAUCS_CONFIG_PFUNC
+  {
+    unsigned int num_threads_per_queue[] = { 3 };
+    if (pfunc_init(1, num_threads_per_queue, NULL) == PFUNC_ERROR) {
+      printf("failed to initialize PFUNC\n");
+      return 1;
+    }
+  }
+#endif
+
+  srand(7);
+  for (i=0; i<NBLOCKS; i++) {
+    data[i] = (double*) malloc(sizes[i]*sizeof(double));
+    if (!data[i]) {
+      printf("out of memory\n");
+      return 1;
+    }
+    for (j=0; j<sizes[i]; j++) data[i][j] = (double) rand();
+  }
+
+  for (striped=0; striped<2; striped++)
+    for (direct=0; direct<2; direct++)
+      for (parallel=0; parallel<=striped; parallel++)
+	if (round_trip(striped,direct,parallel,data)) failed = 1;
+
+  for (i=0; i<NBLOCKS; i++) free(data[i]);
+
+#ifdef TAUCS_CONFIG_PFUNC
+  pfunc_clear();
+#endif
+
+  if (failed) {
+    printf("test failed\n");
+    return 1;
+  } else {
+    printf("test succeeded\n");
+    return 0;
+  }
+}
@@ -0,0 +1,185 @@
+/*********************************************************/
+/* TAUCS                                                 */
+/* Author: Sivan Toledo                                  */
+/*********************************************************/
+/*
+
+TAUCS_CONFIG_BEGIN
+TAUCS_CONFIG_DEFAULT OFF
+TAUCS_CONFIG BASE
+TAUCS_CONFIG DREAL
+TAUCS_CONFIG MATRIX_IO
+TAUCS_CONFIG MALLOC_STUBS
+TAUCS_CONFIG OOC_LLT
+TAUCS_CONFIG AD_HOC_TEST
+TAUCS_CONFIG_END
+
+*/
+
+/*
+  Writes a matrix with taucs_ccs_write_binary, factors it from
+  the file with taucs_ooc_factor_llt_file and compares the
+  solution with the one from taucs_ooc_factor_llt on the matrix
+  in memory. The memory is small enough that the column window
+  is refilled many times and the elimination tree takes several
+  passes over the row indices; the log shows both counts.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <taucs.h>
+
+#define MATRIXFILE "taucs-ooc-file-test.bin"
+#define LFILE      "taucs-ooc-file-test-L"
+#define LMEMFILE   "taucs-ooc-file-test-Lmem"
+
+/* 
+   the window gets an eighth of the memory and the elimination
+   tree reads the row indices in chunks of a 64th; the matrix is
+   banded so its 200K row indices (800KB) dwarf both chunks, and
+   the band keeps the fill, and the fronts, small
+*/
+#define N      5000
+#define BAND   40
+#define MEMORY (2.0*1048576.0)
+
+/* diagonally dominant, so SPD; lower triangle */
+taucs_ccs_matrix* band_matrix(int n, int w)
+{
+  taucs_ccs_matrix* A;
+  int i,j,ip;
+
+  A = taucs_ccs_create(n,n,n*(w+1),TAUCS_DOUBLE | TAUCS_SYMMETRIC | TAUCS_LOWER);
+  if (!A) return NULL;
+
+  ip = 0;
+  for (j=0; j<n; j++) {
+    A->colptr[j] = ip;
+    for (i=j; i<n && i<=j+w; i++) {
+      A->rowind  [ip] = i;
+      A->values.d[ip] = (i == j) ? 2.0*w + 1.0 : -1.0 / (double) (1 + (i+j)%3);
+      ip++;
+    }
+  }
+  A->colptr[n] = ip;
+
+  return A;
+}
+
+double relative_residual(taucs_ccs_matrix* A, double* x, double* b)
+{
+  double* r;
+  double  rnorm;
+
+  r = (double*) malloc(A->n * sizeof(double));
+  if (!r) return 1.0;
+
+  taucs_ccs_times_vec(A,x,r);
+  taucs_vec_axpby(A->n,TAUCS_DOUBLE,1.0,r,-1.0,b,r);
+  rnorm = taucs_vec_norm2(A->n,TAUCS_DOUBLE,r)
+        / taucs_vec_norm2(A->n,TAUCS_DOUBLE,b);
+
+  free(r);
+  return rnorm;
+}
+
+int main()
+{
+  taucs_ccs_matrix* A;
+  taucs_io_handle*  LF;
+  taucs_io_handle*  LM;
+  double* xf;
+  double* xm;
+  double* b;
+  double  rf,rm,dx,xnorm;
+  int     i,rc;
+  int     failed = 0;
+
+  taucs_logfile("stdout");
+
+  A  = band_matrix(N,BAND);
+  if (!A) {
+    printf("matrix generation failed\n");
+    return 1;
+  }
+  xf = (double*) malloc(A->n * sizeof(double));
+  xm = (double*) malloc(A->n * sizeof(double));
+  b  = (double*) malloc(A->n * sizeof(double));
+  if (!xf || !xm || !b) {
+    printf("out of memory\n");
+    return 1;
+  }
+  for (i=0; i<A->n; i++) b[i] = 1.0 + (double) (i%5);
+
+  /* the band order is the order we factor in */
+  taucs_ccs_write_binary(A,MATRIXFILE);
+
+  LF = taucs_io_create_multifile(LFILE);
+  LM = taucs_io_create_multifile(LMEMFILE);
+  if (!LF || !LM) {
+    printf("could not create the factor files\n");
+    return 1;
+  }
+
+  rc = taucs_ooc_factor_llt_file(MATRIXFILE,LF,MEMORY,1);
+  if (rc != TAUCS_SUCCESS) {
+    printf("the factorization from the file failed\n");
+    failed = 1;
+  } else if (taucs_ooc_solve_llt(LF,xf,b)) {
+    printf("the solve with the streamed factor failed\n");
+    failed = 1;
+  }
+
+  rc = taucs_ooc_factor_llt(A,LM,MEMORY);
+  if (rc != TAUCS_SUCCESS) {
+    printf("the in-memory factorization failed\n");
+    failed = 1;
+  } else if (taucs_ooc_solve_llt(LM,xm,b)) {
+    printf("the solve with the in-memory factor failed\n");
+    failed = 1;
+  }
+
+  if (!failed) {
+    rf = relative_residual(A,xf,b);
+    rm = relative_residual(A,xm,b);
+    printf("residuals: from the file %.2e, from memory %.2e\n",rf,rm);
+
+    if (rf > 1e-8 || rm > 1e-8) {
+      printf("residual too large\n");
+      failed = 1;
+    }
+    /* 
+       the window is charged to the memory overhead, so the panels,
+       and the rounding, may differ from the in-memory factorization
+    */
+    dx = xnorm = 0.0;
+    for (i=0; i<A->n; i++) {
+      dx    = max(dx,fabs(xf[i]-xm[i]));
+      xnorm = max(xnorm,fabs(xm[i]));
+    }
+    printf("relative difference between the solutions %.2e\n",dx/xnorm);
+    if (dx > 1e-10 * xnorm) {
+      printf("the two factorizations give different solutions\n");
+      failed = 1;
+    }
+  }
+
+  taucs_io_delete(LF);
+  taucs_io_delete(LM);
+  remove(MATRIXFILE);
+
+  taucs_ccs_free(A);
+  free(xf);
+  free(xm);
+  free(b);
+
+  if (failed) {
+    printf("test failed\n");
+    return 1;
+  } else {
+    printf("test succeeded\n");
+    return 0;
+  }
+}
@@ -91,6 +91,38 @@ typedef int perm_t;
 #define srandom   srand
 #endif
 
+/* 64-bit counts: bytes and entries of out-of-core files */
+
+#ifdef OSTYPE_win32
+typedef __int64   taucs_int64;
+#else
+typedef long long taucs_int64;
+#endif
+
+/*
+  Positions in rowind and values: column pointers and nonzero
+  counts of matrices and factors. The INDEX64 module makes them
+  64-bit, for factors with more than INT_MAX nonzeros; row and
+  column numbers stay int. Only the modules that handle 64-bit
+  positions can be built with it.
+*/
+
+#ifdef TAUCS_CONFIG_INDEX64
+typedef taucs_int64 taucs_index;
+#define TAUCS_INDEX_MAX 9223372036854775807LL
+#else
+typedef int         taucs_index;
+#define TAUCS_INDEX_MAX 2147483647
+#endif
+
+#if defined(TAUCS_CONFIG_INDEX64)                                 \
+  && (defined(TAUCS_CONFIG_OOC_LDLT) || defined(TAUCS_CONFIG_OOC_LU) \
+      || defined(TAUCS_CONFIG_MULTILU) || defined(TAUCS_CONFIG_MULTIQR) \
+      || defined(TAUCS_CONFIG_VAIDYA) || defined(TAUCS_CONFIG_REC_VAIDYA) \
+      || defined(TAUCS_CONFIG_GREMBAN) || defined(TAUCS_CONFIG_INVERSE_FACTOR))
+#error "the INDEX64 module cannot be built with OOC_LDLT, OOC_LU, MULTILU, MULTIQR, VAIDYA, REC_VAIDYA, GREMBAN or INVERSE_FACTOR"
+#endif
+
 #define TAUCS_SUCCESS                       0
 #define TAUCS_ERROR                        -1
 #define TAUCS_ERROR_NOMEM                  -2
@@ -296,6 +328,43 @@ typedef _Complex float  taucs_scomplex;
 typedef struct {double r,i;} taucs_dcomplex;
 typedef struct {float  r,i;} taucs_scomplex;
 
+/* add, sub, mul, neg and conj are inlined so that loops */
+/* over complex vectors are not dominated by call        */
+/* overhead. div, abs and sqrt need care with overflow   */
+/* and remain out of line in taucs_complex.c.            */
+
+#if defined(__GNUC__)
+#define TAUCS_INLINE static __inline__
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
+#define TAUCS_INLINE static inline
+#elif defined(_MSC_VER)
+#define TAUCS_INLINE static __inline
+#else
+#define TAUCS_INLINE static
+#endif
+
+TAUCS_INLINE taucs_dcomplex taucs_zadd_inline(taucs_dcomplex a, taucs_dcomplex b)
+{ taucs_dcomplex c; c.r = a.r + b.r; c.i = a.i + b.i; return c; }
+TAUCS_INLINE taucs_dcomplex taucs_zsub_inline(taucs_dcomplex a, taucs_dcomplex b)
+{ taucs_dcomplex c; c.r = a.r - b.r; c.i = a.i - b.i; return c; }
+TAUCS_INLINE taucs_dcomplex taucs_zmul_inline(taucs_dcomplex a, taucs_dcomplex b)
+{ taucs_dcomplex c; c.r = a.r*b.r - a.i*b.i; c.i = a.r*b.i + a.i*b.r; return c; }
+TAUCS_INLINE taucs_dcomplex taucs_zneg_inline(taucs_dcomplex a)
+{ taucs_dcomplex c; c.r = -a.r; c.i = -a.i; return c; }
+TAUCS_INLINE taucs_dcomplex taucs_zconj_inline(taucs_dcomplex a)
+{ taucs_dcomplex c; c.r = a.r; c.i = -a.i; return c; }
+
+TAUCS_INLINE taucs_scomplex taucs_cadd_inline(taucs_scomplex a, taucs_scomplex b)
+{ taucs_scomplex c; c.r = a.r + b.r; c.i = a.i + b.i; return c; }
+TAUCS_INLINE taucs_scomplex taucs_csub_inline(taucs_scomplex a, taucs_scomplex b)
+{ taucs_scomplex c; c.r = a.r - b.r; c.i = a.i - b.i; return c; }
+TAUCS_INLINE taucs_scomplex taucs_cmul_inline(taucs_scomplex a, taucs_scomplex b)
+{ taucs_scomplex c; c.r = a.r*b.r - a.i*b.i; c.i = a.r*b.i + a.i*b.r; return c; }
+TAUCS_INLINE taucs_scomplex taucs_cneg_inline(taucs_scomplex a)
+{ taucs_scomplex c; c.r = -a.r; c.i = -a.i; return c; }
+TAUCS_INLINE taucs_scomplex taucs_cconj_inline(taucs_scomplex a)
+{ taucs_scomplex c; c.r = a.r; c.i = -a.i; return c; }
+
 #define taucs_zcomplex_create(r,i) taucs_zcomplex_create_fn(r,i)
 #define taucs_ccomplex_create(r,i) taucs_ccomplex_create_fn(r,i)
 
@@ -327,12 +396,12 @@ typedef struct {float  r,i;} taucs_scomplex;
 #define taucs_sone     1.0f
 #define taucs_szero    0.0f
 
-#define taucs_zadd(x,y) taucs_zadd_fn(x,y)
-#define taucs_zsub(x,y) taucs_zsub_fn(x,y)
-#define taucs_zmul(x,y) taucs_zmul_fn(x,y)
+#define taucs_zadd(x,y) taucs_zadd_inline(x,y)
+#define taucs_zsub(x,y) taucs_zsub_inline(x,y)
+#define taucs_zmul(x,y) taucs_zmul_inline(x,y)
 #define taucs_zdiv(x,y) taucs_zdiv_fn(x,y)
-#define taucs_zneg(x)   taucs_zneg_fn(x)
-#define taucs_zconj(x)  taucs_zconj_fn(x)
+#define taucs_zneg(x)   taucs_zneg_inline(x)
+#define taucs_zconj(x)  taucs_zconj_inline(x)
 #define taucs_zabs(x)   taucs_zabs_fn(x)
 #define taucs_zsqrt(x)  taucs_zsqrt_fn(x)
 #define taucs_zimag(x)    ((x).i)
@@ -341,12 +410,12 @@ typedef struct {float  r,i;} taucs_scomplex;
 #define taucs_zone      taucs_zone_const
 #define taucs_zzero     taucs_zzero_const
 
-#define taucs_cadd(x,y) taucs_cadd_fn(x,y)
-#define taucs_csub(x,y) taucs_csub_fn(x,y)
-#define taucs_cmul(x,y) taucs_cmul_fn(x,y)
+#define taucs_cadd(x,y) taucs_cadd_inline(x,y)
+#define taucs_csub(x,y) taucs_csub_inline(x,y)
+#define taucs_cmul(x,y) taucs_cmul_inline(x,y)
 #define taucs_cdiv(x,y) taucs_cdiv_fn(x,y)
-#define taucs_cneg(x)   taucs_cneg_fn(x)
-#define taucs_cconj(x)  taucs_cconj_fn(x)
+#define taucs_cneg(x)   taucs_cneg_inline(x)
+#define taucs_cconj(x)  taucs_cconj_inline(x)
 #define taucs_cabs(x)   taucs_cabs_fn(x)
 #define taucs_csqrt(x)  taucs_csqrt_fn(x)
 #define taucs_cimag(x)    ((x).i)
@@ -410,12 +479,12 @@ typedef struct {float  r,i;} taucs_scomplex;
 
 #define taucs_complex_create(r,i) taucs_zcomplex_create_fn(r,i)
 
-#define taucs_add(x,y) taucs_zadd_fn(x,y)
-#define taucs_sub(x,y) taucs_zsub_fn(x,y)
-#define taucs_mul(x,y) taucs_zmul_fn(x,y)
+#define taucs_add(x,y) taucs_zadd_inline(x,y)
+#define taucs_sub(x,y) taucs_zsub_inline(x,y)
+#define taucs_mul(x,y) taucs_zmul_inline(x,y)
 #define taucs_div(x,y) taucs_zdiv_fn(x,y)
-#define taucs_neg(x)   taucs_zneg_fn(x)
-#define taucs_conj(x)  taucs_zconj_fn(x)
+#define taucs_neg(x)   taucs_zneg_inline(x)
+#define taucs_conj(x)  taucs_zconj_inline(x)
 #define taucs_abs(x)   taucs_zabs_fn(x)
 #define taucs_sqrt(x)  taucs_zsqrt_fn(x)
 
@@ -429,12 +498,12 @@ typedef struct {float  r,i;} taucs_scomplex;
 
 #define taucs_complex_create(r,i) taucs_ccomplex_create_fn(r,i)
 
-#define taucs_add(x,y) taucs_cadd_fn(x,y)
-#define taucs_sub(x,y) taucs_csub_fn(x,y)
-#define taucs_mul(x,y) taucs_cmul_fn(x,y)
+#define taucs_add(x,y) taucs_cadd_inline(x,y)
+#define taucs_sub(x,y) taucs_csub_inline(x,y)
+#define taucs_mul(x,y) taucs_cmul_inline(x,y)
 #define taucs_div(x,y) taucs_cdiv_fn(x,y)
-#define taucs_neg(x)   taucs_cneg_fn(x)
-#define taucs_conj(x)  taucs_cconj_fn(x)
+#define taucs_neg(x)   taucs_cneg_inline(x)
+#define taucs_conj(x)  taucs_cconj_inline(x)
 #define taucs_abs(x)   taucs_cabs_fn(x)
 #define taucs_sqrt(x)  taucs_csqrt_fn(x)
 
@@ -594,8 +663,8 @@ typedef struct
   int     n;    /* columns                      */
   int     m;    /* rows; don't use if symmetric   */
   int     flags;
-  int*    colptr; /* pointers to where columns begin in rowind and values. */
-                  /* 0-based. Length is (n+1). */
+  taucs_index* colptr; /* pointers to where columns begin in rowind and values. */
+                       /* 0-based. Length is (n+1).                          */
   int*    rowind; /* row indices */
 
   union {
@@ -615,8 +684,35 @@ typedef struct {
 
   /* the following may change! do not rely on them. */
   double nreads, nwrites, bytes_read, bytes_written, read_time, write_time;
+  int    compress; /* see taucs_io_set_compression */
+  void*  direct;   /* see taucs_io_set_direct; NULL when off */
 } taucs_io_handle;
 
+/* controls and results of an iterative solve; see     */
+/* taucs_conjugate_gradients_info and taucs_minres_info */
+
+typedef struct {
+  /* controls */
+  int     itermax;
+  double  convergetol;
+  int     replace_every;  /* true-residual replacement period, 0 = only at convergence */
+  int   (*callback)(void* arg, int iteration, double relres); /* nonzero stops */
+  void*   callback_arg;
+  double* resvec;         /* optional residual history, caller allocated */
+  int     resvec_length;
+
+  /* results */
+  int     iterations;
+  int     converged;
+  int     stopped;        /* stopped by the callback */
+  int     replacements;
+  int     resvec_used;
+  double  relres;         /* final relative residual */
+  double  solve_time;
+  double  precond_time;
+  double  time_per_iteration;
+} taucs_iter_info;
+
 /* forward type declarations for various structures */
 /*typedef struct multilu_blocked_factor_st multilu_blocked_factor;*/
 typedef struct taucs_multilu_factor_st   taucs_multilu_factor;
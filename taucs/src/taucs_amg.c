@@ -0,0 +1,931 @@
+/*********************************************************/
+/* TAUCS                                                 */
+/* File  : taucs_amg.c                                   */
+/* Description: smoothed-aggregation algebraic multigrid */
+/*********************************************************/
+
+/*
+  A smoothed-aggregation AMG preconditioner for symmetric positive
+  definite matrices.
+
+  Setup, level by level:
+    - strong connections: |a_ij| > theta_l * sqrt(a_ii a_jj), with
+      theta_l = theta * 2^-l;
+    - aggregation, in the usual three greedy passes (seed aggregates
+      made of a node and its untouched strong neighbors, then leftover
+      nodes join a neighboring aggregate, then what is still left
+      forms aggregates of its own);
+    - a tentative prolongator T that is piecewise constant on the
+      aggregates, smoothed by one damped Jacobi step,
+      P = (I - omega D^-1 A) T with omega = 4 / (3 rho(D^-1 A));
+    - the Galerkin product A_c = P^T A P.
+  Coarsening stops at maxlevels, when the matrix is small enough, or
+  when it stops shrinking. The coarsest matrix is ordered and factored
+  with the supernodal Cholesky code.
+
+  The preconditioner applies one V-cycle with the same number of damped
+  Jacobi sweeps before and after the coarse-grid correction, so it is
+  symmetric and can be used with taucs_conjugate_gradients.
+
+  Each level keeps the full (both triangles) matrix in compressed rows;
+  P and P^T are kept by rows as well, so the sparse products, the
+  Jacobi sweeps, the restriction and the prolongation are all loops
+  over independent rows. With TAUCS_CONFIG_PFUNC and nproc > 1, those
+  loops are split into nproc contiguous row ranges that run on PFUNC
+  threads. The aggregation itself is sequential.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include <limits.h>
+#include "taucs.h"
+
+#ifdef TAUCS_CONFIG_PFUNC
+#include "pfunc.h"
+#endif
+
+#ifdef TAUCS_CORE_DOUBLE
+
+/* row loops shorter than this are not worth splitting among threads */
+#define AMG_PARALLEL_CUTOFF 2048
+
+/* power iterations for the estimate of rho(D^-1 A) */
+#define AMG_POWER_ITERATIONS 15
+
+/* stop coarsening when a level shrinks by less than this factor */
+#define AMG_MIN_COARSENING 0.9
+
+typedef struct {
+  int     n;
+  int*    ptr;
+  int*    ind;
+  double* val;
+} amg_csr;
+
+typedef struct {
+  amg_csr A;        /* the full matrix of this level                 */
+  double* invdiag;  /* omega / a_ii, for the Jacobi sweeps           */
+  amg_csr P;        /* prolongator, n rows, columns in the next level */
+  amg_csr R;        /* P^T                                           */
+  double* x;        /* V-cycle vectors of this level                 */
+  double* b;
+  double* r;
+} amg_level;
+
+typedef struct {
+  int        nlevels;
+  amg_level* levels;
+  int        nproc;
+  int        sweeps;
+
+  /* the coarse-grid solver */
+  void*      L;
+  int*       perm;
+  int*       invperm;
+  double*    px;
+  double*    pb;
+} amg_preconditioner;
+
+/*********************************************************/
+/* row-parallel loops                                    */
+/*********************************************************/
+
+typedef void (*amg_kernel)(void* S, int tid, int begin, int end);
+
+typedef struct {
+  amg_kernel fn;
+  void*      S;
+  int        tid;
+  int        begin;
+  int        end;
+} amg_task;
+
+#ifdef TAUCS_CONFIG_PFUNC
+static void amg_thread(void* args)
+{
+  amg_task* T;
+
+  pfunc_unpack(args, "void*", (void*)&T);
+  (T->fn)(T->S, T->tid, T->begin, T->end);
+}
+#endif
+
+/*
+  Runs fn on rows 0..n-1. Thread tid gets a contiguous range; kernels
+  use tid to pick their scratch space, so they must be called with
+  tid < nproc.
+*/
+
+static void
+amg_for(amg_kernel fn, void* S, int n, int nproc)
+{
+#ifdef TAUCS_CONFIG_PFUNC
+  if (nproc > 1 && n >= AMG_PARALLEL_CUTOFF) {
+    amg_task*       tasks   = (amg_task*) taucs_malloc(nproc * sizeof(amg_task));
+    char**          args    = (char**) taucs_malloc(nproc * sizeof(char*));
+    pfunc_handle_t* handles = (pfunc_handle_t*) taucs_malloc(nproc * sizeof(pfunc_handle_t));
+    int t;
+
+    if (tasks && args && handles) {
+      for (t=0; t<nproc; t++) {
+	tasks[t].fn    = fn;
+	tasks[t].S     = S;
+	tasks[t].tid   = t;
+	tasks[t].begin = (int) (((double) n * t)     / nproc);
+	tasks[t].end   = (int) (((double) n * (t+1)) / nproc);
+	pfunc_handle_init(&handles[t]);
+	pfunc_pack(&args[t], "void*", &tasks[t]);
+	pfunc_run(&handles[t], PFUNC_ATTR_DEFAULT, PFUNC_GROUP_DEFAULT,
+		  amg_thread, args[t]);
+      }
+      pfunc_wait_all(handles, nproc);
+      for (t=0; t<nproc; t++)
+	pfunc_handle_clear(handles[t]);
+      taucs_free(handles);
+      taucs_free(args);
+      taucs_free(tasks);
+      return;
+    }
+    taucs_free(handles);
+    taucs_free(args);
+    taucs_free(tasks);
+  }
+#endif
+  (*fn)(S, 0, 0, n);
+}
+
+/*********************************************************/
+/* compressed-row matrices                               */
+/*********************************************************/
+
+static void
+amg_csr_free(amg_csr* M)
+{
+  taucs_free(M->ptr);
+  taucs_free(M->ind);
+  taucs_free(M->val);
+  M->ptr = M->ind = NULL;
+  M->val = NULL;
+}
+
+/* both triangles of a symmetric ccs matrix that stores the lower one */
+
+static int
+amg_csr_from_ccs(taucs_ccs_matrix* A, amg_csr* M)
+{
+  int n = A->n;
+  int i,j;
+  taucs_index ip,nnz;
+  int* next;
+
+  nnz = 0;
+  for (j=0; j<n; j++)
+    for (ip = (A->colptr)[j]; ip < (A->colptr)[j+1]; ip++)
+      nnz += ((A->rowind)[ip] == j) ? 1 : 2;
+  /* the hierarchy itself is stored with int pointers */
+  if ((double) nnz > (double) INT_MAX) return -1;
+
+  M->n   = n;
+  M->ptr = (int*)    taucs_calloc(n+1, sizeof(int));
+  M->ind = (int*)    taucs_malloc((nnz ? nnz : 1) * sizeof(int));
+  M->val = (double*) taucs_malloc((nnz ? nnz : 1) * sizeof(double));
+  next   = (int*)    taucs_malloc((n ? n : 1) * sizeof(int));
+  if (!M->ptr || !M->ind || !M->val || !next) {
+    amg_csr_free(M);
+    taucs_free(next);
+    return -1;
+  }
+
+  for (j=0; j<n; j++)
+    for (ip = (A->colptr)[j]; ip < (A->colptr)[j+1]; ip++) {
+      i = (A->rowind)[ip];
+      (M->ptr)[i+1]++;
+      if (i != j) (M->ptr)[j+1]++;
+    }
+  for (i=0; i<n; i++) (M->ptr)[i+1] += (M->ptr)[i];
+  for (i=0; i<n; i++) next[i] = (M->ptr)[i];
+
+  for (j=0; j<n; j++)
+    for (ip = (A->colptr)[j]; ip < (A->colptr)[j+1]; ip++) {
+      i = (A->rowind)[ip];
+      (M->ind)[ next[i] ]   = j;
+      (M->val)[ next[i]++ ] = (A->values.d)[ip];
+      if (i != j) {
+	(M->ind)[ next[j] ]   = i;
+	(M->val)[ next[j]++ ] = (A->values.d)[ip];
+      }
+    }
+
+  taucs_free(next);
+  return 0;
+}
+
+/* the lower triangle of a symmetric level matrix, for the coarse factor */
+
+static taucs_ccs_matrix*
+amg_csr_to_ccs(amg_csr* M)
+{
+  taucs_ccs_matrix* A;
+  int n = M->n;
+  int i,ip,nnz;
+
+  nnz = 0;
+  for (i=0; i<n; i++)
+    for (ip = (M->ptr)[i]; ip < (M->ptr)[i+1]; ip++)
+      if ((M->ind)[ip] >= i) nnz++;
+
+  A = taucs_dccs_create(n,n,nnz);
+  if (!A) return NULL;
+  A->flags = TAUCS_DOUBLE | TAUCS_SYMMETRIC | TAUCS_LOWER;
+
+  /* row i of a symmetric matrix is column i */
+  nnz = 0;
+  for (i=0; i<n; i++) {
+    (A->colptr)[i] = nnz;
+    for (ip = (M->ptr)[i]; ip < (M->ptr)[i+1]; ip++)
+      if ((M->ind)[ip] >= i) {
+	(A->rowind)[nnz]   = (M->ind)[ip];
+	(A->values.d)[nnz] = (M->val)[ip];
+	nnz++;
+      }
+  }
+  (A->colptr)[n] = nnz;
+
+  return A;
+}
+
+static int
+amg_csr_transpose(amg_csr* M, int ncols, amg_csr* T)
+{
+  int i,ip,j,q;
+  int nnz = (M->ptr)[M->n];
+
+  T->n   = ncols;
+  T->ptr = (int*)    taucs_calloc(ncols+1, sizeof(int));
+  T->ind = (int*)    taucs_malloc((nnz ? nnz : 1) * sizeof(int));
+  T->val = (double*) taucs_malloc((nnz ? nnz : 1) * sizeof(double));
+  if (!T->ptr || !T->ind || !T->val) {
+    amg_csr_free(T);
+    return -1;
+  }
+
+  for (ip=0; ip<nnz; ip++) (T->ptr)[ (M->ind)[ip] + 1 ]++;
+  for (j=0; j<ncols; j++) (T->ptr)[j+1] += (T->ptr)[j];
+
+  /* the ptr entries serve as insertion points, then shift back */
+  for (i=0; i<M->n; i++)
+    for (ip = (M->ptr)[i]; ip < (M->ptr)[i+1]; ip++) {
+      j = (M->ind)[ip];
+      q = (T->ptr)[j]++;
+      (T->ind)[q] = i;
+      (T->val)[q] = (M->val)[ip];
+    }
+  for (j=ncols; j>0; j--) (T->ptr)[j] = (T->ptr)[j-1];
+  (T->ptr)[0] = 0;
+
+  return 0;
+}
+
+/*
+  C = A*B by rows. The first pass counts the entries of each row of C,
+  the second fills them in; both run row-parallel, each thread with a
+  marker array of its own.
+*/
+
+typedef struct {
+  amg_csr* A;
+  amg_csr* B;
+  amg_csr* C;
+  int      ncols;
+  int*     marks;  /* nproc * ncols */
+  double*  accum;  /* nproc * ncols */
+} amg_spgemm_state;
+
+static void
+amg_spgemm_count(void* vS, int tid, int begin, int end)
+{
+  amg_spgemm_state* S = (amg_spgemm_state*) vS;
+  int* mark = S->marks + (size_t) tid * S->ncols;
+  int  i,ip,k,kp,c,len;
+
+  for (i=begin; i<end; i++) {
+    len = 0;
+    for (ip = (S->A->ptr)[i]; ip < (S->A->ptr)[i+1]; ip++) {
+      k = (S->A->ind)[ip];
+      for (kp = (S->B->ptr)[k]; kp < (S->B->ptr)[k+1]; kp++) {
+	c = (S->B->ind)[kp];
+	if (mark[c] != i) { mark[c] = i; len++; }
+      }
+    }
+    (S->C->ptr)[i+1] = len;
+  }
+}
+
+static void
+amg_spgemm_fill(void* vS, int tid, int begin, int end)
+{
+  amg_spgemm_state* S = (amg_spgemm_state*) vS;
+  int*    mark  = S->marks + (size_t) tid * S->ncols;
+  double* accum = S->accum + (size_t) tid * S->ncols;
+  int     i,ip,k,kp,c,q,first;
+  double  a;
+
+  for (i=begin; i<end; i++) {
+    first = q = (S->C->ptr)[i];
+    for (ip = (S->A->ptr)[i]; ip < (S->A->ptr)[i+1]; ip++) {
+      k = (S->A->ind)[ip];
+      a = (S->A->val)[ip];
+      for (kp = (S->B->ptr)[k]; kp < (S->B->ptr)[k+1]; kp++) {
+	c = (S->B->ind)[kp];
+	if (mark[c] != i) {
+	  mark[c] = i;
+	  accum[c] = 0.0;
+	  (S->C->ind)[q++] = c;
+	}
+	accum[c] += a * (S->B->val)[kp];
+      }
+    }
+    for (; first < q; first++)
+      (S->C->val)[first] = accum[ (S->C->ind)[first] ];
+  }
+}
+
+static int
+amg_spgemm(amg_csr* A, amg_csr* B, int ncols, amg_csr* C, int nproc)
+{
+  amg_spgemm_state S;
+  int i,m = A->n;
+
+  S.A = A; S.B = B; S.C = C;
+  S.ncols = ncols;
+  S.marks = (int*)    taucs_malloc((size_t) nproc * (ncols ? ncols : 1) * sizeof(int));
+  S.accum = (double*) taucs_malloc((size_t) nproc * (ncols ? ncols : 1) * sizeof(double));
+  C->n    = m;
+  C->ptr  = (int*) taucs_malloc((m+1) * sizeof(int));
+  C->ind  = NULL;
+  C->val  = NULL;
+  if (!S.marks || !S.accum || !C->ptr) {
+    taucs_free(S.marks);
+    taucs_free(S.accum);
+    amg_csr_free(C);
+    return -1;
+  }
+
+  for (i=0; i < nproc*ncols; i++) (S.marks)[i] = -1;
+  amg_for(amg_spgemm_count, &S, m, nproc);
+
+  (C->ptr)[0] = 0;
+  for (i=0; i<m; i++) (C->ptr)[i+1] += (C->ptr)[i];
+
+  C->ind = (int*)    taucs_malloc(((C->ptr)[m] ? (C->ptr)[m] : 1) * sizeof(int));
+  C->val = (double*) taucs_malloc(((C->ptr)[m] ? (C->ptr)[m] : 1) * sizeof(double));
+  if (!C->ind || !C->val) {
+    taucs_free(S.marks);
+    taucs_free(S.accum);
+    amg_csr_free(C);
+    return -1;
+  }
+
+  for (i=0; i < nproc*ncols; i++) (S.marks)[i] = -1;
+  amg_for(amg_spgemm_fill, &S, m, nproc);
+
+  taucs_free(S.marks);
+  taucs_free(S.accum);
+  return 0;
+}
+
+/*********************************************************/
+/* vector kernels                                        */
+/*********************************************************/
+
+typedef struct {
+  amg_csr* A;
+  amg_csr* M;        /* for the transfers: P or R */
+  double*  invdiag;
+  double*  x;
+  double*  b;
+  double*  r;
+  double*  y;
+} amg_vec_state;
+
+/* r = b - A x; with b == NULL, r = A x */
+
+static void
+amg_residual_kernel(void* vS, int tid, int begin, int end)
+{
+  amg_vec_state* S = (amg_vec_state*) vS;
+  int*    ptr = S->A->ptr;
+  int*    ind = S->A->ind;
+  double* val = S->A->val;
+  int     i,ip;
+  double  v;
+
+  for (i=begin; i<end; i++) {
+    v = 0.0;
+    for (ip = ptr[i]; ip < ptr[i+1]; ip++)
+      v += val[ip] * (S->x)[ ind[ip] ];
+    (S->r)[i] = (S->b) ? (S->b)[i] - v : v;
+  }
+}
+
+/* x += invdiag .* r */
+
+static void
+amg_correct_kernel(void* vS, int tid, int begin, int end)
+{
+  amg_vec_state* S = (amg_vec_state*) vS;
+  int i;
+
+  for (i=begin; i<end; i++)
+    (S->x)[i] += (S->invdiag)[i] * (S->r)[i];
+}
+
+/* y = M x (restriction), or y += M x (prolongation), with M by rows */
+
+static void
+amg_restrict_kernel(void* vS, int tid, int begin, int end)
+{
+  amg_vec_state* S = (amg_vec_state*) vS;
+  int    i,ip;
+  double v;
+
+  for (i=begin; i<end; i++) {
+    v = 0.0;
+    for (ip = (S->M->ptr)[i]; ip < (S->M->ptr)[i+1]; ip++)
+      v += (S->M->val)[ip] * (S->x)[ (S->M->ind)[ip] ];
+    (S->y)[i] = v;
+  }
+}
+
+static void
+amg_prolong_kernel(void* vS, int tid, int begin, int end)
+{
+  amg_vec_state* S = (amg_vec_state*) vS;
+  int    i,ip;
+  double v;
+
+  for (i=begin; i<end; i++) {
+    v = 0.0;
+    for (ip = (S->M->ptr)[i]; ip < (S->M->ptr)[i+1]; ip++)
+      v += (S->M->val)[ip] * (S->x)[ (S->M->ind)[ip] ];
+    (S->y)[i] += v;
+  }
+}
+
+/*********************************************************/
+/* setup                                                 */
+/*********************************************************/
+
+/*
+  Greedy aggregation on the strong-connection graph. Returns the
+  number of aggregates, or -1 if out of memory.
+*/
+
+static int
+amg_aggregate(amg_csr* A, double* diag, double theta, int* agg)
+{
+  int   n = A->n;
+  int   i,j,ip,nagg,free_nbrs,nstrong;
+  char* strong;
+
+  strong = (char*) taucs_malloc(((A->ptr)[n] ? (A->ptr)[n] : 1) * sizeof(char));
+  if (!strong) return -1;
+
+  for (i=0; i<n; i++) {
+    agg[i] = -1;
+    for (ip = (A->ptr)[i]; ip < (A->ptr)[i+1]; ip++) {
+      j = (A->ind)[ip];
+      strong[ip] = (j != i)
+	&& fabs((A->val)[ip]) > theta * sqrt(fabs(diag[i] * diag[j]));
+    }
+  }
+
+  /* pass 1: a node and all of its strong neighbors, if none is taken; */
+  /* nodes with no strong neighbors are left for pass 3               */
+
+  nagg = 0;
+  for (i=0; i<n; i++) {
+    if (agg[i] != -1) continue;
+    free_nbrs = 1;
+    nstrong   = 0;
+    for (ip = (A->ptr)[i]; ip < (A->ptr)[i+1]; ip++)
+      if (strong[ip]) {
+	nstrong++;
+	if (agg[ (A->ind)[ip] ] != -1) free_nbrs = 0;
+      }
+    if (!free_nbrs || nstrong == 0) continue;
+    agg[i] = nagg;
+    for (ip = (A->ptr)[i]; ip < (A->ptr)[i+1]; ip++)
+      if (strong[ip]) agg[ (A->ind)[ip] ] = nagg;
+    nagg++;
+  }
+
+  /* pass 2: join the aggregate of a strong neighbor; the negative */
+  /* marks keep these nodes from passing their aggregate along     */
+
+  for (i=0; i<n; i++) {
+    if (agg[i] != -1) continue;
+    for (ip = (A->ptr)[i]; ip < (A->ptr)[i+1]; ip++) {
+      j = (A->ind)[ip];
+      if (strong[ip] && agg[j] >= 0) {
+	agg[i] = -2 - agg[j];
+	break;
+      }
+    }
+  }
+  for (i=0; i<n; i++)
+    if (agg[i] <= -2) agg[i] = -2 - agg[i];
+
+  /* pass 3: whatever is left, with its untaken strong neighbors */
+
+  for (i=0; i<n; i++) {
+    if (agg[i] != -1) continue;
+    agg[i] = nagg;
+    for (ip = (A->ptr)[i]; ip < (A->ptr)[i+1]; ip++)
+      if (strong[ip] && agg[ (A->ind)[ip] ] == -1) agg[ (A->ind)[ip] ] = nagg;
+    nagg++;
+  }
+
+  taucs_free(strong);
+  return nagg;
+}
+
+/* rho(D^-1 A) by the power method; the result is an estimate from below */
+
+static double
+amg_spectral_radius(amg_csr* A, double* diag, double* v, double* w, int nproc)
+{
+  amg_vec_state S;
+  int    i,it,n = A->n;
+  double norm,rho = 1.0;
+
+  for (i=0; i<n; i++) v[i] = 1.0 + (double) (i % 7) / 7.0;
+
+  S.A = A; S.b = NULL; S.x = v; S.r = w;
+  for (it=0; it<AMG_POWER_ITERATIONS; it++) {
+    amg_for(amg_residual_kernel, &S, n, nproc);
+    norm = 0.0;
+    for (i=0; i<n; i++) { w[i] /= diag[i]; norm += w[i]*w[i]; }
+    norm = sqrt(norm);
+    if (norm == 0.0) break;
+    rho = 0.0;
+    for (i=0; i<n; i++) { rho += v[i]*v[i]; }
+    rho = norm / sqrt(rho);
+    for (i=0; i<n; i++) v[i] = w[i] / norm;
+  }
+  return rho;
+}
+
+/*
+  Builds P, R and the next level's matrix for level l. Returns the size
+  of the next level, or -1 on failure.
+*/
+
+static int
+amg_coarsen(amg_level* lev, amg_csr* Ac, double theta, int nproc)
+{
+  amg_csr  T, AT, AP;
+  int      n = lev->A.n;
+  int      i,ip,nc;
+  int*     agg;
+  int*     size;
+  double*  diag;
+  double*  v;
+  double   rho,omega;
+
+  agg  = (int*)    taucs_malloc(n * sizeof(int));
+  size = (int*)    taucs_calloc(n, sizeof(int));
+  diag = (double*) taucs_malloc(n * sizeof(double));
+  v    = (double*) taucs_malloc(n * sizeof(double));
+  T.ptr = NULL; T.ind = NULL; T.val = NULL;
+  if (!agg || !size || !diag || !v) goto fail;
+
+  for (i=0; i<n; i++) {
+    diag[i] = 0.0;
+    for (ip = (lev->A.ptr)[i]; ip < (lev->A.ptr)[i+1]; ip++)
+      if ((lev->A.ind)[ip] == i) diag[i] += (lev->A.val)[ip];
+    if (diag[i] <= 0.0) {
+      taucs_printf("taucs_amg: nonpositive diagonal in row %d, matrix is not SPD\n",i);
+      goto fail;
+    }
+  }
+
+  rho   = amg_spectral_radius(&(lev->A), diag, v, lev->r, nproc);
+  omega = 4.0 / (3.0 * rho);
+  for (i=0; i<n; i++) (lev->invdiag)[i] = omega / diag[i];
+
+  nc = amg_aggregate(&(lev->A), diag, theta, agg);
+  if (nc < 0) goto fail;
+
+  /* the tentative prolongator, normalized columns */
+
+  for (i=0; i<n; i++) size[ agg[i] ]++;
+  T.n   = n;
+  T.ptr = (int*)    taucs_malloc((n+1) * sizeof(int));
+  T.ind = (int*)    taucs_malloc(n * sizeof(int));
+  T.val = (double*) taucs_malloc(n * sizeof(double));
+  if (!T.ptr || !T.ind || !T.val) goto fail;
+  for (i=0; i<n; i++) {
+    (T.ptr)[i] = i;
+    (T.ind)[i] = agg[i];
+    (T.val)[i] = 1.0 / sqrt((double) size[ agg[i] ]);
+  }
+  (T.ptr)[n] = n;
+
+  /* P = T - omega D^-1 A T; row i of A T has column agg[i] */
+
+  if (amg_spgemm(&(lev->A), &T, nc, &AT, nproc) == -1) goto fail;
+  for (i=0; i<n; i++)
+    for (ip = (AT.ptr)[i]; ip < (AT.ptr)[i+1]; ip++) {
+      (AT.val)[ip] *= -(lev->invdiag)[i];
+      if ((AT.ind)[ip] == agg[i]) (AT.val)[ip] += (T.val)[i];
+    }
+  lev->P = AT;
+
+  if (amg_csr_transpose(&(lev->P), nc, &(lev->R)) == -1) goto fail;
+
+  /* A_c = R (A P) */
+
+  if (amg_spgemm(&(lev->A), &(lev->P), nc, &AP, nproc) == -1) goto fail;
+  if (amg_spgemm(&(lev->R), &AP, nc, Ac, nproc) == -1) {
+    amg_csr_free(&AP);
+    goto fail;
+  }
+  amg_csr_free(&AP);
+
+  taucs_printf("taucs_amg: level n=%d nnz=%d -> %d aggregates, rho(D^-1 A)=%.2f\n",
+	       n,(lev->A.ptr)[n],nc,rho);
+
+  amg_csr_free(&T);
+  taucs_free(agg);
+  taucs_free(size);
+  taucs_free(diag);
+  taucs_free(v);
+  return nc;
+
+ fail:
+  amg_csr_free(&T);
+  taucs_free(agg);
+  taucs_free(size);
+  taucs_free(diag);
+  taucs_free(v);
+  return -1;
+}
+
+/*********************************************************/
+/* V-cycle                                               */
+/*********************************************************/
+
+static void
+amg_jacobi(amg_preconditioner* M, amg_level* lev, int zero_guess)
+{
+  amg_vec_state S;
+  int n = lev->A.n;
+  int s,i;
+
+  S.A       = &(lev->A);
+  S.invdiag = lev->invdiag;
+  S.x       = lev->x;
+  S.b       = lev->b;
+  S.r       = lev->r;
+
+  for (s=0; s < M->sweeps; s++) {
+    if (s == 0 && zero_guess) {
+      for (i=0; i<n; i++) (lev->x)[i] = (lev->invdiag)[i] * (lev->b)[i];
+      continue;
+    }
+    amg_for(amg_residual_kernel, &S, n, M->nproc);
+    amg_for(amg_correct_kernel,  &S, n, M->nproc);
+  }
+}
+
+static void
+amg_vcycle(amg_preconditioner* M, int l)
+{
+  amg_level*    lev = (M->levels) + l;
+  amg_level*    next;
+  amg_vec_state S;
+  int           n = lev->A.n;
+  int           i;
+
+  if (l == M->nlevels - 1) {
+    taucs_vec_permute (n,TAUCS_DOUBLE,lev->b,M->pb,M->perm);
+    taucs_supernodal_solve_llt(M->L,M->px,M->pb);
+    taucs_vec_ipermute(n,TAUCS_DOUBLE,M->px,lev->x,M->perm);
+    return;
+  }
+
+  next = lev + 1;
+
+  if (M->sweeps > 0)
+    amg_jacobi(M,lev,1);
+  else
+    for (i=0; i<n; i++) (lev->x)[i] = 0.0;
+
+  /* restrict the residual */
+  S.A = &(lev->A);
+  S.x = lev->x;
+  S.b = lev->b;
+  S.r = lev->r;
+  amg_for(amg_residual_kernel, &S, n, M->nproc);
+
+  S.M = &(lev->R);
+  S.x = lev->r;
+  S.y = next->b;
+  amg_for(amg_restrict_kernel, &S, next->A.n, M->nproc);
+
+  amg_vcycle(M,l+1);
+
+  /* prolong the correction */
+  S.M = &(lev->P);
+  S.x = next->x;
+  S.y = lev->x;
+  amg_for(amg_prolong_kernel, &S, n, M->nproc);
+
+  amg_jacobi(M,lev,0);
+}
+
+/*********************************************************/
+/* interface                                             */
+/*********************************************************/
+
+void
+taucs_amg_preconditioner_free(void* vP)
+{
+  amg_preconditioner* M = (amg_preconditioner*) vP;
+  int l;
+
+  if (!M) return;
+
+  if (M->levels) {
+    for (l=0; l<M->nlevels; l++) {
+      amg_csr_free(&((M->levels)[l].A));
+      amg_csr_free(&((M->levels)[l].P));
+      amg_csr_free(&((M->levels)[l].R));
+      taucs_free((M->levels)[l].invdiag);
+      taucs_free((M->levels)[l].x);
+      taucs_free((M->levels)[l].b);
+      taucs_free((M->levels)[l].r);
+    }
+    taucs_free(M->levels);
+  }
+  if (M->L) taucs_supernodal_factor_free(M->L);
+  taucs_free(M->perm);
+  taucs_free(M->invperm);
+  taucs_free(M->px);
+  taucs_free(M->pb);
+  taucs_free(M);
+}
+
+void*
+taucs_amg_preconditioner_create(taucs_ccs_matrix* A,
+				int    maxlevels,
+				int    coarse_size,
+				double theta,
+				int    sweeps,
+				int    nproc)
+{
+  amg_preconditioner* M;
+  amg_level* lev;
+  taucs_ccs_matrix* Ac;
+  taucs_ccs_matrix* PAcPT;
+  amg_csr next;
+  int     l,n,nc;
+  double  wtime;
+  char*   ordering =
+#if defined(TAUCS_CONFIG_METIS)
+    "metis";
+#elif defined(TAUCS_CONFIG_GENMMD)
+    "genmmd";
+#elif defined(TAUCS_CONFIG_AMD)
+    "amd";
+#else
+    "identity";
+#endif
+
+  if (!(A->flags & TAUCS_DOUBLE)) {
+    taucs_printf("taucs_amg_preconditioner_create: only double-precision matrices\n");
+    return NULL;
+  }
+  if (!(A->flags & TAUCS_SYMMETRIC) || !(A->flags & TAUCS_LOWER)) {
+    taucs_printf("taucs_amg_preconditioner_create: matrix must be symmetric, lower part stored\n");
+    return NULL;
+  }
+
+  if (maxlevels   < 1) maxlevels   = 10;
+  if (coarse_size < 1) coarse_size = 500;
+  if (theta       < 0.0) theta     = 0.08;
+  if (sweeps      < 0) sweeps      = 1;
+  if (nproc       < 1) nproc       = 1;
+
+  taucs_printf("taucs_amg_preconditioner_create: n=%d maxlevels=%d coarse=%d theta=%.3f sweeps=%d nproc=%d\n",
+	       A->n,maxlevels,coarse_size,theta,sweeps,nproc);
+  wtime = taucs_wtime();
+
+  M = (amg_preconditioner*) taucs_malloc(sizeof(amg_preconditioner));
+  if (!M) return NULL;
+  M->nlevels = 0;
+  M->nproc   = nproc;
+  M->sweeps  = sweeps;
+  M->L       = NULL;
+  M->perm    = M->invperm = NULL;
+  M->px      = M->pb      = NULL;
+  M->levels  = (amg_level*) taucs_calloc(maxlevels, sizeof(amg_level));
+  if (!M->levels) {
+    taucs_free(M);
+    return NULL;
+  }
+
+  if (amg_csr_from_ccs(A,&next) == -1) {
+    taucs_amg_preconditioner_free(M);
+    return NULL;
+  }
+
+  for (l=0; l<maxlevels; l++) {
+    lev = (M->levels) + l;
+    lev->A = next;
+    M->nlevels = l+1;
+    n = lev->A.n;
+
+    lev->x = (double*) taucs_malloc((n ? n : 1) * sizeof(double));
+    lev->b = (double*) taucs_malloc((n ? n : 1) * sizeof(double));
+    lev->r = (double*) taucs_malloc((n ? n : 1) * sizeof(double));
+    lev->invdiag = (double*) taucs_malloc((n ? n : 1) * sizeof(double));
+    if (!lev->x || !lev->b || !lev->r || !lev->invdiag) {
+      taucs_amg_preconditioner_free(M);
+      return NULL;
+    }
+
+    if (n <= coarse_size || l == maxlevels-1) break;
+
+    nc = amg_coarsen(lev, &next, theta * pow(0.5,(double) l), nproc);
+    if (nc == -1) {
+      taucs_amg_preconditioner_free(M);
+      return NULL;
+    }
+
+    if (nc == 0 || (double) nc > AMG_MIN_COARSENING * (double) n) {
+      /* coarsening stalled; this level is the coarsest */
+      amg_csr_free(&next);
+      amg_csr_free(&(lev->P));
+      amg_csr_free(&(lev->R));
+      break;
+    }
+  }
+
+  /* the coarsest level is solved directly */
+
+  lev = (M->levels) + (M->nlevels - 1);
+  n   = lev->A.n;
+  Ac  = amg_csr_to_ccs(&(lev->A));
+  M->px = (double*) taucs_malloc((n ? n : 1) * sizeof(double));
+  M->pb = (double*) taucs_malloc((n ? n : 1) * sizeof(double));
+  if (!Ac || !M->px || !M->pb) {
+    taucs_ccs_free(Ac);
+    taucs_amg_preconditioner_free(M);
+    return NULL;
+  }
+
+  taucs_ccs_order(Ac,&(M->perm),&(M->invperm),ordering);
+  if (!M->perm) {
+    taucs_printf("taucs_amg_preconditioner_create: ordering of the coarse matrix failed\n");
+    taucs_ccs_free(Ac);
+    taucs_amg_preconditioner_free(M);
+    return NULL;
+  }
+  PAcPT = taucs_ccs_permute_symmetrically(Ac,M->perm,M->invperm);
+  taucs_ccs_free(Ac);
+  /* the left-looking variant, since the multifrontal one is a Cilk */
+  /* procedure in Cilk builds                                       */
+  if (PAcPT) M->L = taucs_ccs_factor_llt_ll(PAcPT);
+  taucs_ccs_free(PAcPT);
+  if (!M->L) {
+    taucs_printf("taucs_amg_preconditioner_create: coarse factorization failed\n");
+    taucs_amg_preconditioner_free(M);
+    return NULL;
+  }
+
+  taucs_printf("taucs_amg_preconditioner_create: %d levels, coarsest n=%d, %.3f seconds\n",
+	       M->nlevels,n,taucs_wtime()-wtime);
+
+  return M;
+}
+
+int
+taucs_amg_preconditioner_solve(void* vP, void* vZ, void* vR)
+{
+  amg_preconditioner* M = (amg_preconditioner*) vP;
+  amg_level* lev = M->levels;
+  int n = lev->A.n;
+  int i;
+
+  for (i=0; i<n; i++) (lev->b)[i] = ((double*) vR)[i];
+  amg_vcycle(M,0);
+  for (i=0; i<n; i++) ((double*) vZ)[i] = (lev->x)[i];
+
+  return 0;
+}
+
+#endif /* TAUCS_CORE_DOUBLE */
@@ -32,10 +32,10 @@ taucs_ccs_free(taucs_ccs_matrix* matrix)
 */
 
 #ifdef TAUCS_CORE_GENERAL
-static taucs_ccs_matrix *taucs_ccs_create_pattern(int m, int n, int nnz);
+static taucs_ccs_matrix *taucs_ccs_create_pattern(int m, int n, taucs_index nnz);
 
 taucs_ccs_matrix* 
-taucs_ccs_create(int m, int n, int nnz, int flags)
+taucs_ccs_create(int m, int n, taucs_index nnz, int flags)
 {
   taucs_ccs_matrix* A = NULL;
 
@@ -71,7 +71,7 @@ taucs_ccs_create(int m, int n, int nnz, int flags)
   }
 }
 
-taucs_ccs_matrix *taucs_ccs_create_pattern(int m, int n, int nnz) 
+taucs_ccs_matrix *taucs_ccs_create_pattern(int m, int n, taucs_index nnz) 
 {
   taucs_ccs_matrix* matrix;
 
@@ -85,11 +85,11 @@ taucs_ccs_matrix *taucs_ccs_create_pattern(int m, int n, int nnz)
 
   matrix->n = n;
   matrix->m = m;
-  matrix->colptr = (int*)    taucs_malloc((n+1) * sizeof(int));
-  matrix->rowind = (int*)    taucs_malloc(nnz   * sizeof(int));
+  matrix->colptr = (taucs_index*) taucs_malloc((n+1) * sizeof(taucs_index));
+  matrix->rowind = (int*)         taucs_malloc(nnz   * sizeof(int));
   matrix->values.v = NULL;
   if (!(matrix->colptr) || !(matrix->rowind)) {
-    taucs_printf("taucs_ccs_create: out of memory (n=%d, nnz=%d)\n",n,nnz);
+    taucs_printf("taucs_ccs_create: out of memory (n=%d, nnz=%.0f)\n",n,(double) nnz);
     taucs_free(matrix->colptr); 
     taucs_free(matrix->rowind); 
     taucs_free (matrix);
@@ -103,7 +103,7 @@ taucs_ccs_matrix *taucs_ccs_create_pattern(int m, int n, int nnz)
 
 #ifndef TAUCS_CORE_GENERAL
 taucs_ccs_matrix* 
-taucs_dtl(ccs_create)(int m, int n, int nnz)
+taucs_dtl(ccs_create)(int m, int n, taucs_index nnz)
 {
   taucs_ccs_matrix* matrix;
 
@@ -131,11 +131,11 @@ taucs_dtl(ccs_create)(int m, int n, int nnz)
 
   matrix->n = n;
   matrix->m = m;
-  matrix->colptr = (int*)    taucs_malloc((n+1) * sizeof(int));
-  matrix->rowind = (int*)    taucs_malloc(nnz   * sizeof(int));
+  matrix->colptr = (taucs_index*) taucs_malloc((n+1) * sizeof(taucs_index));
+  matrix->rowind = (int*)         taucs_malloc(nnz   * sizeof(int));
   matrix->taucs_values = (taucs_datatype*) taucs_malloc(nnz * sizeof(taucs_datatype));
   if (!(matrix->colptr) || !(matrix->rowind) || !(matrix->taucs_values)) {
-    taucs_printf("taucs_ccs_create: out of memory (n=%d, nnz=%d)\n",n,nnz);
+    taucs_printf("taucs_ccs_create: out of memory (n=%d, nnz=%.0f)\n",n,(double) nnz);
     taucs_free(matrix->colptr); 
     taucs_free(matrix->rowind); 
     taucs_free(matrix->taucs_values);
@@ -64,7 +64,8 @@ static void spa_free(spa* s)
 
 static void spa_set(spa* s, taucs_ccs_matrix* A, int j)
 {
-  int i, ip, next;
+  int i, next;
+  taucs_index ip;
   taucs_datatype Aij;
   
   assert(j < A->n);
@@ -88,7 +89,8 @@ static void spa_set(spa* s, taucs_ccs_matrix* A, int j)
 
 static void spa_scale_add(spa* s, int j, taucs_ccs_matrix* A, int k, taucs_datatype alpha)
 {
-  int i, ip, next;
+  int i, next;
+  taucs_index ip;
   taucs_datatype Aik;
   
   assert(k < A->n);
@@ -125,123 +127,127 @@ static void spa_scale_add(spa* s, int j, taucs_ccs_matrix* A, int k, taucs_datat
 /* linked lists for rows                                 */
 /*********************************************************/
 
-static int*            rowlist;
-static int*            rowlist_next;
-static int*            rowlist_colind;
-static taucs_datatype* rowlist_values;
+typedef struct {
+  taucs_index*    head;
+  taucs_index*    next;
+  int*            colind;
+  taucs_datatype* values;
 
-static int     rowlist_freelist;
-static int     rowlist_size;
-static int     rowlist_next_expansion;
+  taucs_index     freelist;
+  taucs_index     size;
+  taucs_index     next_expansion;
+} rowlist;
 
-static int rowlist_create(int n)
+static void rowlist_free(rowlist* r)
 {
-  int i;
+  if (!r) return;
+
+  taucs_free(r->head);
+  taucs_free(r->next);
+  taucs_free(r->colind);
+  taucs_free(r->values);
+  taucs_free(r);
+}
+
+static rowlist* rowlist_create(int n)
+{
+  taucs_index i;
+  rowlist* r;
+
+  r = (rowlist*) taucs_malloc( sizeof(rowlist) );
+  if ( !r ) return NULL;
 
-  rowlist_size           = 1000;
-  rowlist_next_expansion = 1000;
-
-  rowlist        = (int*) taucs_malloc( n * sizeof(int) );
-  rowlist_next   = (int*) taucs_malloc( rowlist_size * sizeof(int) );
-  rowlist_colind = (int*) taucs_malloc( rowlist_size * sizeof(int) );
-  rowlist_values = (taucs_datatype*) taucs_malloc( rowlist_size * sizeof(taucs_datatype) );
-
-  if (!rowlist || !rowlist_next | !rowlist_colind || !rowlist_values) {
-    taucs_free(rowlist);
-    taucs_free(rowlist_next);
-    taucs_free(rowlist_colind);
-    taucs_free(rowlist_values);
-    rowlist = rowlist_next = rowlist_colind = NULL;
-    rowlist_values = NULL;
-    return -1;
+  r->size           = 1000;
+  r->next_expansion = 1000;
+
+  r->head   = (taucs_index*) taucs_malloc( n * sizeof(taucs_index) );
+  r->next   = (taucs_index*) taucs_malloc( r->size * sizeof(taucs_index) );
+  r->colind = (int*) taucs_malloc( r->size * sizeof(int) );
+  r->values = (taucs_datatype*) taucs_malloc( r->size * sizeof(taucs_datatype) );
+
+  if (!(r->head) || !(r->next) || !(r->colind) || !(r->values)) {
+    rowlist_free(r);
+    return NULL;
   }
 
-  for (i=0; i<n; i++) rowlist[i] = -1; /* no list yet for row i */
+  for (i=0; i<n; i++) (r->head)[i] = -1; /* no list yet for row i */
 
   /* free list */
-  rowlist_freelist = 0; 
-  for (i=0; i<rowlist_size-1; i++) rowlist_next[i] = i+1; 
-  rowlist_next[rowlist_size-1] = -1;
+  r->freelist = 0; 
+  for (i=0; i<r->size-1; i++) (r->next)[i] = i+1; 
+  (r->next)[r->size-1] = -1;
 				   
-  return 0;
-}
-
-static void rowlist_free()
-{
-  taucs_free(rowlist);
-  taucs_free(rowlist_next);
-  taucs_free(rowlist_colind);
-  taucs_free(rowlist_values);
+  return r;
 }
 
-/* static void rowlist_freerow(int i){} */
+/* static void rowlist_freerow(rowlist* r, int i){} */
 
-static int rowlist_add(int i,int j,taucs_datatype v)
+static int rowlist_add(rowlist* r, int i,int j,taucs_datatype v)
 {
-  int             l;
-  int*            new_next;
+  taucs_index     l;
+  taucs_index*    new_next;
   int*            new_colind;
   taucs_datatype* new_values;
 
-  if (rowlist_freelist == -1) {
-    int inc = rowlist_next_expansion;
-    int ii;
+  if (r->freelist == -1) {
+    taucs_index inc = r->next_expansion;
+    taucs_index ii;
 
-    rowlist_next_expansion = (int) floor(1.25 * (double) rowlist_next_expansion);
+    r->next_expansion = (taucs_index) floor(1.25 * (double) r->next_expansion);
 
-    new_next   = (int*) taucs_realloc( rowlist_next,   (rowlist_size+inc) * sizeof(int) );
+    new_next   = (taucs_index*) taucs_realloc( r->next,   (r->size+inc) * sizeof(taucs_index) );
     if (!new_next) return -1;
-    rowlist_next   = new_next;
+    r->next   = new_next;
 
-    new_colind = (int*) taucs_realloc( rowlist_colind, (rowlist_size+inc) * sizeof(int) );
+    new_colind = (int*) taucs_realloc( r->colind, (r->size+inc) * sizeof(int) );
     if (!new_colind) return -1;
-    rowlist_colind = new_colind;
+    r->colind = new_colind;
 
     new_values = (taucs_datatype*) 
-                            taucs_realloc(rowlist_values, 
-				    (rowlist_size+inc) * sizeof(taucs_datatype) );
+                            taucs_realloc(r->values, 
+				    (r->size+inc) * sizeof(taucs_datatype) );
     if (!new_values) return -1;
-    rowlist_values = new_values;
+    r->values = new_values;
 
-    rowlist_freelist = rowlist_size;
-    for (ii=rowlist_size; ii<rowlist_size+inc-1; ii++)
-      rowlist_next[ii] = ii+1;
-    rowlist_next[ rowlist_size+inc-1 ] = -1;
+    r->freelist = r->size;
+    for (ii=r->size; ii<r->size+inc-1; ii++)
+      (r->next)[ii] = ii+1;
+    (r->next)[ r->size+inc-1 ] = -1;
 
-    rowlist_size    += inc;
+    r->size    += inc;
   }
 
-  l = rowlist_freelist;
-  rowlist_freelist = rowlist_next[ rowlist_freelist ];
+  l = r->freelist;
+  r->freelist = (r->next)[ r->freelist ];
 
-  rowlist_next  [ l ] = rowlist[ i ];
-  rowlist_colind[ l ] = j;
-  rowlist_values[ l ] = v;
+  (r->next)  [ l ] = (r->head)[ i ];
+  (r->colind)[ l ] = j;
+  (r->values)[ l ] = v;
   
-  rowlist[ i ] = l;
+  (r->head)[ i ] = l;
 
 
   return 0;
 }
 
-static int rowlist_getfirst(int i)
+static taucs_index rowlist_getfirst(rowlist* r, int i)
 {
-  return rowlist[ i ];
+  return (r->head)[ i ];
 }
 
-static int rowlist_getnext(int l)
+static taucs_index rowlist_getnext(rowlist* r, taucs_index l)
 {
-  return rowlist_next[ l ];
+  return (r->next)[ l ];
 }
 
-static int rowlist_getcolind(int l)
+static int rowlist_getcolind(rowlist* r, taucs_index l)
 {
-  return rowlist_colind[ l ];
+  return (r->colind)[ l ];
 }
 
-static taucs_datatype rowlist_getvalue(int l)
+static taucs_datatype rowlist_getvalue(rowlist* r, taucs_index l)
 {
-  return rowlist_values[ l ];
+  return (r->values)[ l ];
 }
 
 /*********************************************************/
@@ -255,10 +261,12 @@ static taucs_datatype rowlist_getvalue(int l)
 taucs_ccs_matrix* 
 taucs_dtl(ccs_factor_llt)(taucs_ccs_matrix* A,double droptol, int modified)
 {
-  int            i,j,k,l,n,ip,next,Lnnz;
+  int            i,j,k,n,ip;
+  taucs_index    l,next,Lnnz;
   taucs_datatype Lkj,pivot,v;
   double norm;
   spa*           s;
+  rowlist*       r;
   taucs_ccs_matrix* L;
   taucs_datatype* dropped;
   int Aj_nnz;
@@ -289,14 +297,14 @@ taucs_dtl(ccs_factor_llt)(taucs_ccs_matrix* A,double droptol, int modified)
   next = 0;
 
   s = spa_create(n);
-  i = rowlist_create(n);
+  r = rowlist_create(n);
 
   dropped = (taucs_datatype*) taucs_malloc( n * sizeof(taucs_datatype) );
 
-  if (!s || i == -1 || !dropped) {
+  if (!s || !r || !dropped) {
     taucs_ccs_free(L);
     spa_free(s);
-    rowlist_free();
+    rowlist_free(r);
     taucs_free(dropped);
     return NULL;
   }
@@ -306,11 +314,11 @@ taucs_dtl(ccs_factor_llt)(taucs_ccs_matrix* A,double droptol, int modified)
   for (j=0; j<n; j++) {
     spa_set(s,A,j);
 
-    for (l = rowlist_getfirst(j); 
+    for (l = rowlist_getfirst(r,j); 
 	 l != -1; 
-	 l = rowlist_getnext(l)) {
-      k   = rowlist_getcolind(l);
-      Lkj = rowlist_getvalue(l);
+	 l = rowlist_getnext(r,l)) {
+      k   = rowlist_getcolind(r,l);
+      Lkj = rowlist_getvalue(r,l);
       /*spa_scale_add(s,j,L,k,taucs_neg(Lkj));*/ /* L_*j -= L_kj * L_*k */
       spa_scale_add(s,j,L,k,taucs_neg(taucs_conj(Lkj))); /* L_*j -= L_kj * L_*k */
     }
@@ -320,7 +328,7 @@ taucs_dtl(ccs_factor_llt)(taucs_ccs_matrix* A,double droptol, int modified)
     if ( next+(s->length) > Lnnz ) {
       int*    rowind;
       taucs_datatype* values;
-      int inc = max( (int) floor(1.25 * (double)Lnnz) , max( 8192, s->length ) );
+      taucs_index inc = max( (taucs_index) floor(1.25 * (double)Lnnz) , max( 8192, s->length ) );
       
       Lnnz += inc;
 
@@ -328,7 +336,7 @@ taucs_dtl(ccs_factor_llt)(taucs_ccs_matrix* A,double droptol, int modified)
       if (!rowind) {
 	taucs_free(dropped);
 	spa_free(s);
-	rowlist_free();
+	rowlist_free(r);
 	taucs_ccs_free(L);
 	return NULL;
       }
@@ -338,7 +346,7 @@ taucs_dtl(ccs_factor_llt)(taucs_ccs_matrix* A,double droptol, int modified)
       if (!values) {
 	taucs_free(dropped);
 	spa_free(s);
-	rowlist_free();
+	rowlist_free(r);
 	taucs_ccs_free(L);
 	return NULL;
       }
@@ -356,7 +364,7 @@ taucs_dtl(ccs_factor_llt)(taucs_ccs_matrix* A,double droptol, int modified)
     }
     norm = sqrt(norm);
 
-    Aj_nnz = (A->colptr)[j+1] - (A->colptr)[j];
+    Aj_nnz = (int) ((A->colptr)[j+1] - (A->colptr)[j]);
 
     for (ip = 0; ip < s->length; ip++) {
       i = (s->indices)[ip];
@@ -411,10 +419,10 @@ taucs_dtl(ccs_factor_llt)(taucs_ccs_matrix* A,double droptol, int modified)
 	(L->rowind)[next] = i;
 	(L->taucs_values)[next] = v;
 	next++;
-	if (rowlist_add(i,j,v) == -1) {
+	if (rowlist_add(r,i,j,v) == -1) {
 	  taucs_free(dropped);
 	  spa_free(s);
-	  rowlist_free();
+	  rowlist_free(r);
 	  taucs_ccs_free(L);
 	  return NULL;
 	}
@@ -437,10 +445,10 @@ taucs_dtl(ccs_factor_llt)(taucs_ccs_matrix* A,double droptol, int modified)
 	(L->rowind)[next] = i;
 	(L->taucs_values)[next] = v;
 	next++;
-	if (rowlist_add(i,j,v) == -1) {
+	if (rowlist_add(r,i,j,v) == -1) {
 	  taucs_free(dropped);
 	  spa_free(s);
-	  rowlist_free();
+	  rowlist_free(r);
 	  taucs_ccs_free(L);
 	  return NULL;
 	}
@@ -458,11 +466,11 @@ taucs_dtl(ccs_factor_llt)(taucs_ccs_matrix* A,double droptol, int modified)
 
   (L->colptr)[n] = next;
   
-  rowlist_free();
+  rowlist_free(r);
   spa_free(s);
   taucs_free(dropped);
 
-  taucs_printf("taucs_ccs_factor_llt: done; nnz(L) = %d, flops=%.1le\n",(L->colptr)[n],flops);
+  taucs_printf("taucs_ccs_factor_llt: done; nnz(L) = %.0f, flops=%.1le\n",(double) (L->colptr)[n],flops);
 
   return L;
 }
@@ -480,9 +488,11 @@ taucs_ccs_matrix*
 taucs_dtl(ccs_factor_llt_partial)(taucs_ccs_matrix* A, 
    			          int p)
 {
-  int            i,j,k,l,n,ip,next,Lnnz;
+  int            i,j,k,n,ip;
+  taucs_index    l,next,Lnnz;
   taucs_datatype Lkj,pivot,v;
   spa*           s;
+  rowlist*       r;
   taucs_ccs_matrix* L;
   int Aj_nnz;
   double flops = 0.0;
@@ -510,23 +520,23 @@ taucs_dtl(ccs_factor_llt_partial)(taucs_ccs_matrix* A,
   next = 0;
 
   s = spa_create(n);
-  i = rowlist_create(n);
+  r = rowlist_create(n);
 
-  if (!s || i == -1) {
+  if (!s || !r) {
     taucs_ccs_free(L);
     spa_free(s);
-    rowlist_free();
+    rowlist_free(r);
     return NULL;
   }
 
   for (j=0; j<p; j++) {
     spa_set(s,A,j);
 
-    for (l = rowlist_getfirst(j); 
+    for (l = rowlist_getfirst(r,j); 
 	 l != -1; 
-	 l = rowlist_getnext(l)) {
-      k   = rowlist_getcolind(l);
-      Lkj = rowlist_getvalue(l);
+	 l = rowlist_getnext(r,l)) {
+      k   = rowlist_getcolind(r,l);
+      Lkj = rowlist_getvalue(r,l);
       spa_scale_add(s,j,L,k,taucs_neg(Lkj)); /*  L_*j -= L_kj * L_*k  */
     }
 
@@ -535,7 +545,7 @@ taucs_dtl(ccs_factor_llt_partial)(taucs_ccs_matrix* A,
     if ( next+(s->length) > Lnnz ) {
       int*    rowind;
       taucs_datatype* values;
-      int inc = max( (int) floor(1.25 * (double)Lnnz) , max( 8192, s->length ) );
+      taucs_index inc = max( (taucs_index) floor(1.25 * (double)Lnnz) , max( 8192, s->length ) );
       /*int inc = max( 8192, s->length );*/
       
       Lnnz += inc;
@@ -543,7 +553,7 @@ taucs_dtl(ccs_factor_llt_partial)(taucs_ccs_matrix* A,
       rowind = (int*) taucs_realloc( L->rowind, Lnnz * sizeof(int) );
       if (!rowind) {
 	spa_free(s);
-	rowlist_free();
+	rowlist_free(r);
 	taucs_ccs_free(L);
 	return NULL;
       }
@@ -552,7 +562,7 @@ taucs_dtl(ccs_factor_llt_partial)(taucs_ccs_matrix* A,
       values = (taucs_datatype*) taucs_realloc( L->taucs_values, Lnnz * sizeof(taucs_datatype) );
       if (!values) {
 	spa_free(s);
-	rowlist_free();
+	rowlist_free(r);
 	taucs_ccs_free(L);
 	return NULL;
       }
@@ -569,7 +579,7 @@ taucs_dtl(ccs_factor_llt_partial)(taucs_ccs_matrix* A,
 
     (L->colptr)[j] = next;
 
-    Aj_nnz = (A->colptr)[j+1] - (A->colptr)[j]; 
+    Aj_nnz = (int) ((A->colptr)[j+1] - (A->colptr)[j]); 
 
     pivot = taucs_sqrt( (s->values)[j] );
 
@@ -591,7 +601,7 @@ taucs_dtl(ccs_factor_llt_partial)(taucs_ccs_matrix* A,
 	(L->rowind)[next] = i;
 	(L->taucs_values)[next] = v;
 	next++;
-	rowlist_add(i,j,v);
+	rowlist_add(r,i,j,v);
 	break;
       }
     }
@@ -608,7 +618,7 @@ taucs_dtl(ccs_factor_llt_partial)(taucs_ccs_matrix* A,
       (L->rowind)[next] = i;
       (L->taucs_values)[next] = v;
       next++;
-      rowlist_add(i,j,v);
+      rowlist_add(r,i,j,v);
     }
 
     (L->colptr)[j+1] = next;
@@ -623,11 +633,11 @@ taucs_dtl(ccs_factor_llt_partial)(taucs_ccs_matrix* A,
     spa_set(s,A,j);
 
     /* we only apply updates from columns 0..p-1 */
-    for (l = rowlist_getfirst(j); 
+    for (l = rowlist_getfirst(r,j); 
 	 l != -1; 
-	 l = rowlist_getnext(l)) {
-      k   = rowlist_getcolind(l);
-      Lkj = rowlist_getvalue(l);
+	 l = rowlist_getnext(r,l)) {
+      k   = rowlist_getcolind(r,l);
+      Lkj = rowlist_getvalue(r,l);
       if (k >= p) continue; 
       spa_scale_add(s,j,L,k,taucs_neg(Lkj)); /*  L_*j -= L_kj * L_*k  */
     }
@@ -637,7 +647,7 @@ taucs_dtl(ccs_factor_llt_partial)(taucs_ccs_matrix* A,
     if ( next+(s->length) > Lnnz ) {
       int*    rowind;
       taucs_datatype* values;
-      int inc = max( (int) floor(1.25 * (double)Lnnz) , max( 8192, s->length ) );
+      taucs_index inc = max( (taucs_index) floor(1.25 * (double)Lnnz) , max( 8192, s->length ) );
       /*int inc = max( 8192, s->length );*/
       
       Lnnz += inc;
@@ -645,7 +655,7 @@ taucs_dtl(ccs_factor_llt_partial)(taucs_ccs_matrix* A,
       rowind = (int*) taucs_realloc( L->rowind, Lnnz * sizeof(int) );
       if (!rowind) {
 	spa_free(s);
-	rowlist_free();
+	rowlist_free(r);
 	taucs_ccs_free(L);
 	return NULL;
       }
@@ -654,7 +664,7 @@ taucs_dtl(ccs_factor_llt_partial)(taucs_ccs_matrix* A,
       values = (taucs_datatype*) taucs_realloc( L->taucs_values, Lnnz * sizeof(taucs_datatype) );
       if (!values) {
 	spa_free(s);
-	rowlist_free();
+	rowlist_free(r);
 	taucs_ccs_free(L);
 	return NULL;
       }
@@ -671,7 +681,7 @@ taucs_dtl(ccs_factor_llt_partial)(taucs_ccs_matrix* A,
 
     (L->colptr)[j] = next;
 
-    Aj_nnz = (A->colptr)[j+1] - (A->colptr)[j]; 
+    Aj_nnz = (int) ((A->colptr)[j+1] - (A->colptr)[j]); 
 
     /* we want Lii to be first in the compressed column */
     for (ip = 0; ip < s->length; ip++) {
@@ -682,7 +692,7 @@ taucs_dtl(ccs_factor_llt_partial)(taucs_ccs_matrix* A,
 	(L->rowind)[next] = i;
 	(L->taucs_values)[next] = v;
 	next++;
-	rowlist_add(i,j,v);
+	rowlist_add(r,i,j,v);
 	break;
       }
     }
@@ -695,7 +705,7 @@ taucs_dtl(ccs_factor_llt_partial)(taucs_ccs_matrix* A,
       (L->rowind)[next] = i;
       (L->taucs_values)[next] = v;
       next++;
-      rowlist_add(i,j,v);
+      rowlist_add(r,i,j,v);
     }
 
     (L->colptr)[j+1] = next;
@@ -709,10 +719,10 @@ taucs_dtl(ccs_factor_llt_partial)(taucs_ccs_matrix* A,
 
   (L->colptr)[n] = next;
   
-  rowlist_free();
+  rowlist_free(r);
   spa_free(s);
 
-  taucs_printf("taucs_ccs_factor_llt_partial: done; nnz(L) = %d, flops=%.1le\n",(L->colptr)[n],flops);
+  taucs_printf("taucs_ccs_factor_llt_partial: done; nnz(L) = %.0f, flops=%.1le\n",(double) (L->colptr)[n],flops);
 
   return L;
 }
@@ -726,9 +736,11 @@ taucs_dtl(ccs_factor_llt_partial)(taucs_ccs_matrix* A,
 taucs_ccs_matrix* 
 taucs_dtl(ccs_factor_ldlt)(taucs_ccs_matrix* A)
 {
-  int            i,j,k,l,n,ip,next,Lnnz;
+  int            i,j,k,n,ip;
+  taucs_index    l,next,Lnnz;
   taucs_datatype Lkj,pivot,v,Dkk;
   spa*           s;
+  rowlist*       r;
   taucs_ccs_matrix* L;
   int Aj_nnz;
   double flops = 0.0;
@@ -747,23 +759,23 @@ taucs_dtl(ccs_factor_ldlt)(taucs_ccs_matrix* A)
   next = 0;
 
   s = spa_create(n);
-  i = rowlist_create(n);
+  r = rowlist_create(n);
 
-  if (!s || i == -1) {
+  if (!s || !r) {
     taucs_ccs_free(L);
     spa_free(s);
-    rowlist_free();
+    rowlist_free(r);
     return NULL;
   }
 
   for (j=0; j<n; j++) {
     spa_set(s,A,j);
 
-    for (l = rowlist_getfirst(j); 
+    for (l = rowlist_getfirst(r,j); 
 	 l != -1; 
-	 l = rowlist_getnext(l)) {
-      k   = rowlist_getcolind(l);
-      Lkj = rowlist_getvalue(l);
+	 l = rowlist_getnext(r,l)) {
+      k   = rowlist_getcolind(r,l);
+      Lkj = rowlist_getvalue(r,l);
       Dkk = (L->taucs_values)[ (L->colptr)[k] ];
       /*spa_scale_add(s,j,L,k,-Lkj*Dkk);*/ /* L_*j -= L_kj * L_*k */
       /*spa_scale_add(s,j,L,k,taucs_mul(taucs_neg(Lkj,Dkk));*/ /* L_*j -= L_kj * L_*k */
@@ -776,7 +788,7 @@ taucs_dtl(ccs_factor_ldlt)(taucs_ccs_matrix* A)
     if ( next+(s->length) > Lnnz ) {
       int*    rowind;
       taucs_datatype* values;
-      int inc = max( (int) floor(1.25 * (double)Lnnz) , max( 8192, s->length ) );
+      taucs_index inc = max( (taucs_index) floor(1.25 * (double)Lnnz) , max( 8192, s->length ) );
       /*int inc = max( 8192, s->length );*/
       
       Lnnz += inc;
@@ -784,7 +796,7 @@ taucs_dtl(ccs_factor_ldlt)(taucs_ccs_matrix* A)
       rowind = (int*) taucs_realloc( L->rowind, Lnnz * sizeof(int) );
       if (!rowind) {
 	spa_free(s);
-	rowlist_free();
+	rowlist_free(r);
 	taucs_ccs_free(L);
 	return NULL;
       }
@@ -793,7 +805,7 @@ taucs_dtl(ccs_factor_ldlt)(taucs_ccs_matrix* A)
       values = (taucs_datatype*) taucs_realloc( L->taucs_values, Lnnz * sizeof(taucs_datatype) );
       if (!values) {
 	spa_free(s);
-	rowlist_free();
+	rowlist_free(r);
 	taucs_ccs_free(L);
 	return NULL;
       }
@@ -810,7 +822,7 @@ taucs_dtl(ccs_factor_ldlt)(taucs_ccs_matrix* A)
 
     (L->colptr)[j] = next;
 
-    Aj_nnz = (A->colptr)[j+1] - (A->colptr)[j]; 
+    Aj_nnz = (int) ((A->colptr)[j+1] - (A->colptr)[j]); 
 
     pivot = (s->values)[j]; 
 
@@ -847,9 +859,9 @@ taucs_dtl(ccs_factor_ldlt)(taucs_ccs_matrix* A)
 	(L->rowind)[next] = i;
 	(L->taucs_values)[next] = pivot; /* we put D on the diagonal */
 	next++;
-	if (rowlist_add(i,j,v) == -1) {
+	if (rowlist_add(r,i,j,v) == -1) {
 	  spa_free(s);
-	  rowlist_free();
+	  rowlist_free(r);
 	  taucs_ccs_free(L);
 	  return NULL;
 	}
@@ -869,9 +881,9 @@ taucs_dtl(ccs_factor_ldlt)(taucs_ccs_matrix* A)
       (L->rowind)[next] = i;
       (L->taucs_values)[next] = v;
       next++;
-      if (rowlist_add(i,j,v) == -1) {
+      if (rowlist_add(r,i,j,v) == -1) {
 	spa_free(s);
-	rowlist_free();
+	rowlist_free(r);
 	taucs_ccs_free(L);
 	return NULL;
       }
@@ -888,7 +900,7 @@ taucs_dtl(ccs_factor_ldlt)(taucs_ccs_matrix* A)
 
   (L->colptr)[n] = next;
   
-  rowlist_free();
+  rowlist_free(r);
   spa_free(s);
 
   taucs_printf("taucs_ccs_factor_ldlt: done; nnz(L) = %.2le, flops=%.2le\n",
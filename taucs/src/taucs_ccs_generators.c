@@ -45,7 +45,7 @@ taucs_ccs_matrix* taucs_ccs_generate_mesh2d_negative(int n)
 
   m->n      = N;
   m->flags  = TAUCS_SYMMETRIC | TAUCS_LOWER | TAUCS_DOUBLE;
-  m->colptr = (int*)    taucs_malloc((N+1) * sizeof(int));
+  m->colptr = (taucs_index*) taucs_malloc((N+1) * sizeof(taucs_index));
   m->rowind = (int*)    taucs_malloc(nnz       * sizeof(int));
   m->values.d/*taucs_values*/ = (double*) taucs_malloc(nnz       * sizeof(double));
 
@@ -109,7 +109,7 @@ taucs_ccs_generate_mesh2d(int n,char *which)
   m->n      = N;
   m->m      = N;
   m->flags  = TAUCS_SYMMETRIC | TAUCS_LOWER | TAUCS_DOUBLE;
-  m->colptr = (int*)    taucs_malloc((N+1) * sizeof(int));
+  m->colptr = (taucs_index*) taucs_malloc((N+1) * sizeof(taucs_index));
   m->rowind = (int*)    taucs_malloc(nnz       * sizeof(int));
   m->values.d/*taucs_values*/ = (double*) taucs_malloc(nnz       * sizeof(double));
 
@@ -219,7 +219,7 @@ taucs_ccs_generate_mesh3d_random(int X, int Y, int Z,int brand)
   m->m      = N;
   m->flags  = TAUCS_SYMMETRIC | TAUCS_LOWER | TAUCS_DOUBLE;
   /*m->indshift = 0;*/
-  m->colptr = (int*)    taucs_malloc((N+1) * sizeof(int));
+  m->colptr = (taucs_index*) taucs_malloc((N+1) * sizeof(taucs_index));
   m->rowind = (int*)    taucs_malloc(nnz       * sizeof(int));
   m->values.d/*taucs_values*/ = (double*) taucs_malloc(nnz       * sizeof(double));
 
@@ -313,7 +313,7 @@ taucs_ccs_generate_dense(int M, int N, int flags)
     m->flags  =  TAUCS_DOUBLE;
   }
 
-  m->colptr = (int*)    taucs_malloc((N+1) * sizeof(int));
+  m->colptr = (taucs_index*) taucs_malloc((N+1) * sizeof(taucs_index));
   m->rowind = (int*)    taucs_malloc(nnz       * sizeof(int));
   m->values.d/*taucs_values*/ = (double*) taucs_malloc(nnz       * sizeof(double));
 
@@ -370,8 +370,9 @@ taucs_ccs_generate_rrn(int X, int Y, int Z, double drop_probability, double rmin
   taucs_ccs_matrix* m;
   taucs_ccs_matrix* l;
   int         N;
-  int         nnz;
-  int         x,y,z,i,j,k,ip,jp;
+  taucs_index nnz;
+  int         x,y,z,i,j,jp;
+  taucs_index k,ip;
   double*     D; /* contributions to future diagonal elements */
 
   int**       neighbors;
@@ -411,14 +412,14 @@ taucs_ccs_generate_rrn(int X, int Y, int Z, double drop_probability, double rmin
   m->m      = N;
   m->flags  = TAUCS_SYMMETRIC | TAUCS_LOWER | TAUCS_DOUBLE;
   /*m->indshift = 0;*/
-  m->colptr = (int*)    taucs_malloc((N+1) * sizeof(int));
+  m->colptr = (taucs_index*) taucs_malloc((N+1) * sizeof(taucs_index));
   m->rowind = (int*)    taucs_malloc(nnz       * sizeof(int));
   m->values.d/*taucs_values*/ = (double*) taucs_malloc(nnz       * sizeof(double));
 
   D         = (double*) taucs_malloc(N         * sizeof(double));
 
   if (!(m->colptr) || !(m->rowind) || !(m->rowind) || !D) {
-    taucs_printf("taucs_ccs_generate_rrn: out of memory: ncols=%d nnz=%d\n",N,nnz);
+    taucs_printf("taucs_ccs_generate_rrn: out of memory: ncols=%d nnz=%.0f\n",N,(double) nnz);
     taucs_free(m->colptr); taucs_free(m->rowind); taucs_free(m->values.d/*taucs_values*/); taucs_free(D);
     return NULL; 
   }
@@ -430,7 +431,7 @@ taucs_ccs_generate_rrn(int X, int Y, int Z, double drop_probability, double rmin
     for (y=0; y<Y; y++) {
       for (x=0; x<X; x++) {
 	int j, je, jw, js, jn, ju, jd; /* indices for up, down, east, west, south, north */
-	int jp; /* pointer to the diagonal value */
+	taucs_index jp; /* pointer to the diagonal value */
 	double v;
 
 	j  = z*X*Y + y*X + x;
@@ -561,8 +562,8 @@ taucs_ccs_generate_rrn(int X, int Y, int Z, double drop_probability, double rmin
   taucs_free(D);
   (m->colptr)[N] = ip;
 
-  taucs_printf("taucs_ccs_generate_rrn: done, ncols=%d allocated nnz=%d real nnz=%d\n",
-	       N,nnz,ip);
+  taucs_printf("taucs_ccs_generate_rrn: done, ncols=%d allocated nnz=%.0f real nnz=%.0f\n",
+	       N,(double) nnz,(double) ip);
 
 
   neighbors = (int**) taucs_malloc(N * sizeof(int*));
@@ -652,13 +653,13 @@ taucs_ccs_generate_rrn(int X, int Y, int Z, double drop_probability, double rmin
   l->n      = largest;
   l->m      = largest;
   l->flags  = TAUCS_SYMMETRIC | TAUCS_LOWER | TAUCS_DOUBLE;
-  l->colptr = (int*)    taucs_malloc((largest+1) * sizeof(int));
+  l->colptr = (taucs_index*) taucs_malloc((largest+1) * sizeof(taucs_index));
   l->rowind = (int*)    taucs_malloc(nnz       * sizeof(int));
   l->values.d/*taucs_values*/ = (double*) taucs_malloc(nnz       * sizeof(double));
 
   k = 0;
   for (jp=0; jp<N; jp++) {
-    int iip;
+    taucs_index iip;
     j = degree[jp];
     if (j == -1) continue;
     assert(j < largest);
@@ -749,7 +750,7 @@ taucs_ccs_generate_discontinuous(int X, int Y, int Z, double jump)
   m->m      = N;
   m->flags  = TAUCS_SYMMETRIC | TAUCS_LOWER | TAUCS_DOUBLE;
   /*m->indshift = 0;*/
-  m->colptr = (int*)    taucs_malloc((N+1) * sizeof(int));
+  m->colptr = (taucs_index*) taucs_malloc((N+1) * sizeof(taucs_index));
   m->rowind = (int*)    taucs_malloc(nnz       * sizeof(int));
   m->values.d/*taucs_values*/ = (double*) taucs_malloc(nnz       * sizeof(double));
 
@@ -30,6 +30,50 @@
 /* read binary                                           */
 /*********************************************************/
 
+/* 
+   colptr is stored as int, or as taucs_int64 when the file's
+   flags have TAUCS_BINARY_INDEX64; either can be read into
+   either width of taucs_index if the values fit
+*/
+
+static int
+binary_read_colptr(int f, int flags, int n, taucs_index* colptr)
+{
+  taucs_int64* wide;
+  int*         narrow;
+  int          j;
+  size_t       width = (flags & TAUCS_BINARY_INDEX64) ? sizeof(taucs_int64) : sizeof(int);
+
+  if (width == sizeof(taucs_index))
+    return read(f,colptr,(n+1)*width) != (ssize_t) ((n+1)*width);
+
+  if (flags & TAUCS_BINARY_INDEX64) {
+    wide = (taucs_int64*) taucs_malloc((n+1)*width);
+    if (!wide || read(f,wide,(n+1)*width) != (ssize_t) ((n+1)*width)) {
+      taucs_free(wide);
+      return -1;
+    }
+    if (wide[n] > (taucs_int64) TAUCS_INDEX_MAX) {
+      taucs_printf("taucs_ccs_read_binary: %.0f nonzeros do not fit in taucs_index\n",
+		   (double) wide[n]);
+      taucs_free(wide);
+      return -1;
+    }
+    for (j=0; j<=n; j++) colptr[j] = (taucs_index) wide[j];
+    taucs_free(wide);
+  } else {
+    narrow = (int*) taucs_malloc((n+1)*width);
+    if (!narrow || read(f,narrow,(n+1)*width) != (ssize_t) ((n+1)*width)) {
+      taucs_free(narrow);
+      return -1;
+    }
+    for (j=0; j<=n; j++) colptr[j] = narrow[j];
+    taucs_free(narrow);
+  }
+
+  return 0;
+}
+
 taucs_ccs_matrix* 
 taucs_ccs_read_binary(char* filename)
 {
@@ -37,7 +81,7 @@ taucs_ccs_read_binary(char* filename)
   int  nrows,ncols,flags,j;/*nnz, omer*/
   int     f;
   ssize_t bytes_read;
-  int*    colptr;
+  taucs_index* colptr;
 
   taucs_printf("taucs_ccs_binary: reading binary matrix %s\n",filename);
   
@@ -55,15 +99,21 @@ taucs_ccs_read_binary(char* filename)
   taucs_printf("\t%d-by-%d, flags = %08x\n",nrows,ncols,flags);
   taucs_printf("\t%d-by-%d, flags = %d  \n",nrows,ncols,flags);
 
-  colptr = (int*) taucs_malloc((ncols+1) * sizeof(int));
+  colptr = (taucs_index*) taucs_malloc((ncols+1) * sizeof(taucs_index));
   assert(colptr);
   
-  bytes_read = read(f,colptr,(ncols+1)*sizeof(int));
+  if (binary_read_colptr(f,flags,ncols,colptr)) {
+    taucs_printf("taucs_ccs_read_binary: could not read colptr\n");
+    taucs_free(colptr);
+    close(f);
+    return NULL;
+  }
+  flags &= ~TAUCS_BINARY_INDEX64;
 
   taucs_printf("colptr = [");
   for(j=0; j<min(ncols-1,10); j++)
-    taucs_printf("%d,",colptr[j]);
-  taucs_printf("...,%d]\n",colptr[ncols]);
+    taucs_printf("%.0f,",(double) colptr[j]);
+  taucs_printf("...,%.0f]\n",(double) colptr[ncols]);
 
 	if ( 0 ) /* we need this so that we have 'else if' in each type */
 	{}
@@ -126,6 +176,7 @@ void taucs_ccs_write_binary(taucs_ccs_matrix *A, char* filename)
 {
   int datatype_size;
   int     f;
+  int     flags;
   ssize_t bytes_wrote;
 
   taucs_printf("taucs_ccs_binary: writing binary matrix %s\n",filename);
@@ -138,10 +189,15 @@ void taucs_ccs_write_binary(taucs_ccs_matrix *A, char* filename)
   f = open(filename,O_WRONLY | O_CREAT | O_TRUNC, S_IRWXO | S_IRWXG | S_IRWXU);
 #endif
 
+  flags = A->flags;
+#ifdef TAUCS_CONFIG_INDEX64
+  flags |= TAUCS_BINARY_INDEX64;
+#endif
+
   bytes_wrote = write(f, &A->m, sizeof(int));
   bytes_wrote = write(f, &A->n, sizeof(int));
-  bytes_wrote = write(f, &A->flags,sizeof(int)); 
-  bytes_wrote = write(f, A->colptr, (A->n + 1) * sizeof(int));
+  bytes_wrote = write(f, &flags,sizeof(int)); 
+  bytes_wrote = write(f, A->colptr, (A->n + 1) * sizeof(taucs_index));
   bytes_wrote = write(f, A->rowind, A->colptr[A->n] * sizeof(int));
 
   datatype_size = 0;
@@ -172,6 +228,7 @@ taucs_ccs_read_hb(char* filename,int flags)
 {
   taucs_ccs_matrix* A = NULL;
   int  nrows,ncols,nnz,j;
+  int* colptr; /* the Fortran readers fill int column pointers */
   char fname[256];
   char type[3];
   
@@ -182,46 +239,49 @@ taucs_ccs_read_hb(char* filename,int flags)
 
   ireadhb_(fname,type,&nrows,&ncols,&nnz);
 
+  colptr = (int*) taucs_malloc((ncols+1) * sizeof(int));
+  if (!colptr) return NULL;
+
   if (type[0] == 'p' || type[0] == 'P') {
 
 		if ( 0 ); /* we need this so that we have 'else if' in each type */
 #ifdef TAUCS_DOUBLE_IN_BUILD
 		else if (flags & TAUCS_DOUBLE) {
       A = taucs_dccs_create(nrows,ncols,nnz);
-      if (!A) return NULL;
+      if (!A) { taucs_free(colptr); return NULL; }
       dreadhb_(fname,&nrows,&ncols,&nnz,
 	       /*A->colptr,A->rowind,A->values); omer*/
-				 A->colptr,A->rowind,A->values.d/*taucs_values*/);
+				 colptr,A->rowind,A->values.d/*taucs_values*/);
     }
 #endif
 
 #ifdef TAUCS_SINGLE_IN_BUILD
 		else if (flags & TAUCS_SINGLE) {
       A = taucs_sccs_create(nrows,ncols,nnz);
-      if (!A) return NULL;
+      if (!A) { taucs_free(colptr); return NULL; }
       sreadhb_(fname,&nrows,&ncols,&nnz,
 	       /*A->colptr,A->rowind,A->values); omer*/
-				 A->colptr,A->rowind,A->values.s/*taucs_values*/);
+				 colptr,A->rowind,A->values.s/*taucs_values*/);
     }
 #endif
 
 #ifdef TAUCS_DCOMPLEX_IN_BUILD
 		else if (flags & TAUCS_DCOMPLEX) {
       A = taucs_zccs_create(nrows,ncols,nnz);
-      if (!A) return NULL;
+      if (!A) { taucs_free(colptr); return NULL; }
       zreadhb_(fname,&nrows,&ncols,&nnz,
 	       /*A->colptr,A->rowind,A->values); omer*/
-				 A->colptr,A->rowind,A->values.z/*taucs_values*/);
+				 colptr,A->rowind,A->values.z/*taucs_values*/);
     }
 #endif
 
 #ifdef TAUCS_SCOMPLEX_IN_BUILD
 		else if (flags & TAUCS_SCOMPLEX) {
       A = taucs_cccs_create(nrows,ncols,nnz);
-      if (!A) return NULL;
+      if (!A) { taucs_free(colptr); return NULL; }
       creadhb_(fname,&nrows,&ncols,&nnz,
 	       /*A->colptr,A->rowind,A->values); omer*/
-				 A->colptr,A->rowind,A->values.c/*taucs_values*/);
+				 colptr,A->rowind,A->values.c/*taucs_values*/);
     }
 #endif
     else {
@@ -234,20 +294,20 @@ taucs_ccs_read_hb(char* filename,int flags)
 #ifdef TAUCS_DOUBLE_IN_BUILD
 		else if (flags & TAUCS_DOUBLE) {
       A = taucs_dccs_create(nrows,ncols,nnz);
-      if (!A) return NULL;
+      if (!A) { taucs_free(colptr); return NULL; }
       dreadhb_(fname,&nrows,&ncols,&nnz,
 	       /*A->colptr,A->rowind,A->values); omer*/
-				 A->colptr,A->rowind,A->values.d/*taucs_values*/);
+				 colptr,A->rowind,A->values.d/*taucs_values*/);
     }
 #endif
 
 #ifdef TAUCS_SINGLE_IN_BUILD
 		else if (flags & TAUCS_SINGLE) {
       A = taucs_sccs_create(nrows,ncols,nnz);
-      if (!A) return NULL;
+      if (!A) { taucs_free(colptr); return NULL; }
       sreadhb_(fname,&nrows,&ncols,&nnz,
 	       /*A->colptr,A->rowind,A->values); omer*/
-				 A->colptr,A->rowind,A->values.s/*taucs_values*/);
+				 colptr,A->rowind,A->values.s/*taucs_values*/);
     }
 #endif
 
@@ -255,10 +315,10 @@ taucs_ccs_read_hb(char* filename,int flags)
 		else if (flags & TAUCS_DCOMPLEX) {
       taucs_printf("taucs_ccs_read_hb: warning: requested a complex type, matrix is real\n");
       A = taucs_dccs_create(nrows,ncols,nnz);
-      if (!A) return NULL;
+      if (!A) { taucs_free(colptr); return NULL; }
       dreadhb_(fname,&nrows,&ncols,&nnz,
 	       /*A->colptr,A->rowind,A->values); omer*/
-				 A->colptr,A->rowind,A->values.d/*taucs_values*/);
+				 colptr,A->rowind,A->values.d/*taucs_values*/);
     }
 #endif
 
@@ -266,10 +326,10 @@ taucs_ccs_read_hb(char* filename,int flags)
 		else if (flags & TAUCS_SCOMPLEX) {
       taucs_printf("taucs_ccs_read_hb: warning: requested a complex type, matrix is real\n");
       A = taucs_sccs_create(nrows,ncols,nnz);
-      if (!A) return NULL;
+      if (!A) { taucs_free(colptr); return NULL; }
       sreadhb_(fname,&nrows,&ncols,&nnz,
 	       /*A->colptr,A->rowind,A->values); omer*/
-				 A->colptr,A->rowind,A->values.s/*taucs_values*/);
+				 colptr,A->rowind,A->values.s/*taucs_values*/);
     }
 #endif
     else {
@@ -282,10 +342,10 @@ taucs_ccs_read_hb(char* filename,int flags)
 #ifdef TAUCS_DCOMPLEX_IN_BUILD
 		else if (flags & TAUCS_DCOMPLEX) {
       A = taucs_zccs_create(nrows,ncols,nnz);
-      if (!A) return NULL;
+      if (!A) { taucs_free(colptr); return NULL; }
       zreadhb_(fname,&nrows,&ncols,&nnz,
 	       /*A->colptr,A->rowind,A->values); omer*/
-				 A->colptr,A->rowind,A->values.z/*taucs_values*/);
+				 colptr,A->rowind,A->values.z/*taucs_values*/);
     }
 #endif
 
@@ -293,10 +353,10 @@ taucs_ccs_read_hb(char* filename,int flags)
 		else if (flags & TAUCS_SCOMPLEX) {
       taucs_printf("taucs_ccs_read_hb: warning: requested a complex type, matrix is real\n");
       A = taucs_cccs_create(nrows,ncols,nnz);
-      if (!A) return NULL;
+      if (!A) { taucs_free(colptr); return NULL; }
       creadhb_(fname,&nrows,&ncols,&nnz,
 	       /*A->colptr,A->rowind,A->values); omer*/
-				 A->colptr,A->rowind,A->values.c/*taucs_values*/);
+				 colptr,A->rowind,A->values.c/*taucs_values*/);
     }
 #endif
     else {
@@ -310,8 +370,9 @@ taucs_ccs_read_hb(char* filename,int flags)
     A->flags |= TAUCS_HERMITIAN | TAUCS_LOWER;
 
   /* make indices 0-based */
-  for (j=0; j<=ncols; j++) ((A->colptr)[j])--;
+  for (j=0; j<=ncols; j++) (A->colptr)[j] = colptr[j] - 1;
   for (j=0; j<nnz;    j++) ((A->rowind)[j])--;
+  taucs_free(colptr);
 
   taucs_printf("taucs_ccs_read_hb: done reading\n");
 
@@ -361,7 +422,8 @@ int
 taucs_dtl(ccs_write_ijv)(taucs_ccs_matrix* m, 
 			 char* ijvfilename)
 {
-  int i,ip,j,n;
+  int i,j,n;
+  taucs_index ip;
   taucs_datatype Aij;
   FILE* f;
 
@@ -488,12 +550,14 @@ taucs_dtl(ccs_read_ijv)(char* ijvfilename,int flags,int base)
 	is 0-based. we add base to the i's and j's found.*/
   FILE* f;
   taucs_ccs_matrix*  m;
-  int*    clen; 
+  taucs_index* clen; 
   int*    is; 
   int*    js;
   taucs_datatype* vs;
-  int ncols, nrows, nnz;
-  int i,j,k,n;
+  int ncols, nrows;
+  taucs_index nnz;
+  int i,j;
+  taucs_index k,n;
   double         di,dj;
   taucs_datatype dv;
 
@@ -518,8 +582,8 @@ taucs_dtl(ccs_read_ijv)(char* ijvfilename,int flags,int base)
   nrows = ncols = 0;
   while (!feof(f)) {
     if (nnz == n) {
-      n = (int) ( 1.25 * (double) n);
-      taucs_printf("taucs_ccs_read_ijv: allocating %d ijv's\n",n);
+      n = (taucs_index) ( 1.25 * (double) n);
+      taucs_printf("taucs_ccs_read_ijv: allocating %.0f ijv's\n",(double) n);
       is = (int*)    taucs_realloc(is,n*sizeof(int));
       js = (int*)    taucs_realloc(js,n*sizeof(int));
       vs = (taucs_datatype*) taucs_realloc(vs,n*sizeof(taucs_datatype));
@@ -594,12 +658,12 @@ taucs_dtl(ccs_read_ijv)(char* ijvfilename,int flags,int base)
   m->flags |= TAUCS_SCOMPLEX;
 #endif
 
-  clen      = (int*)    taucs_malloc((ncols+1) * sizeof(int));
-  m->colptr = (int*)    taucs_malloc((ncols+1) * sizeof(int));
+  clen      = (taucs_index*) taucs_malloc((ncols+1) * sizeof(taucs_index));
+  m->colptr = (taucs_index*) taucs_malloc((ncols+1) * sizeof(taucs_index));
   m->rowind = (int*)    taucs_malloc(nnz       * sizeof(int));
   m->taucs_values = (taucs_datatype*) taucs_malloc(nnz * sizeof(taucs_datatype));
   if (!clen || !(m->colptr) || !(m->rowind) || !(m->rowind)) {
-    taucs_printf("taucs_ccs_read_ijv: out of memory: ncols=%d nnz=%d\n",ncols,nnz);
+    taucs_printf("taucs_ccs_read_ijv: out of memory: ncols=%d nnz=%.0f\n",ncols,(double) nnz);
     taucs_free(clen); taucs_free(m->colptr); taucs_free(m->rowind); 
     taucs_free(m->taucs_values);
     taucs_free (m); taucs_free(is); taucs_free(js); taucs_free(vs); 
@@ -610,21 +674,21 @@ taucs_dtl(ccs_read_ijv)(char* ijvfilename,int flags,int base)
   for (k=0; k<nnz; k++) {
     i = is[k] - 1; /* make it 1-based */
     j = js[k] - 1; /* make it 1-based */
-		if ( j<0 || j>ncols ) taucs_printf("j=%d k=%d\n",j,k);
+		if ( j<0 || j>ncols ) taucs_printf("j=%d k=%.0f\n",j,(double) k);
     ( clen[j] )++;
   }
   /* just check */
   k = 0;
   for (j=0; j<ncols; j++) 
     k += clen[j];
-	if (k!=nnz) taucs_printf("k=%d, nnz=%d\n",k,nnz);
+	if (k!=nnz) taucs_printf("k=%.0f, nnz=%.0f\n",(double) k,(double) nnz);
   assert(k == nnz);
 
   /* now compute column pointers */
   
   k = 0;
   for (j=0; j<ncols; j++) {
-    int tmp;
+    taucs_index tmp;
     tmp =  clen[j];
     clen[j] = (m->colptr[j]) = k;
     k += tmp;
@@ -700,12 +764,14 @@ taucs_dtl(ccs_read_mtx)(char* filename,int flags)
 {
   FILE* f;
   taucs_ccs_matrix*  m;
-  int*    clen; 
+  taucs_index* clen; 
   int*    is; 
   int*    js;
   taucs_datatype* vs;
-  int ncols, nrows, nnz;
-  int i,j,k,n;
+  int ncols, nrows;
+  taucs_index nnz;
+  int i,j;
+  taucs_index k,n;
   double di,dj;
   taucs_datatype dv;
 
@@ -716,7 +782,8 @@ taucs_dtl(ccs_read_mtx)(char* filename,int flags)
     return NULL;
   }
 
-  if (fscanf(f, "%d %d %d", &nrows, &ncols, &nnz) != 3) {
+  /* the entries are counted again as they are read */
+  if (fscanf(f, "%d %d %lg", &nrows, &ncols, &di) != 3) {
     taucs_printf("taucs_ccs_read_mtx: wrong header\n");
     return NULL;
   }
@@ -735,8 +802,8 @@ taucs_dtl(ccs_read_mtx)(char* filename,int flags)
   nrows = ncols = 0;
   while (!feof(f)) {
     if (nnz == n) {
-      n = (int) ( 1.25 * (double) n);
-      taucs_printf("taucs_ccs_read_mtx: allocating %d ijv's\n",n);
+      n = (taucs_index) ( 1.25 * (double) n);
+      taucs_printf("taucs_ccs_read_mtx: allocating %.0f ijv's\n",(double) n);
       is = (int*)    taucs_realloc(is,n*sizeof(int));
       js = (int*)    taucs_realloc(js,n*sizeof(int));
       vs = (taucs_datatype*) taucs_realloc(vs,n*sizeof(taucs_datatype));
@@ -832,12 +899,12 @@ taucs_dtl(ccs_read_mtx)(char* filename,int flags)
   m->flags |= TAUCS_SCOMPLEX;
 #endif
 
-  clen      = (int*)    taucs_malloc((ncols+1) * sizeof(int));
-  m->colptr = (int*)    taucs_malloc((ncols+1) * sizeof(int));
+  clen      = (taucs_index*) taucs_malloc((ncols+1) * sizeof(taucs_index));
+  m->colptr = (taucs_index*) taucs_malloc((ncols+1) * sizeof(taucs_index));
   m->rowind = (int*)    taucs_malloc(nnz       * sizeof(int));
   m->taucs_values = (taucs_datatype*) taucs_malloc(nnz * sizeof(taucs_datatype));
   if (!clen || !(m->colptr) || !(m->rowind) || !(m->rowind)) {
-    taucs_printf("taucs_ccs_read_mtx: out of memory: ncols=%d nnz=%d\n",ncols,nnz);
+    taucs_printf("taucs_ccs_read_mtx: out of memory: ncols=%d nnz=%.0f\n",ncols,(double) nnz);
     taucs_free(clen); taucs_free(m->colptr); taucs_free(m->rowind); 
     taucs_free(m->taucs_values);
     taucs_free (m); taucs_free(is); taucs_free(js); taucs_free(vs); 
@@ -860,7 +927,7 @@ taucs_dtl(ccs_read_mtx)(char* filename,int flags)
   
   k = 0;
   for (j=0; j<ncols; j++) {
-    int tmp;
+    taucs_index tmp;
     tmp =  clen[j];
     clen[j] = (m->colptr[j]) = k;
     k += tmp;
@@ -948,7 +1015,9 @@ taucs_dtl(ccs_read_ccs)(char* filename,int flags)
   /* taucs_datatype dv;*/
   /* double         di,dj;*/
 
-  int i,ip,j,N,*pointers;
+  int i,j,N;
+  taucs_index ip,*pointers;
+  double p;
 
   f = fopen(filename ,"r");
 
@@ -959,42 +1028,43 @@ taucs_dtl(ccs_read_ccs)(char* filename,int flags)
 
   fscanf(f,"%d",&N);
 
-  pointers = (int*) taucs_malloc((N+1)*sizeof(int));
+  pointers = (taucs_index*) taucs_malloc((N+1)*sizeof(taucs_index));
   for(i=0; i<N+1; ++i) {
-    fscanf(f,"%d",&pointers[i]);
+    fscanf(f,"%lg",&p);
+    pointers[i] = (taucs_index) p;
   }
 
   m = taucs_dtl(ccs_create)(N, N, pointers[N]);
   for (i=0; i<=N; i++) (m->colptr)[i] = pointers[i];
 
-  for(i=0; i<pointers[N]; ++i)
-    fscanf(f,"%d",(m->rowind)+i);
+  for(ip=0; ip<pointers[N]; ++ip)
+    fscanf(f,"%d",(m->rowind)+ip);
 
 #ifdef TAUCS_CORE_DOUBLE  
-  for(i=0; i<pointers[N]; ++i)
-    fscanf(f,"%lg",(m->taucs_values)+i);
+  for(ip=0; ip<pointers[N]; ++ip)
+    fscanf(f,"%lg",(m->taucs_values)+ip);
 #endif
   
 #ifdef TAUCS_CORE_SINGLE  
-  for(i=0; i<pointers[N]; ++i)
-    fscanf(f,"%g",(m->taucs_values)+i);
+  for(ip=0; ip<pointers[N]; ++ip)
+    fscanf(f,"%g",(m->taucs_values)+ip);
 #endif
   
 #ifdef TAUCS_CORE_DCOMPLEX  
-  for(i=0; i<pointers[N]; ++i) {
+  for(ip=0; ip<pointers[N]; ++ip) {
     taucs_real_datatype dv_r;
     taucs_real_datatype dv_i;
     fscanf(f,"%lg+%lgi",&dv_r,&dv_i);
-    (m->taucs_values)[i] = taucs_complex_create(dv_r,dv_i);
+    (m->taucs_values)[ip] = taucs_complex_create(dv_r,dv_i);
   }
 #endif
   
 #ifdef TAUCS_CORE_SCOMPLEX
-  for(i=0; i<pointers[N]; ++i) {
+  for(ip=0; ip<pointers[N]; ++ip) {
     taucs_real_datatype dv_r;
     taucs_real_datatype dv_i;
     fscanf(f,"%g+%gi",&dv_r,&dv_i);
-    (m->taucs_values)[i] = taucs_complex_create(dv_r,dv_i);
+    (m->taucs_values)[ip] = taucs_complex_create(dv_r,dv_i);
   }
 #endif
   
@@ -1790,7 +1790,8 @@ leftlooking_supernodal_front_factor_ldlt(int sn,
   
   INFO = taucs_dtl(internal_supernodal_front_factor_ldlt)(fct,L->sn_blocks[sn],L->up_blocks[sn], 
 				      L->d_blocks[sn], L->db_size[sn],
-				      L->sn_size[sn], L->sn_up_size[sn] - L->sn_size[sn],sn,gl_factor_alg);
+				      L->sn_size[sn], L->sn_up_size[sn] - L->sn_size[sn],sn,gl_factor_alg,
+				      NULL /* default pivoting */);
   
   if (INFO) {
     taucs_printf("\t\tLDL^T Factorization: Matrix is singular.\n");
@@ -13,11 +13,21 @@
 /*                                                           */
 /*************************************************************/
 
+/* 64-bit off_t for the streamed matrix file */
+#ifndef OSTYPE_win32
+#define _FILE_OFFSET_BITS 64
+#define _LARGEFILE_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 
+#ifdef OSTYPE_win32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
-/*#include <unistd.h>*/
 /*#include <sys/uio.h>*/
 
 #include <assert.h>
@@ -28,6 +38,10 @@
 #include <errno.h>
 #include "taucs.h"
 
+#ifdef TAUCS_CONFIG_PFUNC
+#include "pfunc.h"
+#endif
+
 #define FALSE 0
 #define TRUE  1
 
@@ -264,6 +278,446 @@ void ooc_supernodal_factor_free(void* vL)
   taucs_free(L);
 }
 
+/*************************************************************/
+/* columns of a matrix in a binary file                      */
+/*************************************************************/
+
+/*
+  The streamed analysis and factorization never hold all of A.
+  The file, written by taucs_ccs_write_binary, holds m, n and
+  flags, then colptr, rowind and the values. Only colptr stays in
+  memory. The columns in use are read into a window, which is a
+  taucs_ccs_matrix whose colptr is indexed by global column
+  numbers. colptr[j] and colptr[j+1] are only meaningful for
+  columns j in the window, but the routines that walk A column by
+  column never look at other columns, so they use the window as
+  if it were A.
+
+  Columns are requested one column (analysis) or one supernode
+  (factorization) at a time, roughly in the postorder of the
+  elimination tree. On a miss the window is refilled with the
+  requested columns and the ones that follow them in postorder,
+  up to the budget.
+*/
+
+typedef struct {
+  int     f;
+  int     n;
+  taucs_index* colptr;  /* colptr of the matrix in the file          */
+  double  rowind_base;  /* file offsets of rowind and of the values  */
+  double  values_base;
+  int*    postorder;    /* read-ahead order; column order if NULL    */
+  int*    ipostorder;
+  int*    stamp;        /* stamp[j]==generation iff j is in window   */
+  int     generation;
+  int*    cols;         /* the columns in the window                 */
+  taucs_index capacity; /* entries allocated in the window           */
+  double  budget;       /* bytes for the window                      */
+  int     with_values;  /* the analysis needs only the structure     */
+  int     fills;        /* window refills, for the log               */
+  int     error;
+  taucs_ccs_matrix window;
+} ooc_ccs_stream;
+
+#define OOC_STREAM_CHUNK (1 << 30)
+
+static int ooc_stream_compare_ints(const void* vx, const void* vy)
+{
+  const int* ix = (const int*)vx;
+  const int* iy = (const int*)vy;
+  if (*ix < *iy) return -1;
+  if (*ix > *iy) return  1;
+  return 0;
+}
+
+static int
+ooc_stream_read(ooc_ccs_stream* s, double offset, void* data, double nbytes)
+{
+  double done = 0.0;
+  long   chunk,got;
+
+  if (lseek(s->f,(off_t) offset,SEEK_SET) == -1) return -1;
+  while (done < nbytes) {
+    chunk = (nbytes-done > OOC_STREAM_CHUNK) ? OOC_STREAM_CHUNK : (long) (nbytes-done);
+    got = (long) read(s->f,(char*)data+(size_t)done,chunk);
+    if (got == -1 && errno == EINTR) continue;
+    if (got <= 0) return -1;
+    done += (double) got;
+  }
+  return 0;
+}
+
+static void
+ooc_stream_close(ooc_ccs_stream* s)
+{
+  if (!s) return;
+  if (s->f != -1) close(s->f);
+  taucs_free(s->colptr);
+  taucs_free(s->postorder);
+  taucs_free(s->ipostorder);
+  taucs_free(s->stamp);
+  taucs_free(s->cols);
+  taucs_free(s->window.colptr);
+  taucs_free(s->window.rowind);
+  taucs_free(s->window.taucs_values);
+  taucs_free(s);
+}
+
+/* colptr is int or taucs_int64 in the file, as in taucs_ccs_read_binary */
+
+static int
+ooc_stream_read_colptr(ooc_ccs_stream* s, int flags)
+{
+  taucs_int64* wide;
+  int*         narrow;
+  int          j;
+  double       offset = 3.0*sizeof(int);
+  size_t       width  = (flags & TAUCS_BINARY_INDEX64) ? sizeof(taucs_int64) : sizeof(int);
+
+  if (width == sizeof(taucs_index))
+    return ooc_stream_read(s,offset,s->colptr,(double)(s->n+1)*width);
+
+  if (flags & TAUCS_BINARY_INDEX64) {
+    wide = (taucs_int64*) taucs_malloc((s->n+1)*width);
+    if (!wide || ooc_stream_read(s,offset,wide,(double)(s->n+1)*width)) {
+      taucs_free(wide);
+      return -1;
+    }
+    if (wide[s->n] > (taucs_int64) TAUCS_INDEX_MAX) {
+      taucs_printf("taucs_ooc_factor_llt_file: %.0f nonzeros do not fit in taucs_index\n",
+		   (double) wide[s->n]);
+      taucs_free(wide);
+      return -1;
+    }
+    for (j=0; j<=s->n; j++) s->colptr[j] = (taucs_index) wide[j];
+    taucs_free(wide);
+  } else {
+    narrow = (int*) taucs_malloc((s->n+1)*width);
+    if (!narrow || ooc_stream_read(s,offset,narrow,(double)(s->n+1)*width)) {
+      taucs_free(narrow);
+      return -1;
+    }
+    for (j=0; j<=s->n; j++) s->colptr[j] = narrow[j];
+    taucs_free(narrow);
+  }
+
+  return 0;
+}
+
+static ooc_ccs_stream*
+ooc_stream_open(char* filename, double budget)
+{
+  ooc_ccs_stream* s;
+  int header[3]; /* m, n, flags */
+
+  s = (ooc_ccs_stream*) taucs_calloc(1,sizeof(ooc_ccs_stream));
+  if (!s) return NULL;
+
+#ifdef OSTYPE_win32
+  s->f = open(filename,_O_RDONLY | _O_BINARY);
+#else
+  s->f = open(filename,O_RDONLY);
+#endif
+  if (s->f == -1) {
+    taucs_printf("taucs_ooc_factor_llt_file: could not open %s\n",filename);
+    taucs_free(s);
+    return NULL;
+  }
+
+  if (ooc_stream_read(s,0.0,header,3.0*sizeof(int))) {
+    taucs_printf("taucs_ooc_factor_llt_file: could not read the header of %s\n",filename);
+    ooc_stream_close(s);
+    return NULL;
+  }
+  if (header[0] != header[1]
+      || !(header[2] & TAUCS_CORE_DATATYPE)
+      || !(header[2] & (TAUCS_SYMMETRIC | TAUCS_HERMITIAN))
+      || !(header[2] & TAUCS_LOWER)) {
+    taucs_printf("taucs_ooc_factor_llt_file: %s is not a symmetric lower matrix of this type\n",
+		 filename);
+    ooc_stream_close(s);
+    return NULL;
+  }
+
+  s->n = header[1];
+  s->colptr = (taucs_index*) taucs_malloc((s->n+1)*sizeof(taucs_index));
+  s->stamp  = (int*) taucs_calloc(s->n,sizeof(int));
+  s->cols   = (int*) taucs_malloc(s->n*sizeof(int));
+  s->window.colptr = (taucs_index*) taucs_malloc((s->n+1)*sizeof(taucs_index));
+  if (!(s->colptr) || !(s->stamp) || !(s->cols) || !(s->window.colptr)) {
+    taucs_printf("taucs_ooc_factor_llt_file: out of memory\n");
+    ooc_stream_close(s);
+    return NULL;
+  }
+  if (ooc_stream_read_colptr(s,header[2])) {
+    taucs_printf("taucs_ooc_factor_llt_file: could not read colptr from %s\n",filename);
+    ooc_stream_close(s);
+    return NULL;
+  }
+
+  s->rowind_base = 3.0*sizeof(int) + (double)(s->n+1)
+                   * ((header[2] & TAUCS_BINARY_INDEX64) ? sizeof(taucs_int64) : sizeof(int));
+  s->values_base = s->rowind_base + (double)(s->colptr[s->n]) * sizeof(int);
+  s->budget      = min(budget,(double) OOC_STREAM_CHUNK); /* int entry counts */
+  s->generation  = 1; /* the stamps are 0: nothing is in the window */
+  s->window.m     = s->n;
+  s->window.n     = s->n;
+  s->window.flags = header[2];
+
+  return s;
+}
+
+/* drops all the columns, for example before values are needed */
+
+static void
+ooc_stream_invalidate(ooc_ccs_stream* s)
+{
+  s->generation++;
+}
+
+/* 
+   refills the window with need[0..nneed) and the columns that 
+   follow the last of them in the read-ahead order
+*/
+
+static int
+ooc_stream_fill(ooc_ccs_stream* s, int* need, int nneed)
+{
+  int    k,j,p,first,last,ncols;
+  taucs_index nnz,pos,len;
+  double entry_bytes = sizeof(int) + (s->with_values ? sizeof(taucs_datatype) : 0);
+  taucs_index* colptr = s->colptr;
+
+  s->generation++;
+  s->fills++;
+
+  nnz = 0; ncols = 0;
+  for (k=0; k<nneed; k++) {
+    j = need[k];
+    if (s->stamp[j] == s->generation) continue;
+    s->stamp[j] = s->generation;
+    s->cols[ncols++] = j;
+    nnz += colptr[j+1] - colptr[j];
+  }
+
+  p = s->postorder ? s->ipostorder[need[nneed-1]] : need[nneed-1];
+  for (p++; p < s->n; p++) {
+    j = s->postorder ? s->postorder[p] : p;
+    len = colptr[j+1] - colptr[j];
+    if ((double)(nnz+len) * entry_bytes > s->budget) break;
+    if (s->stamp[j] == s->generation) continue;
+    s->stamp[j] = s->generation;
+    s->cols[ncols++] = j;
+    nnz += len;
+  }
+
+  if (nnz > s->capacity) {
+    int*  rowind;
+    void* values;
+
+    taucs_free(s->window.rowind);
+    taucs_free(s->window.taucs_values);
+    s->window.taucs_values = NULL;
+    s->capacity = 0;
+    rowind = (int*) taucs_malloc(nnz*sizeof(int));
+    values = s->with_values ? taucs_malloc(nnz*sizeof(taucs_datatype)) : NULL;
+    s->window.rowind = rowind;
+    s->window.taucs_values = (taucs_datatype*) values;
+    if (!rowind || (s->with_values && !values)) {
+      taucs_printf("taucs_ooc_factor_llt_file: out of memory\n");
+      goto failed;
+    }
+    s->capacity = nnz;
+  }
+  if (s->with_values && !(s->window.taucs_values)) {
+    s->window.taucs_values = (taucs_datatype*) taucs_malloc(s->capacity*sizeof(taucs_datatype));
+    if (!(s->window.taucs_values)) {
+      taucs_printf("taucs_ooc_factor_llt_file: out of memory\n");
+      goto failed;
+    }
+  }
+
+  /* contiguous columns are laid out, and read, together */
+
+  qsort(s->cols,ncols,sizeof(int),ooc_stream_compare_ints);
+
+  pos = 0;
+  for (k=0; k<ncols; k++) {
+    first = last = s->cols[k];
+    while (k+1 < ncols && s->cols[k+1] == last+1) { k++; last++; }
+
+    len = colptr[last+1] - colptr[first];
+    if (ooc_stream_read(s,
+			s->rowind_base + (double)colptr[first]*sizeof(int),
+			s->window.rowind + pos,
+			(double)len*sizeof(int)))
+      goto failed;
+    if (s->with_values
+	&& ooc_stream_read(s,
+			   s->values_base + (double)colptr[first]*sizeof(taucs_datatype),
+			   s->window.taucs_values + pos,
+			   (double)len*sizeof(taucs_datatype)))
+      goto failed;
+
+    for (j=first; j<=last+1; j++) 
+      s->window.colptr[j] = pos + (colptr[j] - colptr[first]);
+    pos += len;
+  }
+
+  return 0;
+
+ failed:
+  taucs_printf("taucs_ooc_factor_llt_file: could not read columns of the matrix\n");
+  s->error = 1;
+  /* leave the requested columns empty so callers can unwind */
+  for (k=0; k<nneed; k++) {
+    s->window.colptr[need[k]]   = 0;
+    s->window.colptr[need[k]+1] = 0;
+  }
+  s->generation++;
+  for (k=0; k<nneed; k++) s->stamp[need[k]] = s->generation;
+  return -1;
+}
+
+static int
+ooc_stream_require(ooc_ccs_stream* s, int* need, int nneed)
+{
+  int k;
+
+  for (k=0; k<nneed; k++)
+    if (s->stamp[need[k]] != s->generation)
+      return ooc_stream_fill(s,need,nneed);
+  return 0;
+}
+
+/* union-find without recursion; the trees can be very deep */
+
+static int ooc_uf_find(int* uf, int i)
+{
+  int r,next;
+
+  for (r=i; uf[r] != r; r = uf[r]);
+  for (; uf[i] != r; i = next) {
+    next  = uf[i];
+    uf[i] = r;
+  }
+  return r;
+}
+
+/*
+  Liu's algorithm, as in taucs_ccs_etree, needs the rows of the 
+  strict lower triangle in order, but the file holds columns. One
+  pass counts the entries in every row. Then the rows are taken in
+  blocks whose entries fit in the budget, and each block is 
+  gathered by scanning the columns that can hold its entries. The
+  number of passes is about the size of rowind over the budget.
+*/
+
+static int
+ooc_stream_etree(ooc_ccs_stream* s, int* parent)
+{
+  int    n = s->n;
+  taucs_index* colptr = s->colptr;
+  taucs_index  len,e;
+  int    chunk,k,i,j,r0,r1,cnt,kp,u,t,vroot;
+  int*   buf      = NULL;
+  int*   colind   = NULL;
+  int*   rowcount = NULL;
+  int*   ptr      = NULL;
+  int*   uf       = NULL;
+  int*   realroot = NULL;
+  int    maxrow;
+  double passes = 1.0;
+
+  chunk = (int) min(s->budget / (2.0*sizeof(int)), (double) colptr[n]);
+  if (chunk < 1) chunk = 1;
+
+  rowcount = (int*) taucs_calloc(n+1,sizeof(int));
+  ptr      = (int*) taucs_malloc((n+1)*sizeof(int));
+  uf       = (int*) taucs_malloc(n*sizeof(int));
+  realroot = (int*) taucs_malloc(n*sizeof(int));
+  buf      = (int*) taucs_malloc(chunk*sizeof(int));
+  if (!rowcount || !ptr || !uf || !realroot || !buf) goto failed;
+
+  /* count the strictly lower entries of every row */
+
+  for (e=0, j=0; e<colptr[n]; e+=len) {
+    len = min((taucs_index) chunk,colptr[n]-e);
+    if (ooc_stream_read(s,s->rowind_base + (double)e*sizeof(int),buf,(double)len*sizeof(int)))
+      goto failed;
+    for (k=0; k<len; k++) {
+      while (colptr[j+1] <= e+k) j++;
+      if (buf[k] > j) rowcount[ buf[k] ]++;
+    }
+  }
+
+  maxrow = 0;
+  for (i=0; i<n; i++) maxrow = max(maxrow,rowcount[i]);
+  colind = (int*) taucs_malloc(max(max(chunk,maxrow),1)*sizeof(int));
+  if (!colind) goto failed;
+
+  for (r0=0; r0<n; r0=r1) {
+    cnt = 0;
+    for (r1=r0; r1<n && (r1==r0 || cnt+rowcount[r1] <= chunk); r1++) {
+      ptr[r1] = cnt;
+      cnt += rowcount[r1];
+    }
+
+    /* entries of rows r0..r1-1 lie in columns before r1-1 */
+    if (cnt > 0) {
+      passes += 1.0;
+      for (e=0, j=0; e<colptr[r1-1]; e+=len) {
+	len = min((taucs_index) chunk,colptr[r1-1]-e);
+	if (ooc_stream_read(s,s->rowind_base + (double)e*sizeof(int),buf,(double)len*sizeof(int)))
+	  goto failed;
+	for (k=0; k<len; k++) {
+	  while (colptr[j+1] <= e+k) j++;
+	  i = buf[k];
+	  if (i > j && i >= r0 && i < r1) colind[ ptr[i]++ ] = j;
+	}
+      }
+    }
+
+    for (i=r0; i<r1; i++) {
+      uf[i] = i;
+      realroot[i] = i;
+      parent[i] = n;
+      vroot = i;
+      for (kp=ptr[i]-rowcount[i]; kp<ptr[i]; kp++) {
+	u = ooc_uf_find(uf,colind[kp]);
+	t = realroot[u];
+	if (parent[t] == n && t != i) {
+	  parent[t] = i;
+	  vroot = ooc_uf_find(uf,vroot);
+	  uf[vroot] = u;
+	  vroot = u;
+	  realroot[vroot] = i;
+	}
+      }
+    }
+  }
+  taucs_printf("\t\tStreamed etree: %.0f passes over the row indices\n",passes);
+
+  taucs_free(colind);
+  taucs_free(buf);
+  taucs_free(realroot);
+  taucs_free(uf);
+  taucs_free(ptr);
+  taucs_free(rowcount);
+  return 0;
+
+ failed:
+  taucs_printf("taucs_ooc_factor_llt_file: etree failed (out of memory or read error)\n");
+  s->error = 1;
+  taucs_free(colind);
+  taucs_free(buf);
+  taucs_free(realroot);
+  taucs_free(uf);
+  taucs_free(ptr);
+  taucs_free(rowcount);
+  return -1;
+}
+
 static void
 recursive_symbolic_elimination(int            j,
 			       taucs_ccs_matrix* A,
@@ -282,10 +736,12 @@ recursive_symbolic_elimination(int            j,
 			       int            ipostorder[],
 			       double         given_mem,
 			       void           (*sn_struct_handler)(),
-			       void*          sn_struct_handler_arg
+			       void*          sn_struct_handler_arg,
+			       ooc_ccs_stream* stream
 			       )
 {
-  int  i,ip,c,c_sn;
+  int  i,c,c_sn;
+  taucs_index ip;
   int  in_previous_sn;
   int  nnz = 0; /* to supress a warning */
 
@@ -299,10 +755,14 @@ recursive_symbolic_elimination(int            j,
 				   column_to_sn_map,
 				   map,
 				   do_order,ipostorder,given_mem,
-				   sn_struct_handler,sn_struct_handler_arg
+				   sn_struct_handler,sn_struct_handler_arg,
+				   stream
 				   );
   }
 
+  /* A is the window of the stream; make sure column j is in it */
+  if (stream && j < A->n) 
+    ooc_stream_require(stream,&j,1);
   
   in_previous_sn = 1;
   if (j == A->n) 
@@ -449,14 +909,20 @@ void recursive_postorder(int  j,
   (*next)++;
 }
 
-static void
+/* 
+   with a stream, A is the stream's window and the analysis 
+   reads the columns from the file as it needs them 
+*/
+
+static int
 taucs_ccs_ooc_symbolic_elimination(taucs_ccs_matrix* A,
 				   void* vL,
 				   int do_order,
 				   int do_column_to_sn_map,
 				   double given_mem,
 				   void           (*sn_struct_handler)(),
-				   void*          sn_struct_handler_arg
+				   void*          sn_struct_handler_arg,
+				   ooc_ccs_stream* stream
 				   )
 {
   supernodal_factor_matrix* L = (supernodal_factor_matrix*) vL;
@@ -468,6 +934,7 @@ taucs_ccs_ooc_symbolic_elimination(taucs_ccs_matrix* A,
   int* rowind;
   int* parent;
   int* ipostorder;
+  int* postorder;
 
   L->n         = A->n;
   L->sn_struct = (int**)taucs_malloc((A->n  )*sizeof(int*));
@@ -488,7 +955,19 @@ taucs_ccs_ooc_symbolic_elimination(taucs_ccs_matrix* A,
 
   /* compute the vertex elimination tree */
   parent      = (int*)taucs_malloc((A->n+1)*sizeof(int));
-  taucs_ccs_etree(A,parent,NULL,NULL,NULL);
+  if (stream) {
+    if (ooc_stream_etree(stream,parent)) {
+      L->n_sn = 0;
+      taucs_free(parent);
+      taucs_free(rowind);
+      taucs_free(next_child);
+      taucs_free(first_child);
+      taucs_free(map);
+      taucs_free(column_to_sn_map);
+      return -1;
+    }
+  } else
+    taucs_ccs_etree(A,parent,NULL,NULL,NULL);
   for (j=0; j <= (A->n); j++) first_child[j] = -1;
   for (j = (A->n)-1; j >= 0; j--) {
     int p = parent[j];
@@ -500,12 +979,17 @@ taucs_ccs_ooc_symbolic_elimination(taucs_ccs_matrix* A,
   taucs_printf("STARTING SYMB 2\n");
 
   ipostorder = (int*)taucs_malloc((A->n+1)*sizeof(int));
+  /* the stream reads ahead in postorder */
+  postorder  = stream ? (int*)taucs_malloc((A->n+1)*sizeof(int)) : NULL;
   { 
     int next = 0;
-    /*int* postorder = (int*)taucs_malloc((A->n+1)*sizeof(int));*/
     recursive_postorder(A->n,first_child,next_child,
-			NULL,
+			postorder,
 			ipostorder,&next);
+    if (stream) {
+      stream->postorder  = postorder;
+      stream->ipostorder = ipostorder;
+    }
     /*
     printf("ipostorder ");
     for (j=0; j <= (A->n); j++) printf("%d ",ipostorder[j]);
@@ -534,7 +1018,8 @@ taucs_ccs_ooc_symbolic_elimination(taucs_ccs_matrix* A,
 				 column_to_sn_map,
 				 map,
 				 do_order,ipostorder,given_mem,
-				 sn_struct_handler,sn_struct_handler_arg
+				 sn_struct_handler,sn_struct_handler_arg,
+				 stream
 				 );
 
   taucs_printf("AFTER SYMB\n");
@@ -570,6 +1055,10 @@ taucs_ccs_ooc_symbolic_elimination(taucs_ccs_matrix* A,
   L->first_child = (int*) taucs_realloc(L->first_child,(L->n_sn+1)*sizeof(int));
   L->next_child  = (int*) taucs_realloc(L->next_child,(L->n_sn+1)*sizeof(int));
 
+  /* the root is an empty supernode; the planner sizes it too */
+  (L->sn_size)   [L->n_sn] = 0;
+  (L->sn_up_size)[L->n_sn] = 0;
+
   L->sn_blocks     = taucs_calloc((L->n_sn), sizeof(taucs_datatype*)); /* so we can free before allocation */
   L->up_blocks     = taucs_calloc((L->n_sn), sizeof(taucs_datatype*));
 
@@ -583,7 +1072,9 @@ taucs_ccs_ooc_symbolic_elimination(taucs_ccs_matrix* A,
 
   taucs_free(next_child);
   taucs_free(first_child);
-  taucs_free(ipostorder);
+  if (!stream) taucs_free(ipostorder); /* otherwise the stream owns it */
+
+  return (stream && stream->error) ? -1 : 0;
 }
 
 /*************************************************************/
@@ -724,6 +1215,7 @@ static int
 leftlooking_supernodal_front_factor(int sn,
 				    int* indmap,
 				    taucs_ccs_matrix* A,
+				    ooc_ccs_stream* stream,
 				    supernodal_factor_matrix* L)
 {
   int ip,jp;
@@ -733,6 +1225,13 @@ leftlooking_supernodal_front_factor(int sn,
   int sn_size = (L->sn_size)[sn];
   int up_size = (L->sn_up_size)[sn] - (L->sn_size)[sn];
 
+  /* the columns of sn come first in its structure */
+  if (stream) {
+    if (ooc_stream_require(stream,(L->sn_struct)[sn],sn_size)) 
+      return -1;
+    A = &(stream->window);
+  }
+
   /* creating transform for real indices */
   for(ip=0;ip<(L->sn_up_size)[sn];ip++) indmap[(L->sn_struct)[sn][ip]] = ip;
 
@@ -790,6 +1289,7 @@ recursive_leftlooking_supernodal_factor_llt(int sn,       /* this supernode */
 					    int is_root,  /* is v the root? */
 					    int* map,
 					    taucs_ccs_matrix* A,
+					    ooc_ccs_stream* stream,
 					    supernodal_factor_matrix* L)
 {
   int  child;
@@ -813,7 +1313,7 @@ recursive_leftlooking_supernodal_factor_llt(int sn,       /* this supernode */
     if (recursive_leftlooking_supernodal_factor_llt(child,
 						    FALSE,
 						    map,
-						    A,L)) {
+						    A,stream,L)) {
       /* failure */
       return -1;
     }
@@ -835,6 +1335,7 @@ recursive_leftlooking_supernodal_factor_llt(int sn,       /* this supernode */
     if (leftlooking_supernodal_front_factor(sn,
 					    map,
 					    A,
+					    stream,
 					    L)) {
       /* nonpositive pivot */
       return -1;
@@ -862,7 +1363,8 @@ void* taucs_ccs_factor_llt_ll(taucs_ccs_matrix* A)
 				     TRUE /* sort row indices */,
 				     FALSE /* don't return col_tosn_map */,
 				     1.0/0.0,
-				     NULL,NULL /* sn_struct handler*/ );
+				     NULL,NULL /* sn_struct handler*/,
+				     NULL /* A is in memory */);
 
   wtime = taucs_wtime()-wtime;
   ctime = taucs_ctime()-ctime;
@@ -878,7 +1380,7 @@ void* taucs_ccs_factor_llt_ll(taucs_ccs_matrix* A)
   if (recursive_leftlooking_supernodal_factor_llt((L->n_sn),  
 						  TRUE, 
 						  map,
-						  A,L)) {
+						  A,NULL,L)) {
     ooc_supernodal_factor_free(L);
     taucs_free(map);
 
@@ -1184,7 +1686,7 @@ recursive_leftlooking_supernodal_factor_llt_ooc(int sn,    /* this supernode */
       if (recursive_leftlooking_supernodal_factor_llt(child,
 						      FALSE,
 						      map,
-						      A,L)) {
+						      A,NULL,L)) {
 	/* failure */
 	return -1;
       }
@@ -1232,6 +1734,7 @@ recursive_leftlooking_supernodal_factor_llt_ooc(int sn,    /* this supernode */
     if (leftlooking_supernodal_front_factor(sn,
 					    map,
 					    A,
+					    NULL,
 					    L)) {
       /* nonpositive pivot */
       return -1;
@@ -1401,7 +1904,8 @@ void* taucs_ccs_factor_llt_ll_ooc(taucs_ccs_matrix* A,
 				     TRUE /* sort row indices */,
 				     FALSE /* don't return col_to_sn_map */,
 				     (memory - memory_overhead)/3.0,
-				     ooc_sn_struct_handler,handle);
+				     ooc_sn_struct_handler,handle,
+				     NULL /* A is in memory */);
   
   /* we now compute an exact memory overhead bound using n_sn */
   memory_overhead = 
@@ -1880,6 +2384,329 @@ int taucs_dtl(ooc_solve_llt)(void* vL,
   ooc_supernodal_factor_free(L);
   return 0;
 }
+/*************************************************************/
+/* block OOC solve                                           */
+/*************************************************************/
+
+/*
+  The block solve streams L once per sweep and applies every 
+  supernode to all the right-hand sides with one trsm and one
+  gemm. The supernodes read last by the forward sweep are the
+  ones the backward sweep needs first; those with the highest
+  postorder numbers (an upward-closed subtree at the root) are 
+  kept in memory between the sweeps when the budget allows.
+*/
+
+static void
+ooc_solve_many_drop(int sn,
+		    supernodal_factor_matrix* L)
+{
+  taucs_free(L->sn_struct[sn]);
+  taucs_free(L->sn_blocks[sn]);
+  taucs_free(L->up_blocks[sn]);
+  L->sn_struct[sn] = NULL;
+  L->sn_blocks[sn] = NULL;
+  L->up_blocks[sn] = NULL;
+}
+
+static int
+ooc_solve_many_load(int sn,
+		    taucs_io_handle* handle,
+		    supernodal_factor_matrix* L)
+{
+  int sn_size = L->sn_size[sn];
+  int up_size = L->sn_up_size[sn] - L->sn_size[sn];
+  int has_up  = (up_size > 0 && sn_size > 0);
+
+  if (L->sn_struct[sn]) return TAUCS_SUCCESS; /* kept by the forward sweep */
+
+  L->sn_struct[sn] = (int*)taucs_malloc((sn_size+up_size)*sizeof(int));
+  L->sn_blocks[sn] = (taucs_datatype*)taucs_malloc(sn_size*sn_size*sizeof(taucs_datatype));
+  if (has_up)
+    L->up_blocks[sn] = (taucs_datatype*)taucs_malloc(up_size*sn_size*sizeof(taucs_datatype));
+  if (!L->sn_struct[sn] || !L->sn_blocks[sn] || (has_up && !L->up_blocks[sn])) {
+    taucs_printf("taucs_ooc_solve_llt_many: out of memory\n");
+    ooc_solve_many_drop(sn,L);
+    return TAUCS_ERROR_NOMEM;
+  }
+
+  if (taucs_io_read(handle,IO_BASE+sn,1,sn_size+up_size,TAUCS_INT,L->sn_struct[sn])
+      || taucs_io_read(handle,IO_BASE+L->n_sn+2*sn,
+		       sn_size,sn_size,
+		       TAUCS_CORE_DATATYPE,L->sn_blocks[sn])
+      || (has_up && taucs_io_read(handle,IO_BASE+L->n_sn+2*sn+1,
+				  up_size,sn_size,
+				  TAUCS_CORE_DATATYPE,L->up_blocks[sn]))) {
+    taucs_printf("taucs_ooc_solve_llt_many: reading supernode %d failed\n",sn);
+    ooc_solve_many_drop(sn,L);
+    return TAUCS_ERROR;
+  }
+
+  return TAUCS_SUCCESS;
+}
+
+/* Y = L^{-1} W; W is overwritten */
+static int 
+recursive_supernodal_solve_l_many_ooc(int sn,
+				      int is_root,
+				      taucs_io_handle* handle,
+				      supernodal_factor_matrix* L,
+				      char* cached,
+				      int nrhs,
+				      taucs_datatype* W, int ld_W,
+				      taucs_datatype* Y, int ld_Y,
+				      taucs_datatype* t)
+{
+  int child;
+  int sn_size,up_size;
+  int i,j,rc;
+  int* sn_struct;
+  taucs_datatype* xdense;
+  taucs_datatype* bdense;
+
+  for (child = L->first_child[sn]; child != -1; child = L->next_child[child]) {
+    rc = recursive_supernodal_solve_l_many_ooc(child,FALSE,handle,L,cached,
+					       nrhs,W,ld_W,Y,ld_Y,t);
+    if (rc != TAUCS_SUCCESS) return rc;
+  }
+
+  if (is_root) return TAUCS_SUCCESS;
+
+  sn_size = L->sn_size[sn];
+  up_size = L->sn_up_size[sn] - L->sn_size[sn];
+  if (sn_size == 0) return TAUCS_SUCCESS;
+
+  rc = ooc_solve_many_load(sn,handle,L);
+  if (rc != TAUCS_SUCCESS) return rc;
+  sn_struct = L->sn_struct[sn];
+
+  xdense = t;
+  bdense = t + sn_size*nrhs;
+
+  for (j=0; j<nrhs; j++)
+    for (i=0; i<sn_size; i++)
+      xdense[j*sn_size + i] = W[j*ld_W + sn_struct[i]];
+
+  taucs_trsm ("Left",
+	      "Lower",
+	      "No Conjugate",
+	      "No unit diagonal",
+	      &sn_size,&nrhs,
+	      &taucs_one_const,
+	      L->sn_blocks[sn],&sn_size,
+	      xdense,&sn_size);
+
+  if (up_size > 0)
+    taucs_gemm ("No Conjugate","No Conjugate",
+		&up_size, &nrhs, &sn_size,
+		&taucs_one_const,
+		L->up_blocks[sn],&up_size,
+		xdense,&sn_size,
+		&taucs_zero_const,
+		bdense,&up_size);
+
+  for (j=0; j<nrhs; j++) {
+    for (i=0; i<sn_size; i++)
+      Y[j*ld_Y + sn_struct[i]] = xdense[j*sn_size + i];
+    for (i=0; i<up_size; i++)
+      W[j*ld_W + sn_struct[sn_size+i]] = 
+	taucs_sub(W[j*ld_W + sn_struct[sn_size+i]],bdense[j*up_size + i]);
+  }
+
+  if (!cached[sn]) ooc_solve_many_drop(sn,L);
+  return TAUCS_SUCCESS;
+}
+
+/* X = L^{-*} Y; Y is not modified */
+static int 
+recursive_supernodal_solve_lt_many_ooc(int sn,
+				       int is_root,
+				       taucs_io_handle* handle,
+				       supernodal_factor_matrix* L,
+				       int nrhs,
+				       taucs_datatype* X, int ld_X,
+				       taucs_datatype* Y, int ld_Y,
+				       taucs_datatype* t)
+{
+  int child;
+  int sn_size,up_size;
+  int i,j,rc;
+  int* sn_struct;
+  taucs_datatype* xdense;
+  taucs_datatype* bdense;
+
+  sn_size = is_root ? 0 : L->sn_size[sn];
+
+  if (sn_size > 0) {
+    up_size = L->sn_up_size[sn] - L->sn_size[sn];
+
+    rc = ooc_solve_many_load(sn,handle,L);
+    if (rc != TAUCS_SUCCESS) return rc;
+    sn_struct = L->sn_struct[sn];
+
+    bdense = t;
+    xdense = t + sn_size*nrhs;
+
+    for (j=0; j<nrhs; j++) {
+      for (i=0; i<sn_size; i++)
+	bdense[j*sn_size + i] = Y[j*ld_Y + sn_struct[i]];
+      for (i=0; i<up_size; i++)
+	xdense[j*up_size + i] = X[j*ld_X + sn_struct[sn_size+i]];
+    }
+
+    if (up_size > 0)
+      taucs_gemm ("Conjugate","No Conjugate",
+		  &sn_size, &nrhs, &up_size,
+		  &taucs_minusone_const,
+		  L->up_blocks[sn],&up_size,
+		  xdense,&up_size,
+		  &taucs_one_const,
+		  bdense,&sn_size);
+
+    taucs_trsm ("Left",
+		"Lower",
+		"Conjugate",
+		"No unit diagonal",
+		&sn_size,&nrhs,
+		&taucs_one_const,
+		L->sn_blocks[sn],&sn_size,
+		bdense,&sn_size);
+
+    for (j=0; j<nrhs; j++)
+      for (i=0; i<sn_size; i++)
+	X[j*ld_X + sn_struct[i]] = bdense[j*sn_size + i];
+
+    ooc_solve_many_drop(sn,L);
+  }
+
+  for (child = L->first_child[sn]; child != -1; child = L->next_child[child]) {
+    rc = recursive_supernodal_solve_lt_many_ooc(child,FALSE,handle,L,
+						nrhs,X,ld_X,Y,ld_Y,t);
+    if (rc != TAUCS_SUCCESS) return rc;
+  }
+
+  return TAUCS_SUCCESS;
+}
+
+/*
+  memory bounds the solve's own storage: the n-by-nrhs 
+  intermediate block, the dense workspace, and the supernodes
+  kept between the sweeps. With memory=0 nothing is kept and
+  L is read exactly twice.
+*/
+
+int taucs_dtl(ooc_solve_llt_many_cached)(void* vL,
+					 int nrhs,
+					 void* vX, int ld_X,
+					 void* vB, int ld_B,
+					 double memory)
+{
+  taucs_io_handle* handle = (taucs_io_handle*) vL;
+  taucs_datatype* X = (taucs_datatype*) vX;
+  taucs_datatype* B = (taucs_datatype*) vB;
+  supernodal_factor_matrix* L;
+
+  taucs_datatype* Y;
+  taucs_datatype* t;
+  char*   cached;
+  int     i,j,sn,rc;
+  int     max_up_size;
+  int     ncached;
+  double  bytes,kept;
+  double  bytes_read;
+
+  if (nrhs <= 0) return TAUCS_SUCCESS;
+
+  L = multifrontal_supernodal_create();
+  if (!L) {
+    taucs_printf("taucs_ooc_solve_llt_many: out of memory\n");
+    return TAUCS_ERROR_NOMEM;
+  }
+
+  taucs_io_read(handle,5,1,1,TAUCS_INT,&(L->n));
+  taucs_io_read(handle,0,1,1,TAUCS_INT,&(L->n_sn));
+  L->sn_struct = (int**)taucs_calloc((L->n_sn  ),sizeof(int*));
+  L->sn_blocks = (taucs_datatype**)taucs_calloc((L->n_sn  ),sizeof(taucs_datatype*));
+  L->up_blocks = (taucs_datatype**)taucs_calloc((L->n_sn  ),sizeof(taucs_datatype*));
+  L->sn_size   = (int*) taucs_malloc((L->n_sn+1)*sizeof(int));
+  L->sn_up_size   = (int*) taucs_malloc((L->n_sn+1)*sizeof(int));
+  L->first_child = (int*) taucs_malloc((L->n_sn+1)*sizeof(int));
+  L->next_child  = (int*) taucs_malloc((L->n_sn+1)*sizeof(int));
+  cached = (char*) taucs_calloc(L->n_sn+1,sizeof(char));
+  if (!L->sn_struct || !L->sn_blocks || !L->up_blocks
+      || !L->sn_size || !L->sn_up_size 
+      || !L->first_child || !L->next_child || !cached) {
+    taucs_printf("taucs_ooc_solve_llt_many: out of memory\n");
+    taucs_free(cached);
+    ooc_supernodal_factor_free(L);
+    return TAUCS_ERROR_NOMEM;
+  }
+  taucs_io_read(handle,1,1,L->n_sn+1,TAUCS_INT,L->first_child);
+  taucs_io_read(handle,2,1,L->n_sn+1,TAUCS_INT,L->next_child);
+  taucs_io_read(handle,3,1,L->n_sn,TAUCS_INT,L->sn_size);
+  taucs_io_read(handle,4,1,L->n_sn,TAUCS_INT,L->sn_up_size);
+
+  max_up_size = 0;
+  for (sn=0; sn<L->n_sn; sn++)
+    max_up_size = max(max_up_size,L->sn_up_size[sn]);
+
+  Y = (taucs_datatype*) taucs_malloc(((L->n)*nrhs) * sizeof(taucs_datatype));
+  t = (taucs_datatype*) taucs_malloc((max(max_up_size,1)*nrhs) * sizeof(taucs_datatype));
+  if (!Y || !t) {
+    taucs_printf("taucs_ooc_solve_llt_many: out of memory\n");
+    taucs_free(Y);
+    taucs_free(t);
+    taucs_free(cached);
+    ooc_supernodal_factor_free(L);
+    return TAUCS_ERROR_NOMEM;
+  }
+
+  /* keep a suffix of the postorder; it is closed under parents */
+  memory -= ((double)(L->n) + (double)max_up_size) 
+            * (double)nrhs * sizeof(taucs_datatype);
+  kept = 0.0;
+  ncached = 0;
+  for (sn=L->n_sn-1; sn>=0; sn--) {
+    bytes = (double) L->sn_up_size[sn] * sizeof(int)
+          + (double) L->sn_up_size[sn] * (double) L->sn_size[sn] 
+            * sizeof(taucs_datatype);
+    if (kept + bytes > memory) break;
+    kept += bytes;
+    cached[sn] = 1;
+    ncached++;
+  }
+
+  for (j=0; j<nrhs; j++)
+    for (i=0; i<L->n; i++)
+      X[j*ld_X + i] = B[j*ld_B + i];
+
+  bytes_read = handle->bytes_read;
+
+  rc = recursive_supernodal_solve_l_many_ooc (L->n_sn,TRUE,handle,L,cached,
+					      nrhs,X,ld_X,Y,L->n,t);
+  if (rc == TAUCS_SUCCESS)
+    rc = recursive_supernodal_solve_lt_many_ooc(L->n_sn,TRUE,handle,L,
+						nrhs,X,ld_X,Y,L->n,t);
+
+  if (rc == TAUCS_SUCCESS)
+    taucs_printf("taucs_ooc_solve_llt_many: %d rhs, %d of %d supernodes kept (%.0f bytes), %.0f bytes read\n",
+		 nrhs,ncached,L->n_sn,kept,handle->bytes_read - bytes_read);
+
+  taucs_free(Y);
+  taucs_free(t);
+  taucs_free(cached);
+  ooc_supernodal_factor_free(L);
+  return rc;
+}
+
+int taucs_dtl(ooc_solve_llt_many)(void* vL,
+				  int nrhs,
+				  void* vX, int ld_X,
+				  void* vB, int ld_B)
+{
+  return taucs_dtl(ooc_solve_llt_many_cached)(vL,nrhs,vX,ld_X,vB,ld_B,0.0);
+}
+
 /*******************************************************************/
 /**                     OOC Panelize Factor                       **/
 /*******************************************************************/
@@ -2005,271 +2832,732 @@ recursive_panelize_ooc_supernodes(int sn,       /* this supernode */
   return curr_avail_mem;
 }
 
-static void
-recursive_leftlooking_supernodal_update_panel_ooc(int J,int K,
-						  int bitmap[],
-						  int* sn_to_panel_map,
-						  taucs_datatype* dense_update_matrix,
-						  taucs_io_handle* handle,
-						  taucs_ccs_matrix* A,
-						  supernodal_factor_matrix* L)
-{
-  int i,j,ir,ii;
+/*************************************************************/
+/* panel planning                                            */
+/*************************************************************/
+
+/*
+  The panel factorization reads from the file
+  - the structure of every supernode, exactly once, and
+  - for every panel P, the structure of every supernode K outside P
+    that the update recursion visits on behalf of P, together with
+    K's update block if K has rows in P.
+  The recursion visits K for P when K's parent is in P, or when the
+  parent is outside P but has rows in P. (The rows of a child outside
+  its parent's columns are rows of the parent, so a supernode without
+  rows in P has no descendant with rows in P.) If T(K) is the set of
+  panels in which K has rows, then K is visited once for every panel
+  in T(parent) plus the parent's own panel, minus K's own panel, and
+  its block is read once for every panel of T(K) other than its own.
+  The volume is thus determined exactly by the sizes |T(K)|. The
+  planner computes them in a single pass over the structures in the
+  file, for all candidate panelizations at once.
+
+  Each candidate splits the memory between the in-core subtrees and
+  the panels. The memory is what remains after the fixed overhead
+  and the per-update buffers: the dense update matrices and one or
+  two update blocks of a visited supernode. The first candidate is
+  the old split (a third each). The others give the panels
+  everything that the in-core subtrees do not use. The planner keeps
+  the feasible candidate with the smallest predicted volume.
+*/
+
+#define OOC_PLAN_CANDIDATES 6
+
+/* in-core share of the memory of each candidate; panels get the rest */
+static double ooc_plan_incore_share[OOC_PLAN_CANDIDATES] = 
+  { 1.0/3.0, 1.0/2.0, 1.0/3.0, 1.0/4.0, 1.0/6.0, 1.0/10.0 };
+
+static double
+ooc_plan_sn_mem(int sn, supernodal_factor_matrix* L)
+{
+  return (double)(L->sn_size)[sn]*(double)(L->sn_up_size)[sn]*sizeof(taucs_datatype)
+    +(double)(L->sn_up_size)[sn]*sizeof(int);
+}
+
+/*
+  For every candidate c and supernode K, touch[c][K] is set to
+  2*|T(K)|+1 if K has rows in its own panel, and to 2*|T(K)| if it
+  does not. Panel numbers never decrease towards the root, so T(K) can
+  be counted in one scan of K's sorted structure.
+*/
+
+static int
+ooc_plan_touches(int ncand,
+		 int** sn_to_panel_map,
+		 int** touch,
+		 taucs_io_handle* handle,
+		 supernodal_factor_matrix* L)
+{
+  int c,sn,i,p,last,count,own;
+  int max_up_size = 0;
+  int* sn_struct;
+  
+  for (sn=0; sn<L->n_sn; sn++)
+    if (L->sn_up_size[sn] > max_up_size) max_up_size = L->sn_up_size[sn];
+
+  sn_struct = (int*) taucs_malloc((max_up_size+1)*sizeof(int));
+  if (!sn_struct) return -1;
+
+  for (sn=0; sn<L->n_sn; sn++) {
+    for (c=0; c<ncand; c++) touch[c][sn] = 0;
+
+    if (L->sn_up_size[sn]-L->sn_size[sn] <= 0) continue;
+
+    if (taucs_io_read(handle,IO_BASE+sn,1,L->sn_up_size[sn],TAUCS_INT,sn_struct)) {
+      taucs_free(sn_struct);
+      return -1;
+    }
+
+    for (c=0; c<ncand; c++) {
+      last  = -1;
+      count = 0;
+      own   = 0;
+      for (i=L->sn_size[sn]; i<L->sn_up_size[sn]; i++) {
+	p = sn_to_panel_map[c][L->col_to_sn_map[sn_struct[i]]];
+	if (p > last) {
+	  count++;
+	  last = p;
+	  if (p == sn_to_panel_map[c][sn]) own = 1;
+	}
+      }
+      touch[c][sn] = 2*count + own;
+    }
+  }
+
+  taucs_free(sn_struct);
+  return 0;
+}
+
+/* the exact number of bytes that the panel factorization reads */
+
+static double
+ooc_plan_volume(int* parent,
+		int* sn_to_panel_map,
+		int* touch,
+		supernodal_factor_matrix* L)
+{
+  int sn,p,pp,visits,blocks;
+  double volume = 0.0;
+
+  for (sn=0; sn<L->n_sn; sn++) {
+    volume += (double)(L->sn_up_size)[sn]*sizeof(int);
+
+    if (L->sn_up_size[sn]-L->sn_size[sn] <= 0) continue;
+
+    p = parent[sn];
+    if (p == L->n_sn) 
+      visits = 0;
+    else {
+      pp = sn_to_panel_map[p];
+      visits = touch[p]/2 + ((pp >= 0 && !(touch[p]%2)) ? 1 : 0);
+      if (pp >= 0 && sn_to_panel_map[sn] == pp) visits--;
+    }
+    blocks = touch[sn]/2 - touch[sn]%2;
+
+    volume += (double) visits * (double)(L->sn_up_size)[sn]*sizeof(int);
+    volume += (double) blocks * (double)((L->sn_up_size)[sn]-(L->sn_size)[sn])
+                              * (double)(L->sn_size)[sn]*sizeof(taucs_datatype);
+  }
+
+  return volume;
+}
+
+static int*
+ooc_plan_parents(supernodal_factor_matrix* L)
+{
+  int sn,child;
+  int* parent = (int*) taucs_malloc((L->n_sn+1)*sizeof(int));
+
+  if (!parent) return NULL;
+  parent[L->n_sn] = -1;
+  for (sn=0; sn<=L->n_sn; sn++)
+    for (child = L->first_child[sn]; child != -1; child = L->next_child[child])
+      parent[child] = sn;
+
+  return parent;
+}
+
+/*
+  Chooses sn_in_core and sn_to_panel_map for the given memory (what
+  is left after the fixed overhead). Returns the number of panels, or
+  -1 on failure; *predicted is set to the read volume of the chosen
+  plan.
+*/
+
+static int
+ooc_plan_panels(double memory,
+		int nproc,
+		int* sn_in_core,
+		int* sn_to_panel_map,
+		double* predicted,
+		taucs_io_handle* handle,
+		supernodal_factor_matrix* L)
+{
+  int*   pm[OOC_PLAN_CANDIDATES];
+  int*   touch[OOC_PLAN_CANDIDATES];
+  int    n_pn[OOC_PLAN_CANDIDATES];
+  int    feasible[OOC_PLAN_CANDIDATES];
+  double incore_mem[OOC_PLAN_CANDIDATES];
+  double panel_mem[OOC_PLAN_CANDIDATES];
+  double volume[OOC_PLAN_CANDIDATES];
+  double* sum = NULL;
+  int*   parent;
+  double* dense = NULL;
+  double max_dense = 0.0, max_update = 0.0, buffers, peak;
+  double bytes_read;
+  int c,i,best = -1;
+  int rc = -1;
+
+  for (i=0; i<L->n_sn; i++) {
+    double dense  = (double)(L->sn_size)[i]*(double)(L->sn_up_size)[i]*sizeof(taucs_datatype);
+    double update = (double)((L->sn_up_size)[i]-(L->sn_size)[i])*(double)(L->sn_size)[i]*sizeof(taucs_datatype)
+                   +(double)(L->sn_up_size)[i]*sizeof(int);
+    if (dense  > max_dense)  max_dense  = dense;
+    if (update > max_update) max_update = update;
+  }
+  buffers = (double)nproc*max_dense + (nproc > 1 ? 2.0 : 1.0)*max_update;
+
+  for (c=0; c<OOC_PLAN_CANDIDATES; c++) pm[c] = touch[c] = NULL;
+  parent = ooc_plan_parents(L);
+  sum    = (double*) taucs_malloc((L->n_sn+1)*sizeof(double));
+  dense  = (double*) taucs_malloc((L->n_sn+1)*sizeof(double));
+  if (!parent || !sum || !dense) goto release;
+
+  for (c=0; c<OOC_PLAN_CANDIDATES; c++) {
+    incore_mem[c] = memory*ooc_plan_incore_share[c];
+    panel_mem[c]  = (c==0) ? memory/3.0 : memory - incore_mem[c] - buffers;
+    feasible[c]   = 0;
+    if (panel_mem[c] <= 0.0) continue;
+
+    pm[c]    = (int*) taucs_malloc((L->n_sn+1)*sizeof(int));
+    touch[c] = (int*) taucs_malloc((L->n_sn+1)*sizeof(int));
+    if (!pm[c] || !touch[c]) goto release;
+
+    for (i=0; i<=L->n_sn; i++) {
+      sn_in_core[i] = 0;
+      pm[c][i] = -1;
+    }
+    if (recursive_compute_supernodes_ll_in_core(L->n_sn,TRUE,incore_mem[c],
+						sn_in_core,L) < 0.0)
+      goto release;
+    n_pn[c] = 0;
+    if (recursive_panelize_ooc_supernodes(L->n_sn,TRUE,panel_mem[c],panel_mem[c],
+					  &(n_pn[c]),sn_in_core,pm[c],L) < 0.0)
+      goto release;
+    n_pn[c]++;
+
+    /* a supernode larger than panel_mem[c] forms a panel by itself,
+       and the dense update matrices only need to hold the largest
+       supernode of their own panel */
+    for (i=0; i<n_pn[c]; i++) sum[i] = dense[i] = 0.0;
+    for (i=0; i<L->n_sn; i++) 
+      if (pm[c][i] >= 0) {
+	double d = (double)(L->sn_size)[i]*(double)(L->sn_up_size)[i]*sizeof(taucs_datatype);
+	sum[pm[c][i]] += ooc_plan_sn_mem(i,L);
+	if (d > dense[pm[c][i]]) dense[pm[c][i]] = d;
+      }
+    peak = 0.0;
+    for (i=0; i<n_pn[c]; i++) 
+      if (sum[i] + (double)nproc*dense[i] > peak) peak = sum[i] + (double)nproc*dense[i];
+    feasible[c] = (peak + incore_mem[c] + buffers - (double)nproc*max_dense <= memory);
+
+  }
+
+  /* move the evaluated candidates to the front for the scan */
+  {
+    int* pm_scan[OOC_PLAN_CANDIDATES];
+    int* touch_scan[OOC_PLAN_CANDIDATES];
+    int  n = 0;
+    for (c=0; c<OOC_PLAN_CANDIDATES; c++)
+      if (pm[c]) { pm_scan[n] = pm[c]; touch_scan[n] = touch[c]; n++; }
+
+    bytes_read = handle->bytes_read;
+    if (n == 0 || ooc_plan_touches(n,pm_scan,touch_scan,handle,L)) goto release;
+    bytes_read = handle->bytes_read - bytes_read;
+  }
+
+  taucs_printf("\t\tOOC panel planner (%.0f MB, %d threads; planning read %.2e bytes):\n",
+	       memory/1048576.0,nproc,bytes_read);
+  for (c=0; c<OOC_PLAN_CANDIDATES; c++) {
+    if (!pm[c]) continue;
+    volume[c] = ooc_plan_volume(parent,pm[c],touch[c],L);
+    taucs_printf("\t\t\tin-core %6.1f MB panels %6.1f MB: %5d panels, read %.2e bytes%s\n",
+		 incore_mem[c]/1048576.0,panel_mem[c]/1048576.0,n_pn[c],volume[c],
+		 feasible[c] ? "" : " (exceeds memory)");
+    if (feasible[c] && (best == -1 || volume[c] < volume[best])) best = c;
+  }
+  if (best == -1) {
+    if (!pm[0]) goto release;
+    taucs_printf("\t\tOOC panel planner: no plan fits in memory, using the default\n");
+    best = 0;
+  }
+
+  for (i=0; i<=L->n_sn; i++) sn_in_core[i] = 0;
+  recursive_compute_supernodes_ll_in_core(L->n_sn,TRUE,incore_mem[best],sn_in_core,L);
+  for (i=0; i<=L->n_sn; i++) sn_to_panel_map[i] = pm[best][i];
+  *predicted = volume[best];
+  rc = n_pn[best];
+
+ release:
+  for (c=0; c<OOC_PLAN_CANDIDATES; c++) {
+    taucs_free(pm[c]);
+    taucs_free(touch[c]);
+  }
+  taucs_free(sum);
+  taucs_free(dense);
+  taucs_free(parent);
+  return rc;
+}
+
+/* the predicted volume of a given panelization, for reporting */
+
+static double
+ooc_plan_predict(int* sn_to_panel_map,
+		 taucs_io_handle* handle,
+		 supernodal_factor_matrix* L)
+{
+  int*   parent = ooc_plan_parents(L);
+  int*   touch  = (int*) taucs_malloc((L->n_sn+1)*sizeof(int));
+  double volume = -1.0;
+
+  if (parent && touch 
+      && !ooc_plan_touches(1,&sn_to_panel_map,&touch,handle,L))
+    volume = ooc_plan_volume(parent,sn_to_panel_map,touch,L);
+
+  taucs_free(touch);
+  taucs_free(parent);
+  return volume;
+}
+
+/*************************************************************/
+/* panel updates                                             */
+/*************************************************************/
+
+/*
+  A supernode K outside the panel updates every supernode of the
+  panel that appears in its row structure. The row indices of K are
+  sorted, so the rows that fall in one updated supernode form a
+  contiguous run, and different runs update different supernodes.
+  The runs are therefore independent. With TAUCS_CONFIG_PFUNC and
+  nproc > 1 they are applied by up to nproc threads, each with its
+  own dense update matrix and bitmap, while one more thread reads
+  the structure of the supernode that will be visited next, and its
+  update block if it updates the panel (the same reads the visit
+  would do). The update threads never do any I/O: everything they
+  touch is read before they start.
+*/
+
+/* updates from K smaller than this are applied by one thread */
+#define OOC_PARALLEL_FLOPS_CUTOFF 1.0e6
+
+typedef struct {
+  int sn;         /* the updated supernode                       */
+  int first_row;  /* first row of K's structure that falls in sn */
+  int row_count;  /* number of rows of K's structure in sn       */
+  int owner;      /* thread that applies this update             */
+} ooc_panel_target;
+
+typedef struct {
+  int                nproc;
+  int**              bitmaps;  /* one per thread, bitmaps[0] is map  */
+  taucs_datatype**   dense;    /* one dense update matrix per thread */
+  ooc_panel_target*  targets;  /* the runs of the current K          */
+  double*            load;     /* flops assigned to each thread      */
+  ooc_ccs_stream*    stream;   /* A's columns, if A is not in memory */
+} ooc_panel_workspace;
+
+typedef struct {
+  int                  J;      /* the first updated supernode                */
+  int                  K;      /* the updating supernode, or the one to read */
+  int                  tid;    /* -1 for the read-ahead task                 */
+  int*                 sn_to_panel_map;
+  int                  ntargets;
+  ooc_panel_workspace* ws;
+  taucs_io_handle*     handle;
+  supernodal_factor_matrix* L;
+} ooc_panel_task;
+
+static int
+ooc_panel_workspace_create(ooc_panel_workspace* ws,
+			   int nproc,
+			   int* map,
+			   taucs_ccs_matrix* A,
+			   supernodal_factor_matrix* L)
+{
+  int t;
+
+  ws->nproc   = nproc;
+  ws->stream  = NULL;
+  ws->bitmaps = (int**) taucs_calloc(nproc,sizeof(int*));
+  ws->dense   = (taucs_datatype**) taucs_calloc(nproc,sizeof(taucs_datatype*));
+  ws->targets = (ooc_panel_target*) taucs_malloc((L->n_sn+1)*sizeof(ooc_panel_target));
+  ws->load    = (double*) taucs_malloc(nproc*sizeof(double));
+  if (!(ws->bitmaps) || !(ws->dense) || !(ws->targets) || !(ws->load))
+    return -1;
+
+  ws->bitmaps[0] = map;
+  for (t=1; t<nproc; t++) {
+    ws->bitmaps[t] = (int*) taucs_calloc(A->n+1,sizeof(int));
+    if (!(ws->bitmaps[t])) return -1;
+  }
+
+  return 0;
+}
+
+/* does not free bitmaps[0], which belongs to the caller */
+
+static void
+ooc_panel_workspace_free(ooc_panel_workspace* ws)
+{
+  int t;
+
+  for (t=0; t<ws->nproc; t++) {
+    if (ws->bitmaps && t>0) taucs_free(ws->bitmaps[t]);
+    if (ws->dense)          taucs_free(ws->dense[t]);
+  }
+  taucs_free(ws->bitmaps);
+  taucs_free(ws->dense);
+  taucs_free(ws->targets);
+  taucs_free(ws->load);
+}
+
+static int
+ooc_panel_find_targets(int J,int K,
+		       int* sn_to_panel_map,
+		       ooc_panel_target* targets,
+		       supernodal_factor_matrix* L)
+{
+  int i,sn;
+  int ntargets = 0;
+  int updated_panel = sn_to_panel_map[J];
+
+  for(i=L->sn_size[K];i<L->sn_up_size[K];i++){
+    sn = L->col_to_sn_map[L->sn_struct[K][i]];
+
+    /* only supernodes from J up, and only those in J's panel */
+    if(sn<J || sn_to_panel_map[sn]!=updated_panel)
+      continue;
+
+    if(ntargets>0 && targets[ntargets-1].sn==sn)
+      targets[ntargets-1].row_count++;
+    else {
+      targets[ntargets].sn        = sn;
+      targets[ntargets].first_row = i;
+      targets[ntargets].row_count = 1;
+      targets[ntargets].owner     = 0;
+      ntargets++;
+    }
+  }
+
+  return ntargets;
+}
+
+static void
+ooc_panel_read_ahead(int J,int sn,
+		     int* sn_to_panel_map,
+		     taucs_io_handle* handle,
+		     supernodal_factor_matrix* L)
+{
+  int i,target;
+  int has_targets = 0;
+
+  if(L->sn_up_size[sn]-L->sn_size[sn]<=0)
+    return;
+
+  if(!L->sn_struct[sn]){
+    L->sn_struct[sn] = (int*)taucs_malloc(L->sn_up_size[sn]*sizeof(int));
+    taucs_io_read(handle,IO_BASE+sn,1,L->sn_up_size[sn],TAUCS_INT,L->sn_struct[sn]);
+  }
+
+  /* the block is only read if sn updates J's panel */
+  for(i=L->sn_size[sn];i<L->sn_up_size[sn] && !has_targets;i++){
+    target = L->col_to_sn_map[L->sn_struct[sn][i]];
+    if(target>=J && sn_to_panel_map[target]==sn_to_panel_map[J])
+      has_targets = 1;
+  }
+
+  if(has_targets && !L->up_blocks[sn]){
+    L->up_blocks[sn] = (taucs_datatype*)taucs_calloc((L->sn_up_size[sn]-L->sn_size[sn])
+						     *L->sn_size[sn],
+						     sizeof(taucs_datatype));
+    taucs_io_read(handle,IO_BASE+L->n_sn+2*sn+1,
+		  L->sn_up_size[sn]-L->sn_size[sn],
+		  L->sn_size[sn],
+		  TAUCS_CORE_DATATYPE,L->up_blocks[sn]);
+  }
+}
+
+/*
+  Subtracts the contribution of K to one updated supernode. The
+  blocks and structures of both supernodes must be in memory.
+*/
+
+static void
+ooc_panel_apply_update(int K,
+		       ooc_panel_target* target,
+		       int bitmap[],
+		       taucs_datatype* dense_update_matrix,
+		       supernodal_factor_matrix* L)
+{
+  int j,ir,ii;
+  int curr_updated_sn = target->sn;
+  int first_row       = target->first_row;
+  int row_count       = target->row_count;
+  int sn_size_child   = (L->sn_size)[K];
+  int sn_up_size_child= (L->sn_up_size)[K];
+  int PK,M,N,LDA,LDB,LDC;
+
+  LDA = LDB = (L->sn_up_size)[K]-(L->sn_size)[K];
+  M  = sn_up_size_child - first_row ;
+  LDC =  M;
+  N  = row_count; 
+  PK = L->sn_size[K];    
+
+  /* This is the HERK+GEMM fix by Elad; GEMM alone computes on the
+     upper triangle of the trapezoidal matrix, which is junk. */
+  taucs_herk ("Lower",
+	      "No Conjugate",
+	      &N,&PK,
+	      &taucs_one_real_const,
+	      &(L->up_blocks[K][first_row-sn_size_child]),&LDA,
+	      &taucs_zero_real_const,
+	      dense_update_matrix,&LDC);
+
+  if(M-N > 0)
+    {
+      int newM = M - N;
+	      
+      taucs_gemm ("No Conjugate",
+		  "Conjugate",
+		  &newM,&N,&PK,
+		  &taucs_one_const,
+		  &(L->up_blocks[K][first_row-sn_size_child+N]),&LDA,
+		  &(L->up_blocks[K][first_row-sn_size_child]),&LDB,
+		  &taucs_zero_const,
+		  dense_update_matrix+N,&LDC);
+    }
+  /* end of GEMM/HERK+GEMM fix */ 
+
+  for(ii=0;ii<L->sn_size[curr_updated_sn];ii++) {
+    bitmap[L->sn_struct[curr_updated_sn][ii]]=ii+1;
+  }
+
+  for(ii=L->sn_size[curr_updated_sn];ii<L->sn_up_size[curr_updated_sn];ii++){
+    bitmap[L->sn_struct[curr_updated_sn][ii]] = ii-L->sn_size[curr_updated_sn]+1;
+  }
+	   
+  assert((double)row_count*(double)LDC < 2048.0*1024.0*1024.0);
+  for(j=0;j<row_count;j++)
+    for(ir=j;ir<row_count;ir++){
+      L->sn_blocks[curr_updated_sn][(bitmap[L->sn_struct[K][first_row+j]]-1)*L->sn_size[curr_updated_sn]+(bitmap[L->sn_struct[K][first_row+ir]]-1)] =
+	taucs_sub(L->sn_blocks[curr_updated_sn][(bitmap[L->sn_struct[K][first_row+j]]-1)*L->sn_size[curr_updated_sn]+(bitmap[L->sn_struct[K][first_row+ir]]-1)] , dense_update_matrix[j*LDC+ir]);
+
+      /* to find overflows */
+      assert((double)(bitmap[L->sn_struct[K][first_row+j]]-1)*(double)L->sn_size[curr_updated_sn] < 2048.0*1024.0*1024.0);
+    }
+  for(j=0;j<row_count;j++)
+    for(ir=row_count;ir<M;ir++){
+      L->up_blocks[curr_updated_sn][(bitmap[L->sn_struct[K][first_row+j]]-1)*(L->sn_up_size[curr_updated_sn]-L->sn_size[curr_updated_sn])+(bitmap[L->sn_struct[K][ir+first_row]]-1)] =
+	taucs_sub(L->up_blocks[curr_updated_sn][(bitmap[L->sn_struct[K][first_row+j]]-1)*(L->sn_up_size[curr_updated_sn]-L->sn_size[curr_updated_sn])+(bitmap[L->sn_struct[K][ir+first_row]]-1)] , dense_update_matrix[j*LDC+ir]);
+
+      /* to find overflow */
+      assert((double)(bitmap[L->sn_struct[K][first_row+j]]-1)*(double)(L->sn_up_size[curr_updated_sn]-L->sn_size[curr_updated_sn]) < 2048.0*1024.0*1024.0);
+    }	
+  for(ii=0;ii<L->sn_up_size[curr_updated_sn];ii++)
+    bitmap[L->sn_struct[curr_updated_sn][ii]]=0;
+}
+
+static void
+ooc_panel_task_run(ooc_panel_task* T)
+{
+  int t;
+
+  if (T->tid < 0) {
+    ooc_panel_read_ahead(T->J,T->K,T->sn_to_panel_map,T->handle,T->L);
+    return;
+  }
+
+  for (t=0; t<T->ntargets; t++)
+    if (T->ws->targets[t].owner == T->tid)
+      ooc_panel_apply_update(T->K,&(T->ws->targets[t]),
+			     T->ws->bitmaps[T->tid],
+			     T->ws->dense[T->tid],
+			     T->L);
+}
+
+#ifdef TAUCS_CONFIG_PFUNC
+static void ooc_panel_thread(void* args)
+{
+  ooc_panel_task* T;
+
+  pfunc_unpack(args, "void*", (void*)&T);
+  ooc_panel_task_run(T);
+}
+#endif
+
+/*
+  Applies the updates of K to all the targets found by
+  ooc_panel_find_targets, and, when running in parallel, reads
+  the supernode next (if not -1) at the same time.
+*/
+
+static void
+ooc_panel_apply_updates(int J,int K,
+			int ntargets,
+			int next,
+			int* sn_to_panel_map,
+			ooc_panel_workspace* ws,
+			taucs_io_handle* handle,
+			supernodal_factor_matrix* L)
+{
+  ooc_panel_task serial;
+  int t;
+
+#ifdef TAUCS_CONFIG_PFUNC
+  int nthreads = ws->nproc < ntargets ? ws->nproc : ntargets;
+  double flops = 0.0;
+
+  for (t=0; t<ntargets; t++)
+    flops += (double) ws->targets[t].row_count
+           * (double) (L->sn_up_size[K] - ws->targets[t].first_row)
+           * (double) L->sn_size[K];
+
+  if (ws->nproc > 1 && (nthreads > 1 || next != -1)
+      && flops >= OOC_PARALLEL_FLOPS_CUTOFF) {
+    int ntasks = nthreads + (next != -1 ? 1 : 0);
+    ooc_panel_task* tasks   = (ooc_panel_task*) taucs_malloc(ntasks * sizeof(ooc_panel_task));
+    char**          args    = (char**) taucs_malloc(ntasks * sizeof(char*));
+    pfunc_handle_t* handles = (pfunc_handle_t*) taucs_malloc(ntasks * sizeof(pfunc_handle_t));
+    int p;
+
+    if (tasks && args && handles) {
+      /* largest-first is not worth a sort here; the targets come in
+	 increasing order and each goes to the least loaded thread */
+      for (p=0; p<nthreads; p++) ws->load[p] = 0.0;
+      for (t=0; t<ntargets; t++) {
+	int best = 0;
+	for (p=1; p<nthreads; p++)
+	  if (ws->load[p] < ws->load[best]) best = p;
+	ws->targets[t].owner = best;
+	ws->load[best] += (double) ws->targets[t].row_count
+	                * (double) (L->sn_up_size[K] - ws->targets[t].first_row)
+	                * (double) L->sn_size[K];
+      }
+
+      for (p=0; p<ntasks; p++) {
+	tasks[p].J        = J;
+	tasks[p].K        = (p < nthreads) ? K : next;
+	tasks[p].sn_to_panel_map = sn_to_panel_map;
+	tasks[p].tid      = (p < nthreads) ? p : -1;
+	tasks[p].ntargets = ntargets;
+	tasks[p].ws       = ws;
+	tasks[p].handle   = handle;
+	tasks[p].L        = L;
+	pfunc_handle_init(&handles[p]);
+	pfunc_pack(&args[p], "void*", &tasks[p]);
+	pfunc_run(&handles[p], PFUNC_ATTR_DEFAULT, PFUNC_GROUP_DEFAULT,
+		  ooc_panel_thread, args[p]);
+      }
+      pfunc_wait_all(handles, ntasks);
+      for (p=0; p<ntasks; p++)
+	pfunc_handle_clear(handles[p]);
+      taucs_free(handles);
+      taucs_free(args);
+      taucs_free(tasks);
+      return;
+    }
+    taucs_free(handles);
+    taucs_free(args);
+    taucs_free(tasks);
+  }
+#endif
+
+  for (t=0; t<ntargets; t++)
+    ws->targets[t].owner = 0;
+
+  serial.J        = J;
+  serial.K        = K;
+  serial.sn_to_panel_map = sn_to_panel_map;
+  serial.tid      = 0;
+  serial.ntargets = ntargets;
+  serial.ws       = ws;
+  serial.handle   = handle;
+  serial.L        = L;
+  ooc_panel_task_run(&serial);
+}
+
+/*
+  Updates the supernodes of J's panel with K and, if K is outside
+  the panel, with K's descendants. after is the supernode that the
+  caller will pass as K next (-1 if none); it is read ahead when the
+  updates run in parallel.
+*/
+
+static void
+recursive_leftlooking_supernodal_update_panel_ooc(int J,int K,
+						  int after,
+						  ooc_panel_workspace* ws,
+						  int* sn_to_panel_map,
+						  taucs_io_handle* handle,
+						  taucs_ccs_matrix* A,
+						  supernodal_factor_matrix* L)
+{
+  int t,sn;
   int  child;
   int* first_child   = L->first_child;
   int* next_child    = L->next_child;
-  int sn_size_child = (L->sn_size)[K];
-  int sn_up_size_child = (L->sn_up_size)[K];
-  int exist_upd=0;
-  int first_row=0;
-  int row_count=0;
-  int updated_panel = sn_to_panel_map[J];
-  int curr_updated_sn = J;
-  int PK,M,N,LDA,LDB,LDC;
+  int ntargets = 0;
+  int recurse;
+  int next;
  
   if(L->sn_up_size[K]-L->sn_size[K]>0){
     
     if(!(L->sn_struct)[K]){
-      L->sn_struct[K] = (int*)taucs_malloc(sn_up_size_child*sizeof(int));
-      taucs_io_read(handle,IO_BASE+K,1,sn_up_size_child,TAUCS_INT,L->sn_struct[K]);
+      L->sn_struct[K] = (int*)taucs_malloc(L->sn_up_size[K]*sizeof(int));
+      taucs_io_read(handle,IO_BASE+K,1,L->sn_up_size[K],TAUCS_INT,L->sn_struct[K]);
     }
 
-    for(i=sn_size_child;i<sn_up_size_child;i++){
-      /* We want to update only supernodes great than J with using of
-	 sort of indices */
-      if(L->col_to_sn_map[L->sn_struct[K][i]]<curr_updated_sn)
-	continue;
+    ntargets = ooc_panel_find_targets(J,K,sn_to_panel_map,ws->targets,L);
+  }
 
-      /* is this row index included in the columns of curr_updated_sn ? */
-      if(L->col_to_sn_map[L->sn_struct[K][i]]==curr_updated_sn){
-	if(!exist_upd) first_row = i;
-	row_count++;
-	exist_upd = 1;
-      }
-     
-      /* if end of update to curr_updated_sn or edge condition */
-      if(L->col_to_sn_map[L->sn_struct[K][i]]!=curr_updated_sn||
-	 i==sn_up_size_child-1)
-	if(exist_upd){ 
-	  if(!(L->up_blocks)[K]){
-	    (L->up_blocks)[K] = (taucs_datatype*)taucs_calloc(((L->sn_up_size)[K]-(L->sn_size)[K])
+  recurse = (ntargets > 0 && sn_to_panel_map[J]!=sn_to_panel_map[K]);
+  next = (recurse && first_child[K] != -1) ? first_child[K] : after;
+
+  if (ntargets > 0) {
+    if(!(L->up_blocks)[K]){
+      (L->up_blocks)[K] = (taucs_datatype*)taucs_calloc(((L->sn_up_size)[K]-(L->sn_size)[K])
 							*((L->sn_size)[K]),
 							sizeof(taucs_datatype));
-	    taucs_io_read(handle,IO_BASE+L->n_sn+2*K+1,
-			  (L->sn_up_size)[K]-(L->sn_size)[K],
-			  (L->sn_size)[K] ,
-			  TAUCS_CORE_DATATYPE,(L->up_blocks)[K]);
-	  }
-	  LDA = LDB = (L->sn_up_size)[K]-(L->sn_size)[K];
-	  M  = sn_up_size_child - first_row ;
-	  LDC =  M;
-	  N  = row_count; 
-	  PK = L->sn_size[K];    
-	  
-	  /* The GEMM code computes on the upper triangle of the trapezoidal
-	     matrix, which is junk. */
-	  /*
-             taucs_gemm ("No Conjugate",
-		         "Conjugate",
-		         &M,&N,&PK,
-		         &taucs_one_const,
-		         &(L->up_blocks[K][first_row-sn_size_child]),&LDA,
-		         &(L->up_blocks[K][first_row-sn_size_child]),&LDB,
-		         &taucs_zero_const,
-		         dense_update_matrix,&LDC);
-	  */
-
-	  /* This is the HERK+GEMM fix by Elad */
-	  taucs_herk ("Lower",
-		      "No Conjugate",
-		      &N,&PK,
-		      &taucs_one_real_const,
-		      &(L->up_blocks[K][first_row-sn_size_child]),&LDA,
-		      &taucs_zero_real_const,
-		      dense_update_matrix,&LDC);
-
-	  if(M-N > 0)
-	    {
-	      int newM = M - N;
-	      
-	      taucs_gemm ("No Conjugate",
-			  "Conjugate",
-			  &newM,&N,&PK,
-			  &taucs_one_const,
-			  &(L->up_blocks[K][first_row-sn_size_child+N]),&LDA,
-			  &(L->up_blocks[K][first_row-sn_size_child]),&LDB,
-			  &taucs_zero_const,
-			  dense_update_matrix+N,&LDC);
-	    }
-	  /* end of GEMM/HERK+GEMM fix */ 
-
-	  if(!(L->sn_blocks)[curr_updated_sn])
-	    (L->sn_blocks)[curr_updated_sn] = 
-	      (taucs_datatype*)taucs_calloc(((L->sn_size)[curr_updated_sn])
-				      *((L->sn_size)[curr_updated_sn]),
-				      sizeof(taucs_datatype));
-    
-	  if(L->sn_up_size[curr_updated_sn]-L->sn_size[curr_updated_sn]>0)
-	    if(!(L->up_blocks)[curr_updated_sn]) 
-	      (L->up_blocks)[curr_updated_sn] = (taucs_datatype*)taucs_calloc(((L->sn_up_size)[curr_updated_sn]-(L->sn_size)[curr_updated_sn]) *((L->sn_size)[curr_updated_sn]),sizeof(taucs_datatype));
-
-	  if(!L->sn_struct[curr_updated_sn]){
-	    L->sn_struct[curr_updated_sn] = (int*)taucs_malloc((L->sn_up_size)[curr_updated_sn]*sizeof(int));
-	    taucs_io_read(handle,
-			  IO_BASE+curr_updated_sn,
-			  1,(L->sn_up_size)[curr_updated_sn],
-			  TAUCS_INT,L->sn_struct[curr_updated_sn]);
-	  }
-
-	  for(ii=0;ii<L->sn_size[curr_updated_sn];ii++) {
-	    bitmap[L->sn_struct[curr_updated_sn][ii]]=ii+1;
-	  }
-
-	  for(ii=L->sn_size[curr_updated_sn];ii<L->sn_up_size[curr_updated_sn];ii++){
-	    bitmap[L->sn_struct[curr_updated_sn][ii]] = ii-L->sn_size[curr_updated_sn]+1;
-	  }
-	   
-	  assert((double)row_count*(double)LDC < 2048.0*1024.0*1024.0);
-	  for(j=0;j<row_count;j++)
-	    for(ir=j;ir<row_count;ir++){
-	      /*
-		L->sn_blocks[curr_updated_sn][(bitmap[L->sn_struct[K][first_row+j]]-1)*L->sn_size[curr_updated_sn]+(bitmap[L->sn_struct[K][first_row+ir]]-1)] -= dense_update_matrix[j*LDC+ir];*/
-	      L->sn_blocks[curr_updated_sn][(bitmap[L->sn_struct[K][first_row+j]]-1)*L->sn_size[curr_updated_sn]+(bitmap[L->sn_struct[K][first_row+ir]]-1)] =
-		taucs_sub(L->sn_blocks[curr_updated_sn][(bitmap[L->sn_struct[K][first_row+j]]-1)*L->sn_size[curr_updated_sn]+(bitmap[L->sn_struct[K][first_row+ir]]-1)] , dense_update_matrix[j*LDC+ir]);
-
-	      /* to find overflows */
-	      assert((double)(bitmap[L->sn_struct[K][first_row+j]]-1)*(double)L->sn_size[curr_updated_sn] < 2048.0*1024.0*1024.0);
-	     }
-	  for(j=0;j<row_count;j++)
-	    for(ir=row_count;ir<M;ir++){
-	      /*L->up_blocks[curr_updated_sn][(bitmap[L->sn_struct[K][first_row+j]]-1)*(L->sn_up_size[curr_updated_sn]-L->sn_size[curr_updated_sn])+(bitmap[L->sn_struct[K][ir+first_row]]-1)] -= dense_update_matrix[j*LDC+ir];*/
-
-	      L->up_blocks[curr_updated_sn][(bitmap[L->sn_struct[K][first_row+j]]-1)*(L->sn_up_size[curr_updated_sn]-L->sn_size[curr_updated_sn])+(bitmap[L->sn_struct[K][ir+first_row]]-1)] =
-		taucs_sub(L->up_blocks[curr_updated_sn][(bitmap[L->sn_struct[K][first_row+j]]-1)*(L->sn_up_size[curr_updated_sn]-L->sn_size[curr_updated_sn])+(bitmap[L->sn_struct[K][ir+first_row]]-1)] , dense_update_matrix[j*LDC+ir]);
-
-	      /* to find overflow */
-	      assert((double)(bitmap[L->sn_struct[K][first_row+j]]-1)*(double)(L->sn_up_size[curr_updated_sn]-L->sn_size[curr_updated_sn]) < 2048.0*1024.0*1024.0);
-	     }	
-	  for(ii=0;ii<L->sn_up_size[curr_updated_sn];ii++)
-	    bitmap[L->sn_struct[curr_updated_sn][ii]]=0;
-
-	  exist_upd = 0;
-	  row_count = 0;
-	}
+      taucs_io_read(handle,IO_BASE+L->n_sn+2*K+1,
+		    (L->sn_up_size)[K]-(L->sn_size)[K],
+		    (L->sn_size)[K] ,
+		    TAUCS_CORE_DATATYPE,(L->up_blocks)[K]);
+    }
 
-      /* is this row index included in the columns of sn in the same panel? */
-      if(L->col_to_sn_map[L->sn_struct[K][i]]!=curr_updated_sn)
-	if(sn_to_panel_map[L->col_to_sn_map[L->sn_struct[K][i]]]==updated_panel){
-	  curr_updated_sn = L->col_to_sn_map[L->sn_struct[K][i]];
-	  if(!exist_upd) first_row = i;
-	  row_count++;
-	  exist_upd = 1;
-	  if( i==sn_up_size_child-1)
-	    if(exist_upd){ 
-	      if(!(L->up_blocks)[K]){
-		(L->up_blocks)[K] = (taucs_datatype*)taucs_calloc(((L->sn_up_size)[K]-(L->sn_size)[K])*((L->sn_size)[K]),sizeof(taucs_datatype));
-		taucs_io_read(handle,IO_BASE+L->n_sn+2*K+1,
-			      (L->sn_up_size)[K]-(L->sn_size)[K],
-			      (L->sn_size)[K] ,
-			      TAUCS_CORE_DATATYPE,(L->up_blocks)[K]);
-	      }
-	      LDA = LDB = (L->sn_up_size)[K]-(L->sn_size)[K];
-	      M  = sn_up_size_child - first_row ;
-	      LDC =  M;
-	      N  = row_count; 
-	      PK = L->sn_size[K];    
-	      
-   
-	      /* The GEMM code computes on the upper triangle of the trapezoidal
-		 matrix, which is junk. */
-	      /*
-	      taucs_gemm ("No Conjugate",
-		     "Conjugate",
-		     &M,&N,&PK,
-		     &taucs_one_const,
-		     &(L->up_blocks[K][first_row-sn_size_child]),&LDA,
-		     &(L->up_blocks[K][first_row-sn_size_child]),&LDB,
-		     &taucs_zero_const,
-		     dense_update_matrix,&LDC);
-	      */
-
-	      /* This is the HERK+GEMM fix by Elad */
-	      taucs_herk ("Lower",
-			  "No Conjugate",
-			  &N,&PK,
-			  &taucs_one_real_const,
-			  &(L->up_blocks[K][first_row-sn_size_child]),&LDA,
-			  &taucs_zero_real_const,
-			  dense_update_matrix,&LDC);
-	      
-	      if(M-N > 0)
-		{
-		  int newM = M - N;
-		  
-		  taucs_gemm ("No Conjugate",
-			      "Conjugate",
-			      &newM,&N,&PK,
-			      &taucs_one_const,
-			      &(L->up_blocks[K][first_row-sn_size_child+N]),&LDA,
-			      &(L->up_blocks[K][first_row-sn_size_child]),&LDB,
-			      &taucs_zero_const,
-			      dense_update_matrix+N,&LDC);
-		}
-	      /* end of GEMM/HERK+GEMM fix */ 
-	      
-	      if(!(L->sn_blocks)[curr_updated_sn])
-		(L->sn_blocks)[curr_updated_sn] = 
-		  (taucs_datatype*)taucs_calloc(((L->sn_size)[curr_updated_sn])*((L->sn_size)[curr_updated_sn]),sizeof(taucs_datatype));
+    /* everything the updates touch must be in memory before they start */
+    for (t=0; t<ntargets; t++) {
+      sn = ws->targets[t].sn;
+
+      if(!(L->sn_blocks)[sn])
+	(L->sn_blocks)[sn] = 
+	  (taucs_datatype*)taucs_calloc(((L->sn_size)[sn])*((L->sn_size)[sn]),
+					sizeof(taucs_datatype));
     
-	      if(L->sn_up_size[curr_updated_sn]-L->sn_size[curr_updated_sn]>0)
-		if(!(L->up_blocks)[curr_updated_sn]) 
-		  (L->up_blocks)[curr_updated_sn] = (taucs_datatype*)taucs_calloc(((L->sn_up_size)[curr_updated_sn]-(L->sn_size)[curr_updated_sn]) *((L->sn_size)[curr_updated_sn]),sizeof(taucs_datatype));
-	      
-	      if(!L->sn_struct[curr_updated_sn]){
-		L->sn_struct[curr_updated_sn] = (int*)taucs_malloc((L->sn_up_size)[curr_updated_sn]*sizeof(int));
-		taucs_io_read(handle,IO_BASE+curr_updated_sn,1,(L->sn_up_size)[curr_updated_sn],TAUCS_INT,L->sn_struct[curr_updated_sn]);
-	      }
-
-	      for(ii=0;ii<L->sn_size[curr_updated_sn];ii++) {
-		bitmap[L->sn_struct[curr_updated_sn][ii]]=ii+1;
-	      }
-
-	      for(ii=L->sn_size[curr_updated_sn];ii<L->sn_up_size[curr_updated_sn];ii++){
-	    bitmap[L->sn_struct[curr_updated_sn][ii]] = ii-L->sn_size[curr_updated_sn]+1;
-	      }
-	  assert((double)row_count*(double)LDC < 2048.0*1024.0*1024.0);
-	      for(j=0;j<row_count;j++)
-		for(ir=j;ir<row_count;ir++){
-		  /*L->sn_blocks[curr_updated_sn][(bitmap[L->sn_struct[K][first_row+j]]-1)*L->sn_size[curr_updated_sn]+(bitmap[L->sn_struct[K][first_row+ir]]-1)] -= dense_update_matrix[j*LDC+ir];*/
-		  L->sn_blocks[curr_updated_sn][(bitmap[L->sn_struct[K][first_row+j]]-1)*L->sn_size[curr_updated_sn]+(bitmap[L->sn_struct[K][first_row+ir]]-1)] =
-		    taucs_sub(L->sn_blocks[curr_updated_sn][(bitmap[L->sn_struct[K][first_row+j]]-1)*L->sn_size[curr_updated_sn]+(bitmap[L->sn_struct[K][first_row+ir]]-1)] , dense_update_matrix[j*LDC+ir]);
-
-		  /* for find overflow */
-		  assert((double)(bitmap[L->sn_struct[K][first_row+j]]-1)*(double)L->sn_size[curr_updated_sn] < 2048.0*1024.0*1024.0);
-		}
-
-	      for(j=0;j<row_count;j++)
-		for(ir=row_count;ir<M;ir++){
-
-		  /*L->up_blocks[curr_updated_sn][(bitmap[L->sn_struct[K][first_row+j]]-1)*(L->sn_up_size[curr_updated_sn]-L->sn_size[curr_updated_sn])+(bitmap[L->sn_struct[K][ir+first_row]]-1)] -= dense_update_matrix[j*LDC+ir];*/
-
-		  L->up_blocks[curr_updated_sn][(bitmap[L->sn_struct[K][first_row+j]]-1)*(L->sn_up_size[curr_updated_sn]-L->sn_size[curr_updated_sn])+(bitmap[L->sn_struct[K][ir+first_row]]-1)] =
-		    taucs_sub(L->up_blocks[curr_updated_sn][(bitmap[L->sn_struct[K][first_row+j]]-1)*(L->sn_up_size[curr_updated_sn]-L->sn_size[curr_updated_sn])+(bitmap[L->sn_struct[K][ir+first_row]]-1)] , dense_update_matrix[j*LDC+ir]);
-
-		  /* for find overflow */
-		  assert((double)(bitmap[L->sn_struct[K][first_row+j]]-1)*(double)(L->sn_up_size[curr_updated_sn]-L->sn_size[curr_updated_sn]) < 2048.0*1024.0*1024.0);
-		}	
-	      for(ii=0;ii<L->sn_up_size[curr_updated_sn];ii++)
-		bitmap[L->sn_struct[curr_updated_sn][ii]]=0;
-
-	      exist_upd = 0;
-	      row_count = 0;
-
-	    }
-	}
-      
+      if(L->sn_up_size[sn]-L->sn_size[sn]>0)
+	if(!(L->up_blocks)[sn]) 
+	  (L->up_blocks)[sn] = (taucs_datatype*)taucs_calloc(((L->sn_up_size)[sn]-(L->sn_size)[sn]) *((L->sn_size)[sn]),sizeof(taucs_datatype));
+
+      if(!L->sn_struct[sn]){
+	L->sn_struct[sn] = (int*)taucs_malloc((L->sn_up_size)[sn]*sizeof(int));
+	taucs_io_read(handle,
+		      IO_BASE+sn,
+		      1,(L->sn_up_size)[sn],
+		      TAUCS_INT,L->sn_struct[sn]);
+      }
     }
-    
+
+    ooc_panel_apply_updates(J,K,ntargets,next,sn_to_panel_map,ws,handle,L);
   }
 
   /* free update sn from memory */
@@ -2278,13 +3566,12 @@ recursive_leftlooking_supernodal_update_panel_ooc(int J,int K,
   taucs_free( L->sn_struct[K]);
   L->sn_struct[K] = NULL;
 
-  if(first_row&&sn_to_panel_map[J]!=sn_to_panel_map[K]){   
-  
+  if(recurse){   
     for (child = first_child[K]; child != -1; child = next_child[child]) {
       recursive_leftlooking_supernodal_update_panel_ooc(J,child,
-							bitmap,
+							next_child[child] != -1 ? next_child[child] : after,
+							ws,
 							sn_to_panel_map,
-							dense_update_matrix,
 							handle,A,L);
     }
   } 
@@ -2301,14 +3588,14 @@ recursive_leftlooking_supernodal_factor_panel_llt_ooc
  int* sn_in_core,
  int* sn_to_panel_map,
  int*  panel_max_size,
+ ooc_panel_workspace* ws,
  taucs_io_handle* handle,
  taucs_ccs_matrix* A,
  supernodal_factor_matrix* L)
 {
-  int  child;
+  int  child,after,t;
   int* first_child   = L->first_child;
   int* next_child    = L->next_child;
-  taucs_datatype* dense_update_matrix = NULL;
   
   for (child = first_child[sn]; child != -1; child = next_child[child]) {
     if(sn_in_core[child]){
@@ -2322,7 +3609,7 @@ recursive_leftlooking_supernodal_factor_panel_llt_ooc
       if (recursive_leftlooking_supernodal_factor_llt(child,
 						      FALSE,
 						      map,
-						      A,L)) {
+						      A,ws->stream,L)) {
 	/* failure */
 	return -1;
       }
@@ -2342,6 +3629,7 @@ recursive_leftlooking_supernodal_factor_panel_llt_ooc
 								sn_in_core,
 								sn_to_panel_map,
 								panel_max_size,
+								ws,
 								handle,
 								A,L)) {
 	/* failure */
@@ -2363,21 +3651,26 @@ recursive_leftlooking_supernodal_factor_panel_llt_ooc
       taucs_io_read(handle,IO_BASE+sn,1,(L->sn_up_size)[sn],TAUCS_INT,L->sn_struct[sn]);
     }
 
-    if (!dense_update_matrix) 
-      dense_update_matrix = (taucs_datatype*) taucs_calloc(panel_max_size[sn_to_panel_map[sn]],sizeof(taucs_datatype));
+    for (t=0; t<ws->nproc; t++)
+      if (!(ws->dense)[t]) 
+	(ws->dense)[t] = (taucs_datatype*) taucs_calloc(panel_max_size[sn_to_panel_map[sn]],sizeof(taucs_datatype));
 
     for (child = first_child[sn]; child != -1; child = next_child[child]) {
-      if(sn_to_panel_map[sn]!=sn_to_panel_map[child])
-	recursive_leftlooking_supernodal_update_panel_ooc(sn,child,
-							  map,
+      if(sn_to_panel_map[sn]!=sn_to_panel_map[child]) {
+	for (after = next_child[child]; 
+	     after != -1 && sn_to_panel_map[sn]==sn_to_panel_map[after]; 
+	     after = next_child[after]);
+	recursive_leftlooking_supernodal_update_panel_ooc(sn,child,after,
+							  ws,
 							  sn_to_panel_map,
-							  dense_update_matrix,
 							  handle,A,L);
+      }
     }
 
     if (leftlooking_supernodal_front_factor(sn,
 					    map,
 					    A,
+					    ws->stream,
 					    L)) {
       /* nonpositive pivot */
       return -1;
@@ -2393,12 +3686,14 @@ recursive_leftlooking_supernodal_factor_panel_llt_ooc
  
     
     if(sn_to_panel_map[sn]==sn_to_panel_map[father_sn])
-      recursive_leftlooking_supernodal_update_panel_ooc(father_sn,sn,
-							map,
+      recursive_leftlooking_supernodal_update_panel_ooc(father_sn,sn,-1,
+							ws,
 							sn_to_panel_map,
-							dense_update_matrix,
 							handle,A,L);
-    taucs_free(dense_update_matrix);
+    for (t=0; t<ws->nproc; t++) {
+      taucs_free((ws->dense)[t]);
+      (ws->dense)[t] = NULL;
+    }
     taucs_free((L->sn_blocks)[sn]);
     taucs_free((L->up_blocks)[sn]); 
     taucs_free((L->sn_struct)[sn]);
@@ -2413,6 +3708,22 @@ recursive_leftlooking_supernodal_factor_panel_llt_ooc
 int taucs_dtl(ooc_factor_llt)(taucs_ccs_matrix* A, 
 			      taucs_io_handle* handle,
 			      double memory)
+{
+  return taucs_dtl(ooc_factor_llt_parallel)(A,handle,memory,1);
+}
+
+/*
+  with a stream, A is the stream's window: the analysis and the
+  factorization read the columns of A from the file, and the
+  window and the stream's vectors are charged to the overhead
+*/
+
+static int 
+ooc_factor_llt_driver(taucs_ccs_matrix* A, 
+		      ooc_ccs_stream* stream,
+		      taucs_io_handle* handle,
+		      double memory,
+		      int nproc)
 {
   supernodal_factor_matrix* L;
   int i;
@@ -2422,6 +3733,10 @@ int taucs_dtl(ooc_factor_llt)(taucs_ccs_matrix* A,
   int* panel_max_size;
   int n_pn=0;
   double wtime, ctime;
+  ooc_panel_workspace ws;
+  double memory_parallel = 0.0;
+  double predicted_read = 0.0;
+  double bytes_read;
 
   /*
   int j,ip,jp;
@@ -2440,6 +3755,11 @@ int taucs_dtl(ooc_factor_llt)(taucs_ccs_matrix* A,
     2.0*(double)((A->n)*sizeof(int)) + /* integer vectors in program  */
     4.0*3.0*(double)((A->n)*sizeof(int));  /* singlefile matrix arrays */
 
+  if (stream)
+    memory_overhead += 
+      stream->budget +                      /* window of columns */
+      6.0*(double)((A->n+1)*sizeof(int));   /* vectors of the stream */
+
   taucs_printf("\t\tOOC memory overhead bound %.0lf MB (out of %.0lf MB available)\n",
 	       memory_overhead/1048576.0,memory/1048576.0);
 
@@ -2464,11 +3784,21 @@ int taucs_dtl(ooc_factor_llt)(taucs_ccs_matrix* A,
   */
   taucs_io_append(handle,5,1,1,TAUCS_INT,&(A->n));
 
-  taucs_ccs_ooc_symbolic_elimination(A,L,
-				     TRUE /* sort row indices */,
-				     TRUE /* return col_to_sn_map */,
-				     (memory - memory_overhead)/3.0,
-				     ooc_sn_struct_handler,handle);
+  if (taucs_ccs_ooc_symbolic_elimination(A,L,
+					 TRUE /* sort row indices */,
+					 TRUE /* return col_to_sn_map */,
+					 (memory - memory_overhead)/3.0,
+					 ooc_sn_struct_handler,handle,
+					 stream)) {
+    ooc_supernodal_factor_free(L);
+    return -1;
+  }
+
+  /* from now on the factorization needs the values too */
+  if (stream) {
+    stream->with_values = TRUE;
+    ooc_stream_invalidate(stream);
+  }
   
   wtime = taucs_wtime()-wtime;
   ctime = taucs_ctime()-ctime;
@@ -2483,8 +3813,43 @@ int taucs_dtl(ooc_factor_llt)(taucs_ccs_matrix* A,
     2.0*(double)((L->n_sn)*sizeof(int)) + /* integer vectors in program  */
     4.0*3.0*(double)((L->n_sn)*sizeof(int));  /* singlefile matrix arrays */
 
+  if (stream)
+    memory_overhead += 
+      stream->budget +                      /* window of columns */
+      6.0*(double)((A->n+1)*sizeof(int));   /* vectors of the stream */
+
   taucs_printf("\t\tOOC actual memory overhead %.0lf MB (out of %.0lf MB available)\n",
 	       memory_overhead/1048576.0,memory/1048576.0);
+
+  /* every extra thread needs a bitmap and a dense update matrix,
+     and the read-ahead needs room for one more update block; the
+     panel planner charges the buffers, the bitmaps are overhead */
+
+#ifndef TAUCS_CONFIG_PFUNC
+  if (nproc > 1) 
+    taucs_printf("\t\tOOC Supernodal Left-Looking: PFUNC not configured, using 1 thread\n");
+  nproc = 1;
+#endif
+  if (nproc < 1) nproc = 1;
+
+  if (nproc > 1) {
+    double max_sn_mem = 0.0;
+    for (i=0; i<L->n_sn; i++)
+      if ((double)L->sn_up_size[i]*(double)L->sn_size[i] > max_sn_mem)
+	max_sn_mem = (double)L->sn_up_size[i]*(double)L->sn_size[i];
+
+    memory_parallel = (double)(nproc-1)*(double)((A->n+1)*sizeof(int));
+
+    /* not worth halving the panels for */
+    if (memory_parallel + (double)nproc*max_sn_mem*(double)sizeof(taucs_datatype)
+	> (memory - memory_overhead)/2.0) {
+      taucs_printf("\t\tOOC Supernodal Left-Looking: not enough memory for %d threads, using 1\n",
+		   nproc);
+      nproc = 1;
+      memory_parallel = 0.0;
+    }
+    memory_overhead += memory_parallel;
+  }
  
   wtime = taucs_wtime();
   ctime = taucs_ctime();
@@ -2521,65 +3886,24 @@ int taucs_dtl(ooc_factor_llt)(taucs_ccs_matrix* A,
 
   wtime = taucs_wtime();
   ctime = taucs_ctime();
-  if(recursive_compute_supernodes_ll_in_core(L->n_sn,
-					     TRUE,
-					     (memory - memory_overhead)/3.0,
-					     sn_in_core,
-					     L)<0.0) {
-    ooc_supernodal_factor_free(L);
-    taucs_free(sn_in_core);
-    taucs_free(sn_to_panel_map);  
-    taucs_free(map);
-    return -1;
-  }
-  
- /*  if(recursive_panelize_ooc_supernodes(L->n_sn,
-				       TRUE,
-				       (memory - memory_overhead)/3.0,
-				       (memory - memory_overhead)/3.0,
-				       &n_pn,
-				       sn_in_core,
-				       sn_to_panel_map,
-				       L)<0.0){
-    ooc_supernodal_factor_free(L);
-    taucs_free(sn_in_core);
-    taucs_free(sn_to_panel_map);  
-    taucs_free(map);
-    return -1;
-    }*/
- 
-  /*taucs_printf("\t\tOOC Supernodal Left-Looking: panel-is-paged\n",n_pn);
 
-  if(recursive_smart_panelize_ooc_supernodes(L->n_sn,
-					     TRUE,
-					     (memory - memory_overhead)/3.0,
-					     &n_pn,
-					     sn_in_core,
-					     sn_to_panel_map,
-					     L)<0.0){*/
-	 if(recursive_panelize_ooc_supernodes(L->n_sn,
-					 TRUE,
-					 (memory - memory_overhead)/3.0,
-					 (memory - memory_overhead)/3.0,
-					 &n_pn,
-					 sn_in_core,
-					 sn_to_panel_map,
-					 L)<0.0){
+  /* the panel planner also accounts for the update buffers */
+  n_pn = ooc_plan_panels(memory - memory_overhead,nproc,
+			 sn_in_core,sn_to_panel_map,&predicted_read,
+			 handle,L);
+  if (n_pn < 0) {
     ooc_supernodal_factor_free(L);
     taucs_free(sn_in_core);
     taucs_free(sn_to_panel_map);  
     taucs_free(map);
     return -1;
-    }
-
-  /* it will be at least one panel even empty */
-  n_pn++; 
+  }
 
   /*for(i=0;i<L->n_sn;i++){
     taucs_printf("sn_in_core[%d] = %d\n",i,sn_in_core[i]);
     taucs_printf("sn_to_panel_map[%d] = %d\n",i,sn_to_panel_map[i]);
     }*/
-  taucs_printf("\t\tOOC Supernodal Left-Looking: %d panels\n",n_pn);
+  taucs_printf("\t\tOOC Supernodal Left-Looking: %d panels, %d threads\n",n_pn,nproc);
   /* compute max dense matrix size for every panel */
   panel_max_size = (int*)taucs_calloc(n_pn,sizeof(int));
   for(i=0;i<L->n_sn;i++){
@@ -2608,6 +3932,19 @@ int taucs_dtl(ooc_factor_llt)(taucs_ccs_matrix* A,
   ctime = taucs_ctime();
 
 
+  if (ooc_panel_workspace_create(&ws,nproc,map,A,L)) {
+    ooc_panel_workspace_free(&ws);
+    ooc_supernodal_factor_free(L);
+    taucs_free(panel_max_size);
+    taucs_free(sn_in_core);
+    taucs_free(sn_to_panel_map);  
+    taucs_free(map);
+    return -1;
+  }
+  ws.stream = stream;
+
+  bytes_read = handle->bytes_read;
+
   if (recursive_leftlooking_supernodal_factor_panel_llt_ooc(L->n_sn,
 							    L->n_sn,  
 							    TRUE, 
@@ -2615,14 +3952,19 @@ int taucs_dtl(ooc_factor_llt)(taucs_ccs_matrix* A,
 							    sn_in_core,
 							    sn_to_panel_map,
 							    panel_max_size,
+							    &ws,
 							    handle,
 							    A,L)) {
+    ooc_panel_workspace_free(&ws);
     ooc_supernodal_factor_free(L);
     taucs_free(map);
     return -1;
   }
+  ooc_panel_workspace_free(&ws);
  
  taucs_printf("\t\tOOC Supernodal Left-Looking:\n");
+ taucs_printf("\t\t\tpredicted factor read volume (bytes) = %.0f \n",predicted_read);
+ taucs_printf("\t\t\tactual factor read volume (bytes)    = %.0f \n",handle->bytes_read - bytes_read);
  taucs_printf("\t\t\tread count           = %.0f \n",handle->nreads);
  taucs_printf("\t\t\tread volume (bytes)  = %.2e \n",handle->bytes_read);
  taucs_printf("\t\t\tread time (seconds)  = %.0f \n",handle->read_time);
@@ -2655,6 +3997,44 @@ int taucs_dtl(ooc_factor_llt)(taucs_ccs_matrix* A,
   return 0;
 }
 
+int taucs_dtl(ooc_factor_llt_parallel)(taucs_ccs_matrix* A, 
+				       taucs_io_handle* handle,
+				       double memory,
+				       int nproc)
+{
+  return ooc_factor_llt_driver(A,NULL,handle,memory,nproc);
+}
+
+/*
+  The matrix is in a file written by taucs_ccs_write_binary, 
+  already ordered and with its lower triangle represented; it is
+  never loaded as a whole. An eighth of the memory (at most 1GB)
+  holds a window of its columns.
+*/
+
+int taucs_dtl(ooc_factor_llt_file)(char* filename, 
+				   taucs_io_handle* handle,
+				   double memory,
+				   int nproc)
+{
+  ooc_ccs_stream* stream;
+  int rc;
+
+  stream = ooc_stream_open(filename,memory/8.0);
+  if (!stream) return -1;
+
+  taucs_printf("\t\tOOC Supernodal Left-Looking: streaming %s, %d columns, %.0f nonzeros\n",
+	       filename,stream->n,(double) stream->colptr[stream->n]);
+
+  rc = ooc_factor_llt_driver(&(stream->window),stream,handle,memory,nproc);
+  if (rc == 0 && stream->error) rc = -1;
+
+  taucs_printf("\t\tStreamed window: %d refills\n",stream->fills);
+
+  ooc_stream_close(stream);
+  return rc;
+}
+
 /*************************************************************/
 /* SAME ROUTINE, WITH CHOICE OF PANELIZATION FOR TESTING     */
 /*************************************************************/
@@ -2672,6 +4052,8 @@ int taucs_dtl(ooc_factor_llt_panelchoice)(taucs_ccs_matrix* A,
   int* panel_max_size;
   int n_pn=0;
   double wtime, ctime;
+  ooc_panel_workspace ws;
+  double predicted_read, bytes_read;
   /*
   int j,ip,jp;
   int sn,p;
@@ -2721,7 +4103,8 @@ int taucs_dtl(ooc_factor_llt_panelchoice)(taucs_ccs_matrix* A,
 				     TRUE /* sort row indices */,
 				     TRUE /* return col_to_sn_map */,
 				     (memory - memory_overhead)/3.0,
-				     ooc_sn_struct_handler,handle);
+				     ooc_sn_struct_handler,handle,
+				     NULL /* A is in memory */);
   
   taucs_printf("*** 4\n");
 
@@ -2875,6 +4258,19 @@ int taucs_dtl(ooc_factor_llt_panelchoice)(taucs_ccs_matrix* A,
   ctime = taucs_ctime();
 
 
+  if (ooc_panel_workspace_create(&ws,1,map,A,L)) {
+    ooc_panel_workspace_free(&ws);
+    ooc_supernodal_factor_free(L);
+    taucs_free(panel_max_size);
+    taucs_free(sn_in_core);
+    taucs_free(sn_to_panel_map);  
+    taucs_free(map);
+    return -1;
+  }
+
+  predicted_read = ooc_plan_predict(sn_to_panel_map,handle,L);
+  bytes_read = handle->bytes_read;
+
   if (recursive_leftlooking_supernodal_factor_panel_llt_ooc(L->n_sn,
 							    L->n_sn,  
 							    TRUE, 
@@ -2882,14 +4278,19 @@ int taucs_dtl(ooc_factor_llt_panelchoice)(taucs_ccs_matrix* A,
 							    sn_in_core,
 							    sn_to_panel_map,
 							    panel_max_size,
+							    &ws,
 							    handle,
 							    A,L)) {
+    ooc_panel_workspace_free(&ws);
     ooc_supernodal_factor_free(L);
     taucs_free(map);
     return -1;
   }
+  ooc_panel_workspace_free(&ws);
  
  taucs_printf("\t\tOOC Supernodal Left-Looking:\n");
+ taucs_printf("\t\t\tpredicted factor read volume (bytes) = %.0f \n",predicted_read);
+ taucs_printf("\t\t\tactual factor read volume (bytes)    = %.0f \n",handle->bytes_read - bytes_read);
  taucs_printf("\t\t\tread count           = %.0f \n",handle->nreads);
  taucs_printf("\t\t\tread volume (bytes)  = %.2e \n",handle->bytes_read);
  taucs_printf("\t\t\tread time (seconds)  = %.0f \n",handle->read_time);
@@ -2956,6 +4357,83 @@ int taucs_ooc_factor_llt(taucs_ccs_matrix* A,
   return -1;
 }
 
+int taucs_ooc_factor_llt_parallel(taucs_ccs_matrix* A,
+				  taucs_io_handle*  L,
+				  double memory,
+				  int nproc)
+{
+#ifdef TAUCS_CONFIG_DREAL
+  if (A->flags & TAUCS_DOUBLE)
+    return taucs_dooc_factor_llt_parallel(A,L,memory,nproc);
+#endif
+
+#ifdef TAUCS_CONFIG_SREAL
+  if (A->flags & TAUCS_SINGLE)
+    return taucs_sooc_factor_llt_parallel(A,L,memory,nproc);
+#endif
+
+#ifdef TAUCS_CONFIG_DCOMPLEX
+  if (A->flags & TAUCS_DCOMPLEX)
+    return taucs_zooc_factor_llt_parallel(A,L,memory,nproc);
+#endif
+
+#ifdef TAUCS_CONFIG_SCOMPLEX
+  if (A->flags & TAUCS_SCOMPLEX)
+    return taucs_cooc_factor_llt_parallel(A,L,memory,nproc);
+#endif
+
+  assert(0);
+  return -1;
+}
+
+int taucs_ooc_factor_llt_file(char* filename,
+			      taucs_io_handle*  L,
+			      double memory,
+			      int nproc)
+{
+  int f;
+  int header[3]; /* m, n, flags */
+
+#ifdef OSTYPE_win32
+  f = open(filename,_O_RDONLY | _O_BINARY);
+#else
+  f = open(filename,O_RDONLY);
+#endif
+  if (f == -1) {
+    taucs_printf("taucs_ooc_factor_llt_file: could not open %s\n",filename);
+    return -1;
+  }
+  if (read(f,header,sizeof(header)) != sizeof(header)) {
+    taucs_printf("taucs_ooc_factor_llt_file: could not read the header of %s\n",filename);
+    close(f);
+    return -1;
+  }
+  close(f);
+
+#ifdef TAUCS_CONFIG_DREAL
+  if (header[2] & TAUCS_DOUBLE)
+    return taucs_dooc_factor_llt_file(filename,L,memory,nproc);
+#endif
+
+#ifdef TAUCS_CONFIG_SREAL
+  if (header[2] & TAUCS_SINGLE)
+    return taucs_sooc_factor_llt_file(filename,L,memory,nproc);
+#endif
+
+#ifdef TAUCS_CONFIG_DCOMPLEX
+  if (header[2] & TAUCS_DCOMPLEX)
+    return taucs_zooc_factor_llt_file(filename,L,memory,nproc);
+#endif
+
+#ifdef TAUCS_CONFIG_SCOMPLEX
+  if (header[2] & TAUCS_SCOMPLEX)
+    return taucs_cooc_factor_llt_file(filename,L,memory,nproc);
+#endif
+
+  taucs_printf("taucs_ooc_factor_llt_file: unsupported data type in %s\n",filename);
+  return -1;
+}
+
 int taucs_ooc_factor_llt_panelchoice(taucs_ccs_matrix* A,
 				     taucs_io_handle*  L,
 				     double memory,
@@ -3024,6 +4502,50 @@ int taucs_ooc_solve_llt (void* L /* actual type: taucs_io_handle* */,
   return -1;
 }
 
+int taucs_ooc_solve_llt_many_cached(void* L /* actual type: taucs_io_handle* */,
+				    int n,
+				    void* X, int ld_X,
+				    void* B, int ld_B,
+				    double memory)
+{
+  int flags;
+
+  taucs_io_read((taucs_io_handle*)L,
+		6,1,1,TAUCS_INT,
+		&flags);
+
+#ifdef TAUCS_CONFIG_DREAL
+  if (flags & TAUCS_DOUBLE)
+    return taucs_dooc_solve_llt_many_cached(L,n,X,ld_X,B,ld_B,memory);
+#endif
+
+#ifdef TAUCS_CONFIG_SREAL
+  if (flags & TAUCS_SINGLE)
+    return taucs_sooc_solve_llt_many_cached(L,n,X,ld_X,B,ld_B,memory);
+#endif
+
+#ifdef TAUCS_CONFIG_DCOMPLEX
+  if (flags & TAUCS_DCOMPLEX)
+    return taucs_zooc_solve_llt_many_cached(L,n,X,ld_X,B,ld_B,memory);
+#endif
+
+#ifdef TAUCS_CONFIG_SCOMPLEX
+  if (flags & TAUCS_SCOMPLEX)
+    return taucs_cooc_solve_llt_many_cached(L,n,X,ld_X,B,ld_B,memory);
+#endif
+
+  assert(0);
+  return -1;
+}
+
+int taucs_ooc_solve_llt_many(void* L /* actual type: taucs_io_handle* */,
+			     int n,
+			     void* X, int ld_X,
+			     void* B, int ld_B)
+{
+  return taucs_ooc_solve_llt_many_cached(L,n,X,ld_X,B,ld_B,0.0);
+}
+
 #endif /* TAUCS_CORE_GENRAL */
 
 /*************************************************************/
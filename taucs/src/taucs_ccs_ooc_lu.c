@@ -23,6 +23,10 @@
 
 #include "taucs.h"
 
+#ifdef TAUCS_CONFIG_PFUNC
+#include "pfunc.h"
+#endif
+
 #define HEADER_NROWS   0
 #define HEADER_NCOLS   1
 #define HEADER_FLAGS   2
@@ -48,7 +52,129 @@
 
 #define iabs(x) ((x) > 0 ? (x) : (-(x)))
 
-static double remaining_memory;
+/*
+  All the state of one out-of-core LU factorization lives in this
+  context, so concurrent factorizations do not share any file-scope
+  variables. taucs_ooc_factor_lu allocates it on its stack.
+*/
+
+typedef struct {
+  double remaining_memory;
+  int    nproc;            /* threads for the dense supernode updates */
+
+  /* symmetric skeleton graph */
+  char skel_basename[256];
+  int* skel_buffer;
+  int  skel_buffer_size; /* counted in PAIRS of integers */
+  int  skel_buffer_ptr;  /* index into PAIRS of integers */
+  int  skel_outfiles;
+  int  skel_infiles;
+  int  skel_outfile;
+  char skel_inphase;
+  char skel_outphase;
+  int  skel_get_lastcol;
+  int  skel_next;
+
+  /* fill stack */
+  int    stack_allocated;
+  int    stack_buffer_size;
+  int*   stack_buffer;
+  int    stack_files;
+  char   stack_basename[256];
+  int    stack_buffer_ptr;
+  int    stack_top;
+  double stack_size;
+  double stack_max_size;
+
+  /* row lists */
+  int* rowlists_head;   /* one head per row */
+  int* rowlists_colind;
+  int* rowlists_next;
+  int* rowlists_prev;
+  int  rowlists_size;
+  int  rowlists_freehead;
+  int  rowlists_used;   /* entries not on the freelist */
+
+  taucs_datatype* spa;
+  char*           spamap;
+
+  int oocsp_spcol_n1;
+  int oocsp_spcol_n2;
+
+  double time_total;
+
+#ifdef DETAILED_TIMING
+  double flops_extra;
+  double flops_dense;
+
+  double time_colcol;
+  double time_colcol_1;
+  double time_colcol_2;
+  double time_factor;
+  double time_scatter;
+  double time_gather;
+  double time_append;
+  double time_read;
+  double time_snode_tmp;
+  double time_snode_1;
+  double time_snode_2;
+  double time_snode_21;
+  double time_snode_3;
+  double time_snode_4;
+  double time_snode_detect;
+  double time_snode_prepare;
+  double time_snode_dense;
+
+  double bytes_read;
+  double bytes_appended;
+  double col_ooc_updates;
+  double col_read;
+
+  double flops;
+  double scatters;
+  double gathers;
+  double rowlist_ops;
+  double num_heap_ops;
+#endif /* DETAILED_TIMING */
+} ooc_lu_context;
+
+static void ooc_lu_context_init(ooc_lu_context* ctx, double memory)
+{
+  memset(ctx,0,sizeof(ooc_lu_context));
+
+  ctx->remaining_memory  = memory;
+  ctx->nproc             = 1;
+
+  ctx->skel_buffer       = NULL;
+  ctx->skel_buffer_size  = -1;
+  ctx->skel_buffer_ptr   = -1;
+  ctx->skel_outfiles     = -1;
+  ctx->skel_infiles      = -1;
+  ctx->skel_outfile      = -1;
+  ctx->skel_get_lastcol  = -1;
+  ctx->skel_next         = -1;
+
+  ctx->stack_allocated   = 0; /* maybe 1 would be better here, causing a fault
+                                 instead of a memory leak in case of a bug */
+  ctx->stack_buffer_size = -1;
+  ctx->stack_buffer      = NULL;
+  ctx->stack_files       = -1;
+  ctx->stack_buffer_ptr  = -1;
+  ctx->stack_top         = -1;
+  ctx->stack_size        = -1;
+  ctx->stack_max_size    = -1;
+
+  ctx->rowlists_head     = NULL;
+  ctx->rowlists_colind   = NULL;
+  ctx->rowlists_next     = NULL;
+  ctx->rowlists_prev     = NULL;
+  ctx->rowlists_size     = -1;
+  ctx->rowlists_freehead = -1;
+  ctx->rowlists_used     = 0;
+
+  ctx->spa               = NULL;
+  ctx->spamap            = NULL;
+}
 
 /*********************************************************/
 /* NEW IO ROUTINES                                       */
@@ -289,20 +415,6 @@ static void heap_extract_min(int* heap, int* heapsize, int* i, int* j, int* k)
 
 /* SYMMETRIC SKELETON GRAPH OPERATIONS */
 
-static char skel_basename[256];
-static int* skel_buffer = NULL;
-static int  skel_buffer_size = -1; /* counted in PAIRS of integers */
-static int  skel_buffer_ptr  = -1; /* index into PAIRS of integers */
-static int  skel_outfiles    = -1;
-static int  skel_infiles     = -1;
-static int  skel_outfile     = -1;
-
-static char skel_inphase     = 0;
-static char skel_outphase    = 0;
-
-static int skel_get_lastcol  = -1;
-static int skel_next         = -1;
-
 static int skel_compare(const void* e1, const void* e2) 
 {
   /* we sort according to columns */
@@ -328,9 +440,9 @@ static int skel_compare(const void* e1, const void* e2)
   return 0;
 }
 
-static int skel_init(char* basename)
+static int skel_init(ooc_lu_context* ctx, char* basename)
 {
-  sprintf(skel_basename,"%s.ssort",basename);
+  sprintf(ctx->skel_basename,"%s.ssort",basename);
 
   /* adjust remaining memory.
      We allocate 2 io buffers for the sort phase, plus an array
@@ -339,30 +451,30 @@ static int skel_init(char* basename)
      stack phase, but we do not free the skel buffer first,
      so 3 io buffers is a conservative estimate. */
 
-  remaining_memory -= (double) (3*get_iobufsize());
+  ctx->remaining_memory -= (double) (3*get_iobufsize());
 
   /* debugging */
-  skel_buffer_size = (int)(remaining_memory) / (2*sizeof(int));
+  ctx->skel_buffer_size = (int)(ctx->remaining_memory) / (2*sizeof(int));
 
   /*EF_FILL=0x00;*/
-  skel_buffer      = (int*)taucs_malloc(skel_buffer_size * 2*sizeof(int));
-  if (!skel_buffer) return TAUCS_ERROR_NOMEM;
+  ctx->skel_buffer      = (int*)taucs_malloc(ctx->skel_buffer_size * 2*sizeof(int));
+  if (!ctx->skel_buffer) return TAUCS_ERROR_NOMEM;
 
 
-  skel_buffer_ptr  = 0;
-  skel_outfiles    = 0;
+  ctx->skel_buffer_ptr  = 0;
+  ctx->skel_outfiles    = 0;
 
-  skel_outphase = 'e';
-  skel_inphase  = 'o';
+  ctx->skel_outphase = 'e';
+  ctx->skel_inphase  = 'o';
 
-  skel_get_lastcol = -1;
-  skel_next = 0;
-  skel_outfile = -1;
+  ctx->skel_get_lastcol = -1;
+  ctx->skel_next = 0;
+  ctx->skel_outfile = -1;
 
   return TAUCS_SUCCESS;
 }
 
-static void skel_finalize()
+static void skel_finalize(ooc_lu_context* ctx)
 {
   int i;
 
@@ -372,25 +484,25 @@ static void skel_finalize()
      succeed. But I was not able to detect where the problem is,
      even with Electric Fence 
   */
-  for (i=0; i<2*skel_buffer_size; i++) skel_buffer[i]=0xffffffff;
-  for (i=0; i<2*skel_buffer_size; i++) skel_buffer[i]=0x0;
+  for (i=0; i<2*ctx->skel_buffer_size; i++) ctx->skel_buffer[i]=0xffffffff;
+  for (i=0; i<2*ctx->skel_buffer_size; i++) ctx->skel_buffer[i]=0x0;
 
-  taucs_free(skel_buffer); 
-  skel_buffer = NULL;
+  taucs_free(ctx->skel_buffer); 
+  ctx->skel_buffer = NULL;
 
-  remaining_memory += (double) (3*get_iobufsize());
+  ctx->remaining_memory += (double) (3*get_iobufsize());
 }
 
-static int skel_add(int i,int j) 
+static int skel_add(ooc_lu_context* ctx, int i,int j) 
 {
-  if (skel_buffer_ptr < skel_buffer_size) {
+  if (ctx->skel_buffer_ptr < ctx->skel_buffer_size) {
     /*
     assert(skel_buffer[2*skel_buffer_ptr  ]==0xcccccccc);
     assert(skel_buffer[2*skel_buffer_ptr+1]==0xcccccccc);
     */
-    skel_buffer[2*skel_buffer_ptr]   = i;
-    skel_buffer[2*skel_buffer_ptr+1] = j;
-    skel_buffer_ptr++;
+    ctx->skel_buffer[2*ctx->skel_buffer_ptr]   = i;
+    ctx->skel_buffer[2*ctx->skel_buffer_ptr+1] = j;
+    ctx->skel_buffer_ptr++;
 
     return TAUCS_SUCCESS;
   } else {
@@ -404,10 +516,10 @@ static int skel_add(int i,int j)
 
     /* SORT THIS BUFFER */
 
-    qsort(skel_buffer, skel_buffer_ptr, 2*sizeof(int), &skel_compare);
+    qsort(ctx->skel_buffer, ctx->skel_buffer_ptr, 2*sizeof(int), &skel_compare);
 
     /* WRITE OUT */
-    sprintf(fname,"%s.%c.%d",skel_basename,skel_outphase,skel_outfiles);
+    sprintf(fname,"%s.%c.%d",ctx->skel_basename,ctx->skel_outphase,ctx->skel_outfiles);
     taucs_printf("oocsp_colanalyze: Writing out skel sort buffer <%s> (3)\n",fname);
 
 #ifdef OSTYPE_win32
@@ -423,23 +535,23 @@ static int skel_add(int i,int j)
       taucs_printf("oocsp_colanalyze: could not create skel sort file\n");
       return TAUCS_ERROR_IO;
     }
-    io_size = write(file,skel_buffer,skel_buffer_ptr * 2 * sizeof(int));
-    if (io_size != skel_buffer_ptr * 2 * sizeof(int)) {
+    io_size = write(file,ctx->skel_buffer,ctx->skel_buffer_ptr * 2 * sizeof(int));
+    if (io_size != ctx->skel_buffer_ptr * 2 * sizeof(int)) {
       taucs_printf("oocsp_colanalyze: write to skel sort file failed\n");
       unlink(fname);
       return TAUCS_ERROR_IO;
     }
     close(file);
 
-    skel_outfiles++;
-    skel_buffer_ptr = 0;
+    ctx->skel_outfiles++;
+    ctx->skel_buffer_ptr = 0;
 
     taucs_printf("oocsp_colanalyze: done (using file %s)\n",fname);
     return TAUCS_SUCCESS;
   }
 }
 
-static void skel_sort_incore(int* postorder, int ncols, int* inv_postorder)
+static void skel_sort_incore(ooc_lu_context* ctx, int* postorder, int ncols, int* inv_postorder)
 {
   int natural,i,col;
 
@@ -455,17 +567,17 @@ static void skel_sort_incore(int* postorder, int ncols, int* inv_postorder)
     for (i=0; i<ncols; i++)
       inv_postorder[postorder[i]] = i;
 
-    for (i=0; i<skel_buffer_ptr; i++) {
-      col = skel_buffer[2*i+1];
-      skel_buffer[ 2*i+1 ] = inv_postorder[col];
+    for (i=0; i<ctx->skel_buffer_ptr; i++) {
+      col = ctx->skel_buffer[2*i+1];
+      ctx->skel_buffer[ 2*i+1 ] = inv_postorder[col];
     }
   }
 
-  qsort(skel_buffer, skel_buffer_ptr, 2*sizeof(int),
+  qsort(ctx->skel_buffer, ctx->skel_buffer_ptr, 2*sizeof(int),
 	&skel_compare);
 }
 
-static int skel_sort_outofcore(int* postorder, int ncols, int* inv_postorder)
+static int skel_sort_outofcore(ooc_lu_context* ctx, int* postorder, int ncols, int* inv_postorder)
 {
   int  errorcode = TAUCS_SUCCESS;
   int  natural,i,j,k,e,f;
@@ -489,13 +601,13 @@ static int skel_sort_outofcore(int* postorder, int ncols, int* inv_postorder)
   assert(0); /* debugging xxx */
 
   /* FIRST, WRITE OUT THIS BUFFER */
-  if (skel_buffer_ptr > 0) {
+  if (ctx->skel_buffer_ptr > 0) {
     /* SORT THIS BUFFER */
 
-    qsort(skel_buffer, skel_buffer_ptr, 2*sizeof(int), &skel_compare);
+    qsort(ctx->skel_buffer, ctx->skel_buffer_ptr, 2*sizeof(int), &skel_compare);
 
     /* WRITE OUT */
-    sprintf(fname,"%s.%c.%d",skel_basename,skel_outphase,skel_outfiles);
+    sprintf(fname,"%s.%c.%d",ctx->skel_basename,ctx->skel_outphase,ctx->skel_outfiles);
     taucs_printf("oocsp_colanalyze: Writing out skel sort buffer <%s> (1)\n",fname);
 #ifdef OSTYPE_win32
     mode = _O_WRONLY | _O_CREAT | _O_BINARY;
@@ -510,8 +622,8 @@ static int skel_sort_outofcore(int* postorder, int ncols, int* inv_postorder)
       errorcode = TAUCS_ERROR_IO;
       goto end;
     }
-    io_size = write(file,skel_buffer,skel_buffer_ptr * 2 * sizeof(int));
-    if (io_size != skel_buffer_ptr * 2 * sizeof(int)) {
+    io_size = write(file,ctx->skel_buffer,ctx->skel_buffer_ptr * 2 * sizeof(int));
+    if (io_size != ctx->skel_buffer_ptr * 2 * sizeof(int)) {
       taucs_printf("oocsp_colanalyze: write to skel sort file failed\n");
       unlink(fname);
       errorcode = TAUCS_ERROR_IO;
@@ -519,8 +631,8 @@ static int skel_sort_outofcore(int* postorder, int ncols, int* inv_postorder)
     }
     close(file);
 
-    skel_outfiles++;
-    skel_buffer_ptr = 0;
+    ctx->skel_outfiles++;
+    ctx->skel_buffer_ptr = 0;
   }
 
   /* DO WE NEED TO SORT THE RUNS AGAIN IN POSTORDER? */
@@ -536,8 +648,8 @@ static int skel_sort_outofcore(int* postorder, int ncols, int* inv_postorder)
     for (i=0; i<ncols; i++)
       inv_postorder[postorder[i]] = i;
 
-    for (f=0; f<skel_outfiles; f++) {
-      sprintf(fname,"%s.%c.%d",skel_basename,skel_outphase,f);
+    for (f=0; f<ctx->skel_outfiles; f++) {
+      sprintf(fname,"%s.%c.%d",ctx->skel_basename,ctx->skel_outphase,f);
       taucs_printf("oocsp_colanalyze: Resorting skel sort file <%s>\n",fname);
 #ifdef OSTYPE_win32
       mode = _O_RDWR | _O_BINARY;
@@ -551,7 +663,7 @@ static int skel_sort_outofcore(int* postorder, int ncols, int* inv_postorder)
 	goto end;
       }
       /* read the run */
-      io_size = read(file,skel_buffer,skel_buffer_size*2*sizeof(int));
+      io_size = read(file,ctx->skel_buffer,ctx->skel_buffer_size*2*sizeof(int));
       if (io_size == -1) {
 	taucs_printf("oocsp_colanalyze: read from skel sort file failed\n");
 	errorcode = TAUCS_ERROR_IO;
@@ -562,13 +674,13 @@ static int skel_sort_outofcore(int* postorder, int ncols, int* inv_postorder)
 
       /* sort again */
 
-      assert((int) io_count <= skel_buffer_size);
+      assert((int) io_count <= ctx->skel_buffer_size);
       for (i=0; i<(int)io_count; i++) {
-	j = skel_buffer[2*i+1];
-	skel_buffer[ 2*i+1 ] = inv_postorder[j];
+	j = ctx->skel_buffer[2*i+1];
+	ctx->skel_buffer[ 2*i+1 ] = inv_postorder[j];
       }
 
-      qsort(skel_buffer, io_count, 2*sizeof(int),
+      qsort(ctx->skel_buffer, io_count, 2*sizeof(int),
 	    &skel_compare);
 
       /* rewind the file and write back */
@@ -584,7 +696,7 @@ static int skel_sort_outofcore(int* postorder, int ncols, int* inv_postorder)
 	goto end;
       }
       /*      lseek(file,0,SEEK_SET);*/
-      io_size = write(file,skel_buffer,io_count * 2 * sizeof(int));
+      io_size = write(file,ctx->skel_buffer,io_count * 2 * sizeof(int));
       if (io_size != io_count * 2 * sizeof(int)) {
 	taucs_printf("oocsp_colanalyze: write to skel sort file failed\n");
 	unlink(fname);
@@ -606,17 +718,17 @@ static int skel_sort_outofcore(int* postorder, int ncols, int* inv_postorder)
      each element in the skel_buffer is 2 ints, but 
      each element in the heap is 3 ints 
   */
-  maxopenruns = (2*skel_buffer_size) / (3*iobufsize);
+  maxopenruns = (2*ctx->skel_buffer_size) / (3*iobufsize);
   if (maxopenruns < 2) {
     maxopenruns = 2;
-    iobufsize   = (2*skel_buffer_size) / (3 * 2);
+    iobufsize   = (2*ctx->skel_buffer_size) / (3 * 2);
   }
   taucs_printf("oocsp_colanalyze: Using io buffers of %d elements (%d bytes), max runs = %d\n",
 	     iobufsize,iobufsize*2,maxopenruns);
 
   inbuf  = (int*)taucs_malloc(iobufsize*2*sizeof(int));
   outbuf = (int*)taucs_malloc(iobufsize*2*sizeof(int));
-  infiles  = (int*)taucs_malloc(skel_outfiles*sizeof(int));
+  infiles  = (int*)taucs_malloc(ctx->skel_outfiles*sizeof(int));
   /*
   inbuf  = taucs_calloc(iobufsize,2*sizeof(int));
   outbuf = taucs_calloc(iobufsize,2*sizeof(int));
@@ -628,24 +740,24 @@ static int skel_sort_outofcore(int* postorder, int ncols, int* inv_postorder)
     goto end;
   }
 
-  while (skel_outfiles > 1) {
+  while (ctx->skel_outfiles > 1) {
     char phase;
     /*    int  i,j,k,runstart,openruns;*/
 
     taucs_printf("oocsp_colanalyze: Starting another merge phase with %d input runs\n",
-	       skel_outfiles);
+	       ctx->skel_outfiles);
 
-    skel_infiles  = skel_outfiles;
-    skel_outfiles = 0;
+    ctx->skel_infiles  = ctx->skel_outfiles;
+    ctx->skel_outfiles = 0;
 
-    phase         = skel_inphase;
-    skel_inphase  = skel_outphase;
-    skel_outphase = phase;
+    phase         = ctx->skel_inphase;
+    ctx->skel_inphase  = ctx->skel_outphase;
+    ctx->skel_outphase = phase;
 
-    for (runstart=0; runstart<skel_infiles; runstart += maxopenruns) {
+    for (runstart=0; runstart<ctx->skel_infiles; runstart += maxopenruns) {
 
       sprintf(fname,"%s.%c.%d",
-	      skel_basename,skel_outphase,runstart/maxopenruns);
+	      ctx->skel_basename,ctx->skel_outphase,runstart/maxopenruns);
       taucs_printf("oocsp_colanalyze: Opening output run <%s>\n",fname);
 #ifdef OSTYPE_win32
       mode = _O_WRONLY | _O_CREAT | _O_BINARY;
@@ -660,13 +772,13 @@ static int skel_sort_outofcore(int* postorder, int ncols, int* inv_postorder)
 	errorcode = TAUCS_ERROR_IO;
 	goto end;
       }
-      skel_outfiles++;
+      ctx->skel_outfiles++;
 
       for (openruns=0; 
-	   openruns < maxopenruns && runstart+openruns < skel_infiles;
+	   openruns < maxopenruns && runstart+openruns < ctx->skel_infiles;
 	   openruns++) {
 	
-	sprintf(fname,"%s.%c.%d",skel_basename,skel_inphase,runstart+openruns);
+	sprintf(fname,"%s.%c.%d",ctx->skel_basename,ctx->skel_inphase,runstart+openruns);
 #ifdef OSTYPE_win32
 	mode = _O_RDONLY | _O_BINARY;
 #else
@@ -707,9 +819,9 @@ static int skel_sort_outofcore(int* postorder, int ncols, int* inv_postorder)
 	  }
 	  last_col = j;
 	  if (e == (int)io_count-1) /* end of inbuf marker */
-	    heap_insert(skel_buffer,&heapsize,i,j,2*openruns+1);
+	    heap_insert(ctx->skel_buffer,&heapsize,i,j,2*openruns+1);
 	  else
-	    heap_insert(skel_buffer,&heapsize,i,j,2*openruns);
+	    heap_insert(ctx->skel_buffer,&heapsize,i,j,2*openruns);
 	}
       } 
 
@@ -723,7 +835,7 @@ static int skel_sort_outofcore(int* postorder, int ncols, int* inv_postorder)
       while (heapsize > 0) {
 	int end_of_run,run;
 
-	heap_extract_min(skel_buffer,&heapsize,&i,&j,&k);
+	heap_extract_min(ctx->skel_buffer,&heapsize,&i,&j,&k);
 	if (last_extracted > j)
 	  taucs_printf("oocsp_colanalyze: heap order error!\n");
 	last_extracted = j;
@@ -749,7 +861,7 @@ static int skel_sort_outofcore(int* postorder, int ncols, int* inv_postorder)
 	  }
 	  io_count = io_size/(2*sizeof(int));
 	  if (io_count == 0) {
-	    sprintf(fname,"%s.%c.%d",skel_basename,skel_inphase,runstart+run);
+	    sprintf(fname,"%s.%c.%d",ctx->skel_basename,ctx->skel_inphase,runstart+run);
 	    taucs_printf("oocsp_colanalyze: Closing input run %d <%s>\n",run,fname);
 	    close(infiles[run]);
 	    unlink(fname);
@@ -780,13 +892,13 @@ static int skel_sort_outofcore(int* postorder, int ncols, int* inv_postorder)
 	    last_col = j;
 
 	    if (e == (int)io_count-1) /* end of inbuf marker */
-	      heap_insert(skel_buffer,&heapsize,i,j,2*run+1);
+	      heap_insert(ctx->skel_buffer,&heapsize,i,j,2*run+1);
 	    else
-	      heap_insert(skel_buffer,&heapsize,i,j,2*run);
+	      heap_insert(ctx->skel_buffer,&heapsize,i,j,2*run);
 
-	    if (3*heapsize >= 2*skel_buffer_size) {
+	    if (3*heapsize >= 2*ctx->skel_buffer_size) {
 	      taucs_printf("oocsp_colanalyze: heapsize = %d, buffer_size = %d\n",
-			heapsize,2*skel_buffer_size);
+			heapsize,2*ctx->skel_buffer_size);
 	      taucs_printf("oocsp_colanalyze: merge-heap overflow\n");
 	    }
 	  }
@@ -821,7 +933,7 @@ static int skel_sort_outofcore(int* postorder, int ncols, int* inv_postorder)
 	outbuf_ptr = 0;
       }
       close(outfile);
-      skel_buffer_ptr = 0;
+      ctx->skel_buffer_ptr = 0;
     }
   }
 
@@ -840,12 +952,7 @@ static int skel_sort_outofcore(int* postorder, int ncols, int* inv_postorder)
   return errorcode;
 }
 
-static int  stack_allocated = 0; /* maybe 1 would be better here, causing a fault
-                                    instead of a memory leak in case of a bug */
-static int  stack_buffer_size = -1;
-static int* stack_buffer      = NULL;
-
-static int skel_sort(int* postorder, int ncols,int* tmp)
+static int skel_sort(ooc_lu_context* ctx, int* postorder, int ncols,int* tmp)
 {
   int  errorcode = TAUCS_SUCCESS;
   int  file;
@@ -857,23 +964,23 @@ static int skel_sort(int* postorder, int ncols,int* tmp)
 
   iobufsize   = get_iobufsize() / (2*sizeof(int)); 
 
-  if (skel_outfiles == 0) {
-    skel_sort_incore(postorder,ncols,tmp);
+  if (ctx->skel_outfiles == 0) {
+    skel_sort_incore(ctx,postorder,ncols,tmp);
 
     /* xxxyyy */
-    if (skel_buffer_ptr <= skel_buffer_size / 2) {
-      taucs_printf("final skel ptr=%d\n",skel_buffer_ptr);
-      stack_buffer      = skel_buffer + (2*skel_buffer_ptr);
-      stack_buffer_size = 2*(skel_buffer_size - skel_buffer_ptr);
+    if (ctx->skel_buffer_ptr <= ctx->skel_buffer_size / 2) {
+      taucs_printf("final skel ptr=%d\n",ctx->skel_buffer_ptr);
+      ctx->stack_buffer      = ctx->skel_buffer + (2*ctx->skel_buffer_ptr);
+      ctx->stack_buffer_size = 2*(ctx->skel_buffer_size - ctx->skel_buffer_ptr);
 
-      stack_buffer      = taucs_malloc(stack_buffer_size * sizeof(int)); /* debugging */
+      ctx->stack_buffer      = taucs_malloc(ctx->stack_buffer_size * sizeof(int)); /* debugging */
 
-      stack_allocated   = 0;
+      ctx->stack_allocated   = 0;
       taucs_printf("oocsp_colanalyze: Using remainder of skeleton buffer for stack,\n");
-      taucs_printf("oocsp_colanalyze: size = %d ints\n",stack_buffer_size);
+      taucs_printf("oocsp_colanalyze: size = %d ints\n",ctx->stack_buffer_size);
     } else {
       assert(0); /* for debugging xxx */
-      sprintf(fname,"%s.%c.%d",skel_basename,skel_outphase,0);
+      sprintf(fname,"%s.%c.%d",ctx->skel_basename,ctx->skel_outphase,0);
       taucs_printf("oocsp_colanalyze: Writing out skel sort buffer <%s> (2)\n",fname);
 #ifdef OSTYPE_win32
       mode = _O_WRONLY | _O_CREAT | _O_BINARY;
@@ -887,8 +994,8 @@ static int skel_sort(int* postorder, int ncols,int* tmp)
 	taucs_printf("oocsp_colanalyze: could not create skel sort file\n");
 	return TAUCS_ERROR_IO;
       }
-      io_size = write(file,skel_buffer,skel_buffer_ptr * 2 * sizeof(int));
-      if (io_size != skel_buffer_ptr * 2 * sizeof(int)) {
+      io_size = write(file,ctx->skel_buffer,ctx->skel_buffer_ptr * 2 * sizeof(int));
+      if (io_size != ctx->skel_buffer_ptr * 2 * sizeof(int)) {
 	taucs_printf("oocsp_colanalyze: write to skel sort file failed\n");
 	unlink(fname);
 	return TAUCS_ERROR_IO;
@@ -896,29 +1003,29 @@ static int skel_sort(int* postorder, int ncols,int* tmp)
 
       close(file);
 
-      skel_outfiles++;
-      skel_buffer_ptr = 0;
+      ctx->skel_outfiles++;
+      ctx->skel_buffer_ptr = 0;
 
-      stack_buffer      = skel_buffer;
-      stack_buffer_size = 2*skel_buffer_size;
-      stack_allocated   = 1; /* we need to free it */
+      ctx->stack_buffer      = ctx->skel_buffer;
+      ctx->stack_buffer_size = 2*ctx->skel_buffer_size;
+      ctx->stack_allocated   = 1; /* we need to free it */
 
-      skel_buffer_size  = iobufsize;
-      skel_buffer       = (int*)taucs_malloc(iobufsize*2*sizeof(int));
-      if (!skel_buffer) return TAUCS_ERROR_NOMEM;
+      ctx->skel_buffer_size  = iobufsize;
+      ctx->skel_buffer       = (int*)taucs_malloc(iobufsize*2*sizeof(int));
+      if (!ctx->skel_buffer) return TAUCS_ERROR_NOMEM;
       taucs_printf("oocsp_colanalyze: Using skeleton buffer for stack, allocating \n");
       taucs_printf("oocsp_colanalyze: new skeleton buffer\n\n");
     }
   } else {
     assert(0); /* debugging xxx */
-    if ((errorcode=skel_sort_outofcore(postorder,ncols,tmp)) != TAUCS_SUCCESS)
+    if ((errorcode=skel_sort_outofcore(ctx,postorder,ncols,tmp)) != TAUCS_SUCCESS)
       return errorcode;
 
-    stack_buffer      = skel_buffer;
-    stack_buffer_size = 2*skel_buffer_size;
-    skel_buffer_size  = iobufsize;
-    skel_buffer       = (int*)taucs_malloc(iobufsize*2*sizeof(int));
-    if (!skel_buffer) return TAUCS_ERROR_NOMEM;
+    ctx->stack_buffer      = ctx->skel_buffer;
+    ctx->stack_buffer_size = 2*ctx->skel_buffer_size;
+    ctx->skel_buffer_size  = iobufsize;
+    ctx->skel_buffer       = (int*)taucs_malloc(iobufsize*2*sizeof(int));
+    if (!ctx->skel_buffer) return TAUCS_ERROR_NOMEM;
     taucs_printf("oocsp_colanalyze: Using skeleton buffer for stack, allocating \n");
     taucs_printf("oocsp_colanalyze: new skeleton buffer\n");
   }
@@ -926,64 +1033,64 @@ static int skel_sort(int* postorder, int ncols,int* tmp)
   return errorcode;
 }
 
-static int skel_get_next(int j)
+static int skel_get_next(ooc_lu_context* ctx, int j)
 {
   int row, col;
   char fname[256];
   ssize_t io_size;
   mode_t mode;
 
-  if (skel_next >= skel_buffer_ptr) {
-    if (skel_outfiles > 0) {
-      if (skel_outfile == -1) {
-	sprintf(fname,"%s.%c.%d",skel_basename,skel_outphase,0);
+  if (ctx->skel_next >= ctx->skel_buffer_ptr) {
+    if (ctx->skel_outfiles > 0) {
+      if (ctx->skel_outfile == -1) {
+	sprintf(fname,"%s.%c.%d",ctx->skel_basename,ctx->skel_outphase,0);
 	taucs_printf("oocsp_colanalyze: Opening skel sort buffer <%s> (2)\n",fname);
 #ifdef OSTYPE_win32
 	mode = _O_RDONLY | _O_BINARY;
 #else
 	mode = O_RDONLY;
 #endif
-	skel_outfile = open(fname,mode);
-	if (skel_outfile == -1) {
+	ctx->skel_outfile = open(fname,mode);
+	if (ctx->skel_outfile == -1) {
 	  taucs_printf("oocsp_colanalyze: could not open skel sort file\n");
 	  return TAUCS_ERROR_IO;
 	}
       }
-      io_size = read(skel_outfile,
-		     skel_buffer,skel_buffer_size * 2 * sizeof(int));
+      io_size = read(ctx->skel_outfile,
+		     ctx->skel_buffer,ctx->skel_buffer_size * 2 * sizeof(int));
       if (io_size == -1) {
 	taucs_printf("oocsp_colanalyze: I/O error while trying to read skel sort file\n");
 	return TAUCS_ERROR_IO;
       }
       if (io_size == 0) { /* end of file */
 	taucs_printf("oocsp_colanalyze: Closing and removing skel file, col=%d\n",j);
-	sprintf(fname,"%s.%c.%d",skel_basename,skel_outphase,0);
-	close(skel_outfile);
+	sprintf(fname,"%s.%c.%d",ctx->skel_basename,ctx->skel_outphase,0);
+	close(ctx->skel_outfile);
 	unlink(fname);
-	skel_outfiles   = 0;
-	skel_next       = 0;
-	skel_buffer_ptr = 0;
+	ctx->skel_outfiles   = 0;
+	ctx->skel_next       = 0;
+	ctx->skel_buffer_ptr = 0;
 	return -1;
       } else {
-	skel_next       = 0;
-	skel_buffer_ptr = io_size / (2*sizeof(int));
-	taucs_printf("oocsp_colanalyze: read %d elements from skel sort file\n",skel_buffer_ptr);
+	ctx->skel_next       = 0;
+	ctx->skel_buffer_ptr = io_size / (2*sizeof(int));
+	taucs_printf("oocsp_colanalyze: read %d elements from skel sort file\n",ctx->skel_buffer_ptr);
       }
     } else
       return -1;
   }
 
-  if (skel_next >= skel_buffer_ptr)
+  if (ctx->skel_next >= ctx->skel_buffer_ptr)
     return -1;
 
-  assert(skel_next >= 0);
-  assert(skel_next < skel_buffer_size);
+  assert(ctx->skel_next >= 0);
+  assert(ctx->skel_next < ctx->skel_buffer_size);
 
-  row = skel_buffer[2*skel_next];
-  col = skel_buffer[2*skel_next+1];
+  row = ctx->skel_buffer[2*ctx->skel_next];
+  col = ctx->skel_buffer[2*ctx->skel_next+1];
 
   if (col == j) {
-    skel_next++;
+    ctx->skel_next++;
     return row;
   }
   else
@@ -991,14 +1098,14 @@ static int skel_get_next(int j)
 }
     
 
-static int skel_get_postordercol(int* found, int flag,
+static int skel_get_postordercol(ooc_lu_context* ctx, int* found, int flag,
 				  int j,
 				  int* nnz, int* rowind)
 {
   int row;
 
   *nnz = 0;
-  while ((row = skel_get_next(j)) >= 0) {
+  while ((row = skel_get_next(ctx,j)) >= 0) {
     if (found[row] < flag) {
       found[row] = flag;
       rowind[ *nnz ] = row;
@@ -1059,30 +1166,16 @@ static int uf_find   (int* uf, int i)        { if (uf[i] != i)
 
 /* FILL STACK ROUTINES */
 
-static int  stack_files = -1;
-static char stack_basename[256];
-
-/*
-static int  stack_buffer_size;
-static int* stack_buffer;
-*/
-static int  stack_buffer_ptr = -1;
-
-static int  stack_top = -1;
-
-static double stack_size = -1;
-static double stack_max_size = -1;
-
-static void stack_init(char* basename,
+static void stack_init(ooc_lu_context* ctx, char* basename,
 		       int* colptr, int* colstack, 
 		       int ncols)
 {
   int j;
 
-  sprintf(stack_basename,"%s.fstack",basename);
-  stack_files      = 0;
-  stack_buffer_ptr = 0;
-  stack_top        = -1;
+  sprintf(ctx->stack_basename,"%s.fstack",basename);
+  ctx->stack_files      = 0;
+  ctx->stack_buffer_ptr = 0;
+  ctx->stack_top        = -1;
 
   for (j=0; j<ncols; j++) colptr[j] = -1;
 
@@ -1091,48 +1184,48 @@ static void stack_init(char* basename,
   stack_buffer = mxCalloc(stack_buffer_size,sizeof(int));
   */
 
-  stack_size     = 0.0;
-  stack_max_size = 0.0;
+  ctx->stack_size     = 0.0;
+  ctx->stack_max_size = 0.0;
 }
 
-static void stack_finalize()
+static void stack_finalize(ooc_lu_context* ctx)
 {
-  if (stack_files != 0 || stack_buffer_ptr != 0)
+  if (ctx->stack_files != 0 || ctx->stack_buffer_ptr != 0)
     taucs_printf("oocsp_colanalyze: fill stack did not get empty\n");
 
-  if (stack_allocated)
-    taucs_free(stack_buffer);
+  if (ctx->stack_allocated)
+    taucs_free(ctx->stack_buffer);
 
-  taucs_printf("oocsp_colanalyze: max stack size = %.0lf\n",stack_max_size);
+  taucs_printf("oocsp_colanalyze: max stack size = %.0lf\n",ctx->stack_max_size);
 }
 
-static int stack_push(int* colptr, int* colstack, int i, int j)
+static int stack_push(ooc_lu_context* ctx, int* colptr, int* colstack, int i, int j)
 {
   mode_t mode;
   mode_t perm;
 
-  if (stack_top < 0 || colstack[stack_top] != j) {
+  if (ctx->stack_top < 0 || colstack[ctx->stack_top] != j) {
     if (colptr[j] != -1) {
       taucs_printf("oocsp_colanalyze: fill stack internal error (push)\n");
     }
-    stack_top++;
-    colstack[stack_top] = j;
-    colptr[j] = (stack_buffer_size*stack_files) + stack_buffer_ptr;
+    ctx->stack_top++;
+    colstack[ctx->stack_top] = j;
+    colptr[j] = (ctx->stack_buffer_size*ctx->stack_files) + ctx->stack_buffer_ptr;
     if (colptr[j] > (INT_MAX/2))
       taucs_printf("oocsp_colanalyze: Warning! Pointers to fill stack may overflow\n");
   }
    
-  stack_buffer[stack_buffer_ptr] = i;
-  stack_buffer_ptr++;
+  ctx->stack_buffer[ctx->stack_buffer_ptr] = i;
+  ctx->stack_buffer_ptr++;
 
-  if (stack_buffer_ptr >= stack_buffer_size) {
+  if (ctx->stack_buffer_ptr >= ctx->stack_buffer_size) {
     int     file;
     ssize_t io_size;
     char    fname[256];
 
     assert(0); /* debugging xxx */
 
-    sprintf(fname,"%s.%d",stack_basename,stack_files);
+    sprintf(fname,"%s.%d",ctx->stack_basename,ctx->stack_files);
     taucs_printf("oocsp_colanalyze: Writing out fill stack buffer <%s>\n",fname);
 #ifdef OSTYPE_win32
     mode = _O_WRONLY | _O_CREAT | _O_BINARY;
@@ -1146,16 +1239,16 @@ static int stack_push(int* colptr, int* colstack, int i, int j)
       taucs_printf("oocsp_colanalyze: could not create stack file\n");
       return TAUCS_ERROR_IO;
     }
-    io_size = write(file,stack_buffer,stack_buffer_size * sizeof(int));
-    if (io_size != stack_buffer_size * sizeof(int)) {
+    io_size = write(file,ctx->stack_buffer,ctx->stack_buffer_size * sizeof(int));
+    if (io_size != ctx->stack_buffer_size * sizeof(int)) {
       taucs_printf("oocsp_colanalyze: write to stack file failed\n");
       unlink(fname);
       return TAUCS_ERROR_IO;
     }
     close(file);
 
-    stack_files++;
-    stack_buffer_ptr = 0;
+    ctx->stack_files++;
+    ctx->stack_buffer_ptr = 0;
   }
 
   /*
@@ -1165,7 +1258,7 @@ static int stack_push(int* colptr, int* colstack, int i, int j)
   return TAUCS_SUCCESS;
 }
 
-static int stack_pop(int* colptr, int* colstack, 
+static int stack_pop(ooc_lu_context* ctx, int* colptr, int* colstack, 
 		      int* found, int flag,
 		      int j, int* nnz, int* rowind)
 {
@@ -1173,8 +1266,8 @@ static int stack_pop(int* colptr, int* colstack,
   int   i;
   mode_t mode;
 
-  if (stack_top < 0 || colstack[stack_top] != j) { /* empty fill column */
-    for (i=0; i<=stack_top; i++)
+  if (ctx->stack_top < 0 || colstack[ctx->stack_top] != j) { /* empty fill column */
+    for (i=0; i<=ctx->stack_top; i++)
       if (colstack[i] == j) {
 	taucs_printf("oocsp_colanalyze: fill stack internal error (pop)\n");
 	return TAUCS_ERROR;
@@ -1183,18 +1276,18 @@ static int stack_pop(int* colptr, int* colstack,
     *nnz    = 0;
   } else {
     *nnz = 0;
-    while (colptr[j] < (stack_buffer_size*stack_files) +stack_buffer_ptr) {
+    while (colptr[j] < (ctx->stack_buffer_size*ctx->stack_files) +ctx->stack_buffer_ptr) {
 
-      if (stack_buffer_ptr == 0) {
+      if (ctx->stack_buffer_ptr == 0) {
 	int     file;
 	ssize_t io_size;
 	char    fname[256];
 	
 	assert(0); /* debugging xxx */
 
-	stack_files--;
-	stack_buffer_ptr = stack_buffer_size;
-	sprintf(fname,"%s.%d",stack_basename,stack_files);
+	ctx->stack_files--;
+	ctx->stack_buffer_ptr = ctx->stack_buffer_size;
+	sprintf(fname,"%s.%d",ctx->stack_basename,ctx->stack_files);
 	taucs_printf("oocsp_colanalyze: Reading a fill stack buffer <%s>\n",fname);
 #ifdef OSTYPE_win32
 	mode = _O_RDONLY | _O_BINARY;
@@ -1206,8 +1299,8 @@ static int stack_pop(int* colptr, int* colstack,
 	  taucs_printf("oocsp_colanalyze: could not open stack file\n");
 	  return TAUCS_ERROR_IO;
 	}
-	io_size = read(file,stack_buffer,stack_buffer_size * sizeof(int));
-	if (io_size != stack_buffer_size * sizeof(int)) {
+	io_size = read(file,ctx->stack_buffer,ctx->stack_buffer_size * sizeof(int));
+	if (io_size != ctx->stack_buffer_size * sizeof(int)) {
 	  taucs_printf("oocsp_colanalyze: read from stack file failed\n");
 	  unlink(fname);
 	  return TAUCS_ERROR_IO;
@@ -1216,9 +1309,9 @@ static int stack_pop(int* colptr, int* colstack,
 	unlink(fname);
       }
 
-      stack_buffer_ptr --;
-      assert(stack_buffer_ptr >= 0);
-      row = stack_buffer[ stack_buffer_ptr ];
+      ctx->stack_buffer_ptr --;
+      assert(ctx->stack_buffer_ptr >= 0);
+      row = ctx->stack_buffer[ ctx->stack_buffer_ptr ];
 
       /*printf(">>> %08x \n",row);*/
 
@@ -1229,7 +1322,7 @@ static int stack_pop(int* colptr, int* colstack,
       }
     }
 
-    stack_top--;
+    ctx->stack_top--;
     colptr[j] = -1;
   }
   /*
@@ -1242,7 +1335,7 @@ static int stack_pop(int* colptr, int* colstack,
 /* MAIN ROUTINE */
 
 static
-int oocsp_colanalyze(taucs_ccs_matrix* matrix,
+int oocsp_colanalyze(ooc_lu_context* ctx, taucs_ccs_matrix* matrix,
 		      char* basename,
 		      int*  colperm,
 		      int** ptrparent,
@@ -1280,7 +1373,7 @@ int oocsp_colanalyze(taucs_ccs_matrix* matrix,
   int*    ncols;
 
   taucs_printf("oocsp_colanalyze: In colanalyze\n");
-  taucs_printf("oocsp_colanalyze: using %.0lf MBytes of memory\n",(remaining_memory)/1048576.0);
+  taucs_printf("oocsp_colanalyze: using %.0lf MBytes of memory\n",(ctx->remaining_memory)/1048576.0);
   /*EF_FILL=0x00;*/
   
   nrows     = &matrix->m;
@@ -1288,10 +1381,10 @@ int oocsp_colanalyze(taucs_ccs_matrix* matrix,
 
   /* START THE ANALYSYS */
 
-  if ((errorcode = skel_init(basename)) != TAUCS_SUCCESS)
+  if ((errorcode = skel_init(ctx,basename)) != TAUCS_SUCCESS)
     goto end;
 
-  (remaining_memory) -= (double) ( 4 * (*ncols) * 4 /* sizeof(int32) */);
+  (ctx->remaining_memory) -= (double) ( 4 * (*ncols) * 4 /* sizeof(int32) */);
 
   /* +1 for stack_vertex, stack_child */
   parent          = (int*)taucs_malloc((*ncols+1)*sizeof(int));
@@ -1304,8 +1397,8 @@ int oocsp_colanalyze(taucs_ccs_matrix* matrix,
   *ptrpostorder = postorder;
 
 
-  (remaining_memory) -= (double) ( 2 * ((*ncols)+1) * sizeof(int));
-  (remaining_memory) -= (double) ( 2 * (*nrows) * sizeof(int));
+  (ctx->remaining_memory) -= (double) ( 2 * ((*ncols)+1) * sizeof(int));
+  (ctx->remaining_memory) -= (double) ( 2 * (*nrows) * sizeof(int));
 
   uf        = (int*)taucs_malloc((*ncols+1)*sizeof(int));
   root      = (int*)taucs_malloc((*ncols+1)*sizeof(int));
@@ -1388,7 +1481,7 @@ int oocsp_colanalyze(taucs_ccs_matrix* matrix,
 	}
       }
       /* ADD (j,fcol) TO SKELETON */
-      skel_add(j,fcol);
+      skel_add(ctx,j,fcol);
     }
     /*
     mxDestroyArray(output_args[0]);
@@ -1442,13 +1535,13 @@ int oocsp_colanalyze(taucs_ccs_matrix* matrix,
     
   /* SORT THE SKELETON MATRIX */
 
-  if ((errorcode = skel_sort(postorder, *ncols, found /* temporary */)) != TAUCS_SUCCESS)
+  if ((errorcode = skel_sort(ctx,postorder, *ncols, found /* temporary */)) != TAUCS_SUCCESS)
     goto end;
   
   /* SECOND PHASE, COMPUTE COLCOUNTS */
 
   /* we reuse the space of uf and root */
-  stack_init(basename,stack_colptr,stack_colstk,*ncols); 
+  stack_init(ctx,basename,stack_colptr,stack_colstk,*ncols); 
 
   for (i=0; i < (*nrows); i++) {
     found[i] = -1;
@@ -1470,7 +1563,7 @@ int oocsp_colanalyze(taucs_ccs_matrix* matrix,
       ucolcount[p]++;
     }
 
-    if ((errorcode=stack_pop(stack_colptr,stack_colstk,
+    if ((errorcode=stack_pop(ctx,stack_colptr,stack_colstk,
 			     found, jp,
 			     j,
 			     &nnz,tmp_col)) != TAUCS_SUCCESS) goto end;
@@ -1481,10 +1574,10 @@ int oocsp_colanalyze(taucs_ccs_matrix* matrix,
       lcolcount[j]++;
       ucolcount[i]++;
       if (p < *ncols) 
-	if ((errorcode=stack_push(stack_colptr,stack_colstk,i,p)) != TAUCS_SUCCESS) goto end;
+	if ((errorcode=stack_push(ctx,stack_colptr,stack_colstk,i,p)) != TAUCS_SUCCESS) goto end;
     }
 
-    if ((errorcode=skel_get_postordercol(found,jp,
+    if ((errorcode=skel_get_postordercol(ctx,found,jp,
 					 jp, /* use postorder column index */
 					 &nnz,tmp_col)) != TAUCS_SUCCESS) goto end;
     rowind = tmp_col;
@@ -1500,7 +1593,7 @@ int oocsp_colanalyze(taucs_ccs_matrix* matrix,
 	taucs_printf("oocsp_colanalyze: Internal error while producing ucolcounts\n");
 
       if (p < *ncols) 
-	if ((errorcode=stack_push(stack_colptr,stack_colstk,i,p)) != TAUCS_SUCCESS) goto end;
+	if ((errorcode=stack_push(ctx,stack_colptr,stack_colstk,i,p)) != TAUCS_SUCCESS) goto end;
     }
   }
 
@@ -1522,7 +1615,7 @@ int oocsp_colanalyze(taucs_ccs_matrix* matrix,
       ucolcount[i]--;*/
   }
 
-  stack_finalize();
+  stack_finalize(ctx);
 
   /*
   mxDestroyArray(tmp1_array);
@@ -1547,10 +1640,10 @@ end:
   taucs_free(root);
   taucs_free(tmp_col);
 
-  (remaining_memory) += (double) ( 2 * ((*ncols)+1) * sizeof(int));
-  (remaining_memory) += (double) ( 2 * (*nrows) * sizeof(int));
+  (ctx->remaining_memory) += (double) ( 2 * ((*ncols)+1) * sizeof(int));
+  (ctx->remaining_memory) += (double) ( 2 * (*nrows) * sizeof(int));
 
-  skel_finalize();
+  skel_finalize(ctx);
 
   taucs_printf("oocsp_colanalyze: done\n");
   
@@ -1565,7 +1658,7 @@ end:
 /* There seems to be a confusion here between spawidth and remaining memory; sivan */
 
 static
-int oocsp_panelize_simple(
+int oocsp_panelize_simple(ooc_lu_context* ctx, 
 			   int  nrows,             /* input  */  
 			   int  ncols,             /* input  */
 			   int* postorder,         /* input  */
@@ -1632,7 +1725,7 @@ int oocsp_panelize_simple(
     width_multiplier = 
       1.0*nrows*sizeof(int) + 1.0*nrows*sizeof(taucs_datatype) + 1.0*sizeof(int)
       + 5.0*maxcolcount*sizeof(int) + 2.0*maxcolcount*sizeof(taucs_datatype);
-    *spawidth = (int) floor( (remaining_memory - memuse) / width_multiplier );
+    *spawidth = (int) floor( (ctx->remaining_memory - memuse) / width_multiplier );
   } while (*spawidth > 4*(*maxsn));
 
   if (*spawidth < 8) *spawidth = 8; /* it might go over the limit */
@@ -1735,17 +1828,12 @@ int oocsp_panelize_simple(
 
 #define SNODES 
 #define SNODE_THRESHOLD 4
-#define SNODE_BLOCK 8
 #define SIMPLE_COL_COL_no
 #define SPA_ONEARRAY
 #define USE_BLAS
 #define BLAS_THRESHOLD 10
 #define BLOCK 16
 
-#ifdef DETAILED_TIMING
-static double flops_extra = 0.0;
-static double flops_dense = 0.0;
-#endif
 
 /*
   Out-of-core sparse LU
@@ -1814,40 +1902,6 @@ static double flops_dense = 0.0;
 
 
 
-static double time_total;
-
-#ifdef DETAILED_TIMING
-static double time_colcol;
-static double time_colcol_1;
-static double time_colcol_2;
-static double time_factor;
-static double time_scatter;
-static double time_gather;
-static double time_append;
-static double time_read;
-#ifdef SNODES
-static double time_snode_tmp;
-static double time_snode_1 = 0;
-static double time_snode_2 = 0;
-static double time_snode_21 = 0;
-static double time_snode_3 = 0;
-static double time_snode_4 = 0;
-static double time_snode_detect;
-static double time_snode_prepare;
-static double time_snode_dense;
-#endif
-
-static double bytes_read;
-static double bytes_appended;
-static double col_ooc_updates;
-static double col_read;
-
-static double  flops;
-static double  scatters;
-static double  gathers;
-static double  rowlist_ops;
-static double  num_heap_ops;
-#endif /* DETAILED_TIMING */
 
 /****************************************************/
 /*                                                  */
@@ -1858,14 +1912,14 @@ static double  num_heap_ops;
 /* HEAP OPERATIONS */
 
 
-static void num_heap_heapify(int* heap, int* heapsize, 
+static void num_heap_heapify(ooc_lu_context* ctx, int* heap, int* heapsize, 
 			     int* ipivots, int p) 
 {
   int r,l,smallest;
   int temp;
 
 #ifdef DETAILED_TIMING
-  num_heap_ops += 1.0;
+  ctx->num_heap_ops += 1.0;
 #endif
 
   r = (p+1) * 2;
@@ -1889,18 +1943,18 @@ static void num_heap_heapify(int* heap, int* heapsize,
     heap[p]        = heap[smallest];
     heap[smallest] = temp;
     
-    num_heap_heapify(heap, heapsize, ipivots, smallest);
+    num_heap_heapify(ctx,heap, heapsize, ipivots, smallest);
   }
 }
 
-static void num_heap_insert(int* heap, int* heapsize, int* ipivots, int i)
+static void num_heap_insert(ooc_lu_context* ctx, int* heap, int* heapsize, int* ipivots, int i)
 {
   int child, parent;
 
   (*heapsize)++;
 
 #ifdef DETAILED_TIMING
-  num_heap_ops += 1.0;
+  ctx->num_heap_ops += 1.0;
 #endif
 
   child = (*heapsize-1);
@@ -1911,19 +1965,19 @@ static void num_heap_insert(int* heap, int* heapsize, int* ipivots, int i)
     parent = (child-1) / 2;
 
 #ifdef DETAILED_TIMING
-    num_heap_ops += 1.0;
+    ctx->num_heap_ops += 1.0;
 #endif
   }
 
   heap[child]   = i;
 }
 
-static int num_heap_extractmin(int* heap, int* heapsize, int* ipivots) 
+static int num_heap_extractmin(ooc_lu_context* ctx, int* heap, int* heapsize, int* ipivots) 
 {
   int m; 
 
 #ifdef DETAILED_TIMING
-  num_heap_ops += 1.0;
+  ctx->num_heap_ops += 1.0;
 #endif
 
   if (*heapsize <= 0) return -1;
@@ -1934,7 +1988,7 @@ static int num_heap_extractmin(int* heap, int* heapsize, int* ipivots)
 
   (*heapsize)--;
 
-  num_heap_heapify(heap,heapsize,ipivots,0);
+  num_heap_heapify(ctx,heap,heapsize,ipivots,0);
 
   return m;
 }
@@ -1945,120 +1999,107 @@ static int num_heap_extractmin(int* heap, int* heapsize, int* ipivots)
 /*                                                  */
 /****************************************************/
 
-static int* rowlists_head     = NULL;   /* one head per row */
-static int* rowlists_colind   = NULL; 
-static int* rowlists_next     = NULL;
-static int* rowlists_prev     = NULL;
-static int  rowlists_size     = -1;
-static int  rowlists_freehead = -1;
-/*static int  rowlists_freenext;*/
 
-static void rowlists_finalize()
+static void rowlists_finalize(ooc_lu_context* ctx)
 {
-  taucs_free(rowlists_head);
-  taucs_free(rowlists_colind);
-  taucs_free(rowlists_next);
-  taucs_free(rowlists_prev);
-
-  rowlists_head   = NULL;
-  rowlists_colind = NULL;
-  rowlists_next   = NULL;
-  rowlists_prev   = NULL;
+  taucs_free(ctx->rowlists_head);
+  taucs_free(ctx->rowlists_colind);
+  taucs_free(ctx->rowlists_next);
+  taucs_free(ctx->rowlists_prev);
+
+  ctx->rowlists_head   = NULL;
+  ctx->rowlists_colind = NULL;
+  ctx->rowlists_next   = NULL;
+  ctx->rowlists_prev   = NULL;
 }
 
-static int rowlists_init(int size, int nrows)
+static int rowlists_init(ooc_lu_context* ctx, int size, int nrows)
 {
   int i;
 
-  rowlists_size = size;
+  ctx->rowlists_size = size;
 
-  rowlists_head   = (int*)taucs_malloc(nrows*sizeof(int));
-  rowlists_colind = (int*)taucs_malloc(rowlists_size*sizeof(int));
-  rowlists_next   = (int*)taucs_malloc(rowlists_size*sizeof(int));
-  rowlists_prev   = (int*)taucs_malloc(rowlists_size*sizeof(int));
-  if (!rowlists_head || !rowlists_colind || !rowlists_next || !rowlists_prev) 
+  ctx->rowlists_head   = (int*)taucs_malloc(nrows*sizeof(int));
+  ctx->rowlists_colind = (int*)taucs_malloc(ctx->rowlists_size*sizeof(int));
+  ctx->rowlists_next   = (int*)taucs_malloc(ctx->rowlists_size*sizeof(int));
+  ctx->rowlists_prev   = (int*)taucs_malloc(ctx->rowlists_size*sizeof(int));
+  if (!ctx->rowlists_head || !ctx->rowlists_colind || !ctx->rowlists_next || !ctx->rowlists_prev) 
     return TAUCS_ERROR_NOMEM; 
 
-  for (i=0; i<nrows; i++) rowlists_head[i] = -1;
+  for (i=0; i<nrows; i++) ctx->rowlists_head[i] = -1;
 
   /* link the entire rowlist as one freelist */
 
-  rowlists_freehead = 0;
-  for (i=0; i<rowlists_size; i++) {
-    rowlists_next[i] = i+1;
+  ctx->rowlists_freehead = 0;
+  for (i=0; i<ctx->rowlists_size; i++) {
+    ctx->rowlists_next[i] = i+1;
     /* freelist does not need prev pointers */ 
     /* rowlists_prev[i] = i-1; */ 
   }
-  rowlists_next[ rowlists_size - 1 ] = -1;
+  ctx->rowlists_next[ ctx->rowlists_size - 1 ] = -1;
+  ctx->rowlists_used = 0;
 
   return TAUCS_SUCCESS; 
 }
 
-static int rowlists_insert(int row, int panelcol)
+static int rowlists_insert(ooc_lu_context* ctx, int row, int panelcol)
 {
   int new;
 
 #ifdef DETAILED_TIMING
-  rowlist_ops += 1.0;
+  ctx->rowlist_ops += 1.0;
 #endif /* DETAILED_TIMING */
 
   /* get memory from the freelist */
 
-  if ((new = rowlists_freehead) == -1) {
+  if ((new = ctx->rowlists_freehead) == -1) {
     taucs_printf("oocsp_numfact: Out of rowlist memory\n");
     exit(1);
   }
 
   /* remove this memory from the freelist; freelist does now use prev */
 
-  rowlists_freehead = rowlists_next[ new ];
+  ctx->rowlists_freehead = ctx->rowlists_next[ new ];
+  ctx->rowlists_used++;
 
   /* link to row list */
 
-  rowlists_next[ new ] = rowlists_head[ row ];
-  rowlists_prev[ new ] = -1;
-  rowlists_colind[ new ] = panelcol;
+  ctx->rowlists_next[ new ] = ctx->rowlists_head[ row ];
+  ctx->rowlists_prev[ new ] = -1;
+  ctx->rowlists_colind[ new ] = panelcol;
 
-  if (rowlists_next[new] != -1)
-    rowlists_prev[ rowlists_next[new] ] = new;
+  if (ctx->rowlists_next[new] != -1)
+    ctx->rowlists_prev[ ctx->rowlists_next[new] ] = new;
 
-  rowlists_head[ row ] = new;
+  ctx->rowlists_head[ row ] = new;
 
   return new;
 }
 
-static void rowlists_delete(int row, int index)
+static void rowlists_delete(ooc_lu_context* ctx, int row, int index)
 {
 #ifdef DETAILED_TIMING
-  rowlist_ops += 1.0;
+  ctx->rowlist_ops += 1.0;
 #endif /* DETAILED_TIMING */
 
-  if (rowlists_head[ row ] == index)
-    rowlists_head[ row ] = rowlists_next[ index ];
+  if (ctx->rowlists_head[ row ] == index)
+    ctx->rowlists_head[ row ] = ctx->rowlists_next[ index ];
 
-  if (rowlists_next[ index ] != -1)
-    rowlists_prev[ rowlists_next[index] ] = rowlists_prev[ index ];
+  if (ctx->rowlists_next[ index ] != -1)
+    ctx->rowlists_prev[ ctx->rowlists_next[index] ] = ctx->rowlists_prev[ index ];
 
-  if (rowlists_prev[ index ] != -1)
-    rowlists_next[ rowlists_prev[index] ] = rowlists_next[ index ];
+  if (ctx->rowlists_prev[ index ] != -1)
+    ctx->rowlists_next[ ctx->rowlists_prev[index] ] = ctx->rowlists_next[ index ];
 
-  rowlists_next[ index ] = rowlists_freehead;
-  rowlists_freehead = index;
+  ctx->rowlists_next[ index ] = ctx->rowlists_freehead;
+  ctx->rowlists_freehead = index;
+  ctx->rowlists_used--;
 }
 
-static int rowlists_isempty()
+/* called once per panel; this used to walk the whole freelist */
+static int rowlists_isempty(ooc_lu_context* ctx)
 {
-  int i,count;
-
-  i = rowlists_freehead;
-  count = 0;
-  while (i != -1) {
-    count++;
-    i = rowlists_next[i];
-  }
-
-  if (count == rowlists_size) return 1;
-  else return 0;
+  return (ctx->rowlists_used == 0);
 }
   
 /****************************************************/
@@ -2080,34 +2121,31 @@ int intcmp(const void* v1, const void* v2)
 }
 #endif
 
-static taucs_datatype*  spa    = NULL;
-static char*            spamap = NULL;
-
-static void spa_finalize()
+static void spa_finalize(ooc_lu_context* ctx)
 {
-  taucs_free(spa);
-  taucs_free(spamap);
+  taucs_free(ctx->spa);
+  taucs_free(ctx->spamap);
 
-  spa    = NULL;
-  spamap = NULL;
+  ctx->spa    = NULL;
+  ctx->spamap = NULL;
 }
 
-static int spa_init(int nrows)
+static int spa_init(ooc_lu_context* ctx, int nrows)
 {
   int i;
 
-  spa    = (taucs_datatype*) taucs_malloc(nrows*sizeof(taucs_datatype));
-  spamap = (char*)  taucs_malloc(nrows*sizeof(char));
+  ctx->spa    = (taucs_datatype*) taucs_malloc(nrows*sizeof(taucs_datatype));
+  ctx->spamap = (char*)  taucs_malloc(nrows*sizeof(char));
 
-  if (!spa || !spamap) return TAUCS_ERROR_NOMEM;
+  if (!ctx->spa || !ctx->spamap) return TAUCS_ERROR_NOMEM;
 
-  for (i=0; i<nrows; i++) {spa[i] = taucs_zero; spamap[i] = 0;}
+  for (i=0; i<nrows; i++) {ctx->spa[i] = taucs_zero; ctx->spamap[i] = 0;}
   
   return TAUCS_SUCCESS;
 }
 
 static void
-gather(int             a_nnz,
+gather(ooc_lu_context* ctx, int             a_nnz,
        taucs_datatype* a_re,
        int*            a_ind,
        taucs_datatype* spa,
@@ -2119,7 +2157,7 @@ gather(int             a_nnz,
 #ifdef DETAILED_TIMING
   double time_tmp;
 
-  gathers += ((double) a_nnz);
+  ctx->gathers += ((double) a_nnz);
   time_tmp = taucs_wtime();
 #endif
 
@@ -2132,12 +2170,12 @@ gather(int             a_nnz,
   }
 
 #ifdef DETAILED_TIMING
-  time_gather += (taucs_wtime() - time_tmp);
+  ctx->time_gather += (taucs_wtime() - time_tmp);
 #endif
 }
 
 static void 
-scatter(int             a_nnz,
+scatter(ooc_lu_context* ctx, int             a_nnz,
 	taucs_datatype* a_re,
 	int*            a_ind,
 	taucs_datatype* spa,
@@ -2149,7 +2187,7 @@ scatter(int             a_nnz,
 #ifdef DETAILED_TIMING
   double time_tmp;
 
-  scatters += ((double) a_nnz);
+  ctx->scatters += ((double) a_nnz);
   time_tmp = taucs_wtime();
 #endif
 
@@ -2160,7 +2198,7 @@ scatter(int             a_nnz,
   }
 
 #ifdef DETAILED_TIMING
-  time_scatter += (taucs_wtime() - time_tmp);
+  ctx->time_scatter += (taucs_wtime() - time_tmp);
 #endif
 }
 
@@ -2171,7 +2209,7 @@ scatter(int             a_nnz,
 /****************************************************/
 
 static
-void spcol_spa_update(int pivotindex,
+void spcol_spa_update(ooc_lu_context* ctx, int pivotindex,
 		      taucs_datatype* l_re,
 		      int*    l_ind,
 		      int     l_nnz,
@@ -2199,7 +2237,7 @@ void spcol_spa_update(int pivotindex,
 	spamap[q*nrows + i] = 1;
 	spa   [q*nrows + i] = taucs_zero;
 	a_ind      [q][ a_nnz[q] ] = i;
-	a_inrowlist[q][ a_nnz[q] ] = rowlists_insert(i,q);
+	a_inrowlist[q][ a_nnz[q] ] = rowlists_insert(ctx,i,q);
 	(a_nnz[q])++;
       }
       /*spa[q*nrows + i] -= (spa[q*nrows + pivotindex] * v);*/
@@ -2212,7 +2250,7 @@ void spcol_spa_update(int pivotindex,
 
 #ifdef SIMPLE_COL_COL
 static void
-spcol_spcol_update(int pivotindex,
+spcol_spcol_update(ooc_lu_context* ctx, int pivotindex,
 		   taucs_datatype* l_re,
 		   int*    l_ind,
 		   int     l_nnz,
@@ -2232,7 +2270,7 @@ spcol_spcol_update(int pivotindex,
   if (taucs_iszero(pv)) return;
 
 #ifdef DETAILED_TIMING
-  flops += 2.0 * ((double) l_nnz);
+  ctx->flops += 2.0 * ((double) l_nnz);
 #endif /* DETAILED_TIMING */
 
   for (ip=0; ip<l_nnz; ip++) {
@@ -2241,7 +2279,7 @@ spcol_spcol_update(int pivotindex,
       spamap[i] = 1;
       spa[i] = taucs_zero;
       a_ind[ *a_nnz ] = i;
-      a_inrowlist[ *a_nnz ] = rowlists_insert(i,panelcol);
+      a_inrowlist[ *a_nnz ] = rowlists_insert(ctx,i,panelcol);
       (*a_nnz)++;
     }
     /*spa[i] -= (spa[pivotindex] * l_re[ip]);*/
@@ -2258,11 +2296,8 @@ spcol_spcol_update(int pivotindex,
 }
 #else /* simple col col */
 
-static int oocsp_spcol_n1 = 0;
-static int oocsp_spcol_n2 = 0;
-
 static void
-spcol_spcol_update(int pivotindex,
+spcol_spcol_update(ooc_lu_context* ctx, int pivotindex,
 			  taucs_datatype* l_re,
 			  int*    l_ind,
 			  int     l_nnz,
@@ -2286,7 +2321,7 @@ spcol_spcol_update(int pivotindex,
   if (taucs_iszero(pv)) return;
 
 #ifdef DETAILED_TIMING
-  flops += 2.0 * ((double) l_nnz);
+  ctx->flops += 2.0 * ((double) l_nnz);
 #endif /* DETAILED_TIMING */
 
   for (ip_block=0; ip_block<l_nnz; ip_block += BLOCK) {
@@ -2294,7 +2329,7 @@ spcol_spcol_update(int pivotindex,
     loop_bound = min(ip_block + BLOCK,l_nnz);
 
     flag = 1;
-    oocsp_spcol_n1++;
+    ctx->oocsp_spcol_n1++;
     for (ip=ip_block; ip<loop_bound; ip++) {
       i = l_ind[ip];
       flag &= spamap[i];
@@ -2303,14 +2338,14 @@ spcol_spcol_update(int pivotindex,
     }
 
     if (!flag) {
-      oocsp_spcol_n2++;
+      ctx->oocsp_spcol_n2++;
 
       for (ip=ip_block; ip<loop_bound; ip++) {
 	i = l_ind[ip];
 	if (spamap[i] == 0) {
 	  spamap[i] = 1;
 	  a_ind[ *a_nnz ] = i;
-	  a_inrowlist[ *a_nnz ] = rowlists_insert(i,panelcol);
+	  a_inrowlist[ *a_nnz ] = rowlists_insert(ctx,i,panelcol);
 	  (*a_nnz)++;
 	  /* we essentially zero and update */
 	  /*spa[i] = - (pv * l_re[ip]);*/
@@ -2324,7 +2359,7 @@ spcol_spcol_update(int pivotindex,
 #endif
 
 #if 0
-static void spcol_panel_update(int pivotindex,
+static void spcol_panel_update(ooc_lu_context* ctx, int pivotindex,
 			       taucs_datatype* l_re,
 			       int*    l_ind,
 			       int     l_nnz,
@@ -2343,7 +2378,7 @@ static void spcol_panel_update(int pivotindex,
   assert(0);
 
 #ifdef DETAILED_TIMING
-  flops += ((double) subpanel_size) * 2.0 * ((double) l_nnz);
+  ctx->flops += ((double) subpanel_size) * 2.0 * ((double) l_nnz);
 #endif /* DETAILED_TIMING */
 
   for (j=0; j<subpanel_size; j++) {
@@ -2361,7 +2396,7 @@ static void spcol_panel_update(int pivotindex,
 	spamap[ii] = 1;
 	spa[ii] = taucs_zero;
 	a_ind[q][ a_nnz[q] ] = i;
-	a_inrowlist[q][ a_nnz[q] ] = rowlists_insert(i,q);
+	a_inrowlist[q][ a_nnz[q] ] = rowlists_insert(ctx,i,q);
 	(a_nnz[q])++;
       }
       /*spa[ii] -= (subpanel_tmp[q] * x);*/
@@ -2371,6 +2406,198 @@ static void spcol_panel_update(int pivotindex,
 }
 #endif
 
+/****************************************************/
+/*                                                  */
+/* Supernode updates                                */
+/*                                                  */
+/****************************************************/
+
+#ifdef SNODES
+/*
+  A supernode of L, read from disk, is held in the dense array S:
+  srows_n rows, the pivot rows of its m columns first, so the top m
+  rows form the unit lower triangular diagonal block. The panel
+  columns it updates are copied into the columns of P, one column
+  of P per panel column, with the same row order. The columns of P
+  are independent, so with TAUCS_CONFIG_PFUNC and nproc > 1 they
+  are split among up to nproc threads. Each thread solves with the
+  diagonal block, subtracts the product of the rest of S, and copies
+  its columns back into the panel's sparse accumulators. The fill
+  (row lists, nonzero maps) is recorded before the threads start,
+  so they only touch their own columns.
+*/
+
+/* updates smaller than this are applied by one thread */
+#define OOC_LU_PARALLEL_FLOPS_CUTOFF 1.0e6
+
+typedef struct {
+  taucs_datatype* S;
+  taucs_datatype* P;
+  int             srows_n;
+  int             m;         /* columns in the supernode           */
+  int             first;     /* columns of P handled by this task  */
+  int             last;
+  int*            srows;
+  int*            updcols;   /* the panel column of each column of P */
+  taucs_datatype* panel_spa;
+  int             nrows;
+} ooc_lu_snode_task;
+
+static void
+ooc_lu_snode_update(ooc_lu_snode_task* T)
+{
+  taucs_datatype* S = T->S;
+  taucs_datatype* P = T->P + (T->first * T->srows_n);
+  int srows_n = T->srows_n;
+  int m = T->m;
+  int n = T->last - T->first;
+  int M = srows_n - m;
+  int jj,kk,ii,jjp,iip;
+
+  if (n <= 0) return;
+
+#ifdef USE_BLAS
+  if (m > BLAS_THRESHOLD && n > BLAS_THRESHOLD) {
+    taucs_trsm("Left",
+	       "Lower",
+	       "No transpose",
+	       "Unit",
+	       &m,&n,
+	       &taucs_one_const,
+	       S,&srows_n,
+	       P,&srows_n
+	       );
+  } else
+#endif
+  {
+    /* TRSM */
+    for (jj=0; jj<n; jj++) {
+      for (kk=0; kk<m; kk++) {
+	for (ii=kk+1; ii<m; ii++) {
+	  P[jj*srows_n + ii] =
+	    taucs_sub(P[jj*srows_n + ii],
+		      taucs_mul(P[jj*srows_n + kk] , S[kk*srows_n + ii]));
+	}
+      }
+    }
+  }
+
+#ifdef USE_BLAS
+  if (M > BLAS_THRESHOLD && n > BLAS_THRESHOLD && m > BLAS_THRESHOLD) {
+    taucs_gemm("No transpose",
+	       "No transpose",
+	       &M,&n,&m,
+	       &taucs_minusone_const,
+	       S+m, &srows_n,
+	       P  , &srows_n,
+	       &taucs_one_const,
+	       P+m, &srows_n);
+  } else
+#endif
+  {
+    /* GEMM */
+    for (jj=0; jj<n; jj++) {
+      for (kk=0; kk<m; kk++) {
+	taucs_datatype pv = P[jj*srows_n + kk];
+	if (taucs_iszero(pv)) continue;
+	for (ii=m; ii<srows_n; ii++) {
+	  P[jj*srows_n + ii] =
+	    taucs_sub(P[jj*srows_n + ii],
+		      taucs_mul(pv , S[kk*srows_n + ii]));
+	}
+      }
+    }
+  }
+
+  /* now copy panel columns out of the dense P */
+
+  for (jjp=T->first; jjp<T->last; jjp++) {
+    taucs_datatype* spa = T->panel_spa + (T->updcols[jjp] * T->nrows);
+    taucs_datatype* Pj  = T->P + (jjp * srows_n);
+    int*            r   = T->srows;
+    for (iip=0; iip<srows_n; iip++)
+      spa[ r[iip] ] = Pj[iip];
+  }
+}
+
+#ifdef TAUCS_CONFIG_PFUNC
+static void ooc_lu_snode_thread(void* args)
+{
+  ooc_lu_snode_task* T;
+
+  pfunc_unpack(args, "void*", (void*)&T);
+  ooc_lu_snode_update(T);
+}
+#endif
+
+static void
+ooc_lu_snode_updates(ooc_lu_context* ctx,
+		     taucs_datatype* S, int srows_n, int m,
+		     taucs_datatype* P, int spa_n,
+		     int* srows, int* updcols,
+		     taucs_datatype* panel_spa, int nrows)
+{
+  ooc_lu_snode_task serial;
+
+#ifdef TAUCS_CONFIG_PFUNC
+  int nthreads = ctx->nproc < spa_n ? ctx->nproc : spa_n;
+  double flops = 2.0 * (double) spa_n * (double) srows_n * (double) m;
+
+  if (nthreads > 1 && flops >= OOC_LU_PARALLEL_FLOPS_CUTOFF) {
+    ooc_lu_snode_task* tasks   = (ooc_lu_snode_task*) taucs_malloc(nthreads * sizeof(ooc_lu_snode_task));
+    char**             args    = (char**) taucs_malloc(nthreads * sizeof(char*));
+    pfunc_handle_t*    handles = (pfunc_handle_t*) taucs_malloc(nthreads * sizeof(pfunc_handle_t));
+    int t;
+
+    if (tasks && args && handles) {
+      for (t=0; t<nthreads; t++) {
+	tasks[t].S         = S;
+	tasks[t].P         = P;
+	tasks[t].srows_n   = srows_n;
+	tasks[t].m         = m;
+	tasks[t].first     = (int) (((double) spa_n * t) / nthreads);
+	tasks[t].last      = (int) (((double) spa_n * (t+1)) / nthreads);
+	tasks[t].srows     = srows;
+	tasks[t].updcols   = updcols;
+	tasks[t].panel_spa = panel_spa;
+	tasks[t].nrows     = nrows;
+      }
+      /* the calling thread takes the first block itself */
+      for (t=1; t<nthreads; t++) {
+	pfunc_handle_init(&handles[t]);
+	pfunc_pack(&args[t], "void*", &tasks[t]);
+	pfunc_run(&handles[t], PFUNC_ATTR_DEFAULT, PFUNC_GROUP_DEFAULT,
+		  ooc_lu_snode_thread, args[t]);
+      }
+      ooc_lu_snode_update(&tasks[0]);
+      pfunc_wait_all(handles+1, nthreads-1);
+      for (t=1; t<nthreads; t++)
+	pfunc_handle_clear(handles[t]);
+      taucs_free(handles);
+      taucs_free(args);
+      taucs_free(tasks);
+      return;
+    }
+    taucs_free(handles);
+    taucs_free(args);
+    taucs_free(tasks);
+  }
+#endif
+
+  serial.S         = S;
+  serial.P         = P;
+  serial.srows_n   = srows_n;
+  serial.m         = m;
+  serial.first     = 0;
+  serial.last      = spa_n;
+  serial.srows     = srows;
+  serial.updcols   = updcols;
+  serial.panel_spa = panel_spa;
+  serial.nrows     = nrows;
+  ooc_lu_snode_update(&serial);
+}
+#endif /* SNODES */
+
 /****************************************************/
 /*                                                  */
 /* OLD STUFF                                        */
@@ -2417,7 +2644,7 @@ int x_heap_extractmin( int* heap, int* heapsize, int* ipivots)
 /****************************************************/
 
 static
-int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
+int  oocsp_numfact (ooc_lu_context* ctx, taucs_ccs_matrix* A, int* colperm,
 		    taucs_io_handle* LU,
 		    int* panels,
 		    int* schedstart,
@@ -2517,6 +2744,7 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
   taucs_datatype* S = NULL;
   taucs_datatype* P = NULL;
   int*    spa_updcols = NULL;
+  char*   spa_updmark = NULL; /* marks the panel columns in spa_updcols */
   int     spa_n;
   int*    m2 = NULL;
 
@@ -2530,12 +2758,14 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 
   int maxcolcount;
   
-  /*double time_tmp; omer*/
+#ifdef DETAILED_TIMING
+  double time_tmp;
+#endif
 
   /* READ GLOBALS */
 
   taucs_printf("oocsp_numfact: Using %.0lf MBytes of memory\n",
-	     remaining_memory/1048576.0);
+	     ctx->remaining_memory/1048576.0);
 
 
   /* START THE FACTORIZATION */
@@ -2547,31 +2777,31 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
   ncols = A->n;
 
 #ifdef DETAILED_TIMING
-  flops       = 0.0;
-  scatters    = 0.0;
-  gathers     = 0.0;
-  num_heap_ops    = 0.0;
-  rowlist_ops = 0.0;
-  time_append = 0.0;
-  time_read   = 0.0;
-  time_colcol = 0.0;
-  time_colcol_1 = 0.0;
-  time_colcol_2 = 0.0;
-  time_factor = 0.0;
-  time_scatter= 0.0;
-  time_gather = 0.0;
+  ctx->flops       = 0.0;
+  ctx->scatters    = 0.0;
+  ctx->gathers     = 0.0;
+  ctx->num_heap_ops    = 0.0;
+  ctx->rowlist_ops = 0.0;
+  ctx->time_append = 0.0;
+  ctx->time_read   = 0.0;
+  ctx->time_colcol = 0.0;
+  ctx->time_colcol_1 = 0.0;
+  ctx->time_colcol_2 = 0.0;
+  ctx->time_factor = 0.0;
+  ctx->time_scatter= 0.0;
+  ctx->time_gather = 0.0;
 #ifdef SNODES
-  time_snode_detect  = 0.0;
-  time_snode_prepare = 0.0;
-  time_snode_dense   = 0.0;
+  ctx->time_snode_detect  = 0.0;
+  ctx->time_snode_prepare = 0.0;
+  ctx->time_snode_dense   = 0.0;
 #endif
-  bytes_read  = 0.0;
-  bytes_appended = 0.0;
-  col_read    = 0.0;
-  col_ooc_updates = 0.0;
+  ctx->bytes_read  = 0.0;
+  ctx->bytes_appended = 0.0;
+  ctx->col_read    = 0.0;
+  ctx->col_ooc_updates = 0.0;
 #endif /* DETAILED_TIMING */
 
-  time_total  = taucs_wtime();
+  ctx->time_total  = taucs_wtime();
   
   maxcolcount = 0;
   for (j=0; j<ncols; j++)
@@ -2616,6 +2846,7 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
   P = (taucs_datatype*) taucs_malloc(maxcolcount * spawidth   * sizeof(taucs_datatype) );
   srows       = (int*) taucs_malloc(maxcolcount * sizeof(int) );
   spa_updcols = (int*) taucs_malloc(spawidth * sizeof(int) );
+  spa_updmark = (char*) taucs_calloc(spawidth, sizeof(char) );
 
   /*
   lu_re    = (taucs_datatype*)taucs_malloc(maxsn * nrows * sizeof(taucs_datatype) );
@@ -2678,6 +2909,17 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
     goto end;
   }
 
+#ifdef SPA_ONEARRAY
+  /* scatter/gather assume a clean map; fresh pages from the first */
+  /* call in a process happen to be zero, recycled ones are not.   */
+  if (spawidth > 0) {
+    for (i=0; i<spawidth*nrows; i++) {
+      panel_spa   [i] = taucs_zero;
+      panel_spamap[i] = 0;
+    }
+  }
+#endif
+
 #ifdef SNODES
   if (!pivots
       || !snode_pivrows
@@ -2689,6 +2931,7 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
       || !P
       || !srows
       || !spa_updcols
+      || !spa_updmark
       || !lu_re
       || !lu_ind
       ) {
@@ -2712,7 +2955,7 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
   heapsize = 0;
   for (i=0; i<nrows; i++) nnzmap[i] = 0;
 
-  if ((errorcode=rowlists_init(maxcolcount * iabs(spawidth),nrows))!=TAUCS_SUCCESS) goto end; 
+  if ((errorcode=rowlists_init(ctx,maxcolcount * iabs(spawidth),nrows))!=TAUCS_SUCCESS) goto end; 
   
   for (i=0; i<ncols; i++) ipivots[i] = INT_MAX;
 
@@ -2734,7 +2977,7 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 #else
 #endif
 
-  if ((errorcode = spa_init( nrows )) != TAUCS_SUCCESS) goto end;
+  if ((errorcode = spa_init(ctx, nrows )) != TAUCS_SUCCESS) goto end;
 
   nsteps=0; 
   for (i=0; i<ncols; i++) {
@@ -2749,7 +2992,8 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 
   for (step=1; step<=nsteps; step++) {
 
-    taucs_printf("oocsp_numfact: Starting step %d/%d\r",step,nsteps);
+    taucs_log(TAUCS_LOG_OOC,TAUCS_LOG_DEBUG,
+	      "oocsp_numfact: Starting step %d/%d\r",step,nsteps);
 
     if (p==0) {
       /*taucs_printf("oocsp_numfact: (new panel)\n");*/
@@ -2757,14 +3001,14 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
       snode_last = -1;
 #endif
 
-      if (!rowlists_isempty())
+      if (!rowlists_isempty(ctx))
 	taucs_printf("oocsp_numfact: Internal Error (row lists not empty)\n");
       if (heapsize) 
 	taucs_printf("oocsp_numfact: Internal Error (heap not empty; 1)\n");
       for (i=0; i<nrows; i++) 
 	if (nnzmap[i]) taucs_printf("oocsp_numfact: Internal Error (heap not empty; 2)\n");
     } else {
-      taucs_printf("oocsp_numfact: (same panel)\n");
+      taucs_log(TAUCS_LOG_OOC,TAUCS_LOG_DEBUG,"oocsp_numfact: (same panel)\n");
     }
     
     /* LOAD A PARTIAL PANEL */
@@ -2854,7 +3098,7 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 	  taucs_printf("oocsp_numfact: Panel wider than spawidth\n");
 	  goto end;
 	} 
-	scatter(panel_nnz[p],panel_re[p],panel_ind[p],
+	scatter(ctx,panel_nnz[p],panel_re[p],panel_ind[p],
 #ifdef SPA_ONEARRAY
 		panel_spa+(p * nrows),
 		panel_spamap+(p * nrows)
@@ -2866,13 +3110,13 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
       }
 
       for (i=0; i<panel_nnz[p]; i++) {
-	panel_inrowlist[p][i] = rowlists_insert(panel_ind[p][i],
+	panel_inrowlist[p][i] = rowlists_insert(ctx,panel_ind[p][i],
 						p);
 
 	/*if (nnzmap[ panel_ind[p][i] ] == 0 && uindices[ panel_ind[p][i] ]) {*/
 	if (nnzmap[ panel_ind[p][i] ] == 0 && !lindices[ panel_ind[p][i] ]) {
 	  nnzmap[ panel_ind[p][i] ] = 1;
-	  num_heap_insert( heap, &heapsize, ipivots, panel_ind[p][i] );
+	  num_heap_insert(ctx, heap, &heapsize, ipivots, panel_ind[p][i] );
 	}
       }
 
@@ -2885,7 +3129,7 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 #ifndef SNODES
     /* we need to prevent panel cols from being loaded! */
 
-    while ((i = num_heap_extractmin( heap, &heapsize, ipivots)) != -1) {
+    while ((i = num_heap_extractmin(ctx, heap, &heapsize, ipivots)) != -1) {
       if (i == INT_MAX) continue;
 
       nnzmap[ i ] = 0;
@@ -2911,8 +3155,8 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
       Lreadcol(LU,k,Lclen[k],lu_ind,lu_re);
 
 #ifdef DETAILED_TIMING
-      bytes_read += (double) (Lclen[k] * (sizeof(taucs_datatype)+sizeof(int)));
-      col_read += 1.0;
+      ctx->bytes_read += (double) (Lclen[k] * (sizeof(taucs_datatype)+sizeof(int)));
+      ctx->col_read += 1.0;
 #endif /* DETAILED_TIMING */
 
       /*
@@ -2927,7 +3171,7 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
       */
 
 #ifdef DETAILED_TIMING
-      time_read += (taucs_wtime() - time_tmp);
+      ctx->time_read += (taucs_wtime() - time_tmp);
 #endif
 
 
@@ -2946,30 +3190,30 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 	if (nnzmap[ lu_ind[ii] ] == 0 && !lindices[ lu_ind[ii] ]
 	    && !taucs_iszero(lu_re[ii])) {
 	  nnzmap[ lu_ind[ii] ] = 1;
-	  num_heap_insert( heap, &heapsize, ipivots, lu_ind[ii] );
+	  num_heap_insert(ctx, heap, &heapsize, ipivots, lu_ind[ii] );
 	  /*taucs_printf("oocsp_numfact: inserting row %d into heap\n",lu_ind[ii]);*/
 	}
       }
 
-      for(qp = rowlists_head[i]; qp != -1; qp = rowlists_next[qp]) {
-	q = rowlists_colind[qp];
+      for(qp = ctx->rowlists_head[i]; qp != -1; qp = ctx->rowlists_next[qp]) {
+	q = ctx->rowlists_colind[qp];
 #ifdef DETAILED_TIMING
 	time_tmp = taucs_wtime();
 #endif
 	if (spawidth <= 0) {
-	  scatter(panel_nnz[q],panel_re[q],panel_ind[q],
-		  spa,spamap);
-	  spcol_spcol_update(i,
+	  scatter(ctx,panel_nnz[q],panel_re[q],panel_ind[q],
+		  ctx->spa,ctx->spamap);
+	  spcol_spcol_update(ctx,i,
 			     lu_re,lu_ind,Lclen[k],
 			     q,panel_inrowlist[q],
-			     spa,
-			     spamap,
+			     ctx->spa,
+			     ctx->spamap,
 			     panel_ind[q],&(panel_nnz[q]),
 			     lcolcount[panel_id[q]]+ucolcount[panel_id[q]]);
-	  gather(panel_nnz[q],panel_re[q],panel_ind[q],
-		 spa,spamap);
+	  gather(ctx,panel_nnz[q],panel_re[q],panel_ind[q],
+		 ctx->spa,ctx->spamap);
 	} else {
-	  spcol_spcol_update(i,
+	  spcol_spcol_update(ctx,i,
 			     lu_re,lu_ind,Lclen[k],
 			     q,panel_inrowlist[q],
 #ifdef SPA_ONEARRAY
@@ -2983,8 +3227,8 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 			     lcolcount[panel_id[q]]+ucolcount[panel_id[q]]);
 	}
 #ifdef DETAILED_TIMING
-	time_colcol += (taucs_wtime() - time_tmp);
-	col_ooc_updates += 1.0;
+	ctx->time_colcol += (taucs_wtime() - time_tmp);
+	ctx->col_ooc_updates += 1.0;
 #endif
       }
 
@@ -3020,7 +3264,7 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 #else  /* with SNODES */
     /* we need to prevent panel cols from being loaded! */
 
-    while ((i = num_heap_extractmin( heap, &heapsize, ipivots)) != -1) {
+    while ((i = num_heap_extractmin(ctx, heap, &heapsize, ipivots)) != -1) {
       if (i == INT_MAX) continue;
 
       nnzmap[ i ] = 0;
@@ -3053,13 +3297,13 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 	/*oocsp_readcol(L,ks,lu_ind+((ks-k)*maxcolcount),lu_re+((ks-k)*maxcolcount));*/
 	Lreadcol(LU,ks,Lclen[ks],lu_ind+((ks-k)*maxcolcount),lu_re+((ks-k)*maxcolcount));
 #ifdef DETAILED_TIMING
-	bytes_read += (double) (Lclen[ks] * (sizeof(taucs_datatype)+sizeof(int)));
-	col_read += 1.0;
+	ctx->bytes_read += (double) (Lclen[ks] * (sizeof(taucs_datatype)+sizeof(int)));
+	ctx->col_read += 1.0;
 #endif /* DETAILED_TIMING */
       }
 
 #ifdef DETAILED_TIMING
-      time_read += (taucs_wtime() - time_tmp);
+      ctx->time_read += (taucs_wtime() - time_tmp);
 #endif
       /*taucs_printf("oocsp_numfact: Read supernode, %d cols %d:%d\n",ks-k,k,ks-1);*/
       
@@ -3073,7 +3317,7 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 	if (nnzmap[ lu_ind[ii] ] == 0 && !lindices[ lu_ind[ii] ]
 	    && !taucs_iszero(lu_re[ii])) {
 	  nnzmap[ lu_ind[ii] ] = 1;
-	  num_heap_insert( heap, &heapsize, ipivots, lu_ind[ii] );
+	  num_heap_insert(ctx, heap, &heapsize, ipivots, lu_ind[ii] );
 	  /*taucs_printf("oocsp_numfact: inserting row %d into heap\n",lu_ind[ii]);*/
 	}
       }
@@ -3081,7 +3325,7 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
       /* determine which panel cols need to be updates */
       dense_flag = 1;
       for (tmp = 0; tmp<1; tmp++) {
-	int jj,ii,kk,iip,jjp;
+	int jj,ii,iip,jjp;
 
 	/*	printf("snode %d:%d\n",k,ks-1);*/
 
@@ -3105,7 +3349,7 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 	/* we should keep this and restore the -1 invariant                */
 
 #ifdef DETAILED_TIMING
-	time_snode_tmp = taucs_wtime();
+	ctx->time_snode_tmp = taucs_wtime();
 #endif
 
 	for (jj=k; jj<ks; jj++) {
@@ -3131,37 +3375,32 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 	/* by this supernode.                                                 */
 
 #ifdef DETAILED_TIMING
-	time_snode_tmp = taucs_wtime();
+	ctx->time_snode_tmp = taucs_wtime();
 #endif
 
 	spa_n = 0;
 	for (jj=k; jj<ks; jj++) {
 	  ii = pivots[jj];
-	  for(qp = rowlists_head[ii]; qp != -1; qp = rowlists_next[qp]) {
-	    int skip; /* don't add a column twice to spa_updcols */
-	    q = rowlists_colind[qp];
-	    for (skip=0, jjp=0; jjp<spa_n; jjp++) {
-	      if (spa_updcols[jjp] == q) {
-		skip = 1;
-		break;
-	      }
-	    }
-	    if (!skip) {
+	  for(qp = ctx->rowlists_head[ii]; qp != -1; qp = ctx->rowlists_next[qp]) {
+	    q = ctx->rowlists_colind[qp];
+	    if (!spa_updmark[q]) { /* don't add a column twice to spa_updcols */
 	      /*if (jj-k > 4) printf("*** jj-k %d ks-k %d\n",jj-k,ks-k);*/
 
 #ifdef DETAILED_TIMING
-	      flops += 2.0 * ( (ks-jj) * (srows_n - (jj-k)) - 0.5*(ks-jj)*(ks-jj) );
-	      flops_extra += 2.0 * ( (jj-k) * (srows_n) - 0.5*(jj-k)*(jj-k) );
+	      ctx->flops += 2.0 * ( (ks-jj) * (srows_n - (jj-k)) - 0.5*(ks-jj)*(ks-jj) );
+	      ctx->flops_extra += 2.0 * ( (jj-k) * (srows_n) - 0.5*(jj-k)*(jj-k) );
 #endif /* DETAILED_TIMING */
 
+	      spa_updmark[q] = 1;
 	      spa_updcols[spa_n] = q;
 	      /*spa_updptrs[spa_n] = jj-k;*/
 	      spa_n++;
 	    }
 	  }
 	}
+	for (jjp=0; jjp<spa_n; jjp++) spa_updmark[ spa_updcols[jjp] ] = 0;
 #ifdef DETAILED_TIMING
-	time_snode_1 += (taucs_wtime()-time_snode_tmp);
+	ctx->time_snode_1 += (taucs_wtime()-ctx->time_snode_tmp);
 #endif
 
 	if (spa_n < SNODE_THRESHOLD) {
@@ -3195,109 +3434,43 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 	  }
 	}
 #ifdef DETAILED_TIMING
-	time_snode_3 += (taucs_wtime()-time_snode_tmp);
+	ctx->time_snode_3 += (taucs_wtime()-ctx->time_snode_tmp);
 #endif
 
 	/* now the snode is stored in a dense array S, with row indices srows */
 	/* and with the diagonal block of L on top.                           */
 
 	/* next we copy the columns of the panels that need to be updated     */
-	/* into the dense array P.                                            */
-
-	/* we then copy these columns into the dense array P, and if          */
-	/* fill occurs, we update the nonzero bitmap and row lists.           */
+	/* into the dense array P. If fill occurs, we update the nonzero      */
+	/* bitmap and row lists as we go, so a single pass over each column   */
+	/* suffices.                                                          */
 
 #ifdef DETAILED_TIMING
-	time_snode_tmp = taucs_wtime();
+	ctx->time_snode_tmp = taucs_wtime();
 #endif
-#define OLD_1_no
-#ifdef OLD_1
 	for (jjp=0; jjp<spa_n; jjp++) {
+	  taucs_datatype* spa    = panel_spa    + (spa_updcols[jjp] * nrows);
+	  char*           spamap = panel_spamap + (spa_updcols[jjp] * nrows);
+	  taucs_datatype* Pj     = P + (jjp * srows_n);
+	  
 	  jj = spa_updcols[jjp];
 
 	  for (iip=0; iip<srows_n; iip++) {
-	  /*for (iip=spa_updptrs[jjp]; iip<srows_n; iip++) {*/
-	    if (panel_spamap[jj*nrows + srows[iip]] == 0) {
-	      /* fill will occur here */
-	      panel_spa[jj*nrows + srows[iip]] = taucs_zero;
-	      /*P[jjp*srows_n + iip] = taucs_zero;*/
-	      
-	      panel_spamap   [jj*nrows + srows[iip]] = 1;
-	      panel_ind      [jj][panel_nnz[jj] ] = srows[iip];
-	      panel_inrowlist[jj][panel_nnz[jj] ] = rowlists_insert(srows[iip],jj);
+	    ii = srows[iip];
+	    if (spamap[ii] == 0) {
+	      spamap[ii] = 1;
+	      spa   [ii] = taucs_zero;
+	      panel_ind      [jj][panel_nnz[jj] ] = ii;
+	      panel_inrowlist[jj][panel_nnz[jj] ] = rowlists_insert(ctx,ii,jj);
 	      (panel_nnz[jj])++;
 	    }
-#ifdef JUNK
-	    } else { 
-	      /* no fill, just copy the element */
-  	      P[jjp*srows_n + iip] = panel_spa[jj*nrows + srows[iip]];
-	    }
-#endif
-	  }
-	} 
-
-	{ 
-#ifdef DETAILED_TIMING
-	  double x = taucs_wtime();
-#endif
-	  for (jjp=0; jjp<spa_n; jjp++) {
-	    jj = spa_updcols[jjp];
-	    for (iip=0; iip<srows_n; iip++) {
-	      P[jjp*srows_n + iip] = panel_spa[jj*nrows + srows[iip]];
-	    }
-	  }
-#ifdef DETAILED_TIMING
-	  time_snode_21 += (taucs_wtime()-x);
-#endif
-        }
-#else /* OLD_1 */
-	for (jjp=0; jjp<spa_n; jjp++) {
-	  int iip_block, loop_bound, flag;
-	  
-	  jj = spa_updcols[jjp];
-
-	  for (iip_block=0; iip_block<srows_n; iip_block += SNODE_BLOCK) {
-
-	    loop_bound = min(iip_block + SNODE_BLOCK,srows_n);
-	    
-	    flag = 1;
-	    for (iip=iip_block; iip<loop_bound; iip++)
-	      flag &= panel_spamap[jj*nrows + srows[iip]];
-	     
-	    if (!flag) {
-	      for (iip=iip_block; iip<loop_bound; iip++) {
-		if (panel_spamap[jj*nrows + srows[iip]] == 0) {
-		  panel_spamap   [jj*nrows + srows[iip]] = 1;
-		  panel_spa      [jj*nrows + srows[iip]] = taucs_zero;
-		  panel_ind      [jj][panel_nnz[jj] ] = srows[iip];
-		  panel_inrowlist[jj][panel_nnz[jj] ] = rowlists_insert(srows[iip],jj);
-		  (panel_nnz[jj])++;
-		}
-	      }
-	    }
-	  }
-	  
-	  { 
-#ifdef DETAILED_TIMING
-	    double x = taucs_wtime();
-#endif
-	    for (iip=0; iip<srows_n; iip++)
-	      P[jjp*srows_n + iip] = panel_spa[jj*nrows + srows[iip]];
-#ifdef DETAILED_TIMING
-	    time_snode_21 += (taucs_wtime()-x);
-#endif
+	    Pj[iip] = spa[ii];
 	  }
 	}
-#endif /* OLD_1 */
 
 #ifdef DETAILED_TIMING
-	time_snode_2 += (taucs_wtime()-time_snode_tmp);
-#endif
-
-	/*printf("supernode update: col %d pivotrow %d updates col %d\n",jj,ii,panel_id[q]);*/
- 
-#ifdef DETAILED_TIMING
-	time_snode_prepare += (taucs_wtime() - time_tmp);
+	ctx->time_snode_2 += (taucs_wtime()-ctx->time_snode_tmp);
+	ctx->time_snode_prepare += (taucs_wtime() - time_tmp);
 #endif
 
 #ifdef DETAILED_TIMING
@@ -3307,125 +3480,18 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 	/*flops += (2.0 * spa_n * srows_n * (ks-k) - 2.0); */ /* over estimate; sivan. */
 	/* we can subract triangle in estimate, skip zero pivots in flops & code */
 #ifdef DETAILED_TIMING
-	flops_dense += (2.0 * spa_n * srows_n * (ks-k) -
+	ctx->flops_dense += (2.0 * spa_n * srows_n * (ks-k) -
 			1.0 * spa_n * (ks-k) * (ks-k)); 
 #endif /* DETAILED_TIMING */
 
-#ifdef JUNK
-	printf("TRSM's RHS:\n");
-	for (kk=k; kk<ks; kk++) {
-	  for (jj=0; jj<spa_n; jj++) {
-	    printf("%c", P[jj*srows_n + (kk-k)] ? '*' : 'o');
-	  }
-	  printf("\n");
-	}
-#endif
+	/* TRSM and GEMM into P, then copy P back into the panel */
 
-#ifdef USE_BLAS
-	{ 
-	  int m = ks-k;
-	  int n = spa_n;
-	  int M = srows_n - m;
-	  int N = n;
-	  int K = m;
-	  
-	  if (m > BLAS_THRESHOLD && n > BLAS_THRESHOLD) {
-	    taucs_trsm("Left",
-		       "Lower",
-		       "No transpose",
-		       "Unit",
-		       &m,&n,
-		       &taucs_one_const,
-		       S,&srows_n,
-		       P,&srows_n
-		       );
-	  } else {
-	    /* TRSM */
-	    for (jj=0; jj<spa_n; jj++) {
-	      for (kk=k; kk<ks; kk++) {
-		for (ii=kk-k+1; ii<(ks-k); ii++) {
-		  /*P[jj*srows_n + ii] -= (P[jj*srows_n + (kk-k)] * S[(kk-k)*srows_n + ii]);*/
-		  P[jj*srows_n + ii] = 
-		  taucs_sub(P[jj*srows_n + ii],
-			    taucs_mul(P[jj*srows_n + (kk-k)] , S[(kk-k)*srows_n + ii]));
-		}
-	      }
-	    }
-	  }
+	ooc_lu_snode_updates(ctx,S,srows_n,ks-k,P,spa_n,
+			     srows,spa_updcols,panel_spa,nrows);
 
-	  if (M > BLAS_THRESHOLD && N > BLAS_THRESHOLD && K > BLAS_THRESHOLD) {
-	    taucs_gemm("No transpose",
-		       "No transpose",
-		       &M,&N,&K,
-		       &taucs_minusone_const,
-		       S+m, &srows_n,
-		       P  , &srows_n,
-		       &taucs_one_const,
-		       P+m, &srows_n);
-	  } else {
-	    /* GEMM */
-	    for (jj=0; jj<spa_n; jj++) {
-	      for (kk=k; kk<ks; kk++) {
-		for (ii=(ks-k); ii<srows_n; ii++) {
-		  /*P[jj*srows_n + ii] -= (P[jj*srows_n + (kk-k)] * S[(kk-k)*srows_n + ii]);*/
-		  P[jj*srows_n + ii] =
-		    taucs_sub(P[jj*srows_n + ii],
-			      taucs_mul(P[jj*srows_n + (kk-k)] , S[(kk-k)*srows_n + ii]));
-		}
-	      }
-	    }
-	  }
-	}
-#else	   
-	/* TRSM */
-	for (jj=0; jj<spa_n; jj++) {
-	  for (kk=k; kk<ks; kk++) {
-	    for (ii=kk-k+1; ii<(ks-k); ii++) {
-	      P[jj*srows_n + ii] =
-		taucs_sub(P[jj*srows_n + ii],
-			  taucs_mul(P[jj*srows_n + (kk-k)] , S[(kk-k)*srows_n + ii]));
-	      /*P[jj*srows_n + ii] -= (P[jj*srows_n + (kk-k)] * S[(kk-k)*srows_n + ii]);*/
-	    }
-	  }
-	}
-
-	/* GEMM */
-	for (jj=0; jj<spa_n; jj++) {
-	  for (kk=k; kk<ks; kk++) {
-	    for (ii=(ks-k); ii<srows_n; ii++) {
-	      P[jj*srows_n + ii] =
-		taucs_sub(P[jj*srows_n + ii],
-			  taucs_mul(P[jj*srows_n + (kk-k)] , S[(kk-k)*srows_n + ii]));
-
-	      /*P[jj*srows_n + ii] -= (P[jj*srows_n + (kk-k)] * S[(kk-k)*srows_n + ii]);*/
-	    }
-	  }
-	}
-#endif
 #ifdef DETAILED_TIMING
-	time_snode_dense += (taucs_wtime() - time_tmp);
-	col_ooc_updates += 1.0;
-#endif
-
-#ifdef DETAILED_TIMING
-	time_tmp = taucs_wtime();
-#endif
-
-	/* now copy panel columns out of the dense P */
-
-#ifdef DETAILED_TIMING
-	time_snode_tmp = taucs_wtime();
-#endif
-	for (jjp=0; jjp<spa_n; jjp++) {
-	  jj = spa_updcols[jjp];
-	  for (iip=0; iip<srows_n; iip++) {
-	    /*for (iip=spa_updptrs[jjp]; iip<srows_n; iip++) {*/
-	    panel_spa[jj*nrows + srows[iip] ] = P[jjp*srows_n + iip];
-	  }
-	}
-#ifdef DETAILED_TIMING
-	time_snode_4 += (taucs_wtime()-time_snode_tmp);
-        time_snode_prepare += (taucs_wtime() - time_tmp);
+	ctx->time_snode_dense += (taucs_wtime() - time_tmp);
+	ctx->col_ooc_updates += 1.0;
 #endif
       }
       if (!dense_flag) { /* we didn't do it using the blas since m,n, or k were too small */
@@ -3438,8 +3504,8 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 	    taucs_printf("oocsp_numfact: internal error (supernode update)\n");
 	    exit(1);
 	  }
-	  for(qp = rowlists_head[ii]; qp != -1; qp = rowlists_next[qp]) {
-	    q = rowlists_colind[qp];
+	  for(qp = ctx->rowlists_head[ii]; qp != -1; qp = ctx->rowlists_next[qp]) {
+	    q = ctx->rowlists_colind[qp];
 	    /*printf("supernode update: col %d pivotrow %d updates col %d\n",jj,ii,panel_id[q]);*/
 
 #ifdef DETAILED_TIMING
@@ -3449,7 +3515,7 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 	      taucs_printf("oocsp_numfact: internal error (supernode without a spa)\n");
 	      exit(1);
 	    } else {
-	      spcol_spcol_update(ii,
+	      spcol_spcol_update(ctx,ii,
 				 lu_re+((jj-k)*maxcolcount),lu_ind+((jj-k)*maxcolcount),Lclen[jj],
 				 q,panel_inrowlist[q],
 #ifdef SPA_ONEARRAY
@@ -3463,9 +3529,9 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 				 lcolcount[panel_id[q]]+ucolcount[panel_id[q]]);
 	    }
 #ifdef DETAILED_TIMING
-	    time_colcol   += (taucs_wtime() - time_tmp);
-	    time_colcol_1 += (taucs_wtime() - time_tmp);
-	    col_ooc_updates += 1.0;
+	    ctx->time_colcol   += (taucs_wtime() - time_tmp);
+	    ctx->time_colcol_1 += (taucs_wtime() - time_tmp);
+	    ctx->col_ooc_updates += 1.0;
 #endif
 	  }
 	}
@@ -3496,7 +3562,7 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
       /* gather */
 
       if (spawidth > 0) {
-	gather(panel_nnz[p],panel_re[p],panel_ind[p],
+	gather(ctx,panel_nnz[p],panel_re[p],panel_ind[p],
 #ifdef SPA_ONEARRAY
 	       panel_spa + (p * nrows),
 	       panel_spamap + (p * nrows));
@@ -3577,11 +3643,11 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
       }
 
 #ifdef DETAILED_TIMING
-      flops += (double) lnext;
+      ctx->flops += (double) lnext;
 #endif /* DETAILED_TIMING */
       
 #ifdef DETAILED_TIMING
-      time_factor += (taucs_wtime() - time_tmp);
+      ctx->time_factor += (taucs_wtime() - time_tmp);
 #endif
 
       /* Write out column of L, U */
@@ -3609,11 +3675,11 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
       Uclen[j] = maxcolcount - 1 - unext;
       if ((errorcode=Uappendcol(LU,j,maxcolcount - 1 - unext,lu_ind + (unext+1),lu_re  + (unext+1)))!=TAUCS_SUCCESS) goto end;
 #ifdef DETAILED_TIMING
-      time_append += (taucs_wtime() - time_tmp);
+      ctx->time_append += (taucs_wtime() - time_tmp);
 #endif
 
 #ifdef DETAILED_TIMING
-      bytes_appended += (double) ((maxcolcount - 1 - unext) 
+      ctx->bytes_appended += (double) ((maxcolcount - 1 - unext) 
 				  * (sizeof(taucs_datatype)+sizeof(int)));
 #endif /* DETAILED_TIMING */
 
@@ -3690,17 +3756,17 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 	snode_size++;
 
 	for (ii=0; ii<snode_size; ii++)
-	  spa[snode_pivrows[ii]] = taucs_zero;
+	  ctx->spa[snode_pivrows[ii]] = taucs_zero;
 	for (ii=0; ii<lnext; ii++)
-	  spa[lu_ind[ii]] = lu_re[ii];
+	  ctx->spa[lu_ind[ii]] = lu_re[ii];
 
 	for (ii=0; ii<snode_nnz; ii++) {
 	  assert(ii < nrows);
-	  snode_re[ii] = spa[snode_ind[ii]];
+	  snode_re[ii] = ctx->spa[snode_ind[ii]];
 	}
 
 #ifdef DETAILED_TIMING
-	time_snode_detect += (taucs_wtime() - time_tmp);
+	ctx->time_snode_detect += (taucs_wtime() - time_tmp);
 	time_tmp = taucs_wtime();
 #endif
 
@@ -3711,8 +3777,8 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 	if ((errorcode=Lappendcol(LU,j,snode_nnz,snode_ind,snode_re))!=TAUCS_SUCCESS) goto end;
 
 #ifdef DETAILED_TIMING
-	time_append += (taucs_wtime() - time_tmp);
-	bytes_appended += (double) (snode_nnz
+	ctx->time_append += (taucs_wtime() - time_tmp);
+	ctx->bytes_appended += (double) (snode_nnz
 				    * (sizeof(taucs_datatype)+sizeof(int)));
 #endif
 
@@ -3725,7 +3791,7 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 	/*taucs_printf("oocsp_numfact: new supernode, column %d row %d\n",j,pivotindex);*/
 
 #ifdef DETAILED_TIMING
-	time_snode_detect += (taucs_wtime() - time_tmp);
+	ctx->time_snode_detect += (taucs_wtime() - time_tmp);
 	time_tmp = taucs_wtime();
 #endif
       
@@ -3735,8 +3801,8 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 	if ((errorcode=Lappendcol(LU,j,lnext,lu_ind,lu_re))!=TAUCS_SUCCESS) goto end;
 
 #ifdef DETAILED_TIMING
-	time_append += (taucs_wtime() - time_tmp);
-	bytes_appended += (double) (lnext 
+	ctx->time_append += (taucs_wtime() - time_tmp);
+	ctx->bytes_appended += (double) (lnext 
 				    * (sizeof(taucs_datatype)+sizeof(int)));
 	time_tmp = taucs_wtime();
 #endif
@@ -3752,7 +3818,7 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 	snode_size = 1;
 
 #ifdef DETAILED_TIMING
-	time_snode_detect += (taucs_wtime() - time_tmp);
+	ctx->time_snode_detect += (taucs_wtime() - time_tmp);
 #endif
       }
 
@@ -3770,8 +3836,8 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
       Lclen[j] = lnext;
       if ((errorcode=Lappendcol(LU,j,lnext,lu_ind,lu_re))!=TAUCS_SUCCESS) goto end;
 #ifdef DETAILED_TIMING
-      time_append += (taucs_wtime() - time_tmp);
-      bytes_appended += (double) (lnext 
+      ctx->time_append += (taucs_wtime() - time_tmp);
+      ctx->bytes_appended += (double) (lnext 
 				  * (sizeof(taucs_datatype)+sizeof(int)));
 #endif /* DETAILED_TIMING */
 
@@ -3785,24 +3851,24 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
       time_tmp = taucs_wtime();
 #endif
       if (spawidth <= 0) {
-	for(qp = rowlists_head[pivotindex]; qp != -1; qp = rowlists_next[qp]) {
-	  q = rowlists_colind[qp];
-	  scatter(panel_nnz[q],panel_re[q],panel_ind[q],
-		  spa,spamap);
-	  spcol_spcol_update(pivotindex,
+	for(qp = ctx->rowlists_head[pivotindex]; qp != -1; qp = ctx->rowlists_next[qp]) {
+	  q = ctx->rowlists_colind[qp];
+	  scatter(ctx,panel_nnz[q],panel_re[q],panel_ind[q],
+		  ctx->spa,ctx->spamap);
+	  spcol_spcol_update(ctx,pivotindex,
 			     lu_re,lu_ind,lnext,
 			     q,panel_inrowlist[q],
-			     spa,
-			     spamap,
+			     ctx->spa,
+			     ctx->spamap,
 			     panel_ind[q],&(panel_nnz[q]),
 			     lcolcount[panel_id[q]]+ucolcount[panel_id[q]]);
-	  gather(panel_nnz[q],panel_re[q],panel_ind[q],
-		 spa,spamap);
+	  gather(ctx,panel_nnz[q],panel_re[q],panel_ind[q],
+		 ctx->spa,ctx->spamap);
 	}
       } else {
 	int spa_n = 0;
-	for(qp = rowlists_head[pivotindex]; qp != -1; qp = rowlists_next[qp]) {
-	  q = rowlists_colind[qp];
+	for(qp = ctx->rowlists_head[pivotindex]; qp != -1; qp = ctx->rowlists_next[qp]) {
+	  q = ctx->rowlists_colind[qp];
 	  /* sivan 20 oct 2003: I am not sure the ifdef is right */
 #ifdef SNODES
 	  spa_updcols[spa_n] = q;
@@ -3823,7 +3889,7 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 	}
 	*/
 
-	spcol_spa_update(pivotindex,
+	spcol_spa_update(ctx,pivotindex,
 			 lu_re,lu_ind,lnext,
 			 spa_updcols,spa_n,nrows,
 			 panel_inrowlist,
@@ -3832,8 +3898,8 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 			 panel_ind,panel_nnz);
       }
 #ifdef DETAILED_TIMING
-      time_colcol   += (taucs_wtime() - time_tmp);
-      time_colcol_2 += (taucs_wtime() - time_tmp);
+      ctx->time_colcol   += (taucs_wtime() - time_tmp);
+      ctx->time_colcol_2 += (taucs_wtime() - time_tmp);
 #endif
 
       /*taucs_printf("oocsp_numfact: done updating\n");*/
@@ -3842,7 +3908,7 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
 
       for (ip = 0; ip<panel_nnz[p]; ip++) {
 	i = panel_ind[p][ip];
-	rowlists_delete(i,panel_inrowlist[p][ip]);
+	rowlists_delete(ctx,i,panel_inrowlist[p][ip]);
       }
 
       /*taucs_printf("freeing panel_ind[%d] = %08x\n",p,panel_ind[p]);*/
@@ -3906,7 +3972,7 @@ int  oocsp_numfact (taucs_ccs_matrix* A, int* colperm,
   if (((errorcode=taucs_io_append(LU, HEADER_LCLEN  , (A->n), 1, TAUCS_INT, Lclen      ))) != TAUCS_SUCCESS) goto end;
   if (((errorcode=taucs_io_append(LU, HEADER_UCLEN  , (A->n), 1, TAUCS_INT, Uclen      ))) != TAUCS_SUCCESS) goto end;
 
-  (remaining_memory) += (double) ( 2 * (ncols+1) * sizeof(int));
+  (ctx->remaining_memory) += (double) ( 2 * (ncols+1) * sizeof(int));
 
   {
     double nnzL = 0;
@@ -3932,9 +3998,9 @@ end:
     taucs_free(panel_spamap);
   }
 
-  spa_finalize();
+  spa_finalize(ctx);
 
-  rowlists_finalize();
+  rowlists_finalize(ctx);
 
   taucs_free(ipivots);
 
@@ -3968,6 +4034,7 @@ end:
   taucs_free(pivots);
 
   taucs_free(spa_updcols);
+  taucs_free(spa_updmark);
   taucs_free(P);
   taucs_free(S);
   taucs_free(srows);
@@ -3986,51 +4053,50 @@ end:
 
   /* OLD */
 
-  time_total = taucs_wtime() - time_total;
-  taucs_printf("oocsp_numfact: %lg sec total\n",time_total);
+  ctx->time_total = taucs_wtime() - ctx->time_total;
+  taucs_printf("oocsp_numfact: %lg sec total\n",ctx->time_total);
 
 #ifdef DETAILED_TIMING
-  taucs_printf("oocsp_numfact: %lg extra flops, %2.0lf %\n",flops_extra,100.0*flops_extra/flops);
-  taucs_printf("oocsp_numfact: %lg dense flops, %2.0lf %\n",flops_dense,100.0*flops_dense/flops);
-  taucs_printf("oocsp_numfact: %lg Mflop dense/s\n",(flops_dense*1e-6)/(time_snode_dense));
+  taucs_printf("oocsp_numfact: %lg extra flops, %2.0lf %\n",ctx->flops_extra,100.0*ctx->flops_extra/ctx->flops);
+  taucs_printf("oocsp_numfact: %lg dense flops, %2.0lf %\n",ctx->flops_dense,100.0*ctx->flops_dense/ctx->flops);
+  taucs_printf("oocsp_numfact: %lg Mflop dense/s\n",(ctx->flops_dense*1e-6)/(ctx->time_snode_dense));
  
-  taucs_printf("oocsp_numfact: %lg flops\n",flops);
-  taucs_printf("oocsp_numfact: %lg scatter ops\n",scatters);
-  taucs_printf("oocsp_numfact: %lg gather  ops\n",gathers);
-  taucs_printf("oocsp_numfact: %lg heap    ops\n",num_heap_ops);
-  taucs_printf("oocsp_numfact: %lg rowlist ops\n",rowlist_ops);
-  taucs_printf("oocsp_numfact: %lg sec col/col ops\n",time_colcol);
-  taucs_printf("oocsp_numfact: %lg sec col/col ops (%lg+%lg=%lg)\n",time_colcol,
-	     time_colcol_1,time_colcol_2,(time_colcol_1+time_colcol_2));
-  taucs_printf("oocsp_numfact: %lg sec column factor ops\n",time_factor);
-  taucs_printf("oocsp_numfact: %lg sec scatter ops\n",time_scatter);
-  taucs_printf("oocsp_numfact: %lg sec gather  ops\n",time_gather);
-  taucs_printf("oocsp_numfact: %lg sec io read\n",time_read);
-  taucs_printf("oocsp_numfact: %lg sec io write\n",time_append);
+  taucs_printf("oocsp_numfact: %lg flops\n",ctx->flops);
+  taucs_printf("oocsp_numfact: %lg scatter ops\n",ctx->scatters);
+  taucs_printf("oocsp_numfact: %lg gather  ops\n",ctx->gathers);
+  taucs_printf("oocsp_numfact: %lg heap    ops\n",ctx->num_heap_ops);
+  taucs_printf("oocsp_numfact: %lg rowlist ops\n",ctx->rowlist_ops);
+  taucs_printf("oocsp_numfact: %lg sec col/col ops\n",ctx->time_colcol);
+  taucs_printf("oocsp_numfact: %lg sec col/col ops (%lg+%lg=%lg)\n",ctx->time_colcol,
+	     ctx->time_colcol_1,ctx->time_colcol_2,(ctx->time_colcol_1+ctx->time_colcol_2));
+  taucs_printf("oocsp_numfact: %lg sec column factor ops\n",ctx->time_factor);
+  taucs_printf("oocsp_numfact: %lg sec scatter ops\n",ctx->time_scatter);
+  taucs_printf("oocsp_numfact: %lg sec gather  ops\n",ctx->time_gather);
+  taucs_printf("oocsp_numfact: %lg sec io read\n",ctx->time_read);
+  taucs_printf("oocsp_numfact: %lg sec io write\n",ctx->time_append);
 #ifdef SNODES
-  taucs_printf("oocsp_numfact: %lg sec snode preparations for dense ops\n",time_snode_prepare);
-  taucs_printf("oocsp_numfact: %lg sec snode dense ops\n",time_snode_dense);
-  taucs_printf("oocsp_numfact: %lg sec snode detection\n",time_snode_detect);
-  taucs_printf("oocsp_numfact: %lg sec snode 1\n",time_snode_1);
-  taucs_printf("oocsp_numfact: %lg sec snode 2 (%lg)\n",time_snode_2,
-		                                      time_snode_21);
-  taucs_printf("oocsp_numfact: %lg sec snode 3\n",time_snode_3);
-  taucs_printf("oocsp_numfact: %lg sec snode 4\n",time_snode_4);
+  taucs_printf("oocsp_numfact: %lg sec snode preparations for dense ops\n",ctx->time_snode_prepare);
+  taucs_printf("oocsp_numfact: %lg sec snode dense ops\n",ctx->time_snode_dense);
+  taucs_printf("oocsp_numfact: %lg sec snode detection\n",ctx->time_snode_detect);
+  taucs_printf("oocsp_numfact: %lg sec snode 1\n",ctx->time_snode_1);
+  taucs_printf("oocsp_numfact: %lg sec snode 2 (%lg)\n",ctx->time_snode_2,
+		                                      ctx->time_snode_21);
+  taucs_printf("oocsp_numfact: %lg sec snode 3\n",ctx->time_snode_3);
+  taucs_printf("oocsp_numfact: %lg sec snode 4\n",ctx->time_snode_4);
 #endif
   taucs_printf("oocsp_numfact: \n");
-  taucs_printf("oocsp_numfact: %lg Mflop/s\n",(flops*1e-6)/(time_total));
-  taucs_printf("oocsp_numfact: %lg MB/s IO read\n",(bytes_read*1e-6)/(time_read));
-  taucs_printf("oocsp_numfact: %lg MB/s IO write\n",(bytes_appended*1e-6)/(time_append));
-  taucs_printf("oocsp_numfact: %lg col reuse\n",col_ooc_updates/col_read);
-  taucs_printf("oocsp_numfact: %lg percent IO\n",(time_read+time_append)/time_total);
-  taucs_printf("oocsp_numfact: %lg percent col/col\n",(time_colcol)/time_total);
+  taucs_printf("oocsp_numfact: %lg Mflop/s\n",(ctx->flops*1e-6)/(ctx->time_total));
+  taucs_printf("oocsp_numfact: %lg MB/s IO read\n",(ctx->bytes_read*1e-6)/(ctx->time_read));
+  taucs_printf("oocsp_numfact: %lg MB/s IO write\n",(ctx->bytes_appended*1e-6)/(ctx->time_append));
+  taucs_printf("oocsp_numfact: %lg col reuse\n",ctx->col_ooc_updates/ctx->col_read);
+  taucs_printf("oocsp_numfact: %lg percent IO\n",(ctx->time_read+ctx->time_append)/ctx->time_total);
+  taucs_printf("oocsp_numfact: %lg percent col/col\n",(ctx->time_colcol)/ctx->time_total);
 #endif
 
 
 #ifndef SIMPLE_COL_COL
   {
-    extern int oocsp_spcol_n1,oocsp_spcol_n2;
-    taucs_printf("oocsp_numfact: spcol counts %d %d\n",oocsp_spcol_n1,oocsp_spcol_n2);
+    taucs_printf("oocsp_numfact: spcol counts %d %d\n",ctx->oocsp_spcol_n1,ctx->oocsp_spcol_n2);
   }
 #endif
 
@@ -4044,7 +4110,7 @@ end:
 
 static 
 int
-oocsp_factor(taucs_ccs_matrix* A_in,
+oocsp_factor(ooc_lu_context* ctx, taucs_ccs_matrix* A_in,
       taucs_io_handle* LU,
       int*  colperm)
 {
@@ -4075,13 +4141,13 @@ oocsp_factor(taucs_ccs_matrix* A_in,
   taucs_printf("taucs_ooc_lu: starting\n");
 
   taucs_printf("taucs_ooc_lu: calling colanalyze\n");
-  rc = oocsp_colanalyze(A_in,
+  rc = oocsp_colanalyze(ctx,A_in,
 	   	        taucs_io_get_basename(LU),
 		        colperm,&etree,&postorder,&l_colcounts,&u_colcounts);
   if (rc != TAUCS_SUCCESS) return rc;
 
   taucs_printf("taucs_ooc_lu: calling panelize\n");
-  rc = oocsp_panelize_simple(A_in->m,A_in->n,
+  rc = oocsp_panelize_simple(ctx,A_in->m,A_in->n,
 	  	             postorder,
                              l_colcounts,u_colcounts,etree,
 			     &spawidth,&maxsn,
@@ -4092,7 +4158,7 @@ oocsp_factor(taucs_ccs_matrix* A_in,
   if (rc != TAUCS_SUCCESS) return rc;
 
   taucs_printf("taucs_ooc_lu: calling numfact\n");
-  rc = oocsp_numfact(A_in,colperm,
+  rc = oocsp_numfact(ctx,A_in,colperm,
 	  	     /*L,U,*/
 		     LU,
 		     panels,schedstart,schedend,fetchnext,ejectnext,
@@ -4111,16 +4177,36 @@ oocsp_factor(taucs_ccs_matrix* A_in,
   return TAUCS_SUCCESS;
 }
 
+int
+taucs_dtl(ooc_factor_lu_parallel)(taucs_ccs_matrix* A_in,
+				  int    colperm[],
+				  taucs_io_handle* LU,
+				  double memory,
+				  int    nproc)
+{
+  ooc_lu_context ctx;
+
+#ifndef TAUCS_CONFIG_PFUNC
+  if (nproc > 1) 
+    taucs_printf("taucs_ooc_factor_lu: PFUNC not configured, using 1 thread\n");
+  nproc = 1;
+#endif
+  if (nproc < 1) nproc = 1;
+
+  ooc_lu_context_init(&ctx,memory);
+  ctx.nproc = nproc;
+  taucs_printf("taucs_ooc_factor_lu: using %.0lf MBytes of in-core memory, %d threads\n",
+	     (ctx.remaining_memory)/1048576.0,nproc);
+  return oocsp_factor(&ctx,A_in,LU,colperm);
+}
+
 int
 taucs_dtl(ooc_factor_lu)(taucs_ccs_matrix* A_in,
 		         int    colperm[],
                          taucs_io_handle* LU,
 		         double memory)
 {
-  remaining_memory = memory;
-  taucs_printf("taucs_ooc_factor_lu: using %.0lf MBytes of in-core memory\n",
-	     (remaining_memory)/1048576.0);
-  return oocsp_factor(A_in,LU,colperm);
+  return taucs_dtl(ooc_factor_lu_parallel)(A_in,colperm,LU,memory,1);
 }
 
 /*********************************************************/
@@ -4336,6 +4422,39 @@ int taucs_ooc_factor_lu(taucs_ccs_matrix* A,
   return TAUCS_ERROR_DATATYPE;
 }
 
+int taucs_ooc_factor_lu_parallel(taucs_ccs_matrix* A,
+				 int*              colperm,
+				 taucs_io_handle*  LU,
+				 double            memory,
+				 int               nproc)
+{
+#ifdef TAUCS_CONFIG_DREAL
+  if (A->flags & TAUCS_DOUBLE) {
+    return taucs_dooc_factor_lu_parallel(A,colperm,LU,memory,nproc);
+  }
+#endif
+
+#ifdef TAUCS_CONFIG_DCOMPLEX
+  if (A->flags & TAUCS_DCOMPLEX) {
+    return taucs_zooc_factor_lu_parallel(A,colperm,LU,memory,nproc);
+  }
+#endif
+
+#ifdef TAUCS_CONFIG_SREAL
+  if (A->flags & TAUCS_SINGLE) {
+    return taucs_sooc_factor_lu_parallel(A,colperm,LU,memory,nproc);
+  }
+#endif
+
+#ifdef TAUCS_CONFIG_SCOMPLEX
+  if (A->flags & TAUCS_SCOMPLEX) {
+    return taucs_cooc_factor_lu_parallel(A,colperm,LU,memory,nproc);
+  }
+#endif
+
+  return TAUCS_ERROR_DATATYPE;
+}
+
 int taucs_ooc_solve_lu (void* vLU,
 			void* x, void* b)
 {
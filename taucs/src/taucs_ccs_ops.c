@@ -64,7 +64,8 @@ taucs_dtl(ccs_split)(taucs_ccs_matrix*  A,
 		     int p)
 {
   int i,n;
-  int Lnnz, Rnnz;
+  taucs_index ip;
+  taucs_index Lnnz, Rnnz;
 
   assert((A->flags & TAUCS_SYMMETRIC) || (A->flags & TAUCS_TRIANGULAR));
   assert(A->flags & TAUCS_LOWER);
@@ -88,11 +89,11 @@ taucs_dtl(ccs_split)(taucs_ccs_matrix*  A,
   (*L)->flags |= TAUCS_SYMMETRIC | TAUCS_LOWER;
   (*L)->n = n;
   (*L)->m = n;
-  (*L)->colptr = (int*)    taucs_malloc((n+1) * sizeof(int));
+  (*L)->colptr = (taucs_index*) taucs_malloc((n+1) * sizeof(taucs_index));
   (*L)->rowind = (int*)    taucs_malloc(Lnnz   * sizeof(int));
   (*L)->taucs_values = (void*)   taucs_malloc(Lnnz   * sizeof(taucs_datatype));
   if (!((*L)->colptr) || !((*L)->rowind) || !((*L)->rowind)) {
-    	taucs_printf("taucs_ccs_split: out of memory: n=%d nnz=%d\n",n,Lnnz);
+    	taucs_printf("taucs_ccs_split: out of memory: n=%d nnz=%.0f\n",n,(double) Lnnz);
 	taucs_free((*L)->colptr); taucs_free((*L)->rowind); taucs_free((*L)->taucs_values);
 	taucs_free ((*L));
 	return; 
@@ -103,9 +104,9 @@ taucs_dtl(ccs_split)(taucs_ccs_matrix*  A,
   for (i=p+1; i<n+1; i++)
     ((*L)->colptr)[i] = ((*L)->colptr)[p]; /* other columns are empty */
 
-  for (i=0; i<Lnnz; i++) {
-    ((*L)->rowind)[i] = (A->rowind)[i];
-    ((*L)->taucs_values)[i] = (A->taucs_values)[i];
+  for (ip=0; ip<Lnnz; ip++) {
+    ((*L)->rowind)[ip] = (A->rowind)[ip];
+    ((*L)->taucs_values)[ip] = (A->taucs_values)[ip];
   }
 
   /* now copy right part of matrix into a p-by-p matrix */
@@ -117,11 +118,11 @@ taucs_dtl(ccs_split)(taucs_ccs_matrix*  A,
   (*R)->flags = TAUCS_SYMMETRIC | TAUCS_LOWER;
   (*R)->n = n-p;
   (*R)->m = n-p;
-  (*R)->colptr = (int*)    taucs_malloc((n-p+1) * sizeof(int));
+  (*R)->colptr = (taucs_index*) taucs_malloc((n-p+1) * sizeof(taucs_index));
   (*R)->rowind = (int*)    taucs_malloc(Rnnz   * sizeof(int));
   (*R)->taucs_values = (void*)   taucs_malloc(Rnnz   * sizeof(taucs_datatype));
   if (!((*R)->colptr) || !((*R)->rowind) || !((*R)->rowind)) {
-    	taucs_printf("taucs_ccs_split: out of memory (3): p=%d nnz=%d\n",p,Rnnz);
+    	taucs_printf("taucs_ccs_split: out of memory (3): p=%d nnz=%.0f\n",p,(double) Rnnz);
 	taucs_free((*R)->colptr); taucs_free((*R)->rowind); taucs_free((*R)->taucs_values);
 	taucs_free((*L)->colptr); taucs_free((*L)->rowind); taucs_free((*L)->taucs_values);
 	taucs_free ((*R));
@@ -132,9 +133,9 @@ taucs_dtl(ccs_split)(taucs_ccs_matrix*  A,
   for (i=0; i<=(n-p); i++)
     ((*R)->colptr)[i] = (A->colptr)[i+p] - Lnnz;   
 
-  for (i=0; i<Rnnz; i++) {
-    ((*R)->rowind)[i] = (A->rowind)[i + Lnnz] - p;
-    ((*R)->taucs_values)[i] = (A->taucs_values)[i + Lnnz];
+  for (ip=0; ip<Rnnz; ip++) {
+    ((*R)->rowind)[ip] = (A->rowind)[ip + Lnnz] - p;
+    ((*R)->taucs_values)[ip] = (A->taucs_values)[ip + Lnnz];
   }
 } 
 
@@ -181,10 +182,11 @@ taucs_dtl(ccs_permute_symmetrically)(taucs_ccs_matrix* A, int* perm, int* invper
 {
   taucs_ccs_matrix* PAPT;
   int n;
-  int nnz;
+  taucs_index nnz;
   /*int* colptr;*/
-  int* len;
-  int i,j,ip,I,J;
+  taucs_index* len;
+  taucs_index ip;
+  int i,j,I,J;
   taucs_datatype AIJ;
 
   assert(A->flags & TAUCS_SYMMETRIC || A->flags & TAUCS_HERMITIAN);
@@ -199,7 +201,7 @@ taucs_dtl(ccs_permute_symmetrically)(taucs_ccs_matrix* A, int* perm, int* invper
   /*PAPT->flags = TAUCS_SYMMETRIC | TAUCS_LOWER;*/
   PAPT->flags = A->flags;
 
-  len    = (int*) taucs_malloc(n * sizeof(int));
+  len    = (taucs_index*) taucs_malloc(n * sizeof(taucs_index));
   /*colptr = (int*) taucs_malloc(n * sizeof(int));*/
   if (!len) {
     taucs_printf("taucs_ccs_permute_symmetrically: out of memory\n");
@@ -263,6 +265,100 @@ taucs_dtl(ccs_permute_symmetrically)(taucs_ccs_matrix* A, int* perm, int* invper
 
 #endif /*#ifndef TAUCS_CORE_GENERAL*/
 
+/*********************************************************/
+/* drop small entries                                    */
+/* keeps the diagonal and every entry with               */
+/* |A(i,j)| >= droptol * max_i |A(i,j)|                  */
+/*********************************************************/
+
+#ifdef TAUCS_CORE_GENERAL
+taucs_ccs_matrix* 
+taucs_ccs_threshold_drop(taucs_ccs_matrix* A, double droptol)
+{
+
+#ifdef TAUCS_DOUBLE_IN_BUILD
+  if (A->flags & TAUCS_DOUBLE)
+    return taucs_dccs_threshold_drop(A,droptol);
+#endif
+
+#ifdef TAUCS_SINGLE_IN_BUILD
+  if (A->flags & TAUCS_SINGLE)
+    return taucs_sccs_threshold_drop(A,droptol);
+#endif
+
+#ifdef TAUCS_DCOMPLEX_IN_BUILD
+  if (A->flags & TAUCS_DCOMPLEX)
+    return taucs_zccs_threshold_drop(A,droptol);
+#endif
+
+#ifdef TAUCS_SCOMPLEX_IN_BUILD
+  if (A->flags & TAUCS_SCOMPLEX)
+    return taucs_cccs_threshold_drop(A,droptol);
+#endif
+  
+  assert(0);
+  return NULL;
+}
+#endif /*TAUCS_CORE_GENERAL*/
+
+#ifndef TAUCS_CORE_GENERAL
+
+taucs_ccs_matrix* 
+taucs_dtl(ccs_threshold_drop)(taucs_ccs_matrix* A, double droptol)
+{
+  taucs_ccs_matrix* D;
+  int n;
+  taucs_index nnz;
+  int i,j;
+  taucs_index ip;
+  double colmax;
+
+  n   = A->n;
+
+  /* first pass counts the surviving entries */
+
+  nnz = 0;
+  for (j=0; j<n; j++) {
+    colmax = 0.0;
+    for (ip = (A->colptr)[j]; ip < (A->colptr)[j+1]; ip++)
+      if ((double) taucs_abs((A->taucs_values)[ip]) > colmax) 
+	colmax = (double) taucs_abs((A->taucs_values)[ip]);
+    for (ip = (A->colptr)[j]; ip < (A->colptr)[j+1]; ip++) {
+      i = (A->rowind)[ip];
+      if (i == j || (double) taucs_abs((A->taucs_values)[ip]) >= droptol * colmax) nnz++;
+    }
+  }
+
+  D = taucs_dtl(ccs_create)(A->m,n,nnz);
+  if (!D) return NULL;
+  D->flags = A->flags;
+
+  nnz = 0;
+  for (j=0; j<n; j++) {
+    (D->colptr)[j] = nnz;
+    colmax = 0.0;
+    for (ip = (A->colptr)[j]; ip < (A->colptr)[j+1]; ip++)
+      if ((double) taucs_abs((A->taucs_values)[ip]) > colmax) 
+	colmax = (double) taucs_abs((A->taucs_values)[ip]);
+    for (ip = (A->colptr)[j]; ip < (A->colptr)[j+1]; ip++) {
+      i = (A->rowind)[ip];
+      if (i == j || (double) taucs_abs((A->taucs_values)[ip]) >= droptol * colmax) {
+	(D->rowind)[nnz]       = i;
+	(D->taucs_values)[nnz] = (A->taucs_values)[ip];
+	nnz++;
+      }
+    }
+  }
+  (D->colptr)[n] = nnz;
+
+  taucs_printf("taucs_ccs_threshold_drop: droptol=%.2e, kept %.0f of %.0f entries\n",
+	       droptol,(double) nnz,(double) (A->colptr)[n]);
+
+  return D;
+}
+
+#endif /*#ifndef TAUCS_CORE_GENERAL*/
+
 /*********************************************************/
 /* compute B = A*X                                       */
 /* current restrictions: A must be square, real          */
@@ -336,7 +432,8 @@ taucs_dtl(ccs_times_vec)(taucs_ccs_matrix* m,
 			 taucs_datatype* X,
 			 taucs_datatype* B)
 {
-  int i,ip,j,n,m_;
+  int i,j,n,m_;
+  taucs_index ip;
   taucs_datatype Aij;
 
   n = m->n;
@@ -344,6 +441,39 @@ taucs_dtl(ccs_times_vec)(taucs_ccs_matrix* m,
 
   for (i=0; i < m_; i++) B[i] = taucs_zero;
 
+#ifdef TAUCS_CORE_COMPLEX
+  /* Complex products are formed on the real and imaginary */
+  /* parts directly. C99 complex multiplication calls a    */
+  /* library routine to handle infinities, and the generic */
+  /* complex build calls functions, so this keeps the      */
+  /* inner loop free of calls in both builds.              */
+  {
+    taucs_real_datatype* x = (taucs_real_datatype*) X;
+    taucs_real_datatype* b = (taucs_real_datatype*) B;
+    taucs_real_datatype* a = (taucs_real_datatype*) (m->taucs_values);
+    taucs_real_datatype  ar, ai, aj;
+    int sym  = (m->flags & TAUCS_SYMMETRIC) || (m->flags & TAUCS_HERMITIAN);
+    int herm = (m->flags & TAUCS_HERMITIAN) ? 1 : 0;
+
+    for (j=0; j<n; j++) {
+      for (ip = (m->colptr)[j]; ip < (m->colptr[j+1]); ip++) {
+	i  = (m->rowind)[ip];
+	ar = a[2*ip];
+	ai = a[2*ip+1];
+
+	b[2*i]   += ar * x[2*j]   - ai * x[2*j+1];
+	b[2*i+1] += ar * x[2*j+1] + ai * x[2*j];
+	if (sym && i != j) {
+	  aj = herm ? -ai : ai;
+	  b[2*j]   += ar * x[2*i]   - aj * x[2*i+1];
+	  b[2*j+1] += ar * x[2*i+1] + aj * x[2*i];
+	}
+      }
+    }
+    return;
+  }
+#endif
+
   if (m->flags & TAUCS_SYMMETRIC) {
     for (j=0; j<n; j++) {
       for (ip = (m->colptr)[j]; ip < (m->colptr[j+1]); ip++) {
@@ -385,7 +515,8 @@ taucs_dtl(ccs_times_vec_many)(taucs_ccs_matrix* m,
 			 taucs_datatype* B,
 			 int nrhs)
 {
-  int i,ip,j,n,k,m_;
+  int i,j,n,k,m_;
+  taucs_index ip;
   taucs_datatype Aij;
 
   n = m->n;
@@ -481,7 +612,8 @@ void
 taucs_dtl(ccs_parallel_times_vec)(taucs_ccs_matrix* m, taucs_datatype* X, taucs_datatype* B, 
 				  int sv, int mv, int ev, int tid, taucs_datatype *S, int nproc, pfunc_handle_t handle)
 {
-  int i,ip,j,n,m_,k;
+  int i,j,n,m_,k;
+  taucs_index ip;
   taucs_datatype Aij;
 
   n = m->n;
@@ -599,7 +731,8 @@ taucs_sccs_times_vec_dacc(taucs_ccs_matrix* m,
 			 taucs_single* X,
 			 taucs_single* B)
 {
-  int i,ip,j,n;
+  int i,j,n;
+  taucs_index ip;
   taucs_single Aij;
   taucs_double* Bd;
 
@@ -677,8 +810,9 @@ taucs_dtl(ccs_augment_nonpositive_offdiagonals)(taucs_ccs_matrix* A)
 #ifdef TAUCS_CORE_COMPLEX
   assert(0);
 #else
-  int n,i,j;
-  int *tmp;
+  int n,i;
+  taucs_index j;
+  taucs_index *tmp;
   taucs_ccs_matrix* A_tmp;
   
   if (!(A->flags & TAUCS_SYMMETRIC) || !(A->flags & TAUCS_LOWER)) {
@@ -688,7 +822,7 @@ taucs_dtl(ccs_augment_nonpositive_offdiagonals)(taucs_ccs_matrix* A)
 
   n=A->n;
 
-  tmp = (int *)taucs_calloc((2*n+1),sizeof(int));
+  tmp = (taucs_index *)taucs_calloc((2*n+1),sizeof(taucs_index));
   if (!tmp) {
     taucs_printf("taucs_ccs_augment_nonpositive_offdiagonal: out of memory\n");
     return NULL;
@@ -786,8 +920,9 @@ taucs_ccs_matrix *taucs_dtl(ccs_transpose)(taucs_ccs_matrix *A, int pattern_only
 {
   taucs_ccs_matrix *At;
   int *row_size, *row_index;
-  int i, j;
-  int nnz;
+  int i;
+  taucs_index j;
+  taucs_index nnz;
   
   int do_values;
 
@@ -813,7 +948,7 @@ taucs_ccs_matrix *taucs_dtl(ccs_transpose)(taucs_ccs_matrix *A, int pattern_only
   At->m = A->n;
   At->n = A->m;
   nnz = A->colptr[ A->n ];
-  At->colptr = taucs_calloc(At->n + 1, sizeof(int));
+  At->colptr = taucs_calloc(At->n + 1, sizeof(taucs_index));
   At->rowind = taucs_calloc( nnz /*At->nnz*/, sizeof(int));
   if (do_values)
     (At->taucs_values) = taucs_calloc(nnz, sizeof(taucs_datatype));
@@ -822,8 +957,8 @@ taucs_ccs_matrix *taucs_dtl(ccs_transpose)(taucs_ccs_matrix *A, int pattern_only
   
   /* Find row sizes */
   row_size = taucs_calloc(A->m, sizeof(int));
-  for(i = 0; i < nnz; i++)
-    row_size[A->rowind[i]]++;
+  for(j = 0; j < nnz; j++)
+    row_size[A->rowind[j]]++;
   
   /* Initiate the colptr of At based on rowsizes */
   At->colptr[0] = 0;
@@ -838,7 +973,7 @@ taucs_ccs_matrix *taucs_dtl(ccs_transpose)(taucs_ccs_matrix *A, int pattern_only
     for(j = A->colptr[i]; j < A->colptr[i + 1]; j++)
       {
 	int row = A->rowind[j];
-	int index = At->colptr[row] + row_index[row];
+	taucs_index index = At->colptr[row] + row_index[row];
 	
 	At->rowind[index] = i;
 	if (do_values)
@@ -866,14 +1001,15 @@ void taucs_ccs_permute_rows_inplace(taucs_ccs_matrix *A, int *row_order)
 {
   int *inverse_r = taucs_malloc(A->m * sizeof(int));
   int i;
+  taucs_index ip;
   
   /* Find inverse of row order */
   for (i = 0; i < A->m; i++)
     inverse_r[row_order[i]] = i;
   
   /* Change row numbers */
-  for (i = 0; i < A->colptr[ A->n ]/*A->nnz*/; i++)
-    A->rowind[i] = inverse_r[A->rowind[i]];
+  for (ip = 0; ip < A->colptr[ A->n ]/*A->nnz*/; ip++)
+    A->rowind[ip] = inverse_r[A->rowind[ip]];
   
   taucs_free(inverse_r);
 }
@@ -888,7 +1024,8 @@ void taucs_ccs_permute_rows_inplace(taucs_ccs_matrix *A, int *row_order)
 #ifdef TAUCS_CORE_GENERAL
 taucs_ccs_matrix *taucs_ccs_find_ata_pattern(taucs_ccs_matrix *A)
 {
-  int ata_nnz, mark, i, j, k, row, row1;
+  taucs_index ata_nnz, j, k;
+  int mark, i, row, row1;
   taucs_ccs_matrix *ATA;
   taucs_ccs_matrix *AT = taucs_ccs_transpose(A, 1);
 
@@ -10,6 +10,7 @@
 #include <string.h>
 #include <assert.h>
 #include <math.h>
+#include <limits.h>
 #include "taucs.h"
 
 /*********************************************************/
@@ -43,7 +44,7 @@ taucs_ccs_colamd(taucs_ccs_matrix* m,
   int*   A;
   int*   p;
   int*   ip;
-  int    k,nnz;
+  taucs_index k,nnz;
   int i;
   
   if (m->flags & TAUCS_SYMMETRIC || m->flags & TAUCS_HERMITIAN) {
@@ -57,21 +58,27 @@ taucs_ccs_colamd(taucs_ccs_matrix* m,
   *invperm = NULL;
 
   nnz = (m->colptr)[m->n];
+
+  /* colamd's workspace, about 2.2*nnz plus a few n, is indexed by ints */
+  if (2.5 * (double) nnz + 8.0 * ((double) m->m + m->n) > (double) INT_MAX) {
+    taucs_printf("taucs_ccs_colamd: matrix too large for colamd's int workspace\n");
+    return;
+  }
   
   p  = (int*) taucs_malloc((m->n + 1) * sizeof(int));
   ip = (int*) taucs_malloc((m->n + 1) * sizeof(int));
   assert(p && ip);
   
-  Alen = colamd_recommended(nnz, m->m, m->n);
+  Alen = colamd_recommended((int) nnz, m->m, m->n);
   A = taucs_malloc(Alen * sizeof(int)); assert(A);
   assert(A);
   colamd_set_defaults (knobs) ;
   
-  for (i=0; i<=m->n; i++)  p[i] = (m->colptr)[i];
+  for (i=0; i<=m->n; i++)  p[i] = (int) (m->colptr)[i];
   for (k=0; k<nnz; k++)     A[k] = (m->rowind)[k];
   
-  taucs_printf("oocsp_ccs_colamd: calling colamd matrix is %dx%d, nnz=%d\n",
-	     m->m,m->n,nnz);
+  taucs_printf("oocsp_ccs_colamd: calling colamd matrix is %dx%d, nnz=%.0f\n",
+	     m->m,m->n,(double) nnz);
   if (!colamd (m->m, m->n, Alen, A, p, knobs, stats)) {
     taucs_printf("oocsp_ccs_colamd: colamd failed\n");
     taucs_free(A);
@@ -134,7 +141,8 @@ taucs_ccs_amd(taucs_ccs_matrix* m,
   int* w;
   int* len;
 
-  int  nnz,i,j,ip;
+  taucs_index nnz,ip;
+  int  i,j;
   
   taucs_printf("taucs_ccs_amd: starting (%s)\n",which);
 
@@ -157,6 +165,12 @@ taucs_ccs_amd(taucs_ccs_matrix* m,
 
   n   = m->n;
   nnz = (m->colptr)[n];
+
+  /* iw holds the symmetric structure, and AMD indexes it with ints */
+  if (2.0*((double) nnz - n) + n > (double) INT_MAX) {
+    taucs_printf("taucs_ccs_amd: matrix too large for AMD's int workspace\n");
+    return;
+  }
   
   pe     = (int*) taucs_malloc(n * sizeof(int));
   degree = (int*) taucs_malloc(n * sizeof(int));
@@ -169,7 +183,10 @@ taucs_ccs_amd(taucs_ccs_matrix* m,
   len    = (int*) taucs_malloc(n * sizeof(int));
 
   /* AMD docs recommend iwlen >= 1.2 nnz, but this leads to compressions */
-  iwlen = n + (int) (2.0 * 2.0*(nnz - n));
+  if (n + 2.0 * 2.0*((double) nnz - n) > (double) INT_MAX)
+    iwlen = INT_MAX;
+  else
+    iwlen = n + (int) (2.0 * 2.0*((double) nnz - n));
 
   taucs_printf("taucs_ccs_amd: allocating %d ints for iw\n",iwlen);
 
@@ -235,8 +252,8 @@ taucs_ccs_amd(taucs_ccs_matrix* m,
     }
   }
 
-  taucs_printf("taucs_ccs_amd: calling amd matrix is %dx%d, nnz=%d\n",
-	     n,n,nnz);
+  taucs_printf("taucs_ccs_amd: calling amd matrix is %dx%d, nnz=%.0f\n",
+	     n,n,(double) nnz);
 
   if (!strcmp(which,"amd")) 
     amd_   (&n, pe, iw, len, &iwlen, &pfree, nv, next,
@@ -306,7 +323,8 @@ taucs_ccs_camd(taucs_ccs_matrix* A,
   *invperm = NULL;
   return;
 #else
-  int  n,m,nnz,i,j,ip;
+  int  n,m,nnz,i,j;
+  taucs_index ip;
   int  rc = 0; /* warning */
   int* Ap;
   int* Ai;
@@ -334,7 +352,11 @@ taucs_ccs_camd(taucs_ccs_matrix* A,
   *invperm = NULL;
 
   n = m = A->n;
-  nnz = 2 * (A->colptr)[n] - n;
+  if (2.0 * (double) (A->colptr)[n] - n > (double) INT_MAX) {
+    taucs_printf("taucs_ccs_amd: matrix too large for amd_order's int indices\n");
+    return;
+  }
+  nnz = (int) (2 * (A->colptr)[n] - n);
 
   Ai = (int*) taucs_malloc(nnz * sizeof(int));
   Ap = (int*) taucs_malloc((n+1)*sizeof(int));
@@ -485,7 +507,8 @@ taucs_ccs_genmmd(taucs_ccs_matrix* m,
   int* len;
   int* next;
 
-  int  nnz,i,j,ip;
+  int  nnz,i,j;
+  taucs_index ip;
   
   /*taucs_printf("taucs_ccs_genmmd: starting (%s)\n",which);*/
 
@@ -507,7 +530,12 @@ taucs_ccs_genmmd(taucs_ccs_matrix* m,
   *invperm = NULL;
 
   n   = m->n;
-  nnz = (m->colptr)[n];
+
+  if (2.0 * (double) (m->colptr)[n] - n > (double) INT_MAX) {
+    taucs_printf("taucs_ccs_genmmd: matrix too large for genmmd's int indices\n");
+    return;
+  }
+  nnz = (int) (m->colptr)[n];
   
   /* I copied the value of delta and the size of */
   /* from SuperLU. Sivan                         */
@@ -652,7 +680,8 @@ taucs_ccs_treeorder(taucs_ccs_matrix* m,
 		    int** perm,
 		    int** invperm)
 {
-  int  n,nnz,i,j,ip,k,p,nleaves;
+  int  n,nnz,i,j,k,p,nleaves;
+  taucs_index ip;
   int* adjptr;
   int* adj;
   int* len;
@@ -675,7 +704,14 @@ taucs_ccs_treeorder(taucs_ccs_matrix* m,
   }
 
   n   = m->n;
-  nnz = (m->colptr)[n];
+
+  if (2.0 * ((double) (m->colptr)[n] - n) > (double) INT_MAX) {
+    taucs_printf("taucs_ccs_treeorder: matrix too large for int indices\n");
+    *perm    = NULL;
+    *invperm = NULL;
+    return;
+  }
+  nnz = (int) (m->colptr)[n];
   
   taucs_printf("taucs_ccs_treeorder: starting, matrix is %dx%d, # edges=%d\n",
 	     n,n,nnz-n);
@@ -850,7 +886,8 @@ taucs_ccs_metis(taucs_ccs_matrix* m,
   *invperm = NULL;
   return;
 #else
-  int  n,nnz,i,j,ip;
+  int  n,nnz,i,j;
+  taucs_index ip;
   int* xadj;
   int* adj;
   int  num_flag     = 0;
@@ -875,7 +912,15 @@ taucs_ccs_metis(taucs_ccs_matrix* m,
   }
 
   n   = m->n;
-  nnz = (m->colptr)[n];
+
+  /* adj has 2*nnz entries and METIS indexes it with ints */
+  if (2.0 * (double) (m->colptr)[n] > (double) INT_MAX) {
+    taucs_printf("taucs_ccs_metis: matrix too large for METIS's int indices\n");
+    *perm    = NULL;
+    *invperm = NULL;
+    return;
+  }
+  nnz = (int) (m->colptr)[n];
   
   *perm    = (int*) taucs_malloc(n * sizeof(int));
   *invperm = (int*) taucs_malloc(n * sizeof(int));
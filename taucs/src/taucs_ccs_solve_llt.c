@@ -7,8 +7,239 @@
 #include <stdlib.h>
 #include <math.h>
 #include <assert.h>
+#include <string.h>
 #include "taucs.h"
 
+#ifdef TAUCS_CONFIG_PFUNC
+#include "pfunc.h"
+#endif
+
+/*********************************************************/
+/* level-scheduled solves                                */
+/*********************************************************/
+
+/*
+  A schedule for solving with a ccs LL^T factor. Rows are grouped into
+  level sets; the rows of one level do not depend on each other, so a
+  level can be split among threads, with a barrier between levels.
+  Both sweeps are row oriented (a sparse dot product per row) so that
+  no two threads ever write the same entry: the forward sweep uses a
+  copy of L by rows, stored in level order, and the backward sweep uses
+  the columns of L itself, which are the rows of L^T.
+*/
+
+typedef struct {
+  int    n;
+  int    flags;
+  int    nproc;
+  taucs_ccs_matrix* L;     /* not owned; must outlive the schedule */
+
+  int    fwd_nlevels;
+  int*   fwd_levptr;       /* level k is fwd_order[fwd_levptr[k]..] */
+  int*   fwd_order;
+  taucs_index* fwd_rowptr; /* rows of L in fwd_order, no diagonal   */
+  int*   fwd_colind;
+  void*  fwd_values;
+  void*  diag;
+
+  int    bwd_nlevels;
+  int*   bwd_levptr;
+  int*   bwd_order;
+} ccs_solve_schedule;
+
+#ifdef TAUCS_CORE_GENERAL
+static void
+ccs_solve_schedule_free(ccs_solve_schedule* S)
+{
+  if (!S) return;
+  taucs_free(S->fwd_levptr);
+  taucs_free(S->fwd_order);
+  taucs_free(S->fwd_rowptr);
+  taucs_free(S->fwd_colind);
+  taucs_free(S->fwd_values);
+  taucs_free(S->diag);
+  taucs_free(S->bwd_levptr);
+  taucs_free(S->bwd_order);
+  taucs_free(S);
+}
+
+void
+taucs_ccs_solve_llt_schedule_free(void* vS)
+{
+  ccs_solve_schedule_free((ccs_solve_schedule*) vS);
+}
+
+/*
+  Sorts 0..n-1 by level into order, and returns the number of levels,
+  or -1 if out of memory.
+*/
+
+static int
+ccs_solve_schedule_levels(int n, int* level, int** plevptr, int** porder)
+{
+  int  i,k,nlevels;
+  int* levptr;
+  int* order;
+
+  nlevels = 0;
+  for (i=0; i<n; i++) nlevels = max(nlevels, level[i]+1);
+
+  levptr = (int*) taucs_malloc((nlevels+1) * sizeof(int));
+  order  = (int*) taucs_malloc(n           * sizeof(int));
+  if (!levptr || !order) {
+    taucs_free(levptr);
+    taucs_free(order);
+    return -1;
+  }
+
+  for (k=0; k<=nlevels; k++) levptr[k] = 0;
+  for (i=0; i<n; i++) levptr[ level[i]+1 ]++;
+  for (k=0; k<nlevels; k++) levptr[k+1] += levptr[k];
+  for (i=0; i<n; i++) order[ levptr[level[i]]++ ] = i;
+  for (k=nlevels; k>0; k--) levptr[k] = levptr[k-1];
+  levptr[0] = 0;
+
+  *plevptr = levptr;
+  *porder  = order;
+  return nlevels;
+}
+
+static int
+ccs_solve_element_size(int flags)
+{
+  if (flags & TAUCS_SINGLE)   return sizeof(taucs_single);
+  if (flags & TAUCS_DOUBLE)   return sizeof(taucs_double);
+  if (flags & TAUCS_SCOMPLEX) return sizeof(taucs_scomplex);
+  if (flags & TAUCS_DCOMPLEX) return sizeof(taucs_dcomplex);
+  assert(0);
+  return -1;
+}
+
+/*
+  Computes the level sets of both sweeps once; the schedule can then
+  be passed as the preconditioner argument of the iterative solvers,
+  with taucs_ccs_solve_llt_scheduled as the preconditioner function.
+  With nproc > 1 the levels are split among PFUNC threads; this
+  requires a build with PFUNC and an initialized PFUNC runtime.
+*/
+
+void*
+taucs_ccs_solve_llt_analyze(taucs_ccs_matrix* L, int nproc)
+{
+  ccs_solve_schedule* S;
+  int  n,i,j,p,esize;
+  taucs_index ip,k;
+  int* level;
+  int* pos;
+  char* values;
+  char* fwd_values;
+  char* diag;
+
+  if (!(L->flags & TAUCS_TRIANGULAR) || !(L->flags & TAUCS_LOWER)) {
+    taucs_printf("taucs_ccs_solve_llt_analyze: factor matrix must be lower triangular\n");
+    return NULL;
+  }
+
+#ifndef TAUCS_CONFIG_PFUNC
+  if (nproc > 1)
+    taucs_printf("taucs_ccs_solve_llt_analyze: PFUNC not in the build, solving on one thread\n");
+  nproc = 1;
+#endif
+
+  n     = L->n;
+  esize = ccs_solve_element_size(L->flags);
+
+  S     = (ccs_solve_schedule*) taucs_calloc(1, sizeof(ccs_solve_schedule));
+  level = (int*) taucs_malloc(n * sizeof(int));
+  pos   = (int*) taucs_malloc(n * sizeof(int));
+  if (!S || !level || !pos) goto nomem;
+
+  S->n     = n;
+  S->flags = L->flags;
+  S->nproc = max(nproc, 1);
+  S->L     = L;
+
+  /*
+    On one thread, a single level in natural order is a valid schedule
+    and keeps the accesses to x sequential. Within a level the forward
+    sweep goes up and the backward sweep goes down, so this also works
+    for the backward sweep.
+  */
+
+  /* forward sweep: row i waits for every j with L(i,j) != 0 */
+
+  for (i=0; i<n; i++) level[i] = 0;
+  for (j=0; j<n; j++) {
+    assert( (L->rowind)[ (L->colptr)[j] ] == j ); /* diagonal first */
+    if (S->nproc == 1) continue;
+    for (ip = (L->colptr)[j]+1; ip < (L->colptr)[j+1]; ip++) {
+      i = (L->rowind)[ip];
+      level[i] = max(level[i], level[j]+1);
+    }
+  }
+  S->fwd_nlevels = ccs_solve_schedule_levels(n,level,&(S->fwd_levptr),&(S->fwd_order));
+  if (S->fwd_nlevels == -1) goto nomem;
+
+  /* backward sweep: row i of L^T waits for every j with L(j,i) != 0 */
+
+  for (i=n-1; i>=0; i--) {
+    level[i] = 0;
+    if (S->nproc == 1) continue;
+    for (ip = (L->colptr)[i]+1; ip < (L->colptr)[i+1]; ip++)
+      level[i] = max(level[i], level[ (L->rowind)[ip] ]+1);
+  }
+  S->bwd_nlevels = ccs_solve_schedule_levels(n,level,&(S->bwd_levptr),&(S->bwd_order));
+  if (S->bwd_nlevels == -1) goto nomem;
+
+  /* copy L by rows, in forward level order */
+
+  S->fwd_rowptr = (taucs_index*) taucs_malloc((n+1) * sizeof(taucs_index));
+  S->fwd_colind = (int*)  taucs_malloc(((L->colptr)[n] - n) * sizeof(int));
+  S->fwd_values =         taucs_malloc(((L->colptr)[n] - n) * esize);
+  S->diag       =         taucs_malloc(n * esize);
+  if (!(S->fwd_rowptr) || (!(S->fwd_colind) && (L->colptr)[n] > n)
+      || (!(S->fwd_values) && (L->colptr)[n] > n) || !(S->diag)) goto nomem;
+
+  for (p=0; p<n; p++) pos[ (S->fwd_order)[p] ] = p;
+
+  for (p=0; p<=n; p++) (S->fwd_rowptr)[p] = 0;
+  for (j=0; j<n; j++)
+    for (ip = (L->colptr)[j]+1; ip < (L->colptr)[j+1]; ip++)
+      (S->fwd_rowptr)[ pos[ (L->rowind)[ip] ]+1 ]++;
+  for (p=0; p<n; p++) (S->fwd_rowptr)[p+1] += (S->fwd_rowptr)[p];
+
+  /* fwd_rowptr[p] serves as the fill pointer of row p, then shifts back */
+
+  values     = (char*) L->values.v;
+  fwd_values = (char*) S->fwd_values;
+  diag       = (char*) S->diag;
+  for (j=0; j<n; j++) {
+    ip = (L->colptr)[j];
+    memcpy(diag + j*esize, values + ip*esize, esize);
+    for (ip = (L->colptr)[j]+1; ip < (L->colptr)[j+1]; ip++) {
+      k = (S->fwd_rowptr)[ pos[ (L->rowind)[ip] ] ]++;
+      (S->fwd_colind)[k] = j;
+      memcpy(fwd_values + k*esize, values + ip*esize, esize);
+    }
+  }
+  for (p=n; p>0; p--) (S->fwd_rowptr)[p] = (S->fwd_rowptr)[p-1];
+  (S->fwd_rowptr)[0] = 0;
+
+  taucs_free(level);
+  taucs_free(pos);
+
+  taucs_printf("taucs_ccs_solve_llt_analyze: n=%d, %d forward levels, %d backward levels, %d threads\n",
+	       n,S->fwd_nlevels,S->bwd_nlevels,S->nproc);
+  return S;
+
+ nomem:
+  taucs_printf("taucs_ccs_solve_llt_analyze: out of memory\n");
+  taucs_free(level);
+  taucs_free(pos);
+  ccs_solve_schedule_free(S);
+  return NULL;
+}
+#endif /*TAUCS_CORE_GENERAL*/
 
 /*********************************************************/
 /*                                                       */
@@ -23,7 +254,7 @@ taucs_dtl(ccs_solve_llt)(void* vL, taucs_datatype* x, taucs_datatype* b)
 
   int n;
   int i,j;
-  int ip,jp;
+  taucs_index ip,jp;
   taucs_datatype  Aij, Ajj, Aii;
   taucs_datatype* y;
 
@@ -141,7 +372,7 @@ taucs_dtl(ccs_solve_schur)(taucs_ccs_matrix* L,
 {
   int n;
   int i,j;
-  int ip,jp;
+  taucs_index ip,jp;
   taucs_datatype  Aij, Ajj, Aii;
   taucs_datatype* y;
 
@@ -246,7 +477,7 @@ taucs_dtl(ccs_solve_ldlt)(void* vL, taucs_datatype* x, taucs_datatype* b)
 
   int n;
   int i,j;
-  int ip,jp;
+  taucs_index ip,jp;
   taucs_datatype  Ajj = taucs_zero_const; /* just to suppress the warning */
   taucs_datatype  Aij = taucs_zero_const; /* just to suppress the warning */
   taucs_datatype* y;
@@ -358,6 +589,145 @@ taucs_dtl(ccs_solve_ldlt)(void* vL, taucs_datatype* x, taucs_datatype* b)
   return 0;
 }
 
+/*********************************************************/
+/* level-scheduled LL^T solve                            */
+/*********************************************************/
+
+/* thread tid of nproc solves its share of each level */
+
+static void
+scheduled_forward(ccs_solve_schedule* S,
+		  taucs_datatype* x, taucs_datatype* b,
+		  int tid, int nproc)
+{
+  int* levptr = S->fwd_levptr;
+  int* order  = S->fwd_order;
+  taucs_index* rowptr = S->fwd_rowptr;
+  int* colind = S->fwd_colind;
+  taucs_datatype* values = (taucs_datatype*) S->fwd_values;
+  taucs_datatype* diag   = (taucs_datatype*) S->diag;
+  int k,p,i,chunk,first,last;
+  taucs_index q;
+  taucs_datatype v;
+
+  for (k=0; k<S->fwd_nlevels; k++) {
+    chunk = (levptr[k+1] - levptr[k] + nproc - 1) / nproc;
+    first = min(levptr[k] +  tid    * chunk, levptr[k+1]);
+    last  = min(levptr[k] + (tid+1) * chunk, levptr[k+1]);
+
+    for (p=first; p<last; p++) {
+      i = order[p];
+      v = b[i];
+      for (q=rowptr[p]; q<rowptr[p+1]; q++)
+	v = taucs_sub( v, taucs_mul( values[q], x[ colind[q] ] ));
+      x[i] = taucs_div( v, diag[i] );
+    }
+
+#ifdef TAUCS_CONFIG_PFUNC
+    if (nproc > 1) pfunc_barrier();
+#endif
+  }
+}
+
+static void
+scheduled_backward(ccs_solve_schedule* S,
+		   taucs_datatype* x,
+		   int tid, int nproc)
+{
+  taucs_ccs_matrix* L = S->L;
+  int* levptr = S->bwd_levptr;
+  int* order  = S->bwd_order;
+  taucs_index* colptr = L->colptr;
+  int* rowind = L->rowind;
+  taucs_datatype* values = L->taucs_values;
+  taucs_datatype* diag   = (taucs_datatype*) S->diag;
+  int k,p,i,chunk,first,last;
+  taucs_index q;
+  taucs_datatype v;
+
+  for (k=0; k<S->bwd_nlevels; k++) {
+    chunk = (levptr[k+1] - levptr[k] + nproc - 1) / nproc;
+    first = min(levptr[k] +  tid    * chunk, levptr[k+1]);
+    last  = min(levptr[k] + (tid+1) * chunk, levptr[k+1]);
+
+    for (p=last-1; p>=first; p--) {
+      i = order[p];
+      v = x[i];
+      for (q=colptr[i]+1; q<colptr[i+1]; q++)
+	v = taucs_sub( v, taucs_mul( taucs_conj(values[q]), x[ rowind[q] ] ));
+      x[i] = taucs_div( v, diag[i] );
+    }
+
+#ifdef TAUCS_CONFIG_PFUNC
+    if (nproc > 1) pfunc_barrier();
+#endif
+  }
+}
+
+#ifdef TAUCS_CONFIG_PFUNC
+static void
+scheduled_solve_thread(void* args)
+{
+  ccs_solve_schedule* S;
+  taucs_datatype* x;
+  taucs_datatype* b;
+  int tid;
+
+  pfunc_unpack(args, "void*, void*, void*, int",
+	       (void*)&S, (void*)&x, (void*)&b, &tid);
+
+  /* the forward sweep ends with a barrier, so x is complete here */
+  scheduled_forward (S,x,b,tid,S->nproc);
+  scheduled_backward(S,x,  tid,S->nproc);
+}
+#endif
+
+int
+taucs_dtl(ccs_solve_llt_scheduled)(void* vS, taucs_datatype* x, taucs_datatype* b)
+{
+  ccs_solve_schedule* S = (ccs_solve_schedule*) vS;
+
+#ifdef TAUCS_CONFIG_PFUNC
+  if (S->nproc > 1) {
+    int nproc = S->nproc;
+    int i;
+    char** args = (char**) taucs_malloc(nproc * sizeof(char*));
+    pfunc_handle_t* handles = (pfunc_handle_t*) taucs_malloc(nproc * sizeof(pfunc_handle_t));
+    pfunc_group_t group;
+
+    if (args && handles) {
+      pfunc_group_init(&group);
+      pfunc_group_set(&group, GROUP_ID, 1235);
+      pfunc_group_set(&group, GROUP_SIZE, nproc);
+      pfunc_group_set(&group, GROUP_BARRIER_TYPE, BARRIER_SPIN);
+
+      for (i=0; i<nproc; i++) {
+	pfunc_handle_init(&handles[i]);
+	pfunc_pack(&args[i], "void*, void*, void*, int", S, x, b, i);
+	pfunc_run(&handles[i], PFUNC_ATTR_DEFAULT, group,
+		  scheduled_solve_thread, args[i]);
+      }
+      pfunc_wait_all(handles, nproc);
+
+      for (i=0; i<nproc; i++)
+	pfunc_handle_clear(handles[i]);
+      taucs_free(handles);
+      taucs_free(args);
+      return 0;
+    }
+
+    /* could not start the threads; solve on this one */
+    taucs_free(handles);
+    taucs_free(args);
+  }
+#endif
+
+  scheduled_forward (S,x,b,0,1);
+  scheduled_backward(S,x,  0,1);
+
+  return 0;
+}
+
 #endif /*#ifndef TAUCS_CORE_GENERAL*/
 
 #ifdef TAUCS_CORE_GENERAL
@@ -446,6 +816,35 @@ taucs_ccs_solve_llt(void* vL, void* x, void* b)
   return -1;
 }
 
+int
+taucs_ccs_solve_llt_scheduled(void* vS, void* x, void* b)
+{
+  ccs_solve_schedule* S = (ccs_solve_schedule*) vS;
+
+#ifdef TAUCS_DOUBLE_IN_BUILD
+  if (S->flags & TAUCS_DOUBLE)
+    return taucs_dccs_solve_llt_scheduled(S,(taucs_double*) x, (taucs_double*) b);
+#endif
+
+#ifdef TAUCS_SINGLE_IN_BUILD
+  if (S->flags & TAUCS_SINGLE)
+    return taucs_sccs_solve_llt_scheduled(S,(taucs_single*) x, (taucs_single*) b);
+#endif
+
+#ifdef TAUCS_DCOMPLEX_IN_BUILD
+  if (S->flags & TAUCS_DCOMPLEX)
+    return taucs_zccs_solve_llt_scheduled(S,(taucs_dcomplex*) x, (taucs_dcomplex*) b);
+#endif
+
+#ifdef TAUCS_SCOMPLEX_IN_BUILD
+  if (S->flags & TAUCS_SCOMPLEX)
+    return taucs_cccs_solve_llt_scheduled(S,(taucs_scomplex*) x, (taucs_scomplex*) b);
+#endif
+  
+  assert(0);
+  return -1;
+}
+
 int
 taucs_ccs_solve_ldlt(void* vL, void* x, void* b)
 {
@@ -116,6 +116,7 @@ static spa* spa_create(int n)
 static void spa_free(spa* s)
 {
   taucs_free( s->indices );
+  taucs_free( s->bitmap  );
   taucs_free( s->values  );
   taucs_free( s );
 }
@@ -253,94 +254,119 @@ static double spa_A_norm(spa* s, int j, taucs_ccs_matrix* A)
 /*                                                       */
 /*********************************************************/
 
-int*    rowlist;
-int*    rowlist_next;
-int*    rowlist_colind;
-double* rowlist_values;
+typedef struct {
+  int*    head;
+  int*    next;
+  int*    colind;
+  double* values;
+
+  int     freelist;
+  int     size;
+} rowlist;
+
+static void rowlist_free(rowlist* r)
+{
+  if (!r) return;
 
-int     rowlist_freelist;
-int     rowlist_size;
+  taucs_free(r->head);
+  taucs_free(r->next);
+  taucs_free(r->colind);
+  taucs_free(r->values);
+  taucs_free(r);
+}
 
-static int rowlist_create(int n)
+static rowlist* rowlist_create(int n)
 {
   int i;
+  rowlist* r;
 
-  rowlist = (int*) taucs_malloc( n * sizeof(int) );
+  r = (rowlist*) taucs_malloc( sizeof(rowlist) );
+  if ( !r ) return NULL;
 
-  rowlist_size    = 1000;
-  rowlist_next    = (int*)    taucs_malloc( rowlist_size * sizeof(int) );
-  rowlist_colind = (int*)    taucs_malloc( rowlist_size * sizeof(int) );
-  rowlist_values  = (double*) taucs_malloc( rowlist_size * sizeof(double) );
+  r->head = (int*) taucs_malloc( n * sizeof(int) );
 
-  for (i=0; i<n; i++) rowlist[i] = -1; /* no list yet for row i */
+  r->size   = 1000;
+  r->next   = (int*)    taucs_malloc( r->size * sizeof(int) );
+  r->colind = (int*)    taucs_malloc( r->size * sizeof(int) );
+  r->values = (double*) taucs_malloc( r->size * sizeof(double) );
+
+  if (!(r->head) || !(r->next) || !(r->colind) || !(r->values)) {
+    rowlist_free(r);
+    return NULL;
+  }
+
+  for (i=0; i<n; i++) (r->head)[i] = -1; /* no list yet for row i */
 
   /* free list */
-  rowlist_freelist = 0; 
-  for (i=0; i<rowlist_size-1; i++) rowlist_next[i] = i+1; 
-  rowlist_next[rowlist_size-1] = -1;
+  r->freelist = 0; 
+  for (i=0; i<r->size-1; i++) (r->next)[i] = i+1; 
+  (r->next)[r->size-1] = -1;
 				   
-  return 0;
+  return r;
 }
 
-static void rowlist_free()
-{
-  taucs_free(rowlist);
-  taucs_free(rowlist_next);
-  taucs_free(rowlist_colind);
-  taucs_free(rowlist_values);
-}
-
-/*static void rowlist_freerow(int i){}*/
+/*static void rowlist_freerow(rowlist* r, int i){}*/
 
-static void rowlist_add(int i,int j,double v)
+static int rowlist_add(rowlist* r, int i,int j,double v)
 {
   int l;
 
-  if (rowlist_freelist == -1) {
+  if (r->freelist == -1) {
     int inc = 1000;
     int ii;
-
-    rowlist_next   = (int*)    taucs_realloc( rowlist_next,   (rowlist_size+inc) * sizeof(int) );
-    rowlist_colind = (int*)    taucs_realloc( rowlist_colind, (rowlist_size+inc) * sizeof(int) );
-    rowlist_values = (double*) taucs_realloc( rowlist_values, (rowlist_size+inc) * sizeof(double) );
-
-    rowlist_freelist = rowlist_size;
-    for (ii=rowlist_size; ii<rowlist_size+inc-1; ii++)
-      rowlist_next[ii] = ii+1;
-    rowlist_next[ rowlist_size+inc-1 ] = -1;
-
-    rowlist_size    += inc;
+    int*    new_next;
+    int*    new_colind;
+    double* new_values;
+
+    new_next   = (int*)    taucs_realloc( r->next,   (r->size+inc) * sizeof(int) );
+    if (!new_next) return -1;
+    r->next   = new_next;
+    new_colind = (int*)    taucs_realloc( r->colind, (r->size+inc) * sizeof(int) );
+    if (!new_colind) return -1;
+    r->colind = new_colind;
+    new_values = (double*) taucs_realloc( r->values, (r->size+inc) * sizeof(double) );
+    if (!new_values) return -1;
+    r->values = new_values;
+
+    r->freelist = r->size;
+    for (ii=r->size; ii<r->size+inc-1; ii++)
+      (r->next)[ii] = ii+1;
+    (r->next)[ r->size+inc-1 ] = -1;
+
+    r->size    += inc;
   }
 
-  l = rowlist_freelist;
-  rowlist_freelist = rowlist_next[ rowlist_freelist ];
+  l = r->freelist;
+  r->freelist = (r->next)[ r->freelist ];
 
-  rowlist_next  [ l ] = rowlist[ i ];
-  rowlist_colind[ l ] = j;
-  rowlist_values[ l ] = v;
+  (r->next)  [ l ] = (r->head)[ i ];
+  (r->colind)[ l ] = j;
+  (r->values)[ l ] = v;
   
-  rowlist[ i ] = l;
+  (r->head)[ i ] = l;
+
+  return 0;
 }
 
-static int rowlist_getfirst(int i)
+static int rowlist_getfirst(rowlist* r, int i)
 {
-  return rowlist[ i ];
+  return (r->head)[ i ];
 }
 
-static int rowlist_getnext(int l)
+static int rowlist_getnext(rowlist* r, int l)
 {
-  return rowlist_next[ l ];
+  return (r->next)[ l ];
 }
 
-static int rowlist_getcolind(int l)
+static int rowlist_getcolind(rowlist* r, int l)
 {
-  return rowlist_colind[ l ];
+  return (r->colind)[ l ];
 }
 
 /*
-static double rowlist_getvalue(int l)
+static double rowlist_getvalue(rowlist* r, int l)
 {
-  return rowlist_values[ l ];
+  return (r->values)[ l ];
 }
 */
 
@@ -355,6 +381,7 @@ taucs_ccs_factor_xxt(taucs_ccs_matrix* A)
   double v;/*Lkj,pivot,norm omer*/
   spa*           s;
   spa*           Aej;
+  rowlist*       r;
   taucs_ccs_matrix* L;
   taucs_ccs_matrix* U;
   /*int Aj_nnz;omer*/
@@ -388,16 +415,28 @@ taucs_ccs_factor_xxt(taucs_ccs_matrix* A)
 
 
   L = taucs_dtl(ccs_create)(n,n,1000);
+
+  s   = spa_create(n);
+  Aej = spa_create(n);
+  r   = rowlist_create(n);
+
+  if (!U || !L || !s || !Aej || !r) {
+    taucs_printf("taucs_ccs_factor_xxt: out of memory\n");
+    taucs_free(bitmap);
+    rowlist_free(r);
+    if (Aej) spa_free(Aej);
+    if (s)   spa_free(s);
+    taucs_ccs_free(L);
+    taucs_ccs_free(U);
+    return NULL;
+  }
+
   /*  L->flags = TAUCS_TRIANGULAR | TAUCS_LOWER; */
   L->flags = 0;
 
   Lnnz = 1000;
   next = 0;
 
-  s   = spa_create(n);
-  Aej = spa_create(n);
-  rowlist_create(n);
-
   for (j=0; j<n; j++) {
 
     /* set the spa to ej */
@@ -416,10 +455,10 @@ taucs_ccs_factor_xxt(taucs_ccs_matrix* A)
     for (ip=0; ip<Aej->length; ip++) {
       i = (Aej->indices)[ip];
       
-      for (l = rowlist_getfirst(i); 
+      for (l = rowlist_getfirst(r,i); 
 	   l != -1; 
-	   l = rowlist_getnext(l)) {
-	k   = rowlist_getcolind(l);
+	   l = rowlist_getnext(r,l)) {
+	k   = rowlist_getcolind(r,l);
 	
 	if (bitmap[k] == j) continue;
 	bitmap[k] = j;
@@ -470,7 +509,16 @@ taucs_ccs_factor_xxt(taucs_ccs_matrix* A)
       (L->rowind)[next] = i;
       (L->taucs_values)[next] = v;
       next++;
-      rowlist_add(i,j,v);
+      if (rowlist_add(r,i,j,v) == -1) {
+	taucs_printf("taucs_ccs_factor_xxt: out of memory\n");
+	taucs_free(bitmap);
+	rowlist_free(r);
+	spa_free(Aej);
+	spa_free(s);
+	taucs_ccs_free(L);
+	taucs_ccs_free(U);
+	return NULL;
+      }
     }
 
     (L->colptr)[j+1] = next;
@@ -479,7 +527,7 @@ taucs_ccs_factor_xxt(taucs_ccs_matrix* A)
   (L->colptr)[n] = next;
   
   taucs_free(bitmap);
-  rowlist_free();
+  rowlist_free(r);
   spa_free(Aej);
   spa_free(s);
   taucs_ccs_free(U);
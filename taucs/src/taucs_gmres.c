@@ -0,0 +1,473 @@
+/*********************************************************/
+/* TAUCS                                                 */
+/* File  : taucs_gmres.c                                 */
+/* Description: restarted GMRES and BiCGStab             */
+/*********************************************************/
+
+/*********************************************************/
+/* Krylov-subspace solvers for unsymmetric systems:      */
+/* restarted flexible GMRES and BiCGStab.                */
+/*                                                       */
+/* Both use right preconditioning, x = M^{-1} y, so the  */
+/* convergence test is on the true residual b-Ax. The    */
+/* preconditioner is called as precond_fn(args,z,r) and  */
+/* solves M z = r; it is typically taucs_multilu_solve   */
+/* applied to an LU factor of a sparsified A.            */
+/*                                                       */
+/* GMRES keeps the preconditioned basis vectors Z, so    */
+/* the preconditioner may change from one iteration to   */
+/* the next (flexible GMRES, Saad 1993).                 */
+/*********************************************************/
+
+#include <stdio.h>
+#include <math.h>
+#include <assert.h>
+#include <string.h>
+#include "taucs.h"
+
+#ifndef TAUCS_CORE
+#error "You must define TAUCS_CORE to compile this file"
+#endif
+
+#ifdef TAUCS_CORE_GENERAL
+
+/*********************************************************/
+/* generic interfaces                                    */
+/*********************************************************/
+
+int
+taucs_gmres(taucs_ccs_matrix*  A,
+	    int               (*precond_fn)(void*,void* x,void* b),
+	    void*             precond_args,
+	    void*             X,
+	    void*             B,
+	    int               restart,
+	    int               itermax,
+	    double            convergetol)
+{
+#ifdef TAUCS_DOUBLE_IN_BUILD
+  if (A->flags & TAUCS_DOUBLE)
+    return taucs_dgmres(A,precond_fn,precond_args,(taucs_double*) X,(taucs_double*) B,
+			restart,itermax,convergetol);
+#endif
+
+#ifdef TAUCS_SINGLE_IN_BUILD
+  if (A->flags & TAUCS_SINGLE)
+    return taucs_sgmres(A,precond_fn,precond_args,(taucs_single*) X,(taucs_single*) B,
+			restart,itermax,convergetol);
+#endif
+
+#ifdef TAUCS_DCOMPLEX_IN_BUILD
+  if (A->flags & TAUCS_DCOMPLEX)
+    return taucs_zgmres(A,precond_fn,precond_args,(taucs_dcomplex*) X,(taucs_dcomplex*) B,
+			restart,itermax,convergetol);
+#endif
+
+#ifdef TAUCS_SCOMPLEX_IN_BUILD
+  if (A->flags & TAUCS_SCOMPLEX)
+    return taucs_cgmres(A,precond_fn,precond_args,(taucs_scomplex*) X,(taucs_scomplex*) B,
+			restart,itermax,convergetol);
+#endif
+
+  assert(0);
+  return TAUCS_ERROR;
+}
+
+int
+taucs_bicgstab(taucs_ccs_matrix*  A,
+	       int               (*precond_fn)(void*,void* x,void* b),
+	       void*             precond_args,
+	       void*             X,
+	       void*             B,
+	       int               itermax,
+	       double            convergetol)
+{
+#ifdef TAUCS_DOUBLE_IN_BUILD
+  if (A->flags & TAUCS_DOUBLE)
+    return taucs_dbicgstab(A,precond_fn,precond_args,(taucs_double*) X,(taucs_double*) B,
+			   itermax,convergetol);
+#endif
+
+#ifdef TAUCS_SINGLE_IN_BUILD
+  if (A->flags & TAUCS_SINGLE)
+    return taucs_sbicgstab(A,precond_fn,precond_args,(taucs_single*) X,(taucs_single*) B,
+			   itermax,convergetol);
+#endif
+
+#ifdef TAUCS_DCOMPLEX_IN_BUILD
+  if (A->flags & TAUCS_DCOMPLEX)
+    return taucs_zbicgstab(A,precond_fn,precond_args,(taucs_dcomplex*) X,(taucs_dcomplex*) B,
+			   itermax,convergetol);
+#endif
+
+#ifdef TAUCS_SCOMPLEX_IN_BUILD
+  if (A->flags & TAUCS_SCOMPLEX)
+    return taucs_cbicgstab(A,precond_fn,precond_args,(taucs_scomplex*) X,(taucs_scomplex*) B,
+			   itermax,convergetol);
+#endif
+
+  assert(0);
+  return TAUCS_ERROR;
+}
+
+#endif /* TAUCS_CORE_GENERAL */
+
+#ifndef TAUCS_CORE_GENERAL
+
+/*********************************************************/
+/* utilities                                             */
+/*********************************************************/
+
+#ifdef TAUCS_CORE_COMPLEX
+#define krylov_real(x) taucs_complex_create((x),0.0)
+#else
+#define krylov_real(x) (x)
+#endif
+
+/* conj(u)' * v */
+
+static taucs_datatype
+krylov_dot(int n, taucs_datatype* u, taucs_datatype* v)
+{
+  taucs_datatype s = taucs_zero;
+  int i;
+
+  for (i=0; i<n; i++)
+    s = taucs_add(s,taucs_mul(taucs_conj(u[i]),v[i]));
+
+  return s;
+}
+
+static double
+krylov_norm2(int n, taucs_datatype* v)
+{
+  double s = 0.0;
+  double a;
+  int i;
+
+  for (i=0; i<n; i++) {
+    a  = (double) taucs_abs(v[i]);
+    s += a*a;
+  }
+
+  return sqrt(s);
+}
+
+/* y = y + a*x */
+
+static void
+krylov_axpy(int n, taucs_datatype a, taucs_datatype* x, taucs_datatype* y)
+{
+  int i;
+
+  for (i=0; i<n; i++)
+    y[i] = taucs_add(y[i],taucs_mul(a,x[i]));
+}
+
+/* r = b - A*x */
+
+static void
+krylov_residual(taucs_ccs_matrix* A, taucs_datatype* x, taucs_datatype* b,
+		taucs_datatype* r)
+{
+  int i;
+
+  taucs_dtl(ccs_times_vec)(A,x,r);
+  for (i=0; i<A->n; i++) r[i] = taucs_sub(b[i],r[i]);
+}
+
+/* z = M^{-1} r, or z = r without a preconditioner */
+
+static int
+krylov_precond(int n,
+	       int (*precond_fn)(void*,void*,void*), void* precond_args,
+	       taucs_datatype* z, taucs_datatype* r)
+{
+  if (precond_fn)
+    return (*precond_fn)(precond_args,z,r);
+
+  memcpy(z,r,n*sizeof(taucs_datatype));
+  return TAUCS_SUCCESS;
+}
+
+/*********************************************************/
+/* restarted flexible GMRES                              */
+/*********************************************************/
+
+int
+taucs_dtl(gmres)(taucs_ccs_matrix*  A,
+		 int               (*precond_fn)(void*,void* x,void* b),
+		 void*             precond_args,
+		 taucs_datatype*   X,
+		 taucs_datatype*   B,
+		 int               restart,
+		 int               itermax,
+		 double            convergetol)
+{
+  int n = A->n;
+  int m;
+  int i,j,k,its;
+  int converged = 0;
+  int breakdown;
+  double bnorm, beta, resid = 0.0;
+  double hnext, nrm, a;
+
+  taucs_datatype* V  = NULL; /* (m+1) orthonormal basis vectors */
+  taucs_datatype* Z  = NULL; /* m preconditioned basis vectors  */
+  taucs_datatype* H  = NULL; /* (m+1)-by-m Hessenberg matrix    */
+  taucs_datatype* sn = NULL; /* Givens rotations                */
+  double*         cs = NULL;
+  taucs_datatype* g  = NULL; /* rotated right-hand side         */
+  taucs_datatype  t, sign;
+
+  m = (restart > 0) ? restart : 30;
+  if (m > n) m = n;
+  if (m < 1) m = 1;
+
+  bnorm = krylov_norm2(n,B);
+  if (bnorm == 0.0) {
+    for (i=0; i<n; i++) X[i] = taucs_zero;
+    taucs_printf("gmres: n=%d, zero right-hand side\n",n);
+    return TAUCS_SUCCESS;
+  }
+
+  V  = (taucs_datatype*) taucs_malloc((size_t) (m+1) * n * sizeof(taucs_datatype));
+  Z  = (taucs_datatype*) taucs_malloc((size_t)  m    * n * sizeof(taucs_datatype));
+  H  = (taucs_datatype*) taucs_malloc((size_t) (m+1) * m * sizeof(taucs_datatype));
+  sn = (taucs_datatype*) taucs_malloc( m    * sizeof(taucs_datatype));
+  cs = (double*)         taucs_malloc( m    * sizeof(double));
+  g  = (taucs_datatype*) taucs_malloc((m+1) * sizeof(taucs_datatype));
+  if (!V || !Z || !H || !sn || !cs || !g) {
+    taucs_printf("gmres: out of memory\n");
+    taucs_free(V); taucs_free(Z); taucs_free(H);
+    taucs_free(sn); taucs_free(cs); taucs_free(g);
+    return TAUCS_ERROR_NOMEM;
+  }
+
+#define h(i,j) H[(i) + (j)*(m+1)]
+
+  its = 0;
+  for (;;) {
+    krylov_residual(A,X,B,V);
+    beta  = krylov_norm2(n,V);
+    resid = beta / bnorm;
+
+    if (resid <= convergetol) { converged = 1; break; }
+    if (its >= itermax) break;
+
+    for (i=0; i<n; i++) V[i] = taucs_div(V[i],krylov_real(beta));
+    g[0] = krylov_real(beta);
+    for (i=1; i<=m; i++) g[i] = taucs_zero;
+
+    breakdown = 0;
+    for (j=0; j<m && its<itermax && !breakdown; ) {
+      taucs_datatype* vj = V + (size_t) j    *n;
+      taucs_datatype* w  = V + (size_t)(j+1)*n;
+      taucs_datatype* zj = Z + (size_t) j    *n;
+
+      if (krylov_precond(n,precond_fn,precond_args,zj,vj) != TAUCS_SUCCESS) {
+	taucs_printf("gmres: preconditioner failed\n");
+	its = itermax;
+	break;
+      }
+      taucs_dtl(ccs_times_vec)(A,zj,w);
+      its++;
+
+      /* modified Gram-Schmidt */
+      for (i=0; i<=j; i++) {
+	h(i,j) = krylov_dot(n,V + (size_t) i*n,w);
+	krylov_axpy(n,taucs_neg(h(i,j)),V + (size_t) i*n,w);
+      }
+      hnext = krylov_norm2(n,w);
+      h(j+1,j) = krylov_real(hnext);
+      if (hnext != 0.0)
+	for (i=0; i<n; i++) w[i] = taucs_div(w[i],krylov_real(hnext));
+      else
+	breakdown = 1; /* the solution is in the current subspace */
+
+      /* apply the previous rotations to the new column */
+      for (i=0; i<j; i++) {
+	t        = taucs_add(taucs_mul(krylov_real(cs[i]),h(i,j)),
+			     taucs_mul(sn[i],h(i+1,j)));
+	h(i+1,j) = taucs_sub(taucs_mul(krylov_real(cs[i]),h(i+1,j)),
+			     taucs_mul(taucs_conj(sn[i]),h(i,j)));
+	h(i,j)   = t;
+      }
+
+      /* generate a rotation that annihilates h(j+1,j) */
+      a   = (double) taucs_abs(h(j,j));
+      nrm = sqrt(a*a + hnext*hnext);
+      if (a == 0.0) {
+	cs[j] = 0.0;
+	sn[j] = taucs_one;
+	h(j,j) = krylov_real(hnext);
+      } else {
+	sign  = taucs_div(h(j,j),krylov_real(a));
+	cs[j] = a / nrm;
+	sn[j] = taucs_mul(sign,krylov_real(hnext / nrm));
+	h(j,j) = taucs_mul(sign,krylov_real(nrm));
+      }
+      h(j+1,j) = taucs_zero;
+
+      g[j+1] = taucs_neg(taucs_mul(taucs_conj(sn[j]),g[j]));
+      g[j]   = taucs_mul(krylov_real(cs[j]),g[j]);
+
+      j++;
+      resid = (double) taucs_abs(g[j]) / bnorm;
+      if (resid <= convergetol) break;
+    }
+
+    /* solve the triangular system and update x += Z y */
+    k = j;
+    for (i=k-1; i>=0; i--) {
+      t = g[i];
+      for (j=i+1; j<k; j++)
+	t = taucs_sub(t,taucs_mul(h(i,j),g[j]));
+      g[i] = ((double) taucs_abs(h(i,i)) == 0.0) ? taucs_zero : taucs_div(t,h(i,i));
+    }
+    for (i=0; i<k; i++)
+      krylov_axpy(n,g[i],Z + (size_t) i*n,X);
+  }
+
+#undef h
+
+  taucs_printf("gmres: n=%d restart=%d iterations = %d reduction in residual=%.2e\n",
+	       n,m,its,resid);
+
+  taucs_free(V); taucs_free(Z); taucs_free(H);
+  taucs_free(sn); taucs_free(cs); taucs_free(g);
+
+  return converged ? TAUCS_SUCCESS : TAUCS_ERROR;
+}
+
+/*********************************************************/
+/* BiCGStab                                              */
+/*********************************************************/
+
+int
+taucs_dtl(bicgstab)(taucs_ccs_matrix*  A,
+		    int               (*precond_fn)(void*,void* x,void* b),
+		    void*             precond_args,
+		    taucs_datatype*   X,
+		    taucs_datatype*   B,
+		    int               itermax,
+		    double            convergetol)
+{
+  int n = A->n;
+  int i,its;
+  int converged = 0;
+  double bnorm, resid;
+  taucs_datatype rho, rho_old, alpha, omega, beta, tt;
+  taucs_datatype *R, *Rhat, *P, *Phat, *S, *Shat, *T, *Vv;
+  taucs_datatype* work;
+
+  bnorm = krylov_norm2(n,B);
+  if (bnorm == 0.0) {
+    for (i=0; i<n; i++) X[i] = taucs_zero;
+    taucs_printf("bicgstab: n=%d, zero right-hand side\n",n);
+    return TAUCS_SUCCESS;
+  }
+
+  work = (taucs_datatype*) taucs_malloc((size_t) 8 * n * sizeof(taucs_datatype));
+  if (!work) {
+    taucs_printf("bicgstab: out of memory\n");
+    return TAUCS_ERROR_NOMEM;
+  }
+  R    = work;
+  Rhat = work + (size_t) n;
+  P    = work + (size_t) 2*n;
+  Phat = work + (size_t) 3*n;
+  S    = work + (size_t) 4*n;
+  Shat = work + (size_t) 5*n;
+  T    = work + (size_t) 6*n;
+  Vv   = work + (size_t) 7*n;
+
+  krylov_residual(A,X,B,R);
+  memcpy(Rhat,R,n*sizeof(taucs_datatype));
+  resid = krylov_norm2(n,R) / bnorm;
+  if (resid <= convergetol) converged = 1;
+
+  rho_old = alpha = omega = taucs_one;
+
+  for (its=0; its<itermax && !converged; its++) {
+    rho = krylov_dot(n,Rhat,R);
+    if ((double) taucs_abs(rho) == 0.0) {
+      taucs_printf("bicgstab: breakdown (rho=0)\n");
+      break;
+    }
+
+    if (its == 0)
+      memcpy(P,R,n*sizeof(taucs_datatype));
+    else {
+      beta = taucs_mul(taucs_div(rho,rho_old),taucs_div(alpha,omega));
+      for (i=0; i<n; i++)
+	P[i] = taucs_add(R[i],
+			 taucs_mul(beta,taucs_sub(P[i],taucs_mul(omega,Vv[i]))));
+    }
+
+    if (krylov_precond(n,precond_fn,precond_args,Phat,P) != TAUCS_SUCCESS) {
+      taucs_printf("bicgstab: preconditioner failed\n");
+      break;
+    }
+    taucs_dtl(ccs_times_vec)(A,Phat,Vv);
+
+    tt = krylov_dot(n,Rhat,Vv);
+    if ((double) taucs_abs(tt) == 0.0) {
+      taucs_printf("bicgstab: breakdown (rhat'v=0)\n");
+      break;
+    }
+    alpha = taucs_div(rho,tt);
+
+    for (i=0; i<n; i++) S[i] = taucs_sub(R[i],taucs_mul(alpha,Vv[i]));
+
+    resid = krylov_norm2(n,S) / bnorm;
+    if (resid <= convergetol) {
+      krylov_axpy(n,alpha,Phat,X);
+      converged = 1;
+      its++;
+      break;
+    }
+
+    if (krylov_precond(n,precond_fn,precond_args,Shat,S) != TAUCS_SUCCESS) {
+      taucs_printf("bicgstab: preconditioner failed\n");
+      break;
+    }
+    taucs_dtl(ccs_times_vec)(A,Shat,T);
+
+    tt = krylov_dot(n,T,T);
+    if ((double) taucs_abs(tt) == 0.0) {
+      /* s is already zero to working precision */
+      krylov_axpy(n,alpha,Phat,X);
+      converged = 1;
+      its++;
+      break;
+    }
+    omega = taucs_div(krylov_dot(n,T,S),tt);
+
+    krylov_axpy(n,alpha,Phat,X);
+    krylov_axpy(n,omega,Shat,X);
+    for (i=0; i<n; i++) R[i] = taucs_sub(S[i],taucs_mul(omega,T[i]));
+
+    resid = krylov_norm2(n,R) / bnorm;
+    if (resid <= convergetol) { converged = 1; its++; break; }
+
+    if ((double) taucs_abs(omega) == 0.0) {
+      taucs_printf("bicgstab: breakdown (omega=0)\n");
+      its++;
+      break;
+    }
+    rho_old = rho;
+  }
+
+  taucs_printf("bicgstab: n=%d iterations = %d reduction in residual=%.2e\n",
+	       n,its,resid);
+
+  taucs_free(work);
+  return converged ? TAUCS_SUCCESS : TAUCS_ERROR;
+}
+
+#endif /* not TAUCS_CORE_GENERAL */
+
+/*********************************************************/
+/*                                                       */
+/*********************************************************/
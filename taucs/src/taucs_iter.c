@@ -13,63 +13,37 @@
 #include "pfunc.h"
 #endif
 
-#ifdef TAUCS_CORE_DOUBLE
+#ifndef TAUCS_CORE_GENERAL
 
 /*********************************************************/
 /* utilities                                             */
+/*                                                       */
+/* The solvers below work on a real view of the vectors: */
+/* a complex vector of length n is 2n interleaved reals. */
+/* With Hermitian A every scalar in CG and MINRES is     */
+/* real, so the vector loops need no complex arithmetic  */
+/* and compile to plain, vectorizable real loops.        */
 /*********************************************************/
-/*extern int _isnan(double);*/
 
-static int element_size(int flags)
-{
-  if (flags & TAUCS_SINGLE)   return sizeof(taucs_single);
-  if (flags & TAUCS_DOUBLE)   return sizeof(taucs_double);
-  if (flags & TAUCS_SCOMPLEX) return sizeof(taucs_scomplex);
-  if (flags & TAUCS_DCOMPLEX) return sizeof(taucs_dcomplex);
-  if (flags & TAUCS_INT)      return sizeof(int);
-  assert(0);
-  return -1;
-}
+#ifdef TAUCS_CORE_COMPLEX
+#define REAL_LENGTH(n) (2*(n))
+#else
+#define REAL_LENGTH(n) (n)
+#endif
+
+/* returns Re(v'*u) */
 
-static double dotprod(int n, double* v, double* u)
+static double dotprod(int n, taucs_real_datatype* v, taucs_real_datatype* u)
 {
   double x;
   int i;
 
-  for (i=0, x=0.0; i<n; i++) x += v[i]*u[i];
+  for (i=0, x=0.0; i<n; i++) x += (double) v[i] * (double) u[i];
 
   return x;
 }
 
-#ifdef TAUCS_CONFIG_PFUNC
-static double parallel_dotprod(double *v, double *w, int sv, int ev, double *S, int tid, pfunc_handle_t handle, int nproc)
-{
-  //  static int k[2] = {0, 0};
-
-  int i = 0;
-  *(S + tid) = 0.0;
-  for (i = sv; i < ev; i++)
-    *(S + tid) += v[i] * w[i];
-
-  //double hit = taucs_wtime();
-  pfunc_barrier();
-  //double exit = taucs_wtime();
-
-  //taucs_printf("(tid: %d) K = %d, Hit = %f, Exit = %f.\n", tid, k[tid], hit, exit);
-  //k[tid]++;
-
-  double r = 0.0;
-  for(i = 0; i < nproc; i++)
-    r += S[i];
-
-
-
-  return r;
-}
-
-#endif
-
-static double twonorm(int n, double* v)
+static double twonorm(int n, taucs_real_datatype* v)
 {
   /*
   double norm;
@@ -102,6 +76,54 @@ static double twonorm(int n, double* v)
   return scale * sqrt( ssq );
 }
 
+#endif /* not TAUCS_CORE_GENERAL */
+
+#ifdef TAUCS_CORE_DOUBLE
+
+/*********************************************************/
+/* utilities                                             */
+/*********************************************************/
+/*extern int _isnan(double);*/
+
+static int element_size(int flags)
+{
+  if (flags & TAUCS_SINGLE)   return sizeof(taucs_single);
+  if (flags & TAUCS_DOUBLE)   return sizeof(taucs_double);
+  if (flags & TAUCS_SCOMPLEX) return sizeof(taucs_scomplex);
+  if (flags & TAUCS_DCOMPLEX) return sizeof(taucs_dcomplex);
+  if (flags & TAUCS_INT)      return sizeof(int);
+  assert(0);
+  return -1;
+}
+
+#ifdef TAUCS_CONFIG_PFUNC
+static double parallel_dotprod(double *v, double *w, int sv, int ev, double *S, int tid, pfunc_handle_t handle, int nproc)
+{
+  //  static int k[2] = {0, 0};
+
+  int i = 0;
+  *(S + tid) = 0.0;
+  for (i = sv; i < ev; i++)
+    *(S + tid) += v[i] * w[i];
+
+  //double hit = taucs_wtime();
+  pfunc_barrier();
+  //double exit = taucs_wtime();
+
+  //taucs_printf("(tid: %d) K = %d, Hit = %f, Exit = %f.\n", tid, k[tid], hit, exit);
+  //k[tid]++;
+
+  double r = 0.0;
+  for(i = 0; i < nproc; i++)
+    r += S[i];
+
+
+
+  return r;
+}
+
+#endif
+
 #ifdef TAUCS_CONFIG_PFUNC
 
 /* Map and reduce implementation of twonorm */
@@ -407,7 +429,7 @@ static void taucs_pfunc_conjugate_gradients(void *args)
 	       &P, &R, &Q, &Z, &S1, &S2, &S3, &tid, &handle, &nproc);
 
 
-  taucs_printf("taucs_pfunc_conjugate_gradients: (tid %d) Starting to work. sv = %d, mv = %d, ev = %d. \n", tid, sv, mv, ev);
+  taucs_log(TAUCS_LOG_ITER,TAUCS_LOG_DEBUG,"taucs_pfunc_conjugate_gradients: (tid %d) Starting to work. sv = %d, mv = %d, ev = %d. \n", tid, sv, mv, ev);
 
   double* X = (double*) vX;
   double* B = (double*) vB;
@@ -477,8 +499,9 @@ static void taucs_pfunc_conjugate_gradients(void *args)
     
     ratio = Res_norm/Init_norm;
     if (tid == 0 && Iter % 25 == 0) 
-      taucs_printf("cg: n=%d at iteration %d the convergence ratio is %.2e, Rnorm %.2e\n", 
-		   A->n,Iter, ratio,Res_norm) ;
+      taucs_log(TAUCS_LOG_ITER,TAUCS_LOG_DEBUG,
+		"cg: n=%d at iteration %d the convergence ratio is %.2e, Rnorm %.2e\n", 
+		A->n,Iter, ratio,Res_norm) ;
   }
   pfunc_barrier();
 
@@ -498,231 +521,502 @@ static void taucs_pfunc_conjugate_gradients(void *args)
   // THE FOLLOWING LINES ARE DEBUG
   pfunc_barrier();
   fflush(stdout);
-  taucs_printf("taucs_pfunc_conjugate_gradients: (tid %d) Finished working.\n", tid);
+  taucs_log(TAUCS_LOG_ITER,TAUCS_LOG_DEBUG,"taucs_pfunc_conjugate_gradients: (tid %d) Finished working.\n", tid);
 }
 
 #endif
 
+#endif /* TAUCS_CORE_DOUBLE */
+
+/*********************************************************/
+/* generic interfaces                                    */
+/*********************************************************/
+
+#ifdef TAUCS_CORE_GENERAL
+
 int 
 taucs_conjugate_gradients(taucs_ccs_matrix* A,
 			  int               (*precond_fn)(void*,void* x,void* b),
 			  void*             precond_args,
-			  void*             vX,
-			  void*             vB,
+			  void*             X,
+			  void*             B,
 			  int               itermax,
 			  double            convergetol
 			  )
 {
-  double ct;
-  double* X = (double*) vX;
-  double* B = (double*) vB;
-  double *P, *R, *Q, *Z ;
+#ifdef TAUCS_DOUBLE_IN_BUILD
+  if (A->flags & TAUCS_DOUBLE)
+    return taucs_dconjugate_gradients(A,precond_fn,precond_args,
+				      (taucs_double*) X,(taucs_double*) B,
+				      itermax,convergetol);
+#endif
+
+#ifdef TAUCS_SINGLE_IN_BUILD
+  if (A->flags & TAUCS_SINGLE)
+    return taucs_sconjugate_gradients(A,precond_fn,precond_args,
+				      (taucs_single*) X,(taucs_single*) B,
+				      itermax,convergetol);
+#endif
+
+#ifdef TAUCS_DCOMPLEX_IN_BUILD
+  if (A->flags & TAUCS_DCOMPLEX)
+    return taucs_zconjugate_gradients(A,precond_fn,precond_args,
+				      (taucs_dcomplex*) X,(taucs_dcomplex*) B,
+				      itermax,convergetol);
+#endif
+
+#ifdef TAUCS_SCOMPLEX_IN_BUILD
+  if (A->flags & TAUCS_SCOMPLEX)
+    return taucs_cconjugate_gradients(A,precond_fn,precond_args,
+				      (taucs_scomplex*) X,(taucs_scomplex*) B,
+				      itermax,convergetol);
+#endif
+
+  assert(0);
+  return -1;
+}
+
+int 
+taucs_minres(taucs_ccs_matrix*  A,
+	     int                (*precond_fn)(void*,void* x,void* b),
+	     void*              precond_args,
+	     void*              X,
+	     void*              B,
+	     int                itermax,
+	     double             convergetol)
+{
+#ifdef TAUCS_DOUBLE_IN_BUILD
+  if (A->flags & TAUCS_DOUBLE)
+    return taucs_dminres(A,precond_fn,precond_args,
+			 (taucs_double*) X,(taucs_double*) B,
+			 itermax,convergetol);
+#endif
+
+#ifdef TAUCS_SINGLE_IN_BUILD
+  if (A->flags & TAUCS_SINGLE)
+    return taucs_sminres(A,precond_fn,precond_args,
+			 (taucs_single*) X,(taucs_single*) B,
+			 itermax,convergetol);
+#endif
+
+#ifdef TAUCS_DCOMPLEX_IN_BUILD
+  if (A->flags & TAUCS_DCOMPLEX)
+    return taucs_zminres(A,precond_fn,precond_args,
+			 (taucs_dcomplex*) X,(taucs_dcomplex*) B,
+			 itermax,convergetol);
+#endif
+
+#ifdef TAUCS_SCOMPLEX_IN_BUILD
+  if (A->flags & TAUCS_SCOMPLEX)
+    return taucs_cminres(A,precond_fn,precond_args,
+			 (taucs_scomplex*) X,(taucs_scomplex*) B,
+			 itermax,convergetol);
+#endif
+
+  assert(0);
+  return -1;
+}
+
+int 
+taucs_conjugate_gradients_info(taucs_ccs_matrix* A,
+                               int               (*precond_fn)(void*,void* x,void* b),
+                               void*             precond_args,
+                               void*             X,
+                               void*             B,
+                               taucs_iter_info*  info)
+{
+#ifdef TAUCS_DOUBLE_IN_BUILD
+  if (A->flags & TAUCS_DOUBLE)
+    return taucs_dconjugate_gradients_info(A,precond_fn,precond_args,
+                                   (taucs_double*) X,(taucs_double*) B,info);
+#endif
+
+#ifdef TAUCS_SINGLE_IN_BUILD
+  if (A->flags & TAUCS_SINGLE)
+    return taucs_sconjugate_gradients_info(A,precond_fn,precond_args,
+                                   (taucs_single*) X,(taucs_single*) B,info);
+#endif
+
+#ifdef TAUCS_DCOMPLEX_IN_BUILD
+  if (A->flags & TAUCS_DCOMPLEX)
+    return taucs_zconjugate_gradients_info(A,precond_fn,precond_args,
+                                   (taucs_dcomplex*) X,(taucs_dcomplex*) B,info);
+#endif
+
+#ifdef TAUCS_SCOMPLEX_IN_BUILD
+  if (A->flags & TAUCS_SCOMPLEX)
+    return taucs_cconjugate_gradients_info(A,precond_fn,precond_args,
+                                   (taucs_scomplex*) X,(taucs_scomplex*) B,info);
+#endif
+
+  assert(0);
+  return -1;
+}
+
+int 
+taucs_minres_info(taucs_ccs_matrix* A,
+                  int               (*precond_fn)(void*,void* x,void* b),
+                  void*             precond_args,
+                  void*             X,
+                  void*             B,
+                  taucs_iter_info*  info)
+{
+#ifdef TAUCS_DOUBLE_IN_BUILD
+  if (A->flags & TAUCS_DOUBLE)
+    return taucs_dminres_info(A,precond_fn,precond_args,
+                      (taucs_double*) X,(taucs_double*) B,info);
+#endif
+
+#ifdef TAUCS_SINGLE_IN_BUILD
+  if (A->flags & TAUCS_SINGLE)
+    return taucs_sminres_info(A,precond_fn,precond_args,
+                      (taucs_single*) X,(taucs_single*) B,info);
+#endif
+
+#ifdef TAUCS_DCOMPLEX_IN_BUILD
+  if (A->flags & TAUCS_DCOMPLEX)
+    return taucs_zminres_info(A,precond_fn,precond_args,
+                      (taucs_dcomplex*) X,(taucs_dcomplex*) B,info);
+#endif
+
+#ifdef TAUCS_SCOMPLEX_IN_BUILD
+  if (A->flags & TAUCS_SCOMPLEX)
+    return taucs_cminres_info(A,precond_fn,precond_args,
+                      (taucs_scomplex*) X,(taucs_scomplex*) B,info);
+#endif
+
+  assert(0);
+  return -1;
+}
+
+#endif /* TAUCS_CORE_GENERAL */
+
+#ifndef TAUCS_CORE_GENERAL
+
+/*********************************************************/
+/* bookkeeping shared by CG and MINRES                   */
+/*********************************************************/
+
+static void
+iter_info_init(taucs_iter_info* info, int itermax, double convergetol)
+{
+  memset(info,0,sizeof(taucs_iter_info));
+  info->itermax     = itermax;
+  info->convergetol = convergetol;
+}
+
+static void
+iter_info_clear_results(taucs_iter_info* info)
+{
+  info->iterations   = 0;
+  info->converged    = 0;
+  info->stopped      = 0;
+  info->replacements = 0;
+  info->resvec_used  = 0;
+  info->relres       = 0.0;
+  info->solve_time   = 0.0;
+  info->precond_time = 0.0;
+  info->time_per_iteration = 0.0;
+}
+
+/* records the relative residual of iteration iter and   */
+/* asks the callback whether to continue; returns        */
+/* nonzero if the solve should stop.                     */
+
+static int
+iter_info_step(taucs_iter_info* info, int iter, double relres)
+{
+  if (info->resvec && iter < info->resvec_length) {
+    info->resvec[iter] = relres;
+    info->resvec_used  = iter+1;
+  }
+  if (info->callback && (*(info->callback))(info->callback_arg,iter,relres)) {
+    info->stopped = 1;
+    return 1;
+  }
+  return 0;
+}
+
+static void
+iter_info_finish(taucs_iter_info* info, int iter, double relres, double t)
+{
+  info->iterations = iter;
+  info->relres     = relres;
+  info->converged  = (relres <= info->convergetol);
+  info->solve_time = t;
+  info->time_per_iteration = (iter > 0) ? t / iter : 0.0;
+}
+
+/*********************************************************/
+/* conjugate gradients                                   */
+/*********************************************************/
+
+int 
+taucs_dtl(conjugate_gradients_info)(taucs_ccs_matrix* A,
+				    int               (*precond_fn)(void*,void* x,void* b),
+				    void*             precond_args,
+				    taucs_datatype*   vX,
+				    taucs_datatype*   vB,
+				    taucs_iter_info*  info
+				    )
+{
+  double ct, pt;
+  taucs_datatype *vP, *vR, *vQ, *vZ;
+  taucs_real_datatype *X, *B, *P, *R, *Q, *Z; /* real views */
+  taucs_real_datatype alpha, beta;
   double Alpha, Beta, Rho, Init_norm, ratio, Res_norm, Rtmp ;
   double Rho0 = 0.0; /* warning */
-  /*double t1, t2,  cpus[9] ; omer*/
-  /*
-  double one[2] = {1.0, 0.0};
-  double zero[2] = {0.0, 0.0} ;
-  */
-  /*  double Tiny = 0.0;*/
   double Tiny = 0.1e-28;
+  double convergetol = info->convergetol;
+  int    itermax     = info->itermax;
+  int    replace     = info->replace_every;
+  int    nreplaced   = 0;
   int    Iter;
-  /*int    stats[6] ; omer*/
-  int    i,n;
-
-#define RESVEC_NO
-#ifdef RESVEC
-  FILE* f;
-  double* resvec = (double*) taucs_malloc((itermax+2) * sizeof(double));
-  assert(resvec);
-  for (i=0; i<=itermax; i++) {
-    /*double inf = 1.0/0.0; omer*/
-    double nan = taucs_get_nan()/*inf - inf; omer*/
-    assert(taucs_isnan(nan));
-    resvec[i] = nan;
+  int    i,n,nr;
+
+  iter_info_clear_results(info);
+
+#ifdef TAUCS_CORE_COMPLEX
+  /* the real-view inner products assume a Hermitian A */
+  if (!(A->flags & TAUCS_HERMITIAN)) {
+    taucs_printf("cg: complex matrices must be Hermitian\n");
+    return TAUCS_ERROR_BADARGS;
   }
 #endif
 
-  n = A->n;
+  n  = A->n;
+  nr = REAL_LENGTH(n);
  
-  P = (double*) taucs_malloc(n * sizeof(double));
-  R = (double*) taucs_malloc(n * sizeof(double));
-  Q = (double*) taucs_malloc(n * sizeof(double));
-  Z = (double*) taucs_malloc(n * sizeof(double));
+  vP = (taucs_datatype*) taucs_malloc(n * sizeof(taucs_datatype));
+  vR = (taucs_datatype*) taucs_malloc(n * sizeof(taucs_datatype));
+  vQ = (taucs_datatype*) taucs_malloc(n * sizeof(taucs_datatype));
+  vZ = (taucs_datatype*) taucs_malloc(n * sizeof(taucs_datatype));
+  if (!vP || !vR || !vQ || !vZ) {
+    taucs_printf("cg: out of memory\n");
+    taucs_free(vP); taucs_free(vR); taucs_free(vQ); taucs_free(vZ);
+    return TAUCS_ERROR_NOMEM;
+  }
+
+  X = (taucs_real_datatype*) vX;
+  B = (taucs_real_datatype*) vB;
+  P = (taucs_real_datatype*) vP;
+  R = (taucs_real_datatype*) vR;
+  Q = (taucs_real_datatype*) vQ;
+  Z = (taucs_real_datatype*) vZ;
 
 #define TAUCS_REMOVE_CONST_NO
 #ifdef TAUCS_REMOVE_CONST
     {
       double s;
-      for (i=0, s=0.0; i<n; i++) s += B[i];
-      for (i=0, s=0.0; i<n; i++) B[i] -= s;
+      for (i=0, s=0.0; i<nr; i++) s += B[i];
+      for (i=0, s=0.0; i<nr; i++) B[i] -= s;
     }
 #endif
 
-  /*
-  for (i=0; i<n; i++) X[i] = 0;
-  for (i=0; i<n; i++) R[i] = B[i];
-  */
-
   ct = -taucs_wtime();
+  pt = 0.0;
 
-  taucs_ccs_times_vec(A,X,R);
+  taucs_dtl(ccs_times_vec)(A,vX,vR);
 
-  for (i=0; i<n; i++) R[i] = B[i] - R[i];
+  for (i=0; i<nr; i++) R[i] = B[i] - R[i];
 
-  Res_norm = Init_norm = twonorm(n,R);
-  taucs_printf("two norm of initial residual %.2e\n",Init_norm);
+  Res_norm = Init_norm = twonorm(nr,R);
   if ( Init_norm == 0.0 ) Init_norm = 1.0;
-  ratio = 1.0;
+  ratio = Res_norm/Init_norm;
  
   Iter = 0;
- 
-#ifdef RESVEC
-  resvec[Iter] = Res_norm;
-#endif
+  iter_info_step(info,Iter,ratio);
 
-  while ( ratio > convergetol && Iter <= itermax ) {
+  /* no I/O inside this loop; progress goes to info */
+
+  while ( ratio > convergetol && Iter < itermax && !info->stopped ) {
     Iter++;
     
+    pt -= taucs_wtime();
     if (precond_fn)
-      (*precond_fn)(precond_args,Z,R);
+      (*precond_fn)(precond_args,vZ,vR);
     else
-      for (i=0; i<n; i++) Z[i] = R[i];
-
-    for (i=0,Rho=0.0; i<n; i++) Rho += R[i] * Z[i];
+      for (i=0; i<nr; i++) Z[i] = R[i];
+    pt += taucs_wtime();
 
+    Rho = dotprod(nr,R,Z);
 
     if ( Iter == 1 ) {
-      for (i=0; i<n; i++) P[i] = Z[i];
+      for (i=0; i<nr; i++) P[i] = Z[i];
     } else {
       Beta = Rho /(Rho0 + Tiny);
-      for (i=0; i<n; i++) P[i] = Z[i] + Beta * P[i];
+      beta = (taucs_real_datatype) Beta;
+      for (i=0; i<nr; i++) P[i] = Z[i] + beta * P[i];
     };
 
-    taucs_ccs_times_vec(A,P,Q); /* Q = A*P */
+    taucs_dtl(ccs_times_vec)(A,vP,vQ); /* Q = A*P */
 
-    for (i=0,Rtmp=0.0; i<n; i++) Rtmp += P[i] * Q[i];
+    Rtmp = dotprod(nr,P,Q);
   
     Alpha = Rho/(Rtmp+Tiny);
+    alpha = (taucs_real_datatype) Alpha;
 
-    for (i=0; i<n; i++) X[i] = X[i] + Alpha * P[i];
+    for (i=0; i<nr; i++) X[i] = X[i] + alpha * P[i];
 
-    for (i=0; i<n; i++) R[i] = R[i] - Alpha * Q[i];
+    for (i=0; i<nr; i++) R[i] = R[i] - alpha * Q[i];
 
 #ifdef TAUCS_REMOVE_CONST
     {
       double s;
-      for (i=0, s=0.0; i<n; i++) s += R[i];
-      for (i=0, s=0.0; i<n; i++) R[i] -= s;
+      for (i=0, s=0.0; i<nr; i++) s += R[i];
+      for (i=0, s=0.0; i<nr; i++) R[i] -= s;
     }
 #endif
 
-
     Rho0  = Rho;
 
-    Res_norm = twonorm(n,R);
+    Res_norm = twonorm(nr,R);
+    ratio = Res_norm/Init_norm;
 
-#if 0
-    taucs_ccs_times_vec(A,X,R);
-    for (i=0; i<n; i++) R[i] -= B[i];
-    Res_norm = twonorm(n,R);
-#endif
+    /* residual replacement: the recursively updated R drifts */
+    /* away from B-AX, so every few iterations, and before    */
+    /* accepting convergence, replace it by the true residual */
 
-#ifdef RESVEC
-  resvec[Iter] = Res_norm;
-#endif
+    if ((replace > 0 && Iter % replace == 0) || ratio <= convergetol) {
+      taucs_dtl(ccs_times_vec)(A,vX,vR);
+      for (i=0; i<nr; i++) R[i] = B[i] - R[i];
+      Res_norm = twonorm(nr,R);
+      ratio = Res_norm/Init_norm;
+      nreplaced++;
+    }
 
-    ratio = Res_norm/Init_norm;
-    if (Iter % 25 == 0) 
-      taucs_printf("cg: n=%d at iteration %d the convergence ratio is %.2e, Rnorm %.2e\n", 
-		   A->n,Iter, ratio,Res_norm) ;
+    iter_info_step(info,Iter,ratio);
   }
 
+  /* the reported residual is always the true one */
+  taucs_dtl(ccs_times_vec)(A,vX,vR);
+  for (i=0; i<nr; i++) R[i] = B[i] - R[i];
+  Res_norm = twonorm(nr,R);
+
   ct += taucs_wtime();
-  taucs_printf("Iteration time = %.2es\n", ct);
+  info->precond_time = pt;
+  info->replacements = nreplaced;
+  iter_info_finish(info,Iter,Res_norm/Init_norm,ct);
 
-  if (Iter > 0) {
-    taucs_printf("cg: n=%d iterations = %d Reduction in residual norm %.2e, Rnorm %.2e\n", 
-		 A->n,Iter,ratio,Res_norm) ;
-    taucs_ccs_times_vec(A,X,R);
-    for (i=0; i<n; i++) R[i] = B[i] - R[i];
-    taucs_printf("cg: true residual norm %.2e\n",twonorm(n,R));
-  }
+  taucs_printf("cg: n=%d iterations = %d Reduction in residual norm %.2e, Rnorm %.2e%s\n", 
+	       A->n,Iter,ratio,Res_norm,info->stopped ? " (stopped by callback)" : "");
+  taucs_printf("cg: true relative residual norm %.2e, %d replacements\n",info->relres,nreplaced);
+  taucs_printf("cg: iteration time = %.2es (%.2es per iteration, %.2es in preconditioner)\n",
+	       ct,info->time_per_iteration,pt);
 
-  taucs_free(P) ;
-  taucs_free(R) ;
-  taucs_free(Q) ;
-  taucs_free(Z) ;
- 
-#ifdef RESVEC
-  f=fopen("resvec","a");
-  assert(f);
-  for (i=0; i<=itermax && !taucs_isnan(resvec[i]); i++) {
-    fprintf(f,"%.3e\n",resvec[i]);
-  }
-  fclose(f);
-  taucs_free(resvec);
-#endif
+  taucs_free(vP) ;
+  taucs_free(vR) ;
+  taucs_free(vQ) ;
+  taucs_free(vZ) ;
 
   return 0; 
 }                                                                             
 
+int 
+taucs_dtl(conjugate_gradients)(taucs_ccs_matrix* A,
+			       int               (*precond_fn)(void*,void* x,void* b),
+			       void*             precond_args,
+			       taucs_datatype*   X,
+			       taucs_datatype*   B,
+			       int               itermax,
+			       double            convergetol
+			       )
+{
+  taucs_iter_info info;
+
+  iter_info_init(&info,itermax,convergetol);
+  return taucs_dtl(conjugate_gradients_info)(A,precond_fn,precond_args,X,B,&info);
+}
+
 /*********************************************************/
 /* minres                                                */
 /*********************************************************/
 
 int 
-taucs_minres(taucs_ccs_matrix*  A,
-	     int                (*precond_fn)(void*,void* x,void* b),
-	     void*              precond_args,
-	     void*              vX,
-	     void*              vB,
-	     int                itermax,
-	     double             convergetol)
+taucs_dtl(minres_info)(taucs_ccs_matrix*  A,
+		       int                (*precond_fn)(void*,void* x,void* b),
+		       void*              precond_args,
+		       taucs_datatype*    vX,
+		       taucs_datatype*    vB,
+		       taucs_iter_info*   info)
 {
-  double* X = (double*) vX;
-  double* B = (double*) vB;
-
-  double *Xcg, *R, *V, *VV, *Vold, *Volder, *M, *Mold, *Molder;
-  double tolb, normr, alpha, beta, beta1, betaold;
+  taucs_datatype *vXcg, *vR, *vV, *vVV, *vVold, *vVolder, *vM, *vMold, *vMolder;
+  taucs_real_datatype *X, *B;                  /* real views */
+  taucs_real_datatype *Xcg, *R, *V, *VV, *Vold, *Volder, *M, *Mold, *Molder;
+  taucs_real_datatype t1, t2;
+  double tolb, normb, normr, alpha, beta, beta1, betaold;
   double gamma, gammabar, delta, deltabar, epsilon;
   double cs,sn,snprod, numer, denom;
+  double ct, pt;
+  double convergetol = info->convergetol;
+  int    itermax     = info->itermax;
+  int    replace     = info->replace_every;
+  int    nreplaced   = 0;
   int    Iter;
-  int    i,n;
+  int    i,n,nr;
+
+  iter_info_clear_results(info);
+
+#ifdef TAUCS_CORE_COMPLEX
+  /* the real-view inner products assume a Hermitian A */
+  if (!(A->flags & TAUCS_HERMITIAN)) {
+    taucs_printf("minres: complex matrices must be Hermitian\n");
+    return TAUCS_ERROR_BADARGS;
+  }
+#endif
 
-  n = A->n;
+  n  = A->n;
+  nr = REAL_LENGTH(n);
  
-  R      = (double*) taucs_malloc(n * sizeof(double));
-  Xcg    = (double*) taucs_malloc(n * sizeof(double));
-  VV     = (double*) taucs_malloc(n * sizeof(double));
-  V      = (double*) taucs_malloc(n * sizeof(double));
-  Vold   = (double*) taucs_malloc(n * sizeof(double));
-  Volder = (double*) taucs_malloc(n * sizeof(double));
-  M      = (double*) taucs_malloc(n * sizeof(double));
-  Mold   = (double*) taucs_malloc(n * sizeof(double));
-  Molder = (double*) taucs_malloc(n * sizeof(double));
-
-  tolb = convergetol * twonorm(n,B);
+  vR      = (taucs_datatype*) taucs_malloc(n * sizeof(taucs_datatype));
+  vXcg    = (taucs_datatype*) taucs_malloc(n * sizeof(taucs_datatype));
+  vVV     = (taucs_datatype*) taucs_malloc(n * sizeof(taucs_datatype));
+  vV      = (taucs_datatype*) taucs_malloc(n * sizeof(taucs_datatype));
+  vVold   = (taucs_datatype*) taucs_malloc(n * sizeof(taucs_datatype));
+  vVolder = (taucs_datatype*) taucs_malloc(n * sizeof(taucs_datatype));
+  vM      = (taucs_datatype*) taucs_malloc(n * sizeof(taucs_datatype));
+  vMold   = (taucs_datatype*) taucs_malloc(n * sizeof(taucs_datatype));
+  vMolder = (taucs_datatype*) taucs_malloc(n * sizeof(taucs_datatype));
+
+  X      = (taucs_real_datatype*) vX;
+  B      = (taucs_real_datatype*) vB;
+  R      = (taucs_real_datatype*) vR;
+  Xcg    = (taucs_real_datatype*) vXcg;
+  VV     = (taucs_real_datatype*) vVV;
+  V      = (taucs_real_datatype*) vV;
+  Vold   = (taucs_real_datatype*) vVold;
+  Volder = (taucs_real_datatype*) vVolder;
+  M      = (taucs_real_datatype*) vM;
+  Mold   = (taucs_real_datatype*) vMold;
+  Molder = (taucs_real_datatype*) vMolder;
+
+  ct = -taucs_wtime();
+  pt = 0.0;
+
+  normb = twonorm(nr,B);
+  tolb = convergetol * normb;
   taucs_printf("minres: residual convergence tolerance %.1e\n",tolb);
  
-  for (i=0; i<n; i++) X[i] = 0;    /* x = 0 */
-  for (i=0; i<n; i++) R[i] = B[i]; /* r = b-A*x */
+  for (i=0; i<nr; i++) X[i] = 0;    /* x = 0 */
+  for (i=0; i<nr; i++) R[i] = B[i]; /* r = b-A*x */
 
-  normr = twonorm(n,R);
+  normr = twonorm(nr,R);
   if ( normr == 0.0 ) {
     taucs_printf("minres: initial residual == 0\n");
     return -1;
   }
 
-  for (i=0; i<n; i++) V[i]    = R[i];    /* v = r */
-  for (i=0; i<n; i++) Vold[i] = R[i];    /* vold = r */
+  for (i=0; i<nr; i++) V[i]    = R[i];    /* v = r */
+  for (i=0; i<nr; i++) Vold[i] = R[i];    /* vold = r */
   
+  pt -= taucs_wtime();
   if (precond_fn)
-    (*precond_fn)(precond_args,V,Vold);
+    (*precond_fn)(precond_args,vV,vVold);
   else
-    for (i=0; i<n; i++) V[i] = Vold[i];
+    for (i=0; i<nr; i++) V[i] = Vold[i];
+  pt += taucs_wtime();
   
-  beta1 = dotprod(n,Vold,V);
+  beta1 = dotprod(nr,Vold,V);
   if (beta1 < 0.0) {
     taucs_printf("minres: error (1)\n");
     return -1;
@@ -731,7 +1025,7 @@ taucs_minres(taucs_ccs_matrix*  A,
 
   { int flag = 0;
     for (i=0; i<n; i++) {
-      if (taucs_isnan(V[i]) && flag < 10) 
+      if (taucs_isnan(vV[i]) && flag < 10) 
 	taucs_printf("minres: V has nan's in position %d\n",i);
       flag++;
     }
@@ -739,34 +1033,37 @@ taucs_minres(taucs_ccs_matrix*  A,
 
 
   snprod = beta1;
-  taucs_printf(">>> %e %e %e\n",beta1,snprod,normr);
-
 
-  for (i=0; i<n; i++) VV[i] = V[i] / beta1;
+  t1 = (taucs_real_datatype) beta1;
+  for (i=0; i<nr; i++) VV[i] = V[i] / t1;
   
-  taucs_ccs_times_vec(A,VV,V); /* V = A*VV */
+  taucs_dtl(ccs_times_vec)(A,vVV,vV); /* V = A*VV */
   
-  alpha = dotprod(n,VV,V);
+  alpha = dotprod(nr,VV,V);
   
-  for (i=0; i<n; i++) V[i] -= (alpha/beta1) * Vold[i];
+  t1 = (taucs_real_datatype) (alpha/beta1);
+  for (i=0; i<nr; i++) V[i] -= t1 * Vold[i];
   
   /* local reorthogonalization */
 
-  numer = dotprod(n,VV,V);
-  denom = dotprod(n,VV,VV);
+  numer = dotprod(nr,VV,V);
+  denom = dotprod(nr,VV,VV);
 
-  for (i=0; i<n; i++) V[i] -= (numer/denom) * VV[i];
+  t1 = (taucs_real_datatype) (numer/denom);
+  for (i=0; i<nr; i++) V[i] -= t1 * VV[i];
 
-  for (i=0; i<n; i++) Volder[i] = Vold[i];
-  for (i=0; i<n; i++) Vold[i]   = V[i];
+  for (i=0; i<nr; i++) Volder[i] = Vold[i];
+  for (i=0; i<nr; i++) Vold[i]   = V[i];
   
+  pt -= taucs_wtime();
   if (precond_fn)
-    (*precond_fn)(precond_args,V,Vold);
+    (*precond_fn)(precond_args,vV,vVold);
   else
-    for (i=0; i<n; i++) V[i] = Vold[i];
+    for (i=0; i<nr; i++) V[i] = Vold[i];
+  pt += taucs_wtime();
   
   betaold = beta1;
-  beta = dotprod(n,Vold,V);
+  beta = dotprod(nr,Vold,V);
   if (beta < 0.0) {
     taucs_printf("minres: error (2)\n");
     return -1;
@@ -779,45 +1076,56 @@ taucs_minres(taucs_ccs_matrix*  A,
   gamma = sqrt(gammabar*gammabar + beta*beta);
 
 
-  for (i=0; i<n; i++) Mold[i] = 0.0;
-  for (i=0; i<n; i++) M[i]    = VV[i] / gamma;
+  t1 = (taucs_real_datatype) gamma;
+  for (i=0; i<nr; i++) Mold[i] = 0.0;
+  for (i=0; i<nr; i++) M[i]    = VV[i] / t1;
 
   cs = gammabar / gamma;
   sn = beta / gamma;
 
 
-  for (i=0; i<n; i++) X[i] += snprod*cs*M[i];
+  t1 = (taucs_real_datatype) (snprod*cs);
+  for (i=0; i<nr; i++) X[i] += t1*M[i];
   snprod = snprod * sn;
 
   /* generate CG iterates */
-  for (i=0; i<n; i++) Xcg[i] = X[i] + snprod*(sn/cs)*M[i];
+  t1 = (taucs_real_datatype) (snprod*(sn/cs));
+  for (i=0; i<nr; i++) Xcg[i] = X[i] + t1*M[i];
 
   /* compute residual again */
   
-  taucs_ccs_times_vec(A,X,R); 
-  for (i=0; i<n; i++) R[i] = B[i] - R[i];  /* r = b - A*x */
-  normr = twonorm(n,R);
+  taucs_dtl(ccs_times_vec)(A,vX,vR); 
+  for (i=0; i<nr; i++) R[i] = B[i] - R[i];  /* r = b - A*x */
+  normr = twonorm(nr,R);
 
   taucs_printf("minres: starting iterations, residual norm is %.1e\n",normr);
+  iter_info_step(info,0,normr/normb);
   
-  for ( Iter=1; Iter <= itermax; Iter++ ) {
+  /* no I/O inside this loop; progress goes to info */
 
-    for (i=0; i<n; i++) VV[i] = V[i] / beta;
-    taucs_ccs_times_vec(A,VV,V); 
-    for (i=0; i<n; i++) V[i] -= (beta/betaold) * Volder[i];
-    alpha = dotprod(n,VV,V);
-    for (i=0; i<n; i++) V[i] -= (alpha/beta) * Vold[i];
+  for ( Iter=1; Iter <= itermax; Iter++ ) {
 
-    for (i=0; i<n; i++) Volder[i] = Vold[i];
-    for (i=0; i<n; i++) Vold  [i] = V   [i];
+    t1 = (taucs_real_datatype) beta;
+    for (i=0; i<nr; i++) VV[i] = V[i] / t1;
+    taucs_dtl(ccs_times_vec)(A,vVV,vV); 
+    t1 = (taucs_real_datatype) (beta/betaold);
+    for (i=0; i<nr; i++) V[i] -= t1 * Volder[i];
+    alpha = dotprod(nr,VV,V);
+    t1 = (taucs_real_datatype) (alpha/beta);
+    for (i=0; i<nr; i++) V[i] -= t1 * Vold[i];
+
+    for (i=0; i<nr; i++) Volder[i] = Vold[i];
+    for (i=0; i<nr; i++) Vold  [i] = V   [i];
     
+    pt -= taucs_wtime();
     if (precond_fn)
-      (*precond_fn)(precond_args,V,Vold);
+      (*precond_fn)(precond_args,vV,vVold);
     else
-      for (i=0; i<n; i++) V[i] = Vold[i];
+      for (i=0; i<nr; i++) V[i] = Vold[i];
+    pt += taucs_wtime();
 
     betaold = beta;
-    beta = dotprod(n,Vold,V);
+    beta = dotprod(nr,Vold,V);
     if (beta < 0.0) {
       taucs_printf("minres: error (3)\n");
       return -1;
@@ -825,57 +1133,89 @@ taucs_minres(taucs_ccs_matrix*  A,
     beta = sqrt(beta);
 
     delta = cs*deltabar + sn*alpha;
-    for (i=0; i<n; i++) Molder[i] = Mold[i];
-    for (i=0; i<n; i++) Mold  [i] = M   [i];
-    for (i=0; i<n; i++) M[i] = VV[i] - delta*Mold[i] - epsilon*Molder[i];
+    for (i=0; i<nr; i++) Molder[i] = Mold[i];
+    for (i=0; i<nr; i++) Mold  [i] = M   [i];
+    t1 = (taucs_real_datatype) delta;
+    t2 = (taucs_real_datatype) epsilon;
+    for (i=0; i<nr; i++) M[i] = VV[i] - t1*Mold[i] - t2*Molder[i];
     gammabar = sn*deltabar - cs*alpha;
     epsilon = sn*beta;
     deltabar = -cs*beta;
     gamma = sqrt(gammabar*gammabar + beta*beta);
-    for (i=0; i<n; i++) M[i] = M[i]/ gamma;
+    t1 = (taucs_real_datatype) gamma;
+    for (i=0; i<nr; i++) M[i] = M[i]/ t1;
     cs = gammabar / gamma;
     sn = beta / gamma;
 
     /* stagnation test; skipped */
     
-    for (i=0; i<n; i++) X[i] += snprod*cs*M[i];
+    t1 = (taucs_real_datatype) (snprod*cs);
+    for (i=0; i<nr; i++) X[i] += t1*M[i];
     snprod = snprod*sn;
-    for (i=0; i<n; i++) Xcg[i] = X[i] + snprod*(sn/cs)*M[i];
+    t1 = (taucs_real_datatype) (snprod*(sn/cs));
+    for (i=0; i<nr; i++) Xcg[i] = X[i] + t1*M[i];
     
+    /* without a preconditioner the residual norm is the   */
+    /* recurrence |snprod|; it is replaced by the true one */
+    /* every few iterations and before accepting it.       */
+
     if (precond_fn) {
-      taucs_ccs_times_vec(A,X,R); 
-      for (i=0; i<n; i++) R[i] = B[i] - R[i];  /* r = b - A*x */
-      normr = twonorm(n,R);
+      taucs_dtl(ccs_times_vec)(A,vX,vR); 
+      for (i=0; i<nr; i++) R[i] = B[i] - R[i];  /* r = b - A*x */
+      normr = twonorm(nr,R);
     } else {
       normr = fabs(snprod); 
-      if (normr <= tolb) {
+      if (normr <= tolb || (replace > 0 && Iter % replace == 0)) {
 	/* double check */
-	taucs_ccs_times_vec(A,X,R); 
-	for (i=0; i<n; i++) R[i] = B[i] - R[i];  /* r = b - A*x */
-	normr = twonorm(n,R);
+	taucs_dtl(ccs_times_vec)(A,vX,vR); 
+	for (i=0; i<nr; i++) R[i] = B[i] - R[i];  /* r = b - A*x */
+	normr = twonorm(nr,R);
+	nreplaced++;
       }
     }
 
-    if (Iter > -1)
-      taucs_printf("minres: n=%d iterations = %d residual norm %12.4e\n", A->n,Iter,normr);
+    if (iter_info_step(info,Iter,normr/normb)) break;
 
     if (normr <= tolb) break;
   }
+  if (Iter > itermax) Iter = itermax;
 
-  taucs_printf("minres: done. n=%d iterations = %d residual norm %12.4e\n", A->n,Iter,normr);
+  ct += taucs_wtime();
+  info->precond_time = pt;
+  info->replacements = nreplaced;
+  iter_info_finish(info,Iter,normr/normb,ct);
+
+  taucs_printf("minres: done. n=%d iterations = %d residual norm %12.4e%s\n", 
+	       A->n,Iter,normr,info->stopped ? " (stopped by callback)" : "");
+  taucs_printf("minres: iteration time = %.2es (%.2es per iteration, %.2es in preconditioner)\n",
+	       ct,info->time_per_iteration,pt);
  
-  taucs_free(Molder) ;
-  taucs_free(Mold) ;
-  taucs_free(M) ;
-  taucs_free(Volder) ;
-  taucs_free(Vold) ;
-  taucs_free(V) ;
-  taucs_free(VV) ;
-  taucs_free(Xcg) ;
-  taucs_free(R) ;
+  taucs_free(vMolder) ;
+  taucs_free(vMold) ;
+  taucs_free(vM) ;
+  taucs_free(vVolder) ;
+  taucs_free(vVold) ;
+  taucs_free(vV) ;
+  taucs_free(vVV) ;
+  taucs_free(vXcg) ;
+  taucs_free(vR) ;
  
   return 0; 
 }                                                                             
 
-#endif /* TAUCS_CORE_DOUBLE */
+int 
+taucs_dtl(minres)(taucs_ccs_matrix*  A,
+		  int                (*precond_fn)(void*,void* x,void* b),
+		  void*              precond_args,
+		  taucs_datatype*    X,
+		  taucs_datatype*    B,
+		  int                itermax,
+		  double             convergetol)
+{
+  taucs_iter_info info;
+
+  iter_info_init(&info,itermax,convergetol);
+  return taucs_dtl(minres_info)(A,precond_fn,precond_args,X,B,&info);
+}
 
+#endif /* not TAUCS_CORE_GENERAL */
@@ -171,6 +171,7 @@ int taucs_getopt_string(char* cmd, void* args[], char* name, char** x) {
 #define TAUCS_FACTORTYPE_IND_OOC        7
 #define TAUCS_FACTORTYPE_LU             8
 #define TAUCS_FACTORTYPE_QR             9
+#define TAUCS_FACTORTYPE_AMG           10
 
 typedef struct {
   int   n;
@@ -193,6 +194,8 @@ static void taucs_linsolve_free(void* vF)
     taucs_supernodal_factor_ldlt_free(F->L);
   if (F->type == TAUCS_FACTORTYPE_LLT_CCS)
     taucs_ccs_free(F->L);
+  if (F->type == TAUCS_FACTORTYPE_AMG)
+    taucs_amg_preconditioner_free(F->L);
 #ifdef TAUCS_CONFIG_MULTILU
   if (F->type == TAUCS_FACTORTYPE_LU)
     taucs_multilu_factor_free(F->L);
@@ -246,24 +249,48 @@ int taucs_linsolve(taucs_ccs_matrix* A,
 
   double opt_maxdepth  = 0.0; /* default meaning no limit */
 
+  double opt_ldlt_alpha   = -1.0; /* negative means the default threshold */
+  double opt_ldlt_beta    = -1.0;
+  double opt_ldlt_perturb =  0.0; /* static pivoting, relative to max |A(i,j)| */
+
   int    opt_ooc       =  0;
   char*            opt_ooc_name   = NULL;
   void*            opt_ooc_handle = NULL;
   int              local_handle_open   = FALSE;
   int              local_handle_create = FALSE;
   double           opt_ooc_memory = -1.0;
+  int              opt_ooc_compress = FALSE;
+  int              opt_ooc_direct   = FALSE;
 
   char*            opt_ordering   = NULL;
 
   int    opt_cg          = 0;
   int    opt_minres      = 0;
+  int    opt_gmres       = 0;
+  int    opt_bicgstab    = 0;
+  double opt_restart     = 30.0;
+  int    opt_levels      = 0;
+  void*  schedule        = NULL;
   double opt_maxits      = 300.0;
   double opt_convergetol = 1e-6;
+  double opt_replace     = 0.0;
+  void*  opt_iter_info   = NULL; /* taucs_iter_info* supplied by the caller */
 
   int    opt_sg          = 0;
   int    opt_amwb        = 0;
   double opt_amwb_sg     = 1;
   double opt_amwb_rnd    = 170566;
+  int    opt_ic          = 0;
+  double opt_ic_levels   = -1.0; /* negative means not given */
+  double opt_ic_droptol  = 0.0;
+  int    opt_ic_modified = 0;
+  int    opt_amg         = 0;
+  double opt_amg_levels  = -1.0; /* negative means the default */
+  double opt_amg_coarse  = -1.0;
+  double opt_amg_theta   = -1.0;
+  double opt_amg_sweeps  = -1.0;
+  double opt_lu_droptol  = 0.0;
+  void*  opt_lu_matrix   = NULL; /* user-supplied matrix to factor instead of A */
   taucs_ccs_matrix* M    = NULL;
   taucs_ccs_matrix* PMPT = NULL;
 
@@ -290,6 +317,17 @@ int taucs_linsolve(taucs_ccs_matrix* A,
       understood |= taucs_getopt_boolean(options[i],opt_arg,"taucs.approximate.amwb",&opt_amwb); 
       understood |= taucs_getopt_double(options[i],opt_arg,"taucs.approximate.amwb.randomseed",&opt_amwb_rnd); 
       understood |= taucs_getopt_double(options[i],opt_arg,"taucs.approximate.amwb.subgraphs",&opt_amwb_sg); 
+      understood |= taucs_getopt_boolean(options[i],opt_arg,"taucs.approximate.ic",&opt_ic); 
+      understood |= taucs_getopt_double(options[i],opt_arg,"taucs.approximate.ic.levels",&opt_ic_levels); 
+      understood |= taucs_getopt_double(options[i],opt_arg,"taucs.approximate.ic.droptol",&opt_ic_droptol); 
+      understood |= taucs_getopt_boolean(options[i],opt_arg,"taucs.approximate.ic.modified",&opt_ic_modified); 
+      understood |= taucs_getopt_boolean(options[i],opt_arg,"taucs.approximate.amg",&opt_amg); 
+      understood |= taucs_getopt_double(options[i],opt_arg,"taucs.approximate.amg.levels",&opt_amg_levels); 
+      understood |= taucs_getopt_double(options[i],opt_arg,"taucs.approximate.amg.coarse",&opt_amg_coarse); 
+      understood |= taucs_getopt_double(options[i],opt_arg,"taucs.approximate.amg.theta",&opt_amg_theta); 
+      understood |= taucs_getopt_double(options[i],opt_arg,"taucs.approximate.amg.sweeps",&opt_amg_sweeps); 
+      understood |= taucs_getopt_double(options[i],opt_arg,"taucs.approximate.lu.droptol",&opt_lu_droptol); 
+      understood |= taucs_getopt_pointer(options[i],opt_arg,"taucs.approximate.lu.matrix",&opt_lu_matrix); 
       understood |= taucs_getopt_boolean(options[i],opt_arg,"taucs.factor",&opt_factor); 
       understood |= taucs_getopt_boolean(options[i],opt_arg,"taucs.factor.symbolic",&opt_symbolic); 
       understood |= taucs_getopt_boolean(options[i],opt_arg,"taucs.factor.numeric",&opt_numeric); 
@@ -301,16 +339,27 @@ int taucs_linsolve(taucs_ccs_matrix* A,
       understood |= taucs_getopt_boolean(options[i],opt_arg,"taucs.factor.ll",&opt_ll); 
       understood |= taucs_getopt_string(options[i],opt_arg,"taucs.factor.ordering",&opt_ordering); 
       understood |= taucs_getopt_double(options[i],opt_arg,"taucs.maxdepth",&opt_maxdepth); 
+      understood |= taucs_getopt_double(options[i],opt_arg,"taucs.factor.ldlt.alpha",&opt_ldlt_alpha); 
+      understood |= taucs_getopt_double(options[i],opt_arg,"taucs.factor.ldlt.beta",&opt_ldlt_beta); 
+      understood |= taucs_getopt_double(options[i],opt_arg,"taucs.factor.ldlt.perturb",&opt_ldlt_perturb); 
 
       understood |= taucs_getopt_boolean(options[i],opt_arg,"taucs.ooc",&opt_ooc); 
       understood |= taucs_getopt_string (options[i],opt_arg,"taucs.ooc.basename",&opt_ooc_name); 
       understood |= taucs_getopt_pointer(options[i],opt_arg,"taucs.ooc.iohandle",&opt_ooc_handle); 
       understood |= taucs_getopt_double (options[i],opt_arg,"taucs.ooc.memory",  &opt_ooc_memory); 
+      understood |= taucs_getopt_boolean(options[i],opt_arg,"taucs.ooc.compress",&opt_ooc_compress); 
+      understood |= taucs_getopt_boolean(options[i],opt_arg,"taucs.ooc.direct",  &opt_ooc_direct); 
 
       understood |= taucs_getopt_boolean(options[i],opt_arg,"taucs.solve.cg",&opt_cg); 
       understood |= taucs_getopt_boolean(options[i],opt_arg,"taucs.solve.minres",&opt_minres); 
+      understood |= taucs_getopt_boolean(options[i],opt_arg,"taucs.solve.gmres",&opt_gmres); 
+      understood |= taucs_getopt_boolean(options[i],opt_arg,"taucs.solve.bicgstab",&opt_bicgstab); 
+      understood |= taucs_getopt_double(options[i],opt_arg,"taucs.solve.restart",&opt_restart); 
+      understood |= taucs_getopt_boolean(options[i],opt_arg,"taucs.solve.levels",&opt_levels); 
       understood |= taucs_getopt_double(options[i],opt_arg,"taucs.solve.maxits",&opt_maxits); 
       understood |= taucs_getopt_double(options[i],opt_arg,"taucs.solve.convergetol",&opt_convergetol); 
+      understood |= taucs_getopt_double(options[i],opt_arg,"taucs.solve.replace",&opt_replace); 
+      understood |= taucs_getopt_pointer(options[i],opt_arg,"taucs.solve.info",&opt_iter_info); 
 
       understood |= taucs_getopt_double(options[i],opt_arg,"taucs.multiqr.max_kappa_R",&opt_max_kappa_R); 
 
@@ -337,11 +386,26 @@ int taucs_linsolve(taucs_ccs_matrix* A,
   /* First, construct a preconditioner if one is needed */
 
   if (opt_amwb) {
-    M = taucs_amwb_preconditioner_create(A,(int) opt_amwb_rnd,opt_amwb_sg,0 /* stretch flag */, 0 /* amwb force */);
+    if (opt_pfunc_nproc > 1)
+      M = taucs_amwb_preconditioner_create_parallel(A,(int) opt_amwb_rnd,opt_amwb_sg,0 /* stretch flag */, 0 /* amwb force */,
+						    (int) opt_pfunc_nproc);
+    else
+      M = taucs_amwb_preconditioner_create(A,(int) opt_amwb_rnd,opt_amwb_sg,0 /* stretch flag */, 0 /* amwb force */);
     if (!M)
       taucs_printf("taucs_linsolve: AMWB preconditioner construction failed, using A\n");
   }
 
+  /* an LU preconditioner for GMRES/BiCGStab may be computed on a sparsified A */
+
+  if (opt_lu && opt_lu_droptol > 0.0 && !opt_lu_matrix) {
+    if (opt_gmres || opt_bicgstab) {
+      M = taucs_ccs_threshold_drop(A,opt_lu_droptol);
+      if (!M)
+	taucs_printf("taucs_linsolve: dropping small entries failed, using A\n");
+    } else
+      taucs_printf("taucs_linsolve: ignoring the LU drop tolerance in a direct solve\n");
+  }
+
   /* First, decide on the kind of factorization */
 
   if (opt_factor) {
@@ -363,6 +427,10 @@ int taucs_linsolve(taucs_ccs_matrix* A,
 
     /* decide on ordering and order */  
 
+    /* AMG does not need a fill-reducing ordering */
+    if (!opt_ordering && opt_amg)
+      opt_ordering = "identity";
+
     if (!opt_ordering)
       opt_ordering = opt_lu || opt_qr ? 
 	"colamd" : 
@@ -423,11 +491,20 @@ int taucs_linsolve(taucs_ccs_matrix* A,
 	}
 
 	if (opt_ooc_name) {
-	  opt_ooc_handle = taucs_io_open_multifile(opt_ooc_name);
+	  taucs_io_handle* (*ooc_open)  (char*) = taucs_io_open_multifile;
+	  taucs_io_handle* (*ooc_create)(char*) = taucs_io_create_multifile;
+
+	  /* a comma-separated list of basenames stripes the factor over them */
+	  if (strchr(opt_ooc_name,',')) {
+	    ooc_open   = taucs_io_open_striped;
+	    ooc_create = taucs_io_create_striped;
+	  }
+
+	  opt_ooc_handle = (*ooc_open)(opt_ooc_name);
 	  if (opt_ooc_handle) {
 	    local_handle_open = TRUE;
 	  } else {
-	    opt_ooc_handle = taucs_io_create_multifile(opt_ooc_name);
+	    opt_ooc_handle = (*ooc_create)(opt_ooc_name);
 	    if (opt_ooc_handle) {
 	      local_handle_create = TRUE;
 	    } else {
@@ -440,6 +517,9 @@ int taucs_linsolve(taucs_ccs_matrix* A,
 	}
 	taucs_printf("taucs_linsolve: ooc file created?=%d opened?=%d\n",
 		     local_handle_create,local_handle_open);
+	if (opt_ooc_compress) taucs_io_set_compression(opt_ooc_handle,TRUE);
+	if (opt_ooc_direct)   taucs_io_set_direct(opt_ooc_handle,TRUE);
+	if (opt_pfunc_nproc > 1) taucs_io_set_parallel(opt_ooc_handle,TRUE);
 	if (opt_ooc_memory < 0.0) opt_ooc_memory = taucs_available_memory_size();
 	if (opt_ind) {
 #ifdef TAUCS_CONFIG_OOC_LDLT
@@ -457,8 +537,9 @@ int taucs_linsolve(taucs_ccs_matrix* A,
 	
 #endif
 	}
-	else if (taucs_ooc_factor_llt(PMPT ? PMPT : PAPT, 
-				      opt_ooc_handle, opt_ooc_memory) == TAUCS_SUCCESS)
+	else if (taucs_ooc_factor_llt_parallel(PMPT ? PMPT : PAPT, 
+					       opt_ooc_handle, opt_ooc_memory,
+					       opt_pfunc_nproc > 1 ? (int) opt_pfunc_nproc : 1) == TAUCS_SUCCESS)
 	  f->type = TAUCS_FACTORTYPE_LLT_OOC;
 	else {
 	  retcode = TAUCS_ERROR;
@@ -479,8 +560,35 @@ int taucs_linsolve(taucs_ccs_matrix* A,
 	  taucs_printf("taucs_linsolve: starting IC indefinite factorization\n");
 	  if (opt_mf) {
 	    taucs_printf("taucs_linsolve: starting IC indefinite MF factorization\n");
-	    if (!opt_numeric && opt_symbolic)
+
+#ifdef TAUCS_CILK
+	    if (!opt_context) {
+	      char* argv[16]  = {"program_name" };
+	      char  bufs[16][16];
+	      int   p = 0;
+	      int   argc;
+	      
+	      for (argc=1; argc<16; argc++) argv[argc] = 0;
+	      argc = 1;
+	      
+	      if (opt_cilk_nproc > 0) {
+		argv[argc++] = "--nproc";
+		sprintf(bufs[p],"%d",(int) opt_cilk_nproc);
+		argv[argc++] = bufs[p++];
+	      }
+	      
+	      taucs_printf("taucs_ccs_linsolve:_cilk_init\n");
+	      opt_context = Cilk_init(&argc,argv);
+	      local_context = TRUE;
+	    }
+#endif
+
+	    if (!opt_numeric && opt_symbolic) {
 	      f->L = taucs_ccs_factor_ldlt_symbolic_maxdepth(PMPT ? PMPT : PAPT,(int) opt_maxdepth);
+	      if (f->L)
+		taucs_supernodal_factor_ldlt_set_pivoting(f->L,opt_ldlt_alpha,opt_ldlt_beta,
+							  opt_ldlt_perturb);
+	    }
 
 	    if (opt_numeric && !opt_symbolic) {
 	      int rc;
@@ -493,11 +601,29 @@ int taucs_linsolve(taucs_ccs_matrix* A,
 	      }
 	      f->L = ((taucs_factorization*)*F)->L;
 	      taucs_supernodal_factor_free_numeric(f->L);
+	      /* otherwise keep the parameters given with the symbolic phase */
+	      if (opt_ldlt_alpha >= 0.0 || opt_ldlt_beta >= 0.0 || opt_ldlt_perturb > 0.0)
+		taucs_supernodal_factor_ldlt_set_pivoting(f->L,opt_ldlt_alpha,opt_ldlt_beta,
+							  opt_ldlt_perturb);
+#ifdef TAUCS_CILK	  
+	      rc = EXPORT(taucs_ccs_factor_ldlt_numeric)(opt_context, PMPT ? PMPT : PAPT, f->L);
+#else
 	      rc = taucs_ccs_factor_ldlt_numeric(PMPT ? PMPT : PAPT, f->L);
+#endif
 	    }
 	    
 	    if (opt_numeric && opt_symbolic) {
-	      f->L = taucs_ccs_factor_ldlt_mf_maxdepth(PMPT ? PMPT : PAPT,(int) opt_maxdepth);
+#ifdef TAUCS_CILK	  
+	      f->L = EXPORT(taucs_ccs_factor_ldlt_mf_pivoting)(opt_context,
+							       PMPT ? PMPT : PAPT,
+							       (int) opt_maxdepth,
+							       opt_ldlt_alpha,
+							       opt_ldlt_beta,
+							       opt_ldlt_perturb);
+#else
+	      f->L = taucs_ccs_factor_ldlt_mf_pivoting(PMPT ? PMPT : PAPT,(int) opt_maxdepth,
+						       opt_ldlt_alpha,opt_ldlt_beta,opt_ldlt_perturb);
+#endif
 	    }
 	    
 	    if (! (f->L) ) {
@@ -507,9 +633,18 @@ int taucs_linsolve(taucs_ccs_matrix* A,
 	    } else {
 	      f->type = TAUCS_FACTORTYPE_IND;
 	    }
+
+#ifdef TAUCS_CILK
+	    if (local_context) {
+	      Cilk_terminate((CilkContext*) opt_context);
+	      opt_context   = NULL;
+	      local_context = FALSE;
+	    }
+#endif
 	  } else if (opt_ll || TRUE) {/* this is the default*/
 	    taucs_printf("taucs_linsolve: starting IC indefinite LL factorization\n");
-	    f->L = taucs_ccs_factor_ldlt_ll_maxdepth(PMPT ? PMPT : PAPT,(int) opt_maxdepth);
+	    f->L = taucs_ccs_factor_ldlt_ll_pivoting(PMPT ? PMPT : PAPT,(int) opt_maxdepth,
+						     opt_ldlt_alpha,opt_ldlt_beta,opt_ldlt_perturb);
 	    if (! (f->L) ) {
 	      taucs_printf("taucs_factor: factorization failed\n");
 	      retcode = TAUCS_ERROR;
@@ -520,7 +655,38 @@ int taucs_linsolve(taucs_ccs_matrix* A,
 	  }
 	} else { /* llt */
 	  taucs_printf("taucs_linsolve: starting IC LLT factorization\n");
-	  if (opt_mf) {
+	  if (opt_ic) {
+	    int levels = (int) opt_ic_levels;
+
+	    /* without a drop tolerance, the default is IC(0) */
+	    if (opt_ic_levels < 0.0) levels = (opt_ic_droptol > 0.0) ? -1 : 0;
+
+	    taucs_printf("taucs_linsolve: starting incomplete LLT factorization\n");
+	    f->L = taucs_ccs_factor_sn_ic(PMPT ? PMPT : PAPT,
+					  levels,opt_ic_droptol,opt_ic_modified);
+	    if (! (f->L) ) {
+	      taucs_printf("taucs_factor: factorization failed\n");
+	      retcode = TAUCS_ERROR;
+	      goto release_and_return;
+	    } else {
+	      f->type = TAUCS_FACTORTYPE_LLT_CCS;
+	    }
+	  } else if (opt_amg) {
+	    taucs_printf("taucs_linsolve: starting AMG setup\n");
+	    f->L = taucs_amg_preconditioner_create(PMPT ? PMPT : PAPT,
+						   (int) opt_amg_levels,
+						   (int) opt_amg_coarse,
+						   opt_amg_theta,
+						   (int) opt_amg_sweeps,
+						   opt_pfunc_nproc > 1 ? (int) opt_pfunc_nproc : 1);
+	    if (! (f->L) ) {
+	      taucs_printf("taucs_factor: AMG setup failed\n");
+	      retcode = TAUCS_ERROR;
+	      goto release_and_return;
+	    } else {
+	      f->type = TAUCS_FACTORTYPE_AMG;
+	    }
+	  } else if (opt_mf) {
 	    taucs_printf("taucs_linsolve: starting IC LLT MF factorization\n");
 
 #ifdef TAUCS_CILK
@@ -657,9 +823,12 @@ int taucs_linsolve(taucs_ccs_matrix* A,
 #endif /* cilk */
 
 #ifdef TAUCS_CILK 
-	  f->L = EXPORT(taucs_ccs_factor_lu)(opt_context, A, f->rowperm, 1.0, opt_cilk_nproc);
+	  f->L = EXPORT(taucs_ccs_factor_lu)(opt_context, 
+					     opt_lu_matrix ? (taucs_ccs_matrix*) opt_lu_matrix : (M ? M : A),
+					     f->rowperm, 1.0, opt_cilk_nproc);
 #else
-	  f->L = taucs_ccs_factor_lu(A, f->rowperm, 1.0, opt_pfunc_nproc);
+	  f->L = taucs_ccs_factor_lu(opt_lu_matrix ? (taucs_ccs_matrix*) opt_lu_matrix : (M ? M : A),
+				     f->rowperm, 1.0, opt_pfunc_nproc);
 #endif /* cilk */
 
 	  taucs_printf("taucs_linsolve: factor time %.02e seconds (%.02e seconds CPU time)\n",taucs_wtime()-tw,taucs_ctime()-tc);	  
@@ -781,6 +950,19 @@ int taucs_linsolve(taucs_ccs_matrix* A,
     case TAUCS_FACTORTYPE_LLT_CCS:
       precond_fn  = taucs_ccs_solve_llt;
       precond_arg = f->L;
+      if (opt_levels) {
+	/* level-scheduled sweeps, on the PFUNC threads if there are any */
+	schedule = taucs_ccs_solve_llt_analyze(f->L,
+					       opt_pfunc_nproc > 1 ? (int) opt_pfunc_nproc : 1);
+	if (schedule) {
+	  precond_fn  = taucs_ccs_solve_llt_scheduled;
+	  precond_arg = schedule;
+	}
+      }
+      break;
+    case TAUCS_FACTORTYPE_AMG:
+      precond_fn  = taucs_amg_preconditioner_solve;
+      precond_arg = f->L;
       break;
     case TAUCS_FACTORTYPE_LDLT_CCS:
       precond_fn  = taucs_ccs_solve_ldlt;
@@ -798,7 +980,10 @@ int taucs_linsolve(taucs_ccs_matrix* A,
       break;
       #endif
     case TAUCS_FACTORTYPE_IND:
+#ifndef TAUCS_CILK
+      /* with Cilk this is a cilk procedure, called through EXPORT below */
       precond_fn_many  = taucs_supernodal_solve_ldlt_many;
+#endif
       precond_arg = f->L;
       break;
     default:
@@ -814,16 +999,57 @@ int taucs_linsolve(taucs_ccs_matrix* A,
     }
 
     if ( f->type == TAUCS_FACTORTYPE_IND_OOC ||
-	 f->type == TAUCS_FACTORTYPE_IND ) {
+	 f->type == TAUCS_FACTORTYPE_IND ||
+	 (f->type == TAUCS_FACTORTYPE_LLT_OOC && !opt_cg && !opt_minres) ) {
       /* solve PB as a whole, and not 1 by 1 */
       
       int ld = (A->n) * element_size(A->flags);
       for (j=0; j<nrhs; j++)
 	taucs_vec_permute (A->n,A->flags,(char*)B+j*ld,(char*)PB+j*ld,f->rowperm);
       
-      if (precond_fn_many) {
-	/*	(*precond_fn_many)(precond_arg,nrhs,PX,ld,PB,ld);*/
-	(*precond_fn_many)(precond_arg,nrhs,PX,A->n,PB,ld);
+#ifdef TAUCS_CILK
+      if (f->type == TAUCS_FACTORTYPE_IND) {
+	int solve_context = FALSE;
+
+	if (!opt_context) {
+	  char* argv[16]  = {"program_name" };
+	  char  bufs[16][16];
+	  int   p = 0;
+	  int   argc;
+	  
+	  for (argc=1; argc<16; argc++) argv[argc] = 0;
+	  argc = 1;
+	  
+	  if (opt_cilk_nproc > 0) {
+	    argv[argc++] = "--nproc";
+	    sprintf(bufs[p],"%d",(int) opt_cilk_nproc);
+	    argv[argc++] = bufs[p++];
+	  }
+	  
+	  taucs_printf("taucs_ccs_linsolve:_cilk_init\n");
+	  opt_context = Cilk_init(&argc,argv);
+	  solve_context = TRUE;
+	}
+
+	EXPORT(taucs_supernodal_solve_ldlt_many)(opt_context,
+						 precond_arg,nrhs,PX,A->n,PB,A->n);
+
+	if (solve_context) {
+	  Cilk_terminate((CilkContext*) opt_context);
+	  opt_context = NULL;
+	}
+      } else
+#endif
+      if (f->type == TAUCS_FACTORTYPE_LLT_OOC) {
+	/* the solve may keep the top of L in core between its sweeps */
+	retcode = taucs_ooc_solve_llt_many_cached(precond_arg,nrhs,PX,A->n,PB,A->n,
+						  opt_ooc_memory > 0.0 
+						  ? opt_ooc_memory 
+						  : taucs_available_memory_size());
+	if (retcode != TAUCS_SUCCESS) goto release_and_return;
+      } else if (precond_fn_many) {
+	/* the leading dimensions are in elements, not bytes */
+	(*precond_fn_many)(precond_arg,nrhs,PX,A->n,PB,A->n);
 	
       } else {
 	taucs_printf("taucs_linsolve: I don't know how to solve!\n");
@@ -837,6 +1063,23 @@ int taucs_linsolve(taucs_ccs_matrix* A,
       
       
     } else {
+      taucs_iter_info  local_info;
+      taucs_iter_info* iter_info = NULL;
+
+      /* the caller's info (or a local one when only the  */
+      /* replacement period is given) receives the history */
+      /* and statistics; the last right-hand side wins.    */
+      if (opt_iter_info || opt_replace > 0.0) {
+	if (opt_iter_info) 
+	  iter_info = (taucs_iter_info*) opt_iter_info;
+	else {
+	  memset(&local_info,0,sizeof(taucs_iter_info));
+	  iter_info = &local_info;
+	}
+	iter_info->itermax     = (int) opt_maxits;
+	iter_info->convergetol = opt_convergetol;
+	if (opt_replace > 0.0) iter_info->replace_every = (int) opt_replace;
+      }
       
       for (j=0; j<nrhs; j++) {
 	int ld = (A->n) * element_size(A->flags);
@@ -846,7 +1089,8 @@ int taucs_linsolve(taucs_ccs_matrix* A,
 	if (opt_cg) {
 
 #ifdef TAUCS_CONFIG_PFUNC
-	  if (opt_pfunc_nproc > 1)
+	  /* the scheduled solve runs its own threads, so use the sequential CG */
+	  if (opt_pfunc_nproc > 1 && !schedule)
 	  taucs_parallel_conjugate_gradients (PAPT,
 					      precond_fn, precond_arg,
 					      (char*)PX+j*ld, (char*)PB+j*ld,
@@ -854,6 +1098,12 @@ int taucs_linsolve(taucs_ccs_matrix* A,
 					      opt_convergetol, (int)opt_pfunc_nproc);
 	  else
 #endif
+	  if (iter_info)
+	    taucs_conjugate_gradients_info (PAPT,
+					    precond_fn, precond_arg,
+					    (char*)PX+j*ld, (char*)PB+j*ld,
+					    iter_info);
+	  else
 	    taucs_conjugate_gradients (PAPT,
 				       precond_fn, precond_arg,
 				       (char*)PX+j*ld, (char*)PB+j*ld,
@@ -861,6 +1111,12 @@ int taucs_linsolve(taucs_ccs_matrix* A,
 				       opt_convergetol);
 	  
 	} else if (opt_minres) {
+	  if (iter_info)
+	    taucs_minres_info         (PAPT,
+				       precond_fn, precond_arg,
+				       (char*)PX+j*ld, (char*)PB+j*ld,
+				       iter_info);
+	  else
 	  taucs_minres              (PAPT,
 				     precond_fn, precond_arg,
 				     (char*)PX+j*ld, (char*)PB+j*ld,
@@ -913,13 +1169,46 @@ int taucs_linsolve(taucs_ccs_matrix* A,
     retcode = TAUCS_ERROR; 
     goto release_and_return;
 #else
-    taucs_printf("taucs_linsolve: doing an LU solve, n=%d, nrhs=%d\n",A->n,nrhs);
+    if (opt_gmres || opt_bicgstab) {
+#ifdef TAUCS_CILK
+      taucs_printf("taucs_linsolve: LU-preconditioned GMRES/BiCGStab is not supported in Cilk builds\n");
+      retcode = TAUCS_ERROR_BADARGS;
+      goto release_and_return;
+#else
+      int ld = (A->n) * element_size(A->flags);
+      int j,rc;
+
+      taucs_printf("taucs_linsolve: doing an LU-preconditioned %s solve, n=%d, nrhs=%d\n",
+		   opt_gmres ? "GMRES" : "BiCGStab",A->n,nrhs);
+
+      for (j=0; j<nrhs; j++) {
+	memset((char*)X+j*ld,0,ld);
+	if (opt_gmres)
+	  rc = taucs_gmres(A,
+				(int (*)(void*,void*,void*)) taucs_multilu_solve,f->L,
+				(char*)X+j*ld,(char*)B+j*ld,
+				(int) opt_restart,(int) opt_maxits,opt_convergetol);
+	else
+	  rc = taucs_bicgstab(A,
+				   (int (*)(void*,void*,void*)) taucs_multilu_solve,f->L,
+				   (char*)X+j*ld,(char*)B+j*ld,
+				   (int) opt_maxits,opt_convergetol);
+	if (rc != TAUCS_SUCCESS) {
+	  taucs_printf("taucs_linsolve: Krylov solver did not converge for right-hand side %d\n",j);
+	  /* report the first failure, not the last right-hand side */
+	  if (retcode == TAUCS_SUCCESS) retcode = rc;
+	}
+      }
+#endif
+    } else {
+      taucs_printf("taucs_linsolve: doing an LU solve, n=%d, nrhs=%d\n",A->n,nrhs);
 
 #ifdef TAUCS_CILK
-    retcode = EXPORT(taucs_multilu_solve_many)(opt_context, f->L, nrhs, X, A->n, B, A->n);
+      retcode = EXPORT(taucs_multilu_solve_many)(opt_context, f->L, nrhs, X, A->n, B, A->n);
 #else
-    retcode = taucs_multilu_solve_many(f->L, nrhs, X, A->n, B, A->n);
+      retcode = taucs_multilu_solve_many(f->L, nrhs, X, A->n, B, A->n);
 #endif
+    }
 
     if (retcode != TAUCS_SUCCESS) 
       goto release_and_return;
@@ -987,6 +1276,7 @@ int taucs_linsolve(taucs_ccs_matrix* A,
     taucs_linsolve_free(f);
   }
 
+  taucs_ccs_solve_llt_schedule_free(schedule);
   taucs_ccs_free(PMPT);
   taucs_ccs_free(PAPT);
   taucs_ccs_free(M);
@@ -1008,6 +1298,7 @@ release_and_return:
 
   taucs_free(rowperm);
   taucs_free(colperm);
+  taucs_ccs_solve_llt_schedule_free(schedule);
   taucs_ccs_free(PMPT);
   taucs_ccs_free(PAPT);
   taucs_ccs_free(M);
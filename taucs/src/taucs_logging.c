@@ -25,55 +25,126 @@
 #define LOG_STDOUT 2
 #define LOG_FILE   3
 
-static char log_file_prefix[256];
-static int  log_file_type = LOG_NONE;
-static int  first_time = 0;
+/*
+  A message is written only if its level is at most the current
+  level and its subsystem is in the current mask; the test comes
+  before any formatting. With logging off (the default, or after
+  taucs_logfile("none")) the effective level is -1, so every message
+  is dropped by a single comparison.
+
+  The log file is opened by taucs_logfile, not by the first message,
+  so concurrent callers never race on opening it. Each message is one
+  vfprintf, which stdio serializes per stream. Log files are fully
+  buffered and flushed by taucs_log_flush, by the next taucs_logfile,
+  at exit, and after every TAUCS_LOG_ERROR message; stdout and stderr
+  are still flushed after every message.
+*/
+
+#define LOG_FILE_BUFFER 65536
+
+static FILE* log_stream    = NULL;
+static int   log_file_type = LOG_NONE;
+static int   log_level     = TAUCS_LOG_INFO;
+static int   log_mask      = TAUCS_LOG_ALL;
+static int   log_cutoff    = -1; /* log_level, or -1 when there is no log */
+static int   log_atexit    = 0;
+
+void
+taucs_log_flush(void)
+{
+  if (log_file_type != LOG_NONE && log_stream) fflush(log_stream);
+}
+
+static void
+log_close(void)
+{
+  if (log_file_type == LOG_FILE && log_stream) fclose(log_stream);
+  log_stream = NULL;
+  log_file_type = LOG_NONE;
+  log_cutoff    = -1;
+}
 
 void
 taucs_logfile(char* file_prefix)
 {
+  taucs_log_flush();
+  log_close();
+
   if (!strcmp(file_prefix,"stderr")) {
+    log_stream = stderr;
     log_file_type = LOG_STDERR;
   } else if (!strcmp(file_prefix,"stdout")) {
+    log_stream = stdout;
     log_file_type = LOG_STDOUT;
   } else if (!strcmp(file_prefix,"none")) {
-    log_file_type = LOG_NONE;
+    return;
   } else {
-    strcpy(log_file_prefix,file_prefix);
+    if ((log_stream = fopen(file_prefix,"w")) == NULL) {
+      fprintf(stderr,"could not open log file %s, exiting\n",file_prefix);
+      exit(1);
+    }
+    setvbuf(log_stream,NULL,_IOFBF,LOG_FILE_BUFFER);
     log_file_type = LOG_FILE;
-    first_time = 1;
+    if (!log_atexit) {
+      atexit(taucs_log_flush);
+      log_atexit = 1;
+    }
   }
+
+  log_cutoff = log_level;
 }
 
-int
-taucs_printf(char *fmt, ...)
+void
+taucs_log_set_level(int level)
+{
+  log_level = level;
+  if (log_file_type != LOG_NONE) log_cutoff = level;
+}
+
+void
+taucs_log_set_mask(int mask)
 {
-  static FILE* logf;
-  va_list      ap;
+  log_mask = mask;
+}
 
-  if (log_file_type == LOG_NONE) return 0;
+int
+taucs_log_enabled(int subsystem, int level)
+{
+  return (level <= log_cutoff && (subsystem & log_mask));
+}
 
-  if (first_time && log_file_type == LOG_FILE) {
-    char filename[256];
+static void
+log_write(int level, char* fmt, va_list ap)
+{
+  vfprintf(log_stream, fmt, ap);
 
-    sprintf(filename,"%s",log_file_prefix);
+  if (log_file_type != LOG_FILE || level == TAUCS_LOG_ERROR)
+    fflush(log_stream);
+}
 
-    if ((logf = fopen(filename,"w")) == NULL) {
-      fprintf(stderr,"could not open log file %s, exiting\n",filename);
-      exit(1);
-    }
-    first_time = 0;
-  }
+int
+taucs_log(int subsystem, int level, char* fmt, ...)
+{
+  va_list ap;
 
-  if (log_file_type == LOG_STDERR) logf = stderr;
-  if (log_file_type == LOG_STDOUT) logf = stdout;
+  if (level > log_cutoff || !(subsystem & log_mask)) return 0;
 
   va_start(ap, fmt);
+  log_write(level, fmt, ap);
+  va_end(ap);
 
-  vfprintf(logf, fmt, ap);
+  return 0;
+}
 
-  fflush(logf);
+int
+taucs_printf(char *fmt, ...)
+{
+  va_list ap;
 
+  if (TAUCS_LOG_INFO > log_cutoff || !(TAUCS_LOG_GENERAL & log_mask)) return 0;
+
+  va_start(ap, fmt);
+  log_write(TAUCS_LOG_INFO, fmt, ap);
   va_end(ap);
 
   return 0;
@@ -439,6 +439,10 @@ struct taucs_multiqr_factor_st
   int *perb_indexs;
   taucs_double perb_value;
 
+  /* Peak number of bytes held by factor blocks (R, Y and active fronts) 
+     during the numeric factorization. */
+  double peak_memory;
+
 };
 
 #endif /* both with core general and not we define the structure. not that they will
@@ -1401,6 +1405,14 @@ typedef struct multiqr_context_st
      of [A; B] when perturbation in B are of perb_value */
   taucs_double max_norm_A_perb;
 
+  /* 
+   * Memory accounting. block_memory holds the number of bytes last charged 
+   * for each factor block, current_memory their sum and peak_memory its maximum.
+   */
+  double *block_memory;
+  double current_memory;
+  double peak_memory;
+
   /* PLACEHOLDER FOR FUTURE USE IN PARALLEL */
 #ifdef TAUCS_CILK
   /* Next is in the first item of every workspace */
@@ -1424,6 +1436,7 @@ static void multiqr_context_free(multiqr_context* context)
   taucs_free(context->column_cleared);
   taucs_free(context->map_rows);
   taucs_free(context->map_cols);
+  taucs_free(context->block_memory);
 
 #ifndef TAUCS_CILK
   taucs_free(context->QR_workspace);
@@ -1453,6 +1466,9 @@ static multiqr_context* multiqr_context_create(taucs_ccs_matrix *A, taucs_multiq
   memset(context->map_rows, -1, (A->m + A->n) * sizeof(int));
   context->map_cols = (int*)taucs_malloc(A->n * sizeof(int));
   memset(context->map_cols, -1, A->n * sizeof(int));
+  context->block_memory = (double*)taucs_calloc(symbolic->number_supercolumns + 1, sizeof(double));
+  context->current_memory = 0.0;
+  context->peak_memory = 0.0;
 
   /* Find workspace size */
   /* TODO: need to make sure workspace is big enough */
@@ -1482,7 +1498,8 @@ static multiqr_context* multiqr_context_create(taucs_ccs_matrix *A, taucs_multiq
 
   /* Check allocation */
   if (context->At == NULL || context->row_cleared == NULL || context->map_rows == NULL ||
-      context->map_cols == NULL || (have_B && context->QTB_workspace == NULL))
+      context->map_cols == NULL || context->block_memory == NULL || 
+      (have_B && context->QTB_workspace == NULL))
   {
     multiqr_context_free(context);
     context = NULL;
@@ -1499,6 +1516,7 @@ static void factorize_supercolumn(multiqr_context *mcontext, int pivot_supercol,
 static void check_for_perb(multiqr_context *mcontext, int pivot_supercol, taucs_double max_kappa_R, 
 			   taucs_datatype **B, int nrhs);
 static void focus_front(multiqr_context *mcontext, int supercol, int hold_explicit_for_refine);
+static void account_factor_block(multiqr_context *mcontext, int supercol);
 static void allocate_factor(multiqr_context* context, int m, int n, int supercolumns_number, int type, int have_q);
 static void allocate_factor_block(multiqr_context* mcontext, int pivot_supercol);
 static void enlarge_factor_block(multiqr_context* mcontext, int pivot_supercol, int new_row_index);
@@ -1853,6 +1871,11 @@ taucs_multiqr_factor* taucs_dtl(ccs_factor_pseudo_qr_numeric)(taucs_ccs_matrix *
     }
   }
 
+  /* Report memory usage. With keep_q == FALSE this is R plus the active fronts */
+  context->F->peak_memory = context->peak_memory;
+  taucs_printf("multiqr: peak factor memory %.2e bytes (%s)\n", 
+	       context->peak_memory, keep_q ? "Q kept" : "Q discarded");
+
   /* Keep factor and free rest of context */  
   taucs_multiqr_factor *F = context->F;
   multiqr_context_free(context);
@@ -1887,6 +1910,13 @@ static void factorize_supercolumn(multiqr_context *mcontext, int pivot_supercol,
   focus_front(mcontext, pivot_supercol, max_kappa_R != MULTIQR_INF_PARAMETER && max_kappa_R != 0);
   release_map_cols(mcontext, map_cols);
 
+  /* The front is now active, and the children's reduced blocks were consumed */
+  account_factor_block(mcontext, pivot_supercol);
+  for(i = mcontext->symbolic->etree.first_child[pivot_supercol]; 
+      i != MULTIQR_SYMBOLIC_NONE; 
+      i = mcontext->symbolic->etree.next_child[i])
+    account_factor_block(mcontext, i);
+
   multiqr_factor_block *factor_block = mcontext->F->blocks[pivot_supercol];
 
   // Explanation on hadeling row_pivots < col_pivots:
@@ -1953,7 +1983,10 @@ static void factorize_supercolumn(multiqr_context *mcontext, int pivot_supercol,
   }
 
   if (factor_block->row_pivots_number == 0)
+  {
+    account_factor_block(mcontext, pivot_supercol);
     return;
+  }
 
   /* OPTIMIC elimination */
   if (factor_block->non_pivot_cols_number > 0 &&
@@ -2009,7 +2042,11 @@ static void factorize_supercolumn(multiqr_context *mcontext, int pivot_supercol,
     TAUCS_PROFILE_STOP(taucs_profile_multiqr_apply_Qt);
   }
 
-  /* Shrink YR1 if we don't want to keep Y.  */
+  /* 
+   * Shrink YR1 if we don't want to keep Y. The reflectors were already applied
+   * to B above, so nothing of this front's Y is needed any more: we release Y2 
+   * and tau now rather than at the end of the factorization.
+   */
   if (!keep_q)
   {
     TAUCS_PROFILE_START(taucs_profile_multiqr_discard_y);
@@ -2019,6 +2056,9 @@ static void factorize_supercolumn(multiqr_context *mcontext, int pivot_supercol,
     factor_block->have_q = FALSE;
     factor_block->ld_YR1 = factor_block->row_pivots_number;
     factor_block->pivot_rows = taucs_realloc(factor_block->pivot_rows, factor_block->row_pivots_number * sizeof(int));
+    factor_block->non_pivot_rows = NULL;
+    taucs_free(factor_block->tau);
+    factor_block->tau = NULL;
 
     if (factor_block->tau3 != NULL) 
     {
@@ -2038,6 +2078,8 @@ static void factorize_supercolumn(multiqr_context *mcontext, int pivot_supercol,
 
     TAUCS_PROFILE_STOP(taucs_profile_multiqr_discard_y);
   }     
+
+  account_factor_block(mcontext, pivot_supercol);
 }
 
 /*************************************************************************************
@@ -2826,6 +2868,40 @@ static void allocate_factor_block(multiqr_context* mcontext, int pivot_supercol)
 }
 
 
+/*************************************************************************************
+ * Function: account_factor_block
+ *
+ * Description: Recomputes the number of bytes held by the factor block of the 
+ *              supercolumn (including its reduced block, which lives inside R2) and
+ *              updates the current and peak memory counters of the context.
+ *
+ *************************************************************************************/
+static void account_factor_block(multiqr_context *mcontext, int supercol)
+{
+  multiqr_factor_block *factor_block = mcontext->F->blocks[supercol];
+  double bytes = 0.0;
+
+  if (factor_block != NULL)
+  {
+    bytes += sizeof(multiqr_factor_block);
+    bytes += (double)(factor_block->r_size + factor_block->ld_YR1) * sizeof(int);
+    if (factor_block->YR1 != NULL)
+      bytes += (double)factor_block->ld_YR1 * factor_block->col_pivots_number * sizeof(taucs_datatype);
+    if (factor_block->R2 != NULL)
+      bytes += (double)factor_block->ld_R2 * factor_block->non_pivot_cols_number * sizeof(taucs_datatype);
+    if (factor_block->tau != NULL)
+      bytes += (double)factor_block->col_pivots_number * sizeof(taucs_datatype);
+    if (factor_block->tau3 != NULL)
+      bytes += (double)factor_block->non_pivot_cols_number * sizeof(taucs_datatype);
+    if (factor_block->reduced_block != NULL)
+      bytes += (double)(factor_block->reduced_block->m + factor_block->reduced_block->n) * sizeof(int);
+  }
+
+  mcontext->current_memory += bytes - mcontext->block_memory[supercol];
+  mcontext->block_memory[supercol] = bytes;
+  mcontext->peak_memory = max(mcontext->peak_memory, mcontext->current_memory);
+}
+
 /*************************************************************************************
  * Function: enlarge_factor_block
  *
@@ -2964,6 +3040,7 @@ static void allocate_factor(multiqr_context* context, int m, int n, int supercol
   context->F->have_q = have_q;
   context->F->perbs = 0;
   context->F->perb_indexs = NULL;
+  context->F->peak_memory = 0.0;
 }
 
 /*************************************************************************************
@@ -4200,6 +4277,20 @@ void taucs_multiqr_get_perb_indices(taucs_multiqr_factor *F, int *indices)
   memcpy(indices, F->perb_indexs, F->perbs * sizeof(int));
 }
 
+/*************************************************************************************
+ * Function: taucs_multiqr_get_peak_memory
+ *
+ * Description: Returns the peak number of bytes held by the factor blocks during 
+ *              the numeric factorization that created F. When Q is not kept the 
+ *              Householder vectors of each front are applied to B and released
+ *              as soon as the front is factored, so this is R plus the active fronts.
+ *
+ *************************************************************************************/
+double taucs_multiqr_get_peak_memory(taucs_multiqr_factor *F)
+{ 
+  return F->peak_memory;
+}
+
 
 /*************************************************************************************
  * Function: multiqr_free_blocked_factor
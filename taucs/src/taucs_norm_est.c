@@ -245,7 +245,8 @@ taucs_double taucs_norm_1(taucs_ccs_matrix *A)
 #ifndef TAUCS_CORE_GENERAL
 taucs_double taucs_dtl(norm_1)(taucs_ccs_matrix *A)
 {
-  int j, i;
+  int i;
+  taucs_index j;
   taucs_double norm1 = -1;
   for(i = 0; i < A->n; i++)
   {
@@ -9,6 +9,16 @@
 /*                                                           */
 /*************************************************************/
 
+/* 64-bit off_t on 32-bit systems, and O_DIRECT on Linux; 
+   must precede system headers */
+#ifndef OSTYPE_win32
+#define _FILE_OFFSET_BITS 64
+#define _LARGEFILE_SOURCE
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -29,6 +39,10 @@
 #include <fcntl.h>
 #include <errno.h>
 
+#ifdef TAUCS_CONFIG_PFUNC
+#include "pfunc.h"
+#endif
+
 /*************************************************************/
 /* io routines                                               */
 /*************************************************************/
@@ -43,10 +57,55 @@
 
 #define IO_TYPE_SINGLEFILE    1
 #define IO_TYPE_MULTIFILE     0
+#define IO_TYPE_STRIPED       2
 
-/* maximum file size in GB */
+/* maximum size of each data file of a multifile, in megabytes */
 
+#ifndef IO_FILE_RESTRICTION
 #define IO_FILE_RESTRICTION   1024
+#endif
+#define IO_FILE_BYTES         ((double) IO_FILE_RESTRICTION * 1024.0 * 1024.0)
+
+/* 
+   a striped file deals its data out to the devices in units of
+   IO_STRIPE_UNIT bytes, round robin; must be a multiple of 
+   IO_DIRECT_ALIGN 
+*/
+
+#ifndef IO_STRIPE_UNIT
+#define IO_STRIPE_UNIT        (1024*1024)
+#endif
+#define IO_STRIPE_MAX_DEVICES 64
+
+/* largest single read() or write() */
+
+#define IO_CHUNK              (1024*1024*1024)
+
+/* 
+   a matrix stored compressed has this bit in its flags in the
+   index table, and its compressed size follows its offset 
+*/
+
+#define TAUCS_IO_COMPRESSED   65536
+
+/* smaller blocks are not worth compressing */
+
+#define IO_COMPRESS_MIN       256
+
+#define IO_IS_COMPRESSED(flags) ((flags) != -1 && ((flags) & TAUCS_IO_COMPRESSED))
+
+/* 
+   direct I/O transfers whole aligned blocks through a staging
+   buffer of IO_DIRECT_STAGING bytes; appended matrices of at 
+   least IO_DIRECT_ALIGN_MIN bytes start on a block boundary,
+   smaller ones are packed 
+*/
+
+#ifndef IO_DIRECT_ALIGN
+#define IO_DIRECT_ALIGN       4096
+#endif
+#define IO_DIRECT_STAGING     (4*1024*1024)
+#define IO_DIRECT_ALIGN_MIN   (64*1024)
 
 /* in taucs.h:
 typedef struct {
@@ -61,6 +120,7 @@ typedef struct {
   int   n;
   int   flags;
   off_t offset;
+  taucs_int64 csize; /* bytes on disk, if TAUCS_IO_COMPRESSED */
 } taucs_io_matrix_singlefile;
 
 typedef struct {
@@ -74,16 +134,51 @@ typedef struct {
   int    n;
   int    flags;
   double offset;
+  taucs_int64 csize; /* bytes on disk, if TAUCS_IO_COMPRESSED */
 } taucs_io_matrix_multifile;
 
 typedef struct {
-  int    f[1024];
+  int*   f;  /* data files 0..last_created_file */
+  int    nf; /* allocated size of f */
   double last_offset;
   int    last_created_file;
   char   basename[256];
   taucs_io_matrix_multifile* matrices;
 } taucs_io_handle_multifile;
 
+/*
+  A striped handle has one data file per device, basename.d in
+  the directory of the d'th basename. Byte x of the data lives
+  in unit u = x/IO_STRIPE_UNIT, on device u mod ndevices, so 
+  the part of a large matrix on each device is contiguous there.
+  File 0 starts with the header and the index table follows the
+  data, as in a multifile.
+*/
+
+typedef struct {
+  int    ndevices;
+  int*   f;                 /* data file of each device */
+  char** basenames;
+  double last_offset;
+  int    parallel;          /* see taucs_io_set_parallel */
+  taucs_io_matrix_multifile* matrices;
+} taucs_io_handle_striped;
+
+/* 
+   the direct I/O state of a handle, one per data file of a 
+   striped handle; tail keeps a copy of the last block written,
+   so consecutive packed appends do not read back the block they
+   share 
+*/
+
+typedef struct {
+  char* buffer;      /* as allocated */
+  char* stage;       /* IO_DIRECT_STAGING bytes, aligned */
+  char* tail;        /* IO_DIRECT_ALIGN bytes, aligned */
+  int   tail_fd;     /* -1 if tail holds nothing */
+  off_t tail_offset;
+} taucs_io_direct;
+
 
 #define TAUCS_FILE_SIGNATURE "taucs"
 
@@ -111,6 +206,587 @@ static int element_size(int flags)
   return -1;
 }
 
+/*************************************************************/
+/* block compression                                         */
+/*************************************************************/
+
+/*
+  Integer blocks (mostly sorted row indices) are stored as
+  zigzag varints of the differences between consecutive entries.
+  Floating-point blocks are byte-shuffled, so that the bytes of
+  equal significance in consecutive elements (signs, exponents,
+  and the zeros of the upper triangle of diagonal blocks) become
+  adjacent, and the shuffled bytes are run-length coded.
+  Both codecs are lossless and need one pass each way.
+  A block that does not shrink is stored as is.
+*/
+
+static int io_codec_element_size(int flags)
+{
+  if (flags & TAUCS_DCOMPLEX) return sizeof(taucs_double);
+  if (flags & TAUCS_SCOMPLEX) return sizeof(taucs_single);
+  return element_size(flags);
+}
+
+static int io_varint_pack(int* v, int count,
+			  unsigned char* out, int cap)
+{
+  int i,len = 0;
+  unsigned int prev = 0;
+  unsigned int u;
+  int d;
+
+  for (i=0; i<count; i++) {
+    d = (int) ((unsigned int) v[i] - prev);
+    prev = (unsigned int) v[i];
+    u = (((unsigned int) d) << 1) ^ (unsigned int) (d >> 31);
+    while (u >= 128) {
+      if (len >= cap) return -1;
+      out[len++] = (unsigned char) (u | 128);
+      u >>= 7;
+    }
+    if (len >= cap) return -1;
+    out[len++] = (unsigned char) u;
+  }
+  return len;
+}
+
+static int io_varint_unpack(unsigned char* in, int len,
+			    int* v, int count)
+{
+  int i,p = 0,shift;
+  unsigned int prev = 0;
+  unsigned int u;
+
+  for (i=0; i<count; i++) {
+    u = 0;
+    shift = 0;
+    do {
+      if (p >= len || shift > 28) return -1;
+      u |= ((unsigned int) (in[p] & 127)) << shift;
+      shift += 7;
+    } while (in[p++] & 128);
+    prev += (unsigned int) ((int) (u >> 1) ^ -((int) (u & 1)));
+    v[i] = (int) prev;
+  }
+  return (p == len) ? 0 : -1;
+}
+
+/* 
+   run-length code: a byte c < 128 is followed by c+1 literal
+   bytes, a byte c >= 128 by one byte repeated c-128+3 times 
+*/
+
+static int io_rle_pack(unsigned char* in, int n,
+		       unsigned char* out, int cap)
+{
+  int i = 0,j,run,lit,len = 0;
+
+  while (i < n) {
+    for (run=1; i+run<n && run<130 && in[i+run]==in[i]; run++);
+    if (run >= 3) {
+      if (len+2 > cap) return -1;
+      out[len++] = (unsigned char) (128 + run - 3);
+      out[len++] = in[i];
+      i += run;
+      continue;
+    }
+    for (lit=0; i+lit<n && lit<128; lit++) {
+      if (i+lit+2 < n 
+	  && in[i+lit] == in[i+lit+1] 
+	  && in[i+lit] == in[i+lit+2]) break;
+    }
+    if (len+1+lit > cap) return -1;
+    out[len++] = (unsigned char) (lit - 1);
+    for (j=0; j<lit; j++) out[len++] = in[i+j];
+    i += lit;
+  }
+  return len;
+}
+
+static int io_rle_unpack(unsigned char* in, int len,
+			 unsigned char* out, int n)
+{
+  int p = 0,o = 0,c,k;
+
+  while (p < len) {
+    c = in[p++];
+    if (c >= 128) {
+      k = c - 128 + 3;
+      if (p >= len || o+k > n) return -1;
+      memset(out+o,in[p++],k);
+    } else {
+      k = c + 1;
+      if (p+k > len || o+k > n) return -1;
+      memcpy(out+o,in+p,k);
+      p += k;
+    }
+    o += k;
+  }
+  return (o == n) ? 0 : -1;
+}
+
+/* returns the compressed size, or -1 if the block does not shrink */
+
+static int io_compress(int flags, void* data, int nbytes,
+		       unsigned char* out)
+{
+  unsigned char* shuffled;
+  unsigned char* in = (unsigned char*) data;
+  int esize,nelem,b,i,len;
+
+  if (flags & TAUCS_INT) 
+    return io_varint_pack((int*) data,nbytes/sizeof(int),out,nbytes-1);
+
+  esize = io_codec_element_size(flags);
+  nelem = nbytes / esize;
+  shuffled = (unsigned char*) taucs_malloc(nbytes);
+  if (!shuffled) return -1;
+  for (b=0; b<esize; b++)
+    for (i=0; i<nelem; i++)
+      shuffled[b*nelem+i] = in[i*esize+b];
+  len = io_rle_pack(shuffled,nbytes,out,nbytes-1);
+  taucs_free(shuffled);
+  return len;
+}
+
+static int io_decompress(int flags, unsigned char* in, int csize,
+			 void* data, int nbytes)
+{
+  unsigned char* shuffled;
+  unsigned char* out = (unsigned char*) data;
+  int esize,nelem,b,i;
+
+  if (flags & TAUCS_INT) 
+    return io_varint_unpack(in,csize,(int*) data,nbytes/sizeof(int));
+
+  esize = io_codec_element_size(flags);
+  nelem = nbytes / esize;
+  shuffled = (unsigned char*) taucs_malloc(nbytes);
+  if (!shuffled) return -1;
+  if (io_rle_unpack(in,csize,shuffled,nbytes) == -1) {
+    taucs_free(shuffled);
+    return -1;
+  }
+  for (b=0; b<esize; b++)
+    for (i=0; i<nelem; i++)
+      out[i*esize+b] = shuffled[b*nelem+i];
+  taucs_free(shuffled);
+  return 0;
+}
+
+/*************************************************************/
+/* large transfers                                           */
+/*************************************************************/
+
+/* 
+   read() and write() may transfer less than requested, and 
+   most systems cap a single call below 2GB, so block transfers
+   loop in chunks 
+*/
+
+static taucs_int64 io_write_full(int fd, void* data, taucs_int64 size)
+{
+  taucs_int64 done = 0;
+  long nbytes;
+
+  while (done < size) {
+    nbytes = (long) write(fd,(char*)data+done,
+			  (size-done > IO_CHUNK) ? IO_CHUNK : (unsigned int) (size-done));
+    if (nbytes == -1 && errno == EINTR) continue;
+    if (nbytes <= 0) {
+      if (nbytes == -1) perror("taucs_io");
+      return -1;
+    }
+    done += nbytes;
+  }
+  return done;
+}
+
+static taucs_int64 io_read_full(int fd, void* data, taucs_int64 size)
+{
+  taucs_int64 done = 0;
+  long nbytes;
+
+  while (done < size) {
+    nbytes = (long) read(fd,(char*)data+done,
+			 (size-done > IO_CHUNK) ? IO_CHUNK : (unsigned int) (size-done));
+    if (nbytes == -1 && errno == EINTR) continue;
+    if (nbytes <= 0) return -1;
+    done += nbytes;
+  }
+  return done;
+}
+
+/*************************************************************/
+/* direct I/O                                                */
+/*************************************************************/
+
+/* 
+   O_DIRECT (Linux and most Unix systems) or F_NOCACHE (Mac OS X)
+   bypass the page cache; both can be switched on an open file 
+*/
+
+static int io_fd_set_direct(int fd, int direct)
+{
+#if defined(O_DIRECT)
+  int fl = fcntl(fd,F_GETFL);
+  if (fl == -1) return -1;
+  fl = direct ? (fl | O_DIRECT) : (fl & ~O_DIRECT);
+  return (fcntl(fd,F_SETFL,fl) == -1) ? -1 : 0;
+#elif defined(F_NOCACHE)
+  return (fcntl(fd,F_NOCACHE,direct ? 1 : 0) == -1) ? -1 : 0;
+#else
+  return direct ? -1 : 0;
+#endif
+}
+
+/* reads up to size bytes; returns fewer only at the end of the file */
+
+static taucs_int64 io_read_upto(int fd, void* data, taucs_int64 size)
+{
+  taucs_int64 done = 0;
+  long nbytes;
+
+  while (done < size) {
+    nbytes = (long) read(fd,(char*)data+done,(unsigned int) (size-done));
+    if (nbytes == -1 && errno == EINTR) continue;
+    if (nbytes == -1) return -1;
+    if (nbytes == 0) break;
+    done += nbytes;
+  }
+  return done;
+}
+
+/* the current contents of the block at offset; zeros past the end of the file */
+
+static int io_direct_fill_block(taucs_io_direct* d, int fd, off_t offset, char* block)
+{
+  taucs_int64 got;
+
+  if (d->tail_fd == fd && d->tail_offset == offset) {
+    memcpy(block,d->tail,IO_DIRECT_ALIGN);
+    return 0;
+  }
+  if (lseek(fd,offset,SEEK_SET) == -1) return -1;
+  got = io_read_upto(fd,block,IO_DIRECT_ALIGN);
+  if (got == -1) return -1;
+  memset(block+got,0,(size_t) (IO_DIRECT_ALIGN-got));
+  return 0;
+}
+
+/*
+  Transfers size bytes at offset as whole aligned blocks, at
+  most IO_DIRECT_STAGING bytes at a time. Writes preserve the
+  parts of the first and last blocks that lie outside the
+  transfer; reads may end short at the end of the file, as long
+  as the requested bytes were read.
+*/
+
+static int io_direct_transfer(taucs_io_direct* d,
+			      int    fd,
+			      off_t  offset,
+			      char*  data,
+			      taucs_int64 size,
+			      int    writing)
+{
+  off_t end = offset + (off_t) size;
+  off_t pos = (offset / IO_DIRECT_ALIGN) * IO_DIRECT_ALIGN;
+  off_t span_end,lo,hi;
+  taucs_int64 span,got;
+
+  while (pos < end) {
+    span_end = ((end + IO_DIRECT_ALIGN - 1) / IO_DIRECT_ALIGN) * IO_DIRECT_ALIGN;
+    if (span_end - pos > IO_DIRECT_STAGING) span_end = pos + IO_DIRECT_STAGING;
+    span = (taucs_int64) (span_end - pos);
+    lo = (offset > pos) ? offset : pos;
+    hi = (end < span_end) ? end : span_end;
+
+    if (writing) {
+      if (lo > pos 
+	  && io_direct_fill_block(d,fd,pos,d->stage) == -1) 
+	return -1;
+      if (hi < span_end && (span > IO_DIRECT_ALIGN || lo == pos)
+	  && io_direct_fill_block(d,fd,span_end-IO_DIRECT_ALIGN,
+				  d->stage+span-IO_DIRECT_ALIGN) == -1)
+	return -1;
+      memcpy(d->stage+(lo-pos),data+(lo-offset),(size_t) (hi-lo));
+
+      if (lseek(fd,pos,SEEK_SET) == -1) return -1;
+      if (io_write_full(fd,d->stage,span) != span) {
+	d->tail_fd = -1;
+	return -1;
+      }
+      memcpy(d->tail,d->stage+span-IO_DIRECT_ALIGN,IO_DIRECT_ALIGN);
+      d->tail_fd     = fd;
+      d->tail_offset = span_end-IO_DIRECT_ALIGN;
+    } else {
+      if (lseek(fd,pos,SEEK_SET) == -1) return -1;
+      got = io_read_upto(fd,d->stage,span);
+      if (got < (taucs_int64) (hi-pos)) return -1;
+      memcpy(data+(lo-offset),d->stage+(lo-pos),(size_t) (hi-lo));
+    }
+
+    pos = span_end;
+  }
+  return 0;
+}
+
+/* reads or writes size bytes at offset of one open file */
+
+static int io_fd_transfer(taucs_io_direct* d,
+			  int    fd,
+			  off_t  offset,
+			  void*  data,
+			  taucs_int64 size,
+			  int    writing)
+{
+  if (d)
+    return io_direct_transfer(d,fd,offset,(char*) data,size,writing);
+
+  if (lseek(fd,offset,SEEK_SET) == -1) return -1;
+  if (writing) 
+    return (io_write_full(fd,data,size) == size) ? 0 : -1;
+  else
+    return (io_read_full (fd,data,size) == size) ? 0 : -1;
+}
+
+static int io_file_transfer(taucs_io_handle* f,
+			    int    fd,
+			    off_t  offset,
+			    void*  data,
+			    taucs_int64 size,
+			    int    writing)
+{
+  return io_fd_transfer((taucs_io_direct*) f->direct,fd,offset,data,size,writing);
+}
+
+/* 
+   the multifile table of open data files grows on demand; 
+   file i holds bytes [i,i+1)*IO_FILE_BYTES of the data 
+*/
+
+static int io_multifile_set_file(taucs_io_handle_multifile* h, int i, int file_id)
+{
+  int* f;
+  int  nf;
+
+  if (i >= h->nf) {
+    nf = max(2*(h->nf),i+1);
+    f = (int*) taucs_realloc(h->f,nf*sizeof(int));
+    if (!f) {
+      taucs_printf("taucs_io: out of memory\n");
+      return -1;
+    }
+    h->f  = f;
+    h->nf = nf;
+  }
+  h->f[i] = file_id;
+  if (i > h->last_created_file) h->last_created_file = i;
+  return 0;
+}
+
+static int io_multifile_create_file(taucs_io_handle_multifile* h, int i)
+{
+  int file_id;
+  mode_t mode;
+  mode_t perm;
+  char filename[256];
+
+  sprintf(filename,"%s.%d",h->basename,i);
+
+#ifdef OSTYPE_win32
+  mode = _O_RDWR | _O_CREAT | _O_BINARY;
+  perm = _S_IREAD | _S_IWRITE | _S_IEXEC;
+#else
+  mode = O_RDWR | O_CREAT;
+  perm = 0644;
+#endif
+
+  file_id = open(filename,mode,perm);
+  if (file_id == -1) {
+    taucs_printf("taucs_io: Could not create data file %s\n",filename);
+    return -1;
+  }
+  return io_multifile_set_file(h,i,file_id);
+}
+
+/* reads or writes size bytes at a global offset, creating files when writing */
+
+static int io_multifile_transfer(taucs_io_handle* f,
+				 double offset,
+				 void*  data,
+				 taucs_int64 size,
+				 int    writing)
+{
+  taucs_io_handle_multifile* h = ((taucs_io_handle_multifile*) f->type_specific);
+  int    file_index;
+  double file_offset;
+  taucs_int64 chunk,done = 0;
+
+  while (done < size) {
+    file_index  = (int) floor(offset / IO_FILE_BYTES);
+    file_offset = offset - (double) file_index * IO_FILE_BYTES;
+    /* for find overflow */
+    assert(file_offset < IO_FILE_BYTES);
+
+    chunk = size - done;
+    if ((double) chunk > IO_FILE_BYTES - file_offset)
+      chunk = (taucs_int64) (IO_FILE_BYTES - file_offset);
+
+    while (writing && file_index > h->last_created_file) {
+      if (io_multifile_create_file(h,h->last_created_file+1) == -1) return -1;
+      if (f->direct && io_fd_set_direct(h->f[h->last_created_file],1) == -1) {
+	taucs_printf("taucs_io: cannot use direct I/O on data file %d\n",
+		     h->last_created_file);
+	return -1;
+      }
+    }
+    if (file_index > h->last_created_file) return -1;
+
+    if (io_file_transfer(f,h->f[file_index],(off_t) file_offset,
+			 (char*)data+done,chunk,writing) == -1)
+      return -1;
+
+    done   += chunk;
+    offset += (double) chunk;
+  }
+  return 0;
+}
+
+/*************************************************************/
+/* striped transfers                                         */
+/*************************************************************/
+
+typedef struct {
+  taucs_io_handle* f;
+  int    device;
+  double offset;
+  char*  data;
+  taucs_int64 size;
+  int    writing;
+  int    rc;
+} io_stripe_task;
+
+/* the units of one transfer that lie on one device, in order */
+
+static void io_striped_device_transfer(io_stripe_task* T)
+{
+  taucs_io_handle_striped* h = ((taucs_io_handle_striped*) T->f->type_specific);
+  taucs_io_direct* d = T->f->direct ? ((taucs_io_direct*) T->f->direct) + T->device : NULL;
+  double end = T->offset + (double) T->size;
+  double u,u_last,lo,hi,device_offset;
+
+  T->rc = 0;
+  u      = floor(T->offset / IO_STRIPE_UNIT);
+  u_last = floor((end - 1.0) / IO_STRIPE_UNIT);
+  u += (double) ((T->device - (int) fmod(u,(double) h->ndevices) + h->ndevices) 
+		 % h->ndevices);
+
+  for (; u <= u_last; u += (double) h->ndevices) {
+    lo = max(T->offset,u * IO_STRIPE_UNIT);
+    hi = min(end,(u + 1.0) * IO_STRIPE_UNIT);
+    device_offset = floor(u / h->ndevices) * IO_STRIPE_UNIT + (lo - u * IO_STRIPE_UNIT);
+    if (io_fd_transfer(d,h->f[T->device],(off_t) device_offset,
+		       T->data + (taucs_int64) (lo - T->offset),
+		       (taucs_int64) (hi - lo),T->writing) == -1) {
+      T->rc = -1;
+      return;
+    }
+  }
+}
+
+#ifdef TAUCS_CONFIG_PFUNC
+static void io_striped_thread(void* args)
+{
+  io_stripe_task* T;
+
+  pfunc_unpack(args, "void*", (void*)&T);
+  io_striped_device_transfer(T);
+}
+#endif
+
+/* 
+   reads or writes size bytes at a global offset; with 
+   taucs_io_set_parallel, each device gets its own thread 
+*/
+
+static int io_striped_transfer(taucs_io_handle* f,
+			       double offset,
+			       void*  data,
+			       taucs_int64 size,
+			       int    writing)
+{
+  taucs_io_handle_striped* h = ((taucs_io_handle_striped*) f->type_specific);
+  io_stripe_task T[IO_STRIPE_MAX_DEVICES];
+  double units;
+  int d,ntasks;
+
+  if (size <= 0) return 0;
+
+  units  = floor((offset + (double) size - 1.0) / IO_STRIPE_UNIT) 
+         - floor(offset / IO_STRIPE_UNIT) + 1.0;
+  ntasks = (units < (double) h->ndevices) ? (int) units : h->ndevices;
+
+  for (d=0; d<ntasks; d++) {
+    T[d].f       = f;
+    T[d].device  = (int) fmod(floor(offset / IO_STRIPE_UNIT) + d,(double) h->ndevices);
+    T[d].offset  = offset;
+    T[d].data    = (char*) data;
+    T[d].size    = size;
+    T[d].writing = writing;
+    T[d].rc      = 0;
+  }
+
+#ifdef TAUCS_CONFIG_PFUNC
+  if (h->parallel && ntasks > 1) {
+    pfunc_handle_t handles[IO_STRIPE_MAX_DEVICES];
+    char*          args   [IO_STRIPE_MAX_DEVICES];
+
+    /* the calling thread does the first device itself */
+    for (d=1; d<ntasks; d++) {
+      pfunc_handle_init(&handles[d]);
+      pfunc_pack(&args[d], "void*", &T[d]);
+      pfunc_run(&handles[d], PFUNC_ATTR_DEFAULT, PFUNC_GROUP_DEFAULT,
+		io_striped_thread, args[d]);
+    }
+    io_striped_device_transfer(&T[0]);
+    pfunc_wait_all(handles+1, ntasks-1);
+    for (d=1; d<ntasks; d++)
+      pfunc_handle_clear(handles[d]);
+  } else
+#endif
+  for (d=0; d<ntasks; d++) 
+    io_striped_device_transfer(&T[d]);
+
+  for (d=0; d<ntasks; d++)
+    if (T[d].rc == -1) return -1;
+  return 0;
+}
+
+/* grows an index table, marking the new entries unused */
+
+static int io_matrix_table_grow(taucs_io_matrix_multifile** matrices,
+				int nmatrices,
+				int index)
+{
+  taucs_io_matrix_multifile* m;
+  int i;
+
+  m = (taucs_io_matrix_multifile*) taucs_realloc(*matrices,
+						 (index + 1) * sizeof(taucs_io_matrix_multifile));
+  if (!m) return -1;
+  for (i=nmatrices; i<index; i++) {
+    m[i].m      = -1;
+    m[i].n      = -1;
+    m[i].flags  = -1;
+    m[i].offset = -1.0;
+    m[i].csize  = -1;
+  }
+  *matrices = m;
+  return 0;
+}
+
 /*************************************************************/
 /*                                                           */
 /*************************************************************/
@@ -179,7 +855,14 @@ taucs_io_handle* taucs_io_create_multifile(char* basename)
     taucs_free(h);
     return NULL;
   }
-  ((taucs_io_handle_multifile*)h->type_specific)->f[0] = f;
+  ((taucs_io_handle_multifile*)h->type_specific)->f  = NULL;
+  ((taucs_io_handle_multifile*)h->type_specific)->nf = 0;
+  ((taucs_io_handle_multifile*)h->type_specific)->last_created_file = 0;
+  if (io_multifile_set_file((taucs_io_handle_multifile*)h->type_specific,0,f) == -1) {
+    taucs_free(h->type_specific);
+    taucs_free(h);
+    return NULL;
+  }
   ((taucs_io_handle_multifile*)h->type_specific)->matrices = NULL;
   ((taucs_io_handle_multifile*)h->type_specific)->last_offset = offset;
   ((taucs_io_handle_multifile*)h->type_specific)->last_created_file = 0;
@@ -187,6 +870,8 @@ taucs_io_handle* taucs_io_create_multifile(char* basename)
 
   h->nreads = h->nwrites = h->bytes_read =
     h->bytes_written = h->read_time =h->write_time = 0.0;
+  h->compress = 0;
+  h->direct   = NULL;
 
   return h;
 }
@@ -259,29 +944,284 @@ taucs_io_handle* taucs_io_create_singlefile(char* filename)
 
   h->nreads = h->nwrites = h->bytes_read =
     h->bytes_written = h->read_time =h->write_time = 0.0;
+  h->compress = 0;
+  h->direct   = NULL;
 
   return h;
 }
 
-int taucs_io_append(taucs_io_handle* f,
-		    int   index,
-		    int   m,int n,
-		    int   flags,
-		    void* data
-		    )
+/*************************************************************/
+/* striped files                                             */
+/*************************************************************/
+
+/* an index table entry as stored in a striped file */
+
+#define IO_STRIPE_ENTRY (3*sizeof(int)+sizeof(double)+sizeof(taucs_int64))
+
+/* closes the data files and frees everything but the handle itself */
+
+static int io_striped_release(taucs_io_handle_striped* hs)
 {
-  int this_size = 0,next_size = 0;
-  int first_size = 0;
-  int added_files = 0;
-  int written_bytes = 0;
-  off_t this_offset = 0;
-  double this_multi_offset = 0.0,new_last_offset = 0.0;
-  ssize_t nbytes = 0;
-  int i = 0;
+  int d;
+  int rc = 0;
+
+  for (d=0; d<hs->ndevices; d++) {
+    if (hs->f[d] != -1 && close(hs->f[d]) == -1) {
+      taucs_printf("taucs_close: Could not close data file %s.%d\n",
+		   hs->basenames[d],d);
+      rc = -1;
+    }
+    taucs_free(hs->basenames[d]);
+  }
+  taucs_free(hs->basenames);
+  taucs_free(hs->f);
+  taucs_free(hs->matrices);
+  return rc;
+}
+
+/* 
+   splits a comma-separated list of basenames and opens (or 
+   creates) the data file of each device 
+*/
+
+static taucs_io_handle* io_striped_handle(char* basenames, int creating)
+{
+  taucs_io_handle* h;
+  taucs_io_handle_striped* hs;
+  char*  p;
+  char*  q;
+  int    d,n,len;
   mode_t mode;
   mode_t perm;
-  char filename[256];
-  int file_id = 0;
+  char   filename[256];
+
+  for (n=1, p=basenames; *p; p++) 
+    if (*p == ',') n++;
+  if (n > IO_STRIPE_MAX_DEVICES) {
+    taucs_printf("taucs_io: at most %d devices in a striped file\n",
+		 IO_STRIPE_MAX_DEVICES);
+    return NULL;
+  }
+
+#ifdef OSTYPE_win32
+  mode = _O_RDWR | _O_BINARY;
+  perm = _S_IREAD | _S_IWRITE | _S_IEXEC;
+  if (creating) mode |= _O_CREAT;
+#else
+  mode = O_RDWR;
+  perm = 0644;
+  if (creating) mode |= O_CREAT;
+#endif
+
+  h  = (taucs_io_handle*) taucs_calloc(1,sizeof(taucs_io_handle));
+  hs = (taucs_io_handle_striped*) taucs_calloc(1,sizeof(taucs_io_handle_striped));
+  if (hs) {
+    hs->f         = (int*)   taucs_malloc(n*sizeof(int));
+    hs->basenames = (char**) taucs_calloc(n,sizeof(char*));
+  }
+  if (!h || !hs || !(hs->f) || !(hs->basenames)) {
+    taucs_printf("taucs_io: out of memory\n");
+    if (hs) { taucs_free(hs->f); taucs_free(hs->basenames); }
+    taucs_free(hs);
+    taucs_free(h);
+    return NULL;
+  }
+  h->type          = IO_TYPE_STRIPED;
+  h->nmatrices     = 0;
+  h->type_specific = hs;
+  h->compress      = 0;
+  h->direct        = NULL;
+  hs->ndevices     = n;
+  hs->matrices     = NULL;
+  hs->parallel     = 0;
+  for (d=0; d<n; d++) hs->f[d] = -1;
+
+  for (d=0, p=basenames; d<n; d++, p=q+1) {
+    q = strchr(p,',');
+    len = q ? (int) (q-p) : (int) strlen(p);
+    hs->basenames[d] = (char*) taucs_malloc(len+1);
+    if (!(hs->basenames[d]) || len == 0 || len + 16 > (int) sizeof(filename)) {
+      taucs_printf("taucs_io: bad basename for device %d\n",d);
+      break;
+    }
+    memcpy(hs->basenames[d],p,len);
+    hs->basenames[d][len] = 0;
+
+    sprintf(filename,"%s.%d",hs->basenames[d],d);
+    hs->f[d] = open(filename,mode,perm);
+    if (hs->f[d] == -1) {
+      taucs_printf("taucs_io: Could not %s data file %s\n",
+		   creating ? "create" : "open",filename);
+      break;
+    }
+    if (!q) { d++; break; }
+  }
+
+  if (d < n) {
+    io_striped_release(hs);
+    taucs_free(hs);
+    taucs_free(h);
+    return NULL;
+  }
+  return h;
+}
+
+/*
+  basenames is a comma-separated list, one per device, such as 
+  "/disk0/L,/disk1/L"; file 0 of the first holds the metadata.
+*/
+
+taucs_io_handle* taucs_io_create_striped(char* basenames)
+{
+  taucs_io_handle* h;
+  taucs_io_handle_striped* hs;
+  int nmatrices = 0;
+  int unit = IO_STRIPE_UNIT;
+  int fd;
+
+  h = io_striped_handle(basenames,1);
+  if (!h) return NULL;
+  hs = (taucs_io_handle_striped*) h->type_specific;
+  fd = hs->f[0];
+
+  hs->last_offset = (double) (strlen(TAUCS_FILE_SIGNATURE) + 3*sizeof(int) + sizeof(double));
+
+  if (write(fd,TAUCS_FILE_SIGNATURE,strlen(TAUCS_FILE_SIGNATURE)) 
+      != (ssize_t) strlen(TAUCS_FILE_SIGNATURE)
+      || write(fd,&(hs->ndevices),sizeof(int))       != sizeof(int)
+      || write(fd,&unit,sizeof(int))                 != sizeof(int)
+      || write(fd,&nmatrices,sizeof(int))            != sizeof(int)
+      || write(fd,&(hs->last_offset),sizeof(double)) != sizeof(double)) {
+    taucs_printf("taucs_create: Error writing metadata.\n");
+    io_striped_release(hs);
+    taucs_free(hs);
+    taucs_free(h);
+    return NULL;
+  }
+
+  h->nreads = h->nwrites = h->bytes_read =
+    h->bytes_written = h->read_time =h->write_time = 0.0;
+
+  return h;
+}
+
+taucs_io_handle* taucs_io_open_striped(char* basenames)
+{
+  taucs_io_handle* h;
+  taucs_io_handle_striped* hs;
+  char  signature[16];
+  int   ndevices,unit,nmatrices,i;
+  char* table = NULL;
+  char* p;
+  int   fd;
+
+  h = io_striped_handle(basenames,0);
+  if (!h) return NULL;
+  hs = (taucs_io_handle_striped*) h->type_specific;
+  fd = hs->f[0];
+
+  if (read(fd,signature,strlen(TAUCS_FILE_SIGNATURE)) 
+      != (ssize_t) strlen(TAUCS_FILE_SIGNATURE)
+      || strncmp(signature,TAUCS_FILE_SIGNATURE,strlen(TAUCS_FILE_SIGNATURE))
+      || read(fd,&ndevices,sizeof(int))            != sizeof(int)
+      || read(fd,&unit,sizeof(int))                != sizeof(int)
+      || read(fd,&nmatrices,sizeof(int))           != sizeof(int)
+      || read(fd,&(hs->last_offset),sizeof(double)) != sizeof(double)) {
+    taucs_printf("taucs_open: Error reading metadata.\n");
+    goto failure;
+  }
+  if (ndevices != hs->ndevices || unit != IO_STRIPE_UNIT) {
+    taucs_printf("taucs_open: file was striped over %d devices in units of %d bytes\n",
+		 ndevices,unit);
+    goto failure;
+  }
+
+  if (nmatrices > 0) {
+    table        = (char*) taucs_malloc(nmatrices * IO_STRIPE_ENTRY);
+    hs->matrices = (taucs_io_matrix_multifile*) 
+                   taucs_malloc(nmatrices * sizeof(taucs_io_matrix_multifile));
+    if (!table || !(hs->matrices)) {
+      taucs_printf("taucs_open: out of memory\n");
+      goto failure;
+    }
+    if (io_striped_transfer(h,hs->last_offset,table,
+			    (taucs_int64) nmatrices * IO_STRIPE_ENTRY,0) == -1) {
+      taucs_printf("taucs_open: Error reading metadata.\n");
+      goto failure;
+    }
+    for (i=0, p=table; i<nmatrices; i++) {
+      memcpy(&(hs->matrices[i].m),     p,sizeof(int));         p += sizeof(int);
+      memcpy(&(hs->matrices[i].n),     p,sizeof(int));         p += sizeof(int);
+      memcpy(&(hs->matrices[i].flags), p,sizeof(int));         p += sizeof(int);
+      memcpy(&(hs->matrices[i].offset),p,sizeof(double));      p += sizeof(double);
+      memcpy(&(hs->matrices[i].csize), p,sizeof(taucs_int64)); p += sizeof(taucs_int64);
+    }
+    taucs_free(table);
+  }
+  h->nmatrices = nmatrices;
+
+  h->nreads = h->nwrites = h->bytes_read =
+    h->bytes_written = h->read_time =h->write_time = 0.0;
+
+  return h;
+
+ failure:
+  taucs_free(table);
+  io_striped_release(hs);
+  taucs_free(hs);
+  taucs_free(h);
+  return NULL;
+}
+
+/* writes the index table after the data and the header in file 0 */
+
+static int io_striped_close(taucs_io_handle* f)
+{
+  taucs_io_handle_striped* hs = ((taucs_io_handle_striped*) f->type_specific);
+  char* table = NULL;
+  char* p;
+  int   i;
+  int   rc = 0;
+
+  if (f->nmatrices > 0) {
+    table = (char*) taucs_malloc(f->nmatrices * IO_STRIPE_ENTRY);
+    if (!table) {
+      taucs_printf("taucs_close: out of memory\n");
+      return -1;
+    }
+    for (i=0, p=table; i<f->nmatrices; i++) {
+      memcpy(p,&(hs->matrices[i].m),     sizeof(int));         p += sizeof(int);
+      memcpy(p,&(hs->matrices[i].n),     sizeof(int));         p += sizeof(int);
+      memcpy(p,&(hs->matrices[i].flags), sizeof(int));         p += sizeof(int);
+      memcpy(p,&(hs->matrices[i].offset),sizeof(double));      p += sizeof(double);
+      memcpy(p,&(hs->matrices[i].csize), sizeof(taucs_int64)); p += sizeof(taucs_int64);
+    }
+    rc = io_striped_transfer(f,hs->last_offset,table,
+			     (taucs_int64) f->nmatrices * IO_STRIPE_ENTRY,1);
+    taucs_free(table);
+  }
+
+  if (rc == -1
+      || lseek(hs->f[0],strlen(TAUCS_FILE_SIGNATURE) + 2*sizeof(int),SEEK_SET) == -1
+      || write(hs->f[0],&(f->nmatrices),sizeof(int))        != sizeof(int)
+      || write(hs->f[0],&(hs->last_offset),sizeof(double)) != sizeof(double)) {
+    taucs_printf("taucs_close: Error writing metadata.\n");
+    rc = -1;
+  }
+
+  if (io_striped_release(hs) == -1) rc = -1;
+  return rc;
+}
+
+static int io_append_bytes(taucs_io_handle* f,
+			   int   index,
+			   int   m,int n,
+			   int   flags,
+			   void* data,
+			   taucs_int64 size
+			   )
+{
+  int i = 0;
   double wtime;
  
   wtime = taucs_wtime();
@@ -294,11 +1234,16 @@ int taucs_io_append(taucs_io_handle* f,
       ((taucs_io_handle_singlefile*)f->type_specific)->matrices = 
 					(taucs_io_matrix_singlefile*) taucs_realloc(h->matrices,
 						(index + 1) * sizeof(taucs_io_matrix_singlefile));
+      if (!h->matrices) {
+	taucs_printf("taucs_append: out of memory \n");
+	return -1;
+      }
       for(i=f->nmatrices;i<index;i++){
 				h->matrices[i].m = -1;
 				h->matrices[i].n = -1;
 				h->matrices[i].flags = -1;
 				h->matrices[i].offset = -1;
+				h->matrices[i].csize = -1;
       }
       f->nmatrices = index+1;
     }
@@ -308,35 +1253,23 @@ int taucs_io_append(taucs_io_handle* f,
 	return -1;
       }
     
-    if (!((taucs_io_handle_singlefile*)f->type_specific)->matrices) {
-      taucs_printf("taucs_append: out of memory \n");
-      return -1;
-    }
+    if (f->direct && size >= IO_DIRECT_ALIGN_MIN)
+      h->last_offset = ((h->last_offset + IO_DIRECT_ALIGN - 1) / IO_DIRECT_ALIGN) 
+	               * IO_DIRECT_ALIGN;
 
     matrices = h->matrices;
-    this_offset = h->last_offset;
     matrices[index].m = m;
     matrices[index].n = n;
     matrices[index].flags = flags;
-    matrices[index].offset = this_offset;
-    /*this_size = m * n * ((flags & TAUCS_INT) ? sizeof(int) : sizeof(double));*/
-    this_size = m * n * element_size(flags);
-    h->last_offset +=this_size; 
-    
+    matrices[index].offset = h->last_offset;
+    matrices[index].csize = size;
 
     /*taucs_printf("debug1: index = %d offset = %d\n ",index,this_offset);*/
-    if (lseek(h->f, this_offset, SEEK_SET) == -1) {
-      taucs_printf("taucs_append: lseek failed\n");
-      return -1;
-    }
-    
-    nbytes = write(h->f, data, this_size);
-    /*    taucs_printf("debug for nbytes = %d this_size = %d \n ",nbytes,this_size);*/
-    /*if (nbytes != this_size) { omer*/
-		if ((int)nbytes != this_size) { 
+    if (io_file_transfer(f,h->f,h->last_offset,data,size,1) == -1) { 
       taucs_printf("taucs_append: Error writing data (%s:%d).\n",__FILE__,__LINE__);
       return -1;
     }
+    h->last_offset += (off_t) size; 
   }
 
   if (f->type == IO_TYPE_MULTIFILE) {
@@ -344,14 +1277,9 @@ int taucs_io_append(taucs_io_handle* f,
     taucs_io_matrix_multifile* matrices;
    
     if (index >= f->nmatrices){    
-      ((taucs_io_handle_multifile*)f->type_specific)->matrices = 
-				(taucs_io_matrix_multifile*) taucs_realloc(h->matrices,
-				  (index + 1) * sizeof(taucs_io_matrix_multifile));
-      for(i=f->nmatrices;i<index;i++){
-				h->matrices[i].m = -1;
-				h->matrices[i].n = -1;
-				h->matrices[i].flags = -1;
-				h->matrices[i].offset = -1.0;
+      if (io_matrix_table_grow(&(h->matrices),f->nmatrices,index) == -1) {
+	taucs_printf("taucs_append: out of memory \n");
+	return -1;
       }
       f->nmatrices = index+1;
     }
@@ -360,107 +1288,127 @@ int taucs_io_append(taucs_io_handle* f,
 			return -1;
     }
     
-    if (!((taucs_io_handle_multifile*)f->type_specific)->matrices) {
-      taucs_printf("taucs_append: out of memory \n");
-      return -1;
-    }
+    if (f->direct && size >= IO_DIRECT_ALIGN_MIN)
+      h->last_offset = ceil(h->last_offset / IO_DIRECT_ALIGN) * IO_DIRECT_ALIGN;
 
     matrices = h->matrices;
     matrices[index].m = m;
     matrices[index].n = n;
     matrices[index].flags = flags;
     matrices[index].offset =  h->last_offset;
-    /*this_size = m * n * ((flags & TAUCS_INT) ? sizeof(int) : sizeof(double));*/
-    this_size = m * n * element_size(flags);
-    new_last_offset = h->last_offset + ((double)this_size);
+    matrices[index].csize = size;
     /*    taucs_printf("debug1: index = %d offset = %lf\n ",index,h->last_offset);*/
-    
-    if(new_last_offset < ((h->last_created_file+1)*IO_FILE_RESTRICTION*1024.0*1024.0)){    
-      this_multi_offset = h->last_offset - ((h->last_created_file)*IO_FILE_RESTRICTION*1024.0*1024.0);   
-      if (lseek(h->f[h->last_created_file],(off_t)this_multi_offset, SEEK_SET) == -1) {
-				taucs_printf("taucs_append: lseek failed\n");
-				return -1;
-      }
-					    
-      nbytes = write(h->f[h->last_created_file], data, this_size);
-      /*if (nbytes != this_size) { omer*/
-			if ((int)nbytes != this_size) { 
-				taucs_printf("taucs_append: Error writing data (%s:%d).\n",__FILE__,__LINE__);
-				taucs_printf("taucs_append: index %d n %d m %d\n",index,n,m);
-				taucs_printf("taucs_append: trying to write %d bytes from %08x, wrote %d\n",
-					 this_size,data,nbytes);
-				if (nbytes==-1) perror("taucs_append");
-				return -1;
-      }
+
+    if (io_multifile_transfer(f,h->last_offset,data,size,1) == -1) {
+      taucs_printf("taucs_append: Error writing data (%s:%d).\n",__FILE__,__LINE__);
+      taucs_printf("taucs_append: index %d n %d m %d\n",index,n,m);
+      return -1;
     }
-    else{
-      if(h->last_offset < ((h->last_created_file+1)*IO_FILE_RESTRICTION*1024.0*1024.0)){
-				this_multi_offset = h->last_offset - 
-					((h->last_created_file)*IO_FILE_RESTRICTION*1024.0*1024.0);
-				if (lseek(h->f[h->last_created_file],(off_t)this_multi_offset, SEEK_SET) == -1) {
-					taucs_printf("taucs_append: lseek failed\n");
-					return -1;
-				}
-				first_size = (int)((IO_FILE_RESTRICTION*1024.0*1024.0) - this_multi_offset);
-				nbytes = write(h->f[h->last_created_file], data, first_size);
-				/*if (nbytes != first_size) { omer*/
-				if ((int)nbytes != first_size) { 
-					taucs_printf("taucs_append: Error writing data (%s:%d).\n",__FILE__,__LINE__);
-					return -1;
-				}
+    h->last_offset += (double) size; 
+  }
+
+  if (f->type == IO_TYPE_STRIPED) {
+    taucs_io_handle_striped* h = ((taucs_io_handle_striped*) f->type_specific);
+
+    if (index >= f->nmatrices) {
+      if (io_matrix_table_grow(&(h->matrices),f->nmatrices,index) == -1) {
+	taucs_printf("taucs_append: out of memory \n");
+	return -1;
       }
+      f->nmatrices = index+1;
+    }
+    else if (h->matrices[index].m!=-1 || h->matrices[index].n!=-1) {
+      taucs_printf("taucs_append: try append more than once for index=%d \n",index);
+      return -1;
+    }
 
-      this_multi_offset = 0.0;
-      next_size = this_size - first_size;
-      written_bytes = first_size;
-      while(next_size>0){
-				if(next_size>IO_FILE_RESTRICTION*1024*1024)
-					next_size = IO_FILE_RESTRICTION*1024*1024;
-				sprintf(filename,"%s.%d",h->basename,(h->last_created_file+1));
+    if (f->direct && size >= IO_DIRECT_ALIGN_MIN)
+      h->last_offset = ceil(h->last_offset / IO_DIRECT_ALIGN) * IO_DIRECT_ALIGN;
 
-#ifdef OSTYPE_win32
-				mode = _O_RDWR | _O_CREAT | _O_BINARY;
-				perm = _S_IREAD | _S_IWRITE | _S_IEXEC;
-#else
-				mode = O_RDWR | O_CREAT;
-				perm = 0644;
-#endif
+    h->matrices[index].m      = m;
+    h->matrices[index].n      = n;
+    h->matrices[index].flags  = flags;
+    h->matrices[index].offset = h->last_offset;
+    h->matrices[index].csize  = size;
 
-				file_id = open(filename,mode,perm);
-      
-				if (file_id == -1) {
-					taucs_printf("taucs_append: Could not create metadata file %s\n",filename);
-					return -1;
-				}
-				added_files++;
-				h->last_created_file++;
-				h->f[h->last_created_file] = file_id;
-				nbytes = write(h->f[h->last_created_file],((char*)data)+written_bytes,next_size);
-				/*if (nbytes != next_size) { omer*/
-				if ((int)nbytes != next_size) { 
-					taucs_printf("taucs_append: Error writing data (%s:%d).\n",__FILE__,__LINE__);
-					return -1;
-				}
-				written_bytes += next_size;
-				next_size = this_size - written_bytes;
-      }
+    if (io_striped_transfer(f,h->last_offset,data,size,1) == -1) {
+      taucs_printf("taucs_append: Error writing data (%s:%d).\n",__FILE__,__LINE__);
+      return -1;
     }
-    h->last_offset = new_last_offset; 
- }
+    h->last_offset += (double) size; 
+  }
   
   wtime = taucs_wtime()-wtime;
 
   f->nwrites       += 1.0;
-  f->bytes_written += (double) this_size;
+  f->bytes_written += (double) size;
   f->write_time    += wtime;
 
-  /*disc_write += 1.0;*/
-  /*bytes_write += (double)this_size;*/
-  /*time_write += wtime;*/
-
   return 0;
 }
 
+int taucs_io_append(taucs_io_handle* f,
+		    int   index,
+		    int   m,int n,
+		    int   flags,
+		    void* data
+		    )
+{
+  taucs_int64 nbytes = (taucs_int64) m * (taucs_int64) n * element_size(flags);
+  unsigned char* packed;
+  int csize,rc;
+
+  /* the codecs work on blocks of up to IO_CHUNK bytes */
+  if (!f->compress || nbytes < IO_COMPRESS_MIN || nbytes > IO_CHUNK)
+    return io_append_bytes(f,index,m,n,flags,data,nbytes);
+
+  packed = (unsigned char*) taucs_malloc((size_t) nbytes);
+  csize = packed ? io_compress(flags,data,(int) nbytes,packed) : -1;
+
+  if (csize == -1)
+    rc = io_append_bytes(f,index,m,n,flags,data,nbytes);
+  else
+    rc = io_append_bytes(f,index,m,n,flags | TAUCS_IO_COMPRESSED,packed,csize);
+
+  taucs_free(packed);
+  return rc;
+}
+
+/* the index table entry of a matrix; raw size in bytes */
+
+static void io_matrix_info(taucs_io_handle* f,
+			   int index,
+			   int* flags, taucs_int64* nbytes, taucs_int64* csize)
+{
+  int m = -1,n = -1;
+
+  *flags = -1;
+  *csize = -1;
+  if (f->type == IO_TYPE_SINGLEFILE) {
+    taucs_io_handle_singlefile* h = ((taucs_io_handle_singlefile*) f->type_specific);
+    m      = h->matrices[index].m;
+    n      = h->matrices[index].n;
+    *flags = h->matrices[index].flags;
+    *csize = h->matrices[index].csize;
+  }
+  if (f->type == IO_TYPE_MULTIFILE) {
+    taucs_io_handle_multifile* h = ((taucs_io_handle_multifile*) f->type_specific);
+    m      = h->matrices[index].m;
+    n      = h->matrices[index].n;
+    *flags = h->matrices[index].flags;
+    *csize = h->matrices[index].csize;
+  }
+  if (f->type == IO_TYPE_STRIPED) {
+    taucs_io_handle_striped* h = ((taucs_io_handle_striped*) f->type_specific);
+    m      = h->matrices[index].m;
+    n      = h->matrices[index].n;
+    *flags = h->matrices[index].flags;
+    *csize = h->matrices[index].csize;
+  }
+  *nbytes = (m == -1 || *flags == -1) 
+    ? -1 : (taucs_int64) m * (taucs_int64) n * element_size(*flags);
+}
+
 int   taucs_io_write(taucs_io_handle* f,
 		     int   index,
 		     int   m,int n,
@@ -468,188 +1416,147 @@ int   taucs_io_write(taucs_io_handle* f,
 		     void* data
 		     )
 {
-  int this_size;
-  off_t this_offset;
-  ssize_t nbytes;
-  double curr_file_offset;
-  int first_size;
-  int next_size,start_file_index;
-  int write_bytes;
+  taucs_int64 this_size;
+  int stored_flags;
+  taucs_int64 stored_size,csize;
+
+  if (index>=f->nmatrices) return -1;
+  io_matrix_info(f,index,&stored_flags,&stored_size,&csize);
+  if (IO_IS_COMPRESSED(stored_flags)) {
+    taucs_printf("taucs_write: matrix %d is stored compressed and cannot be rewritten\n",index);
+    return -1;
+  }
+
+  /*this_size = m * n * ((flags & TAUCS_INT) ? sizeof(int) : sizeof(double));*/
+  this_size = (taucs_int64) m * (taucs_int64) n * element_size(flags);
 
   if (f->type == IO_TYPE_SINGLEFILE) {
     taucs_io_handle_singlefile* h = ((taucs_io_handle_singlefile*) f->type_specific);
-    taucs_io_matrix_singlefile* matrices;
-    
-    if (index>=f->nmatrices) return -1;
-    matrices = h->matrices;
-    /*this_size = m * n * ((flags & TAUCS_INT) ? sizeof(int) : sizeof(double));*/
-    this_size = m * n * element_size(flags);
-    this_offset = matrices[index].offset;
         
-    if (lseek(h->f, this_offset, SEEK_SET) == -1) {
-      taucs_printf("taucs_write: lseek failed\n");
-      return -1;
-    }
-    nbytes = write(h->f, data, this_size);
-    /*if (nbytes != this_size) { omer*/
-		if ((int)nbytes != this_size) { 
+    if (io_file_transfer(f,h->f,h->matrices[index].offset,data,this_size,1) == -1) { 
       taucs_printf("taucs_write: Error writing data (%s:%d).\n",__FILE__,__LINE__);
       return -1;
     }
   }
 
-if (f->type == IO_TYPE_MULTIFILE) {
+  if (f->type == IO_TYPE_MULTIFILE) {
     taucs_io_handle_multifile* h = ((taucs_io_handle_multifile*) f->type_specific);
-    taucs_io_matrix_multifile* matrices;
     
-    if (index>=f->nmatrices) return -1;
-    matrices = h->matrices;
-    /*this_size = m * n * ((flags & TAUCS_INT) ? sizeof(int) : sizeof(double));*/
-    this_size = m * n * element_size(flags);
-    start_file_index = (int)floor((matrices[index].offset/(IO_FILE_RESTRICTION*1024*1024)));
-    curr_file_offset = matrices[index].offset - start_file_index*(IO_FILE_RESTRICTION*1024.0*1024.0);
-
-    if (lseek(h->f[start_file_index],(off_t) curr_file_offset, SEEK_SET) == -1) {
-      taucs_printf("taucs_write: lseek failed\n");
+    if (io_multifile_transfer(f,h->matrices[index].offset,data,this_size,1) == -1) {
+      taucs_printf("taucs_write: Error writing data (%s:%d).\n",__FILE__,__LINE__);
       return -1;
     }
-    first_size = (int)((IO_FILE_RESTRICTION*1024.0*1024.0) - curr_file_offset);
-    if(this_size<first_size) first_size = this_size;
+  }
 
-    nbytes = write(h->f[start_file_index], data, first_size);
-    /*if (nbytes != first_size) { omer*/
-		if ((int)nbytes != first_size) { 
+  if (f->type == IO_TYPE_STRIPED) {
+    taucs_io_handle_striped* h = ((taucs_io_handle_striped*) f->type_specific);
+    
+    if (io_striped_transfer(f,h->matrices[index].offset,data,this_size,1) == -1) {
       taucs_printf("taucs_write: Error writing data (%s:%d).\n",__FILE__,__LINE__);
       return -1;
     }
-    next_size = this_size - first_size;
-    write_bytes = first_size;
-
-    while(next_size>0){
-      if(next_size>IO_FILE_RESTRICTION*1024*1024)
-	next_size = IO_FILE_RESTRICTION*1024*1024;
-	start_file_index++;
-	if (lseek(h->f[start_file_index],0, SEEK_SET) == -1) {
-	  taucs_printf("taucs_write: lseek failed\n");
-	  return -1;
-	}
-	nbytes = write(h->f[start_file_index],((char*)data)+write_bytes,next_size);
-	/*if (nbytes != next_size) { omer*/
-	if ((int)nbytes != next_size) { 
-	  taucs_printf("taucs_write: Error writing data (%s:%d).\n",__FILE__,__LINE__);
-	  return -1;
-	}
-	write_bytes += next_size;
-	next_size = this_size - write_bytes;
-      }
   }
 
   return 0;
 }
 
-int   taucs_io_read_message(taucs_io_handle* f,
-		    int    index,
-		    int    m,int n,
-		    int    flags,
-		    void* data,
-				int show_message
-		    )
+static int io_read_bytes(taucs_io_handle* f,
+			 int    index,
+			 void*  data,
+			 taucs_int64 size,
+			 int    show_message
+			 )
 {
-  int this_size = 0;
-  off_t this_offset = 0;
-  ssize_t nbytes = 0;
-  double curr_file_offset = 0.0;
-  int first_size = 0;
-  int next_size = 0,start_file_index = 0;
-  int read_bytes = 0;
   double wtime = 0.0;
 
   wtime = taucs_wtime();
 
+  if (index>=f->nmatrices) return -1;
+
   if (f->type == IO_TYPE_SINGLEFILE) {
     taucs_io_handle_singlefile* h = ((taucs_io_handle_singlefile*) f->type_specific);
-    taucs_io_matrix_singlefile* matrices;
-    
-    if (index>=f->nmatrices) return -1;
-    matrices = h->matrices;
-    /*this_size = m * n * ((flags & TAUCS_INT) ? sizeof(int) : sizeof(double));*/
-    this_size = m * n * element_size(flags);
-    this_offset = matrices[index].offset;
         
-    if (lseek(h->f, this_offset, SEEK_SET) == -1) {
-      if (show_message) taucs_printf("taucs_read: lseek failed\n");
-      return -1;
-    }
-    nbytes = read(h->f, data, this_size);
-    /*if (nbytes != this_size) { omer*/
-		if ((int)nbytes != this_size) { 
-      taucs_printf("taucs_read: Error reading data .\n");
+    if (io_file_transfer(f,h->f,h->matrices[index].offset,data,size,0) == -1) { 
+      if (show_message) taucs_printf("taucs_read: Error reading data .\n");
       return -1;
     }
   }
 
   if (f->type == IO_TYPE_MULTIFILE) {
     taucs_io_handle_multifile* h = ((taucs_io_handle_multifile*) f->type_specific);
-    taucs_io_matrix_multifile* matrices;
-    
-    if (index>=f->nmatrices) return -1;
-    matrices = h->matrices;
-    /*this_size = m * n * ((flags & TAUCS_INT) ? sizeof(int) : sizeof(double));*/
-    this_size = m * n * element_size(flags);
-    start_file_index = (int)floor((matrices[index].offset/(IO_FILE_RESTRICTION*1024*1024)));
-    curr_file_offset = matrices[index].offset - start_file_index*(IO_FILE_RESTRICTION*1024.0*1024.0);
 
-    /* for find overflow */
-    assert(curr_file_offset < IO_FILE_RESTRICTION*1024.0*1024.0);
-
-    if (lseek(h->f[start_file_index],(off_t) curr_file_offset, SEEK_SET) == -1) {
-      if (show_message) taucs_printf("taucs_read: lseek failed\n");
+    if (io_multifile_transfer(f,h->matrices[index].offset,data,size,0) == -1) {
+      if (show_message) taucs_printf("taucs_read: Error reading data .\n");
       return -1;
     }
-    first_size = (int)(IO_FILE_RESTRICTION*1024.0*1024.0 - curr_file_offset);
-    if(this_size<first_size) first_size = this_size;
+  }
+
+  if (f->type == IO_TYPE_STRIPED) {
+    taucs_io_handle_striped* h = ((taucs_io_handle_striped*) f->type_specific);
 
-    nbytes = read(h->f[start_file_index], data, first_size);
-    /*if (nbytes != first_size) { omer*/
-		if ((int)nbytes != first_size) { 
-      taucs_printf("taucs_read: Error reading data .\n");
+    if (io_striped_transfer(f,h->matrices[index].offset,data,size,0) == -1) {
+      if (show_message) taucs_printf("taucs_read: Error reading data .\n");
       return -1;
     }
-    next_size = this_size - first_size;
-    read_bytes = first_size;
-
-    while(next_size>0){
-      if(next_size>IO_FILE_RESTRICTION*1024*1024)
-	next_size = IO_FILE_RESTRICTION*1024*1024;
-	start_file_index++;
-	if (lseek(h->f[start_file_index],0, SEEK_SET) == -1) {
-	  taucs_printf("taucs_read: lseek failed\n");
-	  return -1;
-	}
-	nbytes = read(h->f[start_file_index],((char*)data)+read_bytes,next_size);
-	/*if (nbytes != next_size) { omer*/
-	if ((int)nbytes != next_size) { 
-	  taucs_printf("taucs_read: Error reading data .\n");
-	  return -1;
-	}
-	read_bytes += next_size;
-	next_size = this_size - read_bytes;
-      }
   }
   
   wtime = taucs_wtime()-wtime;
 
   f->nreads     += 1.0;
   f->read_time  += wtime;
-  f->bytes_read += (double) this_size;
+  f->bytes_read += (double) size;
 
-  /*disc_read += 1.0;*/
-  /*bytes_read += (double)this_size;*/
-  /*time_read += wtime;*/
-  
   return 0;
 }
 
+/* 
+   compressed blocks are decompressed here, in the calling 
+   thread, so read-ahead threads also decompress ahead 
+*/
+
+int   taucs_io_read_message(taucs_io_handle* f,
+			    int    index,
+			    int    m,int n,
+			    int    flags,
+			    void*  data,
+			    int    show_message
+			    )
+{
+  taucs_int64 nbytes = (taucs_int64) m * (taucs_int64) n * element_size(flags);
+  int stored_flags;
+  taucs_int64 stored_size,csize;
+  unsigned char* packed;
+  void* full;
+  int rc;
+
+  if (index>=f->nmatrices) return -1;
+  io_matrix_info(f,index,&stored_flags,&stored_size,&csize);
+  if (!IO_IS_COMPRESSED(stored_flags))
+    return io_read_bytes(f,index,data,nbytes,show_message);
+
+  packed = (unsigned char*) taucs_malloc((size_t) csize);
+  full   = (nbytes == stored_size) ? data : taucs_malloc((size_t) stored_size);
+  if (!packed || !full) {
+    taucs_printf("taucs_read: out of memory\n");
+    taucs_free(packed);
+    if (full != data) taucs_free(full);
+    return -1;
+  }
+
+  rc = io_read_bytes(f,index,packed,csize,show_message);
+  if (rc == 0 
+      && io_decompress(stored_flags,packed,(int) csize,full,(int) stored_size) == -1) {
+    taucs_printf("taucs_read: corrupt compressed data in matrix %d\n",index);
+    rc = -1;
+  }
+  if (rc == 0 && full != data)
+    memcpy(data,full,(size_t) ((nbytes < stored_size) ? nbytes : stored_size));
+
+  taucs_free(packed);
+  if (full != data) taucs_free(full);
+  return rc;
+}
+
 int   taucs_io_read(taucs_io_handle* f,
 		    int    index,
 		    int    m,int n,
@@ -670,6 +1577,89 @@ int   taucs_io_read_try(taucs_io_handle* f,
 	return taucs_io_read_message(f,index,m,n,flags,data,0);
 }
 
+/*
+  a field of the index table, possibly straddling two data files,
+  like the m, n and flags fields written by taucs_io_close
+*/
+
+static int io_multifile_write_field(taucs_io_handle_multifile* h,
+				    double* curr_file_offset,
+				    void* value, int size)
+{
+  int first_size;
+
+  if(*curr_file_offset+(double)size<IO_FILE_BYTES){
+    if (io_write_full(h->f[h->last_created_file],value,size) != size){ 
+      taucs_printf("taucs_close: Error writing data .\n");
+      return -1;
+    }
+    *curr_file_offset += (double)size;
+    return 0;
+  }
+
+  first_size = (int) (IO_FILE_BYTES - *curr_file_offset);
+  if (io_write_full(h->f[h->last_created_file],value,first_size) != first_size) { 
+    taucs_printf("taucs_close: Error writing data .\n");
+    return -1;
+  }
+  if (io_multifile_create_file(h,h->last_created_file+1) == -1)
+    return -1;
+  if (io_write_full(h->f[h->last_created_file],(char*)value+first_size,size-first_size) 
+      != size-first_size){ 
+    taucs_printf("taucs_close: Error writing data .\n");
+    return -1;
+  }
+  *curr_file_offset = (double)(size-first_size);
+  return 0;
+}
+
+static int io_multifile_read_field(taucs_io_handle_multifile* h,
+				   int* file_index,
+				   double* curr_file_offset,
+				   void* value, int size)
+{
+  int first_size;
+  int file_id;
+  mode_t mode;
+  char filename[256];
+
+  if(*curr_file_offset+(double)size<IO_FILE_BYTES){
+    if (io_read_full(h->f[*file_index],value,size) != size){ 
+      taucs_printf("taucs_open: Error in open data .\n");
+      return -1;
+    }
+    *curr_file_offset += (double)size;
+    return 0;
+  }
+
+  first_size = (int) (IO_FILE_BYTES - *curr_file_offset);
+  if (io_read_full(h->f[*file_index],value,first_size) != first_size) { 
+    taucs_printf("taucs_open: Error in open data .\n");
+    return -1;
+  }
+#ifdef OSTYPE_win32
+  mode = _O_RDWR | _O_BINARY;
+#else
+  mode = O_RDWR;
+#endif
+  (*file_index)++;
+  sprintf(filename,"%s.%d",h->basename,*file_index);
+  file_id = open(filename,mode);
+  if (file_id == -1) {
+    taucs_printf("taucs_open: Could not open data file %s\n",filename);
+    return -1;
+  }
+  if (io_multifile_set_file(h,*file_index,file_id) == -1)
+    return -1;
+  if (io_read_full(h->f[*file_index],(char*)value+first_size,size-first_size) 
+      != size-first_size){ 
+    taucs_printf("taucs_open: Error in open data .\n");
+    return -1;
+  }
+  *curr_file_offset = (double)(size-first_size);
+  return 0;
+}
+
 int   taucs_io_close(taucs_io_handle* f)
 {
   int i;
@@ -677,11 +1667,11 @@ int   taucs_io_close(taucs_io_handle* f)
   /*off_t offset; omer*/
   ssize_t nbytes;
   double curr_file_offset;
-  mode_t mode;
-  mode_t perm;
   char filename[256];
   int file_id;
-  int first_size;
+
+  /* the metadata is written unaligned, through the page cache */
+  taucs_io_set_direct(f,0);
 
   if (f->type == IO_TYPE_SINGLEFILE) {
     taucs_io_handle_singlefile* h = ((taucs_io_handle_singlefile*) f->type_specific);
@@ -703,8 +1693,8 @@ int   taucs_io_close(taucs_io_handle* f)
       return -1;
     }
     /* writing start offset of metadata */
-    nbytes = write(h->f,&(h->last_offset), sizeof(int));
-    if (nbytes != sizeof(int)) { 
+    nbytes = write(h->f,&(h->last_offset), sizeof(off_t));
+    if (nbytes != sizeof(off_t)) { 
       taucs_printf("taucs_close: Error writing metadata.\n");
       return -1;
     }
@@ -734,6 +1724,13 @@ int   taucs_io_close(taucs_io_handle* f)
 	taucs_printf("taucs_close: Error writing data (%s:%d).\n",__FILE__,__LINE__);
 	return -1;
       }
+      if (IO_IS_COMPRESSED(matrices[i].flags)) {
+	nbytes = write(h->f,&matrices[i].csize, sizeof(taucs_int64));
+	if (nbytes != sizeof(taucs_int64)) { 
+	  taucs_printf("taucs_close: Error writing data (%s:%d).\n",__FILE__,__LINE__);
+	  return -1;
+	}
+      }
     }
     taucs_free(matrices);
   }
@@ -761,25 +1758,11 @@ int   taucs_io_close(taucs_io_handle* f)
 	return -1;
     }
 
-    curr_file_offset = h->last_offset - (h->last_created_file)*(IO_FILE_RESTRICTION*1024.0*1024.0);
-    if(!((int)curr_file_offset)){
-      sprintf(filename,"%s.%d",h->basename,(h->last_created_file+1));
-#ifdef OSTYPE_win32
-      mode = _O_RDWR | _O_CREAT | _O_BINARY;
-      perm = _S_IREAD | _S_IWRITE | _S_IEXEC;
-#else
-      mode = O_RDWR | O_CREAT;
-      perm = 0644;
-#endif
-
-      file_id = open(filename,mode,perm);
-      
-      if (file_id == -1) {
-	taucs_printf("taucs_close: Could not create metadata file %s\n",filename);
+    curr_file_offset = h->last_offset - (double)(h->last_created_file)*IO_FILE_BYTES;
+    if(curr_file_offset == IO_FILE_BYTES){
+      if (io_multifile_create_file(h,h->last_created_file+1) == -1)
 	return -1;
-      }
-      h->last_created_file++;
-	h->f[h->last_created_file] = file_id;
+      curr_file_offset = 0.0;
     }
     else
       if (lseek(h->f[h->last_created_file],(off_t) curr_file_offset, SEEK_SET) == -1) {
@@ -789,169 +1772,16 @@ int   taucs_io_close(taucs_io_handle* f)
     
     /* writing metadata  for every matrix */
     for(i=0; i<f->nmatrices; i++){
-      /* write m */
-      if(curr_file_offset+(double)sizeof(int)<IO_FILE_RESTRICTION*1024.0*1024.0){
-	nbytes = write(h->f[h->last_created_file],&(matrices[i].m),sizeof(int));
-	if (nbytes != sizeof(int)){ 
-	  taucs_printf("taucs_close: Error writing data (%s:%d).\n",__FILE__,__LINE__);
-	  return -1;
-	}
-	curr_file_offset += (double)sizeof(int);
-      }
-      else{
-	first_size = IO_FILE_RESTRICTION*1024*1024 - (int)curr_file_offset;
-	nbytes = write(h->f[h->last_created_file],&(matrices[i].m),first_size);
-	/*if (nbytes != first_size) { omer*/
-	if ((int)nbytes != first_size) { 
-	  taucs_printf("taucs_close: Error writing data .\n");
-	  return -1;
-	}
-	sprintf(filename,"%s.%d",h->basename,(h->last_created_file+1));
-
-#ifdef OSTYPE_win32
-	mode = _O_RDWR | _O_CREAT | _O_BINARY;
-	perm = _S_IREAD | _S_IWRITE | _S_IEXEC;
-#else
-	mode = O_RDWR | O_CREAT;
-	perm = 0644;
-#endif
-
-	file_id = open(filename,mode,perm);
-	
-	if (file_id == -1) {
-	  taucs_printf("taucs_close: Could not create metadata file %s\n",filename);
-	  return -1;
-	}
-	h->last_created_file++;
-	h->f[h->last_created_file] = file_id;
-	nbytes = write(h->f[h->last_created_file],(char*)&(matrices[i].m)+first_size,sizeof(int)-first_size);
-	if (nbytes != sizeof(int)-first_size){ 
-	  taucs_printf("taucs_close: Error writing data .\n");
-	  return -1;
-	}
-	curr_file_offset = (double)(sizeof(int)-first_size);
-      }
-      /* write n */
-      if(curr_file_offset+(double)sizeof(int)<IO_FILE_RESTRICTION*1024.0*1024.0){
-	nbytes = write(h->f[h->last_created_file],&(matrices[i].n),sizeof(int));
-	if (nbytes != sizeof(int)){ 
-	  taucs_printf("taucs_close: Error writing data .\n");
-	  return -1;
-	}
-	curr_file_offset += (double)sizeof(int);
-      }
-      else{
-	first_size = IO_FILE_RESTRICTION*1024*1024 - (int)curr_file_offset;
-	nbytes = write(h->f[h->last_created_file],&(matrices[i].n),first_size);
-	/*if (nbytes != first_size) { omer*/
-	if ((int)nbytes != first_size) { 
-	  taucs_printf("taucs_close: Error writing data .\n");
-	  return -1;
-	}
-	sprintf(filename,"%s.%d",h->basename,(h->last_created_file+1));
-#ifdef OSTYPE_win32
-	mode = _O_RDWR | _O_CREAT | _O_BINARY;
-	perm = _S_IREAD | _S_IWRITE | _S_IEXEC;
-#else
-	mode = O_RDWR | O_CREAT;
-	perm = 0644;
-#endif
-	file_id = open(filename,mode,perm);
-	
-	if (file_id == -1) {
-	  taucs_printf("taucs_close: Could not create metadata file %s\n",filename);
-	  return -1;
-	}
-	h->last_created_file++;
-	h->f[h->last_created_file] = file_id;
-	nbytes = write(h->f[h->last_created_file],(char*)&(matrices[i].n)+first_size,sizeof(int)-first_size);
-	if (nbytes != sizeof(int)-first_size){ 
-	  taucs_printf("taucs_close: Error writing data .\n");
-	  return -1;
-	}
-	curr_file_offset = (double)(sizeof(int)-first_size);
-      }
-      
-      /* write flags */
-      if(curr_file_offset+(double)sizeof(int)<IO_FILE_RESTRICTION*1024.0*1024.0){
-	nbytes = write(h->f[h->last_created_file],&(matrices[i].flags),sizeof(int));
-	if (nbytes != sizeof(int)){ 
-	  taucs_printf("taucs_close: Error writing data .\n");
-	  return -1;
-	}
-	curr_file_offset += (double)sizeof(int);
-      }
-      else{
-	first_size = IO_FILE_RESTRICTION*1024*1024 - (int)curr_file_offset;
-	nbytes = write(h->f[h->last_created_file],&(matrices[i].flags),first_size);
-	/*if (nbytes != first_size) { omer*/
-	if ((int)nbytes != first_size) { 
-	  taucs_printf("taucs_close: Error writing data .\n");
-	  return -1;
-	}
-	sprintf(filename,"%s.%d",h->basename,(h->last_created_file+1));
-#ifdef OSTYPE_win32
-	mode = _O_RDWR | _O_CREAT | _O_BINARY;
-	perm = _S_IREAD | _S_IWRITE | _S_IEXEC;
-#else
-	mode = O_RDWR | O_CREAT;
-	perm = 0644;
-#endif
-	file_id = open(filename,mode,perm);
-	
-	if (file_id == -1) {
-	  taucs_printf("taucs_close: Could not create metadata file %s\n",filename);
-	  return -1;
-	}
-	h->last_created_file++;
-	h->f[h->last_created_file] = file_id;
-	nbytes = write(h->f[h->last_created_file],(char*)&(matrices[i].flags)+first_size,sizeof(int)-first_size);
-	if (nbytes != sizeof(int)-first_size){ 
-	    taucs_printf("taucs_close: Error writing data .\n");
-	    return -1;
-	}
-	curr_file_offset = (double)(sizeof(int)-first_size);
-      }
-      /* write offset */
-      if(curr_file_offset+(double)sizeof(double)<IO_FILE_RESTRICTION*1024.0*1024.0){
-	nbytes = write(h->f[h->last_created_file],&(matrices[i].offset),sizeof(double));
-	if (nbytes != sizeof(double)){ 
-	  taucs_printf("taucs_close: Error writing data .\n");
-	  return -1;
-	}
-	curr_file_offset += (double)sizeof(double);
-      }
-      else{
-	first_size = IO_FILE_RESTRICTION*1024*1024 - (int)curr_file_offset;
-	nbytes = write(h->f[h->last_created_file],&(matrices[i].offset),first_size);
-	/*if (nbytes != first_size) { omer*/
-	if ((int)nbytes != first_size) { 
-	  taucs_printf("taucs_close: Error writing data .\n");
-	  return -1;
-	}
-	sprintf(filename,"%s.%d",h->basename,(h->last_created_file+1));
-#ifdef OSTYPE_win32
-	mode = _O_RDWR | _O_CREAT | _O_BINARY;
-	perm = _S_IREAD | _S_IWRITE | _S_IEXEC;
-#else
-	mode = O_RDWR | O_CREAT;
-	perm = 0644;
-#endif
-
-	file_id = open(filename,mode,perm);
-	if (file_id == -1) {
-	  taucs_printf("taucs_close: Could not create metadata file %s\n",filename);
-	    return -1;
-	}
-	h->last_created_file++;
-	h->f[h->last_created_file] = file_id;
-	nbytes = write(h->f[h->last_created_file],(char*)&(matrices[i].offset)+first_size,sizeof(double)-first_size);
-	  if (nbytes != sizeof(double)-first_size){ 
-	    taucs_printf("taucs_close: Error writing data .\n");
-	    return -1;
-	  }
-	  curr_file_offset = (double)(sizeof(double)-first_size);
-      }
+      if (io_multifile_write_field(h,&curr_file_offset,&(matrices[i].m),     sizeof(int))    == -1
+	  || io_multifile_write_field(h,&curr_file_offset,&(matrices[i].n),     sizeof(int))    == -1
+	  || io_multifile_write_field(h,&curr_file_offset,&(matrices[i].flags), sizeof(int))    == -1
+	  || io_multifile_write_field(h,&curr_file_offset,&(matrices[i].offset),sizeof(double)) == -1)
+	return -1;
+      /* write compressed size */
+      if (IO_IS_COMPRESSED(matrices[i].flags)
+	  && io_multifile_write_field(h,&curr_file_offset,&(matrices[i].csize),
+				      sizeof(taucs_int64)) == -1)
+	return -1;
     }
     for(i=0;i<=h->last_created_file;i++){
       file_id=close(h->f[i]);
@@ -961,8 +1791,17 @@ int   taucs_io_close(taucs_io_handle* f)
 	return -1;
       }
     }
+    taucs_free(h->f);
     taucs_free(matrices);
   }
+
+  if (f->type == IO_TYPE_STRIPED) {
+    if (io_striped_close(f) == -1) {
+      taucs_free(f->type_specific);
+      taucs_free(f);
+      return -1;
+    }
+  }
   
   taucs_free(f->type_specific);
   taucs_free(f);
@@ -1005,6 +1844,8 @@ taucs_io_handle* taucs_io_open_singlefile(char* filename)
   }
   hs = h->type_specific;
   hs->f = f;
+  h->compress = 0;
+  h->direct   = NULL;
  
   if (lseek(hs->f, strlen(TAUCS_FILE_SIGNATURE), SEEK_SET) == -1) {
     taucs_printf("taucs_open: lseek failed\n");
@@ -1015,8 +1856,8 @@ taucs_io_handle* taucs_io_open_singlefile(char* filename)
     taucs_printf("taucs_open: Error read data .\n");
     return NULL;
   }
-  nbytes = read(hs->f, &hs->last_offset, sizeof(int));
-  if (nbytes != sizeof(int)) { 
+  nbytes = read(hs->f, &hs->last_offset, sizeof(off_t));
+  if (nbytes != sizeof(off_t)) { 
     taucs_printf("taucs_open: Error read data .\n");
     return NULL;
   }
@@ -1051,6 +1892,14 @@ taucs_io_handle* taucs_io_open_singlefile(char* filename)
       taucs_printf("taucs_open: Error writing data .\n");
       return NULL;
     }
+    hs->matrices[i].csize = -1;
+    if (IO_IS_COMPRESSED(hs->matrices[i].flags)) {
+      nbytes = read(hs->f,&hs->matrices[i].csize, sizeof(taucs_int64));
+      if (nbytes != sizeof(taucs_int64)) { 
+	taucs_printf("taucs_open: Error writing data .\n");
+	return NULL;
+      }
+    }
   }
   return h;
 }
@@ -1067,7 +1916,6 @@ taucs_io_handle* taucs_io_open_multifile(char* basename)
   char filename[256];
   int start_file_index;
   double curr_file_offset;
-  int first_size;
 
   sprintf(filename,"%s.%d",basename,0);
 #ifdef OSTYPE_win32
@@ -1095,7 +1943,12 @@ taucs_io_handle* taucs_io_open_multifile(char* basename)
     return NULL;
   }
   hs = h->type_specific;
-  hs->f[0] = file_id;
+  hs->f  = NULL;
+  hs->nf = 0;
+  hs->last_created_file = 0;
+  if (io_multifile_set_file(hs,0,file_id) == -1) return NULL;
+  h->compress = 0;
+  h->direct   = NULL;
   strcpy(hs->basename,basename);
  
   if (lseek(hs->f[0], strlen(TAUCS_FILE_SIGNATURE), SEEK_SET) == -1) {
@@ -1120,7 +1973,7 @@ taucs_io_handle* taucs_io_open_multifile(char* basename)
     hs->matrices = NULL;
 
   /* open all files before including start */
-  start_file_index = (int)floor(((hs->last_offset)/(IO_FILE_RESTRICTION*1024*1024)));
+  start_file_index = (int)floor(((hs->last_offset)/IO_FILE_BYTES));
   hs->last_created_file = start_file_index;
   for(i=0;i<=start_file_index;i++){
     sprintf(filename,"%s.%d",hs->basename,i);
@@ -1129,10 +1982,10 @@ taucs_io_handle* taucs_io_open_multifile(char* basename)
       taucs_printf("taucs_open: Could not open data file %s\n",filename);
       return NULL;
     }
-    hs->f[i] = file_id;
+    if (io_multifile_set_file(hs,i,file_id) == -1) return NULL;
   }
   
-  curr_file_offset = hs->last_offset - start_file_index*(IO_FILE_RESTRICTION*1024.0*1024.0);
+  curr_file_offset = hs->last_offset - (double)start_file_index*IO_FILE_BYTES;
   /* seek of start offset of data */
   if (lseek(hs->f[start_file_index],(off_t) curr_file_offset, SEEK_SET) == -1) {
     taucs_printf("taucs_open: lseek failed\n");
@@ -1140,137 +1993,22 @@ taucs_io_handle* taucs_io_open_multifile(char* basename)
   }
   /* reading metadata  for every matrix */
   for(i=0; i<h->nmatrices; i++){
-    /* read m */
-    if((int)(curr_file_offset+sizeof(int))<IO_FILE_RESTRICTION*1024*1024){
-      nbytes = read(hs->f[start_file_index],&hs->matrices[i].m,sizeof(int));
-      if (nbytes != sizeof(int)){ 
-	taucs_printf("taucs_open: Error in open data .\n");
-	return NULL;
-      }
-      curr_file_offset += (double)sizeof(int);
-    }
-    else{
-      first_size = IO_FILE_RESTRICTION*1024*1024 - (int)curr_file_offset;
-      nbytes = read(hs->f[start_file_index],&hs->matrices[i].m,first_size);
-      /*if (nbytes != first_size) { omer*/
-			if ((int)nbytes != first_size) { 
-				taucs_printf("taucs_open: Error in open data .\n");
-				return NULL;
-      }
-      start_file_index++;
-      sprintf(filename,"%s.%d",hs->basename,start_file_index);
-      file_id = open(filename,mode);
-      if (file_id == -1) {
-	taucs_printf("taucs_open: Could not open data file %s\n",filename);
-	return NULL;
-      }
-      hs->f[start_file_index] = file_id;
-      nbytes = read( hs->f[start_file_index],(char*)&hs->matrices[i].m+first_size,sizeof(int)-first_size);
-      if (nbytes != sizeof(int)-first_size){ 
-	taucs_printf("taucs_open: Error in open data .\n");
-	    return NULL;
-      }
-      curr_file_offset = (double)(sizeof(int)-first_size);
-    }
-
-    /* read n */
-    if((int)(curr_file_offset+sizeof(int))<IO_FILE_RESTRICTION*1024*1024){
-      nbytes = read(hs->f[start_file_index],&hs->matrices[i].n,sizeof(int));
-      if (nbytes != sizeof(int)){ 
-	taucs_printf("taucs_open: Error in open data .\n");
-	return NULL;
-      }
-      curr_file_offset += (double)sizeof(int);
-    }
-    else{
-      first_size = IO_FILE_RESTRICTION*1024*1024 - (int)curr_file_offset;
-      nbytes = read(hs->f[start_file_index],&hs->matrices[i].n,first_size);
-      /*if (nbytes != first_size) { omer*/
-			if ((int)nbytes != first_size) { 
-				taucs_printf("taucs_open: Error in open data .\n");
-				return NULL;
-      }
-      start_file_index++;
-      sprintf(filename,"%s.%d",hs->basename,start_file_index);
-      file_id = open(filename,mode);
-      if (file_id == -1) {
-	taucs_printf("taucs_open: Could not open data file %s\n",filename);
-	return NULL;
-      }
-      hs->f[start_file_index] = file_id;
-      nbytes = read( hs->f[start_file_index],(char*)&hs->matrices[i].n+first_size,sizeof(int)-first_size);
-      if (nbytes != sizeof(int)-first_size){ 
-	taucs_printf("taucs_open: Error in open data .\n");
-	    return NULL;
-      }
-      curr_file_offset = (double)(sizeof(int)-first_size);
-    }
-
-    /* read flags */
-    if((int)(curr_file_offset+sizeof(int))<IO_FILE_RESTRICTION*1024*1024){
-      nbytes = read(hs->f[start_file_index],&hs->matrices[i].flags,sizeof(int));
-      if (nbytes != sizeof(int)){ 
-	taucs_printf("taucs_open: Error in open data .\n");
-	return NULL;
-      }
-      curr_file_offset += (double)sizeof(int);
-    }
-    else{
-      first_size = IO_FILE_RESTRICTION*1024*1024 - (int)curr_file_offset;
-      nbytes = read(hs->f[start_file_index],&hs->matrices[i].flags,first_size);
-      /*if (nbytes != first_size) { omer*/
-			if ((int)nbytes != first_size) { 
-	taucs_printf("taucs_open: Error in open data .\n");
-	return NULL;
-      }
-      start_file_index++;
-      sprintf(filename,"%s.%d",hs->basename,start_file_index);
-      file_id = open(filename,mode);
-      if (file_id == -1) {
-	taucs_printf("taucs_open: Could not open data file %s\n",filename);
-	return NULL;
-      }
-      hs->f[start_file_index] = file_id;
-      nbytes = read( hs->f[start_file_index],(char*)&hs->matrices[i].flags+first_size,sizeof(int)-first_size);
-      if (nbytes != sizeof(int)-first_size){ 
-	taucs_printf("taucs_open: Error in open data .\n");
-	    return NULL;
-      }
-      curr_file_offset = (double)(sizeof(int)-first_size);
-    }
+    if (io_multifile_read_field(hs,&start_file_index,&curr_file_offset,
+				&hs->matrices[i].m,     sizeof(int))    == -1
+	|| io_multifile_read_field(hs,&start_file_index,&curr_file_offset,
+				   &hs->matrices[i].n,     sizeof(int))    == -1
+	|| io_multifile_read_field(hs,&start_file_index,&curr_file_offset,
+				   &hs->matrices[i].flags, sizeof(int))    == -1
+	|| io_multifile_read_field(hs,&start_file_index,&curr_file_offset,
+				   &hs->matrices[i].offset,sizeof(double)) == -1)
+      return NULL;
 
-    /* read offset */
-    if((int)(curr_file_offset+sizeof(double))<IO_FILE_RESTRICTION*1024*1024){
-      nbytes = read(hs->f[start_file_index],&hs->matrices[i].offset,sizeof(double));
-      if (nbytes != sizeof(double)){ 
-	taucs_printf("taucs_open: Error in open data .\n");
-	return NULL;
-      }
-      curr_file_offset += (double)sizeof(double);
-    }
-    else{
-      first_size = IO_FILE_RESTRICTION*1024*1024 - (int)curr_file_offset;
-      nbytes = read(hs->f[start_file_index],&hs->matrices[i].offset,first_size);
-      /*if (nbytes != first_size) { omer*/
-			if ((int)nbytes != first_size) { 
-				taucs_printf("taucs_open: Error in open data .\n");
-				return NULL;
-      }
-      start_file_index++;
-      sprintf(filename,"%s.%d",hs->basename,start_file_index);
-      file_id = open(filename,mode);
-      if (file_id == -1) {
-	taucs_printf("taucs_open: Could not open data file %s\n",filename);
-	return NULL;
-      }
-      hs->f[start_file_index] = file_id;
-      nbytes = read( hs->f[start_file_index],(char*)&hs->matrices[i].offset+first_size,sizeof(double)-first_size);
-      if (nbytes != sizeof(double)-first_size){ 
-	taucs_printf("taucs_open: Error in open data .\n");
-	return NULL;
-      }
-      curr_file_offset = (double)(sizeof(double)-first_size);
-    }
+    /* read compressed size */
+    hs->matrices[i].csize = -1;
+    if (IO_IS_COMPRESSED(hs->matrices[i].flags)
+	&& io_multifile_read_field(hs,&start_file_index,&curr_file_offset,
+				   &hs->matrices[i].csize,sizeof(taucs_int64)) == -1)
+      return NULL;
   }
 
   return h;
@@ -1284,6 +2022,8 @@ int taucs_io_delete(taucs_io_handle* f)
 
   taucs_printf("taucs_io_delete: starting\n");
 
+  taucs_io_set_direct(f,0);
+
   if (f->type == IO_TYPE_SINGLEFILE) {
     taucs_printf("taucs_io_delete: delete only works on multifile; delete singlefile directly\n");
     return -1;
@@ -1302,6 +2042,22 @@ int taucs_io_delete(taucs_io_handle* f)
     }
 
     taucs_free(h->matrices);
+    taucs_free(h->f);
+  }
+  if (f->type == IO_TYPE_STRIPED) {
+    taucs_io_handle_striped* h = ((taucs_io_handle_striped*) f->type_specific);
+
+    for (i=0; i < h->ndevices; i++) {
+      close((h->f)[i]);
+      (h->f)[i] = -1;
+      sprintf(filename,"%s.%d",h->basenames[i],i);
+      if (unlink(filename) == -1) {
+	taucs_printf("taucs_io_delete: could not delete <%s>\n",filename);
+	return_code = -1;
+      }
+    }
+
+    io_striped_release(h);
   }
   
   taucs_free(f->type_specific);
@@ -1328,9 +2084,140 @@ char* taucs_io_get_basename(taucs_io_handle* f)
     taucs_io_handle_multifile* h = ((taucs_io_handle_multifile*) f->type_specific);
     return h->basename;
   }
+  if (f->type == IO_TYPE_STRIPED) {
+    taucs_io_handle_striped* h = ((taucs_io_handle_striped*) f->type_specific);
+    return h->basenames[0];
+  }
   return NULL;
 }
 
+/*********************************************************/
+/* SET_COMPRESSION                                       */
+/* Matrices appended while compression is on are stored  */
+/* compressed; reads decompress them transparently.      */
+/*********************************************************/
+
+int taucs_io_set_compression(taucs_io_handle* f, int compress)
+{
+  int old = f->compress;
+  f->compress = compress;
+  return old;
+}
+
+/*********************************************************/
+/* SET_DIRECT                                            */
+/* While direct I/O is on, matrices bypass the page      */
+/* cache, in aligned blocks staged through one buffer.   */
+/* Offsets in the index table stay exact, so the files   */
+/* can be read either way. If the file system does not   */
+/* support direct I/O, the handle stays buffered.        */
+/*********************************************************/
+
+static int io_set_direct_all(taucs_io_handle* f, int direct)
+{
+  int i;
+
+  if (f->type == IO_TYPE_SINGLEFILE) {
+    taucs_io_handle_singlefile* h = ((taucs_io_handle_singlefile*) f->type_specific);
+    return io_fd_set_direct(h->f,direct);
+  }
+  if (f->type == IO_TYPE_MULTIFILE) {
+    taucs_io_handle_multifile* h = ((taucs_io_handle_multifile*) f->type_specific);
+    for (i=0; i<=h->last_created_file; i++) {
+      if (io_fd_set_direct(h->f[i],direct) == -1) {
+	/* undo the files already switched */
+	while (--i >= 0) io_fd_set_direct(h->f[i],!direct);
+	return -1;
+      }
+    }
+  }
+  if (f->type == IO_TYPE_STRIPED) {
+    taucs_io_handle_striped* h = ((taucs_io_handle_striped*) f->type_specific);
+    for (i=0; i<h->ndevices; i++) {
+      if (io_fd_set_direct(h->f[i],direct) == -1) {
+	while (--i >= 0) io_fd_set_direct(h->f[i],!direct);
+	return -1;
+      }
+    }
+  }
+  return 0;
+}
+
+/* a striped handle has a staging buffer per device, so they can work at once */
+
+static int io_direct_count(taucs_io_handle* f)
+{
+  if (f->type == IO_TYPE_STRIPED)
+    return ((taucs_io_handle_striped*) f->type_specific)->ndevices;
+  return 1;
+}
+
+int taucs_io_set_direct(taucs_io_handle* f, int direct)
+{
+  taucs_io_direct* d = (taucs_io_direct*) f->direct;
+  int old = (d != NULL);
+  int n = io_direct_count(f);
+  int i,ok;
+  size_t base;
+
+  if (direct && !old) {
+    d  = (taucs_io_direct*) taucs_calloc(n,sizeof(taucs_io_direct));
+    ok = (d != NULL);
+    for (i=0; ok && i<n; i++) {
+      d[i].buffer = (char*) taucs_malloc(IO_DIRECT_STAGING + 2*IO_DIRECT_ALIGN);
+      ok = (d[i].buffer != NULL);
+    }
+    if (!ok)
+      taucs_printf("taucs_io_set_direct: out of memory\n");
+    else if (io_set_direct_all(f,1) == -1) {
+      taucs_printf("taucs_io_set_direct: direct I/O not supported, using buffered I/O\n");
+      ok = 0;
+    }
+    if (!ok) {
+      for (i=0; d && i<n; i++) taucs_free(d[i].buffer);
+      taucs_free(d);
+      return old;
+    }
+    for (i=0; i<n; i++) {
+      base = ((size_t) d[i].buffer + IO_DIRECT_ALIGN - 1) & ~((size_t) IO_DIRECT_ALIGN - 1);
+      d[i].stage       = (char*) base;
+      d[i].tail        = d[i].stage + IO_DIRECT_STAGING;
+      d[i].tail_fd     = -1;
+      d[i].tail_offset = 0;
+    }
+    f->direct = d;
+  }
+
+  if (!direct && old) {
+    io_set_direct_all(f,0);
+    for (i=0; i<n; i++) taucs_free(d[i].buffer);
+    taucs_free(d);
+    f->direct = NULL;
+  }
+
+  return old;
+}
+
+/*********************************************************/
+/* SET_PARALLEL                                          */
+/* A striped handle with parallel I/O on transfers to    */
+/* all its devices at once, in PFUNC threads. The PFUNC  */
+/* runtime must be initialized. Other handles ignore it. */
+/*********************************************************/
+
+int taucs_io_set_parallel(taucs_io_handle* f, int parallel)
+{
+  taucs_io_handle_striped* h;
+  int old;
+
+  if (f->type != IO_TYPE_STRIPED) return 0;
+  h = ((taucs_io_handle_striped*) f->type_specific);
+  old = h->parallel;
+#ifdef TAUCS_CONFIG_PFUNC
+  h->parallel = parallel;
+#endif
+  return old;
+}
 
 /*************************************************************/
 /*                                                           */
@@ -196,6 +196,8 @@ int taucs_multiqr_get_perb_number(taucs_multiqr_factor *F);
 
 void taucs_multiqr_get_perb_indices(taucs_multiqr_factor *F, int *indices);
 
+double taucs_multiqr_get_peak_memory(taucs_multiqr_factor *F);
+
 void taucs_multiqr_factor_free(taucs_multiqr_factor* F);
 
 
@@ -233,8 +235,8 @@ double         taucs_dtl(abs_fn)(taucs_datatype a);
 
 /*** taucs_ccs_base.c ***/
 
-taucs_ccs_matrix* taucs_dtl(ccs_create)          (int m, int n, int nnz);
-taucs_ccs_matrix* taucs_ccs_create               (int m, int n, int nnz, int flags);
+taucs_ccs_matrix* taucs_dtl(ccs_create)          (int m, int n, taucs_index nnz);
+taucs_ccs_matrix* taucs_ccs_create               (int m, int n, taucs_index nnz, int flags);
 void              taucs_dtl(ccs_free)            (taucs_ccs_matrix* matrix);
 void              taucs_ccs_free                 (taucs_ccs_matrix* matrix);
 
@@ -254,6 +256,9 @@ taucs_ccs_matrix* taucs_dtl(ccs_permute_symmetrically)(taucs_ccs_matrix* A,
 taucs_ccs_matrix*     taucs_ccs_permute_symmetrically (taucs_ccs_matrix* A, 
 						       int* perm, int* invperm);
 
+taucs_ccs_matrix* taucs_dtl(ccs_threshold_drop)(taucs_ccs_matrix* A, double droptol);
+taucs_ccs_matrix*     taucs_ccs_threshold_drop (taucs_ccs_matrix* A, double droptol);
+
 void              taucs_dtl(ccs_times_vec)       (taucs_ccs_matrix* m, 
 						  taucs_datatype* X,
 						  taucs_datatype* B);
@@ -296,6 +301,10 @@ taucs_ccs_matrix *taucs_ccs_find_ata_pattern(taucs_ccs_matrix *A);
 
 /*** taucs_ccs_io.c ***/
 
+/* set in the flags of a binary matrix file whose colptr is taucs_int64 */
+#define TAUCS_BINARY_INDEX64 0x40000000
+
+
 int               taucs_dtl(ccs_write_ijv)       (taucs_ccs_matrix* matrix, 
 						  char* filename);
 int                    taucs_ccs_write_ijv       (taucs_ccs_matrix* matrix, 
@@ -331,6 +340,19 @@ taucs_ccs_matrix* taucs_ccs_factor_llt_partial   (taucs_ccs_matrix* A,
 taucs_ccs_matrix* taucs_dtl(ccs_factor_llt_partial)(taucs_ccs_matrix* A, 
 						    int p);
 
+/*** taucs_sn_ic.c ***/
+
+taucs_ccs_matrix* taucs_dtl(ccs_factor_sn_ic)    (taucs_ccs_matrix* A,
+						  int levels, double droptol,
+						  int modified);
+taucs_ccs_matrix*     taucs_ccs_factor_sn_ic     (taucs_ccs_matrix* A,
+						  int levels, double droptol,
+						  int modified);
+taucs_ccs_matrix* taucs_dtl(ccs_factor_sn_llt_partial)(taucs_ccs_matrix* A,
+						       int p);
+taucs_ccs_matrix*     taucs_ccs_factor_sn_llt_partial(taucs_ccs_matrix* A,
+						       int p);
+
 taucs_ccs_matrix* taucs_dtl(ccs_factor_ldlt)     (taucs_ccs_matrix* A);
 taucs_ccs_matrix*     taucs_ccs_factor_ldlt      (taucs_ccs_matrix* A);
 
@@ -340,6 +362,10 @@ taucs_ccs_matrix* taucs_dtl(ccs_factor_xxt)      (taucs_ccs_matrix* A);
 
 int               taucs_ccs_solve_llt            (void* L, void* x, void* b);
 int               taucs_dtl(ccs_solve_llt)       (void* L, taucs_datatype* x, taucs_datatype* b);
+void*             taucs_ccs_solve_llt_analyze    (taucs_ccs_matrix* L, int nproc);
+void              taucs_ccs_solve_llt_schedule_free(void* S);
+int               taucs_ccs_solve_llt_scheduled  (void* S, void* x, void* b);
+int               taucs_dtl(ccs_solve_llt_scheduled)(void* S, taucs_datatype* x, taucs_datatype* b);
 int               taucs_ccs_solve_ldlt           (void* L, void* x, void* b);
 int               taucs_dtl(ccs_solve_ldlt)      (void* L, taucs_datatype* x, taucs_datatype* b);
 int               taucs_ccs_solve_schur          (taucs_ccs_matrix* L,
@@ -374,6 +400,25 @@ taucs_ccs_matrix* taucs_ccs_generate_discontinuous(int X, int Y, int Z,
 						   double jump);
 double* taucs_vec_generate_continuous            (int X, int Y, int Z, char* which);
 
+int taucs_dtl(conjugate_gradients_info)          (taucs_ccs_matrix*  A,
+						  int               (*precond_fn)(void*,void* x,void* b),
+						  void*             precond_args,
+						  taucs_datatype*   X,
+						  taucs_datatype*   B,
+						  taucs_iter_info*  info);
+int taucs_conjugate_gradients_info               (taucs_ccs_matrix*  A,
+						  int               (*precond_fn)(void*,void* x,void* b),
+						  void*             precond_args,
+						  void*             X,
+						  void*             B,
+						  taucs_iter_info*  info);
+int taucs_dtl(conjugate_gradients)               (taucs_ccs_matrix*  A,
+						  int               (*precond_fn)(void*,void* x,void* b),
+						  void*             precond_args,
+						  taucs_datatype*   X,
+						  taucs_datatype*   B,
+						  int               itermax,
+						  double            convergetol);
 int taucs_conjugate_gradients                    (taucs_ccs_matrix*  A,
 						  int               (*precond_fn)(void*,void* x,void* b),
 						  void*             precond_args,
@@ -393,6 +438,25 @@ int taucs_parallel_conjugate_gradients                    (taucs_ccs_matrix*  A,
 							   int nproc);
 #endif
 
+int taucs_dtl(minres_info)                       (taucs_ccs_matrix*  A,
+						  int               (*precond_fn)(void*,void* x,void* b),
+						  void*             precond_args,
+						  taucs_datatype*   X,
+						  taucs_datatype*   B,
+						  taucs_iter_info*  info);
+int taucs_minres_info                            (taucs_ccs_matrix*  A,
+						  int               (*precond_fn)(void*,void* x,void* b),
+						  void*             precond_args,
+						  void*             X,
+						  void*             B,
+						  taucs_iter_info*  info);
+int taucs_dtl(minres)                            (taucs_ccs_matrix*  A,
+						  int               (*precond_fn)(void*,void* x,void* b),
+						  void*             precond_args,
+						  taucs_datatype*   X,
+						  taucs_datatype*   B,
+						  int               itermax,
+						  double            convergetol);
 int taucs_minres                                 (taucs_ccs_matrix*  A,
 						  int               (*precond_fn)(void*,void* x,void* b),
 						  void*             precond_args,
@@ -401,6 +465,39 @@ int taucs_minres                                 (taucs_ccs_matrix*  A,
 						  int               itermax,
 						  double            convergetol);
 
+/* unsymmetric Krylov solvers - taucs_gmres.c */
+
+int taucs_dtl(gmres)                             (taucs_ccs_matrix*  A,
+						  int               (*precond_fn)(void*,void* x,void* b),
+						  void*             precond_args,
+						  taucs_datatype*   X,
+						  taucs_datatype*   B,
+						  int               restart,
+						  int               itermax,
+						  double            convergetol);
+int taucs_gmres                                  (taucs_ccs_matrix*  A,
+						  int               (*precond_fn)(void*,void* x,void* b),
+						  void*             precond_args,
+						  void*             X,
+						  void*             B,
+						  int               restart,
+						  int               itermax,
+						  double            convergetol);
+int taucs_dtl(bicgstab)                          (taucs_ccs_matrix*  A,
+						  int               (*precond_fn)(void*,void* x,void* b),
+						  void*             precond_args,
+						  taucs_datatype*   X,
+						  taucs_datatype*   B,
+						  int               itermax,
+						  double            convergetol);
+int taucs_bicgstab                               (taucs_ccs_matrix*  A,
+						  int               (*precond_fn)(void*,void* x,void* b),
+						  void*             precond_args,
+						  void*             X,
+						  void*             B,
+						  int               itermax,
+						  double            convergetol);
+
 int taucs_sg_preconditioner_solve                (void*   P,
 						  double* z, 
 						  double* r);
@@ -412,12 +509,30 @@ void *taucs_sg_preconditioner_create             (taucs_ccs_matrix *A,
 						  char *specification);
 void taucs_sg_preconditioner_free                (void* P);
 
+void* taucs_amg_preconditioner_create            (taucs_ccs_matrix* A,
+						  int    maxlevels,
+						  int    coarse_size,
+						  double theta,
+						  int    sweeps,
+						  int    nproc);
+int   taucs_amg_preconditioner_solve             (void* P,
+						  void* Z,
+						  void* R);
+void  taucs_amg_preconditioner_free              (void* P);
+
 taucs_ccs_matrix*
 taucs_amwb_preconditioner_create                 (taucs_ccs_matrix *symccs_mtxA, 
 						  int rnd,
 						  double subgraphs,
 						  int stretch_flag,
 						  int amwb_flag);
+taucs_ccs_matrix*
+taucs_amwb_preconditioner_create_parallel        (taucs_ccs_matrix *symccs_mtxA, 
+						  int rnd,
+						  double subgraphs,
+						  int stretch_flag,
+						  int amwb_flag,
+						  int nproc);
 
 void* 
 taucs_recursive_amwb_preconditioner_create       (taucs_ccs_matrix* A, 
@@ -434,12 +549,14 @@ int
 taucs_recursive_amwb_preconditioner_solve        (void* P, 
 						  void* Z, 
 						  void* R);
+void
+taucs_recursive_amwb_preconditioner_free         (void* P);
 
 int taucs_dtl(ccs_etree)                         (taucs_ccs_matrix* A,
 						  int* parent,
 						  int* l_colcount,
 						  int* l_rowcount,
-						  int* l_nnz);
+						  taucs_index* l_nnz);
 
 int      
 taucs_dtl(ccs_symbolic_elimination)              (taucs_ccs_matrix* A,
@@ -457,6 +574,8 @@ taucs_cilk void* taucs_dtl(ccs_factor_llt_mf_maxdepth)      (taucs_ccs_matrix* A
 void* taucs_dtl(ccs_factor_llt_ll)               (taucs_ccs_matrix* A);
 void* taucs_dtl(ccs_factor_llt_ll_maxdepth)      (taucs_ccs_matrix* A,int max_depth);
 int   taucs_dtl(supernodal_solve_llt)            (void* vL, void* x, void* b);
+taucs_cilk int taucs_dtl(ccs_factor_llt_mf_batch)    (int nmatrices, taucs_ccs_matrix** A, void** L);
+taucs_cilk int taucs_dtl(supernodal_solve_llt_batch) (int nmatrices, void** L, void** X, void** B);
 void taucs_dtl(supernodal_factor_free)                (void* L);
 void taucs_dtl(supernodal_factor_free_numeric)        (void* L);
 taucs_ccs_matrix* taucs_dtl(supernodal_factor_to_ccs) (void* L);
@@ -471,19 +590,29 @@ void* taucs_dtl(ccs_factor_ldlt_symbolic)         (taucs_ccs_matrix* A);
 void* taucs_dtl(ccs_factor_ldlt_symbolic_maxdepth)(taucs_ccs_matrix* A,int max_depth);
 int taucs_ccs_ldlt_symbolic_elimination(taucs_ccs_matrix* A,void* vL,int do_order,int max_depth);
 
-void* taucs_dtl(ccs_factor_ldlt_mf)               (taucs_ccs_matrix* A);
-void* taucs_dtl(ccs_factor_ldlt_mf_maxdepth)      (taucs_ccs_matrix* A,int max_depth);
+taucs_cilk void* taucs_dtl(ccs_factor_ldlt_mf)    (taucs_ccs_matrix* A);
+taucs_cilk void* taucs_dtl(ccs_factor_ldlt_mf_maxdepth)(taucs_ccs_matrix* A,int max_depth);
 void* taucs_dtl(ccs_factor_ldlt_symbolic_maxdepth)(taucs_ccs_matrix* A, int max_depth);
-void* taucs_ccs_factor_ldlt_mf                    (taucs_ccs_matrix* A);
-void* taucs_ccs_factor_ldlt_mf_maxdepth           (taucs_ccs_matrix* A,int max_depth);
+taucs_cilk void* taucs_ccs_factor_ldlt_mf         (taucs_ccs_matrix* A);
+taucs_cilk void* taucs_ccs_factor_ldlt_mf_maxdepth(taucs_ccs_matrix* A,int max_depth);
+taucs_cilk void* taucs_dtl(ccs_factor_ldlt_mf_pivoting)(taucs_ccs_matrix* A,int max_depth,
+						       double alpha,double beta,double perturb);
+taucs_cilk void* taucs_ccs_factor_ldlt_mf_pivoting(taucs_ccs_matrix* A,int max_depth,
+						   double alpha,double beta,double perturb);
 void* taucs_ccs_factor_ldlt_symbolic_maxdepth			(taucs_ccs_matrix* A,int max_depth);
 void* taucs_dtl(ccs_factor_ldlt_ll)               (taucs_ccs_matrix* A);
 void* taucs_dtl(ccs_factor_ldlt_ll_maxdepth)      (taucs_ccs_matrix* A,int max_depth);
 void* taucs_ccs_factor_ldlt_ll_maxdepth           (taucs_ccs_matrix* A,int max_depth);
+void* taucs_dtl(ccs_factor_ldlt_ll_pivoting)(taucs_ccs_matrix* A,int max_depth,
+					    double alpha,double beta,double perturb);
+void* taucs_ccs_factor_ldlt_ll_pivoting(taucs_ccs_matrix* A,int max_depth,
+					double alpha,double beta,double perturb);
+void  taucs_supernodal_factor_ldlt_set_pivoting(void* L,
+						double alpha,double beta,double perturb);
 
 
-int   taucs_dtl(ccs_factor_ldlt_numeric)          (taucs_ccs_matrix* A,void* L);
-int   taucs_ccs_factor_ldlt_numeric               (taucs_ccs_matrix* A,void* L);
+taucs_cilk int   taucs_dtl(ccs_factor_ldlt_numeric)(taucs_ccs_matrix* A,void* L);
+taucs_cilk int   taucs_ccs_factor_ldlt_numeric     (taucs_ccs_matrix* A,void* L);
 void taucs_supernodal_factor_ldlt_free            (void* L);
 void taucs_dtl(supernodal_factor_ldlt_free)(void* vL);
 void taucs_supernodal_factor_ldlt_free_numeric    (void* L);
@@ -491,18 +620,19 @@ void taucs_dtl(supernodal_factor_ldlt_free_numeric)(void* vL);
 
 int   taucs_dtl(supernodal_solve_ldlt)            (void* vL, void* x, void* b);
 int   taucs_supernodal_solve_ldlt                 (void* vL, void* x, void* b);
-void	taucs_dtl(get_statistics)										(int* pbytes,double* pflops,
+void	taucs_dtl(get_statistics)										(double* pbytes,double* pflops,
 																									 double* pnnz,void* vL);
-void	taucs_get_statistics(int* pbytes,double* pflops,double* pnnz,void* vL);
+void	taucs_get_statistics(double* pbytes,double* pflops,double* pnnz,void* vL);
 void	taucs_dtl(inertia_calc)(void* vL, int* inertia);
 void	taucs_inertia_calc(void* vL, int* inertia);
-int taucs_supernodal_solve_ldlt_many(void *L,int n,void* X, int ld_X,void* B, int ld_B);
-int taucs_dtl(supernodal_solve_ldlt_many) (void* L ,int n,void* X, int ld_X, void* B, int ld_B);
+taucs_cilk int taucs_supernodal_solve_ldlt_many(void *L,int n,void* X, int ld_X,void* B, int ld_B);
+taucs_cilk int taucs_dtl(supernodal_solve_ldlt_many) (void* L ,int n,void* X, int ld_X, void* B, int ld_B);
 
 int taucs_dtl(internal_supernodal_front_factor_ldlt)(void* fct,taucs_datatype* F1,
 																								taucs_datatype* F2,taucs_datatype* DB,
 																								int* db_size,int sn_size,
-																								int up_size,int sn,int alg);
+																								int up_size,int sn,int alg,
+																								void* piv);
 
 /* taucs_ccs_ooc_ldlt */
 int taucs_dtl(ooc_factor_ldlt)(taucs_ccs_matrix* A,taucs_io_handle*  L,double memory);
@@ -521,7 +651,7 @@ int taucs_ccs_etree                              (taucs_ccs_matrix* A,
 						  int* parent,
 						  int* l_colcount,
 						  int* l_rowcount,
-						  int* l_nnz);
+						  taucs_index* l_nnz);
 
 int      
 taucs_ccs_symbolic_elimination                   (taucs_ccs_matrix* A,
@@ -539,6 +669,8 @@ taucs_cilk void* taucs_ccs_factor_llt_mf_maxdepth           (taucs_ccs_matrix* A
 void* taucs_ccs_factor_llt_ll                    (taucs_ccs_matrix* A);
 void* taucs_ccs_factor_llt_ll_maxdepth           (taucs_ccs_matrix* A,int max_depth);
 int   taucs_supernodal_solve_llt                 (void* vL, void* x, void* b);
+taucs_cilk int taucs_ccs_factor_llt_mf_batch          (int nmatrices, taucs_ccs_matrix** A, void** L);
+taucs_cilk int taucs_supernodal_solve_llt_batch       (int nmatrices, void** L, void** X, void** B);
 void taucs_supernodal_factor_free                (void* L);
 void taucs_supernodal_factor_free_numeric        (void* L);
 taucs_ccs_matrix* taucs_supernodal_factor_to_ccs (void* L);
@@ -600,6 +732,23 @@ taucs_double taucs_dtl(norm_1)(taucs_ccs_matrix *A);
 
 void   taucs_logfile(char* file_prefix);
 int    taucs_printf(char *fmt, ...);
+
+/* log levels; messages above the current level are dropped */
+#define TAUCS_LOG_ERROR   0
+#define TAUCS_LOG_INFO    1 /* the level of taucs_printf and the default */
+#define TAUCS_LOG_DEBUG   2 /* per-iteration and per-step progress       */
+
+/* subsystems, or'ed together in taucs_log_set_mask */
+#define TAUCS_LOG_GENERAL 1 /* everything written by taucs_printf */
+#define TAUCS_LOG_ITER    2 /* iterative solvers                  */
+#define TAUCS_LOG_OOC     4 /* out-of-core factorizations         */
+#define TAUCS_LOG_ALL     0x7fffffff
+
+int    taucs_log(int subsystem, int level, char* fmt, ...);
+int    taucs_log_enabled(int subsystem, int level);
+void   taucs_log_set_level(int level);
+void   taucs_log_set_mask(int mask);
+void   taucs_log_flush(void);
 int    taucs_maximize_stacksize(void);
 double taucs_system_memory_size(void);
 double taucs_available_memory_size(void);
@@ -616,6 +765,9 @@ taucs_io_handle* taucs_io_open_singlefile(char* filename);
 taucs_io_handle* taucs_io_create_multifile(char* filename);
 taucs_io_handle* taucs_io_open_multifile(char* filename);
 
+taucs_io_handle* taucs_io_create_striped(char* basenames);
+taucs_io_handle* taucs_io_open_striped(char* basenames);
+
 int              taucs_io_close (taucs_io_handle* f);
 int              taucs_io_delete(taucs_io_handle* f);
 
@@ -645,6 +797,9 @@ int              taucs_io_read_try(taucs_io_handle* f,
 			       );
 
 char*            taucs_io_get_basename(taucs_io_handle* f);
+int              taucs_io_set_compression(taucs_io_handle* f, int compress);
+int              taucs_io_set_direct(taucs_io_handle* f, int direct);
+int              taucs_io_set_parallel(taucs_io_handle* f, int parallel);
 
 /*********************************************************/
 /* Out-of-core Sparse Choleksy routines                  */
@@ -653,6 +808,16 @@ char*            taucs_io_get_basename(taucs_io_handle* f);
 int taucs_dtl(ooc_factor_llt)(taucs_ccs_matrix* A, 
 			      taucs_io_handle*  L,
 			      double memory);
+/* nproc threads apply the panel updates; needs TAUCS_CONFIG_PFUNC */
+int taucs_dtl(ooc_factor_llt_parallel)(taucs_ccs_matrix* A, 
+				       taucs_io_handle*  L,
+				       double memory,
+				       int nproc);
+/* A is read from a taucs_ccs_write_binary file, never held whole */
+int taucs_dtl(ooc_factor_llt_file)(char* filename, 
+				   taucs_io_handle*  L,
+				   double memory,
+				   int nproc);
 /*added omer*/
 int taucs_dtl(ooc_factor_llt_panelchoice)(taucs_ccs_matrix* A, 
 					  taucs_io_handle* handle,
@@ -661,12 +826,31 @@ int taucs_dtl(ooc_factor_llt_panelchoice)(taucs_ccs_matrix* A,
 /* end omer*/
 int taucs_dtl(ooc_solve_llt) (void* L /* actual type: taucs_io_handle* */,
 			      void* x, void* b);
+/* block RHS; memory bounds the supernodes kept between the sweeps */
+int taucs_dtl(ooc_solve_llt_many)(void* L, int n,
+				  void* X, int ld_X, void* B, int ld_B);
+int taucs_dtl(ooc_solve_llt_many_cached)(void* L, int n,
+					 void* X, int ld_X, void* B, int ld_B,
+					 double memory);
 
 int taucs_ooc_factor_llt(taucs_ccs_matrix* A, 
 			 taucs_io_handle*  L,
 			 double memory);
+int taucs_ooc_factor_llt_parallel(taucs_ccs_matrix* A, 
+				  taucs_io_handle*  L,
+				  double memory,
+				  int nproc);
+int taucs_ooc_factor_llt_file(char* filename, 
+			      taucs_io_handle*  L,
+			      double memory,
+			      int nproc);
 int taucs_ooc_solve_llt (void* L /* actual type: taucs_io_handle* */,
 			 void* x, void* b);
+int taucs_ooc_solve_llt_many(void* L, int n,
+			     void* X, int ld_X, void* B, int ld_B);
+int taucs_ooc_solve_llt_many_cached(void* L, int n,
+				    void* X, int ld_X, void* B, int ld_B,
+				    double memory);
 
 /*********************************************************/
 /* Out-of-core Sparse LU                                 */
@@ -676,11 +860,22 @@ int taucs_dtl(ooc_factor_lu)(taucs_ccs_matrix* A_in,
 		              int    colperm[],
                               taucs_io_handle* LU,
   	                      double memory);
+/* nproc threads apply the dense supernode updates; needs TAUCS_CONFIG_PFUNC */
+int taucs_dtl(ooc_factor_lu_parallel)(taucs_ccs_matrix* A_in,
+				      int    colperm[],
+				      taucs_io_handle* LU,
+				      double memory,
+				      int    nproc);
 
 int  taucs_ooc_factor_lu     (taucs_ccs_matrix* A_in,
 		              int*   colperm,
                               taucs_io_handle* LU,
   	                      double memory);
+int  taucs_ooc_factor_lu_parallel(taucs_ccs_matrix* A_in,
+				  int*   colperm,
+				  taucs_io_handle* LU,
+				  double memory,
+				  int    nproc);
 
 int taucs_dtl(ooc_solve_lu)(taucs_io_handle*   LU,
 			    taucs_datatype* x, 
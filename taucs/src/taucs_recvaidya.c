@@ -24,6 +24,7 @@ typedef struct {
   taucs_ccs_matrix** B;
   taucs_ccs_matrix** S;
   taucs_ccs_matrix** L;
+  double**        work; /* per-level vectors for the Schur solves */
   int             levels;
   int             level;
   double          convratio;
@@ -215,6 +216,7 @@ taucs_recursive_amwb_preconditioner_create(taucs_ccs_matrix* A,
 
   taucs_ccs_matrix** S; /* Schur complements                        */
   taucs_ccs_matrix** L; /* Partial LL^T factors                     */
+  double**          W; /* Workspace for the Schur complement solves */
 
   double exponent = 1.0/(1.0+epsilon);
 
@@ -234,16 +236,23 @@ taucs_recursive_amwb_preconditioner_create(taucs_ccs_matrix* A,
   args = (recvaidya_args*) taucs_malloc(sizeof(recvaidya_args));
   S    = (taucs_ccs_matrix**) taucs_malloc(32 * sizeof(taucs_ccs_matrix*));
   L    = (taucs_ccs_matrix**) taucs_malloc(32 * sizeof(taucs_ccs_matrix*));
+  W    = (double**) taucs_malloc(32 * sizeof(double*));
 
   *perm    = (int*) taucs_malloc(A->n * sizeof(int));
   *invperm = (int*) taucs_malloc(A->n * sizeof(int));
   tmpperm = *invperm;
-  assert(args && *perm && *invperm);
+  assert(args && S && L && W && *perm && *invperm);
 
   for (i=0; i<A->n; i++) (*perm)[i] = (*invperm)[i] = i;
 
-  for (l=0; l<32; l++)
+  for (l=0; l<32; l++) {
     S[l] = L[l] = NULL;
+    W[l] = NULL;
+  }
+
+  args->S = S;
+  args->L = L;
+  args->work = W;
   
   for (l=0; l<maxlevels; l++) {
 
@@ -323,9 +332,12 @@ taucs_recursive_amwb_preconditioner_create(taucs_ccs_matrix* A,
       for (i=N-n ; i<N   ; i++) backperm[i] = (N-n) + perml[i-(N-n)];
       for (i=0   ; i<N   ; i++) ibackperm[backperm[i]] = i;
       
+      /* only rows of L_21 move, so L stays lower triangular */
+      L[k-1]->flags = TAUCS_DOUBLE | TAUCS_SYMMETRIC | TAUCS_LOWER;
       PLPT = taucs_ccs_permute_symmetrically(L[k-1],backperm,ibackperm);
       taucs_ccs_free(L[k-1]);
       L[k-1] = PLPT;
+      L[k-1]->flags = TAUCS_DOUBLE | TAUCS_TRIANGULAR | TAUCS_LOWER;
 
       taucs_free(backperm);
       taucs_free(ibackperm);
@@ -347,16 +359,25 @@ taucs_recursive_amwb_preconditioner_create(taucs_ccs_matrix* A,
       taucs_free(ibackperm);
     }
 
+    /* the supernodal code leaves the Schur complement in the */
+    /* trailing columns, so ccs_split can take it apart       */
+    Ll = taucs_ccs_factor_sn_llt_partial(PVPT,p);
+    taucs_ccs_free(PVPT);
+    if (!Ll) {
+      taucs_printf("recvaidya_create: factorization of level %d failed\n",l);
+      taucs_recursive_amwb_preconditioner_free(args);
+      taucs_free(*perm);
+      taucs_free(*invperm);
+      *perm = *invperm = NULL;
+      return NULL;
+    }
     if (p<n) {
-      Ll = taucs_ccs_factor_llt_partial(PVPT,p);
-      taucs_ccs_free(PVPT);
       taucs_ccs_split(Ll,&(L[l]),&(S[l+1]),p);
-      (L[l])   -> flags = TAUCS_TRIANGULAR | TAUCS_LOWER;
-      (S[l+1]) -> flags = TAUCS_SYMMETRIC  | TAUCS_LOWER;
+      (L[l])   -> flags = TAUCS_DOUBLE | TAUCS_TRIANGULAR | TAUCS_LOWER;
+      (S[l+1]) -> flags = TAUCS_DOUBLE | TAUCS_SYMMETRIC  | TAUCS_LOWER;
       taucs_ccs_free(Ll);
     } else {
-      L[l] = taucs_ccs_factor_llt(PVPT,0.0,0);
-      taucs_ccs_free(PVPT);
+      L[l] = Ll;
       break;
     }
 
@@ -373,13 +394,113 @@ taucs_recursive_amwb_preconditioner_create(taucs_ccs_matrix* A,
   args->convratio = convratio;
   args->maxits = innerits;
   args->level  = 0;
-  args->S = S;
-  args->L = L;
+
+  /* the inner iterations run on every application of the preconditioner, */
+  /* so their vectors are allocated once here: y (n), and r, z, d, q on   */
+  /* the Schur complement                                                  */
+  for (l=0; l<levels-1; l++) {
+    W[l] = (double*) taucs_malloc((L[l]->n + 4*S[l+1]->n) * sizeof(double));
+    if (!W[l]) {
+      taucs_recursive_amwb_preconditioner_free(args);
+      taucs_free(*perm);
+      taucs_free(*invperm);
+      *perm = *invperm = NULL;
+      return NULL;
+    }
+  }
 
   return args;
   
 }
 
+/*
+  Applies level P->level, which is not the last: solves L_11 y_1 = b_1,
+  runs preconditioned CG on the Schur complement with the next level as
+  the preconditioner, and then solves L_11^T x_1 = y_1 - L_21^T x_2.
+  This is taucs_ccs_solve_schur, but the vectors come from the
+  workspace of the level rather than from the heap.
+*/
+
+static void
+recvaidya_schur_solve(recvaidya_args* P, double* x, double* b)
+{
+  taucs_ccs_matrix* L  = (P->L)[P->level];
+  taucs_ccs_matrix* SC = (P->S)[(P->level) + 1];
+  recvaidya_args args;
+  int     n,m,p,i,j,ip,iter;
+  double* y;
+  double *r, *z, *d, *q;
+  double  rho, rho0 = 0.0, alpha, dq, res, res0;
+
+  n = L->n;
+  m = SC->n;
+  p = n - m;
+
+  y = (P->work)[P->level];
+  r = y + n;
+  z = r + m;
+  d = z + m;
+  q = d + m;
+
+  for (i=0; i<n; i++) x[i] = b[i];
+
+  /* Solve L y = b = x; the diagonal comes first in each column */
+
+  for (j=0; j<p; j++) {
+    ip = (L->colptr)[j];
+    y[j] = x[j] / (L->values.d)[ip];
+    for (ip++; ip < (L->colptr)[j+1]; ip++)
+      x[ (L->rowind)[ip] ] -= y[j] * (L->values.d)[ip];
+  }
+  for (i=p; i<n; i++) y[i] = x[i];
+
+  /* Now solve x_2 <- (A_22 - L_21 L_21^T)^-1 y_2, starting from 0 */
+
+  args       = *P; /* copy the data but modify next level! */
+  args.level = (P->level) + 1;
+
+  res0 = 0.0;
+  for (i=0; i<m; i++) {
+    x[p+i] = 0.0;
+    r[i]   = y[p+i];
+    res0  += r[i]*r[i];
+  }
+  res0 = sqrt(res0);
+
+  for (iter=0; iter < (int)(P->maxits) && res0 > 0.0; iter++) {
+    taucs_recursive_amwb_preconditioner_solve(&args,z,r);
+
+    for (i=0, rho=0.0; i<m; i++) rho += r[i]*z[i];
+    if (iter == 0)
+      for (i=0; i<m; i++) d[i] = z[i];
+    else
+      for (i=0; i<m; i++) d[i] = z[i] + (rho/rho0) * d[i];
+
+    taucs_ccs_times_vec(SC,d,q);
+
+    for (i=0, dq=0.0; i<m; i++) dq += d[i]*q[i];
+    if (dq == 0.0) break;
+    alpha = rho / dq;
+
+    for (i=0, res=0.0; i<m; i++) {
+      x[p+i] += alpha * d[i];
+      r[i]   -= alpha * q[i];
+      res    += r[i]*r[i];
+    }
+    rho0 = rho;
+
+    if (sqrt(res) <= (P->convratio) * res0) break;
+  }
+
+  /* Now we have x_2, solve L_11^T x_1 = y_1 - L_21^T x_2 */
+
+  for (i=p-1; i>=0; i--) {
+    for (ip = (L->colptr)[i]+1; ip < (L->colptr)[i+1]; ip++)
+      y[i] -= x[ (L->rowind)[ip] ] * (L->values.d)[ip];
+    x[i] = y[i] / (L->values.d)[ (L->colptr)[i] ];
+  }
+}
+
 int
 taucs_recursive_amwb_preconditioner_solve(void* vP,
 					  void* vZ, 
@@ -388,7 +509,6 @@ taucs_recursive_amwb_preconditioner_solve(void* vP,
   recvaidya_args* P = (recvaidya_args*) vP;
   double* Z = (double*) vZ;
   double* R = (double*) vR;
-  recvaidya_args args;
 
   if ( P->level == (P->levels)-1 ) {
     /* this is the last level, L is a complete factor */
@@ -406,20 +526,30 @@ taucs_recursive_amwb_preconditioner_solve(void* vP,
 	       P->level,P->levels);
     */
 
-    args       = *P; /* copy the data but modify next level! */
-    args.level = (P->level) + 1;
-    
-    taucs_ccs_solve_schur((P->L)[P->level],
-			  (P->S)[(P->level) + 1],
-			  taucs_recursive_amwb_preconditioner_solve,
-			  &args,
-			  (int)(P->maxits),
-			  (P->convratio),
-			  Z, R);
+    recvaidya_schur_solve(P, Z, R);
   }
   return 0;
 }
 
+void
+taucs_recursive_amwb_preconditioner_free(void* vP)
+{
+  recvaidya_args* P = (recvaidya_args*) vP;
+  int l;
+
+  if (!P) return;
+
+  for (l=0; l<32; l++) {
+    taucs_ccs_free((P->L)[l]);
+    taucs_ccs_free((P->S)[l]);
+    taucs_free((P->work)[l]);
+  }
+  taucs_free(P->L);
+  taucs_free(P->S);
+  taucs_free(P->work);
+  taucs_free(P);
+}
+
 #endif /* TAUCS_CORE */  
 		      
 
@@ -0,0 +1,852 @@
+/*********************************************************/
+/* TAUCS                                                 */
+/* Supernodal incomplete Cholesky factorization          */
+/*********************************************************/
+
+/*
+  An incomplete LL^T factorization that works on dense blocks.
+
+  The sparsity pattern is fixed in advance, either by level of fill
+  (IC(k)) or, when no level limit is given, as the pattern of the
+  complete factor. Consecutive columns with nested patterns are merged
+  into supernodes, possibly accepting a little extra fill, and each
+  supernode is stored as a dense block. The numeric phase is a
+  left-looking supernodal factorization: updates are computed with GEMM
+  and scattered into the target block; update entries that fall outside
+  the target's pattern are dropped. After all the updates to a supernode
+  are in, rows of its off-diagonal block whose entries are all below
+  droptol (relative to the column norms) are dropped, and the diagonal
+  block is factored with POTRF and the rest with TRSM.
+
+  With modified != 0, dropped entries are added to the diagonal, to
+  preserve row sums, as in taucs_ccs_factor_llt.
+
+  taucs_ccs_factor_sn_llt_partial uses the same machinery with the
+  complete pattern to eliminate only a leading set of columns; the
+  trailing supernodes collect the updates but are not factored, and
+  end up holding the Schur complement.
+
+  All the state is local to the call. The factor is returned as a
+  lower-triangular ccs matrix, the same as taucs_ccs_factor_llt, so it
+  can be used with taucs_ccs_solve_llt.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <math.h>
+#include "taucs.h"
+
+#define FALSE 0
+#define TRUE  1
+
+/* updates smaller than this (in multiply-adds) do not call the BLAS */
+#define IC_BLAS_CUTOFF 1000
+
+/* merge a column into a supernode if at most this fraction of the */
+/* supernode's entries become explicit zeros                      */
+#define IC_RELAX_FRACTION 0.2
+
+#ifndef TAUCS_CORE_GENERAL
+
+typedef struct {
+  int   n;
+  int   n_sn;
+  int*  first_col;   /* first column of each supernode, n_sn+1 entries */
+  int*  col_to_sn;
+  int*  nrows;       /* number of rows in each supernode's block       */
+  int** rows;        /* sorted; the first rows are the supernode's own */
+                     /* columns                                        */
+  taucs_datatype** blocks; /* column major, leading dimension nrows    */
+} ic_factor;
+
+/*********************************************************/
+/* symbolic phase                                        */
+/*********************************************************/
+
+static int
+ic_compare_ints(const void* vx, const void* vy)
+{
+  int x = *((const int*) vx);
+  int y = *((const int*) vy);
+  return (x > y) - (x < y);
+}
+
+/*
+  Computes the pattern of the incomplete factor, column by column.
+  Entries of A have level 0, and a fill entry (i,j) created through
+  column k has level lev(i,k)+lev(j,k)+1. Entries with level above
+  levels are not in the pattern; levels < 0 means no limit, which gives
+  the pattern of the complete factor. Only columns 0..p-1 are
+  eliminated; with p < n, columns p..n-1 get the pattern of the Schur
+  complement. The rows of each column are sorted and the diagonal
+  comes first.
+*/
+
+static int
+ic_pattern(taucs_ccs_matrix* A, int levels, int p_elim,
+	   taucs_index** pcolptr, int** prowind)
+{
+  int  n = A->n;
+  int  i,j,k,l,len,lkj;
+  taucs_index p,q,ip;
+  taucs_index nnz, size;
+  taucs_index* colptr;
+  int* rowind;
+  int* lev;
+  int* colof;   /* the column of each pattern entry */
+  taucs_index* next; /* links entries of the same row */
+  taucs_index* head;
+  int* mark;
+  int* levw;
+  int* list;
+
+  *pcolptr = NULL;
+  *prowind = NULL;
+
+  size   = 2*(A->colptr[n]) + n;
+  colptr = (taucs_index*) taucs_malloc((n+1) * sizeof(taucs_index));
+  rowind = (int*) taucs_malloc(size  * sizeof(int));
+  lev    = (int*) taucs_malloc(size  * sizeof(int));
+  colof  = (int*) taucs_malloc(size  * sizeof(int));
+  next   = (taucs_index*) taucs_malloc(size  * sizeof(taucs_index));
+  head   = (taucs_index*) taucs_malloc(n     * sizeof(taucs_index));
+  mark   = (int*) taucs_malloc(n     * sizeof(int));
+  levw   = (int*) taucs_malloc(n     * sizeof(int));
+  list   = (int*) taucs_malloc(n     * sizeof(int));
+
+  if (!colptr || !rowind || !lev || !colof || !next
+      || !head || !mark || !levw || !list) {
+    taucs_free(colptr); taucs_free(rowind); taucs_free(lev);
+    taucs_free(colof);  taucs_free(next);   taucs_free(head);
+    taucs_free(mark);   taucs_free(levw);   taucs_free(list);
+    return -1;
+  }
+
+  for (i=0; i<n; i++) {
+    head[i] = -1;
+    mark[i] = -1;
+  }
+
+  nnz = 0;
+  for (j=0; j<n; j++) {
+    colptr[j] = nnz; /* column j-1 ends here, and the fill loop needs it */
+    len = 0;
+    mark[j] = j; levw[j] = 0; list[len++] = j;
+
+    for (ip = (A->colptr)[j]; ip < (A->colptr)[j+1]; ip++) {
+      i = (A->rowind)[ip];
+      if (i <= j || mark[i] == j) continue;
+      mark[i] = j; levw[i] = 0; list[len++] = i;
+    }
+
+    /* fill through the columns k<j with (j,k) in the pattern */
+    for (p = head[j]; p != -1; p = next[p]) {
+      k   = colof[p];
+      lkj = lev[p];
+      if (levels >= 0 && lkj >= levels) continue; /* too deep for any fill */
+      for (q = colptr[k]; q < colptr[k+1]; q++) {
+	i = rowind[q];
+	if (i <= j) continue;
+	l = lev[q] + lkj + 1;
+	if (levels >= 0 && l > levels) continue;
+	if (mark[i] != j) {
+	  mark[i] = j; levw[i] = l; list[len++] = i;
+	} else if (l < levw[i])
+	  levw[i] = l;
+      }
+    }
+
+    qsort(list+1, len-1, sizeof(int), ic_compare_ints);
+
+    if (nnz + len > size) {
+      taucs_index newsize = max( (taucs_index) floor(1.25 * (double) size), nnz + len );
+      void* t;
+
+      t = taucs_realloc(rowind, newsize*sizeof(int));
+      if (t) rowind = (int*) t;
+      if (t) { t = taucs_realloc(lev,   newsize*sizeof(int)); if (t) lev   = (int*) t; }
+      if (t) { t = taucs_realloc(colof, newsize*sizeof(int)); if (t) colof = (int*) t; }
+      if (t) { t = taucs_realloc(next,  newsize*sizeof(taucs_index)); if (t) next = (taucs_index*) t; }
+      if (!t) {
+	taucs_free(colptr); taucs_free(rowind); taucs_free(lev);
+	taucs_free(colof);  taucs_free(next);   taucs_free(head);
+	taucs_free(mark);   taucs_free(levw);   taucs_free(list);
+	return -1;
+      }
+      size = newsize;
+    }
+
+    for (ip=0; ip<len; ip++) {
+      i = list[ip];
+      rowind[nnz] = i;
+      lev   [nnz] = levw[i];
+      colof [nnz] = j;
+      /* with no level limit, the pattern of the complete factor only */
+      /* needs the children of each column in the elimination tree,  */
+      /* except that a column whose parent is not eliminated must    */
+      /* reach all of its rows.                                      */
+      if (i > j && j < p_elim
+	  && (levels >= 0 || ip == 1 || list[1] >= p_elim)) {
+	next[nnz] = head[i];
+	head[i]   = nnz;
+      }
+      nnz++;
+    }
+  }
+  colptr[n] = nnz;
+
+  taucs_free(lev);
+  taucs_free(colof);
+  taucs_free(next);
+  taucs_free(head);
+  taucs_free(mark);
+  taucs_free(levw);
+  taucs_free(list);
+
+  *pcolptr = colptr;
+  *prowind = rowind;
+  return 0;
+}
+
+static void
+ic_factor_free(ic_factor* F)
+{
+  int J;
+
+  if (!F) return;
+  if (F->rows)
+    for (J=0; J<F->n_sn; J++) taucs_free(F->rows[J]);
+  if (F->blocks)
+    for (J=0; J<F->n_sn; J++) taucs_free(F->blocks[J]);
+  taucs_free(F->first_col);
+  taucs_free(F->col_to_sn);
+  taucs_free(F->nrows);
+  taucs_free(F->rows);
+  taucs_free(F->blocks);
+  taucs_free(F);
+}
+
+/*
+  Partitions the columns into supernodes. Column j joins the current
+  supernode if j is in the supernode's row set, and if merging the
+  pattern of j into it keeps the fraction of explicit zeros small.
+  No supernode contains both column p-1 and column p.
+*/
+
+static ic_factor*
+ic_supernodes(int n, int p_elim, taucs_index* colptr, int* rowind)
+{
+  ic_factor* F;
+  int  j,s,ip,len,r,nr,ncols,missing,added,J;
+  int* S;      /* rows of the current supernode */
+  int* T;
+  int  S_len;
+  double entries, zeros, new_zeros;
+
+  F = (ic_factor*) taucs_malloc(sizeof(ic_factor));
+  if (!F) return NULL;
+  F->n         = n;
+  F->n_sn      = 0;
+  F->first_col = (int*) taucs_malloc((n+1) * sizeof(int));
+  F->col_to_sn = (int*) taucs_malloc(n     * sizeof(int));
+  F->nrows     = (int*) taucs_malloc(n     * sizeof(int));
+  F->rows      = (int**) taucs_calloc(n, sizeof(int*));
+  F->blocks    = (taucs_datatype**) taucs_calloc(n, sizeof(taucs_datatype*));
+  S            = (int*) taucs_malloc(n * sizeof(int));
+  T            = (int*) taucs_malloc(n * sizeof(int));
+  if (!F->first_col || !F->col_to_sn || !F->nrows || !F->rows || !F->blocks
+      || !S || !T) {
+    F->n_sn = n;
+    ic_factor_free(F);
+    taucs_free(S); taucs_free(T);
+    return NULL;
+  }
+
+  s = 0;
+  S_len = 0;
+  entries = zeros = 0.0;
+  for (j=0; j<=n; j++) {
+    if (j < n && j > s && j != p_elim && (j-s) < S_len && S[j-s] == j) {
+      /* count rows of S (from j down) that j lacks, and rows of j that S lacks */
+      len = (int) (colptr[j+1] - colptr[j]);
+      missing = added = 0;
+      nr = 0;
+      {
+	int a = j-s;
+	taucs_index b = colptr[j];
+	while (a < S_len || b < colptr[j+1]) {
+	  if (b == colptr[j+1] || (a < S_len && S[a] < rowind[b])) {
+	    T[nr++] = S[a++]; missing++;
+	  } else if (a == S_len || rowind[b] < S[a]) {
+	    T[nr++] = rowind[b++]; added++;
+	  } else {
+	    T[nr++] = S[a++]; b++;
+	  }
+	}
+      }
+      ncols     = j - s;
+      new_zeros = (double) missing + (double) added * (double) ncols;
+      if (zeros + new_zeros
+	  <= IC_RELAX_FRACTION * (entries + (double) len + new_zeros)) {
+	zeros   += new_zeros;
+	entries += (double) len + new_zeros;
+	for (ip=0; ip<nr; ip++) S[j-s+ip] = T[ip];
+	S_len = j - s + nr;
+	continue;
+      }
+    }
+
+    /* close the current supernode */
+    if (j > s) {
+      J = F->n_sn;
+      F->first_col[J] = s;
+      F->nrows[J]     = S_len;
+      F->rows[J]      = (int*) taucs_malloc(S_len * sizeof(int));
+      if (!F->rows[J]) {
+	F->n_sn++;
+	ic_factor_free(F);
+	taucs_free(S); taucs_free(T);
+	return NULL;
+      }
+      for (ip=0; ip<S_len; ip++) F->rows[J][ip] = S[ip];
+      for (r=s; r<j; r++) F->col_to_sn[r] = J;
+      F->n_sn++;
+    }
+    if (j == n) break;
+
+    /* start a new supernode at j */
+    s = j;
+    S_len = (int) (colptr[j+1] - colptr[j]);
+    for (ip=0; ip<S_len; ip++) S[ip] = rowind[colptr[j]+ip];
+    entries = (double) S_len;
+    zeros   = 0.0;
+  }
+  F->first_col[F->n_sn] = n;
+
+  taucs_free(S);
+  taucs_free(T);
+  return F;
+}
+
+/*********************************************************/
+/* numeric phase                                         */
+/*********************************************************/
+
+/*
+  W = L_K(p:nK-1,:) * L_K(p:q-1,:)^H, where L_K is the nK-by-k block
+  of a supernode. W is (nK-p)-by-(q-p) with leading dimension nK-p.
+*/
+
+static void
+ic_update(taucs_datatype* LK, int nK, int k, int p, int q,
+	  taucs_datatype* W)
+{
+  int m = nK - p;
+  int c = q - p;
+  int i,j,t;
+  taucs_datatype v;
+
+  if ((double) m * (double) c * (double) k < IC_BLAS_CUTOFF) {
+    for (j=0; j<c; j++) {
+      for (i=j; i<m; i++) {
+	v = taucs_zero_const;
+	for (t=0; t<k; t++)
+	  v = taucs_add(v, taucs_mul(LK[t*nK+p+i], taucs_conj(LK[t*nK+p+j])));
+	W[j*m+i] = v;
+      }
+    }
+    return;
+  }
+
+  taucs_gemm("No Transpose", "Conjugate",
+	     &m, &c, &k,
+	     &taucs_one_const,
+	     LK+p, &nK,
+	     LK+p, &nK,
+	     &taucs_zero_const,
+	     W, &m);
+}
+
+/*
+  Drops the off-diagonal rows of supernode J whose entries are all at
+  most droptol times the norm of their column. Rows that contain
+  entries of A are never dropped.
+*/
+
+static int
+ic_drop_rows(ic_factor* F, int J, double droptol, int modified,
+	     char* in_A, taucs_datatype* comp, double* norms)
+{
+  int  ncols = F->first_col[J+1] - F->first_col[J];
+  int  nrows = F->nrows[J];
+  int* rows  = F->rows[J];
+  taucs_datatype* B = F->blocks[J];
+  int  r,c,keep,next;
+  taucs_datatype v;
+
+  for (c=0; c<ncols; c++) {
+    norms[c] = 0.0;
+    for (r=c; r<nrows; r++) {
+      v = B[c*nrows+r];
+      norms[c] += taucs_re( taucs_mul(v,taucs_conj(v)) );
+    }
+    norms[c] = droptol * sqrt(norms[c]);
+  }
+
+  next = ncols;
+  for (r=ncols; r<nrows; r++) {
+    keep = in_A[r];
+    for (c=0; c<ncols && !keep; c++)
+      if (taucs_abs(B[c*nrows+r]) > norms[c]) keep = TRUE;
+
+    if (!keep) {
+      if (modified) {
+	for (c=0; c<ncols; c++) {
+	  v = B[c*nrows+r];
+	  B[c*nrows+c] = taucs_add(B[c*nrows+c], v);
+	  comp[rows[r]] = taucs_add(comp[rows[r]], v);
+	}
+      }
+      continue;
+    }
+
+    if (next != r) {
+      rows[next] = rows[r];
+      for (c=0; c<ncols; c++) B[c*nrows+next] = B[c*nrows+r];
+    }
+    next++;
+  }
+
+  if (next == nrows) return nrows;
+
+  /* compact the block to the new leading dimension */
+  for (c=0; c<ncols; c++)
+    for (r=0; r<next; r++)
+      B[c*next+r] = B[c*nrows+r];
+  F->nrows[J] = next;
+  return next;
+}
+
+/*
+  When rows are dropped, fill that the static pattern predicts for J
+  may never arrive. This trims the rows of J to those that A and the
+  pending updates (after their own drops) actually reach. map must be
+  -1 on entry; it is restored on exit.
+*/
+
+static void
+ic_trim_rows(taucs_ccs_matrix* A, ic_factor* F, int J,
+	     int* head, int* link, int* ptr, int* map)
+{
+  int  fc    = F->first_col[J];
+  int  lc    = F->first_col[J+1];
+  int  ncols = lc - fc;
+  int  nrows = F->nrows[J];
+  int* rows  = F->rows[J];
+  int  j,i,K,r,len;
+  taucs_index ip;
+
+  for (r=ncols; r<nrows; r++) map[rows[r]] = -2;
+
+  for (j=fc; j<lc; j++)
+    for (ip = (A->colptr)[j]; ip < (A->colptr)[j+1]; ip++) {
+      i = (A->rowind)[ip];
+      if (map[i] == -2) map[i] = -3;
+    }
+
+  for (K = head[J]; K != -1; K = link[K])
+    for (r = ptr[K]; r < F->nrows[K]; r++) {
+      i = F->rows[K][r];
+      if (map[i] == -2) map[i] = -3;
+    }
+
+  len = ncols;
+  for (r=ncols; r<nrows; r++) {
+    i = rows[r];
+    if (map[i] == -3) rows[len++] = i;
+    map[i] = -1;
+  }
+  F->nrows[J] = len;
+}
+
+/*
+  Left-looking supernodal numeric factorization on the pattern in F.
+  Supernodes that start at column p or later receive their updates but
+  are not factored, so they end up holding the Schur complement.
+  Returns 0, or -1 on failure (not positive definite, or no memory).
+*/
+
+static int
+ic_numeric(taucs_ccs_matrix* A, ic_factor* F, int p_elim,
+	   double droptol, int modified, double* pflops)
+{
+  int  n = A->n;
+  int  J,K,nextK,j,c,r,i,p,q,m,fc,lc,ncols,nrows,nK,kK,info,lr;
+  taucs_index ip;
+  int  max_rows = 0, max_cols = 0;
+  int* map;
+  int* head;    /* supernodes waiting to update J      */
+  int* link;
+  int* ptr;     /* first row of K not yet used         */
+  char* in_A;
+  double* norms;
+  taucs_datatype* comp;  /* diagonal compensation (modified) */
+  taucs_datatype* W;
+  taucs_datatype* B;
+  taucs_datatype  v;
+  double flops = 0.0;
+
+  for (J=0; J<F->n_sn; J++) {
+    max_rows = max(max_rows, F->nrows[J]);
+    max_cols = max(max_cols, F->first_col[J+1] - F->first_col[J]);
+  }
+
+  map   = (int*) taucs_malloc(n * sizeof(int));
+  head  = (int*) taucs_malloc(F->n_sn * sizeof(int));
+  link  = (int*) taucs_malloc(F->n_sn * sizeof(int));
+  ptr   = (int*) taucs_malloc(F->n_sn * sizeof(int));
+  in_A  = (char*) taucs_malloc(max_rows * sizeof(char));
+  norms = (double*) taucs_malloc(max_cols * sizeof(double));
+  comp  = (taucs_datatype*) taucs_malloc(n * sizeof(taucs_datatype));
+  W     = (taucs_datatype*) taucs_malloc(max_rows * max_cols * sizeof(taucs_datatype));
+
+  if (!map || !head || !link || !ptr || !in_A || !norms || !comp || !W) {
+    taucs_free(map);  taucs_free(head); taucs_free(link);
+    taucs_free(ptr);  taucs_free(in_A); taucs_free(norms);
+    taucs_free(comp); taucs_free(W);
+    return -1;
+  }
+
+  for (i=0; i<n; i++) {
+    map[i]  = -1;
+    comp[i] = taucs_zero_const;
+  }
+  for (J=0; J<F->n_sn; J++) head[J] = -1;
+
+  for (J=0; J<F->n_sn; J++) {
+    fc    = F->first_col[J];
+    lc    = F->first_col[J+1];
+    ncols = lc - fc;
+    if (droptol > 0.0)
+      ic_trim_rows(A, F, J, head, link, ptr, map);
+    nrows = F->nrows[J];
+
+    B = (taucs_datatype*) taucs_calloc(nrows*ncols, sizeof(taucs_datatype));
+    if (!B) break;
+    F->blocks[J] = B;
+
+    for (r=0; r<nrows; r++) {
+      map[ F->rows[J][r] ] = r;
+      in_A[r] = FALSE;
+    }
+
+    /* gather the columns of A */
+    for (j=fc; j<lc; j++) {
+      c = j - fc;
+      for (ip = (A->colptr)[j]; ip < (A->colptr)[j+1]; ip++) {
+	i  = (A->rowind)[ip];
+	lr = map[i];
+	assert(lr >= c);
+	B[c*nrows+lr] = taucs_add(B[c*nrows+lr], (A->taucs_values)[ip]);
+	if (lr >= ncols) in_A[lr] = TRUE;
+      }
+      if (modified)
+	B[c*nrows+c] = taucs_add(B[c*nrows+c], comp[j]);
+    }
+
+    /* apply the updates from earlier supernodes */
+    for (K = head[J]; K != -1; K = nextK) {
+      nextK = link[K];
+      nK = F->nrows[K];
+      kK = F->first_col[K+1] - F->first_col[K];
+      p  = ptr[K];
+      for (q=p; q<nK && F->rows[K][q] < lc; q++);
+      m  = nK - p;
+
+      ic_update(F->blocks[K], nK, kK, p, q, W);
+      flops += 2.0 * (double) m * (double) (q-p) * (double) kK;
+
+      for (c=0; c<q-p; c++) {
+	j = F->rows[K][p+c] - fc;
+	for (r=c; r<m; r++) {
+	  v  = W[c*m+r];
+	  lr = map[ F->rows[K][p+r] ];
+	  if (lr >= 0)
+	    B[j*nrows+lr] = taucs_sub(B[j*nrows+lr], v);
+	  else if (modified) {
+	    /* the entry is dropped; its value -v goes to both diagonals */
+	    B[j*nrows+j] = taucs_sub(B[j*nrows+j], v);
+	    comp[ F->rows[K][p+r] ] = taucs_sub(comp[ F->rows[K][p+r] ], v);
+	  }
+	}
+      }
+
+      ptr[K] = q;
+      if (q < nK) {
+	int J2 = F->col_to_sn[ F->rows[K][q] ];
+	link[K]  = head[J2];
+	head[J2] = K;
+      }
+    }
+
+    for (r=0; r<nrows; r++) map[ F->rows[J][r] ] = -1;
+
+    if (fc >= p_elim) continue; /* part of the Schur complement */
+
+    if (droptol > 0.0 && nrows > ncols)
+      nrows = ic_drop_rows(F, J, droptol, modified, in_A, comp, norms);
+
+    /* factor the diagonal block and scale the rest */
+    taucs_potrf("Lower", &ncols, B, &nrows, &info);
+    if (info) {
+      taucs_printf("taucs_ccs_factor_sn_ic: not positive definite in column %d\n",
+		   fc + info - 1);
+      break;
+    }
+    if (nrows > ncols) {
+      m = nrows - ncols;
+      taucs_trsm("Right", "Lower", "Conjugate", "No unit diagonal",
+		 &m, &ncols,
+		 &taucs_one_const,
+		 B, &nrows,
+		 B+ncols, &nrows);
+
+      ptr[J] = ncols;
+      K = F->col_to_sn[ F->rows[J][ncols] ];
+      link[J] = head[K];
+      head[K] = J;
+    }
+    flops += (double) ncols * (double) ncols * (double) ncols / 3.0
+           + (double) (nrows-ncols) * (double) ncols * (double) ncols;
+  }
+
+  taucs_free(map);  taucs_free(head); taucs_free(link);
+  taucs_free(ptr);  taucs_free(in_A); taucs_free(norms);
+  taucs_free(comp); taucs_free(W);
+
+  *pflops = flops;
+  return (J == F->n_sn) ? 0 : -1;
+}
+
+static taucs_ccs_matrix*
+ic_factor_to_ccs(ic_factor* F)
+{
+  taucs_ccs_matrix* L;
+  int J,c,r,j,nrows,ncols;
+  taucs_index nnz,next;
+  taucs_datatype* B;
+  taucs_datatype  v;
+
+  nnz = 0;
+  for (J=0; J<F->n_sn; J++) {
+    nrows = F->nrows[J];
+    ncols = F->first_col[J+1] - F->first_col[J];
+    nnz  += (taucs_index) ncols*nrows - ((taucs_index) ncols*(ncols-1))/2;
+  }
+
+  L = taucs_dtl(ccs_create)(F->n, F->n, nnz);
+  if (!L) return NULL;
+  L->flags |= TAUCS_TRIANGULAR | TAUCS_LOWER;
+
+  next = 0;
+  for (J=0; J<F->n_sn; J++) {
+    nrows = F->nrows[J];
+    ncols = F->first_col[J+1] - F->first_col[J];
+    B     = F->blocks[J];
+    for (c=0; c<ncols; c++) {
+      j = F->first_col[J] + c;
+      (L->colptr)[j] = next;
+      /* the diagonal element comes first */
+      for (r=c; r<nrows; r++) {
+	v = B[c*nrows+r];
+	if (r > c && taucs_re(v) == 0.0 && taucs_im(v) == 0.0) continue;
+	(L->rowind)[next]       = F->rows[J][r];
+	(L->taucs_values)[next] = v;
+	next++;
+      }
+    }
+  }
+  (L->colptr)[F->n] = next;
+
+  return L;
+}
+
+taucs_ccs_matrix*
+taucs_dtl(ccs_factor_sn_ic)(taucs_ccs_matrix* A,
+			    int levels, double droptol, int modified)
+{
+  taucs_index* colptr;
+  int* rowind;
+  ic_factor* F;
+  taucs_ccs_matrix* L;
+  double flops;
+  double wtime;
+
+  if (!(A->flags & TAUCS_SYMMETRIC) && !(A->flags & TAUCS_HERMITIAN)) {
+    taucs_printf("taucs_ccs_factor_sn_ic: matrix must be symmetric\n");
+    return NULL;
+  }
+  if (!(A->flags & TAUCS_LOWER)) {
+    taucs_printf("taucs_ccs_factor_sn_ic: lower part must be represented\n");
+    return NULL;
+  }
+
+  taucs_printf("taucs_ccs_factor_sn_ic: starting n=%d levels=%d droptol=%.2e modified?=%d\n",
+	       A->n,levels,droptol,modified);
+  wtime = taucs_wtime();
+
+  if (ic_pattern(A,levels,A->n,&colptr,&rowind) == -1) {
+    taucs_printf("taucs_ccs_factor_sn_ic: out of memory\n");
+    return NULL;
+  }
+
+  F = ic_supernodes(A->n,A->n,colptr,rowind);
+  taucs_free(colptr);
+  taucs_free(rowind);
+  if (!F) {
+    taucs_printf("taucs_ccs_factor_sn_ic: out of memory\n");
+    return NULL;
+  }
+
+  if (ic_numeric(A,F,A->n,droptol,modified,&flops) == -1) {
+    ic_factor_free(F);
+    return NULL;
+  }
+
+  L = ic_factor_to_ccs(F);
+  if (L)
+    taucs_printf("taucs_ccs_factor_sn_ic: done; %d supernodes, nnz(L) = %.0f, flops=%.1le, %.3f seconds\n",
+		 F->n_sn,(double) (L->colptr)[A->n],flops,taucs_wtime()-wtime);
+  ic_factor_free(F);
+
+  return L;
+}
+
+/*
+  A partial LL^T factorization: columns 0..p-1 are eliminated exactly
+  and columns p..n-1 hold the Schur complement A22 - L21 L21^T, in the
+  same layout as taucs_ccs_factor_llt_partial, so the result can be
+  taken apart with taucs_ccs_split. With p == n this is a complete
+  supernodal factorization.
+*/
+
+taucs_ccs_matrix*
+taucs_dtl(ccs_factor_sn_llt_partial)(taucs_ccs_matrix* A, int p)
+{
+  taucs_index* colptr;
+  int* rowind;
+  ic_factor* F;
+  taucs_ccs_matrix* L;
+  double flops;
+  double wtime;
+
+  if (!(A->flags & TAUCS_SYMMETRIC) && !(A->flags & TAUCS_HERMITIAN)) {
+    taucs_printf("taucs_ccs_factor_sn_llt_partial: matrix must be symmetric\n");
+    return NULL;
+  }
+  if (!(A->flags & TAUCS_LOWER)) {
+    taucs_printf("taucs_ccs_factor_sn_llt_partial: lower part must be represented\n");
+    return NULL;
+  }
+  if (p < 0 || p > A->n) {
+    taucs_printf("taucs_ccs_factor_sn_llt_partial: p=%d out of range\n",p);
+    return NULL;
+  }
+
+  taucs_printf("taucs_ccs_factor_sn_llt_partial: starting n=%d p=%d\n",A->n,p);
+  wtime = taucs_wtime();
+
+  if (ic_pattern(A,-1,p,&colptr,&rowind) == -1) {
+    taucs_printf("taucs_ccs_factor_sn_llt_partial: out of memory\n");
+    return NULL;
+  }
+
+  F = ic_supernodes(A->n,p,colptr,rowind);
+  taucs_free(colptr);
+  taucs_free(rowind);
+  if (!F) {
+    taucs_printf("taucs_ccs_factor_sn_llt_partial: out of memory\n");
+    return NULL;
+  }
+
+  if (ic_numeric(A,F,p,0.0,FALSE,&flops) == -1) {
+    ic_factor_free(F);
+    return NULL;
+  }
+
+  L = ic_factor_to_ccs(F);
+  if (L)
+    taucs_printf("taucs_ccs_factor_sn_llt_partial: done; %d supernodes, nnz(L) = %.0f, flops=%.1le, %.3f seconds\n",
+		 F->n_sn,(double) (L->colptr)[A->n],flops,taucs_wtime()-wtime);
+  ic_factor_free(F);
+
+  return L;
+}
+
+#endif /*#ifndef TAUCS_CORE_GENERAL*/
+
+/*********************************************************/
+/*                                                       */
+/*********************************************************/
+
+#ifdef TAUCS_CORE_GENERAL
+taucs_ccs_matrix*
+taucs_ccs_factor_sn_ic(taucs_ccs_matrix* A,
+		       int levels, double droptol, int modified)
+{
+
+#ifdef TAUCS_DOUBLE_IN_BUILD
+  if (A->flags & TAUCS_DOUBLE)
+    return taucs_dccs_factor_sn_ic(A,levels,droptol,modified);
+#endif
+
+#ifdef TAUCS_SINGLE_IN_BUILD
+  if (A->flags & TAUCS_SINGLE)
+    return taucs_sccs_factor_sn_ic(A,levels,droptol,modified);
+#endif
+
+#ifdef TAUCS_DCOMPLEX_IN_BUILD
+  if (A->flags & TAUCS_DCOMPLEX)
+    return taucs_zccs_factor_sn_ic(A,levels,droptol,modified);
+#endif
+
+#ifdef TAUCS_SCOMPLEX_IN_BUILD
+  if (A->flags & TAUCS_SCOMPLEX)
+    return taucs_cccs_factor_sn_ic(A,levels,droptol,modified);
+#endif
+
+  assert(0);
+  return NULL;
+}
+#endif /*TAUCS_CORE_GENERAL*/
+
+#ifdef TAUCS_CORE_GENERAL
+taucs_ccs_matrix*
+taucs_ccs_factor_sn_llt_partial(taucs_ccs_matrix* A, int p)
+{
+
+#ifdef TAUCS_DOUBLE_IN_BUILD
+  if (A->flags & TAUCS_DOUBLE)
+    return taucs_dccs_factor_sn_llt_partial(A,p);
+#endif
+
+#ifdef TAUCS_SINGLE_IN_BUILD
+  if (A->flags & TAUCS_SINGLE)
+    return taucs_sccs_factor_sn_llt_partial(A,p);
+#endif
+
+#ifdef TAUCS_DCOMPLEX_IN_BUILD
+  if (A->flags & TAUCS_DCOMPLEX)
+    return taucs_zccs_factor_sn_llt_partial(A,p);
+#endif
+
+#ifdef TAUCS_SCOMPLEX_IN_BUILD
+  if (A->flags & TAUCS_SCOMPLEX)
+    return taucs_cccs_factor_sn_llt_partial(A,p);
+#endif
+
+  assert(0);
+  return NULL;
+}
+#endif /*TAUCS_CORE_GENERAL*/
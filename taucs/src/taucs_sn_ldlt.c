@@ -6,8 +6,15 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <math.h>
+#include <limits.h>
+
+#define TAUCS_CORE_CILK
 #include "taucs.h"
 
+#ifdef TAUCS_CILK
+#pragma lang -C
+#endif
+
 #ifdef TAUCS_CORE_DOUBLE
 #define taucs_cmp(x,y) ((x)==(y))
 #define taucs_real_zero_const taucs_dzero_const
@@ -35,6 +42,10 @@
 #define BLAS_FLOPS_CUTOFF  -1.0
 #define SOLVE_DENSE_CUTOFF 5
 
+/* default pivoting thresholds, see ldlt_pivoting below */
+#define LDLT_DEFAULT_ALPHA 0.001
+#define LDLT_DEFAULT_BETA  1e-39
+
 /*******************/
 /* Test Utilities  */
 /*******************/
@@ -42,30 +53,47 @@
 #ifndef TAUCS_CORE_GENERAL
 
 /* globals */
-static float gl_alpha = (float)0.001;
 static int gl_cramer_rule = 0;
-static float gl_beta = (float)0.000000000000000000000000000000000000001;
 typedef enum { fa_right_looking, fa_blocked, fa_sytrf, fa_potrf } factor_alg_enum;
 static int gl_factor_alg = fa_blocked;
 static int gl_block_size = 20;
 
+/*
+  Pivoting parameters of one factorization. Each front works on its
+  own copy, so concurrent fronts never share them. alpha is the
+  Bunch-Kaufman threshold and magnitudes below beta are treated as zero.
+  When perturb is positive we use static pivoting: a column with no
+  acceptable pivot is not delayed to the parent; its diagonal element
+  is used anyway, and is replaced by +-perturb if it is smaller.
+*/
+
+typedef struct {
+  float alpha;
+  float beta;
+  taucs_real_datatype perturb;
+  int   perturbed; /* number of pivots we perturbed */
+} ldlt_pivoting;
+
 #ifdef TAUCS_HACK_LDLT_TESTING
 extern char * gl_parameters;
 
 static void
-get_input_parameters( char* filename )
+get_input_parameters( char* filename, double* alpha, double* beta )
 {
   int factor_alg = 0;
+  float file_alpha, file_beta;
   FILE* f = fopen(filename,"r");
   if (!f) {/* no file found - leave defaults */
     taucs_printf("\t\tUsing default parameters\n");
     return;
   }
-  fscanf(f,"%e,%d,%d,%e,%d",&gl_alpha,&gl_cramer_rule,
-	 &factor_alg,&gl_beta,&gl_block_size);
+  fscanf(f,"%e,%d,%d,%e,%d",&file_alpha,&gl_cramer_rule,
+	 &factor_alg,&file_beta,&gl_block_size);
   fclose(f);
-  taucs_printf("\t\tUsing parameters: %e %d %d %e %d\n",gl_alpha,gl_cramer_rule,
-	       factor_alg,gl_beta,gl_block_size);
+  taucs_printf("\t\tUsing parameters: %e %d %d %e %d\n",file_alpha,gl_cramer_rule,
+	       factor_alg,file_beta,gl_block_size);
+  *alpha = file_alpha;
+  *beta  = file_beta;
 
   switch(factor_alg) {
   case 0:
@@ -85,21 +113,21 @@ get_input_parameters( char* filename )
 #endif
 
 static int
-taucs_is_zero_real( taucs_real_datatype v )
+taucs_is_zero_real( taucs_real_datatype v, float beta )
 {
-  if ( fabs(v) < gl_beta )
+  if ( fabs(v) < beta )
     {
-      /*taucs_printf("zero - %e beta - %e\n",v,gl_beta);*/
+      /*taucs_printf("zero - %e beta - %e\n",v,beta);*/
       return TRUE;
     }
   return FALSE;
 }
 static int
-taucs_is_zero( taucs_datatype v )
+taucs_is_zero( taucs_datatype v, float beta )
 {
-  if ( taucs_real_abs(v) < fabs(gl_beta) )
+  if ( taucs_real_abs(v) < beta )
     {
-      /*taucs_printf("zero - %e beta - %e\n",v,gl_beta);*/
+      /*taucs_printf("zero - %e beta - %e\n",v,beta);*/
       return TRUE;
     }
   return FALSE;
@@ -133,6 +161,11 @@ typedef struct {
 	|--|---|*/
   int* db_size;				/* sizes of diagonal blocks */
   taucs_datatype* d;	/* the diagonal entries of f1 */
+
+  int rejected_size;  /* the last rejected_size up_vertices are columns
+			 rejected to the parent supernode */
+  int perturbed;      /* pivots perturbed by static pivoting in this
+			 front and in the fronts below it */
   
 } supernodal_frontal_matrix_ldlt;
 
@@ -177,6 +210,13 @@ typedef struct {
   taucs_datatype** up_blocks; /* update blocks           */
   
   taucs_datatype** d_blocks;	/* diagonal blocks				 */
+
+  double pivot_alpha;   /* Bunch-Kaufman threshold                         */
+  double pivot_beta;    /* magnitudes below beta are treated as zero       */
+  double pivot_perturb; /* static pivoting, relative to max |A(i,j)|;
+			   zero means rejected columns are delayed         */
+  double perturb_value; /* pivot_perturb times max |A(i,j)|             */
+  int    perturbed;     /* pivots perturbed by the last numeric factorization */
 } supernodal_factor_matrix_ldlt;
 
 
@@ -248,9 +288,54 @@ multifrontal_supernodal_create()
   L->sn_max_ind		 = NULL;
   L->sn_rej_size	 = NULL;
 
+  L->pivot_alpha   = LDLT_DEFAULT_ALPHA;
+  L->pivot_beta    = LDLT_DEFAULT_BETA;
+  L->pivot_perturb = 0.0;
+  L->perturb_value = 0.0;
+  L->perturbed     = 0;
+
   return L;
 }
 
+/* compute the absolute static pivoting perturbation for A */
+static void
+ldlt_pivoting_prepare(supernodal_factor_matrix_ldlt* L, taucs_ccs_matrix* A)
+{
+  int j;
+  taucs_real_datatype v, amax = taucs_real_zero_const;
+
+  L->perturbed     = 0;
+  L->perturb_value = 0.0;
+  if (L->pivot_perturb <= 0.0) return;
+
+  for (j=0; j<A->colptr[A->n]; j++) {
+    v = taucs_abs(A->taucs_values[j]);
+    if (v > amax) amax = v;
+  }
+  L->perturb_value = L->pivot_perturb * amax;
+  taucs_printf("\t\tLDL^T static pivoting: perturbing pivots below %.2e\n",
+	       L->perturb_value);
+}
+
+/* negative alpha or beta select the defaults; perturb <= 0 disables static pivoting */
+static void
+ldlt_pivoting_set(supernodal_factor_matrix_ldlt* L,
+		  double alpha, double beta, double perturb)
+{
+  L->pivot_alpha   = (alpha < 0.0) ? LDLT_DEFAULT_ALPHA : alpha;
+  L->pivot_beta    = (beta  < 0.0) ? LDLT_DEFAULT_BETA  : beta;
+  L->pivot_perturb = (perturb > 0.0) ? perturb : 0.0;
+}
+
+static void
+ldlt_pivoting_copy(ldlt_pivoting* piv, supernodal_factor_matrix_ldlt* L)
+{
+  piv->alpha     = (float) L->pivot_alpha;
+  piv->beta      = (float) L->pivot_beta;
+  piv->perturb   = (taucs_real_datatype) L->perturb_value;
+  piv->perturbed = 0;
+}
+
 void taucs_dtl(supernodal_factor_ldlt_free)(void* vL)
 {
   supernodal_factor_matrix_ldlt* L = (supernodal_factor_matrix_ldlt*) vL;
@@ -326,8 +411,10 @@ taucs_dtl(supernodal_factor_ldlt_to_ccs)(void* vL)
 {
   supernodal_factor_matrix_ldlt* L = (supernodal_factor_matrix_ldlt*) vL;
   taucs_ccs_matrix* C;
-  int n,nnz;
-  int i,j,ip,jp,sn,next,db_size;
+  int n;
+  taucs_int64 nnz; /* the factor may have more than 2^31 nonzeros */
+  int i,j,ip,jp,sn,db_size;
+  taucs_index next;
   taucs_datatype v;
   int* len;
 
@@ -368,8 +455,15 @@ taucs_dtl(supernodal_factor_ldlt_to_ccs)(void* vL)
     }
   }
 
+  /* without INDEX64, CCS column pointers are ints */
+  if (nnz > (taucs_int64) TAUCS_INDEX_MAX) {
+    taucs_printf("supernodal_factor_ldlt_to_ccs: factor has %.0f nonzeros, too many for a CCS matrix\n",
+		 (double) nnz);
+    taucs_free(len);
+    return NULL;
+  }
 
-  C = taucs_dtl(ccs_create)(n,n,nnz);
+  C = taucs_dtl(ccs_create)(n,n,(taucs_index) nnz);
   if (!C) {
     taucs_free(len);
     return NULL;
@@ -451,7 +545,8 @@ taucs_dtl(supernodal_factor_diagonal_to_ccs)(void* vL)
   supernodal_factor_matrix_ldlt* L = (supernodal_factor_matrix_ldlt*) vL;
   taucs_ccs_matrix* C;
   int n,nnz;
-  int i,j,ip,jp,sn,next,db_size;
+  int i,j,ip,jp,sn,db_size;
+  taucs_index next;
   taucs_datatype v;
   int* len;
 
@@ -613,7 +708,7 @@ void	taucs_dtl(inertia_calc)(void* vL, int* inertia)
 }
 #endif
 
-void taucs_dtl(get_statistics)( int* pbytes,
+void taucs_dtl(get_statistics)( double* pbytes,
 				double* pflops,
 				double* pnnz,
 				void* vL)
@@ -621,7 +716,7 @@ void taucs_dtl(get_statistics)( int* pbytes,
   double nnz   = 0.0;
   double flops = 0.0;
   int sn,i,colnnz;
-  int bytes;
+  double bytes;
 
   supernodal_factor_matrix_ldlt* L = (supernodal_factor_matrix_ldlt*) vL;
   
@@ -637,7 +732,7 @@ void taucs_dtl(get_statistics)( int* pbytes,
   for (sn=0; sn<(L->n_sn); sn++) {
     bytes += (L->sn_up_size)[sn] * sizeof(int);
     bytes += (L->sn_size)[sn] * sizeof(int); /* db_size */
-    bytes += ((L->sn_size)[sn]*(L->sn_up_size)[sn]) * sizeof(taucs_datatype);
+    bytes += ((double) (L->sn_size)[sn]*(L->sn_up_size)[sn]) * sizeof(taucs_datatype);
     bytes += ((L->sn_size)[sn]* 2 * sizeof(taucs_datatype));/* d_blocks*/
     
     for (	i=0, colnnz = (L->sn_up_size)[sn];
@@ -991,6 +1086,8 @@ supernodal_frontal_ldlt_create(int* firstcol_in_supernode,
   tmp->SFM_F1 = tmp->SFM_F2 = tmp->SFM_U = NULL;
   tmp->SFM_D = NULL;
   tmp->db_size = NULL;
+  tmp->rejected_size = 0;
+  tmp->perturbed = 0;
 
   if (tmp->sn_size) {
     tmp->SFM_F1 =
@@ -1112,7 +1209,6 @@ mf_sn_front_reorder_ldlt(int sn,
 			 supernodal_factor_matrix_ldlt* snL,
 			 taucs_datatype* F2D11,
 			 supernodal_ldlt_factor* fct,
-			 int parent,
 			 int new_sn_size,
 			 int new_up_size)
 {
@@ -1226,25 +1322,9 @@ mf_sn_front_reorder_ldlt(int sn,
       mtr->SFM_F2 = tempF2;
     }
 
-    /* copying the structure of the parent to a new bigger struct */
-    snL->sn_struct[parent] = (int*)taucs_realloc(snL->sn_struct[parent],
-						 (rej_size+snL->sn_up_size[parent])*sizeof(int));
-    if ( !snL->sn_struct[parent] ) {
-      taucs_printf("Could not allocate memory (for structure) %d\n",(fct->rejected_size) + snL->sn_size[parent]);
-      return -1;
-    }
-    k = snL->sn_up_size[parent] - snL->sn_size[parent];
-    for (i=k-1; i>=0; i--)
-      snL->sn_struct[parent][i+snL->sn_size[parent]+rej_size] =
-	snL->sn_struct[parent][i+snL->sn_size[parent]];
-    for (i=0; i<rej_size; i++)
-      snL->sn_struct[parent][i+snL->sn_size[parent]] =
-	snL->sn_struct[sn][fct->indices[rejected_cols[i]]];
-
-    snL->sn_size[parent]+=rej_size;
-    snL->sn_up_size[parent]+=rej_size;
-    snL->sn_blocks_ld[parent]+=rej_size;
-    /*snL->up_blocks_ld[parent]+=rej_size;*/
+    /* the rejected columns are appended to the structure of the
+       parent when the parent receives this front; see
+       mf_sn_accept_rejected_ldlt */
   }
 
   /* rebuild the structure of the current supernode */
@@ -1265,6 +1345,7 @@ mf_sn_front_reorder_ldlt(int sn,
   /* changes to mtr needed only if there are size changes */
   mtr->sn_size = new_sn_size;
   mtr->up_size = new_up_size;
+  mtr->rejected_size = rej_size;
 
   taucs_free(snL->sn_struct[sn]);
   snL->sn_struct[sn] = current_struct;
@@ -1302,6 +1383,45 @@ mf_sn_front_reorder_ldlt(int sn,
   return INFO;
 }
 
+/* 
+   Append the columns that a child front rejected to the structure of
+   its parent supernode. This is called by the parent when it receives
+   the child's front, so siblings that are factored concurrently never
+   modify the parent's structure at the same time.
+*/
+static int
+mf_sn_accept_rejected_ldlt(supernodal_factor_matrix_ldlt* snL,
+			   int parent,
+			   supernodal_frontal_matrix_ldlt* child_mtr)
+{
+  int i,k;
+  int rej_size = child_mtr->rejected_size;
+  int* rejected = child_mtr->up_vertices + (child_mtr->up_size - rej_size);
+
+  if ( !rej_size ) return 0;
+
+  /* copying the structure of the parent to a new bigger struct */
+  snL->sn_struct[parent] = (int*)taucs_realloc(snL->sn_struct[parent],
+					       (rej_size+snL->sn_up_size[parent])*sizeof(int));
+  if ( !snL->sn_struct[parent] ) {
+    taucs_printf("Could not allocate memory (for structure) %d\n",rej_size + snL->sn_size[parent]);
+    return -1;
+  }
+  k = snL->sn_up_size[parent] - snL->sn_size[parent];
+  for (i=k-1; i>=0; i--)
+    snL->sn_struct[parent][i+snL->sn_size[parent]+rej_size] =
+      snL->sn_struct[parent][i+snL->sn_size[parent]];
+  for (i=0; i<rej_size; i++)
+    snL->sn_struct[parent][i+snL->sn_size[parent]] = rejected[i];
+
+  snL->sn_size[parent]+=rej_size;
+  snL->sn_up_size[parent]+=rej_size;
+  snL->sn_blocks_ld[parent]+=rej_size;
+  /*snL->up_blocks_ld[parent]+=rej_size;*/
+
+  return 0;
+}
+
 static int
 supernodal_find_max_new(taucs_datatype* data,
 			int size,
@@ -1405,6 +1525,41 @@ supernodal_find_row_max(taucs_datatype * row,
 }
 
 
+/*
+  Static pivoting: no acceptable pivot was found for column k. Rather
+  than delaying the column to the parent, which enlarges the parent's
+  front, we accept the diagonal element, after making sure that it is
+  at least piv->perturb in magnitude. Returns INFO for the caller.
+*/
+static int
+ldlt_static_pivot(int* pivot,
+		  int k,
+		  taucs_datatype* akk,
+		  ldlt_pivoting* piv)
+{
+  taucs_real_datatype a;
+
+  if ( piv->perturb <= taucs_real_zero_const ) return 0; /* delay column */
+
+  a = taucs_abs(*akk);
+  if ( a < piv->perturb ) {
+    /* keep the sign (phase) of akk, but give it magnitude perturb */
+#if defined(TAUCS_CORE_DOUBLE) || defined(TAUCS_CORE_SINGLE)
+    if ( a == taucs_real_zero_const ) *akk = piv->perturb;
+    else                              *akk = (*akk / a) * piv->perturb;
+#else
+    if ( a == taucs_real_zero_const )
+      *akk = taucs_complex_create( piv->perturb, 0.0 );
+    else
+      *akk = taucs_complex_create( taucs_re(*akk) * (piv->perturb / a),
+				   taucs_im(*akk) * (piv->perturb / a) );
+#endif
+    piv->perturbed++;
+  }
+  *pivot = k;
+  return 0;
+}
+
 static int
 supernodal_find_pivot( int* pivot,
 		       int* secondpivot,
@@ -1413,7 +1568,8 @@ supernodal_find_pivot( int* pivot,
 		       int LDF1,
 		       int up_size,
 		       taucs_datatype* F1,
-		       taucs_datatype* F2)
+		       taucs_datatype* F2,
+		       ldlt_pivoting* piv)
 {
   int INFO = 0;
   int max_k1Ind, max_k2Ind, max_q1Ind, max_q2Ind;
@@ -1436,8 +1592,8 @@ supernodal_find_pivot( int* pivot,
 
   max_k = max(max_k1,max_k2);
 
-  if ( taucs_is_zero_real(max_k)) {
-    if ( taucs_is_zero_real(akk)) {
+  if ( taucs_is_zero_real(max_k,piv->beta)) {
+    if ( taucs_is_zero_real(akk,piv->beta)) {
       /* if max = 0 and akk = 0 then this is a singular matrix */
       return k + 1;
     }	else {
@@ -1447,7 +1603,7 @@ supernodal_find_pivot( int* pivot,
   }
 
   /* check if akk can be a pivot */
-  if ( akk >= gl_alpha*max_k ) {
+  if ( akk >= piv->alpha*max_k ) {
     *pivot = k;
     return INFO;
   }
@@ -1472,7 +1628,7 @@ supernodal_find_pivot( int* pivot,
   /* the max in q column inside F1 can be the F1(q,k) we found */
   max_q1 = max(max_q1, max_k1);
   max_q = max(max_q1, max_q2);
-  if ( aqq >= gl_alpha*max_q ) {
+  if ( aqq >= piv->alpha*max_q ) {
     *pivot = max_k1Ind;
     return INFO;
   }
@@ -1480,15 +1636,15 @@ supernodal_find_pivot( int* pivot,
   aq1 = taucs_abs(F1[k*LDF1+max_k1Ind]);
 
   if ( aq1 == taucs_real_zero_const ) /* no chance for 2*2 */
-    return INFO;
+    return ldlt_static_pivot(pivot,k,&(F1[k*LDF1+k]),piv);
 
   if (  fabs(max( aqq*max_k + aq1*max_q, akk*max_q + aq1*max_k ))  <=
-	( fabs(akk * aqq - (aq1*aq1) /  gl_alpha ) ))  {
+	( fabs(akk * aqq - (aq1*aq1) /  piv->alpha ) ))  {
     *pivot = k;
     *secondpivot = max_k1Ind;
     return INFO;
   }
-  return INFO;
+  return ldlt_static_pivot(pivot,k,&(F1[k*LDF1+k]),piv);
 }
 
 static int
@@ -1502,7 +1658,8 @@ blocked_find_pivot( int* pivot,
 		    taucs_datatype* W1,
 		    taucs_datatype* W2,
 		    int size_remained,
-		    int index)
+		    int index,
+		    ldlt_pivoting* piv)
 {
   int INFO = 0;
   int max_k1Ind, max_k2Ind, max_q1Ind, max_q2Ind;
@@ -1527,8 +1684,8 @@ blocked_find_pivot( int* pivot,
 
   max_k = max(max_k1,max_k2);
 
-  if ( taucs_is_zero_real(max_k)) {
-    if ( taucs_is_zero_real(akk)) {
+  if ( taucs_is_zero_real(max_k,piv->beta)) {
+    if ( taucs_is_zero_real(akk,piv->beta)) {
       /* if max = 0 and akk = 0 then this is a singular matrix */
       return k + 1;
     }	else {
@@ -1538,7 +1695,7 @@ blocked_find_pivot( int* pivot,
   }
 
   /* check if akk can be a pivot */
-  if ( akk >= gl_alpha*max_k ) {
+  if ( akk >= piv->alpha*max_k ) {
     *pivot = k;
     return INFO;
   }
@@ -1581,7 +1738,7 @@ blocked_find_pivot( int* pivot,
   /* the max in q column inside F1 can be the F1(q,k) we found */
   max_q1 = max(max_q1, max_k1);
   max_q = max(max_q1, max_q2);
-  if ( aqq >= gl_alpha*max_q ) {
+  if ( aqq >= piv->alpha*max_q ) {
     *pivot = max_k1Ind + index;
 
     /* we need to copy from W[i+1] to W[i] 
@@ -1603,10 +1760,10 @@ blocked_find_pivot( int* pivot,
   aq1 = taucs_abs(W1[i*sn_size+max_k1Ind]);
 
   if ( aq1 == taucs_real_zero_const ) /* no chance for 2*2 */
-    return INFO;
+    return ldlt_static_pivot(pivot,k,&(W1[i*sn_size+i]),piv);
 
   if ( max( aqq*max_k + aq1*max_q, akk*max_q + aq1*max_k )  <=
-       ( fabs(akk * aqq - (aq1*aq1) /  gl_alpha ) ) ) {
+       ( fabs(akk * aqq - (aq1*aq1) /  piv->alpha ) ) ) {
     *pivot = k;
     *secondpivot = max_k1Ind + index;
 
@@ -1624,7 +1781,7 @@ blocked_find_pivot( int* pivot,
     return INFO;
   }
 	
-  return INFO;
+  return ldlt_static_pivot(pivot,k,&(W1[i*sn_size+i]),piv);
 }
 
 static void
@@ -1935,14 +2092,14 @@ taucs_ccs_etree(taucs_ccs_matrix* A,
 		int* parent,
 		int* l_colcount,
 		int* l_rowcount,
-		int* l_nnz);
+		taucs_index* l_nnz);
 
 int
 taucs_ccs_etree_liu(taucs_ccs_matrix* A,
 		    int* parent,
 		    int* l_colcount,
 		    int* l_rowcount,
-		    int* l_nnz);
+		    taucs_index* l_nnz);
 
 
 
@@ -1965,7 +2122,8 @@ recursive_symbolic_elimination(int            j,
 			       int            ipostorder[]
 			       )
 {
-  int  i,ip,c,c_sn;
+  int  i,c,c_sn;
+  taucs_index ip;
   int  in_previous_sn;
   int  nnz = 0; /* just to suppress the warning */
 
@@ -2376,7 +2534,8 @@ RL_supernodal_front_factor_ldlt(supernodal_ldlt_factor* fct,
 				int* db_size,
 				int sn_size,
 				int up_size,
-				int sn)
+				int sn,
+				ldlt_pivoting* piv)
 {
   int INFO = 0,i,k,j,one,two;
   int size_left,size_L21;
@@ -2386,7 +2545,7 @@ RL_supernodal_front_factor_ldlt(supernodal_ldlt_factor* fct,
   int rejected_tried = 0, need_switch = 0;
 	
   for (i=0; i<sn_size; i++) {
-    INFO = supernodal_find_pivot(&pivot, &secondpivot, i, sn_size, sn_size, up_size, F1, F2);
+    INFO = supernodal_find_pivot(&pivot, &secondpivot, i, sn_size, sn_size, up_size, F1, F2, piv);
     if ( INFO ) {
       /*The matrix is singular.*/
       /*return INFO;*/
@@ -2617,7 +2776,8 @@ block_factor(int index,
 	     taucs_datatype* W1,
 	     taucs_datatype* W2,
 	     int* rejected_tried,
-	     int sn)
+	     int sn,
+	     ldlt_pivoting* piv)
 {
   int size_remained = sn_size - index;
   int INFO = 0;
@@ -2654,7 +2814,7 @@ block_factor(int index,
 
     INFO = blocked_find_pivot(&pivot,&secondpivot,k,
 			      sn_size,up_size,F1,
-			      F2,W1,W2,size_remained,index);
+			      F2,W1,W2,size_remained,index,piv);
 
     if ( INFO ) {
       /*The matrix is singular.*/
@@ -2943,7 +3103,8 @@ unblock_factor(	int index,
 		int up_size, 
 		supernodal_ldlt_factor* fct,
 		int* rejected_tried,
-		int sn)
+		int sn,
+		ldlt_pivoting* piv)
 {
   int INFO = 0,i,k,j,one,two;
   int size_left,size_L21;
@@ -2953,7 +3114,7 @@ unblock_factor(	int index,
   int need_switch = 0;
   
   for (i=index; i<sn_size; i++) {
-    INFO = supernodal_find_pivot(&pivot, &secondpivot, i, sn_size, sn_size, up_size, F1, F2);
+    INFO = supernodal_find_pivot(&pivot, &secondpivot, i, sn_size, sn_size, up_size, F1, F2, piv);
     if ( INFO ) {
       /*The matrix is singular.*/
       /*return INFO;*/
@@ -3182,7 +3343,8 @@ Blocked_supernodal_front_factor_ldlt(supernodal_ldlt_factor* fct,
 				     int* db_size,
 				     int sn_size,
 				     int up_size,
-				     int sn)
+				     int sn,
+				     ldlt_pivoting* piv)
 {
   int INFO = 0;
   int actual_block_size = gl_block_size;
@@ -3203,12 +3365,12 @@ Blocked_supernodal_front_factor_ldlt(supernodal_ldlt_factor* fct,
     if ( i <= sn_size - gl_block_size ) {
       INFO = block_factor(i, &actual_block_size,
 			  F1,F2,DB,db_size,
-			  sn_size, up_size, fct, W1, W2, &rejected_tried, sn ); 
+			  sn_size, up_size, fct, W1, W2, &rejected_tried, sn, piv ); 
       /*CALL DLASYF( UPLO, N-K+1, NB, KB, A( K, K ), LDA, IPIV( K ),
 	WORK, LDWORK, IINFO )*/
     } else {
       INFO = unblock_factor(i, F1, F2, DB, db_size,
-			    sn_size, up_size, fct, &rejected_tried, sn ); 
+			    sn_size, up_size, fct, &rejected_tried, sn, piv ); 
       
       actual_block_size = sn_size-i;
       /*   CALL DSYTF2( UPLO, N-K+1, A( K, K ), LDA, IPIV( K ), IINFO )
@@ -3377,21 +3539,37 @@ Potrf_supernodal_front_factor_ldlt(supernodal_ldlt_factor* fct,
   return INFO;
 }
 
+/*
+  vpiv points to the ldlt_pivoting parameters of this front, or is
+  NULL for the default thresholds without static pivoting.
+*/
 int taucs_dtl(internal_supernodal_front_factor_ldlt)(void* vfct,taucs_datatype* F1,
 						     taucs_datatype* F2,taucs_datatype* DB,
 						     int* db_size,int sn_size,
-						     int up_size,int sn,int alg)
+						     int up_size,int sn,int alg,
+						     void* vpiv)
 {
   supernodal_ldlt_factor* fct = (supernodal_ldlt_factor*)vfct;
+  ldlt_pivoting* piv = (ldlt_pivoting*)vpiv;
+  ldlt_pivoting  default_piv;
   int ret = 0;
+
+  if (!piv) {
+    default_piv.alpha     = (float) LDLT_DEFAULT_ALPHA;
+    default_piv.beta      = (float) LDLT_DEFAULT_BETA;
+    default_piv.perturb   = taucs_real_zero_const;
+    default_piv.perturbed = 0;
+    piv = &default_piv;
+  }
+
   switch(alg)	{
   case fa_right_looking:
     ret = RL_supernodal_front_factor_ldlt(fct,F1,F2,DB,
-					  db_size,sn_size,up_size,sn);
+					  db_size,sn_size,up_size,sn,piv);
     break;
   case fa_blocked:
     ret = Blocked_supernodal_front_factor_ldlt(fct,F1,F2,DB,
-					       db_size,sn_size,up_size,sn);
+					       db_size,sn_size,up_size,sn,piv);
     break;
   case fa_sytrf:
     ret = Sytrf_supernodal_front_factor_ldlt(fct,F1,F2,DB,
@@ -3406,6 +3584,46 @@ int taucs_dtl(internal_supernodal_front_factor_ldlt)(void* vfct,taucs_datatype*
 }
 
 
+/*
+  U := U - F2D11 * F2^H on the first m columns of U. With more than one
+  worker, the columns of U are split recursively so that large fronts
+  are updated in parallel; each column of U is computed by the same
+  GEMM arithmetic either way.
+*/
+
+#define LDLT_PARALLEL_GEMM_MIN_COLS 64
+
+cilk
+static void
+multifrontal_update_gemm_ldlt(int m, int n, int k,
+			      taucs_datatype* F2D11,
+			      taucs_datatype* F2,
+			      taucs_datatype* U,
+			      int ld)
+{
+  int nhalf;
+
+  if (Cilk_active_size > 1 && n >= 2*LDLT_PARALLEL_GEMM_MIN_COLS) {
+    nhalf = n/2;
+    spawn multifrontal_update_gemm_ldlt(m,nhalf,k,F2D11,F2,U,ld);
+    spawn multifrontal_update_gemm_ldlt(m,n-nhalf,k,
+					F2D11,F2+nhalf,U+nhalf*ld,ld);
+    sync;
+    return;
+  }
+
+  taucs_gemm("No conjugate",
+	     "Conjugate",
+	     &m, &n,
+	     &k,
+	     &taucs_minusone_const,
+	     F2D11,&ld,
+	     F2,&ld,
+	     &taucs_one_const,
+	     U,&ld);
+}
+
+cilk
 static int
 multifrontal_supernodal_front_factor_ldlt(int sn,
 					  int* firstcol_in_supernode,
@@ -3413,8 +3631,7 @@ multifrontal_supernodal_front_factor_ldlt(int sn,
 					  taucs_ccs_matrix* A,
 					  supernodal_frontal_matrix_ldlt* mtr,
 					  int* bitmap,
-					  supernodal_factor_matrix_ldlt* snL,
-					  int parent)
+					  supernodal_factor_matrix_ldlt* snL)
 {
   int i,j,db_size,index;
   int new_sn_size,new_up_size,old_up_size;
@@ -3461,12 +3678,17 @@ multifrontal_supernodal_front_factor_ldlt(int sn,
   /* factor the F1 part of the front matrix */
   {
     int algorithm;
+    ldlt_pivoting piv;
+
+    ldlt_pivoting_copy(&piv,snL);
     if ( sn == snL->n_sn - 1 ) algorithm = fa_sytrf;
     else                       algorithm = fa_blocked;
     INFO = taucs_dtl(internal_supernodal_front_factor_ldlt)(fct,mtr->SFM_F1,mtr->SFM_F2, 
 							    mtr->SFM_D, mtr->db_size, mtr->sn_size, mtr->up_size,sn,
 							    algorithm /* was gl_factor_alg, but 
-									 this caused delays even in the last supernode */);
+									 this caused delays even in the last supernode */,
+							    &piv);
+    mtr->perturbed += piv.perturbed;
   }
 
   if (INFO) {
@@ -3488,7 +3710,7 @@ multifrontal_supernodal_front_factor_ldlt(int sn,
       return -1;
     }
   }
-  INFO = mf_sn_front_reorder_ldlt(sn,mtr,snL,F2D11,fct,parent,new_sn_size,new_up_size);
+  INFO = mf_sn_front_reorder_ldlt(sn,mtr,snL,F2D11,fct,new_sn_size,new_up_size);
 	
   if (INFO) {
     taucs_printf("\t\tLDL^T Factorization: Problem reordering columns.\n");
@@ -3554,15 +3776,13 @@ multifrontal_supernodal_front_factor_ldlt(int sn,
     /* GEMM : C := A*B + C*/
     /* we use here the old_up_size so that we update only the non-updated
        part of U. The rest was already updated in F1-2, and moved here.*/
-    taucs_gemm("No conjugate",
-	       "Conjugate",
-	       &old_up_size, &old_up_size,
-	       &new_sn_size,
-	       &taucs_minusone_const,
-	       F2D11,&new_up_size,
-	       mtr->SFM_F2,&new_up_size,
-	       &taucs_one_const,
-	       mtr->SFM_U,&new_up_size);
+    spawn multifrontal_update_gemm_ldlt(old_up_size, old_up_size,
+					new_sn_size,
+					F2D11,
+					mtr->SFM_F2,
+					mtr->SFM_U,
+					new_up_size);
+    sync;
 
     /* we do not need the upper part of SFM_U
        for it is symmetric */
@@ -3598,73 +3818,116 @@ multifrontal_supernodal_front_factor_ldlt(int sn,
 
 }
 
+/*
+  Receive the front of a child: accept the columns it rejected into
+  the structure of supernode sn, create or enlarge the front of sn,
+  and extend-add the child's update matrix into it.
+*/
+static void
+multifrontal_receive_child_ldlt(supernodal_frontal_matrix_ldlt* child_matrix,
+				supernodal_frontal_matrix_ldlt** my_matrix_ptr,
+				int sn,
+				int is_root,
+				int* bitmap,
+				supernodal_factor_matrix_ldlt* snL,
+				int* perturbed,
+				int* fail)
+{
+  if (child_matrix) *perturbed += child_matrix->perturbed;
+
+  if (*fail) {
+    supernodal_frontal_free(child_matrix);
+    return;
+  }
+
+  if ( mf_sn_accept_rejected_ldlt(snL,sn,child_matrix) != 0 ) {
+    *fail = TRUE;
+    supernodal_frontal_free(child_matrix);
+    return;
+  }
+
+  if (!is_root) {
+    if (!(*my_matrix_ptr)) {
+      *my_matrix_ptr =  supernodal_frontal_ldlt_create(&( snL->sn_struct[sn][0] ),
+						       snL->sn_size[sn],
+						       snL->sn_up_size[sn],
+						       snL->sn_struct[sn]);
+      if (!(*my_matrix_ptr)) {
+	*fail = TRUE;
+	supernodal_frontal_free(child_matrix);
+	return;
+      }
+    } else {
+      if ( supernodal_frontal_ldlt_modify( *my_matrix_ptr, snL, sn ) != 0 ) {
+	*fail = TRUE;
+	supernodal_frontal_free(child_matrix);
+	return;
+      }
+    }
+
+    multifrontal_supernodal_front_extend_add(*my_matrix_ptr,child_matrix,bitmap);
+  }
+  /* moved outside "if !is_root"; Sivan 27 Feb 2002 */
+  supernodal_frontal_free(child_matrix);
+}
+
+cilk
 static supernodal_frontal_matrix_ldlt*
 recursive_multifrontal_supernodal_factor_ldlt(int sn,       /* this 
 							       supernode */
 					      int is_root,  /* is v the root? */
-					      int* bitmap,
+					      int** bitmaps,
 					      taucs_ccs_matrix* A,
 					      supernodal_factor_matrix_ldlt* snL,
-					      int* fail,
-					      int parent /* the parent */)
+					      int* fail)
 {
   supernodal_frontal_matrix_ldlt* my_matrix=NULL;
   supernodal_frontal_matrix_ldlt* child_matrix=NULL;
   int child;
   int* v;
   int  sn_size;
+  int  rc;
+  int  perturbed = 0; /* perturbed pivots in the subtrees of the children */
   int* first_child   = snL->first_child;
   int* next_child    = snL->next_child;
 
-  /* Sivan fixed a bug 25/2/2003: v was set even at the root, */
-  /* but this element of sn_struct was not allocated.         */
-
+#ifdef TAUCS_CILK
+  /* the inlet runs atomically with respect to this procedure, so */
+  /* children never update the structure of sn concurrently       */
+  inlet void receive_child_inlet(supernodal_frontal_matrix_ldlt* child_matrix) {
+    multifrontal_receive_child_ldlt(child_matrix,&my_matrix,sn,is_root,
+				    bitmaps[Self],snL,&perturbed,fail);
+  }
+#endif
 
-  /*if (!is_root) {
-    sn_size = snL->sn_size[sn];
-    v = &( snL->sn_struct[sn][0] );
-    } else {
-    sn_size = -1;
-    v = NULL;
-    }*/
   /* record the original supernode size */
   snL->orig_sn_size[sn] = snL->sn_size[sn];
 
   for (child = first_child[sn]; child != -1; child = next_child[child]) {
+#ifdef TAUCS_CILK
+    receive_child_inlet(spawn recursive_multifrontal_supernodal_factor_ldlt(child,
+									    FALSE,
+									    bitmaps,
+									    A,snL,fail));
+#else
     child_matrix =
       recursive_multifrontal_supernodal_factor_ldlt(child,
 						    FALSE,
-						    bitmap,
-						    A,snL,fail,sn);
+						    bitmaps,
+						    A,snL,fail);
+    multifrontal_receive_child_ldlt(child_matrix,&my_matrix,sn,is_root,
+				    bitmaps[Self],snL,&perturbed,fail);
+#endif
     if (*fail) {
       if (my_matrix) supernodal_frontal_free(my_matrix);
       return NULL;
     }
+  }
+  sync;
 
-    if (!is_root) {
-      if (!my_matrix) {
-	sn_size = snL->sn_size[sn];
-	v = &( snL->sn_struct[sn][0] );
-	my_matrix =  supernodal_frontal_ldlt_create(v,sn_size,
-						    snL->sn_up_size[sn],
-						    snL->sn_struct[sn]);
-	if (!my_matrix) {
-	  *fail = TRUE;
-	  supernodal_frontal_free(child_matrix);
-	  return NULL;
-	}
-      } else {
-	if ( supernodal_frontal_ldlt_modify( my_matrix, snL, sn ) != 0 ) {
-	  supernodal_frontal_free(my_matrix);
-	  *fail = TRUE;
-	  return NULL;
-	}
-      }
-
-      multifrontal_supernodal_front_extend_add(my_matrix,child_matrix,bitmap);
-    }
-    /* moved outside "if !is_root"; Sivan 27 Feb 2002 */
-    supernodal_frontal_free(child_matrix);
+  if (*fail) {
+    if (my_matrix) supernodal_frontal_free(my_matrix);
+    return NULL;
   }
 
   /* in case we have no children, we allocate now */
@@ -3683,35 +3946,93 @@ recursive_multifrontal_supernodal_factor_ldlt(int sn,       /* this
   if(!is_root) {
     sn_size = snL->sn_size[sn];
     v = &( snL->sn_struct[sn][0] );
-    if (multifrontal_supernodal_front_factor_ldlt(sn,
-						  v,
-						  sn_size,
-						  A,
-						  my_matrix,
-						  bitmap,
-						  snL,
-						  parent)) {
+    rc = spawn multifrontal_supernodal_front_factor_ldlt(sn,
+							 v,
+							 sn_size,
+							 A,
+							 my_matrix,
+							 bitmaps[Self],
+							 snL);
+    sync;
+    if (rc) {
       /* nonpositive pivot */
       *fail = TRUE;
       supernodal_frontal_free(my_matrix);
       return NULL;
     }
-  }
+    my_matrix->perturbed += perturbed;
+  } else
+    snL->perturbed = perturbed;
+
   return my_matrix;
 }
 
+static int**
+multifrontal_bitmaps_create(int n)
+{
+  int** maps;
+  int   i,j;
+
+  maps = (int**)taucs_malloc(Cilk_active_size*sizeof(int*));
+  if (!maps) return NULL;
+
+  for (i=0; i < Cilk_active_size; i++) {
+    maps[i] = (int*)taucs_malloc((n+1)*sizeof(int));
+    if (!maps[i]) {
+      for (j=0; j < i ; j++)
+	taucs_free(maps[j]);
+      taucs_free(maps);
+      return NULL;
+    }
+  }
+
+  return maps;
+}
+
+static void
+multifrontal_bitmaps_free(int** maps)
+{
+  int i;
+
+  if (!maps) return;
+  for (i=0; i < Cilk_active_size; i++)
+    taucs_free(maps[i]);
+  taucs_free(maps);
+}
+
+cilk
 void*
 taucs_dtl(ccs_factor_ldlt_mf)(taucs_ccs_matrix* A)
 {
-  return taucs_dtl(ccs_factor_ldlt_mf_maxdepth)(A,0);
+  void* p;
+
+  p = spawn taucs_dtl(ccs_factor_ldlt_mf_maxdepth)(A,0);
+  sync;
+
+  return p;
 }
 
+cilk
 void*
 taucs_dtl(ccs_factor_ldlt_mf_maxdepth)(taucs_ccs_matrix* A,int max_depth)
+{
+  void* p;
+
+  p = spawn taucs_dtl(ccs_factor_ldlt_mf_pivoting)(A,max_depth,-1.0,-1.0,0.0);
+  sync;
+
+  return p;
+}
+
+cilk
+void*
+taucs_dtl(ccs_factor_ldlt_mf_pivoting)(taucs_ccs_matrix* A,int max_depth,
+				       double alpha,double beta,double perturb)
 {
   supernodal_factor_matrix_ldlt* L;
-  int* map;
+  int** maps;
   int fail;
+  supernodal_frontal_matrix_ldlt* always_null;
   double wtime, ctime;
 
   wtime = taucs_wtime();
@@ -3719,6 +4040,7 @@ taucs_dtl(ccs_factor_ldlt_mf_maxdepth)(taucs_ccs_matrix* A,int max_depth)
 
   L = multifrontal_supernodal_create();
   if (!L) return NULL;
+  ldlt_pivoting_set(L,alpha,beta,perturb);
 
 #ifdef TAUCS_CORE_COMPLEX
   fail = taucs_ccs_ldlt_symbolic_elimination(A,L,
@@ -3739,8 +4061,8 @@ taucs_dtl(ccs_factor_ldlt_mf_maxdepth)(taucs_ccs_matrix* A,int max_depth)
   taucs_printf("\t\tSymbolic Analysis            = % 10.3f seconds (%.3f cpu)\n",
 	       wtime,ctime);
 
-  map = (int*)taucs_malloc((A->n+1)*sizeof(int));
-  if (!map) {
+  maps = multifrontal_bitmaps_create(A->n);
+  if (!maps) {
     taucs_supernodal_factor_ldlt_free(L);
     return NULL;
 
@@ -3749,8 +4071,9 @@ taucs_dtl(ccs_factor_ldlt_mf_maxdepth)(taucs_ccs_matrix* A,int max_depth)
 
   /*writeFactorFacts(L,"mfa");*/
 #ifdef TAUCS_HACK_LDLT_TESTING
-  get_input_parameters(gl_parameters);
+  get_input_parameters(gl_parameters,&(L->pivot_alpha),&(L->pivot_beta));
 #endif
+  ldlt_pivoting_prepare(L,A);
   switch(gl_factor_alg)	{
   case fa_right_looking:
     taucs_printf("\t\tUsing RightLooking update in dense factorization.\n");
@@ -3770,32 +4093,42 @@ taucs_dtl(ccs_factor_ldlt_mf_maxdepth)(taucs_ccs_matrix* A,int max_depth)
   ctime = taucs_ctime();
 
   fail = FALSE;
-  recursive_multifrontal_supernodal_factor_ldlt((L->n_sn),
-						TRUE,
-						map,
-						A,L,&fail,-1);
+  always_null = spawn recursive_multifrontal_supernodal_factor_ldlt((L->n_sn),
+								    TRUE,
+								    maps,
+								    A,L,&fail);
+  sync;
+
+  /* the root has no front to pass up; anything else is a bug */
+  if (always_null) {
+    supernodal_frontal_free(always_null);
+    fail = TRUE;
+  }
 
   wtime = taucs_wtime()-wtime;
   ctime = taucs_ctime()-ctime;
   taucs_printf("\t\tSupernodal Multifrontal LDL^T = % 10.3f seconds (%.3f cpu)\n",
 	       wtime,ctime);
 
-  taucs_free(map);
+  multifrontal_bitmaps_free(maps);
 
   if (fail) {
     taucs_supernodal_factor_ldlt_free(L);
     return NULL;
   }
 
+  if (L->pivot_perturb > 0.0)
+    taucs_printf("\t\tLDL^T static pivoting: %d perturbed pivots\n",L->perturbed);
+
   {
     double nnz   = 0.0;
     double flops = 0.0;
-    int bytes;
+    double bytes;
     
     taucs_get_statistics(&bytes,&flops,&nnz,L);
     
     taucs_printf("\t\tPost     Analysis of LDL^T: %.2e nonzeros, %.2e flops, %.2e bytes in L\n",
-		 nnz, flops, (float) bytes);
+		 nnz, flops, bytes);
   }
   
   /*writeFactorFacts(L,"mfb");*/
@@ -3849,37 +4182,52 @@ taucs_dtl(ccs_factor_ldlt_symbolic_maxdepth)(taucs_ccs_matrix* A, int
   return L;
 }
 
+cilk
 int
 taucs_dtl(ccs_factor_ldlt_numeric)(taucs_ccs_matrix* A,void* vL)
 {
   supernodal_factor_matrix_ldlt* L = (supernodal_factor_matrix_ldlt*) vL;
-  int* map;
+  int** maps;
   int fail;
   double wtime, ctime;
+  supernodal_frontal_matrix_ldlt* always_null;
+
+  maps = multifrontal_bitmaps_create(A->n);
+  if (!maps) return -1;
 
-  map = (int*)taucs_malloc((A->n+1)*sizeof(int));
+  ldlt_pivoting_prepare(L,A);
 
   wtime = taucs_wtime();
   ctime = taucs_ctime();
 
   fail = FALSE;
-  recursive_multifrontal_supernodal_factor_ldlt((L->n_sn),
-						TRUE,
-						map,
-						A,L,&fail,-1);
+  always_null = spawn recursive_multifrontal_supernodal_factor_ldlt((L->n_sn),
+								    TRUE,
+								    maps,
+								    A,L,&fail);
+  sync;
+
+  /* the root has no front to pass up; anything else is a bug */
+  if (always_null) {
+    supernodal_frontal_free(always_null);
+    fail = TRUE;
+  }
 
   wtime = taucs_wtime()-wtime;
   ctime = taucs_ctime()-ctime;
   taucs_printf("\t\tSupernodal Multifrontal LDL^T = % 10.3f seconds (%.3f cpu)\n",
 	       wtime,ctime);
 
-  taucs_free(map);
+  multifrontal_bitmaps_free(maps);
 
   if (fail) {
     taucs_supernodal_factor_ldlt_free_numeric(L);
     return -1;
   }
 
+  if (L->pivot_perturb > 0.0)
+    taucs_printf("\t\tLDL^T static pivoting: %d perturbed pivots\n",L->perturbed);
+
   return 0;
 }
 
@@ -4385,6 +4733,9 @@ leftlooking_supernodal_front_factor_ldlt(int sn,
   
   {
     int algorithm;
+    ldlt_pivoting piv;
+
+    ldlt_pivoting_copy(&piv,L);
     if ( sn == L->n_sn - 1 ) algorithm = fa_sytrf;
     else                     algorithm = fa_blocked;
     INFO = taucs_dtl(internal_supernodal_front_factor_ldlt)(fct,L->sn_blocks[sn],L->up_blocks[sn], 
@@ -4392,7 +4743,9 @@ leftlooking_supernodal_front_factor_ldlt(int sn,
 							    L->sn_size[sn], L->sn_up_size[sn] - L->sn_size[sn],sn,
 							    algorithm  
 							    /* was gl_factor_alg, but 
-							       this caused delays even in the last supernode */);
+							       this caused delays even in the last supernode */,
+							    &piv);
+    L->perturbed += piv.perturbed;
   }
 
   
@@ -4589,6 +4942,13 @@ void* taucs_dtl(ccs_factor_ldlt_ll)(taucs_ccs_matrix* A)
 
 void*
 taucs_dtl(ccs_factor_ldlt_ll_maxdepth)(taucs_ccs_matrix* A,int max_depth)
+{
+  return taucs_dtl(ccs_factor_ldlt_ll_pivoting)(A,max_depth,-1.0,-1.0,0.0);
+}
+
+void*
+taucs_dtl(ccs_factor_ldlt_ll_pivoting)(taucs_ccs_matrix* A,int max_depth,
+				       double alpha,double beta,double perturb)
 {
   supernodal_factor_matrix_ldlt* L;
   int* map;
@@ -4601,6 +4961,7 @@ taucs_dtl(ccs_factor_ldlt_ll_maxdepth)(taucs_ccs_matrix* A,int max_depth)
 
   L = multifrontal_supernodal_create();
   if (!L) return NULL;
+  ldlt_pivoting_set(L,alpha,beta,perturb);
 
   fail = taucs_ccs_ldlt_symbolic_elimination(A,L,
 					     TRUE /* sort row indices */,
@@ -4623,8 +4984,9 @@ taucs_dtl(ccs_factor_ldlt_ll_maxdepth)(taucs_ccs_matrix* A,int max_depth)
 
   /*writeFactorFacts(L,"lla");*/
 #ifdef TAUCS_HACK_LDLT_TESTING
-  get_input_parameters(gl_parameters);
+  get_input_parameters(gl_parameters,&(L->pivot_alpha),&(L->pivot_beta));
 #endif
+  ldlt_pivoting_prepare(L,A);
   switch(gl_factor_alg)	{
   case fa_right_looking:
     taucs_printf("\t\tUsing RightLooking update in dense factorization.\n");
@@ -4660,15 +5022,18 @@ taucs_dtl(ccs_factor_ldlt_ll_maxdepth)(taucs_ccs_matrix* A,int max_depth)
   taucs_printf("\t\tSupernodal Left-Looking LDL^T = % 10.3f seconds (%.3f cpu)\n",
 	       wtime,ctime);
 
+  if (L->pivot_perturb > 0.0)
+    taucs_printf("\t\tLDL^T static pivoting: %d perturbed pivots\n",L->perturbed);
+
   {
     double nnz   = 0.0;
     double flops = 0.0;
-    int bytes;
+    double bytes;
 
     taucs_get_statistics(&bytes,&flops,&nnz,L);
 
     taucs_printf("\t\tPost     Analysis of LDL^T: %.2e nonzeros, %.2e flops, %.2e bytes in L\n",
-		 nnz, flops, (float) bytes);
+		 nnz, flops, bytes);
   }
 
   taucs_free(map);
@@ -4693,6 +5058,7 @@ recursive_supernodal_solve_d(int sn,       /* this supernode */
 			     int* first_child, int* next_child,
 			     int** sn_struct, int* sn_sizes,
 			     taucs_datatype* diagonal[], int ** db_size,
+			     float beta,   /* the factor's zero threshold */
 			     taucs_datatype x[], taucs_datatype b[],
 			     taucs_datatype t[])
 {
@@ -4709,7 +5075,7 @@ recursive_supernodal_solve_d(int sn,       /* this supernode */
 				       FALSE,
 				       first_child,next_child,
 				       sn_struct,sn_sizes,
-				       diagonal, db_size,
+				       diagonal, db_size, beta,
 				       x,b,t);
     if ( ret ) return ret;
   }
@@ -4734,7 +5100,7 @@ recursive_supernodal_solve_d(int sn,       /* this supernode */
 	  /* check that if the diagonal was inf, then y[0] was 0.
 	     if not - there isn't a solution.*/
 	  if (isinf(taucs_re(diagonal[sn][i*2])) &&
-	      !taucs_is_zero(y[0]) )
+	      !taucs_is_zero(y[0],beta) )
 	    return -1;
 	}
 
@@ -4933,103 +5299,283 @@ recursive_supernodal_solve_lt(int sn,       /* this supernode */
 }
 
 
-int
-taucs_dtl(supernodal_solve_ldlt_many)(void* vL, int n,
-				      void* X, int ld_X,
-				      void* B, int ld_B)
+/*************************************************************/
+/* blocked solve routines for many right-hand sides          */
+/*************************************************************/
+
+/*
+  The multiple right-hand side solve works on a block of nrhs columns
+  of X at once (in place), so that the off-diagonal updates are done
+  with GEMM and the diagonal blocks with TRSM over all the columns,
+  and each 2-by-2 pivot is decomposed once for the whole block rather
+  than once per column.
+
+  Parallelism: the columns are split into blocks that are solved
+  concurrently, and in the backward solve the subtrees of each
+  supernode are independent, so they are spawned. The forward solve
+  scatters updates into shared ancestor rows, so within a column
+  block it walks the tree sequentially. The dense workspace of a
+  supernode is used only between spawns, so one workspace per worker
+  (indexed by Self) suffices.
+*/
+
+#define SOLVE_MANY_MIN_BLOCK 16
+
+static void
+blocked_supernodal_solve_l(int sn,       /* this supernode */
+			   int is_root,  /* is v the root? */
+			   supernodal_factor_matrix_ldlt* L,
+			   int nrhs,
+			   taucs_datatype X[], int ld_X,
+			   taucs_datatype T[])
 {
-  supernodal_factor_matrix_ldlt* L = (supernodal_factor_matrix_ldlt*) vL;
-  taucs_datatype* y;
-  taucs_datatype* t; /* temporary vector */
-  int     j=0,i,ret = 0;
-	
-  y = taucs_malloc((L->n) * sizeof(taucs_datatype));
-  t = taucs_malloc((L->n) * sizeof(taucs_datatype));
-  if (!y || !t ) {
-    taucs_free(y);
-    taucs_free(t);
-    taucs_printf("supernodal_solve_ldlt: out of memory\n");
-    return -1;
-  }
+  int child;
+  int sn_size; /* number of rows/columns in the supernode    */
+  int up_size; /* number of rows that this supernode updates */
+  int i,j;
+  int* rows;
+  taucs_datatype* xdense;
+  taucs_datatype* bdense;
 
-  for (j=0; j<n; j++) {
-    taucs_datatype* x = (taucs_datatype*) ((taucs_datatype*)X+(j*ld_X));
-    taucs_datatype* b = (taucs_datatype*) ((taucs_datatype*)B+(j*ld_B));
+  for (child = L->first_child[sn]; child != -1; child = L->next_child[child])
+    blocked_supernodal_solve_l(child,FALSE,L,nrhs,X,ld_X,T);
 
-    /*for(i=0;i<L->n;i++)
-      taucs_printf("%.4e ",b[i]);
-      taucs_printf("\n");*/
+  if (is_root) return;
 
-    /* before we start we need:
-       1. put b into y (for the l solve) */
-    for (i=0; i<L->n; i++) {
-      y[i] = b[i];
-    }
+  sn_size = L->sn_size[sn];
+  up_size = L->sn_up_size[sn] - L->sn_size[sn];
+  rows    = L->sn_struct[sn];
 
-    /*for(i=0;i<L->n;i++)
-      taucs_printf("%.4e ",y[i]);
-      taucs_printf("\n");*/
-
-    ret = recursive_supernodal_solve_l (L->n_sn,
-					TRUE,  /* this is the root */
-					L->first_child, L->next_child,
-					L->sn_struct,L->sn_size,L->sn_up_size,
-					L->sn_blocks_ld, L->sn_blocks,
-					L->up_blocks_ld, L->up_blocks,
-					x, y, t);
-
-    if ( ret ) {
-      taucs_free(y);
-      taucs_free(t);
-      taucs_printf("supernodal_solve_ldlt: No solution found.\n");
-      return -1;
+  if (sn_size == 0) return;
+
+  xdense = T;
+  bdense = T + sn_size*nrhs;
+
+  for (j=0; j<nrhs; j++)
+    for (i=0; i<sn_size; i++)
+      xdense[j*sn_size + i] = X[j*ld_X + rows[i]];
+
+  taucs_trsm ("Left",
+	      "Lower",
+	      "No Conjugate",
+	      "No unit diagonal",
+	      &sn_size,&nrhs,
+	      &taucs_one_const,
+	      L->sn_blocks[sn],&(L->sn_blocks_ld[sn]),
+	      xdense          ,&sn_size);
+
+  if (up_size > 0)
+    taucs_gemm ("No Conjugate","No Conjugate",
+		&up_size, &nrhs, &sn_size,
+		&taucs_one_const,
+		L->up_blocks[sn],&(L->up_blocks_ld[sn]),
+		xdense          ,&sn_size,
+		&taucs_zero_const,
+		bdense          ,&up_size);
+
+  for (j=0; j<nrhs; j++) {
+    for (i=0; i<sn_size; i++)
+      X[j*ld_X + rows[i]] = xdense[j*sn_size + i];
+    for (i=0; i<up_size; i++)
+      X[j*ld_X + rows[sn_size+i]] = 
+	taucs_sub( X[j*ld_X + rows[sn_size+i]], bdense[j*up_size + i] );
+  }
+}
+
+static int
+blocked_supernodal_solve_d(supernodal_factor_matrix_ldlt* L,
+			   int nrhs,
+			   taucs_datatype X[], int ld_X)
+{
+  taucs_datatype D[4], y[2], z[2], DL[4], DU[4];
+  taucs_datatype* d;
+  taucs_datatype  v;
+  int sn,i,j,need_switch;
+  int* rows;
+
+  for (sn=0; sn<L->n_sn; sn++) {
+    d    = L->d_blocks[sn];
+    rows = L->sn_struct[sn];
+
+    for (i=0; i<L->sn_size[sn]; i++) {
+      if ( L->db_size[sn][i] == 1 ) { /* a 1*1 block x = b/Aii */
+	for (j=0; j<nrhs; j++) {
+	  v = X[j*ld_X + rows[i]];
+	  /* if the diagonal is inf, b must be 0 or there is no solution */
+	  if (isinf(taucs_re(d[i*2])) && !taucs_is_zero(v,(float) L->pivot_beta))
+	    return -1;
+	  X[j*ld_X + rows[i]] = taucs_div( v, d[i*2] );
+	}
+      } else if ( L->db_size[sn][i] == 2 ) { /* a 2*2 block */
+	D[0] = d[2*i];
+	D[1] = D[2] = d[2*i+1];
+	D[3] = d[2*i+2];
+
+	need_switch = build_LU_from_D(D,DL,DU);
+
+	for (j=0; j<nrhs; j++) {
+	  z[0] = X[j*ld_X + rows[i]];
+	  z[1] = X[j*ld_X + rows[i+1]];
+	  two_times_two_diagonal_block_solve( D,y,z,gl_cramer_rule,FALSE,
+					      DL,DU,need_switch );
+	  X[j*ld_X + rows[i]]   = y[0];
+	  X[j*ld_X + rows[i+1]] = y[1];
+	}
+	i++;
+      } else { /* shouldn't get here */
+	taucs_printf("db_size[%d][%d] = %d\n",sn,i,L->db_size[sn][i] );
+	assert(0);
+	return -1;
+      }
     }
+  }
 
-    /*for(i=0;i<L->n;i++)
-      taucs_printf("%.4e ",x[i]);
-      taucs_printf("\n");*/
-
-    /* solve the Diagonal block */
-    ret = recursive_supernodal_solve_d(L->n_sn,
-				       TRUE,
-				       L->first_child, L->next_child,
-				       L->sn_struct,L->sn_size,L->d_blocks, L->db_size,
-				       y, x, t);
-
-    if ( ret ) {
-      taucs_free(y);
-      taucs_free(t);
-      taucs_printf("supernodal_solve_ldlt: No solution found.\n");
-      return -1;
+  return 0;
+}
+
+cilk
+static void
+blocked_supernodal_solve_lt(int sn,       /* this supernode */
+			    int is_root,  /* is v the root? */
+			    supernodal_factor_matrix_ldlt* L,
+			    int nrhs,
+			    taucs_datatype X[], int ld_X,
+			    taucs_datatype* T[])
+{
+  int child;
+  int sn_size; /* number of rows/columns in the supernode    */
+  int up_size; /* number of rows that this supernode updates */
+  int i,j;
+  int* rows;
+  taucs_datatype* xdense;
+  taucs_datatype* bdense;
+
+  if (!is_root && L->sn_size[sn] > 0) {
+    sn_size = L->sn_size[sn];
+    up_size = L->sn_up_size[sn] - L->sn_size[sn];
+    rows    = L->sn_struct[sn];
+
+    bdense = T[Self];
+    xdense = bdense + sn_size*nrhs;
+
+    for (j=0; j<nrhs; j++) {
+      for (i=0; i<sn_size; i++)
+	bdense[j*sn_size + i] = X[j*ld_X + rows[i]];
+      for (i=0; i<up_size; i++)
+	xdense[j*up_size + i] = X[j*ld_X + rows[sn_size+i]];
     }
 
-    /*for(i=0;i<L->n;i++)
-      taucs_printf("%.4e ",y[i]);
-      taucs_printf("\n");*/
+    if (up_size > 0)
+      taucs_gemm ("Conjugate","No Conjugate",
+		  &sn_size, &nrhs, &up_size,
+		  &taucs_minusone_const,
+		  L->up_blocks[sn],&(L->up_blocks_ld[sn]),
+		  xdense          ,&up_size,
+		  &taucs_one_const,
+		  bdense          ,&sn_size);
+
+    taucs_trsm ("Left",
+		"Lower",
+		"Conjugate",
+		"No unit diagonal",
+		&sn_size,&nrhs,
+		&taucs_one_const,
+		L->sn_blocks[sn],&(L->sn_blocks_ld[sn]),
+		bdense          ,&sn_size);
+
+    for (j=0; j<nrhs; j++)
+      for (i=0; i<sn_size; i++)
+	X[j*ld_X + rows[i]] = bdense[j*sn_size + i];
+  }
+
+  for (child = L->first_child[sn]; child != -1; child = L->next_child[child])
+    spawn blocked_supernodal_solve_lt(child,FALSE,L,nrhs,X,ld_X,T);
+  sync;
+}
+
+cilk
+static void
+blocked_supernodal_solve_ldlt_columns(supernodal_factor_matrix_ldlt* L,
+				      int nrhs, int nb,
+				      taucs_datatype X[], int ld_X,
+				      taucs_datatype* T[],
+				      int* fail)
+{
+  int half;
+
+  if (nrhs > nb) {
+    half = nrhs/2;
+    spawn blocked_supernodal_solve_ldlt_columns(L,half,nb,X,ld_X,T,fail);
+    spawn blocked_supernodal_solve_ldlt_columns(L,nrhs-half,nb,
+						X+half*ld_X,ld_X,T,fail);
+    sync;
+    return;
+  }
+
+  blocked_supernodal_solve_l(L->n_sn,TRUE,L,nrhs,X,ld_X,T[Self]);
+
+  if (blocked_supernodal_solve_d(L,nrhs,X,ld_X)) {
+    *fail = TRUE;
+    return;
+  }
+
+  spawn blocked_supernodal_solve_lt(L->n_sn,TRUE,L,nrhs,X,ld_X,T);
+  sync;
+}
+
+cilk
+int
+taucs_dtl(supernodal_solve_ldlt_many)(void* vL, int n,
+				      void* vX, int ld_X,
+				      void* vB, int ld_B)
+{
+  supernodal_factor_matrix_ldlt* L = (supernodal_factor_matrix_ldlt*) vL;
+  taucs_datatype* X = (taucs_datatype*) vX;
+  taucs_datatype* B = (taucs_datatype*) vB;
+  taucs_datatype** T;
+  int nb, maxsize, sn, i, j, fail;
+
+  if (n <= 0) return 0;
 
+  /* column block size: all the columns when running sequentially */
+  nb = (n + Cilk_active_size - 1) / Cilk_active_size;
+  if (nb < SOLVE_MANY_MIN_BLOCK) nb = SOLVE_MANY_MIN_BLOCK;
+  if (nb > n) nb = n;
 
-    ret = recursive_supernodal_solve_lt(L->n_sn,
-					TRUE,  /* this is the root */
-					L->first_child, L->next_child,
-					L->sn_struct,L->sn_size,L->sn_up_size,
-					L->sn_blocks_ld, L->sn_blocks,
-					L->up_blocks_ld, L->up_blocks,
-					x, y, t);
+  maxsize = 1;
+  for (sn=0; sn<L->n_sn; sn++)
+    maxsize = max(maxsize,L->sn_up_size[sn]);
 
-    if ( ret ) {
-      taucs_free(y);
-      taucs_free(t);
-      taucs_printf("supernodal_solve_ldlt: No solution found.\n");
+  T = (taucs_datatype**) taucs_calloc(Cilk_active_size,sizeof(taucs_datatype*));
+  if (!T) {
+    taucs_printf("supernodal_solve_ldlt: out of memory\n");
+    return -1;
+  }
+  for (i=0; i<Cilk_active_size; i++) {
+    T[i] = (taucs_datatype*) taucs_malloc(maxsize*nb*sizeof(taucs_datatype));
+    if (!T[i]) {
+      for (j=0; j<i; j++) taucs_free(T[j]);
+      taucs_free(T);
+      taucs_printf("supernodal_solve_ldlt: out of memory\n");
       return -1;
     }
+  }
+
+  for (j=0; j<n; j++)
+    for (i=0; i<L->n; i++)
+      X[j*ld_X + i] = B[j*ld_B + i];
+
+  fail = FALSE;
+  spawn blocked_supernodal_solve_ldlt_columns(L,n,nb,X,ld_X,T,&fail);
+  sync;
+
+  for (i=0; i<Cilk_active_size; i++) taucs_free(T[i]);
+  taucs_free(T);
 
-    /*for(i=0;i<L->n;i++)
-      taucs_printf("%.4e ",x[i]);
-      taucs_printf("\n");*/
+  if (fail) {
+    taucs_printf("supernodal_solve_ldlt: No solution found.\n");
+    return -1;
   }
-	
-  taucs_free(y);
-  taucs_free(t);
 
   return 0;
 }
@@ -5089,6 +5635,7 @@ taucs_dtl(supernodal_solve_ldlt)(void* vL, void* vx, void* vb)
 				     TRUE,
 				     L->first_child, L->next_child,
 				     L->sn_struct,L->sn_size,L->d_blocks, L->db_size,
+				     (float) L->pivot_beta,
 				     y, x, t);
 
   if ( ret ) {
@@ -5136,32 +5683,99 @@ taucs_dtl(supernodal_solve_ldlt)(void* vL, void* vx, void* vb)
 
 #ifdef TAUCS_CORE_DOUBLE/*GENERAL*/
 
+cilk
 void* taucs_ccs_factor_ldlt_mf_maxdepth(taucs_ccs_matrix* A,int max_depth)
 {
+  void* p = NULL;
+
+#ifdef TAUCS_DOUBLE_IN_BUILD
+  if (A->flags & TAUCS_DOUBLE)
+    p = spawn taucs_dccs_factor_ldlt_mf_maxdepth(A,max_depth);
+#endif
+
+#ifdef TAUCS_SINGLE_IN_BUILD
+  if (A->flags & TAUCS_SINGLE)
+    p = spawn taucs_sccs_factor_ldlt_mf_maxdepth(A,max_depth);
+#endif
+
+#ifdef TAUCS_DCOMPLEX_IN_BUILD
+  if (A->flags & TAUCS_DCOMPLEX)
+    p = spawn taucs_zccs_factor_ldlt_mf_maxdepth(A,max_depth);
+#endif
+
+#ifdef TAUCS_SCOMPLEX_IN_BUILD
+  if (A->flags & TAUCS_SCOMPLEX)
+    p = spawn taucs_cccs_factor_ldlt_mf_maxdepth(A,max_depth);
+#endif
+
+  sync;
+  return p;
+}
+
+cilk
+void* taucs_ccs_factor_ldlt_mf_pivoting(taucs_ccs_matrix* A,int max_depth,
+					double alpha,double beta,double perturb)
+{
+  void* p = NULL;
+
+#ifdef TAUCS_DOUBLE_IN_BUILD
+  if (A->flags & TAUCS_DOUBLE)
+    p = spawn taucs_dccs_factor_ldlt_mf_pivoting(A,max_depth,alpha,beta,perturb);
+#endif
+
+#ifdef TAUCS_SINGLE_IN_BUILD
+  if (A->flags & TAUCS_SINGLE)
+    p = spawn taucs_sccs_factor_ldlt_mf_pivoting(A,max_depth,alpha,beta,perturb);
+#endif
+
+#ifdef TAUCS_DCOMPLEX_IN_BUILD
+  if (A->flags & TAUCS_DCOMPLEX)
+    p = spawn taucs_zccs_factor_ldlt_mf_pivoting(A,max_depth,alpha,beta,perturb);
+#endif
+
+#ifdef TAUCS_SCOMPLEX_IN_BUILD
+  if (A->flags & TAUCS_SCOMPLEX)
+    p = spawn taucs_cccs_factor_ldlt_mf_pivoting(A,max_depth,alpha,beta,perturb);
+#endif
 
+  sync;
+  return p;
+}
+
+void* taucs_ccs_factor_ldlt_ll_pivoting(taucs_ccs_matrix* A,int max_depth,
+					double alpha,double beta,double perturb)
+{
 #ifdef TAUCS_DOUBLE_IN_BUILD
   if (A->flags & TAUCS_DOUBLE)
-    return taucs_dccs_factor_ldlt_mf_maxdepth(A,max_depth);
+    return taucs_dccs_factor_ldlt_ll_pivoting(A,max_depth,alpha,beta,perturb);
 #endif
 
 #ifdef TAUCS_SINGLE_IN_BUILD
   if (A->flags & TAUCS_SINGLE)
-    return taucs_sccs_factor_ldlt_mf_maxdepth(A,max_depth);
+    return taucs_sccs_factor_ldlt_ll_pivoting(A,max_depth,alpha,beta,perturb);
 #endif
 
 #ifdef TAUCS_DCOMPLEX_IN_BUILD
   if (A->flags & TAUCS_DCOMPLEX)
-    return taucs_zccs_factor_ldlt_mf_maxdepth(A,max_depth);
+    return taucs_zccs_factor_ldlt_ll_pivoting(A,max_depth,alpha,beta,perturb);
 #endif
 
 #ifdef TAUCS_SCOMPLEX_IN_BUILD
   if (A->flags & TAUCS_SCOMPLEX)
-    return taucs_cccs_factor_ldlt_mf_maxdepth(A,max_depth);
+    return taucs_cccs_factor_ldlt_ll_pivoting(A,max_depth,alpha,beta,perturb);
 #endif
 
   assert(0);
   return NULL;
 }
+
+/* the pivoting parameters do not depend on the data type */
+void taucs_supernodal_factor_ldlt_set_pivoting(void* vL,
+					       double alpha,double beta,double perturb)
+{
+  ldlt_pivoting_set((supernodal_factor_matrix_ldlt*) vL,alpha,beta,perturb);
+}
+
 void* taucs_ccs_factor_ldlt_symbolic_maxdepth(taucs_ccs_matrix* A,int
 					      max_depth)
 {
@@ -5246,90 +5860,96 @@ void* taucs_ccs_factor_ldlt_ll(taucs_ccs_matrix* A)
 
 
 
+cilk
 void* taucs_ccs_factor_ldlt_mf(taucs_ccs_matrix* A)
 {
+  void* p = NULL;
 
 #ifdef TAUCS_DOUBLE_IN_BUILD
   if (A->flags & TAUCS_DOUBLE)
-    return taucs_dccs_factor_ldlt_mf(A);
+    p = spawn taucs_dccs_factor_ldlt_mf(A);
 #endif
 
 #ifdef TAUCS_SINGLE_IN_BUILD
   if (A->flags & TAUCS_SINGLE)
-    return taucs_sccs_factor_ldlt_mf(A);
+    p = spawn taucs_sccs_factor_ldlt_mf(A);
 #endif
 
 #ifdef TAUCS_DCOMPLEX_IN_BUILD
   if (A->flags & TAUCS_DCOMPLEX)
-    return taucs_zccs_factor_ldlt_mf(A);
+    p = spawn taucs_zccs_factor_ldlt_mf(A);
 #endif
 
 #ifdef TAUCS_SCOMPLEX_IN_BUILD
   if (A->flags & TAUCS_SCOMPLEX)
-    return taucs_cccs_factor_ldlt_mf(A);
+    p = spawn taucs_cccs_factor_ldlt_mf(A);
 #endif
 
-  assert(0);
-  return NULL;
+  sync;
+  return p;
 }
 
 
 
 
+cilk
 int taucs_ccs_factor_ldlt_numeric(taucs_ccs_matrix* A, void* L)
 {
+  int p = -1;
 
 #ifdef TAUCS_DOUBLE_IN_BUILD
   if (A->flags & TAUCS_DOUBLE)
-    return taucs_dccs_factor_ldlt_numeric(A,L);
+    p = spawn taucs_dccs_factor_ldlt_numeric(A,L);
 #endif
 
 #ifdef TAUCS_SINGLE_IN_BUILD
   if (A->flags & TAUCS_SINGLE)
-    return taucs_sccs_factor_ldlt_numeric(A,L);
+    p = spawn taucs_sccs_factor_ldlt_numeric(A,L);
 #endif
 
 #ifdef TAUCS_DCOMPLEX_IN_BUILD
   if (A->flags & TAUCS_DCOMPLEX)
-    return taucs_zccs_factor_ldlt_numeric(A,L);
+    p = spawn taucs_zccs_factor_ldlt_numeric(A,L);
 #endif
 
 #ifdef TAUCS_SCOMPLEX_IN_BUILD
   if (A->flags & TAUCS_SCOMPLEX)
-    return taucs_cccs_factor_ldlt_numeric(A,L);
+    p = spawn taucs_cccs_factor_ldlt_numeric(A,L);
 #endif
 
-  assert(0);
-  return -1;
+  sync;
+  return p;
 }
 
+cilk
 int taucs_supernodal_solve_ldlt_many(void* L, int n,
 				     void* X, int ld_X,
 				     void* B, int ld_B)
 {
+  int rc = -1;
 
 #ifdef TAUCS_DOUBLE_IN_BUILD
   if (((supernodal_factor_matrix_ldlt*) L)->flags & TAUCS_DOUBLE)
-    return taucs_dsupernodal_solve_ldlt_many(L,n,X,ld_X,B,ld_B);
+    rc = spawn taucs_dsupernodal_solve_ldlt_many(L,n,X,ld_X,B,ld_B);
 #endif
 
 #ifdef TAUCS_SINGLE_IN_BUILD
   if (((supernodal_factor_matrix_ldlt*) L)->flags & TAUCS_SINGLE)
-    return taucs_ssupernodal_solve_ldlt_many(L,n,X,ld_X,B,ld_B);
+    rc = spawn taucs_ssupernodal_solve_ldlt_many(L,n,X,ld_X,B,ld_B);
 #endif
 
 #ifdef TAUCS_DCOMPLEX_IN_BUILD
   if (((supernodal_factor_matrix_ldlt*) L)->flags & TAUCS_DCOMPLEX)
-    return taucs_zsupernodal_solve_ldlt_many(L,n,X,ld_X,B,ld_B);
+    rc = spawn taucs_zsupernodal_solve_ldlt_many(L,n,X,ld_X,B,ld_B);
 #endif
 
 #ifdef TAUCS_SCOMPLEX_IN_BUILD
   if (((supernodal_factor_matrix_ldlt*) L)->flags & TAUCS_SCOMPLEX)
-    return taucs_csupernodal_solve_ldlt_many(L,n,X,ld_X,B,ld_B);
+    rc = spawn taucs_csupernodal_solve_ldlt_many(L,n,X,ld_X,B,ld_B);
 #endif
 
-  assert(0);
-  return -1;
+  sync;
+  return rc;
 }
 
 
@@ -5489,7 +6109,7 @@ taucs_supernodal_factor_diagonal_to_ccs(void* L)
   return NULL;
 }
 
-void	taucs_get_statistics(int* pbytes,double* pflops,double* pnnz,void* vL)
+void	taucs_get_statistics(double* pbytes,double* pflops,double* pnnz,void* vL)
 {
 #ifdef TAUCS_DOUBLE_IN_BUILD
   if (((supernodal_factor_matrix_ldlt*) vL)->flags & TAUCS_DOUBLE) {
@@ -5638,7 +6258,7 @@ taucs_ccs_ldlt_symbolic_elimination(taucs_ccs_matrix* A,
     double wtime;
     int *cc1,*cc2,*rc1,*rc2;
     int *p1;
-    int nnz1,nnz2;
+    taucs_index nnz1,nnz2;
 
     cc1=(int*)taucs_malloc((A->n)*sizeof(int));
     cc2=(int*)taucs_malloc((A->n)*sizeof(int));
@@ -5667,7 +6287,7 @@ taucs_ccs_ldlt_symbolic_elimination(taucs_ccs_matrix* A,
       assert(rc1[j]==rc2[j]);
     }
 
-    if (nnz1!=nnz2) printf("nnz1=%d nnz2=%d\n",nnz1,nnz2);
+    if (nnz1!=nnz2) printf("nnz1=%.0f nnz2=%.0f\n",(double) nnz1,(double) nnz2);
 
     taucs_free(cc1); taucs_free(cc2); taucs_free(rc1); taucs_free(rc2);
   }
@@ -5804,12 +6424,12 @@ taucs_ccs_ldlt_symbolic_elimination(taucs_ccs_matrix* A,
   {
     double nnz   = 0.0;
     double flops = 0.0;
-    int bytes;
+    double bytes;
 
     taucs_get_statistics(&bytes,&flops,&nnz,L);
 
     taucs_printf("\t\tSymbolic Analysis of LDL^T: %.2e nonzeros, %.2e flops, %.2e bytes in L\n",
-		 nnz, flops, (float) bytes);
+		 nnz, flops, bytes);
   }
 
   for (j=0; j < (A->n); j++) map[j] = -1;
@@ -5828,12 +6448,12 @@ taucs_ccs_ldlt_symbolic_elimination(taucs_ccs_matrix* A,
   {
     double nnz   = 0.0;
     double flops = 0.0;
-    int bytes;
+    double bytes;
 
     taucs_get_statistics(&bytes,&flops,&nnz,L);
 
     taucs_printf("\t\tRelaxed  Analysis of LDL^T: %.2e nonzeros, %.2e flops, %.2e bytes in L\n",
-		 nnz, flops, (float) bytes);
+		 nnz, flops, bytes);
   }
 
   /*
@@ -5852,6 +6472,23 @@ taucs_ccs_ldlt_symbolic_elimination(taucs_ccs_matrix* A,
   taucs_free(next_child);
   taucs_free(first_child);
 
+  /* as in the LL^T analysis, blocks and fronts are indexed with ints */
+  {
+    int sn;
+    double sn_size, up_size;
+
+    for (sn=0; sn<(L->n_sn); sn++) {
+      sn_size = (double) (L->sn_size)[sn];
+      up_size = (double) ((L->sn_up_size)[sn] - (L->sn_size)[sn]);
+      if ((sn_size + up_size) * sn_size > (double) INT_MAX
+	  || up_size * up_size > (double) INT_MAX) {
+	taucs_printf("taucs_ccs_ldlt_symbolic_elimination: supernode %d (%.0f columns, %.0f rows) too large for int block indices\n",
+		     sn,sn_size,sn_size+up_size);
+	return -1; /* the caller will free L */
+      }
+    }
+  }
+
   L->sn_blocks_ld  = taucs_malloc((L->n_sn) * sizeof(int));
   L->sn_blocks     = taucs_calloc((L->n_sn), sizeof(taucs_datatype*)); /* so
 									  we can free before allocation */
@@ -5,6 +5,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
+#include <limits.h>
 
 #define NDEBUG
 #include <assert.h>
@@ -853,8 +855,10 @@ taucs_dtl(supernodal_factor_to_ccs)(void* vL)
 {
   supernodal_factor_matrix* L = (supernodal_factor_matrix*) vL;
   taucs_ccs_matrix* C;
-  int n,nnz;
-  int i,j,ip,jp,sn,next;
+  int n;
+  taucs_int64 nnz; /* the factor may have more than 2^31 nonzeros */
+  int i,j,ip,jp,sn;
+  taucs_index next;
   taucs_datatype v;
   int* len;
 
@@ -900,8 +904,15 @@ taucs_dtl(supernodal_factor_to_ccs)(void* vL)
     }
   }
 
+  /* without INDEX64, CCS column pointers are ints */
+  if (nnz > (taucs_int64) TAUCS_INDEX_MAX) {
+    taucs_printf("supernodal_factor_to_ccs: factor has %.0f nonzeros, too many for a CCS matrix\n",
+		 (double) nnz);
+    taucs_free(len);
+    return NULL;
+  }
 
-  C = taucs_dtl(ccs_create)(n,n,nnz);
+  C = taucs_dtl(ccs_create)(n,n,(taucs_index) nnz);
   if (!C) {
     taucs_free(len);
     return NULL;
@@ -1363,14 +1374,14 @@ taucs_ccs_etree(taucs_ccs_matrix* A,
 		int* parent,
 		int* l_colcount,
 		int* l_rowcount,
-		int* l_nnz);
+		taucs_index* l_nnz);
 
 int 
 taucs_ccs_etree_liu(taucs_ccs_matrix* A,
 		    int* parent,
 		    int* l_colcount,
 		    int* l_rowcount,
-		    int* l_nnz);
+		    taucs_index* l_nnz);
 
 
 
@@ -1392,7 +1403,8 @@ recursive_symbolic_elimination(int            j,
 			       int            ipostorder[]
 			       )
 {
-  int  i,ip,c,c_sn;
+  int  i,c,c_sn;
+  taucs_index ip;
   int  in_previous_sn;
   int  nnz = 0; /* just to suppress the warning */
   
@@ -1549,8 +1561,8 @@ recursive_amalgamate_supernodes(int           sn,
   int new_sn_size, new_sn_up_size;
 
   sn_znz.zeros    = 0.0;
-  sn_znz.nonzeros = (double) (((sn_up_size[sn] - sn_size[sn]) * sn_size[sn]) 
-                              + (sn_size[sn] * (sn_size[sn] + 1))/2);
+  sn_znz.nonzeros = ((double) (sn_up_size[sn] - sn_size[sn]) * sn_size[sn]) 
+                    + ((double) sn_size[sn] * (sn_size[sn] + 1))/2.0;
 
   if (sn_first_child[sn] == -1) { /* leaf */
     return sn_znz;
@@ -1581,8 +1593,8 @@ recursive_amalgamate_supernodes(int           sn,
 				      do_order,ipostorder
 				      );
     assert(c_znz[i].zeros + c_znz[i].nonzeros ==
-	   (double) (((sn_up_size[c_sn] - sn_size[c_sn]) * sn_size[c_sn]) 
-		     + (sn_size[c_sn] * (sn_size[c_sn] + 1))/2 ));
+	   ((double) (sn_up_size[c_sn] - sn_size[c_sn]) * sn_size[c_sn]) 
+	   + ((double) sn_size[c_sn] * (sn_size[c_sn] + 1))/2.0);
     i++;
   }
 
@@ -2858,24 +2870,16 @@ recursive_supernodal_solve_lt(int sn,       /* this supernode */
 }
 
 
-int 
-taucs_dtl(supernodal_solve_llt)(void* vL, void* vx, void* vb)
+/* y and t are caller-supplied workspaces of length L->n */
+
+static void
+supernodal_solve_llt_workspace(supernodal_factor_matrix* L,
+			       taucs_datatype* x,
+			       taucs_datatype* b,
+			       taucs_datatype* y,
+			       taucs_datatype* t)
 {
-  supernodal_factor_matrix* L = (supernodal_factor_matrix*) vL;
-  taucs_datatype* x = (taucs_datatype*) vx;
-  taucs_datatype* b = (taucs_datatype*) vb;
-  taucs_datatype* y;
-  taucs_datatype* t; /* temporary vector */
-  int     i;
-  
-  y = taucs_malloc((L->n) * sizeof(taucs_datatype));
-  t = taucs_malloc((L->n) * sizeof(taucs_datatype));
-  if (!y || !t) {
-    taucs_free(y);
-    taucs_free(t);
-    taucs_printf("multifrontal_supernodal_solve_llt: out of memory\n");
-    return -1;
-  }
+  int i;
 
   for (i=0; i<L->n; i++) x[i] = b[i];
 
@@ -2894,12 +2898,321 @@ taucs_dtl(supernodal_solve_llt)(void* vL, void* vx, void* vb)
 				L->sn_blocks_ld, L->sn_blocks,
 				L->up_blocks_ld, L->up_blocks,
 				x, y, t);
+}
+
+int 
+taucs_dtl(supernodal_solve_llt)(void* vL, void* vx, void* vb)
+{
+  supernodal_factor_matrix* L = (supernodal_factor_matrix*) vL;
+  taucs_datatype* x = (taucs_datatype*) vx;
+  taucs_datatype* b = (taucs_datatype*) vb;
+  taucs_datatype* y;
+  taucs_datatype* t; /* temporary vector */
+  
+  y = taucs_malloc((L->n) * sizeof(taucs_datatype));
+  t = taucs_malloc((L->n) * sizeof(taucs_datatype));
+  if (!y || !t) {
+    taucs_free(y);
+    taucs_free(t);
+    taucs_printf("multifrontal_supernodal_solve_llt: out of memory\n");
+    return -1;
+  }
+
+  supernodal_solve_llt_workspace(L,x,b,y,t);
 
   taucs_free(y);
   taucs_free(t);
     
   return 0;
 }
+
+/*************************************************************/
+/* batched factor and solve routines                         */
+/*************************************************************/
+
+/* 
+   These routines factor and solve many small independent
+   systems in one call. Each matrix is factored by exactly the same
+   kernels as taucs_ccs_factor_llt_mf, so the factors are bitwise
+   identical, but the symbolic analysis is shared between consecutive
+   matrices with the same nonzero pattern, the bitmaps and solve
+   workspaces are allocated once for the whole batch, and the
+   per-matrix timing output is suppressed. Like taucs_ccs_factor_llt_mf,
+   the matrices are expected to be already permuted.
+
+   The symbolic phase uses static sort buffers, so it runs
+   sequentially; the numeric factorizations and the solves run
+   concurrently.
+*/
+
+static int
+batch_same_pattern(taucs_ccs_matrix* A, taucs_ccs_matrix* B)
+{
+  int j;
+  taucs_index ip,nnz;
+
+  if (A->n != B->n) return FALSE;
+  if ((A->flags & (TAUCS_LOWER | TAUCS_UPPER)) 
+      != (B->flags & (TAUCS_LOWER | TAUCS_UPPER))) return FALSE;
+
+  if (A->colptr != B->colptr)
+    for (j=0; j<=A->n; j++) 
+      if ((A->colptr)[j] != (B->colptr)[j]) return FALSE;
+
+  nnz = (A->colptr)[A->n];
+  if (A->rowind != B->rowind)
+    for (ip=0; ip<nnz; ip++) 
+      if ((A->rowind)[ip] != (B->rowind)[ip]) return FALSE;
+
+  return TRUE;
+}
+
+static supernodal_factor_matrix*
+multifrontal_supernodal_copy_symbolic(supernodal_factor_matrix* S)
+{
+  supernodal_factor_matrix* L;
+  int n    = S->n;
+  int n_sn = S->n_sn;
+  int sn;
+
+  L = multifrontal_supernodal_create();
+  if (!L) return NULL;
+
+  L->uplo = S->uplo;
+  L->n    = n;
+  L->n_sn = n_sn;
+
+  L->sn_struct     = (int**)taucs_calloc(n, sizeof(int*));
+  L->sn_size       = (int*) taucs_malloc((n+1)*sizeof(int));
+  L->sn_up_size    = (int*) taucs_malloc((n+1)*sizeof(int));
+  L->first_child   = (int*) taucs_malloc((n+1)*sizeof(int));
+  L->next_child    = (int*) taucs_malloc((n+1)*sizeof(int));
+  L->sn_blocks_ld  = (int*) taucs_malloc(n_sn*sizeof(int));
+  L->sn_blocks     = (taucs_datatype**)taucs_calloc(n_sn, sizeof(taucs_datatype*));
+  L->up_blocks_ld  = (int*) taucs_malloc(n_sn*sizeof(int));
+  L->up_blocks     = (taucs_datatype**)taucs_calloc(n_sn, sizeof(taucs_datatype*));
+
+  if (!(L->sn_struct) || !(L->sn_size) || !(L->sn_up_size)
+      || !(L->first_child) || !(L->next_child)
+      || !(L->sn_blocks_ld) || !(L->sn_blocks)
+      || !(L->up_blocks_ld) || !(L->up_blocks)) {
+    taucs_supernodal_factor_free(L);
+    return NULL;
+  }
+
+  memcpy(L->sn_size,    S->sn_size,    (n+1)*sizeof(int));
+  memcpy(L->sn_up_size, S->sn_up_size, (n+1)*sizeof(int));
+  memcpy(L->first_child,S->first_child,(n+1)*sizeof(int));
+  memcpy(L->next_child, S->next_child, (n+1)*sizeof(int));
+
+  for (sn=0; sn<n_sn; sn++) {
+    (L->sn_struct)[sn] = (int*) taucs_malloc((S->sn_up_size)[sn]*sizeof(int));
+    if (!(L->sn_struct)[sn]) {
+      taucs_supernodal_factor_free(L);
+      return NULL;
+    }
+    memcpy((L->sn_struct)[sn],(S->sn_struct)[sn],(S->sn_up_size)[sn]*sizeof(int));
+  }
+
+  return L;
+}
+
+cilk
+static void
+batch_factor_range(int first, int last, /* factor A[first..last-1] */
+		   taucs_ccs_matrix** A,
+		   void** vL,
+		   int** maps,
+		   int* fail)
+{
+  supernodal_factor_matrix* L;
+  supernodal_frontal_matrix* always_null;
+  int mid;
+
+  if (last - first > 1) {
+    mid = first + (last-first)/2;
+    spawn batch_factor_range(first,mid,A,vL,maps,fail);
+    spawn batch_factor_range(mid,last,A,vL,maps,fail);
+    sync;
+    return;
+  }
+
+  L = (supernodal_factor_matrix*) vL[first];
+  if (!L) return; /* symbolic phase failed */
+
+  always_null = spawn recursive_multifrontal_supernodal_factor_llt(L->n_sn,
+								   TRUE,
+								   maps,
+								   A[first],L,
+								   &(fail[first]));
+  sync;
+
+  /* the root has no front to pass up; anything else is a bug */
+  if (always_null) {
+    supernodal_frontal_free(always_null);
+    fail[first] = TRUE;
+  }
+}
+
+cilk
+int 
+taucs_dtl(ccs_factor_llt_mf_batch)(int nmatrices,
+				   taucs_ccs_matrix** A,
+				   void** vL)
+{
+  supernodal_factor_matrix* L;
+  int** maps;
+  int*  fail;
+  int   i,j,maxn,npatterns,rc;
+  double wtime, ctime;
+
+  if (nmatrices <= 0) return TAUCS_SUCCESS;
+
+  wtime = taucs_wtime();
+  ctime = taucs_ctime();
+
+  maxn = 0;
+  for (i=0; i<nmatrices; i++) {
+    vL[i] = NULL;
+    maxn = max(maxn,A[i]->n);
+  }
+
+  fail = (int*)  taucs_calloc(nmatrices, sizeof(int));
+  maps = (int**) taucs_calloc(Cilk_active_size, sizeof(int*));
+  if (!fail || !maps) {
+    taucs_free(fail);
+    taucs_free(maps);
+    return TAUCS_ERROR_NOMEM;
+  }
+  for (i=0; i < Cilk_active_size; i++) {
+    maps[i] = (int*)taucs_malloc((maxn+1)*sizeof(int));
+    if (!maps[i]) {
+      for (j=0; j < i ; j++)
+	taucs_free(maps[j]);
+      taucs_free(maps);
+      taucs_free(fail);
+      return TAUCS_ERROR_NOMEM;
+    }
+  }
+
+  /* symbolic phase, sequential */
+
+  rc = TAUCS_SUCCESS;
+  npatterns = 0;
+  for (i=0; i<nmatrices; i++) {
+    if (i > 0 && vL[i-1] && batch_same_pattern(A[i],A[i-1])) {
+      L = multifrontal_supernodal_copy_symbolic((supernodal_factor_matrix*) vL[i-1]);
+    } else {
+      L = multifrontal_supernodal_create();
+      if (L) {
+#ifdef TAUCS_CORE_COMPLEX
+	if (taucs_ccs_symbolic_elimination(A[i],L,
+					   TRUE /* sort, to avoid complex conjuation */,
+					   0) == -1) {
+#else
+	if (taucs_ccs_symbolic_elimination(A[i],L,
+					   FALSE /* don't sort row indices */,
+					   0) == -1) {
+#endif
+	  taucs_supernodal_factor_free(L);
+	  L = NULL;
+	}
+      }
+      npatterns++;
+    }
+    if (!L) rc = TAUCS_ERROR_NOMEM;
+    vL[i] = L;
+  }
+
+  /* numeric phase, concurrent */
+
+  spawn batch_factor_range(0,nmatrices,A,vL,maps,fail);
+  sync;
+
+  for (i=0; i<nmatrices; i++) {
+    if (fail[i]) {
+      taucs_supernodal_factor_free(vL[i]);
+      vL[i] = NULL;
+      if (rc == TAUCS_SUCCESS) rc = TAUCS_ERROR;
+    }
+  }
+
+  for (i=0; i < Cilk_active_size; i++)
+    taucs_free(maps[i]);
+  taucs_free(maps);
+  taucs_free(fail);
+
+  wtime = taucs_wtime()-wtime;
+  ctime = taucs_ctime()-ctime;
+  taucs_printf("\t\tBatched Multifrontal LL^T    = % 10.3f seconds (%.3f cpu), %d matrices, %d patterns\n",
+	       wtime,ctime,nmatrices,npatterns);
+
+  return rc;
+}
+
+cilk
+static void
+batch_solve_range(int first, int last, /* solve with L[first..last-1] */
+		  void** vL,
+		  void** vX,
+		  void** vB,
+		  taucs_datatype* work,
+		  int ldwork)
+{
+  taucs_datatype* y;
+  int mid;
+
+  if (last - first > 1) {
+    mid = first + (last-first)/2;
+    spawn batch_solve_range(first,mid,vL,vX,vB,work,ldwork);
+    spawn batch_solve_range(mid,last,vL,vX,vB,work,ldwork);
+    sync;
+    return;
+  }
+
+  if (!vL[first]) return;
+
+  /* the solve does not spawn, so the worker cannot change under us */
+  y = work + Self*2*ldwork;
+  supernodal_solve_llt_workspace((supernodal_factor_matrix*) vL[first],
+				 (taucs_datatype*) vX[first],
+				 (taucs_datatype*) vB[first],
+				 y, y + ldwork);
+}
+
+cilk
+int 
+taucs_dtl(supernodal_solve_llt_batch)(int nmatrices,
+				      void** vL,
+				      void** vX,
+				      void** vB)
+{
+  taucs_datatype* work;
+  int i,maxn;
+
+  if (nmatrices <= 0) return TAUCS_SUCCESS;
+
+  maxn = 0;
+  for (i=0; i<nmatrices; i++)
+    if (vL[i]) maxn = max(maxn,((supernodal_factor_matrix*) vL[i])->n);
+
+  work = (taucs_datatype*) 
+    taucs_malloc(2*Cilk_active_size*(maxn+1)*sizeof(taucs_datatype));
+  if (!work) {
+    taucs_printf("multifrontal_supernodal_solve_llt_batch: out of memory\n");
+    return TAUCS_ERROR_NOMEM;
+  }
+
+  spawn batch_solve_range(0,nmatrices,vL,vX,vB,work,maxn+1);
+  sync;
+
+  taucs_free(work);
+
+  for (i=0; i<nmatrices; i++)
+    if (!vL[i]) return TAUCS_ERROR;
+
+  return TAUCS_SUCCESS;
+}
 #endif /*#ifndef TAUCS_CORE_GENERAL*/
 
 /*************************************************************/
@@ -3105,6 +3418,74 @@ int taucs_ccs_factor_llt_numeric(taucs_ccs_matrix* A, void* L)
 }
 
 
+cilk
+int taucs_ccs_factor_llt_mf_batch(int nmatrices, taucs_ccs_matrix** A, void** L)
+{
+  int rc = TAUCS_ERROR;
+
+  if (nmatrices <= 0) return TAUCS_SUCCESS;
+
+#ifdef TAUCS_DOUBLE_IN_BUILD
+  if (A[0]->flags & TAUCS_DOUBLE)
+    rc = spawn taucs_dccs_factor_llt_mf_batch(nmatrices,A,L);
+#endif
+
+#ifdef TAUCS_SINGLE_IN_BUILD
+  if (A[0]->flags & TAUCS_SINGLE)
+    rc = spawn taucs_sccs_factor_llt_mf_batch(nmatrices,A,L);
+#endif
+
+#ifdef TAUCS_DCOMPLEX_IN_BUILD
+  if (A[0]->flags & TAUCS_DCOMPLEX)
+    rc = spawn taucs_zccs_factor_llt_mf_batch(nmatrices,A,L);
+#endif
+
+#ifdef TAUCS_SCOMPLEX_IN_BUILD
+  if (A[0]->flags & TAUCS_SCOMPLEX)
+    rc = spawn taucs_cccs_factor_llt_mf_batch(nmatrices,A,L);
+#endif
+  
+  sync;
+  return rc;
+}
+
+cilk
+int taucs_supernodal_solve_llt_batch(int nmatrices, void** L, void** X, void** B)
+{
+  int rc = TAUCS_ERROR;
+  int flags,i;
+
+  if (nmatrices <= 0) return TAUCS_SUCCESS;
+
+  /* failed factorizations are NULL; take the type from any other */
+  for (i=0; i<nmatrices && !L[i]; i++);
+  if (i == nmatrices) return TAUCS_ERROR;
+  flags = ((supernodal_factor_matrix*) L[i])->flags;
+
+#ifdef TAUCS_DOUBLE_IN_BUILD
+  if (flags & TAUCS_DOUBLE)
+    rc = spawn taucs_dsupernodal_solve_llt_batch(nmatrices,L,X,B);
+#endif
+
+#ifdef TAUCS_SINGLE_IN_BUILD
+  if (flags & TAUCS_SINGLE)
+    rc = spawn taucs_ssupernodal_solve_llt_batch(nmatrices,L,X,B);
+#endif
+
+#ifdef TAUCS_DCOMPLEX_IN_BUILD
+  if (flags & TAUCS_DCOMPLEX)
+    rc = spawn taucs_zsupernodal_solve_llt_batch(nmatrices,L,X,B);
+#endif
+
+#ifdef TAUCS_SCOMPLEX_IN_BUILD
+  if (flags & TAUCS_SCOMPLEX)
+    rc = spawn taucs_csupernodal_solve_llt_batch(nmatrices,L,X,B);
+#endif
+  
+  sync;
+  return rc;
+}
+
 int taucs_supernodal_solve_llt(void* L, void* x, void* b)
 {
 	
@@ -3262,7 +3643,7 @@ taucs_ccs_etree(taucs_ccs_matrix* A,
 		int* parent,
 		int* l_colcount,
 		int* l_rowcount,
-		int* l_nnz)
+		taucs_index* l_nnz)
 {
   int* prev_p;
   /*int* prev_nbr;omer*/
@@ -3279,12 +3660,13 @@ taucs_ccs_etree(taucs_ccs_matrix* A,
   int* ipostorder;
   int  *first_child,*next_child;
 
-  int i,j,k,ip,jp,kp;
-  int nnz,jnnz;
+  int i,j,k,jp;
+  taucs_index ip,kp;
+  taucs_index nnz,jnnz;
   int* uf;
-  int* rowptr;
+  taucs_index* rowptr;
   int* colind;
-  int* rowcount;
+  taucs_index* rowcount;
   int* realroot;
 
   /* we need the row structures for the lower triangle */
@@ -3292,8 +3674,8 @@ taucs_ccs_etree(taucs_ccs_matrix* A,
   nnz = (A->colptr)[n];
   
   uf       = (int*)taucs_malloc(n     * sizeof(int));
-  rowcount = (int*)taucs_malloc((n+1) * sizeof(int));
-  rowptr   = (int*)taucs_malloc((n+1) * sizeof(int));
+  rowcount = (taucs_index*)taucs_malloc((n+1) * sizeof(taucs_index));
+  rowptr   = (taucs_index*)taucs_malloc((n+1) * sizeof(taucs_index));
   colind   = (int*)taucs_malloc(nnz   * sizeof(int));
 
   if (!uf || !rowcount || !rowptr || !colind) {
@@ -3315,7 +3697,7 @@ taucs_ccs_etree(taucs_ccs_matrix* A,
 
   ip = 0;
   for (i=0; i <= n; i++) {
-    int next_ip = ip + rowcount[i];
+    taucs_index next_ip = ip + rowcount[i];
     rowcount[i] = ip;
     rowptr  [i] = ip;
     ip = next_ip;
@@ -3336,7 +3718,7 @@ taucs_ccs_etree(taucs_ccs_matrix* A,
 
   {
     int u,t,vroot;
-    realroot = rowcount; /* reuse space */
+    realroot = (int*) rowcount; /* reuse space */
 
     for (i=0; i<n; i++) {
       uf_makeset(uf,i);
@@ -3365,8 +3747,8 @@ taucs_ccs_etree(taucs_ccs_matrix* A,
   /* compute column counts */
 
   if (l_colcount || l_rowcount || l_nnz) {
-    int* l_nz;
-    int  tmp;
+    taucs_index* l_nz;
+    taucs_index  tmp;
     int  u,p,q;
 
     first_child = (int*)taucs_malloc((n+1) * sizeof(int));
@@ -3541,17 +3923,18 @@ taucs_ccs_etree_liu(taucs_ccs_matrix* A,
 		    int* parent,
 		    int* l_colcount,
 		    int* l_rowcount,
-		    int* l_nnz)
+		    taucs_index* l_nnz)
 {
   int n = A->n;
-  int i,j,k,ip,kp;/*jp omer*/
-  int nnz,jnnz;
+  int i,j,k;/*jp omer*/
+  taucs_index ip,kp;
+  taucs_index nnz,jnnz;
 
   int* uf;
-  int* rowptr;
+  taucs_index* rowptr;
   int* colind;
 
-  int* rowcount;
+  taucs_index* rowcount;
   int* marker;
   int* realroot;
 
@@ -3563,8 +3946,8 @@ taucs_ccs_etree_liu(taucs_ccs_matrix* A,
   nnz = (A->colptr)[n];
   
   uf       = (int*)taucs_malloc(n     * sizeof(int));
-  rowcount = (int*)taucs_malloc((n+1) * sizeof(int));
-  rowptr   = (int*)taucs_malloc((n+1) * sizeof(int));
+  rowcount = (taucs_index*)taucs_malloc((n+1) * sizeof(taucs_index));
+  rowptr   = (taucs_index*)taucs_malloc((n+1) * sizeof(taucs_index));
   colind   = (int*)taucs_malloc(nnz   * sizeof(int));
 
   for (i=0; i <=n; i++) rowcount[i] = 0;
@@ -3581,7 +3964,7 @@ taucs_ccs_etree_liu(taucs_ccs_matrix* A,
 
   ip = 0;
   for (i=0; i <= n; i++) {
-    int next_ip = ip + rowcount[i];
+    taucs_index next_ip = ip + rowcount[i];
     rowcount[i] = ip;
     rowptr  [i] = ip;
     ip = next_ip;
@@ -3603,7 +3986,7 @@ taucs_ccs_etree_liu(taucs_ccs_matrix* A,
 
   {
     int u,t,vroot;
-    realroot = rowcount; /* reuse space */
+    realroot = (int*) rowcount; /* reuse space */
 
     for (i=0; i<n; i++) {
       uf_makeset(uf,i);
@@ -3626,8 +4009,8 @@ taucs_ccs_etree_liu(taucs_ccs_matrix* A,
   /* compute column counts */
 
   if (l_colcount || l_rowcount || l_nnz) {
-    int* l_nz;
-    int  tmp;
+    taucs_index* l_nz;
+    taucs_index  tmp;
 
     /* we allocate scratch vectors to avoid conditionals */
     /* in the inner loop.                                */
@@ -3639,7 +4022,7 @@ taucs_ccs_etree_liu(taucs_ccs_matrix* A,
     if (l_nnz)      l_nz = l_nnz;
     else            l_nz = &tmp;
 
-    marker = rowcount; /* we reuse the space */
+    marker = (int*) rowcount; /* we reuse the space */
     
     for (j=0; j < n; j++) l_cc[j] = 1;
     *l_nz = n;
@@ -3752,7 +4135,7 @@ taucs_ccs_symbolic_elimination(taucs_ccs_matrix* A,
     double wtime;
     int *cc1,*cc2,*rc1,*rc2;
     int *p1;
-    int nnz1,nnz2;
+    taucs_index nnz1,nnz2;
 
     cc1=(int*)taucs_malloc((A->n)*sizeof(int));
     cc2=(int*)taucs_malloc((A->n)*sizeof(int));
@@ -3781,7 +4164,7 @@ taucs_ccs_symbolic_elimination(taucs_ccs_matrix* A,
       assert(rc1[j]==rc2[j]);
     }
 
-    if (nnz1!=nnz2) printf("nnz1=%d nnz2=%d\n",nnz1,nnz2);
+    if (nnz1!=nnz2) printf("nnz1=%.0f nnz2=%.0f\n",(double) nnz1,(double) nnz2);
     
     taucs_free(cc1); taucs_free(cc2); taucs_free(rc1); taucs_free(rc2);
   }
@@ -3911,7 +4294,7 @@ taucs_ccs_symbolic_elimination(taucs_ccs_matrix* A,
     double nnz   = 0.0;
     double flops = 0.0;
     int sn,i,colnnz;
-    int bytes;
+    double bytes;
     double max_front_size = 0.0;
 
     bytes = 
@@ -3925,7 +4308,7 @@ taucs_ccs_symbolic_elimination(taucs_ccs_matrix* A,
 
     for (sn=0; sn<(L->n_sn); sn++) {
       bytes += (L->sn_up_size)[sn] * sizeof(int);    
-      bytes += ((L->sn_size)[sn]*(L->sn_up_size)[sn]) * sizeof(taucs_datatype);
+      bytes += ((double) (L->sn_size)[sn]*(L->sn_up_size)[sn]) * sizeof(taucs_datatype);
       max_front_size = max(max_front_size,(double)(L->sn_up_size)[sn]);
 
       for (i=0, colnnz = (L->sn_up_size)[sn]; 
@@ -3939,7 +4322,7 @@ taucs_ccs_symbolic_elimination(taucs_ccs_matrix* A,
       }
     }
     taucs_printf("\t\tSymbolic Analysis of LL^T: %.2e nonzeros, %.2e flops, %.2e bytes in L\n",
-		 nnz, flops, (float) bytes);
+		 nnz, flops, bytes);
     taucs_printf("\t\t         Maximum front size = %.2e bytes (%.2e bytes packed)\n",
 		 ((double)sizeof(taucs_datatype))*max_front_size*max_front_size, 
 		 ((double)sizeof(taucs_datatype))*max_front_size*(max_front_size+1.0)/2.0);
@@ -3962,7 +4345,7 @@ taucs_ccs_symbolic_elimination(taucs_ccs_matrix* A,
     double nnz   = 0.0;
     double flops = 0.0;
     int sn,i,colnnz;
-    int bytes;
+    double bytes;
 
     bytes = 
       1*sizeof(char)                /* uplo             */
@@ -3975,7 +4358,7 @@ taucs_ccs_symbolic_elimination(taucs_ccs_matrix* A,
 
     for (sn=0; sn<(L->n_sn); sn++) {
       bytes += (L->sn_up_size)[sn] * sizeof(int);
-      bytes += ((L->sn_size)[sn]*(L->sn_up_size)[sn]) * sizeof(taucs_datatype);
+      bytes += ((double) (L->sn_size)[sn]*(L->sn_up_size)[sn]) * sizeof(taucs_datatype);
 
       for (i=0, colnnz = (L->sn_up_size)[sn]; 
 	   i<(L->sn_size)[sn]; 
@@ -3988,7 +4371,7 @@ taucs_ccs_symbolic_elimination(taucs_ccs_matrix* A,
       }
     }
     taucs_printf("\t\tRelaxed  Analysis of LL^T: %.2e nonzeros, %.2e flops, %.2e bytes in L\n",
-		 nnz, flops, (float) bytes);
+		 nnz, flops, bytes);
   }
 
   /*
@@ -4007,6 +4390,24 @@ taucs_ccs_symbolic_elimination(taucs_ccs_matrix* A,
   taucs_free(next_child);
   taucs_free(first_child);
 
+  /* the factor may have more than INT_MAX nonzeros under INDEX64, */
+  /* but each block and front is indexed with ints, as in the BLAS */
+  {
+    int sn;
+    double sn_size, up_size;
+
+    for (sn=0; sn<(L->n_sn); sn++) {
+      sn_size = (double) (L->sn_size)[sn];
+      up_size = (double) ((L->sn_up_size)[sn] - (L->sn_size)[sn]);
+      if ((sn_size + up_size) * sn_size > (double) INT_MAX
+	  || up_size * up_size > (double) INT_MAX) {
+	taucs_printf("taucs_ccs_symbolic_elimination: supernode %d (%.0f columns, %.0f rows) too large for int block indices\n",
+		     sn,sn_size,sn_size+up_size);
+	return -1; /* the caller will free L */
+      }
+    }
+  }
+
   L->sn_blocks_ld  = (int*)taucs_malloc((L->n_sn) * sizeof(int));
   L->sn_blocks     = (taucs_datatype**)taucs_calloc((L->n_sn), sizeof(taucs_datatype*)); /* so we can free before allocation */
   
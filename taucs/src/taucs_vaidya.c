@@ -12,6 +12,9 @@
 #include <assert.h>
 #include "taucs.h"
 
+#ifdef TAUCS_CONFIG_PFUNC
+#include "pfunc.h"
+#endif
 
 /*********************************************************/
 /*                                                       */
@@ -48,46 +51,65 @@ typedef struct {
 
 /************** UNION FIND ***********/
 
-static char *label = NULL;
-static int *p      = NULL;
-static int *rank   = NULL;
+/*
+  The union-find state is owned by the caller, so several
+  preconditioners can be built concurrently.
+*/
+
+typedef struct {
+  char* label;
+  int*  p;
+  int*  rank;
+} unionfind;
 
 static
-int unionfind_init(int size)
+unionfind* unionfind_create(int size)
 {
   int i;
-  p = (int *)taucs_malloc(size * sizeof(int));
-  rank = (int *)taucs_malloc(size * sizeof(int));
-  label = (char *)taucs_malloc(size * sizeof(char));
-  if (!p || !rank || !label) {
-    taucs_free(p);
-    taucs_free(rank);
-    taucs_free(label);
-    return -1;
+  unionfind* uf;
+
+  uf = (unionfind*) taucs_malloc(sizeof(unionfind));
+  if (!uf) return NULL;
+
+  uf->p = (int *)taucs_malloc(size * sizeof(int));
+  uf->rank = (int *)taucs_malloc(size * sizeof(int));
+  uf->label = (char *)taucs_malloc(size * sizeof(char));
+  if (!(uf->p) || !(uf->rank) || !(uf->label)) {
+    taucs_free(uf->p);
+    taucs_free(uf->rank);
+    taucs_free(uf->label);
+    taucs_free(uf);
+    return NULL;
   }
 
   Do(i,size)
     {
-      p[i] = i;
-      rank[i] = 0;
-      label[i] = 0;
+      (uf->p)[i] = i;
+      (uf->rank)[i] = 0;
+      (uf->label)[i] = 0;
     }
 
-  return 0;
+  return uf;
 }
 
 static void 
-unionfind_free (void)
+unionfind_free (unionfind* uf)
 {
-  taucs_free(p);
-  taucs_free(rank);
-  taucs_free(label);
+  if (!uf) return;
+  taucs_free(uf->p);
+  taucs_free(uf->rank);
+  taucs_free(uf->label);
+  taucs_free(uf);
 }
 
 static
-int Union(int a,int b,int x,int y,int l) /* unite a's and b's trees, whose roots are x and y. returns the root
+int Union(unionfind* uf,int a,int b,int x,int y,int l) /* unite a's and b's trees, whose roots are x and y. returns the root
 					  of the united tree */
 {
+  int*  p     = uf->p;
+  int*  rank  = uf->rank;
+  char* label = uf->label;
+
   if (rank[x] > rank[y])
     {
       p[y] = x;
@@ -104,14 +126,21 @@ int Union(int a,int b,int x,int y,int l) /* unite a's and b's trees, whose roots
     }
 }
 
+/*
+  Union by rank keeps the trees O(log n) deep, so the recursion
+  in the path compression is shallow.
+*/
+
 static
-int find_set(int x)
+int find_set(unionfind* uf,int x)
 {
   int tmp;
+  int*  p     = uf->p;
+  char* label = uf->label;
 
   if (x != p[x])
     {
-      tmp = find_set(p[x]);
+      tmp = find_set(uf,p[x]);
       label[x] ^= label[p[x]];
       p[x] = tmp;
     }
@@ -394,6 +423,102 @@ int heap_sort(int size,heap *h,graph *A)
 }
 #endif /* 0, no heap_sort */
 
+/*
+  Sort the edges by decreasing weight with an LSD radix sort on the
+  bit patterns of the (nonnegative) keys. Nonnegative IEEE doubles
+  order like their bit patterns, so we complement the two 32-bit
+  halves and sort them ascending, 11 bits per pass, skipping passes
+  in which all keys share the same digit (the exponent bits usually
+  do). The sort is stable, so equal weights stay in edge order.
+  Returns 0 if the scratch space cannot be allocated or if the
+  platform does not split doubles into two 32-bit unsigned ints; the
+  caller then falls back to the heap sort.
+*/
+
+#define RADIX_BITS    11
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_CUTOFF  256
+
+static int pqueue_radix_sort(heap* h, int size)
+{
+  unsigned int* words;
+  unsigned int* words_tmp;
+  int*          edges_tmp;
+  double*       key_tmp;
+  int*          count;
+  unsigned int  w[2];
+  double        one = 1.0;
+  int           hi, lo;
+  int           i,dst,half,shift,pos,d;
+
+  if (sizeof(double) != 2*sizeof(unsigned int) || sizeof(unsigned int) != 4)
+    return 0;
+
+  /* which half holds the sign and exponent? */
+  memcpy(w,&one,sizeof(double));
+  if (w[0] == 0) { hi = 1; lo = 0; }
+  else           { hi = 0; lo = 1; }
+
+  words     = (unsigned int*) taucs_malloc(2 * size * sizeof(unsigned int));
+  words_tmp = (unsigned int*) taucs_malloc(2 * size * sizeof(unsigned int));
+  /* these swap roles with h's arrays, so they get h's capacity */
+  edges_tmp = (int*)          taucs_malloc(h->alloc_size * sizeof(int));
+  key_tmp   = (double*)       taucs_malloc(h->alloc_size * sizeof(double));
+  count     = (int*)          taucs_malloc(RADIX_BUCKETS * sizeof(int));
+  if (!words || !words_tmp || !edges_tmp || !key_tmp || !count) {
+    taucs_free(words);
+    taucs_free(words_tmp);
+    taucs_free(edges_tmp);
+    taucs_free(key_tmp);
+    taucs_free(count);
+    return 0;
+  }
+
+  Do(i,size) {
+    memcpy(w,&(h->key[i]),sizeof(double));
+    words[2*i]   = ~w[lo];
+    words[2*i+1] = ~w[hi];
+  }
+
+  for (half=0; half<2; half++) {
+    for (shift=0; shift<32; shift += RADIX_BITS) {
+      int*          te;
+      double*       tk;
+      unsigned int* tw;
+
+      Do(d,RADIX_BUCKETS) count[d] = 0;
+      Do(i,size) count[ (words[2*i+half] >> shift) & (RADIX_BUCKETS-1) ]++;
+
+      /* all keys share this digit, the pass would be the identity */
+      if (count[ (words[half] >> shift) & (RADIX_BUCKETS-1) ] == size)
+	continue;
+
+      pos = 0;
+      Do(d,RADIX_BUCKETS) { int c = count[d]; count[d] = pos; pos += c; }
+
+      Do(i,size) {
+	dst = count[ (words[2*i+half] >> shift) & (RADIX_BUCKETS-1) ]++;
+	edges_tmp[dst]     = h->edges[i];
+	key_tmp[dst]       = h->key[i];
+	words_tmp[2*dst]   = words[2*i];
+	words_tmp[2*dst+1] = words[2*i+1];
+      }
+
+      te = h->edges; h->edges = edges_tmp; edges_tmp = te;
+      tk = h->key;   h->key   = key_tmp;   key_tmp   = tk;
+      tw = words;    words    = words_tmp; words_tmp = tw;
+    }
+  }
+
+  taucs_free(words);
+  taucs_free(words_tmp);
+  taucs_free(edges_tmp);
+  taucs_free(key_tmp);
+  taucs_free(count);
+
+  return 1;
+}
+
 static int pqueue_fill(heap* h, graph* G)
 {
   int i,size;
@@ -410,6 +535,9 @@ static int pqueue_fill(heap* h, graph* G)
   
   h->heap_size = size;
 
+  if (size >= RADIX_CUTOFF && pqueue_radix_sort(h,size))
+    return size;
+
 #define noQSORT
 #ifdef QSORT
   quick_sort(*h,0,size-1);
@@ -1342,8 +1470,9 @@ void divide_to_groups(int r,int *first_child,int *next_child,int *pi,int *curr_g
   if(first_child[r] == -1)   
     return;
 
-  stack_array1 = (int*)taucs_calloc(n+1,sizeof(int));
-  stack_array2 = (int*)taucs_calloc(n+1,sizeof(int));
+  /* no need to clear the stacks; see DFS_visit */
+  stack_array1 = (int*)taucs_malloc((n+1)*sizeof(int));
+  stack_array2 = (int*)taucs_malloc((n+1)*sizeof(int));
   stack_top = 0;
 
   if ((!stack_array1) || (!stack_array2))
@@ -1441,8 +1570,9 @@ void DFS_visit(graph *precond,int r,byte *color,linked l,int *pi,int *visited, i
   edge *p;
   int r1;
   int stack_top = 0;
-  edge ** stack_array1 = (edge**)taucs_calloc(n+1,sizeof(edge*));
-  int * stack_array2 = (int*)taucs_calloc(n+1,sizeof(int));
+  /* called once per tree; clearing O(n) stacks each time was quadratic */
+  edge ** stack_array1 = (edge**)taucs_malloc((n+1)*sizeof(edge*));
+  int * stack_array2 = (int*)taucs_malloc((n+1)*sizeof(int));
 
   //  taucs_logfile("stderr");
 
@@ -1551,6 +1681,7 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
   heap Bh;
   heap h;
 #endif
+  unionfind* uf;
   int Bent;
   /*int row,col;*/
   double weight;
@@ -1776,7 +1907,7 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
   /* initialize union-find                                */
   /********************************************************/
 
-  if (unionfind_init(n) == -1) {
+  if ((uf = unionfind_create(n)) == NULL) {
     free_graph(mtxA_tmp);
     free_graph(precond);
     taucs_free(diag);
@@ -1807,7 +1938,7 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
     taucs_free(already_added);
     taucs_free(pi);
     taucs_free(closed_cycle);
-    unionfind_free();
+    unionfind_free(uf);
     return NULL;
   }
   size = pqueue_fill(&Ah,mtxA_tmp);
@@ -1844,8 +1975,8 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
       
       edge_sign = (weight>0);
 
-      x = find_set(u);
-      y = find_set(v);
+      x = find_set(uf,u);
+      y = find_set(uf,v);
 
       if (x!=y)
 	{
@@ -1873,7 +2004,7 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
 #else
 	      already_added[i] = 1;
 #endif
-	      un_root = Union(u,v,x,y,edge_sign);
+	      un_root = Union(uf,u,v,x,y,edge_sign);
 	      closed_cycle[un_root] = closed_cycle[x] | closed_cycle[y];
 	    }
 	  /* else
@@ -1885,7 +2016,7 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
       else
 	{
 	  /* printf("same tree\n"); */
-	  if ((edge_sign != (label[u]^label[v])) && (closed_cycle[x]==0))
+	  if ((edge_sign != (uf->label[u]^uf->label[v])) && (closed_cycle[x]==0))
 	    {
 	      count++;
 	      /* printf("(%d,%d) - %lf\n",u,v,weight); */
@@ -1932,7 +2063,7 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
 #ifdef USE_HEAPSORT
   /*free_heap(h);*/
 #endif
-  unionfind_free();
+  unionfind_free(uf);
 
   precond->nent = Bent;
   basis_Bent = Bent;
@@ -2105,7 +2236,7 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
      to complete the subgraph into a basis (if such an edge exists) */
   
   /* Variation on Kruskal - Introduction to Algorithms page 505 */
-  if (unionfind_init(n) == -1) {
+  if ((uf = unionfind_create(n)) == NULL) {
     free_graph(mtxA_tmp);
     free_graph(precond);
     free_linked_list(l);
@@ -2125,7 +2256,7 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
     free_graph(mtxA_tmp);
     free_graph(precond);
     free_linked_list(l);
-    unionfind_free();
+    unionfind_free(uf);
     taucs_free(diag);
     taucs_free(already_added);
     taucs_free(pi);
@@ -2145,7 +2276,7 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
     free_graph(mtxA_tmp);
     free_graph(precond);
     free_linked_list(l);
-    unionfind_free();
+    unionfind_free(uf);
     taucs_free(diag);
     taucs_free(already_added);
     taucs_free(pi);
@@ -2162,7 +2293,7 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
     taucs_free(already_added);
     taucs_free(pi);
     taucs_free(closed_cycle);
-    unionfind_free();
+    unionfind_free(uf);
     return NULL;
   }
   size = pqueue_fill(&Bh,precond);
@@ -2200,14 +2331,14 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
 	  
 	  edge_sign = (weight>0);
 	  
-	  x = find_set(u);
-	  y = find_set(v);
+	  x = find_set(uf,u);
+	  y = find_set(uf,v);
 	  
 	  if (x!=y)
 	    {
 	      if (!((closed_cycle[x])&&(closed_cycle[y])))
 		{
-		  un_root = Union(u,v,x,y,edge_sign);
+		  un_root = Union(uf,u,v,x,y,edge_sign);
 		  closed_cycle[un_root] = closed_cycle[x] | closed_cycle[y];
 		}
 	      else
@@ -2215,7 +2346,7 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
 	    }
 	  else
 	    {
-	      if ((edge_sign != (label[u]^label[v])) && (closed_cycle[x]==0))
+	      if ((edge_sign != (uf->label[u]^uf->label[v])) && (closed_cycle[x]==0))
 		closed_cycle[x] = 1;
 	    }
 	  
@@ -2231,7 +2362,7 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
     free_graph(mtxA_tmp);
     free_graph(precond);
     free_linked_list(l);
-    unionfind_free();
+    unionfind_free(uf);
     taucs_free(diag);
     taucs_free(already_added);
     taucs_free(pi);
@@ -2273,8 +2404,8 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
 	  
 	  edge_sign = (weight>0);
 	  
-	  x = find_set(u);
-	  y = find_set(v);
+	  x = find_set(uf,u);
+	  y = find_set(uf,v);
 	  
 	  if (x!=y)
 	    {
@@ -2301,13 +2432,13 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
 		  complete_subgraph[groups[u]].b = v;
 		  complete_subgraph[groups[u]].c = weight;
 
-		  un_root = Union(u,v,x,y,edge_sign);
+		  un_root = Union(uf,u,v,x,y,edge_sign);
 		  closed_cycle[un_root] = closed_cycle[x] | closed_cycle[y];
 		}
 	    }
 	  else
 	    {
-	      if ((edge_sign != (label[u]^label[v])) && (closed_cycle[x]==0))
+	      if ((edge_sign != (uf->label[u]^uf->label[v])) && (closed_cycle[x]==0))
 		{
 		  /*
 		    ivec1_p[Bent] = u; 
@@ -2339,7 +2470,7 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
   /*    free_heap(h);*/
 #endif
   taucs_free(closed_cycle);
-  unionfind_free();
+  unionfind_free(uf);
   
   /*** ALLOCATED: mtxA_tmp,diag,already_added,pi,precond,linked ***/
   /*** ALLOCATED: groups,complete_subgraph ***/
@@ -2375,7 +2506,7 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
     /*** ALLOCATED: mtxA_tmp,diag,already_added,pi,precond,linked ***/
     /*** ALLOCATED: groups,complete_subgraph,pairs,closed_cycle ***/
 
-    if (unionfind_init(n) == -1) {
+    if ((uf = unionfind_create(n)) == NULL) {
       free_graph(mtxA_tmp);
       free_graph(precond);
       free_linked_list(l);
@@ -2400,7 +2531,7 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
       free_graph(mtxA_tmp);
       free_graph(precond);
       free_linked_list(l);
-      unionfind_free();
+      unionfind_free(uf);
       taucs_free(diag);
       taucs_free(already_added);
       taucs_free(pi);
@@ -2446,20 +2577,20 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
 	    
 	    edge_sign = (weight>0);
 	    
-	    x = find_set(u);
-	    y = find_set(v);
+	    x = find_set(uf,u);
+	    y = find_set(uf,v);
 	    
 	    if (x!=y)
 	      {
 		if (!((closed_cycle[x])&&(closed_cycle[y])))
 		  {
-		    un_root = Union(u,v,x,y,edge_sign);
+		    un_root = Union(uf,u,v,x,y,edge_sign);
 		    closed_cycle[un_root] = closed_cycle[x] | closed_cycle[y];
 		  }
 	      }
 	    else
 	      {
-		if ((edge_sign != (label[u]^label[v])) && (closed_cycle[x]==0))
+		if ((edge_sign != (uf->label[u]^uf->label[v])) && (closed_cycle[x]==0))
 		  closed_cycle[x] = 1;
 	      }
 	    
@@ -2475,7 +2606,7 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
       free_graph(mtxA_tmp);
       free_graph(precond);
       free_linked_list(l);
-      unionfind_free();
+      unionfind_free(uf);
       taucs_free(diag);
       taucs_free(already_added);
       taucs_free(pi);
@@ -2525,7 +2656,7 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
 	      free_graph(mtxA_tmp);
 	      free_graph(precond);
 	      free_linked_list(l);
-	      unionfind_free();
+	      unionfind_free(uf);
 #ifdef USE_HEAPSORT
 	      free_heap(h);
 #endif
@@ -2569,7 +2700,7 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
 		  free_graph(mtxA_tmp);
 		  free_graph(precond);
 		  free_linked_list(l);
-		  unionfind_free();
+		  unionfind_free(uf);
 #ifdef USE_HEAPSORT
 		  free_heap(h);
 #endif
@@ -2602,8 +2733,8 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
 		
 		edge_sign = (weight>0);
 		
-		x = find_set(u);
-		y = find_set(v);
+		x = find_set(uf,u);
+		y = find_set(uf,v);
 		closed_cycle_x = closed_cycle[x];
 		closed_cycle_y = closed_cycle[y];
 
@@ -2683,7 +2814,7 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
 			(p->no_edges)++;
 		      }
 		    } else {
-		      if ((edge_sign != (label[u]^label[v])) && (closed_cycle[x]==0)) {
+		      if ((edge_sign != (uf->label[u]^uf->label[v])) && (closed_cycle[x]==0)) {
 #ifdef USE_HEAPSORT
 			if (already_added[Ah.edges[i]]==0)
 #else
@@ -2754,11 +2885,11 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
 		    if ((!closed_cycle_x)&&(!closed_cycle_y)&&(p->cross[0]==1))
 		      {
 			int x1,y1,edge_sign1;
-			x1 = find_set(p->a[0]);
-			y1 = find_set(p->b[0]);
+			x1 = find_set(uf,p->a[0]);
+			y1 = find_set(uf,p->b[0]);
 			edge_sign1 = (p->c[0]>0);			    
 			
-			if ((edge_sign^edge_sign1^label[u]^label[v]^label[p->a[0]]^label[p->b[0]]) ==1)
+			if ((edge_sign^edge_sign1^uf->label[u]^uf->label[v]^uf->label[p->a[0]]^uf->label[p->b[0]]) ==1)
 			  {
 #ifdef USE_HEAPSORT
 			    if (already_added[Ah.edges[i]]==0)
@@ -2799,7 +2930,7 @@ amwb_preconditioner_create(taucs_ccs_matrix *taucs_ccs_mtxA,
     taucs_free(pairs);
 
     taucs_free(closed_cycle);
-    unionfind_free();
+    unionfind_free(uf);
     
     precond->nent = Bent;
 
@@ -2913,9 +3044,16 @@ typedef struct msthea {
 
 #define INF 100000000.0
 
-#define Parent(i) ((((i)+1)/2) - 1)
-#define Left(i) ((((i)+1)*2) - 1)
-#define Right(i) ((((i)+1)*2 + 1) - 1)
+/*
+  The MST heap is an indexed 4-ary max-heap: it is half as deep as a
+  binary heap, so increase_key (the common operation in Prim) touches
+  half as many levels, and the four children of a node are adjacent
+  in memory.
+*/
+
+#define MST_ARITY 4
+#define MstParent(i) (((i)-1)/MST_ARITY)
+#define MstChild(i)  (MST_ARITY*(i)+1)
 
 static
 void mstheap_exchange(mstheap A,int a,int b,int *point_to_heap)
@@ -2938,24 +3076,34 @@ void mstheap_exchange(mstheap A,int a,int b,int *point_to_heap)
 static
 void Mstheapify(mstheap A,int i,int *point_to_heap)
 {
-  int l,r,largest;
-  
-  l = Left(i);
-  r = Right(i);
-  
-  if ((l < A.heap_size) && (A.key[l] > A.key[i]))
-    largest = l;
-  else
-    largest = i;
+  int c,c_end,largest;
+  int ver;
+  double key;
 
-  if ((r < A.heap_size) && (A.key[r] > A.key[largest]))
-    largest = r;
+  key = A.key[i];
+  ver = A.vertices[i];
 
-  if (largest != i)
-    {
-      mstheap_exchange(A,i,largest,point_to_heap);
-      Mstheapify(A,largest,point_to_heap);
-    }
+  for (;;) {
+    c = MstChild(i);
+    if (c >= A.heap_size) break;
+    c_end = c + MST_ARITY;
+    if (c_end > A.heap_size) c_end = A.heap_size;
+
+    largest = c;
+    for (c++; c < c_end; c++)
+      if (A.key[c] > A.key[largest]) largest = c;
+
+    if (!(A.key[largest] > key)) break;
+
+    A.key[i]      = A.key[largest];
+    A.vertices[i] = A.vertices[largest];
+    point_to_heap[A.vertices[i]] = i;
+    i = largest;
+  }
+
+  A.key[i]      = key;
+  A.vertices[i] = ver;
+  point_to_heap[ver] = i;
 }
 
 static
@@ -3023,12 +3171,12 @@ void mstheap_increase_key(mstheap h,int vv,double val,int *point_to_heap)
 
   i = v;
 
-  while((i>0) && (h.key[Parent(i)] < key))
+  while((i>0) && (h.key[MstParent(i)] < key))
     {
-      h.key[i]      = h.key[Parent(i)];
-      h.vertices[i] = h.vertices[Parent(i)];
+      h.key[i]      = h.key[MstParent(i)];
+      h.vertices[i] = h.vertices[MstParent(i)];
       point_to_heap[h.vertices[i]] = i;
-      i = Parent(i);
+      i = MstParent(i);
     }
   
   h.key[i] = key;
@@ -3413,7 +3561,7 @@ static int Av_Part_W(graph *mtxA,int *partition,int *new_partition,int *parts,gr
   
 }
 
-static taucs_ccs_matrix *amst_preconditioner_create(graph *mtxA, double* diag,int rnd,double subgraphs,int stretch_flag);
+static taucs_ccs_matrix *amst_preconditioner_create(graph *mtxA, double* diag,int rnd,double subgraphs,int stretch_flag,int nproc);
 static int Prim(graph *mtxA,int r,int *pi,int *d,linked *l);
 /*static int Prim_cluster(graph *mtxA,int r,int *pi,linked *l,int *partition,int *new_partition,int nparts,int *point_to_heap,char *in_Q,mstheap h);*/
 
@@ -3792,6 +3940,279 @@ int Prim_cluster(graph *mtxA,int r,int *pi,linked *l,int *partition,int *new_par
 }
 #endif /* 0, we don't need this routine */
 
+/*********************************************************/
+/* Parallel MST: Boruvka rounds                          */
+/*********************************************************/
+
+/*
+  Computes the same kind of maximum spanning forest as Prim (weights
+  are -v, so heavy negative off-diagonals are preferred), but in
+  Boruvka rounds: every component picks its heaviest outgoing edge,
+  the picked edges are added to the forest and the components are
+  merged. There are at most log2(n) rounds. The scan over the
+  adjacency lists, which is where the work is, and the relabeling of
+  the merged components are split among nproc threads by vertex
+  ranges, with a barrier between the phases of a round. The hooking
+  step is O(n) and done by thread 0.
+
+  Ties are broken by edge index, so the forest does not depend on the
+  number of threads (Prim breaks ties by visiting order, so the two
+  trees may differ on graphs with equal weights; their weight is the
+  same).
+*/
+
+typedef struct {
+  graph* G;
+  int    n;
+  int    nproc;
+  int*   adjptr;  /* adjacency of each vertex, as edge indices */
+  int*   adjedge;
+  int*   comp;    /* component of each vertex, named by a vertex */
+  int*   parent;  /* hooking of components within a round       */
+  int*   vbest;   /* heaviest edge leaving comp[v] at v         */
+  int*   cbest;   /* heaviest edge leaving each component       */
+  char*  intree;  /* edges of the spanning forest               */
+  int    done;
+} boruvka_state;
+
+/* is edge e heavier than edge f (f == -1 means no edge)? */
+static int boruvka_heavier(graph* G, int e, int f)
+{
+  double we, wf;
+
+  if (e == -1) return 0;
+  if (f == -1) return 1;
+
+  we = -((G->edges)[e].v);
+  wf = -((G->edges)[f].v);
+
+  if (we > wf) return 1;
+  if (we < wf) return 0;
+  return (e < f);
+}
+
+static void boruvka_rounds(boruvka_state* S, int tid)
+{
+  graph* G      = S->G;
+  int    n      = S->n;
+  int    nproc  = S->nproc;
+  int*   comp   = S->comp;
+  int*   parent = S->parent;
+  int*   vbest  = S->vbest;
+  int*   cbest  = S->cbest;
+  int    chunk  = (n + nproc - 1) / nproc;
+  int    first  = min( tid    * chunk, n);
+  int    last   = min((tid+1) * chunk, n);
+  int    v,u,c,c2,e,ip,best,hooks;
+
+  for (;;) {
+    /* heaviest edge leaving the component at each vertex */
+    for (v=first; v<last; v++) {
+      best = -1;
+      for (ip=(S->adjptr)[v]; ip<(S->adjptr)[v+1]; ip++) {
+	e = (S->adjedge)[ip];
+	u = (G->edges)[e].i + (G->edges)[e].j - v;
+	if (comp[u] != comp[v] && boruvka_heavier(G,e,best))
+	  best = e;
+      }
+      vbest[v] = best;
+    }
+
+#ifdef TAUCS_CONFIG_PFUNC
+    if (nproc > 1) pfunc_barrier();
+#endif
+
+    if (tid == 0) {
+      Do(v,n) if (comp[v] == v) cbest[v] = -1;
+      Do(v,n) {
+	c = comp[v];
+	if (boruvka_heavier(G,vbest[v],cbest[c])) cbest[c] = vbest[v];
+      }
+
+      hooks = 0;
+      Do(c,n) {
+	if (comp[c] != c) continue;
+	parent[c] = c;
+	e = cbest[c];
+	if (e == -1) continue;
+	c2 = comp[ (G->edges)[e].i ];
+	if (c2 == c) c2 = comp[ (G->edges)[e].j ];
+	/* two components that picked the same edge: the smaller one stays a root */
+	if (cbest[c2] == e && c < c2) continue;
+	parent[c] = c2;
+	(S->intree)[e] = 1;
+	hooks++;
+      }
+
+      S->done = (hooks == 0);
+    }
+
+#ifdef TAUCS_CONFIG_PFUNC
+    if (nproc > 1) pfunc_barrier();
+#endif
+
+    if (S->done) break;
+
+    /* relabel; only the roots of the old components are read */
+    for (v=first; v<last; v++) {
+      c = comp[v];
+      while (parent[c] != c) c = parent[c];
+      comp[v] = c;
+    }
+
+#ifdef TAUCS_CONFIG_PFUNC
+    if (nproc > 1) pfunc_barrier();
+#endif
+  }
+}
+
+#ifdef TAUCS_CONFIG_PFUNC
+static void boruvka_thread(void* args)
+{
+  boruvka_state* S;
+  int tid;
+
+  pfunc_unpack(args, "void*, int", (void*)&S, &tid);
+  boruvka_rounds(S,tid);
+}
+#endif
+
+/*
+  Same contract as Prim: pi is the parent array of the forest (-1 at
+  the roots, r is one of them) and d the depth of each vertex.
+  Returns 1 on success, 0 if out of memory.
+*/
+
+static
+int Boruvka(graph *mtxA,int r,int *pi,int *d,int nproc)
+{
+  boruvka_state S;
+  int  n = mtxA->n;
+  int  e,i,j,v,u,ip,head,tail,root;
+  int* queue;
+
+  S.G       = mtxA;
+  S.n       = n;
+  S.nproc   = nproc;
+  S.done    = 0;
+  S.adjptr  = (int*)  taucs_calloc(n+1,sizeof(int));
+  S.adjedge = (int*)  taucs_malloc(2*(mtxA->nent)*sizeof(int));
+  S.comp    = (int*)  taucs_malloc(n*sizeof(int));
+  S.parent  = (int*)  taucs_malloc(n*sizeof(int));
+  S.vbest   = (int*)  taucs_malloc(n*sizeof(int));
+  S.cbest   = (int*)  taucs_malloc(n*sizeof(int));
+  S.intree  = (char*) taucs_calloc(mtxA->nent ? mtxA->nent : 1,sizeof(char));
+  queue     = (int*)  taucs_malloc(n*sizeof(int));
+
+  if (!S.adjptr || !S.adjedge || !S.comp || !S.parent
+      || !S.vbest || !S.cbest || !S.intree || !queue) {
+    taucs_free(S.adjptr);
+    taucs_free(S.adjedge);
+    taucs_free(S.comp);
+    taucs_free(S.parent);
+    taucs_free(S.vbest);
+    taucs_free(S.cbest);
+    taucs_free(S.intree);
+    taucs_free(queue);
+    return 0;
+  }
+
+  /* adjacency by vertex, from the edge list */
+
+  Do(e,mtxA->nent) {
+    i = (mtxA->edges)[e].i;
+    j = (mtxA->edges)[e].j;
+    if (i == j) continue;
+    (S.adjptr)[i+1]++;
+    (S.adjptr)[j+1]++;
+  }
+  for (v=0; v<n; v++) (S.adjptr)[v+1] += (S.adjptr)[v];
+  Do(v,n) queue[v] = (S.adjptr)[v];
+  Do(e,mtxA->nent) {
+    i = (mtxA->edges)[e].i;
+    j = (mtxA->edges)[e].j;
+    if (i == j) continue;
+    (S.adjedge)[ queue[i]++ ] = e;
+    (S.adjedge)[ queue[j]++ ] = e;
+  }
+
+  Do(v,n) { (S.comp)[v] = v; (S.parent)[v] = v; }
+
+  if (nproc < 1) nproc = S.nproc = 1;
+
+#ifdef TAUCS_CONFIG_PFUNC
+  if (nproc > 1) {
+    char** args = (char**) taucs_malloc(nproc * sizeof(char*));
+    pfunc_handle_t* handles = (pfunc_handle_t*) taucs_malloc(nproc * sizeof(pfunc_handle_t));
+    pfunc_group_t group;
+
+    if (args && handles) {
+      pfunc_group_init(&group);
+      pfunc_group_set(&group, GROUP_ID, 1236);
+      pfunc_group_set(&group, GROUP_SIZE, nproc);
+      pfunc_group_set(&group, GROUP_BARRIER_TYPE, BARRIER_SPIN);
+
+      Do(i,nproc) {
+	pfunc_handle_init(&handles[i]);
+	pfunc_pack(&args[i], "void*, int", &S, i);
+	pfunc_run(&handles[i], PFUNC_ATTR_DEFAULT, group,
+		  boruvka_thread, args[i]);
+      }
+      pfunc_wait_all(handles, nproc);
+
+      Do(i,nproc)
+	pfunc_handle_clear(handles[i]);
+    } else {
+      /* could not start the threads; run on this one */
+      S.nproc = 1;
+      boruvka_rounds(&S,0);
+    }
+    taucs_free(handles);
+    taucs_free(args);
+  } else
+    boruvka_rounds(&S,0);
+#else
+  S.nproc = 1;
+  boruvka_rounds(&S,0);
+#endif
+
+  /* orient the forest: breadth first from r, then from the other roots */
+
+  Do(v,n) pi[v] = -2;
+  for (root=-1; root<n; root++) {
+    v = (root == -1) ? r : root;
+    if (pi[v] != -2) continue;
+
+    pi[v] = -1;
+    d[v]  = 0;
+    head = tail = 0;
+    queue[tail++] = v;
+    while (head < tail) {
+      v = queue[head++];
+      for (ip=(S.adjptr)[v]; ip<(S.adjptr)[v+1]; ip++) {
+	e = (S.adjedge)[ip];
+	if (!(S.intree)[e]) continue;
+	u = (mtxA->edges)[e].i + (mtxA->edges)[e].j - v;
+	if (pi[u] != -2) continue;
+	pi[u] = v;
+	d[u]  = d[v] + 1;
+	queue[tail++] = u;
+      }
+    }
+  }
+
+  taucs_free(S.adjptr);
+  taucs_free(S.adjedge);
+  taucs_free(S.comp);
+  taucs_free(S.parent);
+  taucs_free(S.vbest);
+  taucs_free(S.cbest);
+  taucs_free(S.intree);
+  taucs_free(queue);
+
+  return 1;
+}
+
 static double dist(int i, int j, double w, graph *mtxA,int *pi,int *d,linked *l,double *dilation,double *congestion)
 {
   double out=0;
@@ -3877,7 +4298,8 @@ taucs_ccs_matrix*
 amst_preconditioner_create(graph *mtxA, double* diag,
 			   int rnd,
 			   double subgraphs,
-			   int stretch_flag)
+			   int stretch_flag,
+			   int nproc)
 {
   taucs_ccs_matrix* out;
   /*
@@ -3978,7 +4400,8 @@ amst_preconditioner_create(graph *mtxA, double* diag,
 	}
       Do(i,n)
 	pi[i] = -2;
-      Prim(low_stretch_tree,r,pi,d,lp_low);
+      if (nproc <= 1 || !Boruvka(low_stretch_tree,r,pi,d,nproc))
+	Prim(low_stretch_tree,r,pi,d,lp_low);
       
       free_graph(low_stretch_tree);
       free_linked_list(lp_low);
@@ -3986,11 +4409,14 @@ amst_preconditioner_create(graph *mtxA, double* diag,
 
   else
     {
-      Prim(mtxA,r,pi,d,lp);
+      if (nproc <= 1 || !Boruvka(mtxA,r,pi,d,nproc))
+	Prim(mtxA,r,pi,d,lp);
     }
 
   /* pi now contains the parent array of the tree, d the distance from the root */
-  printf("Stretch = %f\n",find_stretch(mtxA,pi,d));
+  /* the stretch is a serial O(n*depth) diagnostic; only report it when asked for low stretch */
+  if (stretch_flag)
+    taucs_printf("Stretch = %f\n",find_stretch(mtxA,pi,d));
   
 
   groups         = (int *) taucs_malloc(n*sizeof(int));
@@ -4233,12 +4659,20 @@ amst_preconditioner_create(graph *mtxA, double* diag,
 }
 
 
+/*
+  With nproc > 1 the maximum spanning tree of the AMST preconditioner
+  is built in parallel Boruvka rounds. The AMWB construction, used
+  when there are positive off-diagonals (or when forced), tracks the
+  parity of cycles in its Kruskal sweep and remains sequential.
+*/
+
 taucs_ccs_matrix*
-taucs_amwb_preconditioner_create(taucs_ccs_matrix *A, 
-				 int rnd,
-				 double subgraphs,
-				 int stretch_flag,
-				 int force_amwb)
+taucs_amwb_preconditioner_create_parallel(taucs_ccs_matrix *A, 
+					  int rnd,
+					  double subgraphs,
+					  int stretch_flag,
+					  int force_amwb,
+					  int nproc)
 {
   double  wtime;
   double* diag;
@@ -4291,7 +4725,18 @@ taucs_amwb_preconditioner_create(taucs_ccs_matrix *A,
     return ret;
   }
   else
-    return amst_preconditioner_create(G_A, diag, rnd, subgraphs,stretch_flag);
+    return amst_preconditioner_create(G_A, diag, rnd, subgraphs,stretch_flag,nproc);
+}
+
+taucs_ccs_matrix*
+taucs_amwb_preconditioner_create(taucs_ccs_matrix *A, 
+				 int rnd,
+				 double subgraphs,
+				 int stretch_flag,
+				 int force_amwb)
+{
+  return taucs_amwb_preconditioner_create_parallel(A,rnd,subgraphs,
+						   stretch_flag,force_amwb,1);
 }
 
 #endif /* TAUCS_CORE_DOUBLE */